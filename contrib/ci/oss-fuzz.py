@@ -11,6 +11,7 @@ import os
 import sys
 import subprocess
 import glob
+import xml.etree.ElementTree as ET
 from typing import Dict, Optional, List, Union
 
 DEFAULT_BUILDDIR = ".ossfuzz"
@@ -177,6 +178,26 @@ class Builder:
         print("assembling {}".format(dst))
         subprocess.run(argv, cwd=self.srcdir, check=True)
 
+    def makedict(self, dst: str, gtype: str) -> None:
+        """ create a fuzzer dictionary from the builder XML files """
+        tokens: List[str] = []
+        for fn in sorted(glob.glob(os.path.join(self.srcdir, "fwupd/src/fuzzing/*.builder.xml"))):
+            root = ET.parse(fn).getroot()
+            if root.get("gtype") != gtype:
+                continue
+            for node in root.iter():
+                if node.tag in ["firmware", "image", "chunks", "chunk", "data", "filename"]:
+                    continue
+                for token in _dict_tokens_for_text(node.text):
+                    if token not in tokens:
+                        tokens.append(token)
+        if not tokens:
+            return
+        print("assembling {}".format(dst))
+        with open(os.path.join(self.installdir, dst), "w") as f:
+            for token in tokens:
+                f.write("{}\n".format(token))
+
     def grep_meson(self, src: str, token: str = "fuzzing") -> List[str]:
         """ find source files tagged with a specific comment """
         srcs = []
@@ -197,6 +218,31 @@ class Builder:
         return srcs
 
 
+def _dict_escape(blob: bytes) -> str:
+    return '"{}"'.format("".join("\\x{:02X}".format(b) for b in blob))
+
+
+def _dict_tokens_for_text(text: Optional[str]) -> List[str]:
+    """ convert a builder value into the byte sequences a parser would see """
+    if not text or not text.strip():
+        return []
+    text = text.strip()
+    if not text.startswith("0x"):
+        return [_dict_escape(text.encode())]
+    value = int(text, 16)
+    tokens: List[str] = []
+    for sz in [2, 4]:
+        if value >= 1 << (sz * 8):
+            continue
+        tokens.append(_dict_escape(value.to_bytes(sz, "little")))
+        tokens.append(_dict_escape(value.to_bytes(sz, "big")))
+    return tokens
+
+
+def _fuzzer_gtype(fuzzer: str) -> str:
+    return "Fu{}Firmware".format("".join(x.capitalize() for x in fuzzer.split("-")))
+
+
 def _build(bld: Builder) -> None:
 
     # GLib
@@ -282,7 +328,7 @@ def _build(bld: Builder) -> None:
         built_objs.append(bld.compile("fwupd/libfwupdplugin/fu-fuzzer-main.c"))
 
     # built in formats
-    for fuzzer in ["dfuse", "fmap", "ihex", "srec"]:
+    for fuzzer in ["dfu", "dfuse", "fmap", "ihex", "srec"]:
         src = bld.substitute(
             "fwupd/libfwupdplugin/fu-fuzzer-firmware.c.in",
             {
@@ -295,6 +341,7 @@ def _build(bld: Builder) -> None:
             "{}_fuzzer_seed_corpus.zip".format(fuzzer),
             "fwupd/src/fuzzing/firmware/{}*".format(fuzzer),
         )
+        bld.makedict("{}_fuzzer.dict".format(fuzzer), _fuzzer_gtype(fuzzer))
 
     # plugins
     for srcdir, fuzzer, globstr in [
@@ -328,6 +375,7 @@ def _build(bld: Builder) -> None:
             "{}_fuzzer_seed_corpus.zip".format(fuzzer),
             "fwupd/src/fuzzing/firmware/{}".format(globstr),
         )
+        bld.makedict("{}_fuzzer.dict".format(fuzzer), _fuzzer_gtype(fuzzer))
 
 
 if __name__ == "__main__":
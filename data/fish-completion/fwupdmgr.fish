@@ -32,6 +32,8 @@ complete -c fwupdmgr -l disable-ssl-strict -d 'Ignore SSL strict checks when dow
 complete -c fwupdmgr -l ipfs -d 'Use IPFS when downloading files'
 complete -c fwupdmgr -l filter -d 'Filter with a set of device flags'
 complete -c fwupdmgr -l ignore-power -d 'Ignore requirement of external power source'
+complete -c fwupdmgr -l daemon-address -d 'Connect to the daemon using a D-Bus address'
+complete -c fwupdmgr -l download-only -d 'Only download and verify the firmware'
 
 # complete subcommands
 complete -c fwupdmgr -n '__fish_use_subcommand' -x -a activate -d 'Activate devices'
@@ -154,6 +154,52 @@ fwupd_client_get_devices (FwupdClient *self, GCancellable *cancellable, GError *
 	return g_steal_pointer (&helper->array);
 }
 
+static void
+fwupd_client_get_devices_cached_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->array = fwupd_client_get_devices_cached_finish (FWUPD_CLIENT (source), res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_get_devices_cached:
+ * @self: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the devices registered with the daemon, only transferring the
+ * devices that have changed since the last call.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_get_devices_cached (FwupdClient *self, GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (self, cancellable, error))
+		return NULL;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_get_devices_cached_async (self, cancellable,
+					       fwupd_client_get_devices_cached_cb, helper);
+	g_main_loop_run (helper->loop);
+	if (helper->array == NULL) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return NULL;
+	}
+	return g_steal_pointer (&helper->array);
+}
+
 static void
 fwupd_client_get_plugins_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -388,6 +434,54 @@ fwupd_client_get_upgrades (FwupdClient *self, const gchar *device_id,
 	return g_steal_pointer (&helper->array);
 }
 
+static void
+fwupd_client_get_upgrades_for_all_devices_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->array = fwupd_client_get_upgrades_for_all_devices_finish (FWUPD_CLIENT (source), res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_get_upgrades_for_all_devices:
+ * @self: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Gets all the upgrades for every device in one request to the daemon.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_for_all_devices (FwupdClient *self,
+					   GCancellable *cancellable,
+					   GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (self, cancellable, error))
+		return NULL;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_get_upgrades_for_all_devices_async (self, cancellable,
+							 fwupd_client_get_upgrades_for_all_devices_cb,
+							 helper);
+	g_main_loop_run (helper->loop);
+	if (helper->array == NULL) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return NULL;
+	}
+	return g_steal_pointer (&helper->array);
+}
+
 static void
 fwupd_client_get_details_bytes_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -556,6 +650,53 @@ fwupd_client_verify (FwupdClient *self,
 	return TRUE;
 }
 
+static void
+fwupd_client_verify_all_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->array = fwupd_client_verify_all_finish (FWUPD_CLIENT (source), res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_verify_all:
+ * @self: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Verify all the devices that support it, reading back devices that do not
+ * share any hardware at the same time.
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results, with
+ * the update state and any update error set on each device
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_verify_all (FwupdClient *self, GCancellable *cancellable, GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* connect */
+	if (!fwupd_client_connect (self, cancellable, error))
+		return NULL;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_verify_all_async (self, cancellable,
+				       fwupd_client_verify_all_cb, helper);
+	g_main_loop_run (helper->loop);
+	if (helper->array == NULL) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return NULL;
+	}
+	return g_steal_pointer (&helper->array);
+}
+
 static void
 fwupd_client_verify_update_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -1088,6 +1229,63 @@ fwupd_client_install (FwupdClient *self,
 #endif
 }
 
+static void
+fwupd_client_install_batch_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->ret = fwupd_client_install_batch_finish (FWUPD_CLIENT (source), res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_install_batch:
+ * @self: A #FwupdClient
+ * @device_ids: (element-type utf8): the device IDs, or `*` to match any device
+ * @filenames: (element-type filename): the filenames to install, one for each device ID
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Install more than one file as one transaction, only authenticating once.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_install_batch (FwupdClient *self,
+			    GPtrArray *device_ids,
+			    GPtrArray *filenames,
+			    FwupdInstallFlags install_flags,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (device_ids != NULL, FALSE);
+	g_return_val_if_fail (filenames != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (self, cancellable, error))
+		return FALSE;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_install_batch_async (self, device_ids, filenames,
+					  install_flags, cancellable,
+					  fwupd_client_install_batch_cb,
+					  helper);
+	g_main_loop_run (helper->loop);
+	if (!helper->ret) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fwupd_client_install_bytes_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -1427,6 +1625,56 @@ fwupd_client_refresh_remote (FwupdClient *self,
 	return TRUE;
 }
 
+static void
+fwupd_client_refresh_remotes_cb (GObject *source,
+				 GAsyncResult *res,
+				 gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->ret = fwupd_client_refresh_remotes_finish (FWUPD_CLIENT (source),
+							   res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_refresh_remotes:
+ * @self: A #FwupdClient
+ * @remotes: (element-type FwupdRemote): remotes to refresh
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * Refreshes several remotes at the same time by downloading new metadata.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_refresh_remotes (FwupdClient *self,
+			      GPtrArray *remotes,
+			      GCancellable *cancellable,
+			      GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (remotes != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_refresh_remotes_async (self, remotes, cancellable,
+					    fwupd_client_refresh_remotes_cb,
+					    helper);
+	g_main_loop_run (helper->loop);
+	if (!helper->ret) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fwupd_client_modify_remote_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -1965,6 +2213,58 @@ fwupd_client_set_feature_flags (FwupdClient *self,
 	return TRUE;
 }
 
+static void
+fwupd_client_set_request_id_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdClientHelper *helper = (FwupdClientHelper *) user_data;
+	helper->ret = fwupd_client_set_request_id_finish (FWUPD_CLIENT (source), res, &helper->error);
+	g_main_loop_quit (helper->loop);
+}
+
+/**
+ * fwupd_client_set_request_id:
+ * @self: A #FwupdClient
+ * @request_id: (nullable): a request ID, e.g. a trace ID, or %NULL
+ * @cancellable: the #GCancellable, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Sets the ID the daemon uses for the following requests from this client.
+ * The ID is included in the daemon debug output, the update history and the
+ * metrics, which allows a slow or failed update to be matched to the caller.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_set_request_id (FwupdClient *self,
+			     const gchar *request_id,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	g_autoptr(FwupdClientHelper) helper = NULL;
+
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* connect */
+	if (!fwupd_client_connect (self, cancellable, error))
+		return FALSE;
+
+	/* call async version and run loop until complete */
+	helper = fwupd_client_helper_new (self);
+	fwupd_client_set_request_id_async (self, request_id, cancellable,
+					   fwupd_client_set_request_id_cb,
+					   helper);
+	g_main_loop_run (helper->loop);
+	if (!helper->ret) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fwupd_client_self_sign_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -16,6 +16,10 @@ GPtrArray	*fwupd_client_get_devices		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+GPtrArray	*fwupd_client_get_devices_cached	(FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 GPtrArray	*fwupd_client_get_plugins		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
@@ -39,6 +43,10 @@ GPtrArray	*fwupd_client_get_upgrades		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+GPtrArray	*fwupd_client_get_upgrades_for_all_devices (FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 GPtrArray	*fwupd_client_get_details		(FwupdClient	*self,
 							 const gchar	*filename,
 							 GCancellable	*cancellable,
@@ -54,6 +62,10 @@ gboolean	 fwupd_client_verify			(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+GPtrArray	*fwupd_client_verify_all		(FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fwupd_client_verify_update		(FwupdClient	*self,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
@@ -106,6 +118,13 @@ gboolean	 fwupd_client_install			(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fwupd_client_install_batch		(FwupdClient	*self,
+							 GPtrArray	*device_ids,
+							 GPtrArray	*filenames,
+							 FwupdInstallFlags install_flags,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fwupd_client_install_bytes		(FwupdClient	*self,
 							 const gchar	*device_id,
 							 GBytes		*bytes,
@@ -148,6 +167,11 @@ gboolean	 fwupd_client_refresh_remote		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fwupd_client_refresh_remotes		(FwupdClient	*self,
+							 GPtrArray	*remotes,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fwupd_client_modify_remote		(FwupdClient	*self,
 							 const gchar	*remote_id,
 							 const gchar	*key,
@@ -204,6 +228,11 @@ gboolean	 fwupd_client_set_feature_flags		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fwupd_client_set_request_id		(FwupdClient	*self,
+							 const gchar	*request_id,
+							 GCancellable	*cancellable,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 GBytes		*fwupd_client_download_bytes		(FwupdClient	*self,
 							 const gchar	*url,
 							 FwupdClientDownloadFlags flags,
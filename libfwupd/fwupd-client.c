@@ -8,6 +8,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <gmodule.h>
 #ifdef HAVE_LIBCURL
 #include <curl/curl.h>
@@ -52,6 +53,7 @@ typedef struct {
 	gboolean			 tainted;
 	gboolean			 interactive;
 	guint				 percentage;
+	guint				 metadata_generation;
 	GMutex				 idle_mutex;	/* for @idle_id and @idle_sources */
 	guint				 idle_id;
 	GPtrArray			*idle_sources;	/* element-type FwupdClientContextHelper */
@@ -59,9 +61,22 @@ typedef struct {
 	gchar				*host_product;
 	gchar				*host_machine_id;
 	gchar				*host_security_id;
-	GMutex				 proxy_mutex;	/* for @proxy */
+	GMutex				 proxy_mutex;	/* for @proxy and @connect_tasks */
 	GDBusProxy			*proxy;
+	GPtrArray			*connect_tasks;	/* (nullable): element-type GTask */
+	gchar				*daemon_address;
+	GMutex				 devices_mutex;	/* for @devices_cache and @devices_generation */
+	GPtrArray			*devices_cache;	/* element-type FwupdDevice */
+	guint64				 devices_generation;
+	GMutex				 cache_mutex;	/* for @cache_enabled, @cache and @cache_age */
+	gboolean			 cache_enabled;
+	GHashTable			*cache;		/* key:method-and-args value:GPtrArray */
+	guint				 cache_age;
 	gchar				*user_agent;
+#ifdef HAVE_LIBCURL
+	CURLSH				*curl_share;	/* connections, DNS and TLS sessions */
+	GMutex				 curl_share_mutex[CURL_LOCK_DATA_LAST];
+#endif
 #ifdef SOUP_SESSION_COMPAT
 	GObject				*soup_session;
 	GModule				*soup_module;	/* we leak this */
@@ -74,7 +89,29 @@ typedef struct {
 	CURL				*curl;
 	curl_mime			*mime;
 	struct curl_slist		*headers;
+	FwupdClientDownloadFlags	 flags;
 } FwupdCurlHelper;
+
+typedef struct {
+	CURL				*curl;
+	GByteArray			*buf;
+	gchar				*spool_fn;
+	GOutputStream			*spool;		/* nullable */
+	curl_off_t			 offset;	/* bytes received by previous attempts */
+	curl_off_t			 spooled;	/* bytes written to @spool */
+	gboolean			 checked_response;
+	struct curl_slist		*headers;	/* conditional request */
+	gchar				*etag;
+	gchar				*last_modified;
+	GError				*error;
+} FwupdCurlDownload;
+
+/* downloads larger than this are written to the user cache directory as they
+ * arrive so they do not have to be held in memory, and can be resumed */
+#define FWUPD_CLIENT_DOWNLOAD_SPOOL_SIZE	(16 * 1024 * 1024)
+
+/* number of times to resume an interrupted transfer */
+#define FWUPD_CLIENT_DOWNLOAD_RETRIES		5
 #endif
 
 enum {
@@ -83,6 +120,7 @@ enum {
 	SIGNAL_DEVICE_ADDED,
 	SIGNAL_DEVICE_REMOVED,
 	SIGNAL_DEVICE_CHANGED,
+	SIGNAL_DEVICE_VERIFIED,
 	SIGNAL_LAST
 };
 
@@ -97,6 +135,7 @@ enum {
 	PROP_HOST_MACHINE_ID,
 	PROP_HOST_SECURITY_ID,
 	PROP_INTERACTIVE,
+	PROP_METADATA_GENERATION,
 	PROP_LAST
 };
 
@@ -358,6 +397,14 @@ fwupd_client_properties_changed_cb (GDBusProxy *proxy,
 			fwupd_client_object_notify (self, "interactive");
 		}
 	}
+	if (g_variant_dict_contains (dict, "MetadataGeneration")) {
+		g_autoptr(GVariant) val = NULL;
+		val = g_dbus_proxy_get_cached_property (proxy, "MetadataGeneration");
+		if (val != NULL) {
+			priv->metadata_generation = g_variant_get_uint32 (val);
+			fwupd_client_object_notify (self, "metadata-generation");
+		}
+	}
 	if (g_variant_dict_contains (dict, "Percentage")) {
 		g_autoptr(GVariant) val = NULL;
 		val = g_dbus_proxy_get_cached_property (proxy, "Percentage");
@@ -390,6 +437,88 @@ fwupd_client_properties_changed_cb (GDBusProxy *proxy,
 	}
 }
 
+typedef struct {
+	gchar		*key;
+	guint		 cache_age;
+} FwupdClientCacheHelper;
+
+static void
+fwupd_client_cache_helper_free (FwupdClientCacheHelper *helper)
+{
+	g_free (helper->key);
+	g_free (helper);
+}
+
+static GPtrArray *
+fwupd_client_cache_array_copy (GPtrArray *array)
+{
+	GPtrArray *array_new = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < array->len; i++)
+		g_ptr_array_add (array_new, g_object_ref (g_ptr_array_index (array, i)));
+	return array_new;
+}
+
+static void
+fwupd_client_cache_invalidate (FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->cache_mutex);
+	priv->cache_age++;
+	g_hash_table_remove_all (priv->cache);
+}
+
+/* returns %NULL if caching is disabled or there is no cached result */
+static GPtrArray *
+fwupd_client_cache_lookup (FwupdClient *self, const gchar *key)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	GPtrArray *array;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->cache_mutex);
+	if (!priv->cache_enabled)
+		return NULL;
+	array = g_hash_table_lookup (priv->cache, key);
+	if (array == NULL)
+		return NULL;
+	return fwupd_client_cache_array_copy (array);
+}
+
+static GTask *
+fwupd_client_cache_task_new (FwupdClient *self,
+			     const gchar *key,
+			     GCancellable *cancellable,
+			     GAsyncReadyCallback callback,
+			     gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	FwupdClientCacheHelper *helper = g_new0 (FwupdClientCacheHelper, 1);
+	GTask *task = g_task_new (self, cancellable, callback, callback_data);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->cache_mutex);
+
+	/* a signal received while the call is in flight makes the result stale */
+	helper->key = g_strdup (key);
+	helper->cache_age = priv->cache_age;
+	g_task_set_task_data (task, helper, (GDestroyNotify) fwupd_client_cache_helper_free);
+	return task;
+}
+
+/* takes ownership of @array */
+static void
+fwupd_client_cache_task_return (GTask *task, GPtrArray *array)
+{
+	FwupdClient *self = g_task_get_source_object (task);
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	FwupdClientCacheHelper *helper = g_task_get_task_data (task);
+
+	g_mutex_lock (&priv->cache_mutex);
+	if (priv->cache_enabled && helper->cache_age == priv->cache_age) {
+		g_hash_table_insert (priv->cache,
+				     g_strdup (helper->key),
+				     fwupd_client_cache_array_copy (array));
+	}
+	g_mutex_unlock (&priv->cache_mutex);
+	g_task_return_pointer (task, array, (GDestroyNotify) g_ptr_array_unref);
+}
+
 static void
 fwupd_client_signal_cb (GDBusProxy *proxy,
 			const gchar *sender_name,
@@ -398,6 +527,14 @@ fwupd_client_signal_cb (GDBusProxy *proxy,
 			FwupdClient *self)
 {
 	g_autoptr(FwupdDevice) dev = NULL;
+
+	/* any cached devices and releases may now be out of date */
+	if (g_strcmp0 (signal_name, "Changed") == 0 ||
+	    g_strcmp0 (signal_name, "DeviceAdded") == 0 ||
+	    g_strcmp0 (signal_name, "DeviceRemoved") == 0 ||
+	    g_strcmp0 (signal_name, "DeviceChanged") == 0)
+		fwupd_client_cache_invalidate (self);
+
 	if (g_strcmp0 (signal_name, "Changed") == 0) {
 		g_debug ("Emitting ::changed()");
 		g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
@@ -424,15 +561,26 @@ fwupd_client_signal_cb (GDBusProxy *proxy,
 		fwupd_client_signal_emit_device (self, SIGNAL_DEVICE_CHANGED, dev);
 		return;
 	}
+	if (g_strcmp0 (signal_name, "DeviceVerified") == 0) {
+		dev = fwupd_device_from_variant (parameters);
+		g_debug ("Emitting ::device-verified(%s)",
+			 fwupd_device_get_id (dev));
+		fwupd_client_signal_emit_device (self, SIGNAL_DEVICE_VERIFIED, dev);
+		return;
+	}
 	g_debug ("Unknown signal name '%s' from %s", signal_name, sender_name);
 }
 
+/* reused by every synchronous call made from the same thread */
+static GPrivate fwupd_client_thread_ctx = G_PRIVATE_INIT ((GDestroyNotify) g_main_context_unref);
+
 /**
  * fwupd_client_get_main_context:
  * @self: A #FwupdClient
  *
  * Gets the internal #GMainContext to use for synchronous methods.
- * By default the value is set a new #GMainContext.
+ * By default the value is a #GMainContext shared by all the synchronous
+ * methods called from the current thread.
  *
  * Return value: (transfer full): the #GMainContext
  *
@@ -442,9 +590,16 @@ GMainContext *
 fwupd_client_get_main_context (FwupdClient *self)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	GMainContext *main_ctx;
+
 	if (priv->main_ctx != NULL)
 		return g_main_context_ref (priv->main_ctx);
-	return g_main_context_new ();
+	main_ctx = g_private_get (&fwupd_client_thread_ctx);
+	if (main_ctx == NULL) {
+		main_ctx = g_main_context_new ();
+		g_private_set (&fwupd_client_thread_ctx, main_ctx);
+	}
+	return g_main_context_ref (main_ctx);
 }
 
 /**
@@ -565,6 +720,12 @@ fwupd_client_curl_new (FwupdClient *self, GError **error)
 	curl_easy_setopt (helper->curl, CURLOPT_CONNECTTIMEOUT, 60L);
 	curl_easy_setopt (helper->curl, CURLOPT_NOPROGRESS, 0L);
 
+	/* reuse connections between requests, and multiplex where possible */
+	if (priv->curl_share != NULL)
+		curl_easy_setopt (helper->curl, CURLOPT_SHARE, priv->curl_share);
+	curl_easy_setopt (helper->curl, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt (helper->curl, CURLOPT_PIPEWAIT, 1L);
+
 	/* relax the SSL checks for broken corporate proxies */
 	if (g_getenv ("DISABLE_SSL_STRICT") != NULL)
 		curl_easy_setopt (helper->curl, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -586,6 +747,26 @@ fwupd_client_curl_new (FwupdClient *self, GError **error)
 }
 #endif
 
+/* completes every caller that was waiting for the proxy, each one in the
+ * context of the thread that called fwupd_client_connect_async() */
+static void
+fwupd_client_connect_return (FwupdClient *self, const GError *error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GPtrArray) tasks = NULL;
+
+	g_mutex_lock (&priv->proxy_mutex);
+	tasks = g_steal_pointer (&priv->connect_tasks);
+	g_mutex_unlock (&priv->proxy_mutex);
+	for (guint i = 0; tasks != NULL && i < tasks->len; i++) {
+		GTask *task = g_ptr_array_index (tasks, i);
+		if (error != NULL)
+			g_task_return_error (task, g_error_copy (error));
+		else
+			g_task_return_boolean (task, TRUE);
+	}
+}
+
 static void
 fwupd_client_connect_get_proxy_cb (GObject *source,
 				   GAsyncResult *res,
@@ -603,18 +784,20 @@ fwupd_client_connect_get_proxy_cb (GObject *source,
 	g_autoptr(GVariant) val5 = NULL;
 	g_autoptr(GVariant) val6 = NULL;
 	g_autoptr(GVariant) val7 = NULL;
+	g_autoptr(GVariant) val8 = NULL;
 	g_autoptr(GMutexLocker) locker = NULL;
 
 	proxy = g_dbus_proxy_new_finish (res, &error);
 	if (proxy == NULL) {
-		g_task_return_error (task, g_steal_pointer (&error));
+		fwupd_client_connect_return (self, error);
 		return;
 	}
 
 	/* another thread did this for us */
 	locker = g_mutex_locker_new (&priv->proxy_mutex);
 	if (priv->proxy != NULL) {
-		g_task_return_boolean (task, TRUE);
+		g_clear_pointer (&locker, g_mutex_locker_free);
+		fwupd_client_connect_return (self, NULL);
 		return;
 	}
 	priv->proxy = g_steal_pointer (&proxy);
@@ -645,9 +828,74 @@ fwupd_client_connect_get_proxy_cb (GObject *source,
 	val7 = g_dbus_proxy_get_cached_property (priv->proxy, "HostSecurityId");
 	if (val7 != NULL)
 		fwupd_client_set_host_security_id (self, g_variant_get_string (val7, NULL));
+	val8 = g_dbus_proxy_get_cached_property (priv->proxy, "MetadataGeneration");
+	if (val8 != NULL)
+		priv->metadata_generation = g_variant_get_uint32 (val8);
 
 	/* success */
-	g_task_return_boolean (task, TRUE);
+	g_clear_pointer (&locker, g_mutex_locker_free);
+	fwupd_client_connect_return (self, NULL);
+}
+
+static void
+fwupd_client_connect_get_connection_cb (GObject *source,
+					GAsyncResult *res,
+					gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+
+	connection = g_dbus_connection_new_for_address_finish (res, &error);
+	if (connection == NULL) {
+		g_prefix_error (&error, "failed to connect to daemon: ");
+		fwupd_client_connect_return (g_task_get_source_object (task), error);
+		return;
+	}
+	g_dbus_proxy_new (connection,
+			  G_DBUS_PROXY_FLAGS_NONE,
+			  NULL,
+			  FWUPD_DBUS_SERVICE,
+			  FWUPD_DBUS_PATH,
+			  FWUPD_DBUS_INTERFACE,
+			  g_task_get_cancellable (task),
+			  fwupd_client_connect_get_proxy_cb,
+			  g_steal_pointer (&task));
+}
+
+static void
+fwupd_client_connect_get_peer_cb (GObject *source,
+				  GAsyncResult *res,
+				  gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* the daemon is not listening, so use the bus as normal */
+	connection = g_dbus_connection_new_for_address_finish (res, &error);
+	if (connection == NULL) {
+		g_debug ("failed to connect to peer socket: %s", error->message);
+		g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
+					  G_DBUS_PROXY_FLAGS_NONE,
+					  NULL,
+					  FWUPD_DBUS_SERVICE,
+					  FWUPD_DBUS_PATH,
+					  FWUPD_DBUS_INTERFACE,
+					  g_task_get_cancellable (task),
+					  fwupd_client_connect_get_proxy_cb,
+					  g_steal_pointer (&task));
+		return;
+	}
+	g_dbus_proxy_new (connection,
+			  G_DBUS_PROXY_FLAGS_NONE,
+			  NULL,
+			  NULL,
+			  FWUPD_DBUS_PATH,
+			  FWUPD_DBUS_INTERFACE,
+			  g_task_get_cancellable (task),
+			  fwupd_client_connect_get_proxy_cb,
+			  g_steal_pointer (&task));
 }
 
 /**
@@ -663,6 +911,9 @@ fwupd_client_connect_get_proxy_cb (GObject *source,
  * Other methods such as fwupd_client_get_devices_async() should only be called
  * after fwupd_client_connect_finish() has been called without an error.
  *
+ * If the daemon is listening on a private socket then this is used rather
+ * than the system bus.
+ *
  * Since: 1.5.0
  **/
 void
@@ -670,6 +921,7 @@ fwupd_client_connect_async (FwupdClient *self, GCancellable *cancellable,
 			    GAsyncReadyCallback callback, gpointer callback_data)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	const gchar *socket_fn = g_getenv ("FWUPD_DBUS_SOCKET");
 	g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
 	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->proxy_mutex);
 
@@ -684,6 +936,40 @@ fwupd_client_connect_async (FwupdClient *self, GCancellable *cancellable,
 		return;
 	}
 
+	/* another thread is already connecting, so share the same proxy */
+	if (priv->connect_tasks != NULL) {
+		g_ptr_array_add (priv->connect_tasks, g_steal_pointer (&task));
+		return;
+	}
+	priv->connect_tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_ptr_array_add (priv->connect_tasks, g_object_ref (task));
+
+	/* a remote daemon, e.g. a bus forwarded over SSH */
+	if (priv->daemon_address != NULL) {
+		g_dbus_connection_new_for_address (priv->daemon_address,
+						   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+						   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+						   NULL,
+						   cancellable,
+						   fwupd_client_connect_get_connection_cb,
+						   g_steal_pointer (&task));
+		return;
+	}
+
+	/* talk to the daemon directly, without going through the bus */
+	if (socket_fn == NULL)
+		socket_fn = FWUPD_DBUS_P2P_SOCKET_PATH;
+	if (g_file_test (socket_fn, G_FILE_TEST_EXISTS)) {
+		g_autofree gchar *address = g_strdup_printf ("unix:path=%s", socket_fn);
+		g_dbus_connection_new_for_address (address,
+						   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+						   NULL,
+						   cancellable,
+						   fwupd_client_connect_get_peer_cb,
+						   g_steal_pointer (&task));
+		return;
+	}
+
 	g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
 				  G_DBUS_PROXY_FLAGS_NONE,
 				  NULL,
@@ -947,9 +1233,7 @@ fwupd_client_get_devices_cb (GObject *source,
 	}
 
 	/* success */
-	g_task_return_pointer (task,
-			       fwupd_device_array_from_variant (val),
-			       (GDestroyNotify) g_ptr_array_unref);
+	fwupd_client_cache_task_return (task, fwupd_device_array_from_variant (val));
 }
 
 /**
@@ -971,14 +1255,25 @@ fwupd_client_get_devices_async (FwupdClient *self, GCancellable *cancellable,
 				GAsyncReadyCallback callback, gpointer callback_data)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GPtrArray) cached = NULL;
 	g_autoptr(GTask) task = NULL;
 
 	g_return_if_fail (FWUPD_IS_CLIENT (self));
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 	g_return_if_fail (priv->proxy != NULL);
 
+	/* already cached */
+	task = fwupd_client_cache_task_new (self, "GetDevices", cancellable,
+					    callback, callback_data);
+	cached = fwupd_client_cache_lookup (self, "GetDevices");
+	if (cached != NULL) {
+		g_task_return_pointer (task,
+				       g_steal_pointer (&cached),
+				       (GDestroyNotify) g_ptr_array_unref);
+		return;
+	}
+
 	/* call into daemon */
-	task = g_task_new (self, cancellable, callback, callback_data);
 	g_dbus_proxy_call (priv->proxy, "GetDevices",
 			   NULL, G_DBUS_CALL_FLAGS_NONE,
 			   -1, cancellable,
@@ -1007,6 +1302,215 @@ fwupd_client_get_devices_finish (FwupdClient *self, GAsyncResult *res, GError **
 	return g_task_propagate_pointer (G_TASK(res), error);
 }
 
+/* must be called with devices_mutex held */
+static void
+fwupd_client_devices_cache_set (FwupdClient *self, FwupdDevice *device)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	for (guint i = 0; i < priv->devices_cache->len; i++) {
+		FwupdDevice *device_tmp = g_ptr_array_index (priv->devices_cache, i);
+		if (g_strcmp0 (fwupd_device_get_id (device_tmp), fwupd_device_get_id (device)) == 0) {
+			g_object_unref (device_tmp);
+			g_ptr_array_index (priv->devices_cache, i) = g_object_ref (device);
+			return;
+		}
+	}
+	g_ptr_array_add (priv->devices_cache, g_object_ref (device));
+}
+
+/* must be called with devices_mutex held */
+static void
+fwupd_client_devices_cache_remove (FwupdClient *self, const gchar *device_id)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	for (guint i = 0; i < priv->devices_cache->len; i++) {
+		FwupdDevice *device_tmp = g_ptr_array_index (priv->devices_cache, i);
+		if (g_strcmp0 (fwupd_device_get_id (device_tmp), device_id) == 0) {
+			g_ptr_array_remove_index (priv->devices_cache, i);
+			return;
+		}
+	}
+}
+
+/* must be called with devices_mutex held */
+static void
+fwupd_client_devices_cache_return (FwupdClient *self, GTask *task)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* set the parent on any new or changed children */
+	fwupd_device_array_ensure_parents (priv->devices_cache);
+
+	/* same as GetDevices */
+	if (priv->devices_cache->len == 0) {
+		g_task_return_new_error (task,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_NOTHING_TO_DO,
+					 "No detected devices");
+		return;
+	}
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < priv->devices_cache->len; i++) {
+		FwupdDevice *device = g_ptr_array_index (priv->devices_cache, i);
+		g_ptr_array_add (devices, g_object_ref (device));
+	}
+	g_task_return_pointer (task,
+			       g_steal_pointer (&devices),
+			       (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+fwupd_client_get_devices_cached_fallback_cb (GObject *source,
+					     GAsyncResult *res,
+					     gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClient *self = g_task_get_source_object (task);
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	locker = g_mutex_locker_new (&priv->devices_mutex);
+	g_ptr_array_set_size (priv->devices_cache, 0);
+	priv->devices_generation = 0;
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (val == NULL) {
+		fwupd_client_fixup_dbus_error (error);
+		if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
+			fwupd_client_devices_cache_return (self, task);
+			return;
+		}
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	devices = fwupd_device_array_from_variant (val);
+	for (guint i = 0; i < devices->len; i++)
+		fwupd_client_devices_cache_set (self, g_ptr_array_index (devices, i));
+	fwupd_client_devices_cache_return (self, task);
+}
+
+static void
+fwupd_client_get_devices_cached_cb (GObject *source,
+				    GAsyncResult *res,
+				    gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClient *self = g_task_get_source_object (task);
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	gboolean complete = FALSE;
+	guint64 generation = 0;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_autoptr(GVariant) devices_val = NULL;
+	g_autoptr(GVariant) removed_val = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autofree const gchar **removed = NULL;
+
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (val == NULL) {
+		/* an older daemon, so get everything */
+		if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			GCancellable *cancellable = g_task_get_cancellable (task);
+			g_dbus_proxy_call (G_DBUS_PROXY (source), "GetDevices",
+					   NULL, G_DBUS_CALL_FLAGS_NONE,
+					   -1, cancellable,
+					   fwupd_client_get_devices_cached_fallback_cb,
+					   g_steal_pointer (&task));
+			return;
+		}
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* apply the changes to the cache */
+	g_variant_get (val, "(tb@aa{sv}@as)",
+		       &generation, &complete,
+		       &devices_val, &removed_val);
+	locker = g_mutex_locker_new (&priv->devices_mutex);
+	if (complete)
+		g_ptr_array_set_size (priv->devices_cache, 0);
+	removed = g_variant_get_strv (removed_val, NULL);
+	for (guint i = 0; removed[i] != NULL; i++)
+		fwupd_client_devices_cache_remove (self, removed[i]);
+	for (gsize i = 0; i < g_variant_n_children (devices_val); i++) {
+		g_autoptr(FwupdDevice) device = NULL;
+		g_autoptr(GVariant) data = g_variant_get_child_value (devices_val, i);
+		device = fwupd_device_from_variant (data);
+		if (device == NULL)
+			continue;
+		fwupd_client_devices_cache_set (self, device);
+	}
+	priv->devices_generation = generation;
+	fwupd_client_devices_cache_return (self, task);
+}
+
+/**
+ * fwupd_client_get_devices_cached_async:
+ * @self: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Gets all the devices registered with the daemon, like
+ * fwupd_client_get_devices_async(), but only transfers the devices that have
+ * been added, changed or removed since the last time this was called.
+ *
+ * You must have called fwupd_client_connect_async() on @self before using
+ * this method.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_get_devices_cached_async (FwupdClient *self, GCancellable *cancellable,
+				       GAsyncReadyCallback callback, gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	guint64 generation;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (priv->proxy != NULL);
+
+	g_mutex_lock (&priv->devices_mutex);
+	generation = priv->devices_generation;
+	g_mutex_unlock (&priv->devices_mutex);
+
+	/* call into daemon */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	g_dbus_proxy_call (priv->proxy, "GetDevicesSince",
+			   g_variant_new ("(t)", generation),
+			   G_DBUS_CALL_FLAGS_NONE,
+			   -1, cancellable,
+			   fwupd_client_get_devices_cached_cb,
+			   g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_get_devices_cached_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_devices_cached_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_get_devices_cached_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK(res), error);
+}
+
 static void
 fwupd_client_get_plugins_cb (GObject *source,
 			     GAsyncResult *res,
@@ -1370,9 +1874,7 @@ fwupd_client_get_releases_cb (GObject *source,
 	}
 
 	/* success */
-	g_task_return_pointer (task,
-			       fwupd_release_array_from_variant (val),
-			       (GDestroyNotify) g_ptr_array_unref);
+	fwupd_client_cache_task_return (task, fwupd_release_array_from_variant (val));
 }
 
 /**
@@ -1397,6 +1899,8 @@ fwupd_client_get_releases_async (FwupdClient *self, const gchar *device_id,
 				 gpointer callback_data)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autofree gchar *key = NULL;
+	g_autoptr(GPtrArray) cached = NULL;
 	g_autoptr(GTask) task = NULL;
 
 	g_return_if_fail (FWUPD_IS_CLIENT (self));
@@ -1404,8 +1908,19 @@ fwupd_client_get_releases_async (FwupdClient *self, const gchar *device_id,
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 	g_return_if_fail (priv->proxy != NULL);
 
+	/* already cached */
+	key = g_strdup_printf ("GetReleases(%s)", device_id);
+	task = fwupd_client_cache_task_new (self, key, cancellable,
+					    callback, callback_data);
+	cached = fwupd_client_cache_lookup (self, key);
+	if (cached != NULL) {
+		g_task_return_pointer (task,
+				       g_steal_pointer (&cached),
+				       (GDestroyNotify) g_ptr_array_unref);
+		return;
+	}
+
 	/* call into daemon */
-	task = g_task_new (self, cancellable, callback, callback_data);
 	g_dbus_proxy_call (priv->proxy, "GetReleases",
 			   g_variant_new ("(s)", device_id),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1534,9 +2049,7 @@ fwupd_client_get_upgrades_cb (GObject *source,
 	}
 
 	/* success */
-	g_task_return_pointer (task,
-			       fwupd_release_array_from_variant (val),
-			       (GDestroyNotify) g_ptr_array_unref);
+	fwupd_client_cache_task_return (task, fwupd_release_array_from_variant (val));
 }
 
 /**
@@ -1561,6 +2074,8 @@ fwupd_client_get_upgrades_async (FwupdClient *self, const gchar *device_id,
 				 gpointer callback_data)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autofree gchar *key = NULL;
+	g_autoptr(GPtrArray) cached = NULL;
 	g_autoptr(GTask) task = NULL;
 
 	g_return_if_fail (FWUPD_IS_CLIENT (self));
@@ -1568,8 +2083,19 @@ fwupd_client_get_upgrades_async (FwupdClient *self, const gchar *device_id,
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 	g_return_if_fail (priv->proxy != NULL);
 
+	/* already cached */
+	key = g_strdup_printf ("GetUpgrades(%s)", device_id);
+	task = fwupd_client_cache_task_new (self, key, cancellable,
+					    callback, callback_data);
+	cached = fwupd_client_cache_lookup (self, key);
+	if (cached != NULL) {
+		g_task_return_pointer (task,
+				       g_steal_pointer (&cached),
+				       (GDestroyNotify) g_ptr_array_unref);
+		return;
+	}
+
 	/* call into daemon */
-	task = g_task_new (self, cancellable, callback, callback_data);
 	g_dbus_proxy_call (priv->proxy, "GetUpgrades",
 			   g_variant_new ("(s)", device_id),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1600,9 +2126,9 @@ fwupd_client_get_upgrades_finish (FwupdClient *self, GAsyncResult *res, GError *
 }
 
 static void
-fwupd_client_modify_config_cb (GObject *source,
-			       GAsyncResult *res,
-			       gpointer user_data)
+fwupd_client_get_upgrades_for_all_devices_cb (GObject *source,
+					      GAsyncResult *res,
+					      gpointer user_data)
 {
 	g_autoptr(GTask) task = G_TASK (user_data);
 	g_autoptr(GError) error = NULL;
@@ -1616,19 +2142,111 @@ fwupd_client_modify_config_cb (GObject *source,
 	}
 
 	/* success */
-	g_task_return_boolean (task, TRUE);
+	fwupd_client_cache_task_return (task, fwupd_device_array_from_variant (val));
 }
 
 /**
- * fwupd_client_modify_config_async:
+ * fwupd_client_get_upgrades_for_all_devices_async:
  * @self: A #FwupdClient
- * @key: key, e.g. `DisabledPlugins`
- * @value: value, e.g. `*`
  * @cancellable: the #GCancellable, or %NULL
  * @callback: the function to run on completion
  * @callback_data: the data to pass to @callback
  *
- * Modifies a daemon config option.
+ * Gets all the upgrades for every device in one request to the daemon.
+ * Only devices with at least one upgrade are returned, and the upgrades can be
+ * found using fwupd_device_get_releases().
+ *
+ * You must have called fwupd_client_connect_async() on @self before using
+ * this method.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_get_upgrades_for_all_devices_async (FwupdClient *self,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GPtrArray) cached = NULL;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (priv->proxy != NULL);
+
+	/* already cached */
+	task = fwupd_client_cache_task_new (self, "GetUpgradesAll", cancellable,
+					    callback, callback_data);
+	cached = fwupd_client_cache_lookup (self, "GetUpgradesAll");
+	if (cached != NULL) {
+		g_task_return_pointer (task,
+				       g_steal_pointer (&cached),
+				       (GDestroyNotify) g_ptr_array_unref);
+		return;
+	}
+
+	/* call into daemon */
+	g_dbus_proxy_call (priv->proxy, "GetUpgradesAll",
+			   NULL, G_DBUS_CALL_FLAGS_NONE,
+			   -1, cancellable,
+			   fwupd_client_get_upgrades_for_all_devices_cb,
+			   g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_get_upgrades_for_all_devices_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_get_upgrades_for_all_devices_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_get_upgrades_for_all_devices_finish (FwupdClient *self,
+						  GAsyncResult *res,
+						  GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK(res), error);
+}
+
+static void
+fwupd_client_modify_config_cb (GObject *source,
+			       GAsyncResult *res,
+			       gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (val == NULL) {
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * fwupd_client_modify_config_async:
+ * @self: A #FwupdClient
+ * @key: key, e.g. `DisabledPlugins`
+ * @value: value, e.g. `*`
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Modifies a daemon config option.
  * The daemon will only respond to this request with proper permissions
  *
  * Since: 1.5.0
@@ -1838,6 +2456,85 @@ fwupd_client_verify_finish (FwupdClient *self, GAsyncResult *res, GError **error
 	return g_task_propagate_boolean (G_TASK(res), error);
 }
 
+static void
+fwupd_client_verify_all_cb (GObject *source,
+			    GAsyncResult *res,
+			    gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (val == NULL) {
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_pointer (task,
+			       fwupd_device_array_from_variant (val),
+			       (GDestroyNotify) g_ptr_array_unref);
+}
+
+/**
+ * fwupd_client_verify_all_async:
+ * @self: A #FwupdClient
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Verify all the devices that support it. Devices that do not share any
+ * hardware are read back at the same time, and #FwupdClient::device-verified
+ * is emitted as each one completes.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_verify_all_async (FwupdClient *self,
+			       GCancellable *cancellable,
+			       GAsyncReadyCallback callback,
+			       gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (priv->proxy != NULL);
+
+	/* call into daemon */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	g_dbus_proxy_call (priv->proxy, "VerifyAll",
+			   NULL, G_DBUS_CALL_FLAGS_NONE,
+			   G_MAXINT, cancellable,
+			   fwupd_client_verify_all_cb,
+			   g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_verify_all_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_verify_all_async().
+ *
+ * Returns: (element-type FwupdDevice) (transfer container): results, with
+ * the update state and any update error set on each device
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fwupd_client_verify_all_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer (G_TASK(res), error);
+}
+
 static void
 fwupd_client_verify_update_cb (GObject *source,
 			       GAsyncResult *res,
@@ -2180,58 +2877,66 @@ fwupd_client_install_stream_cb (GObject *source, GAsyncResult *res, gpointer use
 	g_task_return_boolean (task, TRUE);
 }
 
-void
-fwupd_client_install_stream_async (FwupdClient *self,
-				   const gchar *device_id,
-				   GUnixInputStream *istr,
+static void
+fwupd_client_install_options_init (GVariantBuilder *builder,
 				   const gchar *filename_hint,
-				   FwupdInstallFlags install_flags,
-				   GCancellable *cancellable,
-				   GAsyncReadyCallback callback,
-				   gpointer callback_data)
+				   FwupdInstallFlags install_flags)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE (self);
-	GVariantBuilder builder;
-	g_autoptr(GDBusMessage) request = NULL;
-	g_autoptr(GUnixFDList) fd_list = NULL;
-	g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
-
-	/* set options */
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
-	g_variant_builder_add (&builder, "{sv}",
+	g_variant_builder_init (builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (builder, "{sv}",
 			       "reason", g_variant_new_string ("user-action"));
 	if (filename_hint != NULL) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "filename", g_variant_new_string (filename_hint));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_OFFLINE) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "offline", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_OLDER) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "allow-older", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_REINSTALL) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "allow-reinstall", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "allow-branch-switch", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_FORCE) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "force", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_IGNORE_POWER) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "ignore-power", g_variant_new_boolean (TRUE));
 	}
 	if (install_flags & FWUPD_INSTALL_FLAG_NO_HISTORY) {
-		g_variant_builder_add (&builder, "{sv}",
+		g_variant_builder_add (builder, "{sv}",
 				       "no-history", g_variant_new_boolean (TRUE));
 	}
+}
+
+void
+fwupd_client_install_stream_async (FwupdClient *self,
+				   const gchar *device_id,
+				   GUnixInputStream *istr,
+				   const gchar *filename_hint,
+				   FwupdInstallFlags install_flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	GVariantBuilder builder;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+	g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+	/* set options */
+	fwupd_client_install_options_init (&builder, filename_hint, install_flags);
 
 	/* set out of band file descriptor */
 	fd_list = g_unix_fd_list_new ();
@@ -2416,6 +3121,126 @@ fwupd_client_install_finish (FwupdClient *self, GAsyncResult *res, GError **erro
 	return g_task_propagate_boolean (G_TASK(res), error);
 }
 
+/**
+ * fwupd_client_install_batch_async:
+ * @self: A #FwupdClient
+ * @device_ids: (element-type utf8): the device IDs, or `*` to match any device
+ * @filenames: (element-type filename): the filenames to install, one for each device ID
+ * @install_flags: the #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_ALLOW_REINSTALL
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Install firmware from more than one archive as one transaction, so that
+ * the client is only asked to authenticate once and the devices are
+ * prepared and cleaned up together.
+ *
+ * NOTE: This method is thread-safe, but progress signals will be
+ * emitted in the global default main context, if not explicitly set with
+ * fwupd_client_set_main_context().
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_install_batch_async (FwupdClient *self,
+				  GPtrArray *device_ids,
+				  GPtrArray *filenames,
+				  FwupdInstallFlags install_flags,
+				  GCancellable *cancellable,
+				  GAsyncReadyCallback callback,
+				  gpointer callback_data)
+{
+#ifdef HAVE_GIO_UNIX
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	GVariantBuilder builder;
+	GVariantBuilder builder_items;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = g_unix_fd_list_new ();
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (device_ids != NULL);
+	g_return_if_fail (filenames != NULL);
+	g_return_if_fail (device_ids->len == filenames->len);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (priv->proxy != NULL);
+
+	/* set out of band file descriptors, which are duplicated */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	g_variant_builder_init (&builder_items, G_VARIANT_TYPE ("a(sh)"));
+	for (guint i = 0; i < filenames->len; i++) {
+		const gchar *filename = g_ptr_array_index (filenames, i);
+		gint idx;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GUnixInputStream) istr = NULL;
+
+		istr = fwupd_unix_input_stream_from_fn (filename, &error);
+		if (istr == NULL) {
+			g_variant_builder_clear (&builder_items);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		idx = g_unix_fd_list_append (fd_list, g_unix_input_stream_get_fd (istr), &error);
+		if (idx < 0) {
+			g_variant_builder_clear (&builder_items);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		g_variant_builder_add (&builder_items, "(sh)",
+				       (const gchar *) g_ptr_array_index (device_ids, i),
+				       idx);
+	}
+
+	/* set options */
+	fwupd_client_install_options_init (&builder, NULL, install_flags);
+
+	/* call into daemon */
+	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
+						  FWUPD_DBUS_PATH,
+						  FWUPD_DBUS_INTERFACE,
+						  "InstallBatch");
+	g_dbus_message_set_unix_fd_list (request, fd_list);
+	g_dbus_message_set_body (request, g_variant_new ("(a(sh)a{sv})",
+							 &builder_items,
+							 &builder));
+	g_dbus_connection_send_message_with_reply (g_dbus_proxy_get_connection (priv->proxy),
+						   request,
+						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+						   G_MAXINT,
+						   NULL,
+						   cancellable,
+						   fwupd_client_install_stream_cb,
+						   g_steal_pointer (&task));
+#else
+	g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+	g_task_return_new_error (task,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_SUPPORTED,
+				 "Not supported as <glib-unix.h> is unavailable");
+#endif
+}
+
+/**
+ * fwupd_client_install_batch_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_install_batch_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_install_batch_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK(res), error);
+}
+
 typedef struct {
 	FwupdDevice		*device;
 	FwupdRelease		*release;
@@ -2461,7 +3286,151 @@ fwupd_client_install_release_bytes_cb (GObject *source, GAsyncResult *res, gpoin
 	g_task_return_boolean (task, TRUE);
 }
 
-static void
+/* releases are kept in the user cache directory so that flashing the same
+ * firmware onto several identical devices only downloads it once */
+#define FWUPD_CLIENT_FIRMWARE_CACHE_SIZE_MAX	(512 * 1024 * 1024)
+
+static gchar *
+fwupd_client_firmware_cache_get_dirname (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), "fwupd", "firmware", NULL);
+}
+
+static gint
+fwupd_client_firmware_cache_sort_cb (gconstpointer a, gconstpointer b)
+{
+	GFileInfo *info1 = *((GFileInfo **) a);
+	GFileInfo *info2 = *((GFileInfo **) b);
+	guint64 mtime1 = g_file_info_get_attribute_uint64 (info1, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	guint64 mtime2 = g_file_info_get_attribute_uint64 (info2, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	if (mtime1 < mtime2)
+		return -1;
+	if (mtime1 > mtime2)
+		return 1;
+	return 0;
+}
+
+/* remove the least recently used entries until the cache fits */
+static void
+fwupd_client_firmware_cache_prune (GFile *dir)
+{
+	guint64 total = 0;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFileEnumerator) enumerator = NULL;
+	g_autoptr(GPtrArray) infos = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	enumerator = g_file_enumerate_children (dir,
+						G_FILE_ATTRIBUTE_STANDARD_NAME ","
+						G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+						G_FILE_ATTRIBUTE_TIME_MODIFIED,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						NULL, &error_local);
+	if (enumerator == NULL) {
+		g_debug ("failed to enumerate firmware cache: %s", error_local->message);
+		return;
+	}
+	while (TRUE) {
+		GFileInfo *info = g_file_enumerator_next_file (enumerator, NULL, NULL);
+		if (info == NULL)
+			break;
+		total += g_file_info_get_size (info);
+		g_ptr_array_add (infos, info);
+	}
+	g_ptr_array_sort (infos, fwupd_client_firmware_cache_sort_cb);
+	for (guint i = 0; i < infos->len && total > FWUPD_CLIENT_FIRMWARE_CACHE_SIZE_MAX; i++) {
+		GFileInfo *info = g_ptr_array_index (infos, i);
+		g_autoptr(GFile) file = g_file_get_child (dir, g_file_info_get_name (info));
+		g_debug ("removing %s from firmware cache", g_file_info_get_name (info));
+		if (!g_file_delete (file, NULL, NULL))
+			continue;
+		total -= g_file_info_get_size (info);
+	}
+}
+
+static GBytes *
+fwupd_client_firmware_cache_lookup (const gchar *checksum)
+{
+	GChecksumType checksum_type = fwupd_checksum_guess_kind (checksum);
+	g_autofree gchar *checksum_actual = NULL;
+	g_autofree gchar *dirname = fwupd_client_firmware_cache_get_dirname ();
+	g_autofree gchar *fn = g_build_filename (dirname, checksum, NULL);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GMappedFile) mmap = NULL;
+
+	mmap = g_mapped_file_new (fn, FALSE, NULL);
+	if (mmap == NULL)
+		return NULL;
+	blob = g_mapped_file_get_bytes (mmap);
+
+	/* never trust the cache */
+	checksum_actual = g_compute_checksum_for_bytes (checksum_type, blob);
+	if (g_strcmp0 (checksum, checksum_actual) != 0) {
+		g_debug ("cached %s was invalid, ignoring", fn);
+		g_unlink (fn);
+		return NULL;
+	}
+
+	/* mark as recently used */
+	file = g_file_new_for_path (fn);
+	g_file_set_attribute_uint64 (file,
+				     G_FILE_ATTRIBUTE_TIME_MODIFIED,
+				     (guint64) (g_get_real_time () / G_USEC_PER_SEC),
+				     G_FILE_QUERY_INFO_NONE,
+				     NULL, NULL);
+	return g_steal_pointer (&blob);
+}
+
+static void
+fwupd_client_firmware_cache_save (const gchar *checksum, GBytes *blob)
+{
+	g_autofree gchar *dirname = fwupd_client_firmware_cache_get_dirname ();
+	g_autofree gchar *fn = g_build_filename (dirname, checksum, NULL);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) dir = g_file_new_for_path (dirname);
+
+	/* too large to be worth keeping */
+	if (g_bytes_get_size (blob) > FWUPD_CLIENT_FIRMWARE_CACHE_SIZE_MAX)
+		return;
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_debug ("failed to create %s", dirname);
+		return;
+	}
+	if (!g_file_set_contents (fn,
+				  g_bytes_get_data (blob, NULL),
+				  (gssize) g_bytes_get_size (blob),
+				  &error_local)) {
+		g_debug ("failed to save %s: %s", fn, error_local->message);
+		return;
+	}
+	fwupd_client_firmware_cache_prune (dir);
+}
+
+static void
+fwupd_client_install_release_blob (GTask *task, GBytes *blob)
+{
+	FwupdClient *self = g_task_get_source_object (task);
+	FwupdClientInstallReleaseData *data = g_task_get_task_data (task);
+	GCancellable *cancellable = g_task_get_cancellable (task);
+
+	/* the firmware is now in the cache ready for the real install */
+	if (data->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD) {
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (task);
+		return;
+	}
+
+	/* if the device specifies ONLY_OFFLINE automatically set this flag */
+	if (fwupd_device_has_flag (data->device, FWUPD_DEVICE_FLAG_ONLY_OFFLINE))
+		data->install_flags |= FWUPD_INSTALL_FLAG_OFFLINE;
+	fwupd_client_install_bytes_async (self,
+					  fwupd_device_get_id (data->device), blob,
+					  data->install_flags, cancellable,
+					  fwupd_client_install_release_bytes_cb,
+					  task);
+}
+
+static void
 fwupd_client_install_release_download_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GBytes) blob = NULL;
@@ -2469,7 +3438,6 @@ fwupd_client_install_release_download_cb (GObject *source, GAsyncResult *res, gp
 	g_autoptr(GTask) task = G_TASK (user_data);
 	FwupdClientInstallReleaseData *data = g_task_get_task_data (task);
 	GChecksumType checksum_type;
-	GCancellable *cancellable = g_task_get_cancellable (task);
 	const gchar *checksum_expected;
 	g_autofree gchar *checksum_actual = NULL;
 
@@ -2491,15 +3459,33 @@ fwupd_client_install_release_download_cb (GObject *source, GAsyncResult *res, gp
 					 checksum_expected, checksum_actual);
 		return;
 	}
+	fwupd_client_firmware_cache_save (checksum_expected, blob);
+	fwupd_client_install_release_blob (g_steal_pointer (&task), blob);
+}
 
-	/* if the device specifies ONLY_OFFLINE automatically set this flag */
-	if (fwupd_device_has_flag (data->device, FWUPD_DEVICE_FLAG_ONLY_OFFLINE))
-		data->install_flags |= FWUPD_INSTALL_FLAG_OFFLINE;
-	fwupd_client_install_bytes_async (FWUPD_CLIENT (source),
-					  fwupd_device_get_id (data->device), blob,
-					  data->install_flags, cancellable,
-					  fwupd_client_install_release_bytes_cb,
-					  g_steal_pointer (&task));
+static void
+fwupd_client_install_release_download (GTask *task, GPtrArray *urls)
+{
+	FwupdClient *self = g_task_get_source_object (task);
+	FwupdClientInstallReleaseData *data = g_task_get_task_data (task);
+	GCancellable *cancellable = g_task_get_cancellable (task);
+	const gchar *checksum;
+
+	/* already downloaded */
+	checksum = fwupd_checksum_get_best (fwupd_release_get_checksums (data->release));
+	if (checksum != NULL) {
+		g_autoptr(GBytes) blob = fwupd_client_firmware_cache_lookup (checksum);
+		if (blob != NULL) {
+			g_debug ("using cached %s", checksum);
+			fwupd_client_install_release_blob (task, blob);
+			return;
+		}
+	}
+	fwupd_client_download_bytes2_async (self, urls,
+					    data->download_flags,
+					    cancellable,
+					    fwupd_client_install_release_download_cb,
+					    task);
 }
 
 static gboolean
@@ -2525,7 +3511,9 @@ static void
 fwupd_client_install_release_remote_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	GPtrArray *locations;
+	const gchar *checksum;
 	const gchar *uri_tmp;
+	gchar **peer_uris;
 	g_autofree gchar *fn = NULL;
 	g_autoptr(FwupdRemote) remote = NULL;
 	g_autoptr(GError) error = NULL;
@@ -2562,6 +3550,12 @@ fwupd_client_install_release_remote_cb (GObject *source, GAsyncResult *res, gpoi
 		fn = g_strdup (uri_tmp + 7);
 	}
 
+	/* already on disk, so there is nothing to prefetch */
+	if (fn != NULL && data->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
 	/* install with flags chosen by the user */
 	if (fn != NULL) {
 		fwupd_client_install_async (FWUPD_CLIENT (source),
@@ -2573,6 +3567,15 @@ fwupd_client_install_release_remote_cb (GObject *source, GAsyncResult *res, gpoi
 		return;
 	}
 
+	/* try peers on the local network first, as the checksum is verified */
+	checksum = fwupd_checksum_get_best (fwupd_release_get_checksums (data->release));
+	peer_uris = fwupd_remote_get_peer_uris (remote);
+	for (guint i = 0; checksum != NULL && peer_uris != NULL && peer_uris[i] != NULL; i++) {
+		if (peer_uris[i][0] == '\0')
+			continue;
+		g_ptr_array_add (uris_built, g_build_filename (peer_uris[i], checksum, NULL));
+	}
+
 	/* remote file */
 	for (guint i = 0; i < locations->len; i++) {
 		uri_tmp = g_ptr_array_index (locations, i);
@@ -2592,12 +3595,7 @@ fwupd_client_install_release_remote_cb (GObject *source, GAsyncResult *res, gpoi
 	}
 
 	/* download file */
-	fwupd_client_download_bytes2_async (FWUPD_CLIENT (source),
-					    uris_built,
-					    data->download_flags,
-					    cancellable,
-					    fwupd_client_install_release_download_cb,
-					    g_steal_pointer (&task));
+	fwupd_client_install_release_download (g_steal_pointer (&task), uris_built);
 }
 
 #ifdef HAVE_LIBCURL
@@ -2681,12 +3679,8 @@ fwupd_client_install_release2_async (FwupdClient *self,
 	/* work out what remote-specific URI fields this should use */
 	remote_id = fwupd_release_get_remote_id (release);
 	if (remote_id == NULL) {
-		fwupd_client_download_bytes2_async (self,
-						    fwupd_release_get_locations (release),
-						    download_flags,
-						    cancellable,
-						    fwupd_client_install_release_download_cb,
-						    g_steal_pointer (&task));
+		fwupd_client_install_release_download (g_steal_pointer (&task),
+						       fwupd_release_get_locations (release));
 		return;
 	}
 
@@ -2972,6 +3966,25 @@ fwupd_client_get_host_security_id (FwupdClient *self)
 	return priv->host_security_id;
 }
 
+/**
+ * fwupd_client_get_metadata_generation:
+ * @self: A #FwupdClient
+ *
+ * Gets the number the daemon increments each time it starts using new
+ * metadata, which can be used to tell when a refreshed catalog is live.
+ *
+ * Returns: integer, or 0 for unknown.
+ *
+ * Since: 1.5.8
+ **/
+guint
+fwupd_client_get_metadata_generation (FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), 0);
+	return priv->metadata_generation;
+}
+
 /**
  * fwupd_client_get_status:
  * @self: A #FwupdClient
@@ -3026,6 +4039,94 @@ fwupd_client_get_daemon_interactive (FwupdClient *self)
 	return priv->interactive;
 }
 
+/**
+ * fwupd_client_set_cache_enabled:
+ * @self: A #FwupdClient
+ * @cache_enabled: %TRUE to cache results
+ *
+ * Sets whether the results of fwupd_client_get_devices_async(),
+ * fwupd_client_get_releases_async(), fwupd_client_get_upgrades_async() and
+ * fwupd_client_get_upgrades_for_all_devices_async() are cached.
+ *
+ * The cache is cleared when the daemon emits any of the `::changed`,
+ * `::device-added`, `::device-removed` or `::device-changed` signals.
+ * Cached objects are shared between callers and should not be modified.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_set_cache_enabled (FwupdClient *self, gboolean cache_enabled)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_mutex_lock (&priv->cache_mutex);
+	priv->cache_enabled = cache_enabled;
+	g_mutex_unlock (&priv->cache_mutex);
+	if (!cache_enabled)
+		fwupd_client_cache_invalidate (self);
+}
+
+/**
+ * fwupd_client_get_cache_enabled:
+ * @self: A #FwupdClient
+ *
+ * Gets whether results are being cached.
+ *
+ * Returns: %TRUE if fwupd_client_set_cache_enabled() has been used
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_get_cache_enabled (FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	locker = g_mutex_locker_new (&priv->cache_mutex);
+	return priv->cache_enabled;
+}
+
+/**
+ * fwupd_client_set_daemon_address:
+ * @self: A #FwupdClient
+ * @daemon_address: (nullable): a D-Bus address, e.g. `unix:path=/tmp/fwupd.sock`
+ *
+ * Sets the address of the message bus the daemon is running on, for instance
+ * the system bus of another machine forwarded over SSH or exposed as TCP.
+ * If unset then the local system bus is used.
+ *
+ * This must be called before fwupd_client_connect_async().
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_set_daemon_address (FwupdClient *self, const gchar *daemon_address)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (priv->proxy == NULL);
+	g_free (priv->daemon_address);
+	priv->daemon_address = g_strdup (daemon_address);
+}
+
+/**
+ * fwupd_client_get_daemon_address:
+ * @self: A #FwupdClient
+ *
+ * Gets the address of the message bus set with fwupd_client_set_daemon_address().
+ *
+ * Returns: a D-Bus address, or %NULL for the local system bus
+ *
+ * Since: 1.5.8
+ **/
+const gchar *
+fwupd_client_get_daemon_address (FwupdClient *self)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), NULL);
+	return priv->daemon_address;
+}
+
 #ifdef HAVE_GIO_UNIX
 
 static void
@@ -3203,27 +4304,31 @@ fwupd_client_refresh_remote_data_free (FwupdClientRefreshRemoteData *data)
 }
 
 static void
-fwupd_client_refresh_remote_update_cb (GObject *source,
-				       GAsyncResult *res,
-				       gpointer user_data)
+fwupd_client_refresh_remote_metadata_cb (GObject *source,
+					 GAsyncResult *res,
+					 gpointer user_data)
 {
+	g_autoptr(GBytes) bytes = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClientRefreshRemoteData *data = g_task_get_task_data (task);
 
 	/* save metadata */
-	if (!fwupd_client_update_metadata_bytes_finish (FWUPD_CLIENT (source), res, &error)) {
+	bytes = fwupd_client_download_bytes_finish (FWUPD_CLIENT (source), res, &error);
+	if (bytes == NULL) {
 		g_task_return_error (task, g_steal_pointer (&error));
 		return;
 	}
+	data->metadata = g_steal_pointer (&bytes);
 
 	/* success */
 	g_task_return_boolean (task, TRUE);
 }
 
 static void
-fwupd_client_refresh_remote_metadata_cb (GObject *source,
-					 GAsyncResult *res,
-					 gpointer user_data)
+fwupd_client_refresh_remote_signature_cb (GObject *source,
+					  GAsyncResult *res,
+					  gpointer user_data)
 {
 	g_autoptr(GBytes) bytes = NULL;
 	g_autoptr(GError) error = NULL;
@@ -3231,136 +4336,418 @@ fwupd_client_refresh_remote_metadata_cb (GObject *source,
 	FwupdClientRefreshRemoteData *data = g_task_get_task_data (task);
 	FwupdClient *self = g_task_get_source_object (task);
 	GCancellable *cancellable = g_task_get_cancellable (task);
+	GChecksumType checksum_kind;
+	g_autofree gchar *checksum = NULL;
 
-	/* save metadata */
+	/* save signature */
 	bytes = fwupd_client_download_bytes_finish (FWUPD_CLIENT (source), res, &error);
 	if (bytes == NULL) {
 		g_task_return_error (task, g_steal_pointer (&error));
 		return;
 	}
-	data->metadata = g_steal_pointer (&bytes);
+	data->signature = g_steal_pointer (&bytes);
+	if (fwupd_remote_get_keyring_kind (data->remote) == FWUPD_KEYRING_KIND_JCAT) {
+		if (!fwupd_remote_load_signature_bytes (data->remote, data->signature, &error)) {
+			g_prefix_error (&error, "Failed to load signature: ");
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+	}
+
+	/* is the signature checksum the same? */
+	checksum_kind = fwupd_checksum_guess_kind (fwupd_remote_get_checksum (data->remote));
+	checksum = g_compute_checksum_for_data (checksum_kind,
+						(const guchar *) g_bytes_get_data (data->signature, NULL),
+						g_bytes_get_size (data->signature));
+	if (g_strcmp0 (checksum, fwupd_remote_get_checksum (data->remote)) == 0) {
+		g_debug ("metadata signature of %s is unchanged, skipping",
+			 fwupd_remote_get_id (data->remote));
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* download metadata */
+	fwupd_client_download_bytes_async (self,
+					   fwupd_remote_get_metadata_uri (data->remote),
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   cancellable,
+					   fwupd_client_refresh_remote_metadata_cb,
+					   g_steal_pointer (&task));
+}
+
+/* downloads the signature and then the metadata if the signature changed,
+ * leaving both in the task data */
+static void
+fwupd_client_refresh_remote_fetch_async (FwupdClient *self,
+					 FwupdRemote *remote,
+					 GCancellable *cancellable,
+					 GAsyncReadyCallback callback,
+					 gpointer callback_data)
+{
+	FwupdClientRefreshRemoteData *data;
+	g_autoptr(GTask) task = NULL;
+
+	task = g_task_new (self, cancellable, callback, callback_data);
+	data = g_new0 (FwupdClientRefreshRemoteData, 1);
+	data->remote = g_object_ref (remote);
+	g_task_set_task_data (task,
+			      g_steal_pointer (&data),
+			      (GDestroyNotify) fwupd_client_refresh_remote_data_free);
+
+	/* download signature, which is usually unchanged since last time */
+	fwupd_client_download_bytes_async (self,
+					   fwupd_remote_get_metadata_uri_sig (remote),
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL,
+					   cancellable,
+					   fwupd_client_refresh_remote_signature_cb,
+					   g_steal_pointer (&task));
+}
+
+static gboolean
+fwupd_client_refresh_remote_fetch_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+fwupd_client_refresh_remote_update_cb (GObject *source,
+				       GAsyncResult *res,
+				       gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+
+	/* save metadata */
+	if (!fwupd_client_update_metadata_bytes_finish (FWUPD_CLIENT (source), res, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+fwupd_client_refresh_remote_fetch_cb (GObject *source,
+				      GAsyncResult *res,
+				      gpointer user_data)
+{
+	FwupdClient *self = FWUPD_CLIENT (source);
+	FwupdClientRefreshRemoteData *data = g_task_get_task_data (G_TASK (res));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+
+	if (!fwupd_client_refresh_remote_fetch_finish (self, res, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* signature is unchanged */
+	if (data->metadata == NULL) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
 
 	/* send all this to fwupd */
 	fwupd_client_update_metadata_bytes_async (self,
 						  fwupd_remote_get_id (data->remote),
 						  data->metadata,
 						  data->signature,
-						  cancellable,
+						  g_task_get_cancellable (task),
 						  fwupd_client_refresh_remote_update_cb,
 						  g_steal_pointer (&task));
 }
 
+/**
+ * fwupd_client_refresh_remote_async:
+ * @self: A #FwupdClient
+ * @remote: A #FwupdRemote
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Refreshes a remote by downloading new metadata.
+ *
+ * NOTE: This method is thread-safe, but progress signals will be
+ * emitted in the global default main context, if not explicitly set with
+ * fwupd_client_set_main_context().
+ *
+ * Since: 1.5.0
+ **/
+void
+fwupd_client_refresh_remote_async (FwupdClient *self,
+				   FwupdRemote *remote,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (FWUPD_IS_REMOTE (remote));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (self, cancellable, callback, callback_data);
+	fwupd_client_refresh_remote_fetch_async (self, remote, cancellable,
+						 fwupd_client_refresh_remote_fetch_cb,
+						 g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_refresh_remote_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_refresh_remote_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.0
+ **/
+gboolean
+fwupd_client_refresh_remote_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK(res), error);
+}
+
+typedef struct {
+	GPtrArray		*fetched;	/* (element-type FwupdClientRefreshRemoteData) */
+	guint			 pending;
+	GError			*error;		/* (nullable): the first failure */
+} FwupdClientRefreshRemotesHelper;
+
 static void
-fwupd_client_refresh_remote_signature_cb (GObject *source,
-					  GAsyncResult *res,
-					  gpointer user_data)
+fwupd_client_refresh_remotes_helper_free (FwupdClientRefreshRemotesHelper *helper)
 {
-	g_autoptr(GBytes) bytes = NULL;
+	g_ptr_array_unref (helper->fetched);
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_free (helper);
+}
+
+#ifdef HAVE_GIO_UNIX
+static void
+fwupd_client_refresh_remotes_update_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GDBusMessage) msg = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GTask) task = G_TASK (user_data);
-	FwupdClientRefreshRemoteData *data = g_task_get_task_data (task);
-	FwupdClient *self = g_task_get_source_object (task);
-	GCancellable *cancellable = g_task_get_cancellable (task);
-	GChecksumType checksum_kind;
-	g_autofree gchar *checksum = NULL;
+	FwupdClientRefreshRemotesHelper *helper = g_task_get_task_data (task);
 
-	/* save signature */
-	bytes = fwupd_client_download_bytes_finish (FWUPD_CLIENT (source), res, &error);
-	if (bytes == NULL) {
+	msg = g_dbus_connection_send_message_with_reply_finish (G_DBUS_CONNECTION (source),
+								res, &error);
+	if (msg == NULL) {
+		fwupd_client_fixup_dbus_error (error);
 		g_task_return_error (task, g_steal_pointer (&error));
 		return;
-	}
-	data->signature = g_steal_pointer (&bytes);
-	if (fwupd_remote_get_keyring_kind (data->remote) == FWUPD_KEYRING_KIND_JCAT) {
-		if (!fwupd_remote_load_signature_bytes (data->remote, data->signature, &error)) {
-			g_prefix_error (&error, "Failed to load signature: ");
-			g_task_return_error (task, g_steal_pointer (&error));
+	}
+	if (g_dbus_message_to_gerror (msg, &error)) {
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* some remotes could not be downloaded */
+	if (helper->error != NULL) {
+		g_task_return_error (task, g_steal_pointer (&helper->error));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+#endif
+
+/* sends all the changed metadata to the daemon in one call */
+static void
+fwupd_client_refresh_remotes_update (FwupdClient *self, GTask *task)
+{
+#ifdef HAVE_GIO_UNIX
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	FwupdClientRefreshRemotesHelper *helper = g_task_get_task_data (task);
+	GVariantBuilder builder;
+	g_autoptr(GDBusMessage) request = NULL;
+	g_autoptr(GUnixFDList) fd_list = g_unix_fd_list_new ();
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(shh)"));
+	for (guint i = 0; i < helper->fetched->len; i++) {
+		FwupdClientRefreshRemoteData *data = g_ptr_array_index (helper->fetched, i);
+		gint idx;
+		gint idx_sig;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GUnixInputStream) istr = NULL;
+		g_autoptr(GUnixInputStream) istr_sig = NULL;
+
+		istr = fwupd_unix_input_stream_from_bytes (data->metadata, &error);
+		if (istr == NULL) {
+			g_variant_builder_clear (&builder);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		istr_sig = fwupd_unix_input_stream_from_bytes (data->signature, &error);
+		if (istr_sig == NULL) {
+			g_variant_builder_clear (&builder);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		idx = g_unix_fd_list_append (fd_list, g_unix_input_stream_get_fd (istr), &error);
+		if (idx < 0) {
+			g_variant_builder_clear (&builder);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		idx_sig = g_unix_fd_list_append (fd_list, g_unix_input_stream_get_fd (istr_sig), &error);
+		if (idx_sig < 0) {
+			g_variant_builder_clear (&builder);
+			g_task_return_error (task, g_steal_pointer (&error));
+			return;
+		}
+		g_variant_builder_add (&builder, "(shh)",
+				       fwupd_remote_get_id (data->remote),
+				       idx, idx_sig);
+	}
+	request = g_dbus_message_new_method_call (FWUPD_DBUS_SERVICE,
+						  FWUPD_DBUS_PATH,
+						  FWUPD_DBUS_INTERFACE,
+						  "UpdateMetadataBatch");
+	g_dbus_message_set_unix_fd_list (request, fd_list);
+
+	/* call into daemon */
+	g_dbus_message_set_body (request, g_variant_new ("(a(shh))", &builder));
+	g_dbus_connection_send_message_with_reply (g_dbus_proxy_get_connection (priv->proxy),
+						   request,
+						   G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+						   G_MAXINT,
+						   NULL,
+						   g_task_get_cancellable (task),
+						   fwupd_client_refresh_remotes_update_cb,
+						   g_object_ref (task));
+#else
+	g_task_return_new_error (task,
+				 FWUPD_ERROR,
+				 FWUPD_ERROR_NOT_SUPPORTED,
+				 "Not supported as <glib-unix.h> is unavailable");
+#endif
+}
+
+static void
+fwupd_client_refresh_remotes_fetch_cb (GObject *source,
+				       GAsyncResult *res,
+				       gpointer user_data)
+{
+	FwupdClient *self = FWUPD_CLIENT (source);
+	FwupdClientRefreshRemoteData *data = g_task_get_task_data (G_TASK (res));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FwupdClientRefreshRemotesHelper *helper = g_task_get_task_data (task);
+
+	/* keep going so the other remotes can still be updated */
+	if (!fwupd_client_refresh_remote_fetch_finish (self, res, &error)) {
+		g_prefix_error (&error, "Failed to refresh %s: ",
+				fwupd_remote_get_id (data->remote));
+		if (helper->error == NULL)
+			helper->error = g_steal_pointer (&error);
+		else
+			g_debug ("%s", error->message);
+	} else if (data->metadata != NULL) {
+		FwupdClientRefreshRemoteData *data_new = g_new0 (FwupdClientRefreshRemoteData, 1);
+		data_new->remote = g_object_ref (data->remote);
+		data_new->signature = g_steal_pointer (&data->signature);
+		data_new->metadata = g_steal_pointer (&data->metadata);
+		g_ptr_array_add (helper->fetched, data_new);
+	} else {
+		g_debug ("%s is unchanged", fwupd_remote_get_id (data->remote));
+	}
+
+	/* wait for the other remotes */
+	if (--helper->pending > 0)
+		return;
+
+	/* every signature was unchanged */
+	if (helper->fetched->len == 0) {
+		if (helper->error != NULL) {
+			g_task_return_error (task, g_steal_pointer (&helper->error));
 			return;
 		}
-	}
-
-	/* is the signature checksum the same? */
-	checksum_kind = fwupd_checksum_guess_kind (fwupd_remote_get_checksum (data->remote));
-	checksum = g_compute_checksum_for_data (checksum_kind,
-						(const guchar *) g_bytes_get_data (data->signature, NULL),
-						g_bytes_get_size (data->signature));
-	if (g_strcmp0 (checksum, fwupd_remote_get_checksum (data->remote)) == 0) {
-		g_debug ("metadata signature of %s is unchanged, skipping",
-			 fwupd_remote_get_id (data->remote));
 		g_task_return_boolean (task, TRUE);
 		return;
 	}
-
-	/* download metadata */
-	fwupd_client_download_bytes_async (self,
-					   fwupd_remote_get_metadata_uri (data->remote),
-					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
-					   cancellable,
-					   fwupd_client_refresh_remote_metadata_cb,
-					   g_steal_pointer (&task));
+	fwupd_client_refresh_remotes_update (self, task);
 }
 
 /**
- * fwupd_client_refresh_remote_async:
+ * fwupd_client_refresh_remotes_async:
  * @self: A #FwupdClient
- * @remote: A #FwupdRemote
+ * @remotes: (element-type FwupdRemote): remotes to refresh
  * @cancellable: the #GCancellable, or %NULL
  * @callback: the function to run on completion
  * @callback_data: the data to pass to @callback
  *
- * Refreshes a remote by downloading new metadata.
+ * Refreshes several remotes by downloading new metadata for all of them at
+ * the same time. All the changed metadata is then sent to the daemon in one
+ * request, so that the metadata store is only rebuilt once.
+ *
+ * If one remote fails to download then the others are still refreshed, and
+ * the first error is returned.
  *
  * NOTE: This method is thread-safe, but progress signals will be
  * emitted in the global default main context, if not explicitly set with
  * fwupd_client_set_main_context().
  *
- * Since: 1.5.0
+ * Since: 1.5.8
  **/
 void
-fwupd_client_refresh_remote_async (FwupdClient *self,
-				   FwupdRemote *remote,
-				   GCancellable *cancellable,
-				   GAsyncReadyCallback callback,
-				   gpointer callback_data)
+fwupd_client_refresh_remotes_async (FwupdClient *self,
+				    GPtrArray *remotes,
+				    GCancellable *cancellable,
+				    GAsyncReadyCallback callback,
+				    gpointer callback_data)
 {
-	FwupdClientRefreshRemoteData *data;
+	FwupdClientRefreshRemotesHelper *helper;
 	g_autoptr(GTask) task = NULL;
 
 	g_return_if_fail (FWUPD_IS_CLIENT (self));
-	g_return_if_fail (FWUPD_IS_REMOTE (remote));
+	g_return_if_fail (remotes != NULL);
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
 	task = g_task_new (self, cancellable, callback, callback_data);
-	data = g_new0 (FwupdClientRefreshRemoteData, 1);
-	data->remote = g_object_ref (remote);
-	g_task_set_task_data (task,
-			      g_steal_pointer (&data),
-			      (GDestroyNotify) fwupd_client_refresh_remote_data_free);
-
-	/* download signature */
-	fwupd_client_download_bytes_async (self,
-					   fwupd_remote_get_metadata_uri_sig (remote),
-					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
-					   cancellable,
-					   fwupd_client_refresh_remote_signature_cb,
-					   g_steal_pointer (&task));
+	helper = g_new0 (FwupdClientRefreshRemotesHelper, 1);
+	helper->fetched = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_client_refresh_remote_data_free);
+	helper->pending = remotes->len;
+	g_task_set_task_data (task, helper,
+			      (GDestroyNotify) fwupd_client_refresh_remotes_helper_free);
+	if (remotes->len == 0) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
 
+	/* download everything at the same time */
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		fwupd_client_refresh_remote_fetch_async (self, remote, cancellable,
+							 fwupd_client_refresh_remotes_fetch_cb,
+							 g_object_ref (task));
+	}
 }
 
 /**
- * fwupd_client_refresh_remote_finish:
+ * fwupd_client_refresh_remotes_finish:
  * @self: A #FwupdClient
  * @res: the #GAsyncResult
  * @error: the #GError, or %NULL
  *
- * Gets the result of fwupd_client_refresh_remote_async().
+ * Gets the result of fwupd_client_refresh_remotes_async().
  *
  * Returns: %TRUE for success
  *
- * Since: 1.5.0
+ * Since: 1.5.8
  **/
 gboolean
-fwupd_client_refresh_remote_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+fwupd_client_refresh_remotes_finish (FwupdClient *self, GAsyncResult *res, GError **error)
 {
 	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
 	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
@@ -3862,6 +5249,87 @@ fwupd_client_set_feature_flags_finish (FwupdClient *self, GAsyncResult *res, GEr
 	return g_task_propagate_boolean (G_TASK(res), error);
 }
 
+static void
+fwupd_client_set_request_id_cb (GObject *source,
+				GAsyncResult *res,
+				gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &error);
+	if (val == NULL) {
+		fwupd_client_fixup_dbus_error (error);
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * fwupd_client_set_request_id_async:
+ * @self: A #FwupdClient
+ * @request_id: (nullable): a request ID, e.g. a trace ID, or %NULL
+ * @cancellable: the #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Sets the ID the daemon uses for the following requests from this client.
+ * The ID is included in the daemon debug output, the update history and the
+ * metrics, which allows a slow or failed update to be matched to the caller.
+ *
+ * Setting %NULL restores the IDs assigned by the daemon.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_client_set_request_id_async (FwupdClient *self,
+				   const gchar *request_id,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FWUPD_IS_CLIENT (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (priv->proxy != NULL);
+
+	/* call into daemon */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	g_dbus_proxy_call (priv->proxy, "SetRequestId",
+			   g_variant_new ("(s)", request_id != NULL ? request_id : ""),
+			   G_DBUS_CALL_FLAGS_NONE, -1,
+			   cancellable,
+			   fwupd_client_set_request_id_cb,
+			   g_steal_pointer (&task));
+}
+
+/**
+ * fwupd_client_set_request_id_finish:
+ * @self: A #FwupdClient
+ * @res: the #GAsyncResult
+ * @error: the #GError, or %NULL
+ *
+ * Gets the result of fwupd_client_set_request_id_async().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_client_set_request_id_finish (FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FWUPD_IS_CLIENT (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK(res), error);
+}
+
 static void
 fwupd_client_self_sign_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
@@ -4324,8 +5792,134 @@ fwupd_client_set_user_agent_for_package (FwupdClient *self,
 }
 
 #ifdef HAVE_LIBCURL
+static void
+fwupd_client_curl_download_free (FwupdCurlDownload *dl)
+{
+	if (dl->spool != NULL)
+		g_object_unref (dl->spool);
+	if (dl->error != NULL)
+		g_error_free (dl->error);
+	if (dl->buf != NULL)
+		g_byte_array_unref (dl->buf);
+	if (dl->headers != NULL)
+		curl_slist_free_all (dl->headers);
+	g_free (dl->etag);
+	g_free (dl->last_modified);
+	g_free (dl->spool_fn);
+	g_free (dl);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FwupdCurlDownload, fwupd_client_curl_download_free)
+
+static gboolean
+fwupd_client_curl_download_spool (FwupdCurlDownload *dl, GError **error)
+{
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFile) file_parent = NULL;
+
+	/* already spooling */
+	if (dl->spool != NULL)
+		return TRUE;
+
+	/* start a new file, as anything already on disk is in @buf */
+	file = g_file_new_for_path (dl->spool_fn);
+	file_parent = g_file_get_parent (file);
+	if (!g_file_query_exists (file_parent, NULL)) {
+		if (!g_file_make_directory_with_parents (file_parent, NULL, error))
+			return FALSE;
+	}
+	dl->spool = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+						     G_FILE_CREATE_PRIVATE,
+						     NULL, error));
+	return dl->spool != NULL;
+}
+
+static gboolean
+fwupd_client_curl_download_restart (FwupdCurlDownload *dl, GError **error)
+{
+	g_byte_array_set_size (dl->buf, 0);
+	dl->offset = 0;
+	dl->spooled = 0;
+	if (dl->spool != NULL) {
+		if (!g_seekable_truncate (G_SEEKABLE (dl->spool), 0, NULL, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static size_t
 fwupd_client_download_write_callback_cb (char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	FwupdCurlDownload *dl = (FwupdCurlDownload *) userdata;
+	gsize realsize = size * nmemb;
+
+	/* the server ignored the Range header and is sending everything */
+	if (!dl->checked_response) {
+		dl->checked_response = TRUE;
+		if (dl->offset > 0) {
+			glong status_code = 0;
+			curl_easy_getinfo (dl->curl, CURLINFO_RESPONSE_CODE, &status_code);
+			if (status_code != 206) {
+				g_debug ("server does not support resume, restarting");
+				if (!fwupd_client_curl_download_restart (dl, &dl->error))
+					return 0;
+			}
+		}
+	}
+
+	/* too large to keep in memory */
+	if (dl->spool == NULL &&
+	    dl->spool_fn != NULL &&
+	    dl->buf->len + realsize > FWUPD_CLIENT_DOWNLOAD_SPOOL_SIZE) {
+		if (!fwupd_client_curl_download_spool (dl, &dl->error))
+			return 0;
+		if (!g_output_stream_write_all (dl->spool, dl->buf->data, dl->buf->len,
+						NULL, NULL, &dl->error))
+			return 0;
+		dl->spooled += dl->buf->len;
+		g_byte_array_set_size (dl->buf, 0);
+	}
+	if (dl->spool != NULL) {
+		if (!g_output_stream_write_all (dl->spool, ptr, realsize,
+						NULL, NULL, &dl->error))
+			return 0;
+		dl->spooled += realsize;
+	} else {
+		g_byte_array_append (dl->buf, (const guint8 *) ptr, realsize);
+	}
+	return realsize;
+}
+
+static size_t
+fwupd_client_download_header_callback_cb (char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	FwupdCurlDownload *dl = (FwupdCurlDownload *) userdata;
+	gsize realsize = size * nmemb;
+	gchar *value;
+	g_autofree gchar *line = g_strndup (ptr, realsize);
+
+	/* a new response, e.g. after a redirect */
+	if (g_str_has_prefix (line, "HTTP/")) {
+		g_clear_pointer (&dl->etag, g_free);
+		g_clear_pointer (&dl->last_modified, g_free);
+		return realsize;
+	}
+	value = g_strstr_len (line, -1, ":");
+	if (value == NULL)
+		return realsize;
+	*value++ = '\0';
+	if (g_ascii_strcasecmp (line, "ETag") == 0) {
+		g_free (dl->etag);
+		dl->etag = g_strdup (g_strstrip (value));
+	} else if (g_ascii_strcasecmp (line, "Last-Modified") == 0) {
+		g_free (dl->last_modified);
+		dl->last_modified = g_strdup (g_strstrip (value));
+	}
+	return realsize;
+}
+
+static size_t
+fwupd_client_upload_write_callback_cb (char *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	GByteArray *buf = (GByteArray *) userdata;
 	gsize realsize = size * nmemb;
@@ -4385,26 +5979,211 @@ fwupd_client_download_ipfs (FwupdClient *self, const gchar *url, GError **error)
 	return fwupd_client_stream_read_bytes (stream, error);
 }
 
+static gchar *
+fwupd_client_download_get_spool_filename (const gchar *url)
+{
+	g_autofree gchar *basename = NULL;
+	basename = g_compute_checksum_for_string (G_CHECKSUM_SHA256, url, -1);
+	return g_build_filename (g_get_user_cache_dir (),
+				 "fwupd", "downloads",
+				 basename, NULL);
+}
+
+static gchar *
+fwupd_client_download_get_conditional_filename (const gchar *url)
+{
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *filename = NULL;
+	basename = g_compute_checksum_for_string (G_CHECKSUM_SHA256, url, -1);
+	filename = g_strdup_printf ("%s.ini", basename);
+	return g_build_filename (g_get_user_cache_dir (),
+				 "fwupd", "conditional",
+				 filename, NULL);
+}
+
+/* the validators and payload of the last complete download of @url */
+static GKeyFile *
+fwupd_client_download_conditional_load (const gchar *url)
+{
+	g_autofree gchar *fn = fwupd_client_download_get_conditional_filename (url);
+	g_autofree gchar *url_tmp = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+	g_autoptr(GError) error_local = NULL;
+
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return NULL;
+	if (!g_key_file_load_from_file (kf, fn, G_KEY_FILE_NONE, &error_local)) {
+		g_debug ("failed to load %s: %s", fn, error_local->message);
+		return NULL;
+	}
+	url_tmp = g_key_file_get_string (kf, "download", "Url", NULL);
+	if (g_strcmp0 (url_tmp, url) != 0)
+		return NULL;
+	if (!g_key_file_has_key (kf, "download", "Data", NULL))
+		return NULL;
+	return g_steal_pointer (&kf);
+}
+
+static void
+fwupd_client_download_conditional_save (FwupdCurlDownload *dl,
+					const gchar *url,
+					GBytes *blob)
+{
+	g_autofree gchar *fn = fwupd_client_download_get_conditional_filename (url);
+	g_autofree gchar *dirname = g_path_get_dirname (fn);
+	g_autofree gchar *data = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+	g_autoptr(GError) error_local = NULL;
+
+	/* nothing to send next time */
+	if (dl->etag == NULL && dl->last_modified == NULL) {
+		g_unlink (fn);
+		return;
+	}
+	g_key_file_set_string (kf, "download", "Url", url);
+	if (dl->etag != NULL)
+		g_key_file_set_string (kf, "download", "ETag", dl->etag);
+	if (dl->last_modified != NULL)
+		g_key_file_set_string (kf, "download", "LastModified", dl->last_modified);
+	data = g_base64_encode (g_bytes_get_data (blob, NULL), g_bytes_get_size (blob));
+	g_key_file_set_string (kf, "download", "Data", data);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_debug ("failed to create %s", dirname);
+		return;
+	}
+	if (!g_key_file_save_to_file (kf, fn, &error_local))
+		g_debug ("failed to save %s: %s", fn, error_local->message);
+}
+
+static gboolean
+fwupd_client_download_resume_from_spool (FwupdCurlDownload *dl)
+{
+	GStatBuf st = { 0x0 };
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* a previous process was interrupted */
+	if (g_stat (dl->spool_fn, &st) != 0 || st.st_size == 0)
+		return FALSE;
+	file = g_file_new_for_path (dl->spool_fn);
+	dl->spool = G_OUTPUT_STREAM (g_file_append_to (file, G_FILE_CREATE_PRIVATE,
+						       NULL, &error_local));
+	if (dl->spool == NULL) {
+		g_debug ("failed to open %s: %s", dl->spool_fn, error_local->message);
+		return FALSE;
+	}
+	dl->offset = st.st_size;
+	dl->spooled = st.st_size;
+	return TRUE;
+}
+
+static gboolean
+fwupd_client_download_is_transient (CURLcode res)
+{
+	return res == CURLE_PARTIAL_FILE ||
+	       res == CURLE_RECV_ERROR ||
+	       res == CURLE_SEND_ERROR ||
+	       res == CURLE_GOT_NOTHING ||
+	       res == CURLE_OPERATION_TIMEDOUT ||
+	       res == CURLE_HTTP2_STREAM ||
+	       res == CURLE_HTTP2;
+}
+
 static GBytes *
 fwupd_client_download_http (FwupdClient *self,
 			    CURL *curl,
 			    const gchar *url,
+			    FwupdClientDownloadFlags flags,
 			    GError **error)
 {
-	CURLcode res;
+	CURLcode res = CURLE_OK;
 	gchar errbuf[CURL_ERROR_SIZE] = { '\0' };
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	glong status_code = 0;
+	g_autoptr(FwupdCurlDownload) dl = g_new0 (FwupdCurlDownload, 1);
+	g_autoptr(GKeyFile) cached = NULL;
+
+	dl->curl = curl;
+	dl->buf = g_byte_array_new ();
+	dl->spool_fn = fwupd_client_download_get_spool_filename (url);
+	if (fwupd_client_download_resume_from_spool (dl))
+		g_debug ("resuming %s from %" CURL_FORMAT_CURL_OFF_T, url, dl->offset);
+
+	/* only ask for the payload if it changed since the last download */
+	if ((flags & FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL) > 0 && dl->offset == 0)
+		cached = fwupd_client_download_conditional_load (url);
+	if (cached != NULL) {
+		g_autofree gchar *etag = NULL;
+		g_autofree gchar *last_modified = NULL;
+		etag = g_key_file_get_string (cached, "download", "ETag", NULL);
+		if (etag != NULL) {
+			g_autofree gchar *hdr = g_strdup_printf ("If-None-Match: %s", etag);
+			dl->headers = curl_slist_append (dl->headers, hdr);
+		}
+		last_modified = g_key_file_get_string (cached, "download", "LastModified", NULL);
+		if (last_modified != NULL) {
+			g_autofree gchar *hdr = g_strdup_printf ("If-Modified-Since: %s", last_modified);
+			dl->headers = curl_slist_append (dl->headers, hdr);
+		}
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, dl->headers);
+	}
+	if (flags & FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL) {
+		curl_easy_setopt (curl, CURLOPT_HEADERFUNCTION, fwupd_client_download_header_callback_cb);
+		curl_easy_setopt (curl, CURLOPT_HEADERDATA, dl);
+	}
 
 	fwupd_client_set_status (self, FWUPD_STATUS_DOWNLOADING);
 	curl_easy_setopt (curl, CURLOPT_URL, url);
 	curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, errbuf);
 	curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, fwupd_client_download_write_callback_cb);
-	curl_easy_setopt (curl, CURLOPT_WRITEDATA, buf);
-	res = curl_easy_perform (curl);
+	curl_easy_setopt (curl, CURLOPT_WRITEDATA, dl);
+	for (guint i = 0; i <= FWUPD_CLIENT_DOWNLOAD_RETRIES; i++) {
+		curl_off_t offset_old;
+
+		/* continue from what has been received so far */
+		offset_old = dl->offset;
+		curl_easy_setopt (curl, CURLOPT_RESUME_FROM_LARGE, dl->offset);
+		dl->checked_response = FALSE;
+		errbuf[0] = '\0';
+		res = curl_easy_perform (curl);
+		if (dl->error != NULL) {
+			fwupd_client_set_status (self, FWUPD_STATUS_IDLE);
+			g_propagate_error (error, g_steal_pointer (&dl->error));
+			return NULL;
+		}
+		curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &status_code);
+
+		/* the partial file is stale, e.g. the server file was replaced */
+		if (status_code == 416 && dl->offset > 0) {
+			g_debug ("range not satisfiable, restarting");
+			if (!fwupd_client_curl_download_restart (dl, error)) {
+				fwupd_client_set_status (self, FWUPD_STATUS_IDLE);
+				return NULL;
+			}
+			continue;
+		}
+		if (res == CURLE_OK || !fwupd_client_download_is_transient (res))
+			break;
+
+		/* got some more data before failing */
+		dl->offset = dl->spooled + dl->buf->len;
+		if (dl->offset == offset_old)
+			break;
+		g_debug ("transfer interrupted at %" CURL_FORMAT_CURL_OFF_T ": %s, resuming",
+			 dl->offset, curl_easy_strerror (res));
+	}
+	curl_easy_setopt (curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t) 0);
+	if (flags & FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL) {
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, NULL);
+		curl_easy_setopt (curl, CURLOPT_HEADERFUNCTION, NULL);
+		curl_easy_setopt (curl, CURLOPT_HEADERDATA, NULL);
+	}
 	fwupd_client_set_status (self, FWUPD_STATUS_IDLE);
 	if (res != CURLE_OK) {
-		glong status_code = 0;
-		curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &status_code);
+		/* keep any spooled data for next time */
+		if (dl->spool != NULL && fwupd_client_download_is_transient (res))
+			g_output_stream_close (dl->spool, NULL, NULL);
+		else
+			g_unlink (dl->spool_fn);
 		g_debug ("status-code was %ld", status_code);
 		if (status_code == 429) {
 			g_set_error (error,
@@ -4428,7 +6207,33 @@ fwupd_client_download_http (FwupdClient *self,
 			     curl_easy_strerror (res));
 		return NULL;
 	}
-	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+
+	/* map the spooled file rather than reading it back in */
+	if (dl->spool != NULL) {
+		g_autoptr(GMappedFile) mmap = NULL;
+		if (!g_output_stream_close (dl->spool, NULL, error))
+			return NULL;
+		mmap = g_mapped_file_new (dl->spool_fn, FALSE, error);
+		g_unlink (dl->spool_fn);
+		if (mmap == NULL)
+			return NULL;
+		return g_mapped_file_get_bytes (mmap);
+	}
+
+	/* use the copy from last time */
+	if (cached != NULL && status_code == 304) {
+		gsize bufsz = 0;
+		g_autofree gchar *data = g_key_file_get_string (cached, "download", "Data", NULL);
+		g_autofree guchar *buf = g_base64_decode (data, &bufsz);
+		g_debug ("%s not modified, using cached copy", url);
+		return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
+	}
+	if (flags & FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL) {
+		g_autoptr(GBytes) blob = g_byte_array_free_to_bytes (g_steal_pointer (&dl->buf));
+		fwupd_client_download_conditional_save (dl, url, blob);
+		return g_steal_pointer (&blob);
+	}
+	return g_byte_array_free_to_bytes (g_steal_pointer (&dl->buf));
 }
 
 static void
@@ -4446,7 +6251,8 @@ fwupd_client_download_bytes_thread_cb (GTask *task,
 		g_autoptr(GError) error = NULL;
 		g_debug ("downloading %s", url);
 		if (fwupd_client_is_url_http (url)) {
-			blob = fwupd_client_download_http (self, helper->curl, url, &error);
+			blob = fwupd_client_download_http (self, helper->curl, url,
+							   helper->flags, &error);
 			if (blob != NULL)
 				break;
 		} else if (fwupd_client_is_url_ipfs (url)) {
@@ -4508,6 +6314,7 @@ fwupd_client_download_bytes2_async (FwupdClient *self,
 		g_task_return_error (task, g_steal_pointer (&error));
 		return;
 	}
+	helper->flags = flags;
 	g_task_set_task_data (task, g_steal_pointer (&helper), (GDestroyNotify) fwupd_client_curl_helper_free);
 
 	/* download data */
@@ -4598,7 +6405,7 @@ fwupd_client_upload_bytes_thread_cb (GTask *task,
 	g_autoptr(GByteArray) buf = g_byte_array_new ();
 
 	curl_easy_setopt (helper->curl, CURLOPT_ERRORBUFFER, errbuf);
-	curl_easy_setopt (helper->curl, CURLOPT_WRITEFUNCTION, fwupd_client_download_write_callback_cb);
+	curl_easy_setopt (helper->curl, CURLOPT_WRITEFUNCTION, fwupd_client_upload_write_callback_cb);
 	curl_easy_setopt (helper->curl, CURLOPT_WRITEDATA, buf);
 	res = curl_easy_perform (helper->curl);
 	fwupd_client_set_status (self, FWUPD_STATUS_IDLE);
@@ -4822,6 +6629,9 @@ fwupd_client_get_property (GObject *object, guint prop_id,
 	case PROP_INTERACTIVE:
 		g_value_set_boolean (value, priv->interactive);
 		break;
+	case PROP_METADATA_GENERATION:
+		g_value_set_uint (value, priv->metadata_generation);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -4941,6 +6751,22 @@ fwupd_client_class_init (FwupdClientClass *klass)
 			      NULL, NULL, g_cclosure_marshal_generic,
 			      G_TYPE_NONE, 1, FWUPD_TYPE_DEVICE);
 
+	/**
+	 * FwupdClient::device-verified:
+	 * @self: the #FwupdClient instance that emitted the signal
+	 * @result: the #FwupdDevice, with the update state and any update error set
+	 *
+	 * The ::device-verified signal is emitted when a device has been
+	 * verified by fwupd_client_verify_all_async().
+	 *
+	 * Since: 1.5.8
+	 **/
+	signals [SIGNAL_DEVICE_VERIFIED] =
+		g_signal_new ("device-verified",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL, g_cclosure_marshal_generic,
+			      G_TYPE_NONE, 1, FWUPD_TYPE_DEVICE);
+
 	/**
 	 * FwupdClient:status:
 	 *
@@ -5041,15 +6867,70 @@ fwupd_client_class_init (FwupdClientClass *klass)
 	pspec = g_param_spec_string ("host-security-id", NULL, NULL,
 				     NULL, G_PARAM_READABLE | G_PARAM_STATIC_NAME);
 	g_object_class_install_property (object_class, PROP_HOST_SECURITY_ID, pspec);
+
+	/**
+	 * FwupdClient:metadata-generation:
+	 *
+	 * Incremented each time the daemon starts using new metadata.
+	 *
+	 * Since: 1.5.8
+	 */
+	pspec = g_param_spec_uint ("metadata-generation", NULL, NULL,
+				   0, G_MAXUINT, 0,
+				   G_PARAM_READABLE | G_PARAM_STATIC_NAME);
+	g_object_class_install_property (object_class, PROP_METADATA_GENERATION, pspec);
 }
 
+#ifdef HAVE_LIBCURL
+static void
+fwupd_client_curl_share_lock_cb (CURL *handle,
+				 curl_lock_data data,
+				 curl_lock_access access,
+				 void *userptr)
+{
+	FwupdClientPrivate *priv = (FwupdClientPrivate *) userptr;
+	if (data < CURL_LOCK_DATA_LAST)
+		g_mutex_lock (&priv->curl_share_mutex[data]);
+}
+
+static void
+fwupd_client_curl_share_unlock_cb (CURL *handle,
+				   curl_lock_data data,
+				   void *userptr)
+{
+	FwupdClientPrivate *priv = (FwupdClientPrivate *) userptr;
+	if (data < CURL_LOCK_DATA_LAST)
+		g_mutex_unlock (&priv->curl_share_mutex[data]);
+}
+#endif
+
 static void
 fwupd_client_init (FwupdClient *self)
 {
 	FwupdClientPrivate *priv = GET_PRIVATE (self);
 	g_mutex_init (&priv->proxy_mutex);
 	g_mutex_init (&priv->idle_mutex);
+	g_mutex_init (&priv->devices_mutex);
+	g_mutex_init (&priv->cache_mutex);
+#ifdef HAVE_LIBCURL
+	for (guint i = 0; i < CURL_LOCK_DATA_LAST; i++)
+		g_mutex_init (&priv->curl_share_mutex[i]);
+	priv->curl_share = curl_share_init ();
+	if (priv->curl_share != NULL) {
+		curl_share_setopt (priv->curl_share, CURLSHOPT_LOCKFUNC, fwupd_client_curl_share_lock_cb);
+		curl_share_setopt (priv->curl_share, CURLSHOPT_UNLOCKFUNC, fwupd_client_curl_share_unlock_cb);
+		curl_share_setopt (priv->curl_share, CURLSHOPT_USERDATA, priv);
+		curl_share_setopt (priv->curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt (priv->curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+		curl_share_setopt (priv->curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	}
+#endif
 	priv->idle_sources = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_client_context_helper_free);
+	priv->devices_cache = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     g_free, (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
@@ -5060,6 +6941,7 @@ fwupd_client_finalize (GObject *object)
 
 	g_clear_pointer (&priv->main_ctx, g_main_context_unref);
 	g_free (priv->user_agent);
+	g_free (priv->daemon_address);
 	g_free (priv->daemon_version);
 	g_free (priv->host_product);
 	g_free (priv->host_machine_id);
@@ -5071,6 +6953,16 @@ fwupd_client_finalize (GObject *object)
 	g_mutex_clear (&priv->proxy_mutex);
 	if (priv->proxy != NULL)
 		g_object_unref (priv->proxy);
+	g_mutex_clear (&priv->devices_mutex);
+	g_ptr_array_unref (priv->devices_cache);
+	g_mutex_clear (&priv->cache_mutex);
+	g_hash_table_unref (priv->cache);
+#ifdef HAVE_LIBCURL
+	if (priv->curl_share != NULL)
+		curl_share_cleanup (priv->curl_share);
+	for (guint i = 0; i < CURL_LOCK_DATA_LAST; i++)
+		g_mutex_clear (&priv->curl_share_mutex[i]);
+#endif
 #ifdef SOUP_SESSION_COMPAT
 	if (priv->soup_session != NULL)
 		g_object_unref (priv->soup_session);
@@ -45,12 +45,16 @@ struct _FwupdClientClass
  * FwupdClientDownloadFlags:
  * @FWUPD_CLIENT_DOWNLOAD_FLAG_NONE:		No flags set
  * @FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_IPFS:	Only use IPFS when downloading URIs
+ * @FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD:	Only download and verify the firmware, do not install it
+ * @FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL:	Reuse the last download of the URI if the server reports it is not modified
  *
  * The options to use for downloading.
  **/
 typedef enum {
 	FWUPD_CLIENT_DOWNLOAD_FLAG_NONE			= 0,		/* Since: 1.4.5 */
 	FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_IPFS		= 1 << 0,	/* Since: 1.5.6 */
+	FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD	= 1 << 1,	/* Since: 1.5.8 */
+	FWUPD_CLIENT_DOWNLOAD_FLAG_CONDITIONAL		= 1 << 2,	/* Since: 1.5.8 */
 	/*< private >*/
 	FWUPD_CLIENT_DOWNLOAD_FLAG_LAST
 } FwupdClientDownloadFlags;
@@ -89,6 +93,14 @@ GPtrArray	*fwupd_client_get_devices_finish	(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_get_devices_cached_async	(FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_devices_cached_finish	(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fwupd_client_get_plugins_async		(FwupdClient	*self,
 							 GCancellable	*cancellable,
 							 GAsyncReadyCallback callback,
@@ -132,6 +144,14 @@ GPtrArray	*fwupd_client_get_upgrades_finish	(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_get_upgrades_for_all_devices_async	(FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_get_upgrades_for_all_devices_finish	(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fwupd_client_get_details_bytes_async	(FwupdClient	*self,
 							 GBytes		*bytes,
 							 GCancellable	*cancellable,
@@ -150,6 +170,14 @@ gboolean	 fwupd_client_verify_finish		(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_verify_all_async		(FwupdClient	*self,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+GPtrArray	*fwupd_client_verify_all_finish		(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fwupd_client_verify_update_async	(FwupdClient	*self,
 							 const gchar	*device_id,
 							 GCancellable	*cancellable,
@@ -242,6 +270,17 @@ gboolean	 fwupd_client_install_finish		(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_install_batch_async	(FwupdClient	*self,
+							 GPtrArray	*device_ids,
+							 GPtrArray	*filenames,
+							 FwupdInstallFlags install_flags,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_install_batch_finish	(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fwupd_client_install_bytes_async	(FwupdClient	*self,
 							 const gchar	*device_id,
 							 GBytes		*bytes,
@@ -293,6 +332,15 @@ gboolean	 fwupd_client_refresh_remote_finish	(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_refresh_remotes_async	(FwupdClient	*self,
+							 GPtrArray	*remotes,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_refresh_remotes_finish	(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fwupd_client_modify_remote_async	(FwupdClient	*self,
 							 const gchar	*remote_id,
 							 const gchar	*key,
@@ -327,11 +375,18 @@ GHashTable	*fwupd_client_get_report_metadata_finish(FwupdClient	*self,
 FwupdStatus	 fwupd_client_get_status		(FwupdClient	*self);
 gboolean	 fwupd_client_get_tainted		(FwupdClient	*self);
 gboolean	 fwupd_client_get_daemon_interactive	(FwupdClient	*self);
+gboolean	 fwupd_client_get_cache_enabled		(FwupdClient	*self);
+void		 fwupd_client_set_cache_enabled		(FwupdClient	*self,
+							 gboolean	 cache_enabled);
+const gchar	*fwupd_client_get_daemon_address	(FwupdClient	*self);
+void		 fwupd_client_set_daemon_address	(FwupdClient	*self,
+							 const gchar	*daemon_address);
 guint		 fwupd_client_get_percentage		(FwupdClient	*self);
 const gchar	*fwupd_client_get_daemon_version	(FwupdClient	*self);
 const gchar	*fwupd_client_get_host_product		(FwupdClient	*self);
 const gchar	*fwupd_client_get_host_machine_id	(FwupdClient	*self);
 const gchar	*fwupd_client_get_host_security_id	(FwupdClient	*self);
+guint		 fwupd_client_get_metadata_generation	(FwupdClient	*self);
 
 void		 fwupd_client_get_remotes_async		(FwupdClient	*self,
 							 GCancellable	*cancellable,
@@ -403,6 +458,15 @@ gboolean	 fwupd_client_set_feature_flags_finish	(FwupdClient	*self,
 							 GAsyncResult	*res,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fwupd_client_set_request_id_async	(FwupdClient	*self,
+							 const gchar	*request_id,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fwupd_client_set_request_id_finish	(FwupdClient	*self,
+							 GAsyncResult	*res,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 const gchar	*fwupd_client_get_user_agent		(FwupdClient	*self);
 void		 fwupd_client_set_user_agent		(FwupdClient	*self,
 							 const gchar	*user_agent);
@@ -24,10 +24,6 @@
 #endif
 #include <json-glib/json-glib.h>
 
-#if !GLIB_CHECK_VERSION(2,54,0)
-#include <errno.h>
-#endif
-
 /**
  * fwupd_checksum_guess_kind:
  * @checksum: A checksum
@@ -585,16 +581,63 @@ fwupd_build_history_report_json (GPtrArray *devices, GError **error)
 	return data;
 }
 
-#define FWUPD_GUID_NAMESPACE_DEFAULT	"6ba7b810-9dad-11d1-80b4-00c04fd430c8"
-#define FWUPD_GUID_NAMESPACE_MICROSOFT	"70ffd812-4c7f-4c7d-0000-000000000000"
+static const gchar fwupd_guid_hex_chars[] = "0123456789abcdef";
+
+/* writes each byte as two hex chars, which is much quicker than printf */
+static gchar *
+fwupd_guid_write_hex (gchar *str, const guint8 *buf, gsize bufsz)
+{
+	for (gsize i = 0; i < bufsz; i++) {
+		*str++ = fwupd_guid_hex_chars[buf[i] >> 4];
+		*str++ = fwupd_guid_hex_chars[buf[i] & 0x0f];
+	}
+	return str;
+}
+
+/**
+ * fwupd_guid_to_string_buf: (skip):
+ * @guid: a #fwupd_guid_t to read
+ * @flags: some %FwupdGuidFlags, e.g. %FWUPD_GUID_FLAG_MIXED_ENDIAN
+ * @buf: a buffer of at least %FWUPD_GUID_STRING_SIZE bytes
+ *
+ * Writes a NUL-terminated text GUID of mixed or BE endian for a packed buffer
+ * without allocating memory.
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_guid_to_string_buf (const fwupd_guid_t *guid, FwupdGuidFlags flags, gchar *buf)
+{
+	const guint8 *data = (const guint8 *) guid;
+	guint8 tmp[8];
+	gchar *str = buf;
+
+	g_return_if_fail (guid != NULL);
+	g_return_if_fail (buf != NULL);
 
-typedef struct __attribute__((packed)) {
-	guint32		a;
-	guint16		b;
-	guint16		c;
-	guint16		d;
-	guint8		e[6];
-} fwupd_guid_native_t;
+	/* mixed is bizaar, but specified as the DCE encoding */
+	memcpy (tmp, data, sizeof(tmp));
+	if (flags & FWUPD_GUID_FLAG_MIXED_ENDIAN) {
+		tmp[0] = data[3];
+		tmp[1] = data[2];
+		tmp[2] = data[1];
+		tmp[3] = data[0];
+		tmp[4] = data[5];
+		tmp[5] = data[4];
+		tmp[6] = data[7];
+		tmp[7] = data[6];
+	}
+	str = fwupd_guid_write_hex (str, tmp + 0, 4);
+	*str++ = '-';
+	str = fwupd_guid_write_hex (str, tmp + 4, 2);
+	*str++ = '-';
+	str = fwupd_guid_write_hex (str, tmp + 6, 2);
+	*str++ = '-';
+	str = fwupd_guid_write_hex (str, data + 8, 2);
+	*str++ = '-';
+	str = fwupd_guid_write_hex (str, data + 10, 6);
+	*str = '\0';
+}
 
 /**
  * fwupd_guid_to_string:
@@ -610,99 +653,39 @@ typedef struct __attribute__((packed)) {
 gchar *
 fwupd_guid_to_string (const fwupd_guid_t *guid, FwupdGuidFlags flags)
 {
-	fwupd_guid_native_t gnat;
+	gchar buf[FWUPD_GUID_STRING_SIZE];
 
 	g_return_val_if_fail (guid != NULL, NULL);
 
-	/* copy to avoid issues with aligning */
-	memcpy (&gnat, guid, sizeof(gnat));
-
-	/* mixed is bizaar, but specified as the DCE encoding */
-	if (flags & FWUPD_GUID_FLAG_MIXED_ENDIAN) {
-		return g_strdup_printf ("%08x-%04x-%04x-%04x-%02x%02x%02x%02x%02x%02x",
-					(guint) GUINT32_FROM_LE(gnat.a),
-					(guint) GUINT16_FROM_LE(gnat.b),
-					(guint) GUINT16_FROM_LE(gnat.c),
-					(guint) GUINT16_FROM_BE(gnat.d),
-					gnat.e[0], gnat.e[1],
-					gnat.e[2], gnat.e[3],
-					gnat.e[4], gnat.e[5]);
-	}
-	return g_strdup_printf ("%08x-%04x-%04x-%04x-%02x%02x%02x%02x%02x%02x",
-				(guint) GUINT32_FROM_BE(gnat.a),
-				(guint) GUINT16_FROM_BE(gnat.b),
-				(guint) GUINT16_FROM_BE(gnat.c),
-				(guint) GUINT16_FROM_BE(gnat.d),
-				gnat.e[0], gnat.e[1],
-				gnat.e[2], gnat.e[3],
-				gnat.e[4], gnat.e[5]);
-}
-
-#if !GLIB_CHECK_VERSION(2,54,0)
-static gboolean
-str_has_sign (const gchar *str)
-{
-	return str[0] == '-' || str[0] == '+';
+	fwupd_guid_to_string_buf (guid, flags, buf);
+	return g_strdup (buf);
 }
 
-static gboolean
-str_has_hex_prefix (const gchar *str)
+static gint
+fwupd_guid_hex_value (gchar chr)
 {
-	return str[0] == '0' && g_ascii_tolower (str[1]) == 'x';
+	if (chr >= '0' && chr <= '9')
+		return chr - '0';
+	if (chr >= 'a' && chr <= 'f')
+		return chr - 'a' + 10;
+	if (chr >= 'A' && chr <= 'F')
+		return chr - 'A' + 10;
+	return -1;
 }
 
+/* reads two hex chars for each byte, returning FALSE for any non-hex char */
 static gboolean
-g_ascii_string_to_unsigned (const gchar *str,
-			    guint base,
-			    guint64 min,
-			    guint64 max,
-			    guint64 *out_num,
-			    GError **error)
+fwupd_guid_read_hex (const gchar *str, guint8 *buf, gsize bufsz)
 {
-	const gchar *end_ptr = NULL;
-	gint saved_errno = 0;
-	guint64 number;
-
-	g_return_val_if_fail (str != NULL, FALSE);
-	g_return_val_if_fail (base >= 2 && base <= 36, FALSE);
-	g_return_val_if_fail (min <= max, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	if (str[0] == '\0') {
-		g_set_error_literal (error,
-				     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-				     "Empty string is not a number");
-		return FALSE;
-	}
-
-	errno = 0;
-	number = g_ascii_strtoull (str, (gchar **)&end_ptr, base);
-	saved_errno = errno;
-
-	if (g_ascii_isspace (str[0]) || str_has_sign (str) ||
-	    (base == 16 && str_has_hex_prefix (str)) ||
-	    (saved_errno != 0 && saved_errno != ERANGE) ||
-	    end_ptr == NULL ||
-	    *end_ptr != '\0') {
-		g_set_error (error,
-			     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-			     "“%s” is not an unsigned number", str);
-		return FALSE;
-	}
-	if (saved_errno == ERANGE || number < min || number > max) {
-		g_autofree gchar *min_str = g_strdup_printf ("%" G_GUINT64_FORMAT, min);
-		g_autofree gchar *max_str = g_strdup_printf ("%" G_GUINT64_FORMAT, max);
-		g_set_error (error,
-			     G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
-			     "Number “%s” is out of bounds [%s, %s]",
-			     str, min_str, max_str);
-		return FALSE;
+	for (gsize i = 0; i < bufsz; i++) {
+		gint hi = fwupd_guid_hex_value (str[i * 2]);
+		gint lo = fwupd_guid_hex_value (str[(i * 2) + 1]);
+		if (hi < 0 || lo < 0)
+			return FALSE;
+		buf[i] = (guint8) ((hi << 4) | lo);
 	}
-	if (out_num != NULL)
-		*out_num = number;
 	return TRUE;
 }
-#endif /* GLIB_CHECK_VERSION(2,54,0) */
 
 /**
  * fwupd_guid_from_string:
@@ -724,15 +707,12 @@ fwupd_guid_from_string (const gchar *guidstr,
 			FwupdGuidFlags flags,
 			GError **error)
 {
-	fwupd_guid_native_t gu = { 0x0 };
-	gboolean mixed_endian = flags & FWUPD_GUID_FLAG_MIXED_ENDIAN;
-	guint64 tmp;
-	g_auto(GStrv) split = NULL;
+	guint8 gu[16] = { 0x0 };
 
 	g_return_val_if_fail (guidstr != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* split into sections */
+	/* check the sections without splitting */
 	if (strlen (guidstr) != 36) {
 		g_set_error_literal (error,
 				     G_IO_ERROR,
@@ -740,51 +720,83 @@ fwupd_guid_from_string (const gchar *guidstr,
 				     "is not valid format");
 		return FALSE;
 	}
-	split = g_strsplit (guidstr, "-", 5);
-	if (g_strv_length (split) != 5) {
+	if (guidstr[8] != '-' || guidstr[13] != '-' ||
+	    guidstr[18] != '-' || guidstr[23] != '-') {
 		g_set_error_literal (error,
 				     G_IO_ERROR,
 				     G_IO_ERROR_INVALID_DATA,
 				     "is not valid format, no dashes");
 		return FALSE;
 	}
-	if (strlen (split[0]) != 8 && strlen (split[1]) != 4 &&
-	    strlen (split[2]) != 4 && strlen (split[3]) != 4 &&
-	    strlen (split[4]) != 12) {
-		g_set_error_literal (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_INVALID_DATA,
-				     "is not valid format, not GUID");
-		return FALSE;
-	}
 
 	/* parse */
-	if (!g_ascii_string_to_unsigned (split[0], 16, 0, 0xffffffff, &tmp, error))
-		return FALSE;
-	gu.a = mixed_endian ? GUINT32_TO_LE(tmp) : GUINT32_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[1], 16, 0, 0xffff, &tmp, error))
-		return FALSE;
-	gu.b = mixed_endian ? GUINT16_TO_LE(tmp) : GUINT16_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[2], 16, 0, 0xffff, &tmp, error))
-		return FALSE;
-	gu.c = mixed_endian ? GUINT16_TO_LE(tmp) : GUINT16_TO_BE(tmp);
-	if (!g_ascii_string_to_unsigned (split[3], 16, 0, 0xffff, &tmp, error))
+	if (!fwupd_guid_read_hex (guidstr + 0, gu + 0, 4) ||
+	    !fwupd_guid_read_hex (guidstr + 9, gu + 4, 2) ||
+	    !fwupd_guid_read_hex (guidstr + 14, gu + 6, 2) ||
+	    !fwupd_guid_read_hex (guidstr + 19, gu + 8, 2) ||
+	    !fwupd_guid_read_hex (guidstr + 24, gu + 10, 6)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "“%s” is not an unsigned number", guidstr);
 		return FALSE;
-	gu.d = GUINT16_TO_BE(tmp);
-	for (guint i = 0; i < 6; i++) {
-		gchar buffer[3] = { 0x0 };
-		memcpy (buffer, split[4] + (i * 2), 2);
-		if (!g_ascii_string_to_unsigned (buffer, 16, 0, 0xff, &tmp, error))
-			return FALSE;
-		gu.e[i] = tmp;
+	}
+	if (flags & FWUPD_GUID_FLAG_MIXED_ENDIAN) {
+		guint8 tmp[8];
+		memcpy (tmp, gu, sizeof(tmp));
+		gu[0] = tmp[3];
+		gu[1] = tmp[2];
+		gu[2] = tmp[1];
+		gu[3] = tmp[0];
+		gu[4] = tmp[5];
+		gu[5] = tmp[4];
+		gu[6] = tmp[7];
+		gu[7] = tmp[6];
 	}
 	if (guid != NULL)
-		memcpy (guid, &gu, sizeof(gu));
+		memcpy (guid, gu, sizeof(gu));
 
 	/* success */
 	return TRUE;
 }
 
+/* the namespaces are hardcoded as BE, not @flags */
+static const fwupd_guid_t fwupd_guid_namespace_default = {
+	0x6b, 0xa7, 0xb8, 0x10, 0x9d, 0xad, 0x11, 0xd1,
+	0x80, 0xb4, 0x00, 0xc0, 0x4f, 0xd4, 0x30, 0xc8 };
+static const fwupd_guid_t fwupd_guid_namespace_microsoft = {
+	0x70, 0xff, 0xd8, 0x12, 0x4c, 0x7f, 0x4c, 0x7d,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static void
+fwupd_guid_hash_data_buf (const guint8 *data, gsize datasz, FwupdGuidFlags flags, gchar *buf)
+{
+	const fwupd_guid_t *uu_namespace = &fwupd_guid_namespace_default;
+	gsize digestlen = 20;
+	guint8 hash[20];
+	fwupd_guid_t uu_new;
+	GChecksum *csum;
+
+	/* old MS GUID */
+	if (flags & FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT)
+		uu_namespace = &fwupd_guid_namespace_microsoft;
+
+	/* hash the namespace and then the string */
+	csum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (csum, (const guchar *) uu_namespace, sizeof(*uu_namespace));
+	g_checksum_update (csum, (const guchar *) data, (gssize) datasz);
+	g_checksum_get_digest (csum, hash, &digestlen);
+	g_checksum_free (csum);
+
+	/* copy most parts of the hash 1:1 */
+	memcpy (uu_new, hash, sizeof(uu_new));
+
+	/* set specific bits according to Section 4.1.3 */
+	uu_new[6] = (guint8) ((uu_new[6] & 0x0f) | (5 << 4));
+	uu_new[8] = (guint8) ((uu_new[8] & 0x3f) | 0x80);
+	fwupd_guid_to_string_buf ((const fwupd_guid_t *) &uu_new, flags, buf);
+}
+
 /**
  * fwupd_guid_hash_data:
  * @data: data to hash
@@ -804,38 +816,13 @@ fwupd_guid_from_string (const gchar *guidstr,
 gchar *
 fwupd_guid_hash_data (const guint8 *data, gsize datasz, FwupdGuidFlags flags)
 {
-	const gchar *namespace_id = FWUPD_GUID_NAMESPACE_DEFAULT;
-	gsize digestlen = 20;
-	guint8 hash[20];
-	fwupd_guid_t uu_namespace;
-	fwupd_guid_t uu_new;
-	g_autoptr(GChecksum) csum = NULL;
+	gchar buf[FWUPD_GUID_STRING_SIZE];
 
-	g_return_val_if_fail (namespace_id != NULL, NULL);
 	g_return_val_if_fail (data != NULL, NULL);
 	g_return_val_if_fail (datasz != 0, NULL);
 
-	/* old MS GUID */
-	if (flags & FWUPD_GUID_FLAG_NAMESPACE_MICROSOFT)
-		namespace_id = FWUPD_GUID_NAMESPACE_MICROSOFT;
-
-	/* convert the namespace to binary: hardcoded BE, not @flags */
-	if (!fwupd_guid_from_string (namespace_id, &uu_namespace, FWUPD_GUID_FLAG_NONE, NULL))
-		return NULL;
-
-	/* hash the namespace and then the string */
-	csum = g_checksum_new (G_CHECKSUM_SHA1);
-	g_checksum_update (csum, (guchar *) &uu_namespace, sizeof(uu_namespace));
-	g_checksum_update (csum, (guchar *) data, (gssize) datasz);
-	g_checksum_get_digest (csum, hash, &digestlen);
-
-	/* copy most parts of the hash 1:1 */
-	memcpy (uu_new, hash, sizeof(uu_new));
-
-	/* set specific bits according to Section 4.1.3 */
-	uu_new[6] = (guint8) ((uu_new[6] & 0x0f) | (5 << 4));
-	uu_new[8] = (guint8) ((uu_new[8] & 0x3f) | 0x80);
-	return fwupd_guid_to_string ((const fwupd_guid_t *) &uu_new, flags);
+	fwupd_guid_hash_data_buf (data, datasz, flags, buf);
+	return g_strdup (buf);
 }
 
 /**
@@ -916,6 +903,29 @@ fwupd_guid_hash_string (const gchar *str)
 				     FWUPD_GUID_FLAG_NONE);
 }
 
+/**
+ * fwupd_guid_hash_string_buf: (skip):
+ * @str: A source string to use as a key
+ * @buf: a buffer of at least %FWUPD_GUID_STRING_SIZE bytes
+ *
+ * Writes the GUID for a given string without allocating memory, using the
+ * same algorithm as fwupd_guid_hash_string().
+ *
+ * Returns: %TRUE for success, or %FALSE if the string was invalid
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fwupd_guid_hash_string_buf (const gchar *str, gchar *buf)
+{
+	g_return_val_if_fail (buf != NULL, FALSE);
+	if (str == NULL || str[0] == '\0')
+		return FALSE;
+	fwupd_guid_hash_data_buf ((const guint8 *) str, strlen (str),
+				  FWUPD_GUID_FLAG_NONE, buf);
+	return TRUE;
+}
+
 /**
  * fwupd_hash_kv_to_variant: (skip):
  **/
@@ -949,6 +959,101 @@ fwupd_variant_to_hash_kv (GVariant *dict)
 	return hash;
 }
 
+/* interned string : refcount */
+G_LOCK_DEFINE_STATIC (intern_pool);
+static GHashTable *intern_pool = NULL;
+
+/**
+ * fwupd_intern_ref: (skip):
+ * @str: (nullable): A string, e.g. a GUID or instance ID
+ *
+ * Gets a shared copy of @str and increments the refcount. Strings returned
+ * from this function can be compared for equality using the pointer value.
+ *
+ * Returns: the interned string, or %NULL if @str was %NULL
+ *
+ * Since: 1.5.8
+ **/
+const gchar *
+fwupd_intern_ref (const gchar *str)
+{
+	gpointer key = NULL;
+	gpointer value = NULL;
+
+	if (str == NULL)
+		return NULL;
+
+	G_LOCK (intern_pool);
+	if (intern_pool == NULL)
+		intern_pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	if (!g_hash_table_lookup_extended (intern_pool, str, &key, &value))
+		key = g_strdup (str);
+	g_hash_table_insert (intern_pool, key, GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+	G_UNLOCK (intern_pool);
+	return key;
+}
+
+/**
+ * fwupd_intern_unref: (skip):
+ * @str: (nullable): A string returned from fwupd_intern_ref()
+ *
+ * Decrements the refcount of the interned string, freeing it when unused.
+ * As a fallback, strings that were not interned are freed using g_free().
+ *
+ * Since: 1.5.8
+ **/
+void
+fwupd_intern_unref (const gchar *str)
+{
+	gpointer key = NULL;
+	gpointer value = NULL;
+
+	if (str == NULL)
+		return;
+
+	G_LOCK (intern_pool);
+	if (intern_pool == NULL ||
+	    !g_hash_table_lookup_extended (intern_pool, str, &key, &value) ||
+	    key != str) {
+		G_UNLOCK (intern_pool);
+		g_free ((gchar *) str);
+		return;
+	}
+	if (GPOINTER_TO_UINT (value) <= 1) {
+		g_hash_table_remove (intern_pool, str);
+	} else {
+		g_hash_table_insert (intern_pool, key,
+				     GUINT_TO_POINTER (GPOINTER_TO_UINT (value) - 1));
+	}
+	G_UNLOCK (intern_pool);
+}
+
+/**
+ * fwupd_intern_lookup: (skip):
+ * @str: (nullable): A string, e.g. a GUID or instance ID
+ *
+ * Finds the interned copy of @str without taking a reference. The result
+ * must only be used for pointer comparisons.
+ *
+ * Returns: the interned string, or %NULL if @str is not in use
+ *
+ * Since: 1.5.8
+ **/
+const gchar *
+fwupd_intern_lookup (const gchar *str)
+{
+	gpointer key = NULL;
+
+	if (str == NULL)
+		return NULL;
+
+	G_LOCK (intern_pool);
+	if (intern_pool != NULL)
+		g_hash_table_lookup_extended (intern_pool, str, &key, NULL);
+	G_UNLOCK (intern_pool);
+	return key;
+}
+
 static void
 fwupd_input_stream_read_bytes_cb (GObject *source,
 				  GAsyncResult *res,
@@ -1048,9 +1153,11 @@ fwupd_unix_input_stream_from_bytes (GBytes *bytes, GError **error)
 {
 #ifdef HAVE_MEMFD_CREATE
 	gint fd;
-	gssize rc;
+	gsize bufsz = 0;
+	gsize done = 0;
+	const guint8 *buf = g_bytes_get_data (bytes, &bufsz);
 
-	fd = memfd_create ("fwupd", MFD_CLOEXEC);
+	fd = memfd_create ("fwupd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
 	if (fd < 0) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -1058,19 +1165,32 @@ fwupd_unix_input_stream_from_bytes (GBytes *bytes, GError **error)
 				     "failed to create memfd");
 		return NULL;
 	}
-	rc = write (fd, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
-	if (rc < 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to write %" G_GSSIZE_FORMAT, rc);
-		return NULL;
+	while (done < bufsz) {
+		gssize rc = write (fd, buf + done, bufsz - done);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "failed to write: %s", g_strerror (errno));
+			close (fd);
+			return NULL;
+		}
+		done += rc;
 	}
+#ifdef F_ADD_SEALS
+	/* the daemon can map a sealed memfd rather than copying it */
+	if (fcntl (fd, F_ADD_SEALS,
+		   F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+		g_debug ("failed to seal memfd: %s", g_strerror (errno));
+#endif
 	if (lseek (fd, 0, SEEK_SET) < 0) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to seek: %s", g_strerror (errno));
+		close (fd);
 		return NULL;
 	}
 	return G_UNIX_INPUT_STREAM (g_unix_input_stream_new (fd, TRUE));
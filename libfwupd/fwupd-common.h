@@ -13,6 +13,7 @@ G_BEGIN_DECLS
 #define FWUPD_DBUS_PATH			"/"
 #define FWUPD_DBUS_SERVICE		"org.freedesktop.fwupd"
 #define FWUPD_DBUS_INTERFACE		"org.freedesktop.fwupd"
+#define FWUPD_DBUS_P2P_SOCKET_PATH	"/run/fwupd.sock"
 
 #define FWUPD_DEVICE_ID_ANY		"*"
 
@@ -37,6 +38,9 @@ typedef enum {
 typedef guint8 fwupd_guid_t[16];
 #endif
 
+/* the length of a GUID string such as 00112233-4455-6677-8899-aabbccddeeff */
+#define FWUPD_GUID_STRING_SIZE		37
+
 const gchar	*fwupd_checksum_get_best		(GPtrArray	*checksums);
 const gchar	*fwupd_checksum_get_by_kind		(GPtrArray	*checksums,
 							 GChecksumType	 kind);
@@ -57,6 +61,9 @@ gboolean	 fwupd_guid_from_string			(const gchar	*guidstr,
 							 fwupd_guid_t	*guid,
 							 FwupdGuidFlags	 flags,
 							 GError		**error);
+void		 fwupd_guid_to_string_buf		(const fwupd_guid_t *guid,
+							 FwupdGuidFlags	 flags,
+							 gchar		*buf);
 #else
 gchar		*fwupd_guid_to_string			(const guint8	 guid[16],
 							 FwupdGuidFlags	 flags);
@@ -67,6 +74,8 @@ gboolean	 fwupd_guid_from_string			(const gchar	*guidstr,
 #endif
 gboolean	 fwupd_guid_is_valid			(const gchar	*guid);
 gchar		*fwupd_guid_hash_string			(const gchar	*str);
+gboolean	 fwupd_guid_hash_string_buf		(const gchar	*str,
+							 gchar		*buf);
 gchar		*fwupd_guid_hash_data			(const guint8	*data,
 							 gsize		 datasz,
 							 FwupdGuidFlags	 flags);
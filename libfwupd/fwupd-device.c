@@ -65,6 +65,7 @@ typedef struct {
 	gchar				*update_image;
 	FwupdStatus			 status;
 	GPtrArray			*releases;
+	GVariant			*releases_variant; /* (nullable): not yet parsed */
 	FwupdDevice			*parent;	/* noref */
 } FwupdDevicePrivate;
 
@@ -462,12 +463,16 @@ gboolean
 fwupd_device_has_guid (FwupdDevice *device, const gchar *guid)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	const gchar *guid_tmp;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 
+	/* not interned means no device has it */
+	guid_tmp = fwupd_intern_lookup (guid);
+	if (guid_tmp == NULL)
+		return FALSE;
 	for (guint i = 0; i < priv->guids->len; i++) {
-		const gchar *guid_tmp = g_ptr_array_index (priv->guids, i);
-		if (g_strcmp0 (guid, guid_tmp) == 0)
+		if (g_ptr_array_index (priv->guids, i) == guid_tmp)
 			return TRUE;
 	}
 	return FALSE;
@@ -489,7 +494,7 @@ fwupd_device_add_guid (FwupdDevice *device, const gchar *guid)
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
 	if (fwupd_device_has_guid (device, guid))
 		return;
-	g_ptr_array_add (priv->guids, g_strdup (guid));
+	g_ptr_array_add (priv->guids, (gpointer) fwupd_intern_ref (guid));
 }
 
 /**
@@ -545,12 +550,16 @@ gboolean
 fwupd_device_has_instance_id (FwupdDevice *device, const gchar *instance_id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	const gchar *instance_id_tmp;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 
+	/* not interned means no device has it */
+	instance_id_tmp = fwupd_intern_lookup (instance_id);
+	if (instance_id_tmp == NULL)
+		return FALSE;
 	for (guint i = 0; i < priv->instance_ids->len; i++) {
-		const gchar *instance_id_tmp = g_ptr_array_index (priv->instance_ids, i);
-		if (g_strcmp0 (instance_id, instance_id_tmp) == 0)
+		if (g_ptr_array_index (priv->instance_ids, i) == instance_id_tmp)
 			return TRUE;
 	}
 	return FALSE;
@@ -572,7 +581,7 @@ fwupd_device_add_instance_id (FwupdDevice *device, const gchar *instance_id)
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
 	if (fwupd_device_has_instance_id (device, instance_id))
 		return;
-	g_ptr_array_add (priv->instance_ids, g_strdup (instance_id));
+	g_ptr_array_add (priv->instance_ids, (gpointer) fwupd_intern_ref (instance_id));
 }
 
 /**
@@ -787,13 +796,17 @@ gboolean
 fwupd_device_has_vendor_id (FwupdDevice *device, const gchar *vendor_id)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	const gchar *vendor_id_tmp;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 	g_return_val_if_fail (vendor_id != NULL, FALSE);
 
+	/* not interned means no device has it */
+	vendor_id_tmp = fwupd_intern_lookup (vendor_id);
+	if (vendor_id_tmp == NULL)
+		return FALSE;
 	for (guint i = 0; i < priv->vendor_ids->len; i++) {
-		const gchar *vendor_id_tmp = g_ptr_array_index (priv->vendor_ids, i);
-		if (g_strcmp0 (vendor_id, vendor_id_tmp) == 0)
+		if (g_ptr_array_index (priv->vendor_ids, i) == vendor_id_tmp)
 			return TRUE;
 	}
 	return FALSE;
@@ -819,7 +832,7 @@ fwupd_device_add_vendor_id (FwupdDevice *device, const gchar *vendor_id)
 
 	if (fwupd_device_has_vendor_id (device, vendor_id))
 		return;
-	g_ptr_array_add (priv->vendor_ids, g_strdup (vendor_id));
+	g_ptr_array_add (priv->vendor_ids, (gpointer) fwupd_intern_ref (vendor_id));
 
 	/* build for compatibility */
 	vendor_ids_tmp = g_new0 (gchar *, priv->vendor_ids->len + 1);
@@ -1254,13 +1267,17 @@ gboolean
 fwupd_device_has_protocol (FwupdDevice *device, const gchar *protocol)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	const gchar *protocol_tmp;
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), FALSE);
 	g_return_val_if_fail (protocol != NULL, FALSE);
 
+	/* not interned means no device has it */
+	protocol_tmp = fwupd_intern_lookup (protocol);
+	if (protocol_tmp == NULL)
+		return FALSE;
 	for (guint i = 0; i < priv->protocols->len; i++) {
-		const gchar *protocol_tmp = g_ptr_array_index (priv->protocols, i);
-		if (g_strcmp0 (protocol, protocol_tmp) == 0)
+		if (g_ptr_array_index (priv->protocols, i) == protocol_tmp)
 			return TRUE;
 	}
 	return FALSE;
@@ -1286,7 +1303,7 @@ fwupd_device_add_protocol (FwupdDevice *device, const gchar *protocol)
 
 	if (fwupd_device_has_protocol (device, protocol))
 		return;
-	g_ptr_array_add (priv->protocols, g_strdup (protocol));
+	g_ptr_array_add (priv->protocols, (gpointer) fwupd_intern_ref (protocol));
 
 	/* build for compatibility */
 	protocols_tmp = g_new0 (gchar *, priv->protocols->len + 1);
@@ -1563,6 +1580,27 @@ fwupd_device_incorporate (FwupdDevice *self, FwupdDevice *donor)
 	}
 }
 
+/* releases are only parsed when first used, as most clients never look */
+static void
+fwupd_device_ensure_releases (FwupdDevice *device)
+{
+	FwupdDevicePrivate *priv = GET_PRIVATE (device);
+	GVariantIter iter;
+	GVariant *child;
+	g_autoptr(GVariant) value = NULL;
+
+	if (priv->releases_variant == NULL)
+		return;
+	value = g_steal_pointer (&priv->releases_variant);
+	g_variant_iter_init (&iter, value);
+	while ((child = g_variant_iter_next_value (&iter))) {
+		g_autoptr(FwupdRelease) release = fwupd_release_from_variant (child);
+		if (release != NULL)
+			g_ptr_array_add (priv->releases, g_object_ref (release));
+		g_variant_unref (child);
+	}
+}
+
 /**
  * fwupd_device_to_variant_full:
  * @device: A #FwupdDevice
@@ -1774,7 +1812,11 @@ fwupd_device_to_variant_full (FwupdDevice *device, FwupdDeviceFlags flags)
 	}
 
 	/* create an array with all the metadata in */
-	if (priv->releases->len > 0) {
+	if (priv->releases_variant != NULL) {
+		g_variant_builder_add (&builder, "{sv}",
+				       FWUPD_RESULT_KEY_RELEASE,
+				       priv->releases_variant);
+	} else if (priv->releases->len > 0) {
 		g_autofree GVariant **children = NULL;
 		children = g_new0 (GVariant *, priv->releases->len);
 		for (guint i = 0; i < priv->releases->len; i++) {
@@ -1810,15 +1852,11 @@ static void
 fwupd_device_from_key_value (FwupdDevice *device, const gchar *key, GVariant *value)
 {
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_RELEASE) == 0) {
-		GVariantIter iter;
-		GVariant *child;
-		g_variant_iter_init (&iter, value);
-		while ((child = g_variant_iter_next_value (&iter))) {
-			g_autoptr(FwupdRelease) release = fwupd_release_from_variant (child);
-			if (release != NULL)
-				fwupd_device_add_release (device, release);
-			g_variant_unref (child);
-		}
+		FwupdDevicePrivate *priv = GET_PRIVATE (device);
+		fwupd_device_ensure_releases (device);
+		priv->releases_variant = g_variant_ref (value);
+		if (priv->releases->len > 0)
+			fwupd_device_ensure_releases (device);
 		return;
 	}
 	if (g_strcmp0 (key, FWUPD_RESULT_KEY_DEVICE_ID) == 0) {
@@ -2271,6 +2309,7 @@ fwupd_device_get_release_default (FwupdDevice *device)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+	fwupd_device_ensure_releases (device);
 	if (priv->releases->len == 0)
 		return NULL;
 	return FWUPD_RELEASE (g_ptr_array_index (priv->releases, 0));
@@ -2291,6 +2330,7 @@ fwupd_device_get_releases (FwupdDevice *device)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
+	fwupd_device_ensure_releases (device);
 	return priv->releases;
 }
 
@@ -2308,6 +2348,7 @@ fwupd_device_add_release (FwupdDevice *device, FwupdRelease *release)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
+	fwupd_device_ensure_releases (device);
 	g_ptr_array_add (priv->releases, g_object_ref (release));
 }
 /**
@@ -2391,6 +2432,8 @@ fwupd_device_to_json (FwupdDevice *device, JsonBuilder *builder)
 	g_return_if_fail (FWUPD_IS_DEVICE (device));
 	g_return_if_fail (builder != NULL);
 
+	fwupd_device_ensure_releases (device);
+
 	fwupd_device_json_add_string (builder, FWUPD_RESULT_KEY_NAME, priv->name);
 	fwupd_device_json_add_string (builder, FWUPD_RESULT_KEY_DEVICE_ID, priv->id);
 	fwupd_device_json_add_string (builder, FWUPD_RESULT_KEY_PARENT_DEVICE_ID,
@@ -2522,6 +2565,7 @@ fwupd_device_to_string (FwupdDevice *device)
 
 	g_return_val_if_fail (FWUPD_IS_DEVICE (device), NULL);
 
+	fwupd_device_ensure_releases (device);
 	str = g_string_new ("");
 	if (priv->name != NULL)
 		g_string_append_printf (str, "%s\n", priv->name);
@@ -2745,12 +2789,12 @@ static void
 fwupd_device_init (FwupdDevice *device)
 {
 	FwupdDevicePrivate *priv = GET_PRIVATE (device);
-	priv->guids = g_ptr_array_new_with_free_func (g_free);
-	priv->instance_ids = g_ptr_array_new_with_free_func (g_free);
+	priv->guids = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_intern_unref);
+	priv->instance_ids = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_intern_unref);
 	priv->icons = g_ptr_array_new_with_free_func (g_free);
 	priv->checksums = g_ptr_array_new_with_free_func (g_free);
-	priv->vendor_ids = g_ptr_array_new_with_free_func (g_free);
-	priv->protocols = g_ptr_array_new_with_free_func (g_free);
+	priv->vendor_ids = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_intern_unref);
+	priv->protocols = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_intern_unref);
 	priv->children = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 }
@@ -2795,6 +2839,8 @@ fwupd_device_finalize (GObject *object)
 	g_ptr_array_unref (priv->checksums);
 	g_ptr_array_unref (priv->children);
 	g_ptr_array_unref (priv->releases);
+	if (priv->releases_variant != NULL)
+		g_variant_unref (priv->releases_variant);
 
 	G_OBJECT_CLASS (fwupd_device_parent_class)->finalize (object);
 }
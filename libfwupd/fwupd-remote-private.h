@@ -23,6 +23,7 @@ void		 fwupd_remote_set_mtime			(FwupdRemote	*self,
 							 guint64	 mtime);
 gchar		**fwupd_remote_get_order_after		(FwupdRemote	*self);
 gchar		**fwupd_remote_get_order_before		(FwupdRemote	*self);
+gchar		**fwupd_remote_get_peer_uris		(FwupdRemote	*self);
 
 void		 fwupd_remote_set_remotes_dir		(FwupdRemote	*self,
 							 const gchar	*directory);
@@ -51,6 +51,7 @@ typedef struct {
 	guint64			 mtime;
 	gchar			**order_after;
 	gchar			**order_before;
+	gchar			**peer_uris;
 	gchar			*remotes_dir;
 	gboolean		 automatic_reports;
 	gboolean		 automatic_security_reports;
@@ -207,6 +208,18 @@ fwupd_remote_get_suffix_for_keyring_kind (FwupdKeyringKind keyring_kind)
 	return NULL;
 }
 
+/* the cached copy keeps the compression format so it can be decompressed */
+static const gchar *
+fwupd_remote_get_suffix_for_metadata_uri (const gchar *metadata_uri)
+{
+	const gchar *suffixes[] = { ".xml.xz", ".xml.zst", NULL };
+	for (guint i = 0; suffixes[i] != NULL; i++) {
+		if (g_str_has_suffix (metadata_uri, suffixes[i]))
+			return suffixes[i];
+	}
+	return ".xml.gz";
+}
+
 static gchar *
 fwupd_remote_build_uri (FwupdRemote *self, const gchar *url, GError **error)
 {
@@ -416,6 +429,7 @@ fwupd_remote_load_from_filename (FwupdRemote *self,
 	g_autofree gchar *metadata_uri = NULL;
 	g_autofree gchar *order_after = NULL;
 	g_autofree gchar *order_before = NULL;
+	g_autofree gchar *peer_uris = NULL;
 	g_autofree gchar *report_uri = NULL;
 	g_autofree gchar *security_report_uri = NULL;
 	g_autoptr(GKeyFile) kf = NULL;
@@ -498,6 +512,7 @@ fwupd_remote_load_from_filename (FwupdRemote *self,
 
 	/* DOWNLOAD-type remotes */
 	if (priv->kind == FWUPD_REMOTE_KIND_DOWNLOAD) {
+		g_autofree gchar *basename = NULL;
 		g_autofree gchar *filename_cache = NULL;
 		g_autofree gchar *username = NULL;
 		g_autofree gchar *password = NULL;
@@ -531,9 +546,11 @@ fwupd_remote_load_from_filename (FwupdRemote *self,
 			return FALSE;
 		}
 		/* set cache to /var/lib... */
+		basename = g_strdup_printf ("metadata%s",
+					    fwupd_remote_get_suffix_for_metadata_uri (metadata_uri));
 		filename_cache = g_build_filename (priv->remotes_dir,
 						   priv->id,
-						   "metadata.xml.gz",
+						   basename,
 						   NULL);
 		fwupd_remote_set_filename_cache (self, filename_cache);
 	}
@@ -578,6 +595,11 @@ fwupd_remote_load_from_filename (FwupdRemote *self,
 		}
 	}
 
+	/* machines on the local network sharing their firmware cache */
+	peer_uris = g_key_file_get_string (kf, group, "PeerURIs", NULL);
+	if (peer_uris != NULL)
+		priv->peer_uris = g_strsplit_set (peer_uris, ",;", -1);
+
 	/* dep logic */
 	order_before = g_key_file_get_string (kf, group, "OrderBefore", NULL);
 	if (order_before != NULL)
@@ -609,6 +631,24 @@ fwupd_remote_get_order_after (FwupdRemote *self)
 	return priv->order_after;
 }
 
+/**
+ * fwupd_remote_get_peer_uris:
+ * @self: A #FwupdRemote
+ *
+ * Gets the list of peers that serve firmware by checksum.
+ *
+ * Returns: (transfer none): an array, or %NULL for unset
+ *
+ * Since: 1.5.8
+ **/
+gchar **
+fwupd_remote_get_peer_uris (FwupdRemote *self)
+{
+	FwupdRemotePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FWUPD_IS_REMOTE (self), NULL);
+	return priv->peer_uris;
+}
+
 /**
  * fwupd_remote_get_order_before:
  * @self: A #FwupdRemote
@@ -1289,6 +1329,9 @@ fwupd_remote_set_from_variant_iter (FwupdRemote *self, GVariantIter *iter)
 			priv->mtime = g_variant_get_uint64 (value);
 		} else if (g_strcmp0 (key, "FirmwareBaseUri") == 0) {
 			fwupd_remote_set_firmware_base_uri (self, g_variant_get_string (value, NULL));
+		} else if (g_strcmp0 (key, "PeerUris") == 0) {
+			g_strfreev (priv->peer_uris);
+			priv->peer_uris = g_variant_dup_strv (value, NULL);
 		} else if (g_strcmp0 (key, "AutomaticReports") == 0) {
 			priv->automatic_reports = g_variant_get_boolean (value);
 		} else if (g_strcmp0 (key, "AutomaticSecurityReports") == 0) {
@@ -1357,6 +1400,10 @@ fwupd_remote_to_variant (FwupdRemote *self)
 		g_variant_builder_add (&builder, "{sv}", "FirmwareBaseUri",
 				       g_variant_new_string (priv->firmware_base_uri));
 	}
+	if (priv->peer_uris != NULL) {
+		g_variant_builder_add (&builder, "{sv}", "PeerUris",
+				       g_variant_new_strv ((const gchar * const *) priv->peer_uris, -1));
+	}
 	if (priv->priority != 0) {
 		g_variant_builder_add (&builder, "{sv}", "Priority",
 				       g_variant_new_int32 (priv->priority));
@@ -1549,6 +1596,7 @@ fwupd_remote_finalize (GObject *obj)
 	g_free (priv->filename_source);
 	g_strfreev (priv->order_after);
 	g_strfreev (priv->order_before);
+	g_strfreev (priv->peer_uris);
 
 	G_OBJECT_CLASS (fwupd_remote_parent_class)->finalize (obj);
 }
@@ -14,7 +14,7 @@
 
 #include "fwupd-client.h"
 #include "fwupd-client-sync.h"
-#include "fwupd-common.h"
+#include "fwupd-common-private.h"
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
 #include "fwupd-device-private.h"
@@ -204,9 +204,12 @@ static void
 fwupd_remote_baseuri_func (void)
 {
 	gboolean ret;
+	gchar **peer_uris;
 	g_autofree gchar *firmware_uri = NULL;
 	g_autofree gchar *fn = NULL;
 	g_autoptr(FwupdRemote) remote = NULL;
+	g_autoptr(FwupdRemote) remote2 = NULL;
+	g_autoptr(GVariant) data = NULL;
 	g_autofree gchar *directory = NULL;
 	g_autoptr(GError) error = NULL;
 
@@ -233,6 +236,19 @@ fwupd_remote_baseuri_func (void)
 	firmware_uri = fwupd_remote_build_firmware_uri (remote, "http://bbc.co.uk/firmware.cab", &error);
 	g_assert_no_error (error);
 	g_assert_cmpstr (firmware_uri, ==, "https://my.fancy.cdn/firmware.cab");
+
+	/* peers are sent to the client */
+	peer_uris = fwupd_remote_get_peer_uris (remote);
+	g_assert_nonnull (peer_uris);
+	g_assert_cmpint (g_strv_length (peer_uris), ==, 2);
+	g_assert_cmpstr (peer_uris[0], ==, "http://192.168.1.10:8080/");
+	g_assert_cmpstr (peer_uris[1], ==, "http://cache.local/fwupd");
+	data = fwupd_remote_to_variant (remote);
+	remote2 = fwupd_remote_from_variant (data);
+	g_assert_nonnull (remote2);
+	peer_uris = fwupd_remote_get_peer_uris (remote2);
+	g_assert_nonnull (peer_uris);
+	g_assert_cmpint (g_strv_length (peer_uris), ==, 2);
 }
 
 /* verify we used the metadata path for firmware */
@@ -318,10 +334,15 @@ fwupd_device_func (void)
 	gboolean ret;
 	g_autofree gchar *data = NULL;
 	g_autofree gchar *str = NULL;
+	FwupdRelease *rel2;
 	g_autoptr(FwupdDevice) dev = NULL;
+	g_autoptr(FwupdDevice) dev2 = NULL;
+	g_autoptr(FwupdDevice) dev3 = NULL;
 	g_autoptr(FwupdRelease) rel = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GString) str_ascii = NULL;
+	g_autoptr(GVariant) variant = NULL;
+	g_autoptr(GVariant) variant2 = NULL;
 	g_autoptr(JsonBuilder) builder = NULL;
 	g_autoptr(JsonGenerator) json_generator = NULL;
 	g_autoptr(JsonNode) json_root = NULL;
@@ -445,6 +466,19 @@ fwupd_device_func (void)
 		"}", &error);
 	g_assert_no_error (error);
 	g_assert (ret);
+
+	/* releases are parsed when used, and can be exported again before that */
+	variant = fwupd_device_to_variant (dev);
+	dev2 = fwupd_device_from_variant (variant);
+	g_assert_nonnull (dev2);
+	variant2 = fwupd_device_to_variant (dev2);
+	dev3 = fwupd_device_from_variant (variant2);
+	g_assert_nonnull (dev3);
+	g_assert_cmpstr (fwupd_device_get_id (dev3), ==, "USB:foo");
+	g_assert_cmpint (fwupd_device_get_releases (dev3)->len, ==, 1);
+	rel2 = fwupd_device_get_release_default (dev3);
+	g_assert_nonnull (rel2);
+	g_assert_cmpstr (fwupd_release_get_version (rel2), ==, "1.2.3");
 }
 
 static void
@@ -622,6 +656,7 @@ fwupd_common_guid_func (void)
 	g_autofree gchar *guid_be = NULL;
 	g_autofree gchar *guid_me = NULL;
 	fwupd_guid_t buf = { 0x0 };
+	gchar str[FWUPD_GUID_STRING_SIZE] = { '\0' };
 	gboolean ret;
 	g_autoptr(GError) error = NULL;
 
@@ -664,6 +699,43 @@ fwupd_common_guid_func (void)
 	/* check failure */
 	g_assert_false (fwupd_guid_from_string ("001122334455-6677-8899-aabbccddeeff", NULL, 0, NULL));
 	g_assert_false (fwupd_guid_from_string ("0112233-4455-6677-8899-aabbccddeeff", NULL, 0, NULL));
+	g_assert_false (fwupd_guid_from_string ("0011223-34455-6677-8899-aabbccddeeff", NULL, 0, NULL));
+
+	/* no allocation */
+	fwupd_guid_to_string_buf ((const fwupd_guid_t *) &buf, FWUPD_GUID_FLAG_MIXED_ENDIAN, str);
+	g_assert_cmpstr (str, ==, "00112233-4455-6677-8899-aabbccddeeff");
+	g_assert_true (fwupd_guid_hash_string_buf ("python.org", str));
+	g_assert_cmpstr (str, ==, "886313e1-3b8a-5372-9b90-0c9aee199e5d");
+	g_assert_false (fwupd_guid_hash_string_buf ("", str));
+}
+
+static void
+fwupd_common_intern_func (void)
+{
+	const gchar *str1;
+	const gchar *str2;
+	g_autofree gchar *tmp = g_strdup ("USB\\VID_273F&PID_1004");
+	g_autoptr(FwupdDevice) dev = fwupd_device_new ();
+
+	/* same string gives the same pointer */
+	g_assert_null (fwupd_intern_lookup (tmp));
+	str1 = fwupd_intern_ref (tmp);
+	str2 = fwupd_intern_ref ("USB\\VID_273F&PID_1004");
+	g_assert_true (str1 == str2);
+	g_assert_true (str1 != tmp);
+	g_assert_true (fwupd_intern_lookup (tmp) == str1);
+	fwupd_intern_unref (str2);
+	g_assert_true (fwupd_intern_lookup (tmp) == str1);
+	fwupd_intern_unref (str1);
+	g_assert_null (fwupd_intern_lookup (tmp));
+
+	/* device lookups use the interned copy */
+	fwupd_device_add_instance_id (dev, tmp);
+	g_assert_true (fwupd_device_has_instance_id (dev, "USB\\VID_273F&PID_1004"));
+	g_assert_false (fwupd_device_has_instance_id (dev, "USB\\VID_273F&PID_1005"));
+	g_assert_true (fwupd_intern_lookup (tmp) != NULL);
+	g_clear_object (&dev);
+	g_assert_null (fwupd_intern_lookup (tmp));
 }
 
 int
@@ -680,6 +752,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/common{machine-hash}", fwupd_common_machine_hash_func);
 	g_test_add_func ("/fwupd/common{device-id}", fwupd_common_device_id_func);
 	g_test_add_func ("/fwupd/common{guid}", fwupd_common_guid_func);
+	g_test_add_func ("/fwupd/common{intern}", fwupd_common_intern_func);
 	g_test_add_func ("/fwupd/release", fwupd_release_func);
 	g_test_add_func ("/fwupd/device", fwupd_device_func);
 	g_test_add_func ("/fwupd/remote{download}", fwupd_remote_download_func);
@@ -27,6 +27,9 @@
 struct _FuArchive {
 	GObject			 parent_instance;
 	GHashTable		*entries;
+	GHashTable		*indexes;	/* (nullable): filename:entry index+1 */
+	GBytes			*blob;		/* (nullable): only when lazy */
+	FuArchiveFlags		 flags;
 };
 
 G_DEFINE_TYPE (FuArchive, fu_archive, G_TYPE_OBJECT)
@@ -37,6 +40,10 @@ fu_archive_finalize (GObject *obj)
 	FuArchive *self = FU_ARCHIVE (obj);
 
 	g_hash_table_unref (self->entries);
+	if (self->indexes != NULL)
+		g_hash_table_unref (self->indexes);
+	if (self->blob != NULL)
+		g_bytes_unref (self->blob);
 	G_OBJECT_CLASS (fu_archive_parent_class)->finalize (obj);
 }
 
@@ -54,6 +61,154 @@ fu_archive_init (FuArchive *self)
 					       g_free, (GDestroyNotify) g_bytes_unref);
 }
 
+#ifdef HAVE_LIBARCHIVE
+/* workaround the struct types of libarchive */
+typedef struct archive _archive_read_ctx;
+
+static void
+_archive_read_ctx_free (_archive_read_ctx *arch)
+{
+	archive_read_close (arch);
+	archive_read_free (arch);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(_archive_read_ctx, _archive_read_ctx_free)
+
+static _archive_read_ctx *
+fu_archive_open (GBytes *blob, GError **error)
+{
+	int r;
+	g_autoptr(_archive_read_ctx) arch = NULL;
+
+	/* decompress anything matching either glob */
+	arch = archive_read_new ();
+	if (arch == NULL) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_SUPPORTED,
+				     "libarchive startup failed");
+		return NULL;
+	}
+	archive_read_support_format_all (arch);
+	archive_read_support_filter_all (arch);
+	r = archive_read_open_memory (arch,
+				      (void *) g_bytes_get_data (blob, NULL),
+				      (size_t) g_bytes_get_size (blob));
+	if (r != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "cannot open: %s",
+			     archive_error_string (arch));
+		return NULL;
+	}
+	return g_steal_pointer (&arch);
+}
+
+/* returns %FALSE for error, and sets @entry to %NULL at the end */
+static gboolean
+fu_archive_next_header (_archive_read_ctx *arch,
+			struct archive_entry **entry,
+			GError **error)
+{
+	int r = archive_read_next_header (arch, entry);
+	if (r == ARCHIVE_EOF) {
+		*entry = NULL;
+		return TRUE;
+	}
+	if (r != ARCHIVE_OK) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "cannot read header: %s",
+			     archive_error_string (arch));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gchar *
+fu_archive_entry_key (FuArchive *self, struct archive_entry *entry)
+{
+	const gchar *fn = archive_entry_pathname (entry);
+	if (fn == NULL)
+		return NULL;
+	if (self->flags & FU_ARCHIVE_FLAG_IGNORE_PATH)
+		return g_path_get_basename (fn);
+	return g_strdup (fn);
+}
+
+static gboolean
+fu_archive_entry_check_size (struct archive_entry *entry, GError **error)
+{
+	if (archive_entry_size (entry) > 1024 * 1024 * 1024) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "cannot read huge files");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static GBytes *
+fu_archive_read_data (_archive_read_ctx *arch, struct archive_entry *entry, GError **error)
+{
+	gint64 bufsz;
+	gssize rc;
+	g_autofree guint8 *buf = NULL;
+
+	if (!fu_archive_entry_check_size (entry, error))
+		return NULL;
+	bufsz = archive_entry_size (entry);
+	buf = g_malloc (bufsz);
+	rc = archive_read_data (arch, buf, (gsize) bufsz);
+	if (rc < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "cannot read data: %s",
+			     archive_error_string (arch));
+		return NULL;
+	}
+	if (rc != bufsz) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "read %" G_GSSIZE_FORMAT " of %" G_GINT64_FORMAT,
+			     rc, bufsz);
+		return NULL;
+	}
+	return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
+}
+
+/* decompress just one entry from the index built when loading */
+static GBytes *
+fu_archive_load_entry (FuArchive *self, guint idx, GError **error)
+{
+	g_autoptr(_archive_read_ctx) arch = NULL;
+
+	arch = fu_archive_open (self->blob, error);
+	if (arch == NULL)
+		return NULL;
+	for (guint i = 0; ; i++) {
+		struct archive_entry *entry = NULL;
+		if (!fu_archive_next_header (arch, &entry, error))
+			return NULL;
+		if (entry == NULL)
+			break;
+		if (i == idx)
+			return fu_archive_read_data (arch, entry, error);
+	}
+	g_set_error (error,
+		     G_IO_ERROR,
+		     G_IO_ERROR_FAILED,
+		     "archive changed, no entry %u",
+		     idx);
+	return NULL;
+}
+#endif
+
 /**
  * fu_archive_lookup_by_fn:
  * @self: A #FuArchive
@@ -76,6 +231,18 @@ fu_archive_lookup_by_fn (FuArchive *self, const gchar *fn, GError **error)
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
 	fw = g_hash_table_lookup (self->entries, fn);
+#ifdef HAVE_LIBARCHIVE
+	if (fw == NULL && self->indexes != NULL) {
+		guint idx = GPOINTER_TO_UINT (g_hash_table_lookup (self->indexes, fn));
+		if (idx > 0) {
+			fw = fu_archive_load_entry (self, idx - 1, error);
+			if (fw == NULL)
+				return NULL;
+			g_hash_table_insert (self->entries, g_strdup (fn), fw);
+			return fw;
+		}
+	}
+#endif
 	if (fw == NULL) {
 		g_set_error (error,
 			     G_IO_ERROR,
@@ -95,6 +262,9 @@ fu_archive_lookup_by_fn (FuArchive *self, const gchar *fn, GError **error)
  * Iterates over the archive contents, calling the given function for each
  * of the files found. If any @callback returns %FALSE scanning is aborted.
  *
+ * If the archive was loaded with %FU_ARCHIVE_FLAG_LAZY then each file is
+ * decompressed just before @callback is called and freed afterwards.
+ *
  * Returns: True if no @callback returned FALSE
  *
  * Since: 1.3.4
@@ -112,6 +282,36 @@ fu_archive_iterate (FuArchive *self,
 	g_return_val_if_fail (callback != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+#ifdef HAVE_LIBARCHIVE
+	if (self->indexes != NULL) {
+		g_autoptr(_archive_read_ctx) arch = fu_archive_open (self->blob, error);
+		if (arch == NULL)
+			return FALSE;
+		for (guint i = 0; ; i++) {
+			struct archive_entry *entry = NULL;
+			g_autofree gchar *fn_key = NULL;
+			g_autoptr(GBytes) fw = NULL;
+
+			if (!fu_archive_next_header (arch, &entry, error))
+				return FALSE;
+			if (entry == NULL)
+				break;
+
+			/* only the last entry with each name is visible */
+			fn_key = fu_archive_entry_key (self, entry);
+			if (fn_key == NULL)
+				continue;
+			if (GPOINTER_TO_UINT (g_hash_table_lookup (self->indexes, fn_key)) != i + 1)
+				continue;
+			fw = fu_archive_read_data (arch, entry, error);
+			if (fw == NULL)
+				return FALSE;
+			if (!callback (self, fn_key, fw, user_data, error))
+				return FALSE;
+		}
+		return TRUE;
+	}
+#endif
 	g_hash_table_iter_init (&iter, self->entries);
 	while (g_hash_table_iter_next (&iter, &key, &value)) {
 		if (!callback (self, (const gchar *)key, (GBytes *)value, user_data, error))
@@ -120,108 +320,52 @@ fu_archive_iterate (FuArchive *self,
 	return TRUE;
 }
 
-#ifdef HAVE_LIBARCHIVE
-/* workaround the struct types of libarchive */
-typedef struct archive _archive_read_ctx;
-
-static void
-_archive_read_ctx_free (_archive_read_ctx *arch)
-{
-	archive_read_close (arch);
-	archive_read_free (arch);
-}
-
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(_archive_read_ctx, _archive_read_ctx_free)
-#endif
-
 static gboolean
 fu_archive_load (FuArchive *self, GBytes *blob, FuArchiveFlags flags, GError **error)
 {
 #ifdef HAVE_LIBARCHIVE
-	int r;
 	g_autoptr(_archive_read_ctx) arch = NULL;
 
-	/* decompress anything matching either glob */
-	arch = archive_read_new ();
-	if (arch == NULL) {
-		g_set_error_literal (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_NOT_SUPPORTED,
-				     "libarchive startup failed");
-		return FALSE;
-	}
-	archive_read_support_format_all (arch);
-	archive_read_support_filter_all (arch);
-	r = archive_read_open_memory (arch,
-				      (void *) g_bytes_get_data (blob, NULL),
-				      (size_t) g_bytes_get_size (blob));
-	if (r != 0) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_NOT_SUPPORTED,
-			     "cannot open: %s",
-			     archive_error_string (arch));
+	self->flags = flags;
+	arch = fu_archive_open (blob, error);
+	if (arch == NULL)
 		return FALSE;
+
+	/* only record where each file is, and decompress on demand */
+	if (flags & FU_ARCHIVE_FLAG_LAZY) {
+		self->blob = g_bytes_ref (blob);
+		self->indexes = g_hash_table_new_full (g_str_hash, g_str_equal,
+						       g_free, NULL);
 	}
-	while (TRUE) {
-		const gchar *fn;
-		gint64 bufsz;
-		gssize rc;
-		struct archive_entry *entry;
+	for (guint i = 0; ; i++) {
+		struct archive_entry *entry = NULL;
 		g_autofree gchar *fn_key = NULL;
-		g_autofree guint8 *buf = NULL;
+		GBytes *fw;
 
-		r = archive_read_next_header (arch, &entry);
-		if (r == ARCHIVE_EOF)
-			break;
-		if (r != ARCHIVE_OK) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "cannot read header: %s",
-				     archive_error_string (arch));
+		if (!fu_archive_next_header (arch, &entry, error))
 			return FALSE;
-		}
+		if (entry == NULL)
+			break;
 
 		/* only extract if valid */
-		fn = archive_entry_pathname (entry);
-		if (fn == NULL)
+		fn_key = fu_archive_entry_key (self, entry);
+		if (fn_key == NULL)
+			continue;
+		if (self->indexes != NULL) {
+			if (!fu_archive_entry_check_size (entry, error))
+				return FALSE;
+			g_debug ("indexing %s [%" G_GINT64_FORMAT "]",
+				 fn_key, (gint64) archive_entry_size (entry));
+			g_hash_table_insert (self->indexes,
+					     g_steal_pointer (&fn_key),
+					     GUINT_TO_POINTER (i + 1));
 			continue;
-		bufsz = archive_entry_size (entry);
-		if (bufsz > 1024 * 1024 * 1024) {
-			g_set_error_literal (error,
-					     G_IO_ERROR,
-					     G_IO_ERROR_FAILED,
-					     "cannot read huge files");
-			return FALSE;
-		}
-		buf = g_malloc (bufsz);
-		rc = archive_read_data (arch, buf, (gsize) bufsz);
-		if (rc < 0) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "cannot read data: %s",
-				     archive_error_string (arch));
-			return FALSE;
 		}
-		if (rc != bufsz) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_FAILED,
-				     "read %" G_GSSIZE_FORMAT " of %" G_GINT64_FORMAT,
-				     rc, bufsz);
+		fw = fu_archive_read_data (arch, entry, error);
+		if (fw == NULL)
 			return FALSE;
-		}
-		if (flags & FU_ARCHIVE_FLAG_IGNORE_PATH) {
-			fn_key = g_path_get_basename (fn);
-		} else {
-			fn_key = g_strdup (fn);
-		}
-		g_debug ("adding %s [%" G_GINT64_FORMAT "]", fn_key, bufsz);
-		g_hash_table_insert (self->entries,
-				     g_steal_pointer (&fn_key),
-				     g_bytes_new_take (g_steal_pointer (&buf), bufsz));
+		g_debug ("adding %s [%" G_GSIZE_FORMAT "]", fn_key, g_bytes_get_size (fw));
+		g_hash_table_insert (self->entries, g_steal_pointer (&fn_key), fw);
 	}
 
 	/* success */
@@ -243,6 +387,9 @@ fu_archive_load (FuArchive *self, GBytes *blob, FuArchiveFlags flags, GError **e
  *
  * Parses @data as an archive and decompresses all files to memory blobs.
  *
+ * If %FU_ARCHIVE_FLAG_LAZY is used then only the filenames are read, and
+ * each file is decompressed when it is first looked up.
+ *
  * Returns: a #FuArchive, or %NULL if the archive was invalid in any way.
  *
  * Since: 1.2.2
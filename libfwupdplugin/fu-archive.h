@@ -16,12 +16,14 @@ G_DECLARE_FINAL_TYPE (FuArchive, fu_archive, FU, ARCHIVE, GObject)
  * FuArchiveFlags:
  * @FU_ARCHIVE_FLAG_NONE:		No flags set
  * @FU_ARCHIVE_FLAG_IGNORE_PATH:	Ignore any path component
+ * @FU_ARCHIVE_FLAG_LAZY:		Only decompress files when required
  *
  * The flags to use when loading the archive.
  **/
 typedef enum {
 	FU_ARCHIVE_FLAG_NONE		= 0,
 	FU_ARCHIVE_FLAG_IGNORE_PATH	= 1 << 0,
+	FU_ARCHIVE_FLAG_LAZY		= 1 << 1,
 	/*< private >*/
 	FU_ARCHIVE_FLAG_LAST
 } FuArchiveFlags;
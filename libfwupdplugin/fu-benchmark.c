@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuBenchmark"
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fwupd.h>
+#include <fwupdplugin.h>
+#include <json-glib/json-glib.h>
+
+#include "fu-benchmark-struct.h"
+
+/* all the random data is generated from this so the runs are comparable */
+#define FU_BENCHMARK_SEED			0x66777570
+#define FU_BENCHMARK_BUFSZ			0x100000
+
+typedef struct {
+	guint8			*buf;		/* FU_BENCHMARK_BUFSZ of random data */
+	guint8			*buf_erased;	/* FU_BENCHMARK_BUFSZ of 0xff, with data every 4th page */
+	FuQuirks		*quirks;
+	GBytes			*blob_cab;
+	GBytes			*blob_hex;
+	GBytes			*blob_dmi;
+	volatile guint32	 sink;		/* stop the compiler removing work */
+} FuBenchmarkContext;
+
+typedef gboolean (*FuBenchmarkFunc)	(FuBenchmarkContext	*ctx,
+					 GError			**error);
+
+typedef struct {
+	const gchar		*id;
+	guint			 iterations;	/* per run */
+	gsize			 bytes;		/* processed per iteration, or 0 */
+	FuBenchmarkFunc		 func;
+} FuBenchmarkItem;
+
+static gboolean
+fu_benchmark_crc8 (FuBenchmarkContext *ctx, GError **error)
+{
+	ctx->sink += fu_common_crc8 (ctx->buf, 0x1000);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_crc16 (FuBenchmarkContext *ctx, GError **error)
+{
+	ctx->sink += fu_common_crc16 (ctx->buf, 0x1000);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_crc32 (FuBenchmarkContext *ctx, GError **error)
+{
+	ctx->sink += fu_common_crc32 (ctx->buf, FU_BENCHMARK_BUFSZ);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_chunk_array_new (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autoptr(GPtrArray) chunks = NULL;
+	chunks = fu_chunk_array_new (ctx->buf, FU_BENCHMARK_BUFSZ, 0x0, 0x1000, 0x40);
+	ctx->sink += chunks->len;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_memcpy_safe (FuBenchmarkContext *ctx, GError **error)
+{
+	guint8 dst[0x40];
+	for (gsize i = 0; i < 0x1000; i += sizeof(dst)) {
+		if (!fu_memcpy_safe (dst, sizeof(dst), 0x0,
+				     ctx->buf, FU_BENCHMARK_BUFSZ, i,
+				     sizeof(dst), error))
+			return FALSE;
+		ctx->sink += dst[0];
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_read_uint_safe (FuBenchmarkContext *ctx, GError **error)
+{
+	for (gsize i = 0; i < 0x1000; i += 8) {
+		guint8 val8 = 0;
+		guint16 val16 = 0;
+		guint32 val32 = 0;
+		if (!fu_common_read_uint8_safe (ctx->buf, FU_BENCHMARK_BUFSZ, i,
+						&val8, error))
+			return FALSE;
+		if (!fu_common_read_uint16_safe (ctx->buf, FU_BENCHMARK_BUFSZ, i + 1,
+						 &val16, G_LITTLE_ENDIAN, error))
+			return FALSE;
+		if (!fu_common_read_uint32_safe (ctx->buf, FU_BENCHMARK_BUFSZ, i + 3,
+						 &val32, G_BIG_ENDIAN, error))
+			return FALSE;
+		ctx->sink += val8 + val16 + val32;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_bytes_find_runs (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autoptr(GBytes) blob = g_bytes_new_static (ctx->buf_erased, FU_BENCHMARK_BUFSZ);
+	g_autoptr(GPtrArray) runs = fu_common_bytes_find_runs (blob, 0x1000, 0xff, FALSE);
+	ctx->sink += runs->len;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_struct_parse (FuBenchmarkContext *ctx, GError **error)
+{
+	for (gsize i = 0; i < 0x1000; i += 8) {
+		FuBenchmarkHdr st = { 0x0 };
+		if (!fu_benchmark_hdr_parse (&st, ctx->buf, FU_BENCHMARK_BUFSZ, i, error))
+			return FALSE;
+		ctx->sink += st.val8 + st.val16 + st.val32;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_quirks_lookup_by_id (FuBenchmarkContext *ctx, GError **error)
+{
+	const gchar *group = "DeviceInstanceId=USB\\VID_0BDA&PID_1100";
+	const gchar *keys[] = { "Name", "Children", "Flags", "Unfound", NULL };
+	for (guint i = 0; keys[i] != NULL; i++) {
+		const gchar *tmp = fu_quirks_lookup_by_id (ctx->quirks, group, keys[i]);
+		ctx->sink += tmp != NULL ? 1 : 0;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_guid_from_string (FuBenchmarkContext *ctx, GError **error)
+{
+	fwupd_guid_t guid = { 0x0 };
+	if (!fwupd_guid_from_string ("bb9ec3e2-77b3-53bc-a1f1-b05916715627",
+				     &guid, FWUPD_GUID_FLAG_MIXED_ENDIAN, error))
+		return FALSE;
+	ctx->sink += guid[0];
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_vercmp_full (FuBenchmarkContext *ctx, GError **error)
+{
+	ctx->sink += fu_common_vercmp_full ("1.2.3", "1.2.4", FWUPD_VERSION_FORMAT_TRIPLET);
+	ctx->sink += fu_common_vercmp_full ("0x00000002", "0x2", FWUPD_VERSION_FORMAT_HEX);
+	ctx->sink += fu_common_vercmp_full ("1.2.3~rc1", "1.2.3", FWUPD_VERSION_FORMAT_UNKNOWN);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_ihex_firmware_parse (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autoptr(FuFirmware) firmware = fu_ihex_firmware_new ();
+	return fu_firmware_parse (firmware, ctx->blob_hex, FWUPD_INSTALL_FLAG_NONE, error);
+}
+
+static gboolean
+fu_benchmark_cabinet_parse (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autoptr(FuCabinet) cabinet = fu_cabinet_new ();
+	return fu_cabinet_parse (cabinet, ctx->blob_cab, FU_CABINET_PARSE_FLAG_NONE, error);
+}
+
+static gboolean
+fu_benchmark_smbios_setup_from_data (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autoptr(FuSmbios) smbios = fu_smbios_new ();
+	return fu_firmware_parse (FU_FIRMWARE (smbios), ctx->blob_dmi,
+				  FWUPD_INSTALL_FLAG_NONE, error);
+}
+
+static const FuBenchmarkItem fu_benchmark_items[] = {
+	{ "common-crc8",		10000,	0x1000,			fu_benchmark_crc8 },
+	{ "common-crc16",		10000,	0x1000,			fu_benchmark_crc16 },
+	{ "common-crc32",		100,	FU_BENCHMARK_BUFSZ,	fu_benchmark_crc32 },
+	{ "chunk-array-new",		100,	FU_BENCHMARK_BUFSZ,	fu_benchmark_chunk_array_new },
+	{ "memcpy-safe",		10000,	0x1000,			fu_benchmark_memcpy_safe },
+	{ "common-read-uint-safe",	10000,	0x1000,			fu_benchmark_read_uint_safe },
+	{ "common-bytes-find-runs",	100,	FU_BENCHMARK_BUFSZ,	fu_benchmark_bytes_find_runs },
+	{ "struct-parse",		10000,	0x1000,			fu_benchmark_struct_parse },
+	{ "quirks-lookup-by-id",	100000,	0,			fu_benchmark_quirks_lookup_by_id },
+	{ "common-guid-from-string",	100000,	0,			fu_benchmark_guid_from_string },
+	{ "common-vercmp-full",		100000,	0,			fu_benchmark_vercmp_full },
+	{ "ihex-firmware-parse",	1000,	0,			fu_benchmark_ihex_firmware_parse },
+	{ "cabinet-parse",		100,	0,			fu_benchmark_cabinet_parse },
+	{ "smbios-setup-from-data",	10000,	0,			fu_benchmark_smbios_setup_from_data },
+	{ NULL, 0, 0, NULL }
+};
+
+static gint
+fu_benchmark_sort_cb (gconstpointer a, gconstpointer b)
+{
+	gdouble da = *((const gdouble *) a);
+	gdouble db = *((const gdouble *) b);
+	if (da < db)
+		return -1;
+	if (da > db)
+		return 1;
+	return 0;
+}
+
+static gboolean
+fu_benchmark_run_item (FuBenchmarkContext *ctx,
+		       const FuBenchmarkItem *item,
+		       guint repeat,
+		       JsonBuilder *builder,
+		       GError **error)
+{
+	gdouble ns_min;
+	gdouble ns_median;
+	g_autofree gdouble *results = g_new0 (gdouble, repeat);
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* warm up caches and any lazily-created tables */
+	if (!item->func (ctx, error)) {
+		g_prefix_error (error, "%s: ", item->id);
+		return FALSE;
+	}
+
+	/* each run gets the smallest timer overhead per iteration we can */
+	for (guint j = 0; j < repeat; j++) {
+		g_timer_reset (timer);
+		for (guint i = 0; i < item->iterations; i++) {
+			if (!item->func (ctx, error)) {
+				g_prefix_error (error, "%s: ", item->id);
+				return FALSE;
+			}
+		}
+		results[j] = g_timer_elapsed (timer, NULL) * 1e9 / item->iterations;
+	}
+	qsort (results, repeat, sizeof(gdouble), fu_benchmark_sort_cb);
+	ns_min = results[0];
+	ns_median = results[repeat / 2];
+
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Id");
+	json_builder_add_string_value (builder, item->id);
+	json_builder_set_member_name (builder, "Iterations");
+	json_builder_add_int_value (builder, item->iterations);
+	json_builder_set_member_name (builder, "Repeat");
+	json_builder_add_int_value (builder, repeat);
+	json_builder_set_member_name (builder, "NsPerOpMin");
+	json_builder_add_double_value (builder, ns_min);
+	json_builder_set_member_name (builder, "NsPerOpMedian");
+	json_builder_add_double_value (builder, ns_median);
+	if (item->bytes > 0) {
+		json_builder_set_member_name (builder, "MBPerSec");
+		json_builder_add_double_value (builder, (item->bytes / ns_median) * 1e9 / 0x100000);
+	}
+	json_builder_end_object (builder);
+
+	g_printerr ("%-24s %12.1f ns/op\n", item->id, ns_median);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_context_setup (FuBenchmarkContext *ctx, GError **error)
+{
+	g_autofree gchar *fn_cab = NULL;
+	g_autofree gchar *fn_dmi = NULL;
+	g_autofree gchar *fn_hex = NULL;
+	g_autoptr(GRand) rand = g_rand_new_with_seed (FU_BENCHMARK_SEED);
+
+	ctx->buf = g_malloc (FU_BENCHMARK_BUFSZ);
+	for (guint i = 0; i < FU_BENCHMARK_BUFSZ; i++)
+		ctx->buf[i] = (guint8) g_rand_int (rand);
+	ctx->buf_erased = g_malloc (FU_BENCHMARK_BUFSZ);
+	memset (ctx->buf_erased, 0xff, FU_BENCHMARK_BUFSZ);
+	for (guint i = 0; i < FU_BENCHMARK_BUFSZ; i += 0x4000)
+		ctx->buf_erased[i + 0xfff] = 0x0;
+
+	ctx->quirks = fu_quirks_new ();
+	if (!fu_quirks_load (ctx->quirks, FU_QUIRKS_LOAD_FLAG_NONE, error))
+		return FALSE;
+
+	fn_cab = g_build_filename (TESTDATADIR_DST, "colorhug", "colorhug-als-3.0.2.cab", NULL);
+	ctx->blob_cab = fu_common_get_contents_bytes (fn_cab, error);
+	if (ctx->blob_cab == NULL)
+		return FALSE;
+	fn_hex = g_build_filename (TESTDATADIR_SRC, "firmware.hex", NULL);
+	ctx->blob_hex = fu_common_get_contents_bytes (fn_hex, error);
+	if (ctx->blob_hex == NULL)
+		return FALSE;
+	fn_dmi = g_build_filename (TESTDATADIR_SRC, "dmi", "tables64", "DMI", NULL);
+	ctx->blob_dmi = fu_common_get_contents_bytes (fn_dmi, error);
+	if (ctx->blob_dmi == NULL)
+		return FALSE;
+	return TRUE;
+}
+
+static void
+fu_benchmark_context_free (FuBenchmarkContext *ctx)
+{
+	g_free (ctx->buf);
+	g_free (ctx->buf_erased);
+	if (ctx->quirks != NULL)
+		g_object_unref (ctx->quirks);
+	if (ctx->blob_cab != NULL)
+		g_bytes_unref (ctx->blob_cab);
+	if (ctx->blob_hex != NULL)
+		g_bytes_unref (ctx->blob_hex);
+	if (ctx->blob_dmi != NULL)
+		g_bytes_unref (ctx->blob_dmi);
+	g_free (ctx);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuBenchmarkContext, fu_benchmark_context_free)
+
+int
+main (int argc, char **argv)
+{
+	gint repeat = 5;
+	g_autofree gchar *filter = NULL;
+	g_autofree gchar *output = NULL;
+	g_autofree gchar *data = NULL;
+	g_autoptr(FuBenchmarkContext) ctx = g_new0 (FuBenchmarkContext, 1);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = g_option_context_new (NULL);
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+	const GOptionEntry options[] = {
+		{ "repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+			"Number of runs of each benchmark", NULL },
+		{ "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+			"Only run benchmarks with IDs containing this string", NULL },
+		{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+			"Write the JSON results to a file rather than stdout", NULL },
+		{ NULL}
+	};
+
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (repeat < 1) {
+		g_printerr ("Invalid repeat count %i\n", repeat);
+		return EXIT_FAILURE;
+	}
+
+	/* use the same test data as the self tests */
+	g_setenv ("FWUPD_DATADIR", TESTDATADIR_SRC, TRUE);
+	g_setenv ("FWUPD_SYSCONFDIR", TESTDATADIR_SRC, TRUE);
+	if (!fu_benchmark_context_setup (ctx, &error)) {
+		g_printerr ("Failed to load test data: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Version");
+	json_builder_add_string_value (builder, PACKAGE_VERSION);
+	json_builder_set_member_name (builder, "Benchmarks");
+	json_builder_begin_array (builder);
+	for (guint i = 0; fu_benchmark_items[i].id != NULL; i++) {
+		const FuBenchmarkItem *item = &fu_benchmark_items[i];
+		if (filter != NULL && g_strstr_len (item->id, -1, filter) == NULL)
+			continue;
+		if (!fu_benchmark_run_item (ctx, item, repeat, builder, &error)) {
+			g_printerr ("Failed to run benchmark: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+
+	/* export as a string */
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	if (output != NULL) {
+		if (!g_file_set_contents (output, data, -1, &error)) {
+			g_printerr ("Failed to save results: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+	g_print ("%s\n", data);
+	return EXIT_SUCCESS;
+}
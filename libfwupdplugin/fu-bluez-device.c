@@ -9,6 +9,12 @@
 #include "config.h"
 
 #include <string.h>
+#ifdef HAVE_GIO_UNIX
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <gio/gunixfdlist.h>
+#endif
 
 #include "fu-bluez-device.h"
 #include "fu-common.h"
@@ -39,6 +45,10 @@ typedef struct {
 	gchar			*path;
 	gulong			 signal_id;
 	GDBusProxy		*proxy;
+	gint			 write_fd;	/* from AcquireWrite, or -1 */
+	guint16			 write_mtu;
+	gint			 notify_fd;	/* from AcquireNotify, or -1 */
+	guint16			 notify_mtu;
 } FuBluezDeviceUuidHelper;
 
 enum {
@@ -59,9 +69,28 @@ G_DEFINE_TYPE_WITH_PRIVATE (FuBluezDevice, fu_bluez_device, FU_TYPE_DEVICE)
 
 #define GET_PRIVATE(o) (fu_bluez_device_get_instance_private (o))
 
+static void
+fu_bluez_uuid_release (FuBluezDeviceUuidHelper *uuid_helper)
+{
+#ifdef HAVE_GIO_UNIX
+	/* closing the fd releases the lock in BlueZ */
+	if (uuid_helper->write_fd >= 0) {
+		close (uuid_helper->write_fd);
+		uuid_helper->write_fd = -1;
+	}
+	if (uuid_helper->notify_fd >= 0) {
+		close (uuid_helper->notify_fd);
+		uuid_helper->notify_fd = -1;
+	}
+#endif
+	uuid_helper->write_mtu = 0;
+	uuid_helper->notify_mtu = 0;
+}
+
 static void
 fu_bluez_uuid_free (FuBluezDeviceUuidHelper *uuid_helper)
 {
+	fu_bluez_uuid_release (uuid_helper);
 	if (uuid_helper->path != NULL)
 		g_free (uuid_helper->path);
 	if (uuid_helper->proxy != NULL)
@@ -156,6 +185,8 @@ fu_bluez_device_add_uuid_path (FuBluezDevice *self, const gchar *uuid, const gch
 	uuid_helper->self = g_object_ref (self);
 	uuid_helper->uuid = g_strdup (uuid);
 	uuid_helper->path = g_strdup (path);
+	uuid_helper->write_fd = -1;
+	uuid_helper->notify_fd = -1;
 	g_hash_table_insert (priv->uuids, g_strdup (uuid), uuid_helper);
 }
 
@@ -219,6 +250,14 @@ fu_bluez_device_to_string (FuDevice *device, guint idt, GString *str)
 			fu_common_string_append_kv (str, idt + 1,
 						    (const gchar *) key,
 						    uuid_helper->path);
+			if (uuid_helper->write_mtu > 0) {
+				fu_common_string_append_kx (str, idt + 2, "WriteMtu",
+							    uuid_helper->write_mtu);
+			}
+			if (uuid_helper->notify_mtu > 0) {
+				fu_common_string_append_kx (str, idt + 2, "NotifyMtu",
+							    uuid_helper->notify_mtu);
+			}
 		}
 	}
 }
@@ -577,6 +616,353 @@ fu_bluez_device_notify_stop (FuBluezDevice *self, const gchar *uuid, GError **er
 	return TRUE;
 }
 
+/*
+ * Calls AcquireWrite or AcquireNotify, which return a socket and the
+ * negotiated MTU. While the socket is open the D-Bus methods for the
+ * characteristic are locked by BlueZ.
+ */
+static gboolean
+fu_bluez_device_acquire_fd (FuBluezDeviceUuidHelper *uuid_helper,
+			    const gchar *method,
+			    gint *fd,
+			    guint16 *mtu,
+			    GError **error)
+{
+#ifdef HAVE_GIO_UNIX
+	gint idx = -1;
+	g_autoptr(GUnixFDList) fd_list = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariantBuilder) builder = NULL;
+
+	builder = g_variant_builder_new (G_VARIANT_TYPE ("a{sv}"));
+	val = g_dbus_proxy_call_with_unix_fd_list_sync (uuid_helper->proxy,
+							method,
+							g_variant_new ("(a{sv})", builder),
+							G_DBUS_CALL_FLAGS_NONE,
+							-1, NULL, &fd_list,
+							NULL, error);
+	if (val == NULL) {
+		g_prefix_error (error, "Failed to call %s: ", method);
+		return FALSE;
+	}
+	g_variant_get (val, "(hq)", &idx, mtu);
+	if (fd_list == NULL) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "%s returned no fd", method);
+		return FALSE;
+	}
+	*fd = g_unix_fd_list_get (fd_list, idx, error);
+	if (*fd < 0)
+		return FALSE;
+	if (*mtu == 0) {
+		close (*fd);
+		*fd = -1;
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "%s returned MTU of zero", method);
+		return FALSE;
+	}
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "Not supported as <gio/gunixfdlist.h> is unavailable");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_bluez_device_write_acquire:
+ * @self: A #FuBluezDevice
+ * @uuid: The UUID, e.g. `00cde35c-7062-11eb-9439-0242ac130002`
+ * @mtu: (out) (optional): the largest write that can be sent in one packet
+ * @error: A #GError, or %NULL
+ *
+ * Acquires a socket for writing to a UUID without response (AcquireWrite
+ * method). This only works for characteristics with the write-without-response
+ * flag set, and is done automatically by fu_bluez_device_write_command().
+ *
+ * Once acquired, fu_bluez_device_write() will fail until the device is closed.
+ *
+ * Returns: %TRUE if the socket was acquired.
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_bluez_device_write_acquire (FuBluezDevice *self,
+			       const gchar *uuid,
+			       guint16 *mtu,
+			       GError **error)
+{
+	FuBluezDeviceUuidHelper *uuid_helper;
+
+	g_return_val_if_fail (FU_IS_BLUEZ_DEVICE (self), FALSE);
+	g_return_val_if_fail (uuid != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	uuid_helper = fu_bluez_device_get_uuid_helper (self, uuid, error);
+	if (uuid_helper == NULL)
+		return FALSE;
+	if (uuid_helper->write_fd < 0) {
+		if (!fu_bluez_device_ensure_uuid_helper_proxy (uuid_helper, error))
+			return FALSE;
+		if (!fu_bluez_device_acquire_fd (uuid_helper, "AcquireWrite",
+						 &uuid_helper->write_fd,
+						 &uuid_helper->write_mtu,
+						 error))
+			return FALSE;
+		g_debug ("acquired write for %s with MTU %u",
+			 uuid, uuid_helper->write_mtu);
+	}
+	if (mtu != NULL)
+		*mtu = uuid_helper->write_mtu;
+	return TRUE;
+}
+
+#ifdef HAVE_GIO_UNIX
+static gboolean
+fu_bluez_device_poll_fd (gint fd, gshort events, GError **error)
+{
+	struct pollfd fds = { .fd = fd, .events = events };
+	gint rc;
+
+	do {
+		rc = poll (&fds, 1, DEFAULT_PROXY_TIMEOUT);
+	} while (rc < 0 && errno == EINTR);
+	if (rc < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to poll: %s", strerror (errno));
+		return FALSE;
+	}
+	if (rc == 0) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_TIMED_OUT,
+				     "timed out waiting for socket");
+		return FALSE;
+	}
+	if ((fds.revents & events) == 0) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_CLOSED,
+				     "socket was closed");
+		return FALSE;
+	}
+	return TRUE;
+}
+#endif
+
+/**
+ * fu_bluez_device_write_command:
+ * @self: A #FuBluezDevice
+ * @uuid: The UUID, e.g. `00cde35c-7062-11eb-9439-0242ac130002`
+ * @buf: data to write
+ * @error: A #GError, or %NULL
+ *
+ * Writes to a UUID on the device without waiting for a response, using the
+ * socket from fu_bluez_device_write_acquire(). Data larger than the MTU is
+ * sent as multiple packets.
+ *
+ * Packets are queued by the kernel so consecutive writes do not wait for a
+ * D-Bus round trip; this only blocks when the queue is full.
+ *
+ * Returns: %TRUE if all the data was queued
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_bluez_device_write_command (FuBluezDevice *self,
+			       const gchar *uuid,
+			       GByteArray *buf,
+			       GError **error)
+{
+#ifdef HAVE_GIO_UNIX
+	FuBluezDeviceUuidHelper *uuid_helper;
+
+	g_return_val_if_fail (FU_IS_BLUEZ_DEVICE (self), FALSE);
+	g_return_val_if_fail (uuid != NULL, FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_bluez_device_write_acquire (self, uuid, NULL, error))
+		return FALSE;
+	uuid_helper = fu_bluez_device_get_uuid_helper (self, uuid, error);
+	if (uuid_helper == NULL)
+		return FALSE;
+	for (gsize i = 0; i < buf->len;) {
+		gsize sz = MIN (uuid_helper->write_mtu, buf->len - i);
+		gssize wrote = write (uuid_helper->write_fd, buf->data + i, sz);
+		if (wrote < 0 && errno == EINTR)
+			continue;
+		if (wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (!fu_bluez_device_poll_fd (uuid_helper->write_fd, POLLOUT, error)) {
+				g_prefix_error (error, "failed to write %s: ", uuid);
+				return FALSE;
+			}
+			continue;
+		}
+		if (wrote < 0) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errno),
+				     "failed to write %s: %s",
+				     uuid, strerror (errno));
+			return FALSE;
+		}
+		if ((gsize) wrote != sz) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_PARTIAL_INPUT,
+				     "failed to write %s: wrote 0x%x of 0x%x",
+				     uuid, (guint) wrote, (guint) sz);
+			return FALSE;
+		}
+		i += sz;
+	}
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "Not supported as <gio/gunixfdlist.h> is unavailable");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_bluez_device_notify_acquire:
+ * @self: A #FuBluezDevice
+ * @uuid: The UUID, e.g. `00cde35c-7062-11eb-9439-0242ac130002`
+ * @mtu: (out) (optional): the largest notification that can be received
+ * @error: A #GError, or %NULL
+ *
+ * Enables notifications for a UUID using a socket (AcquireNotify method)
+ * rather than PropertiesChanged signals. Use fu_bluez_device_notify_read()
+ * to receive each notification.
+ *
+ * Returns: %TRUE if the socket was acquired.
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_bluez_device_notify_acquire (FuBluezDevice *self,
+				const gchar *uuid,
+				guint16 *mtu,
+				GError **error)
+{
+	FuBluezDeviceUuidHelper *uuid_helper;
+
+	g_return_val_if_fail (FU_IS_BLUEZ_DEVICE (self), FALSE);
+	g_return_val_if_fail (uuid != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	uuid_helper = fu_bluez_device_get_uuid_helper (self, uuid, error);
+	if (uuid_helper == NULL)
+		return FALSE;
+	if (uuid_helper->notify_fd < 0) {
+		if (!fu_bluez_device_ensure_uuid_helper_proxy (uuid_helper, error))
+			return FALSE;
+		if (!fu_bluez_device_acquire_fd (uuid_helper, "AcquireNotify",
+						 &uuid_helper->notify_fd,
+						 &uuid_helper->notify_mtu,
+						 error))
+			return FALSE;
+		g_debug ("acquired notify for %s with MTU %u",
+			 uuid, uuid_helper->notify_mtu);
+	}
+	if (mtu != NULL)
+		*mtu = uuid_helper->notify_mtu;
+	return TRUE;
+}
+
+/**
+ * fu_bluez_device_notify_read:
+ * @self: A #FuBluezDevice
+ * @uuid: The UUID, e.g. `00cde35c-7062-11eb-9439-0242ac130002`
+ * @error: A #GError, or %NULL
+ *
+ * Waits for the next notification from a UUID acquired using
+ * fu_bluez_device_notify_acquire().
+ *
+ * Returns: (transfer full): data, or %NULL for error
+ *
+ * Since: 1.5.8
+ **/
+GByteArray *
+fu_bluez_device_notify_read (FuBluezDevice *self, const gchar *uuid, GError **error)
+{
+#ifdef HAVE_GIO_UNIX
+	FuBluezDeviceUuidHelper *uuid_helper;
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+
+	g_return_val_if_fail (FU_IS_BLUEZ_DEVICE (self), NULL);
+	g_return_val_if_fail (uuid != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	uuid_helper = fu_bluez_device_get_uuid_helper (self, uuid, error);
+	if (uuid_helper == NULL)
+		return NULL;
+	if (uuid_helper->notify_fd < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_INITIALIZED,
+			     "notify not acquired for %s", uuid);
+		return NULL;
+	}
+	g_byte_array_set_size (buf, uuid_helper->notify_mtu);
+	for (;;) {
+		gssize len = read (uuid_helper->notify_fd, buf->data, buf->len);
+		if (len >= 0) {
+			g_byte_array_set_size (buf, len);
+			break;
+		}
+		if (errno == EINTR)
+			continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			if (!fu_bluez_device_poll_fd (uuid_helper->notify_fd, POLLIN, error)) {
+				g_prefix_error (error, "failed to read %s: ", uuid);
+				return NULL;
+			}
+			continue;
+		}
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to read %s: %s",
+			     uuid, strerror (errno));
+		return NULL;
+	}
+	return g_steal_pointer (&buf);
+#else
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "Not supported as <gio/gunixfdlist.h> is unavailable");
+	return NULL;
+#endif
+}
+
+static gboolean
+fu_bluez_device_close (FuDevice *device, GError **error)
+{
+	FuBluezDevice *self = FU_BLUEZ_DEVICE (device);
+	FuBluezDevicePrivate *priv = GET_PRIVATE (self);
+	GHashTableIter iter;
+	gpointer value;
+
+	/* give back any sockets so the D-Bus methods work again */
+	g_hash_table_iter_init (&iter, priv->uuids);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		fu_bluez_uuid_release ((FuBluezDeviceUuidHelper *) value);
+	return TRUE;
+}
+
 static void
 fu_bluez_device_incorporate (FuDevice *self, FuDevice *donor)
 {
@@ -672,6 +1058,7 @@ fu_bluez_device_class_init (FuBluezDeviceClass *klass)
 	object_class->finalize = fu_bluez_device_finalize;
 	device_class->probe = fu_bluez_device_probe;
 	device_class->setup = fu_bluez_device_setup;
+	device_class->close = fu_bluez_device_close;
 	device_class->to_string = fu_bluez_device_to_string;
 	device_class->incorporate = fu_bluez_device_incorporate;
 
@@ -33,3 +33,18 @@ gboolean		 fu_bluez_device_notify_start	(FuBluezDevice	*self,
 gboolean		 fu_bluez_device_notify_stop	(FuBluezDevice	*self,
 							 const gchar	*uuid,
 							 GError		**error);
+gboolean		 fu_bluez_device_write_acquire	(FuBluezDevice	*self,
+							 const gchar	*uuid,
+							 guint16	*mtu,
+							 GError		**error);
+gboolean		 fu_bluez_device_write_command	(FuBluezDevice	*self,
+							 const gchar	*uuid,
+							 GByteArray	*buf,
+							 GError		**error);
+gboolean		 fu_bluez_device_notify_acquire	(FuBluezDevice	*self,
+							 const gchar	*uuid,
+							 guint16	*mtu,
+							 GError		**error);
+GByteArray		*fu_bluez_device_notify_read	(FuBluezDevice	*self,
+							 const gchar	*uuid,
+							 GError		**error);
@@ -13,6 +13,7 @@
 
 #include "fu-cabinet.h"
 #include "fu-common.h"
+#include "fu-common-jcat.h"
 
 #include "fwupd-enums.h"
 #include "fwupd-error.h"
@@ -22,6 +23,7 @@ struct _FuCabinet {
 	guint64			 size_max;
 	GCabCabinet		*gcab_cabinet;
 	gchar			*container_checksum;
+	GHashTable		*payload_checksums;	/* basename : FuCabinetChecksumHelper */
 	XbBuilder		*builder;
 	XbSilo			*silo;
 	JcatContext		*jcat_context;
@@ -39,6 +41,7 @@ fu_cabinet_finalize (GObject *obj)
 	if (self->builder != NULL)
 		g_object_unref (self->builder);
 	g_free (self->container_checksum);
+	g_hash_table_unref (self->payload_checksums);
 	g_object_unref (self->gcab_cabinet);
 	g_object_unref (self->jcat_context);
 	g_object_unref (self->jcat_file);
@@ -57,6 +60,8 @@ fu_cabinet_init (FuCabinet *self)
 {
 	self->size_max = 1024 * 1024 * 100;
 	self->gcab_cabinet = gcab_cabinet_new ();
+	self->payload_checksums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+							 (GDestroyNotify) fu_cabinet_checksum_helper_free);
 	self->builder = xb_builder_new ();
 	self->jcat_file = jcat_file_new ();
 	self->jcat_context = jcat_context_new ();
@@ -129,13 +134,130 @@ fu_cabinet_get_file_by_name (FuCabinet *self, const gchar *basename)
 	return NULL;
 }
 
+/* gets the basename of the main firmware file for the release */
+static gchar *
+fu_cabinet_release_get_basename (XbNode *release)
+{
+	const gchar *csum_filename = NULL;
+	g_autoptr(XbNode) csum_tmp = NULL;
+
+	csum_tmp = xb_node_query_first (release, "checksum[@target='content']", NULL);
+	if (csum_tmp != NULL)
+		csum_filename = xb_node_get_attr (csum_tmp, "filename");
+
+	/* if this isn't true, a firmware needs to set in the metainfo.xml file
+	 * something like: <checksum target="content" filename="FLASH.ROM"/> */
+	if (csum_filename == NULL)
+		csum_filename = "firmware.bin";
+	return g_path_get_basename (csum_filename);
+}
+
+typedef struct {
+	GBytes			*blob;
+	gchar			*checksum_sha1;
+	gchar			*checksum_sha256;
+} FuCabinetChecksumHelper;
+
+static void
+fu_cabinet_checksum_helper_free (FuCabinetChecksumHelper *helper)
+{
+	g_bytes_unref (helper->blob);
+	g_free (helper->checksum_sha1);
+	g_free (helper->checksum_sha256);
+	g_free (helper);
+}
+
+/* feed both digests from the same chunk while it is still in the cache */
+static void
+fu_cabinet_checksum_helper_run (FuCabinetChecksumHelper *helper)
+{
+	const gsize chunksz = 0x8000;
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (helper->blob, &bufsz);
+	g_autoptr(GChecksum) csum_sha1 = g_checksum_new (G_CHECKSUM_SHA1);
+	g_autoptr(GChecksum) csum_sha256 = g_checksum_new (G_CHECKSUM_SHA256);
+
+	for (gsize i = 0; i < bufsz; i += chunksz) {
+		gsize sz = MIN (chunksz, bufsz - i);
+		g_checksum_update (csum_sha1, buf + i, sz);
+		g_checksum_update (csum_sha256, buf + i, sz);
+	}
+	helper->checksum_sha1 = g_strdup (g_checksum_get_string (csum_sha1));
+	helper->checksum_sha256 = g_strdup (g_checksum_get_string (csum_sha256));
+}
+
+static void
+fu_cabinet_checksum_helper_run_cb (gpointer data, gpointer user_data)
+{
+	fu_cabinet_checksum_helper_run ((FuCabinetChecksumHelper *) data);
+}
+
+/* computes the content checksums of every payload used by the releases */
+static gboolean
+fu_cabinet_checksum_payloads (FuCabinet *self, GPtrArray *releases, GError **error)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gsize total = 0;
+	guint threads;
+
+	for (guint i = 0; i < releases->len; i++) {
+		XbNode *release = g_ptr_array_index (releases, i);
+		FuCabinetChecksumHelper *helper;
+		GBytes *blob;
+		GCabFile *cabfile;
+		g_autofree gchar *basename = fu_cabinet_release_get_basename (release);
+
+		/* errors are reported when parsing the release */
+		if (g_hash_table_contains (self->payload_checksums, basename))
+			continue;
+		cabfile = fu_cabinet_get_file_by_name (self, basename);
+		if (cabfile == NULL)
+			continue;
+		blob = gcab_file_get_bytes (cabfile);
+		if (blob == NULL)
+			continue;
+		helper = g_new0 (FuCabinetChecksumHelper, 1);
+		helper->blob = g_bytes_ref (blob);
+		g_hash_table_insert (self->payload_checksums,
+				     g_steal_pointer (&basename), helper);
+		total += g_bytes_get_size (blob);
+	}
+
+	/* not worth starting threads */
+	threads = MIN (g_hash_table_size (self->payload_checksums), g_get_num_processors ());
+	if (threads <= 1 || total < 0x100000) {
+		g_hash_table_iter_init (&iter, self->payload_checksums);
+		while (g_hash_table_iter_next (&iter, NULL, &value))
+			fu_cabinet_checksum_helper_run (value);
+	} else {
+		GThreadPool *pool;
+		pool = g_thread_pool_new (fu_cabinet_checksum_helper_run_cb, NULL,
+					  threads, TRUE, error);
+		if (pool == NULL)
+			return FALSE;
+		g_hash_table_iter_init (&iter, self->payload_checksums);
+		while (g_hash_table_iter_next (&iter, NULL, &value)) {
+			if (!g_thread_pool_push (pool, value, error)) {
+				g_thread_pool_free (pool, FALSE, TRUE);
+				return FALSE;
+			}
+		}
+
+		/* wait for all the checksums to complete */
+		g_thread_pool_free (pool, FALSE, TRUE);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 /* sets the firmware and signature blobs on XbNode */
 static gboolean
 fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 {
 	GCabFile *cabfile;
 	GBytes *blob;
-	const gchar *csum_filename = NULL;
 	g_autofree gchar *basename = NULL;
 	g_autoptr(XbNode) csum_tmp = NULL;
 	g_autoptr(XbNode) metadata_trust = NULL;
@@ -151,16 +273,9 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 
 	/* ensure we always have a content checksum */
 	csum_tmp = xb_node_query_first (release, "checksum[@target='content']", NULL);
-	if (csum_tmp != NULL)
-		csum_filename = xb_node_get_attr (csum_tmp, "filename");
-
-	/* if this isn't true, a firmware needs to set in the metainfo.xml file
-	 * something like: <checksum target="content" filename="FLASH.ROM"/> */
-	if (csum_filename == NULL)
-		csum_filename = "firmware.bin";
 
 	/* get the main firmware file */
-	basename = g_path_get_basename (csum_filename);
+	basename = fu_cabinet_release_get_basename (release);
 	cabfile = fu_cabinet_get_file_by_name (self, basename);
 	if (cabfile == NULL) {
 		g_set_error (error,
@@ -203,8 +318,21 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 
 	/* set if unspecified, but error out if specified and incorrect */
 	if (csum_tmp != NULL && xb_node_get_text (csum_tmp) != NULL) {
-		g_autofree gchar *checksum = NULL;
-		checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, blob);
+		FuCabinetChecksumHelper *helper;
+		const gchar *checksum;
+		helper = g_hash_table_lookup (self->payload_checksums, basename);
+		if (helper == NULL) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "no checksum computed for %s",
+				     basename);
+			return FALSE;
+		}
+		if (g_strcmp0 (xb_node_get_attr (csum_tmp, "type"), "sha256") == 0)
+			checksum = helper->checksum_sha256;
+		else
+			checksum = helper->checksum_sha1;
 		if (g_strcmp0 (checksum, xb_node_get_text (csum_tmp)) != 0) {
 			g_set_error (error,
 				     FWUPD_ERROR,
@@ -221,11 +349,11 @@ fu_cabinet_parse_release (FuCabinet *self, XbNode *release, GError **error)
 	if (item != NULL) {
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GPtrArray) results = NULL;
-		results = jcat_context_verify_item (self->jcat_context,
-						    blob, item,
-						    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-						    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-						    &error_local);
+		results = fu_common_jcat_verify_item_cached (self->jcat_context,
+							     blob, item,
+							     JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+							     JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+							     &error_local);
 		if (results == NULL) {
 			g_debug ("failed to verify payload %s: %s",
 				 basename, error_local->message);
@@ -411,12 +539,12 @@ fu_cabinet_build_silo_metainfo (FuCabinet *self, GCabFile *cabfile, GError **err
 	} else {
 		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GPtrArray) results = NULL;
-		results = jcat_context_verify_item (self->jcat_context,
-						    gcab_file_get_bytes (cabfile),
-						    item,
-						    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-						    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-						    &error_local);
+		results = fu_common_jcat_verify_item_cached (self->jcat_context,
+							     gcab_file_get_bytes (cabfile),
+							     item,
+							     JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+							     JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+							     &error_local);
 		if (results == NULL) {
 			g_debug ("failed to verify %s: %s",
 				 fn, error_local->message);
@@ -536,6 +664,7 @@ fu_cabinet_build_silo (FuCabinet *self, GBytes *data, GError **error)
 typedef struct {
 	FuCabinet	*self;
 	guint64		 size_total;
+	GHashTable	*basenames;	/* (nullable): payloads to extract */
 	GError		*error;
 } FuCabinetDecompressHelper;
 
@@ -584,6 +713,45 @@ fu_cabinet_decompress_file_cb (GCabFile *file, gpointer user_data)
 	/* ignore the dirname completely */
 	basename = g_path_get_basename (name);
 	gcab_file_set_extract_name (file, basename);
+
+	/* only decompress the payloads referenced by a release */
+	if (helper->basenames != NULL)
+		return gcab_file_get_bytes (file) == NULL &&
+		       g_hash_table_contains (helper->basenames, basename);
+
+	/* the metadata is always required */
+	return g_str_has_suffix (basename, ".metainfo.xml") ||
+	       g_str_has_suffix (basename, ".jcat");
+}
+
+static gboolean
+fu_cabinet_decompress_extract (FuCabinet *self,
+			       FuCabinetDecompressHelper *helper,
+			       GError **error)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	if (!gcab_cabinet_extract_simple (self->gcab_cabinet, NULL,
+					  fu_cabinet_decompress_file_cb, helper,
+					  NULL, &error_local)) {
+		if (helper->error != NULL) {
+			g_propagate_error (error, g_steal_pointer (&helper->error));
+			return FALSE;
+		}
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     error_local->message);
+		return FALSE;
+	}
+
+	/* the file callback set an error */
+	if (helper->error != NULL) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
+		return FALSE;
+	}
+
+	/* success */
 	return TRUE;
 }
 
@@ -593,9 +761,9 @@ fu_cabinet_decompress (FuCabinet *self, GBytes *data, GError **error)
 	FuCabinetDecompressHelper helper = {
 		.self		= self,
 		.size_total	= 0,
+		.basenames	= NULL,
 		.error		= NULL,
 	};
-	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GInputStream) istream = NULL;
 
 	/* load from a seekable stream */
@@ -615,25 +783,21 @@ fu_cabinet_decompress (FuCabinet *self, GBytes *data, GError **error)
 		return FALSE;
 	}
 
-	/* decompress the file to memory */
-	if (!gcab_cabinet_extract_simple (self->gcab_cabinet, NULL,
-					  fu_cabinet_decompress_file_cb, &helper,
-					  NULL, &error_local)) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     error_local->message);
-		return FALSE;
-	}
-
-	/* the file callback set an error */
-	if (helper.error != NULL) {
-		g_propagate_error (error, helper.error);
-		return FALSE;
-	}
+	/* decompress just the metadata files to memory */
+	return fu_cabinet_decompress_extract (self, &helper, error);
+}
 
-	/* success */
-	return TRUE;
+/* decompress the firmware payloads the releases refer to */
+static gboolean
+fu_cabinet_decompress_payloads (FuCabinet *self, GHashTable *basenames, GError **error)
+{
+	FuCabinetDecompressHelper helper = {
+		.self		= self,
+		.size_total	= 0,
+		.basenames	= basenames,
+		.error		= NULL,
+	};
+	return fu_cabinet_decompress_extract (self, &helper, error);
 }
 
 /**
@@ -656,7 +820,9 @@ fu_cabinet_parse (FuCabinet *self,
 		  GError **error)
 {
 	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GHashTable) basenames = NULL;
 	g_autoptr(GPtrArray) components = NULL;
+	g_autoptr(GPtrArray) releases_all = NULL;
 	g_autoptr(XbQuery) query = NULL;
 
 	g_return_val_if_fail (FU_IS_CABINET (self), FALSE);
@@ -664,7 +830,7 @@ fu_cabinet_parse (FuCabinet *self,
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 	g_return_val_if_fail (self->silo == NULL, FALSE);
 
-	/* decompress */
+	/* decompress the metadata */
 	if (!fu_cabinet_decompress (self, data, error))
 		return FALSE;
 
@@ -698,7 +864,9 @@ fu_cabinet_parse (FuCabinet *self,
 	if (query == NULL)
 		return FALSE;
 
-	/* process each listed release */
+	/* find all the payloads referenced by each listed release */
+	basenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	releases_all = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (guint i = 0; i < components->len; i++) {
 		XbNode *component = g_ptr_array_index (components, i);
 		g_autoptr(GPtrArray) releases = NULL;
@@ -713,12 +881,29 @@ fu_cabinet_parse (FuCabinet *self,
 		}
 		for (guint j = 0; j < releases->len; j++) {
 			XbNode *rel = g_ptr_array_index (releases, j);
-			g_debug ("processing release: %s", xb_node_get_attr (rel, "version"));
-			if (!fu_cabinet_parse_release (self, rel, error))
-				return FALSE;
+			g_autofree gchar *basename = fu_cabinet_release_get_basename (rel);
+			g_hash_table_add (basenames, g_strdup_printf ("%s.asc", basename));
+			g_hash_table_add (basenames, g_steal_pointer (&basename));
+			g_ptr_array_add (releases_all, g_object_ref (rel));
 		}
 	}
 
+	/* only decompress the files that are actually used */
+	if (!fu_cabinet_decompress_payloads (self, basenames, error))
+		return FALSE;
+
+	/* hash all the payloads at once rather than one release at a time */
+	if (!fu_cabinet_checksum_payloads (self, releases_all, error))
+		return FALSE;
+
+	/* process each listed release */
+	for (guint i = 0; i < releases_all->len; i++) {
+		XbNode *rel = g_ptr_array_index (releases_all, i);
+		g_debug ("processing release: %s", xb_node_get_attr (rel, "version"));
+		if (!fu_cabinet_parse_release (self, rel, error))
+			return FALSE;
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuChecksumConverter"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "fu-checksum-converter.h"
+
+struct _FuChecksumConverter
+{
+	GObject			 parent_instance;
+	GChecksum		*checksum;
+	gchar			*checksum_str;
+	gsize			 size;
+};
+
+static void fu_checksum_converter_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (FuChecksumConverter, fu_checksum_converter, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						fu_checksum_converter_iface_init))
+
+/* the data is passed through unchanged */
+static GConverterResult
+fu_checksum_converter_convert (GConverter *converter,
+			       const void *inbuf,
+			       gsize inbuf_size,
+			       void *outbuf,
+			       gsize outbuf_size,
+			       GConverterFlags flags,
+			       gsize *bytes_read,
+			       gsize *bytes_written,
+			       GError **error)
+{
+	FuChecksumConverter *self = FU_CHECKSUM_CONVERTER (converter);
+	gsize sz = MIN (inbuf_size, outbuf_size);
+
+	*bytes_read = 0;
+	*bytes_written = 0;
+	if (inbuf_size == 0) {
+		if (flags & G_CONVERTER_INPUT_AT_END)
+			return G_CONVERTER_FINISHED;
+		if (flags & G_CONVERTER_FLUSH)
+			return G_CONVERTER_FLUSHED;
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_PARTIAL_INPUT,
+				     "Need more input");
+		return G_CONVERTER_ERROR;
+	}
+	if (outbuf_size == 0) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NO_SPACE,
+				     "Need more output space");
+		return G_CONVERTER_ERROR;
+	}
+	memcpy (outbuf, inbuf, sz);
+	g_checksum_update (self->checksum, inbuf, sz);
+	self->size += sz;
+	*bytes_read = sz;
+	*bytes_written = sz;
+	if (sz == inbuf_size && (flags & G_CONVERTER_INPUT_AT_END))
+		return G_CONVERTER_FINISHED;
+	return G_CONVERTER_CONVERTED;
+}
+
+static void
+fu_checksum_converter_reset (GConverter *converter)
+{
+	FuChecksumConverter *self = FU_CHECKSUM_CONVERTER (converter);
+	g_checksum_reset (self->checksum);
+	self->size = 0;
+}
+
+/**
+ * fu_checksum_converter_get_string:
+ * @self: a #FuChecksumConverter
+ *
+ * Gets the checksum of all the data that has been passed through so far.
+ *
+ * Returns: a hexadecimal string
+ **/
+const gchar *
+fu_checksum_converter_get_string (FuChecksumConverter *self)
+{
+	g_autoptr(GChecksum) checksum = NULL;
+	g_return_val_if_fail (FU_IS_CHECKSUM_CONVERTER (self), NULL);
+
+	/* a GChecksum cannot be updated once the string has been read */
+	checksum = g_checksum_copy (self->checksum);
+	g_free (self->checksum_str);
+	self->checksum_str = g_strdup (g_checksum_get_string (checksum));
+	return self->checksum_str;
+}
+
+/**
+ * fu_checksum_converter_get_size:
+ * @self: a #FuChecksumConverter
+ *
+ * Gets the number of bytes that have been passed through so far.
+ *
+ * Returns: size in bytes
+ **/
+gsize
+fu_checksum_converter_get_size (FuChecksumConverter *self)
+{
+	g_return_val_if_fail (FU_IS_CHECKSUM_CONVERTER (self), 0);
+	return self->size;
+}
+
+static void
+fu_checksum_converter_iface_init (GConverterIface *iface)
+{
+	iface->convert = fu_checksum_converter_convert;
+	iface->reset = fu_checksum_converter_reset;
+}
+
+static void
+fu_checksum_converter_finalize (GObject *object)
+{
+	FuChecksumConverter *self = FU_CHECKSUM_CONVERTER (object);
+	g_checksum_free (self->checksum);
+	g_free (self->checksum_str);
+	G_OBJECT_CLASS (fu_checksum_converter_parent_class)->finalize (object);
+}
+
+static void
+fu_checksum_converter_class_init (FuChecksumConverterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_checksum_converter_finalize;
+}
+
+static void
+fu_checksum_converter_init (FuChecksumConverter *self)
+{
+}
+
+/**
+ * fu_checksum_converter_new:
+ * @checksum_type: a #GChecksumType, e.g. %G_CHECKSUM_SHA256
+ *
+ * Creates a #GConverter that does not change the data, but computes the
+ * checksum of everything that is read through it.
+ *
+ * Returns: (transfer full): a #FuChecksumConverter
+ **/
+FuChecksumConverter *
+fu_checksum_converter_new (GChecksumType checksum_type)
+{
+	FuChecksumConverter *self = g_object_new (FU_TYPE_CHECKSUM_CONVERTER, NULL);
+	self->checksum = g_checksum_new (checksum_type);
+	return self;
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_CHECKSUM_CONVERTER (fu_checksum_converter_get_type ())
+G_DECLARE_FINAL_TYPE (FuChecksumConverter, fu_checksum_converter, FU, CHECKSUM_CONVERTER, GObject)
+
+FuChecksumConverter	*fu_checksum_converter_new		(GChecksumType	 checksum_type);
+const gchar		*fu_checksum_converter_get_string	(FuChecksumConverter *self);
+gsize			 fu_checksum_converter_get_size		(FuChecksumConverter *self);
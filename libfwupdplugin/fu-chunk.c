@@ -408,68 +408,300 @@ fu_chunk_array_new (const guint8 *data,
 		    guint32 page_sz,
 		    guint32 packet_sz)
 {
+	FuChunkIter iter;
 	GPtrArray *chunks = NULL;
-	guint32 page_old = G_MAXUINT32;
-	guint32 idx;
-	guint32 last_flush = 0;
 
 	g_return_val_if_fail (data_sz > 0, NULL);
 
 	chunks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	for (idx = 1; idx < data_sz; idx++) {
-		guint32 page = 0;
-		if (page_sz > 0)
-			page = (addr_start + idx) / page_sz;
-		if (page_old == G_MAXUINT32) {
-			page_old = page;
-		} else if (page != page_old) {
-			const guint8 *data_offset = data != NULL ? data + last_flush : 0x0;
-			guint32 address_offset = addr_start + last_flush;
-			if (page_sz > 0)
-				address_offset %= page_sz;
-			g_ptr_array_add (chunks,
-					 fu_chunk_new (chunks->len,
-						       page_old,
-						       address_offset,
-						       data_offset,
-						       idx - last_flush));
-			last_flush = idx;
-			page_old = page;
-			continue;
-		}
-		if (packet_sz > 0 && idx - last_flush >= packet_sz) {
-			const guint8 *data_offset = data != NULL ? data + last_flush : 0x0;
-			guint32 address_offset = addr_start + last_flush;
-			if (page_sz > 0)
-				address_offset %= page_sz;
-			g_ptr_array_add (chunks,
-					 fu_chunk_new (chunks->len,
-						       page,
-						       address_offset,
-						       data_offset,
-						       idx - last_flush));
-			last_flush = idx;
-			continue;
-		}
-	}
-	if (last_flush != idx) {
-		const guint8 *data_offset = data != NULL ? data + last_flush : 0x0;
-		guint32 address_offset = addr_start + last_flush;
-		guint32 page = 0;
-		if (page_sz > 0) {
-			address_offset %= page_sz;
-			page = (addr_start + (idx - 1)) / page_sz;
-		}
+	fu_chunk_iter_init (&iter, data, data_sz, addr_start, page_sz, packet_sz);
+	while (fu_chunk_iter_next (&iter)) {
 		g_ptr_array_add (chunks,
-				 fu_chunk_new (chunks->len,
-					       page,
-					       address_offset,
-					       data_offset,
-					       data_sz - last_flush));
+				 fu_chunk_new (fu_chunk_iter_get_idx (&iter),
+					       fu_chunk_iter_get_page (&iter),
+					       fu_chunk_iter_get_address (&iter),
+					       fu_chunk_iter_get_data (&iter),
+					       fu_chunk_iter_get_data_sz (&iter)));
 	}
 	return chunks;
 }
 
+/**
+ * fu_chunk_iter_init:
+ * @iter: an uninitialized #FuChunkIter
+ * @data: a linear blob of memory, or %NULL
+ * @data_sz: size of @data_sz
+ * @addr_start: the hardware address offset, or 0
+ * @page_sz: the hardware page size, or 0
+ * @packet_sz: the transfer size, or 0
+ *
+ * Initializes an iterator that splits a linear blob of memory into packets,
+ * ensuring each packet does not cross a page boundary and is less that a
+ * specific transfer size.
+ *
+ * Unlike fu_chunk_array_new() no objects are allocated, and the packet
+ * offsets are calculated as required. The @data must remain valid while
+ * the iterator is in use.
+ *
+ * |[<!-- language="C" -->
+ * FuChunkIter iter;
+ * fu_chunk_iter_init_bytes (&iter, fw, 0x0, 0x1000, 64);
+ * while (fu_chunk_iter_next (&iter)) {
+ *   if (!fu_example_write (self,
+ *                          fu_chunk_iter_get_address (&iter),
+ *                          fu_chunk_iter_get_data (&iter),
+ *                          fu_chunk_iter_get_data_sz (&iter),
+ *                          error))
+ *     return FALSE;
+ * }
+ * ]|
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_chunk_iter_init (FuChunkIter *iter,
+		    const guint8 *data,
+		    guint32 data_sz,
+		    guint32 addr_start,
+		    guint32 page_sz,
+		    guint32 packet_sz)
+{
+	g_return_if_fail (iter != NULL);
+	memset (iter, 0, sizeof(*iter));
+	iter->data = data;
+	iter->data_sz = data_sz;
+	iter->addr_start = addr_start;
+	iter->page_sz = page_sz;
+	iter->packet_sz = packet_sz;
+	iter->idx = G_MAXUINT32;
+}
+
+/**
+ * fu_chunk_iter_init_bytes:
+ * @iter: an uninitialized #FuChunkIter
+ * @blob: a #GBytes
+ * @addr_start: the hardware address offset, or 0
+ * @page_sz: the hardware page size, or 0
+ * @packet_sz: the transfer size, or 0
+ *
+ * Initializes an iterator that splits a #GBytes into packets. The @blob is
+ * not referenced and must remain valid while the iterator is in use.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_chunk_iter_init_bytes (FuChunkIter *iter,
+			  GBytes *blob,
+			  guint32 addr_start,
+			  guint32 page_sz,
+			  guint32 packet_sz)
+{
+	gsize bufsz = 0;
+	const guint8 *buf;
+
+	g_return_if_fail (iter != NULL);
+	g_return_if_fail (blob != NULL);
+
+	buf = g_bytes_get_data (blob, &bufsz);
+	fu_chunk_iter_init (iter, buf, (guint32) bufsz, addr_start, page_sz, packet_sz);
+	iter->blob = blob;
+}
+
+/**
+ * fu_chunk_iter_next:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Advances the iterator to the next packet.
+ *
+ * Return value: %TRUE if a packet is available, %FALSE when done
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_chunk_iter_next (FuChunkIter *iter)
+{
+	guint64 abs;
+	guint64 end;
+
+	g_return_val_if_fail (iter != NULL, FALSE);
+
+	iter->offset += iter->chunk_sz;
+	if (iter->offset >= iter->data_sz) {
+		iter->chunk_sz = 0;
+		return FALSE;
+	}
+	iter->idx++;
+
+	/* never cross a page boundary or exceed the transfer size */
+	abs = (guint64) iter->addr_start + iter->offset;
+	end = iter->data_sz;
+	if (iter->page_sz > 0) {
+		guint64 boundary;
+		iter->page = abs / iter->page_sz;
+		iter->address = abs % iter->page_sz;
+		boundary = ((guint64) iter->page + 1) * iter->page_sz - iter->addr_start;
+		end = MIN (end, boundary);
+	} else {
+		iter->page = 0;
+		iter->address = (guint32) abs;
+	}
+	if (iter->packet_sz > 0)
+		end = MIN (end, (guint64) iter->offset + iter->packet_sz);
+	iter->chunk_sz = end - iter->offset;
+	return TRUE;
+}
+
+/**
+ * fu_chunk_iter_get_length:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the total number of packets, which is typically used for progress
+ * reporting. The position of the iterator is not changed.
+ *
+ * Return value: number of packets
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_length (const FuChunkIter *iter)
+{
+	FuChunkIter iter_tmp;
+	guint32 length = 0;
+
+	g_return_val_if_fail (iter != NULL, 0);
+
+	/* only the packet boundaries are visited, not every byte */
+	fu_chunk_iter_init (&iter_tmp, iter->data, iter->data_sz,
+			    iter->addr_start, iter->page_sz, iter->packet_sz);
+	while (fu_chunk_iter_next (&iter_tmp))
+		length++;
+	return length;
+}
+
+/**
+ * fu_chunk_iter_get_idx:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the index of the current packet.
+ *
+ * Return value: index, starting at 0
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_idx (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, G_MAXUINT32);
+	return iter->idx;
+}
+
+/**
+ * fu_chunk_iter_get_page:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the page of the current packet.
+ *
+ * Return value: page
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_page (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, G_MAXUINT32);
+	return iter->page;
+}
+
+/**
+ * fu_chunk_iter_get_address:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the address *within* the page of the current packet.
+ *
+ * Return value: address
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_address (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, G_MAXUINT32);
+	return iter->address;
+}
+
+/**
+ * fu_chunk_iter_get_offset:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the offset of the current packet from the start of the data.
+ *
+ * Return value: offset in bytes
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_offset (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, G_MAXUINT32);
+	return iter->offset;
+}
+
+/**
+ * fu_chunk_iter_get_data:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the data of the current packet, borrowed from the parent buffer.
+ *
+ * Return value: (transfer none): data, or %NULL if initialized without data
+ *
+ * Since: 1.5.8
+ **/
+const guint8 *
+fu_chunk_iter_get_data (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, NULL);
+	if (iter->data == NULL)
+		return NULL;
+	return iter->data + iter->offset;
+}
+
+/**
+ * fu_chunk_iter_get_data_sz:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the data size of the current packet.
+ *
+ * Return value: size in bytes
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_chunk_iter_get_data_sz (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, G_MAXUINT32);
+	return iter->chunk_sz;
+}
+
+/**
+ * fu_chunk_iter_get_bytes:
+ * @iter: an initialized #FuChunkIter
+ *
+ * Gets the current packet as bytes. If the iterator was created using
+ * fu_chunk_iter_init_bytes() then the data is not copied.
+ *
+ * Return value: (transfer full): a #GBytes
+ *
+ * Since: 1.5.8
+ **/
+GBytes *
+fu_chunk_iter_get_bytes (const FuChunkIter *iter)
+{
+	g_return_val_if_fail (iter != NULL, NULL);
+	if (iter->blob != NULL)
+		return g_bytes_new_from_bytes (iter->blob, iter->offset, iter->chunk_sz);
+	return g_bytes_new_static (fu_chunk_iter_get_data (iter), iter->chunk_sz);
+}
+
 /**
  * fu_chunk_array_new_from_bytes:
  * @blob: a #GBytes
@@ -12,6 +12,26 @@
 
 G_DECLARE_FINAL_TYPE (FuChunk, fu_chunk, FU, CHUNK, GObject)
 
+/**
+ * FuChunkIter:
+ *
+ * An iterator that splits a blob into packets without allocating objects.
+ **/
+typedef struct {
+	/*< private >*/
+	GBytes		*blob;
+	const guint8	*data;
+	guint32		 data_sz;
+	guint32		 addr_start;
+	guint32		 page_sz;
+	guint32		 packet_sz;
+	guint32		 offset;
+	guint32		 chunk_sz;
+	guint32		 idx;
+	guint32		 page;
+	guint32		 address;
+} FuChunkIter;
+
 FuChunk		*fu_chunk_bytes_new			(GBytes		*bytes);
 void		 fu_chunk_set_idx			(FuChunk	*self,
 							 guint32	 idx);
@@ -51,3 +71,24 @@ GPtrArray	*fu_chunk_array_new_from_bytes		(GBytes		*blob,
 							 guint32	 addr_start,
 							 guint32	 page_sz,
 							 guint32	 packet_sz);
+
+void		 fu_chunk_iter_init			(FuChunkIter	*iter,
+							 const guint8	*data,
+							 guint32	 data_sz,
+							 guint32	 addr_start,
+							 guint32	 page_sz,
+							 guint32	 packet_sz);
+void		 fu_chunk_iter_init_bytes		(FuChunkIter	*iter,
+							 GBytes		*blob,
+							 guint32	 addr_start,
+							 guint32	 page_sz,
+							 guint32	 packet_sz);
+gboolean	 fu_chunk_iter_next			(FuChunkIter	*iter);
+guint32		 fu_chunk_iter_get_length		(const FuChunkIter *iter);
+guint32		 fu_chunk_iter_get_idx			(const FuChunkIter *iter);
+guint32		 fu_chunk_iter_get_page			(const FuChunkIter *iter);
+guint32		 fu_chunk_iter_get_address		(const FuChunkIter *iter);
+guint32		 fu_chunk_iter_get_offset		(const FuChunkIter *iter);
+const guint8	*fu_chunk_iter_get_data			(const FuChunkIter *iter);
+guint32		 fu_chunk_iter_get_data_sz		(const FuChunkIter *iter);
+GBytes		*fu_chunk_iter_get_bytes		(const FuChunkIter *iter);
@@ -8,8 +8,23 @@
 
 #include <config.h>
 
+#include <fwupd.h>
+
 #include "fu-common-guid.h"
 
+/* the most recently used instance IDs are at the head of the queue, and the
+ * GUIDs are interned so the returned strings stay valid after eviction */
+#define FU_COMMON_GUID_CACHE_MAX		4096
+
+typedef struct {
+	gchar			*str;
+	const gchar		*guid;	/* interned */
+} FuCommonGuidCacheItem;
+
+G_LOCK_DEFINE_STATIC (guid_cache);
+static GHashTable *guid_cache = NULL;	/* str : GList of FuCommonGuidCacheItem */
+static GQueue guid_cache_lru = G_QUEUE_INIT;
+
 /**
  * fu_common_guid_is_plausible:
  * @buf: a buffer of data
@@ -33,3 +48,57 @@ fu_common_guid_is_plausible (const guint8 *buf)
 		return FALSE;
 	return TRUE;
 }
+
+/**
+ * fu_common_guid_hash_string_cached:
+ * @str: A source string to use as a key, e.g. `USB\VID_0A5C&PID_6412`
+ *
+ * Returns the same GUID as fwupd_guid_hash_string(), but remembers the most
+ * recently used strings so that they are not hashed again. This is useful for
+ * instance IDs which are looked up many times during coldplug and replug.
+ *
+ * Returns: A GUID that must not be freed, or %NULL if the string was invalid
+ *
+ * Since: 1.5.8
+ **/
+const gchar *
+fu_common_guid_hash_string_cached (const gchar *str)
+{
+	FuCommonGuidCacheItem *item;
+	GList *link;
+	gchar buf[FWUPD_GUID_STRING_SIZE];
+
+	if (str == NULL || str[0] == '\0')
+		return NULL;
+
+	G_LOCK (guid_cache);
+	if (guid_cache == NULL)
+		guid_cache = g_hash_table_new (g_str_hash, g_str_equal);
+	link = g_hash_table_lookup (guid_cache, str);
+	if (link != NULL) {
+		g_queue_unlink (&guid_cache_lru, link);
+		g_queue_push_head_link (&guid_cache_lru, link);
+		item = link->data;
+		G_UNLOCK (guid_cache);
+		return item->guid;
+	}
+	if (!fwupd_guid_hash_string_buf (str, buf)) {
+		G_UNLOCK (guid_cache);
+		return NULL;
+	}
+	item = g_new0 (FuCommonGuidCacheItem, 1);
+	item->str = g_strdup (str);
+	item->guid = g_intern_string (buf);
+	g_queue_push_head (&guid_cache_lru, item);
+	g_hash_table_insert (guid_cache, item->str, guid_cache_lru.head);
+
+	/* drop the least recently used */
+	if (guid_cache_lru.length > FU_COMMON_GUID_CACHE_MAX) {
+		FuCommonGuidCacheItem *item_old = g_queue_pop_tail (&guid_cache_lru);
+		g_hash_table_remove (guid_cache, item_old->str);
+		g_free (item_old->str);
+		g_free (item_old);
+	}
+	G_UNLOCK (guid_cache);
+	return item->guid;
+}
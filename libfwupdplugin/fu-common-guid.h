@@ -9,3 +9,4 @@
 #include <gio/gio.h>
 
 gboolean	 fu_common_guid_is_plausible	(const guint8	*buf);
+const gchar	*fu_common_guid_hash_string_cached	(const gchar	*str);
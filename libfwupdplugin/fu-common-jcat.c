@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuCommon"
+
+#include <config.h>
+
+#include <fwupd.h>
+
+#include "fu-common-jcat.h"
+
+/* results older than this are verified again, e.g. to notice expired keys */
+#define FU_COMMON_JCAT_CACHE_TTL		(60 * 60 * G_USEC_PER_SEC)
+
+typedef struct {
+	gint64		 ctime;
+	GPtrArray	*results;	/* (nullable) (element-type JcatResult) */
+	GError		*error;		/* (nullable) */
+} FuCommonJcatCacheItem;
+
+/* the same context may be used to parse cabinets from several threads */
+G_LOCK_DEFINE_STATIC (jcat_cache);
+
+static void
+fu_common_jcat_cache_item_free (FuCommonJcatCacheItem *cache_item)
+{
+	if (cache_item->results != NULL)
+		g_ptr_array_unref (cache_item->results);
+	if (cache_item->error != NULL)
+		g_error_free (cache_item->error);
+	g_free (cache_item);
+}
+
+static gchar *
+fu_common_jcat_cache_key (GBytes *blob, JcatItem *item, JcatVerifyFlags flags)
+{
+	GString *str = g_string_new (NULL);
+	g_autofree gchar *csum = NULL;
+	g_autoptr(GPtrArray) blobs = jcat_item_get_blobs (item);
+
+	csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	g_string_append_printf (str, "%s|%u", csum, (guint) flags);
+	for (guint i = 0; i < blobs->len; i++) {
+		JcatBlob *jcat_blob = g_ptr_array_index (blobs, i);
+		GBytes *data = jcat_blob_get_data (jcat_blob);
+		g_autofree gchar *csum_sig = NULL;
+		csum_sig = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, data);
+		g_string_append_printf (str, "|%u:%s",
+					(guint) jcat_blob_get_kind (jcat_blob),
+					csum_sig);
+	}
+	return g_string_free (str, FALSE);
+}
+
+static GPtrArray *
+fu_common_jcat_results_copy (GPtrArray *results)
+{
+	GPtrArray *results_copy = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < results->len; i++)
+		g_ptr_array_add (results_copy, g_object_ref (g_ptr_array_index (results, i)));
+	return results_copy;
+}
+
+/**
+ * fu_common_jcat_verify_item_cached: (skip):
+ * @context: A #JcatContext
+ * @blob: The data that was signed
+ * @item: A #JcatItem, typically from a `.jcat` file
+ * @flags: #JcatVerifyFlags, e.g. %JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE
+ * @error: A #GError or %NULL
+ *
+ * Verifies the item using jcat_context_verify_item(), reusing the result of
+ * an earlier call with identical data and signatures on the same @context.
+ *
+ * This is useful as the same firmware archive is often verified when the
+ * client requests the details and then again when it is installed, and
+ * signature verification is much more expensive than the checksum.
+ *
+ * Failures are also remembered, and results expire after one hour.
+ *
+ * Returns: (transfer container) (element-type JcatResult): results, or %NULL
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fu_common_jcat_verify_item_cached (JcatContext *context,
+				   GBytes *blob,
+				   JcatItem *item,
+				   JcatVerifyFlags flags,
+				   GError **error)
+{
+	FuCommonJcatCacheItem *cache_item;
+	GHashTable *cache;
+	g_autofree gchar *key = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+
+	g_return_val_if_fail (JCAT_IS_CONTEXT (context), NULL);
+	g_return_val_if_fail (blob != NULL, NULL);
+	g_return_val_if_fail (JCAT_IS_ITEM (item), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* already verified */
+	key = fu_common_jcat_cache_key (blob, item, flags);
+	G_LOCK (jcat_cache);
+	cache = g_object_get_data (G_OBJECT (context), "fwupd::VerifyCache");
+	if (cache == NULL) {
+		cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					       (GDestroyNotify) fu_common_jcat_cache_item_free);
+		g_object_set_data_full (G_OBJECT (context), "fwupd::VerifyCache",
+					cache, (GDestroyNotify) g_hash_table_unref);
+	}
+	cache_item = g_hash_table_lookup (cache, key);
+	if (cache_item != NULL &&
+	    g_get_monotonic_time () - cache_item->ctime < FU_COMMON_JCAT_CACHE_TTL) {
+		if (cache_item->error != NULL) {
+			g_propagate_error (error, g_error_copy (cache_item->error));
+		} else {
+			results = fu_common_jcat_results_copy (cache_item->results);
+		}
+		G_UNLOCK (jcat_cache);
+		return g_steal_pointer (&results);
+	}
+	G_UNLOCK (jcat_cache);
+
+	/* verify without holding the lock */
+	results = jcat_context_verify_item (context, blob, item, flags, &error_local);
+
+	/* save for next time */
+	cache_item = g_new0 (FuCommonJcatCacheItem, 1);
+	cache_item->ctime = g_get_monotonic_time ();
+	if (results != NULL)
+		cache_item->results = fu_common_jcat_results_copy (results);
+	else
+		cache_item->error = g_error_copy (error_local);
+	G_LOCK (jcat_cache);
+	cache = g_object_get_data (G_OBJECT (context), "fwupd::VerifyCache");
+	if (cache != NULL)
+		g_hash_table_insert (cache, g_steal_pointer (&key), cache_item);
+	else
+		fu_common_jcat_cache_item_free (cache_item);
+	G_UNLOCK (jcat_cache);
+
+	if (results == NULL) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	return g_steal_pointer (&results);
+}
+
+/**
+ * fu_common_jcat_invalidate_cache: (skip):
+ * @context: A #JcatContext
+ *
+ * Forgets all the results saved by fu_common_jcat_verify_item_cached(),
+ * for instance when the public keys used by @context have changed.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_common_jcat_invalidate_cache (JcatContext *context)
+{
+	g_return_if_fail (JCAT_IS_CONTEXT (context));
+	G_LOCK (jcat_cache);
+	g_object_set_data (G_OBJECT (context), "fwupd::VerifyCache", NULL);
+	G_UNLOCK (jcat_cache);
+}
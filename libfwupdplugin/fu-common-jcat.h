@@ -0,0 +1,17 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <jcat.h>
+
+GPtrArray	*fu_common_jcat_verify_item_cached	(JcatContext	*context,
+							 GBytes		*blob,
+							 JcatItem	*item,
+							 JcatVerifyFlags flags,
+							 GError		**error);
+void		 fu_common_jcat_invalidate_cache	(JcatContext	*context);
@@ -205,28 +205,6 @@ fu_common_vercmp_char (gchar chr1, gchar chr2)
 	return chr1 < chr2 ? -1 : 1;
 }
 
-static gint
-fu_common_vercmp_chunk (const gchar *str1, const gchar *str2)
-{
-	guint i;
-
-	/* trivial */
-	if (g_strcmp0 (str1, str2) == 0)
-		return 0;
-	if (str1 == NULL)
-		return 1;
-	if (str2 == NULL)
-		return -1;
-
-	/* check each char of the chunk */
-	for (i = 0; str1[i] != '\0' && str2[i] != '\0'; i++) {
-		gint rc = fu_common_vercmp_char (str1[i], str2[i]);
-		if (rc != 0)
-			return rc;
-	}
-	return fu_common_vercmp_char (str1[i], str2[i]);
-}
-
 static gboolean
 _g_ascii_is_digits (const gchar *str)
 {
@@ -487,12 +465,65 @@ fu_common_version_verify_format (const gchar *version,
 	return TRUE;
 }
 
+/* compare each char of the chunk, which is not NUL-terminated */
+static gint
+fu_common_vercmp_chunk_len (const gchar *str1, gsize len1, const gchar *str2, gsize len2)
+{
+	gsize i;
+	for (i = 0; i < len1 && i < len2; i++) {
+		gint rc = fu_common_vercmp_char (str1[i], str2[i]);
+		if (rc != 0)
+			return rc;
+	}
+	return fu_common_vercmp_char (i < len1 ? str1[i] : '\0',
+				      i < len2 ? str2[i] : '\0');
+}
+
+/* parses one dot-delimited section, returning the end of the section */
+static const gchar *
+fu_common_vercmp_parse_section (const gchar *str,
+				gint64 *value,
+				const gchar **suffix,
+				gsize *suffix_len)
+{
+	gchar *endptr = NULL;
+	const gchar *end;
+
+	*value = g_ascii_strtoll (str, &endptr, 10);
+	for (end = endptr; *end != '\0' && *end != '.'; end++);
+	*suffix = endptr;
+	*suffix_len = end - endptr;
+	return end;
+}
+
+static gint
+fu_common_vercmp_section (gint64 ver_a, const gchar *suffix_a, gsize suffix_len_a,
+			  gint64 ver_b, const gchar *suffix_b, gsize suffix_len_b)
+{
+	/* compare integers */
+	if (ver_a < ver_b)
+		return -1;
+	if (ver_a > ver_b)
+		return 1;
+
+	/* compare strings */
+	if (suffix_len_a > 0 || suffix_len_b > 0) {
+		gint rc = fu_common_vercmp_chunk_len (suffix_a, suffix_len_a,
+						      suffix_b, suffix_len_b);
+		if (rc < 0)
+			return -1;
+		if (rc > 0)
+			return 1;
+	}
+	return 0;
+}
+
+/* compares each section in place rather than using g_strsplit() */
 static gint
 fu_common_vercmp_safe (const gchar *version_a, const gchar *version_b)
 {
-	guint longest_split;
-	g_auto(GStrv) split_a = NULL;
-	g_auto(GStrv) split_b = NULL;
+	const gchar *str_a = version_a;
+	const gchar *str_b = version_b;
 
 	/* sanity check */
 	if (version_a == NULL || version_b == NULL)
@@ -502,42 +533,172 @@ fu_common_vercmp_safe (const gchar *version_a, const gchar *version_b)
 	if (g_strcmp0 (version_a, version_b) == 0)
 		return 0;
 
-	/* split into sections, and try to parse */
-	split_a = g_strsplit (version_a, ".", -1);
-	split_b = g_strsplit (version_b, ".", -1);
-	longest_split = MAX (g_strv_length (split_a), g_strv_length (split_b));
-	for (guint i = 0; i < longest_split; i++) {
-		gchar *endptr_a = NULL;
-		gchar *endptr_b = NULL;
+	for (;;) {
+		const gchar *suffix_a = NULL;
+		const gchar *suffix_b = NULL;
 		gint64 ver_a;
 		gint64 ver_b;
+		gint rc;
+		gsize suffix_len_a = 0;
+		gsize suffix_len_b = 0;
+
+		str_a = fu_common_vercmp_parse_section (str_a, &ver_a, &suffix_a, &suffix_len_a);
+		str_b = fu_common_vercmp_parse_section (str_b, &ver_b, &suffix_b, &suffix_len_b);
+		rc = fu_common_vercmp_section (ver_a, suffix_a, suffix_len_a,
+					       ver_b, suffix_b, suffix_len_b);
+		if (rc != 0)
+			return rc;
 
 		/* we lost or gained a dot */
-		if (split_a[i] == NULL)
+		if (*str_a == '\0' && *str_b == '\0')
+			break;
+		if (*str_a == '\0')
 			return -1;
-		if (split_b[i] == NULL)
+		if (*str_b == '\0')
 			return 1;
+		str_a++;
+		str_b++;
+	}
 
-		/* compare integers */
-		ver_a = g_ascii_strtoll (split_a[i], &endptr_a, 10);
-		ver_b = g_ascii_strtoll (split_b[i], &endptr_b, 10);
-		if (ver_a < ver_b)
-			return -1;
-		if (ver_a > ver_b)
-			return 1;
+	/* we really shouldn't get here */
+	return 0;
+}
+
+/**
+ * fu_common_version_key_init:
+ * @key: A #FuVersionKey
+ * @version: (nullable): the release version, e.g. 1.2.3
+ * @fmt: a #FwupdVersionFormat, e.g. %FWUPD_VERSION_FORMAT_PLAIN
+ *
+ * Parses a version number so that it can be compared using
+ * fu_common_version_key_cmp() without any further parsing or allocation.
+ *
+ * Since: 1.5.8
+ */
+void
+fu_common_version_key_init (FuVersionKey *key, const gchar *version, FwupdVersionFormat fmt)
+{
+	const gchar *str = version;
+
+	g_return_if_fail (key != NULL);
+
+	memset (key, 0, sizeof(*key));
+	key->version = version;
+	key->fmt = fmt;
+	if (version == NULL || fmt == FWUPD_VERSION_FORMAT_PLAIN)
+		return;
+
+	/* the number fu_common_version_parse_from_format() would convert */
+	if (fmt == FWUPD_VERSION_FORMAT_HEX) {
+		const gchar *version_noprefix = version;
+		gchar *endptr = NULL;
+		guint64 tmp;
+		guint base = 0;
+		if (g_strstr_len (version, -1, ".") != NULL)
+			return;
+		if (g_str_has_prefix (version, "20") && strlen (version) == 8)
+			return;
+		if (g_str_has_prefix (version, "0x")) {
+			version_noprefix += 2;
+			base = 16;
+		} else if (_g_ascii_is_digits (version)) {
+			base = 10;
+		} else {
+			return;
+		}
+		tmp = g_ascii_strtoull (version_noprefix, &endptr, base);
+		if (endptr != NULL && endptr[0] != '\0')
+			return;
+		if (tmp == 0)
+			return;
+		key->hex_valid = TRUE;
+		key->hex = (guint32) tmp;
+		return;
+	}
 
-		/* compare strings */
-		if ((endptr_a != NULL && endptr_a[0] != '\0') ||
-		    (endptr_b != NULL && endptr_b[0] != '\0')) {
-			gint rc = fu_common_vercmp_chunk (endptr_a, endptr_b);
-			if (rc < 0)
-				return -1;
-			if (rc > 0)
-				return 1;
+	for (;;) {
+		gint64 value = 0;
+		const gchar *suffix = NULL;
+		gsize suffix_len = 0;
+
+		if (key->sections >= FU_VERSION_KEY_SECTIONS_MAX) {
+			key->overflow = TRUE;
+			return;
+		}
+		str = fu_common_vercmp_parse_section (str, &value, &suffix, &suffix_len);
+		if (suffix_len > G_MAXUINT32) {
+			key->overflow = TRUE;
+			return;
 		}
+		key->values[key->sections] = value;
+		key->suffixes[key->sections] = suffix;
+		key->suffix_lens[key->sections] = suffix_len;
+		key->sections++;
+		if (*str == '\0')
+			break;
+		str++;
 	}
+}
 
-	/* we really shouldn't get here */
+/**
+ * fu_common_version_key_cmp:
+ * @key_a: A #FuVersionKey
+ * @key_b: A #FuVersionKey
+ *
+ * Compares version numbers for sorting, returning the same result as
+ * fu_common_vercmp_full() would for the original strings. Both keys must have
+ * been created using the same #FwupdVersionFormat.
+ *
+ * Returns: -1 if a < b, +1 if a > b, 0 if they are equal, and %G_MAXINT on error
+ *
+ * Since: 1.5.8
+ */
+gint
+fu_common_version_key_cmp (const FuVersionKey *key_a, const FuVersionKey *key_b)
+{
+	guint longest;
+
+	g_return_val_if_fail (key_a != NULL, G_MAXINT);
+	g_return_val_if_fail (key_b != NULL, G_MAXINT);
+
+	if (key_a->fmt == FWUPD_VERSION_FORMAT_PLAIN)
+		return g_strcmp0 (key_a->version, key_b->version);
+	if (key_a->version == NULL || key_b->version == NULL)
+		return G_MAXINT;
+
+	/* the converted strings are fixed width so the numbers can be used */
+	if (key_a->fmt == FWUPD_VERSION_FORMAT_HEX) {
+		if (!key_a->hex_valid || !key_b->hex_valid)
+			return fu_common_vercmp_full (key_a->version, key_b->version, key_a->fmt);
+		if (key_a->hex < key_b->hex)
+			return -1;
+		if (key_a->hex > key_b->hex)
+			return 1;
+		return 0;
+	}
+
+	/* too many sections to fit */
+	if (key_a->overflow || key_b->overflow)
+		return fu_common_vercmp_safe (key_a->version, key_b->version);
+
+	longest = MAX (key_a->sections, key_b->sections);
+	for (guint i = 0; i < longest; i++) {
+		gint rc;
+
+		/* we lost or gained a dot */
+		if (i >= key_a->sections)
+			return -1;
+		if (i >= key_b->sections)
+			return 1;
+		rc = fu_common_vercmp_section (key_a->values[i],
+					       key_a->suffixes[i],
+					       key_a->suffix_lens[i],
+					       key_b->values[i],
+					       key_b->suffixes[i],
+					       key_b->suffix_lens[i]);
+		if (rc != 0)
+			return rc;
+	}
 	return 0;
 }
 
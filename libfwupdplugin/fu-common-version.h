@@ -9,12 +9,41 @@
 #include <gio/gio.h>
 #include <fwupd.h>
 
+#define FU_VERSION_KEY_SECTIONS_MAX	8
+
+/**
+ * FuVersionKey:
+ *
+ * A pre-parsed version number that can be compared many times without
+ * splitting or allocating, for instance when sorting releases.
+ *
+ * The key does not copy the version string, which must remain valid for as
+ * long as the key is used.
+ **/
+typedef struct {
+	/*< private >*/
+	const gchar		*version;
+	FwupdVersionFormat	 fmt;
+	guint			 sections;
+	gboolean		 overflow;
+	gboolean		 hex_valid;
+	guint32			 hex;
+	gint64			 values[FU_VERSION_KEY_SECTIONS_MAX];
+	const gchar		*suffixes[FU_VERSION_KEY_SECTIONS_MAX];
+	guint32			 suffix_lens[FU_VERSION_KEY_SECTIONS_MAX];
+} FuVersionKey;
+
 gint		 fu_common_vercmp		(const gchar	*version_a,
 						 const gchar	*version_b)
 G_DEPRECATED_FOR(fu_common_vercmp_full);
 gint		 fu_common_vercmp_full		(const gchar	*version_a,
 						 const gchar	*version_b,
 						 FwupdVersionFormat fmt);
+void		 fu_common_version_key_init	(FuVersionKey	*key,
+						 const gchar	*version,
+						 FwupdVersionFormat fmt);
+gint		 fu_common_version_key_cmp	(const FuVersionKey *key_a,
+						 const FuVersionKey *key_b);
 gchar		*fu_common_version_from_uint64	(guint64	 val,
 						 FwupdVersionFormat kind);
 gchar		*fu_common_version_from_uint32	(guint32	 val,
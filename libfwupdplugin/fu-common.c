@@ -27,11 +27,16 @@
 #include <cpuid.h>
 #endif
 
+#ifdef HAVE_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_LIBARCHIVE
 #include <archive_entry.h>
 #include <archive.h>
 #endif
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <string.h>
 #include <stdlib.h>
@@ -40,11 +45,11 @@
 #include "fwupd-error.h"
 
 #include "fu-common.h"
+#include "fu-chunk.h"
 #include "fu-volume-private.h"
 
 #define UDISKS_DBUS_SERVICE			"org.freedesktop.UDisks2"
-#define UDISKS_DBUS_PATH			"/org/freedesktop/UDisks2/Manager"
-#define UDISKS_DBUS_MANAGER_INTERFACE		"org.freedesktop.UDisks2.Manager"
+#define UDISKS_DBUS_PATH_ROOT			"/org/freedesktop/UDisks2"
 #define UDISKS_DBUS_INTERFACE_PARTITION 	"org.freedesktop.UDisks2.Partition"
 #define UDISKS_DBUS_INTERFACE_FILESYSTEM	"org.freedesktop.UDisks2.Filesystem"
 #define UDISKS_DBUS_INTERFACE_BLOCK		"org.freedesktop.UDisks2.Block"
@@ -256,6 +261,79 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
 	return g_bytes_new_take (data, len);
 }
 
+/**
+ * fu_common_get_contents_mapped:
+ * @filename: A filename
+ * @error: A #GError, or %NULL
+ *
+ * Maps a file into memory rather than reading it into a heap buffer, which
+ * means that large images are only paged in as they are parsed. Any #GBytes
+ * created from the returned #GBytes using fu_common_bytes_new_offset() also
+ * refer to the mapped data.
+ *
+ * The file must not be modified while the returned #GBytes is in use.
+ *
+ * Returns: a #GBytes, or %NULL for failure
+ *
+ * Since: 1.5.8
+ **/
+GBytes *
+fu_common_get_contents_mapped (const gchar *filename, GError **error)
+{
+	g_autoptr(GMappedFile) mapped_file = NULL;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	mapped_file = g_mapped_file_new (filename, FALSE, error);
+	if (mapped_file == NULL)
+		return NULL;
+	g_debug ("mapping %s with %" G_GSIZE_FORMAT " bytes",
+		 filename, g_mapped_file_get_length (mapped_file));
+#ifdef HAVE_MMAN_H
+	/* parsers mostly read from the start to the end */
+	if (g_mapped_file_get_length (mapped_file) > 0) {
+		gchar *data = g_mapped_file_get_contents (mapped_file);
+		gsize len = g_mapped_file_get_length (mapped_file);
+		if (madvise (data, len, MADV_SEQUENTIAL) != 0)
+			g_debug ("failed to set sequential: %s", g_strerror (errno));
+		if (madvise (data, len, MADV_WILLNEED) != 0)
+			g_debug ("failed to set willneed: %s", g_strerror (errno));
+	}
+#endif
+	return g_mapped_file_get_bytes (mapped_file);
+}
+
+#if defined(HAVE_GIO_UNIX) && defined(F_GET_SEALS)
+static GBytes *
+fu_common_get_contents_fd_sealed (gint fd, gsize count, GError **error)
+{
+	gint seals = fcntl (fd, F_GET_SEALS);
+	struct stat st = { 0x0 };
+	g_autoptr(GMappedFile) mapped_file = NULL;
+
+	/* the sender could change or truncate the data after we check it */
+	if (seals < 0)
+		return NULL;
+	if ((seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) != (F_SEAL_SHRINK | F_SEAL_WRITE))
+		return NULL;
+	if (fstat (fd, &st) < 0 || st.st_size == 0)
+		return NULL;
+	if ((guint64) st.st_size > count) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "cannot read from fd: 0x%x > 0x%x",
+			     (guint) st.st_size, (guint) count);
+		return NULL;
+	}
+	mapped_file = g_mapped_file_new_from_fd (fd, FALSE, NULL);
+	if (mapped_file == NULL)
+		return NULL;
+	return g_mapped_file_get_bytes (mapped_file);
+}
+#endif
+
 /**
  * fu_common_get_contents_fd:
  * @fd: A file descriptor
@@ -264,6 +342,9 @@ fu_common_get_contents_bytes (const gchar *filename, GError **error)
  *
  * Reads a blob from a specific file descriptor.
  *
+ * If @fd is a memfd sealed against writing and shrinking then it is mapped
+ * rather than copied, as the contents can no longer change.
+ *
  * Note: this will close the fd when done
  *
  * Returns: (transfer full): a #GBytes, or %NULL
@@ -276,6 +357,7 @@ fu_common_get_contents_fd (gint fd, gsize count, GError **error)
 #ifdef HAVE_GIO_UNIX
 	guint8 tmp[0x8000] = { 0x0 };
 	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 
@@ -291,6 +373,20 @@ fu_common_get_contents_fd (gint fd, gsize count, GError **error)
 		return NULL;
 	}
 
+#ifdef F_GET_SEALS
+	/* map the data with no copy */
+	blob = fu_common_get_contents_fd_sealed (fd, count, &error_local);
+	if (blob != NULL) {
+		g_close (fd, NULL);
+		return g_steal_pointer (&blob);
+	}
+	if (error_local != NULL) {
+		g_close (fd, NULL);
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+#endif
+
 	/* read the entire fd to a data blob */
 	stream = g_unix_input_stream_new (fd, TRUE);
 
@@ -504,6 +600,70 @@ fu_common_test_namespace_support (GError **error)
 	return TRUE;
 }
 
+#define FU_COMMON_FIRMWARE_BUILDER_CACHE_MAX	32
+
+static gint fu_common_filename_glob_sort_cb (gconstpointer a, gconstpointer b);
+
+/* everything the script can see that is specific to this archive or host,
+ * apart from the tools in /usr */
+static gchar *
+fu_common_firmware_builder_cache_key (GBytes *bytes,
+				      const gchar *script_fn,
+				      const gchar *output_fn,
+				      const gchar *localstatebuilderdir)
+{
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (bytes, &bufsz);
+	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA256);
+
+	g_checksum_update (csum, buf, bufsz);
+	g_checksum_update (csum, (const guchar *) script_fn, strlen (script_fn) + 1);
+	g_checksum_update (csum, (const guchar *) output_fn, strlen (output_fn) + 1);
+
+	/* this is mounted as /boot */
+	if (g_file_test (localstatebuilderdir, G_FILE_TEST_IS_DIR)) {
+		g_autoptr(GPtrArray) files = NULL;
+		files = fu_common_get_files_recursive (localstatebuilderdir, NULL);
+		if (files == NULL)
+			return NULL;
+		g_ptr_array_sort (files, fu_common_filename_glob_sort_cb);
+		for (guint i = 0; i < files->len; i++) {
+			const gchar *fn = g_ptr_array_index (files, i);
+			GStatBuf st = { 0x0 };
+			g_autofree gchar *str = NULL;
+			if (g_stat (fn, &st) != 0)
+				return NULL;
+			str = g_strdup_printf ("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ";",
+					       fn, (gint64) st.st_size, (gint64) st.st_mtime);
+			g_checksum_update (csum, (const guchar *) str, -1);
+		}
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+/* not fatal if the cache directory is read-only */
+static void
+fu_common_firmware_builder_cache_save (const gchar *cache_fn, GBytes *firmware_blob)
+{
+	g_autofree gchar *cache_dir = g_path_get_dirname (cache_fn);
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) files = NULL;
+
+	/* the archives change rarely, so just start again when full */
+	files = fu_common_get_files_recursive (cache_dir, NULL);
+	if (files != NULL && files->len >= FU_COMMON_FIRMWARE_BUILDER_CACHE_MAX) {
+		if (!fu_common_rmtree (cache_dir, &error_local)) {
+			g_debug ("failed to clear firmware builder cache: %s",
+				 error_local->message);
+			return;
+		}
+	}
+	if (!fu_common_set_contents_bytes (cache_fn, firmware_blob, &error_local)) {
+		g_debug ("failed to save firmware builder cache: %s",
+			 error_local->message);
+	}
+}
+
 /**
  * fu_common_firmware_builder:
  * @bytes: The data to use
@@ -520,6 +680,9 @@ fu_common_test_namespace_support (GError **error)
  * 4. The firmware.bin is extracted from the container
  * 5. The temporary location is deleted
  *
+ * The generated firmware is cached, so building from the same archive again
+ * does not run the script unless the builder directory has changed.
+ *
  * Returns: a new #GBytes, or %NULL for error
  *
  * Since: 0.9.7
@@ -533,6 +696,9 @@ fu_common_firmware_builder (GBytes *bytes,
 	gint rc = 0;
 	g_autofree gchar *argv_str = NULL;
 	g_autofree gchar *bwrap_fn = NULL;
+	g_autofree gchar *cache_fn = NULL;
+	g_autofree gchar *cache_key = NULL;
+	g_autofree gchar *cachedir = NULL;
 	g_autofree gchar *localstatebuilderdir = NULL;
 	g_autofree gchar *localstatedir = NULL;
 	g_autofree gchar *output2_fn = NULL;
@@ -547,6 +713,27 @@ fu_common_firmware_builder (GBytes *bytes,
 	g_return_val_if_fail (output_fn != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	/* this is shared with the plugins */
+	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	localstatebuilderdir = g_build_filename (localstatedir, "builder", NULL);
+
+	/* already generated */
+	cache_key = fu_common_firmware_builder_cache_key (bytes, script_fn, output_fn,
+							  localstatebuilderdir);
+	if (cache_key != NULL) {
+		cachedir = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+		cache_fn = g_build_filename (cachedir, "builder", cache_key, NULL);
+		if (g_file_test (cache_fn, G_FILE_TEST_EXISTS)) {
+			g_autoptr(GError) error_local = NULL;
+			firmware_blob = fu_common_get_contents_bytes (cache_fn, &error_local);
+			if (firmware_blob != NULL) {
+				g_debug ("using cached firmware %s", cache_fn);
+				return g_steal_pointer (&firmware_blob);
+			}
+			g_debug ("ignoring firmware builder cache: %s", error_local->message);
+		}
+	}
+
 	/* find bwrap in the path */
 	bwrap_fn = fu_common_find_program_in_path ("bwrap", error);
 	if (bwrap_fn == NULL)
@@ -563,10 +750,6 @@ fu_common_firmware_builder (GBytes *bytes,
 	if (!fu_common_extract_archive (bytes, tmpdir, error))
 		return NULL;
 
-	/* this is shared with the plugins */
-	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
-	localstatebuilderdir = g_build_filename (localstatedir, "builder", NULL);
-
 	/* launch bubblewrap and generate firmware */
 	g_ptr_array_add (argv, g_steal_pointer (&bwrap_fn));
 	fu_common_add_argv (argv, "--die-with-parent");
@@ -623,6 +806,10 @@ fu_common_firmware_builder (GBytes *bytes,
 	if (!fu_common_rmtree (tmpdir, error))
 		return NULL;
 
+	/* save for next time */
+	if (cache_fn != NULL)
+		fu_common_firmware_builder_cache_save (cache_fn, firmware_blob);
+
 	/* success */
 	return g_steal_pointer (&firmware_blob);
 }
@@ -799,6 +986,209 @@ fu_common_spawn_sync (const gchar * const * argv,
 	return g_subprocess_wait_check (subprocess, cancellable, error);
 }
 
+typedef struct {
+	FuOutputHandler		 handler_cb;
+	gpointer		 handler_user_data;
+	GSubprocess		*subprocess;
+	GDataInputStream	*stream;
+	GError			*error;
+	guint			 timeout_ms;
+	GSource			*timeout_source;
+	gboolean		 eof;
+	gboolean		 exited;
+} FuCommonSpawnAsyncHelper;
+
+static void
+fu_common_spawn_async_helper_free (FuCommonSpawnAsyncHelper *helper)
+{
+	if (helper->timeout_source != NULL) {
+		g_source_destroy (helper->timeout_source);
+		g_source_unref (helper->timeout_source);
+	}
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	if (helper->stream != NULL)
+		g_object_unref (helper->stream);
+	g_object_unref (helper->subprocess);
+	g_free (helper);
+}
+
+/* only the first error is kept */
+static void
+fu_common_spawn_async_set_error (FuCommonSpawnAsyncHelper *helper, GError *error)
+{
+	if (helper->error == NULL) {
+		helper->error = error;
+		return;
+	}
+	g_error_free (error);
+}
+
+/* the task completes when the output is closed and the child has exited */
+static void
+fu_common_spawn_async_maybe_complete (GTask *task)
+{
+	FuCommonSpawnAsyncHelper *helper = g_task_get_task_data (task);
+	if (!helper->eof || !helper->exited)
+		return;
+	if (helper->timeout_source != NULL)
+		g_source_destroy (helper->timeout_source);
+	if (helper->error != NULL) {
+		g_task_return_error (task, g_steal_pointer (&helper->error));
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+fu_common_spawn_async_timeout_cb (gpointer user_data)
+{
+	FuCommonSpawnAsyncHelper *helper = (FuCommonSpawnAsyncHelper *) user_data;
+	fu_common_spawn_async_set_error (helper,
+					 g_error_new (G_IO_ERROR,
+						      G_IO_ERROR_TIMED_OUT,
+						      "timed out after %ums",
+						      helper->timeout_ms));
+	g_subprocess_force_exit (helper->subprocess);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_common_spawn_async_read_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FuCommonSpawnAsyncHelper *helper = g_task_get_task_data (task);
+	GError *error = NULL;
+	g_autofree gchar *line = NULL;
+
+	line = g_data_input_stream_read_line_finish_utf8 (G_DATA_INPUT_STREAM (source),
+							  res, NULL, &error);
+	if (line == NULL) {
+		if (error != NULL)
+			fu_common_spawn_async_set_error (helper, error);
+		helper->eof = TRUE;
+		fu_common_spawn_async_maybe_complete (task);
+		return;
+	}
+	if (helper->handler_cb != NULL && line[0] != '\0')
+		helper->handler_cb (line, helper->handler_user_data);
+
+	/* get the next line */
+	g_data_input_stream_read_line_async (helper->stream,
+					     G_PRIORITY_DEFAULT,
+					     g_task_get_cancellable (task),
+					     fu_common_spawn_async_read_cb,
+					     g_object_ref (task));
+}
+
+static void
+fu_common_spawn_async_wait_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FuCommonSpawnAsyncHelper *helper = g_task_get_task_data (task);
+	GError *error = NULL;
+
+	if (!g_subprocess_wait_check_finish (G_SUBPROCESS (source), res, &error)) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_subprocess_force_exit (helper->subprocess);
+		fu_common_spawn_async_set_error (helper, error);
+	}
+	helper->exited = TRUE;
+	fu_common_spawn_async_maybe_complete (task);
+}
+
+/**
+ * fu_common_spawn_async:
+ * @argv: The argument list to run
+ * @handler_cb: (scope notified): A #FuOutputHandler or %NULL
+ * @handler_user_data: the user data to pass to @handler_cb
+ * @timeout_ms: a timeout in ms, or 0 for no limit
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Runs a subprocess without waiting for it to exit, so that several can be
+ * run at the same time. Any output on standard out or standard error will be
+ * forwarded to @handler_cb as whole lines while the process is running.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_common_spawn_async (const gchar * const *argv,
+		       FuOutputHandler handler_cb,
+		       gpointer handler_user_data,
+		       guint timeout_ms,
+		       GCancellable *cancellable,
+		       GAsyncReadyCallback callback,
+		       gpointer callback_data)
+{
+	FuCommonSpawnAsyncHelper *helper;
+	GError *error = NULL;
+	g_autoptr(GSubprocess) subprocess = NULL;
+	g_autoptr(GTask) task = NULL;
+	g_autofree gchar *argv_str = NULL;
+
+	g_return_if_fail (argv != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (NULL, cancellable, callback, callback_data);
+	g_task_set_source_tag (task, fu_common_spawn_async);
+
+	/* create subprocess */
+	argv_str = g_strjoinv (" ", (gchar **) argv);
+	g_debug ("running '%s'", argv_str);
+	subprocess = g_subprocess_newv (argv, G_SUBPROCESS_FLAGS_STDOUT_PIPE |
+					      G_SUBPROCESS_FLAGS_STDERR_MERGE, &error);
+	if (subprocess == NULL) {
+		g_task_return_error (task, error);
+		return;
+	}
+
+	/* watch for output and for the process to exit */
+	helper = g_new0 (FuCommonSpawnAsyncHelper, 1);
+	helper->handler_cb = handler_cb;
+	helper->handler_user_data = handler_user_data;
+	helper->subprocess = g_object_ref (subprocess);
+	helper->stream = g_data_input_stream_new (g_subprocess_get_stdout_pipe (subprocess));
+	helper->timeout_ms = timeout_ms;
+	g_task_set_task_data (task, helper, (GDestroyNotify) fu_common_spawn_async_helper_free);
+	if (timeout_ms > 0) {
+		helper->timeout_source = g_timeout_source_new (timeout_ms);
+		g_source_set_callback (helper->timeout_source,
+				       fu_common_spawn_async_timeout_cb,
+				       helper, NULL);
+		g_source_attach (helper->timeout_source,
+				 g_main_context_get_thread_default ());
+	}
+	g_data_input_stream_read_line_async (helper->stream,
+					     G_PRIORITY_DEFAULT,
+					     cancellable,
+					     fu_common_spawn_async_read_cb,
+					     g_object_ref (task));
+	g_subprocess_wait_check_async (subprocess, cancellable,
+				       fu_common_spawn_async_wait_cb,
+				       g_object_ref (task));
+}
+
+/**
+ * fu_common_spawn_finish:
+ * @res: a #GAsyncResult
+ * @error: A #GError or %NULL
+ *
+ * Gets the result of fu_common_spawn_async().
+ *
+ * Returns: %TRUE if the process exited successfully
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_common_spawn_finish (GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (g_task_is_valid (res, NULL), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 /**
  * fu_common_write_uint16:
  * @buf: A writable buffer
@@ -1411,6 +1801,37 @@ fu_common_string_append_kb (GString *str, guint idt, const gchar *key, gboolean
 	fu_common_string_append_kv (str, idt, key, value ? "true" : "false");
 }
 
+/* formatting a large buffer costs far more than the transfer it describes,
+ * so check first if either of the log handlers would print a debug message */
+static gboolean
+fu_common_dump_enabled (const gchar *log_domain)
+{
+	const gchar *domains;
+
+	/* FuDebug, as used by the daemon and fwupdtool */
+	domains = g_getenv ("FWUPD_VERBOSE");
+	if (domains != NULL) {
+		g_auto(GStrv) split = NULL;
+		if (g_strcmp0 (domains, "*") == 0 || log_domain == NULL)
+			return TRUE;
+		split = g_strsplit (domains, ",", -1);
+		if (g_strv_contains ((const gchar * const *) split, log_domain))
+			return TRUE;
+	}
+
+	/* the GLib default handler */
+	domains = g_getenv ("G_MESSAGES_DEBUG");
+	if (domains != NULL) {
+		g_auto(GStrv) split = NULL;
+		if (g_strcmp0 (domains, "all") == 0 || log_domain == NULL)
+			return TRUE;
+		split = g_strsplit_set (domains, " ,", -1);
+		if (g_strv_contains ((const gchar * const *) split, log_domain))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /**
  * fu_common_dump_full:
  * @log_domain: log domain, typically %G_LOG_DOMAIN or %NULL
@@ -1422,6 +1843,8 @@ fu_common_string_append_kb (GString *str, guint idt, const gchar *key, gboolean
  *
  * Dumps a raw buffer to the screen.
  *
+ * Nothing is formatted if debugging is not enabled for @log_domain.
+ *
  * Since: 1.2.4
  **/
 void
@@ -1432,7 +1855,12 @@ fu_common_dump_full (const gchar *log_domain,
 		     guint columns,
 		     FuDumpFlags flags)
 {
-	g_autoptr(GString) str = g_string_new (NULL);
+	g_autoptr(GString) str = NULL;
+
+	/* nobody is listening */
+	if (!fu_common_dump_enabled (log_domain))
+		return;
+	str = g_string_new (NULL);
 
 	/* optional */
 	if (title != NULL)
@@ -1570,16 +1998,99 @@ fu_common_bytes_align (GBytes *bytes, gsize blksz, gchar padval)
  *
  * Since: 1.2.6
  **/
+/* compares a word at a time, which the compiler can also vectorize */
+static gboolean
+fu_common_buf_is_filled (const guint8 *buf, gsize bufsz, guint8 value)
+{
+	const guint64 pattern = G_GUINT64_CONSTANT (0x0101010101010101) * value;
+	gsize i = 0;
+
+	for (; i + 4 * sizeof(guint64) <= bufsz; i += 4 * sizeof(guint64)) {
+		guint64 tmp[4];
+		memcpy (tmp, buf + i, sizeof(tmp));
+		if (((tmp[0] ^ pattern) | (tmp[1] ^ pattern) |
+		     (tmp[2] ^ pattern) | (tmp[3] ^ pattern)) != 0)
+			return FALSE;
+	}
+	for (; i < bufsz; i++) {
+		if (buf[i] != value)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 gboolean
 fu_common_bytes_is_empty (GBytes *bytes)
 {
 	gsize sz = 0;
 	const guint8 *buf = g_bytes_get_data (bytes, &sz);
-	for (gsize i = 0; i < sz; i++) {
-		if (buf[i] != 0xff)
-			return FALSE;
+	return fu_common_buf_is_filled (buf, sz, 0xff);
+}
+
+static void
+fu_common_bytes_find_runs_add (GPtrArray *runs, GBytes *bytes,
+			      gsize offset, gsize sz, gsize page_sz)
+{
+	FuChunk *chk;
+	g_autoptr(GBytes) blob = g_bytes_new_from_bytes (bytes, offset, sz);
+	chk = fu_chunk_bytes_new (blob);
+	fu_chunk_set_idx (chk, runs->len);
+	fu_chunk_set_page (chk, offset / page_sz);
+	fu_chunk_set_address (chk, offset);
+	g_ptr_array_add (runs, chk);
+}
+
+/**
+ * fu_common_bytes_find_runs:
+ * @bytes: a #GBytes
+ * @page_sz: page size in bytes, or 0 to treat @bytes as one page
+ * @erased_value: the value of an erased byte, typically 0xff
+ * @erased: %TRUE to return the erased ranges, %FALSE for the ranges with data
+ *
+ * Scans @bytes a page at a time, merging adjacent pages that are either
+ * all @erased_value or not into ranges.
+ *
+ * Each #FuChunk has the offset of the range set as the address and the
+ * page number of the first page, and refers to the data in @bytes rather
+ * than copying it.
+ *
+ * Return value: (transfer container) (element-type FuChunk): ranges
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fu_common_bytes_find_runs (GBytes *bytes,
+			   gsize page_sz,
+			   guint8 erased_value,
+			   gboolean erased)
+{
+	gsize bufsz = 0;
+	gsize run_start = G_MAXSIZE;
+	const guint8 *buf;
+	GPtrArray *runs;
+
+	g_return_val_if_fail (bytes != NULL, NULL);
+
+	runs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	buf = g_bytes_get_data (bytes, &bufsz);
+	if (page_sz == 0)
+		page_sz = MAX (bufsz, 1);
+	for (gsize offset = 0; offset < bufsz; offset += page_sz) {
+		gsize sz = MIN (page_sz, bufsz - offset);
+		if (fu_common_buf_is_filled (buf + offset, sz, erased_value) == erased) {
+			if (run_start == G_MAXSIZE)
+				run_start = offset;
+		} else if (run_start != G_MAXSIZE) {
+			fu_common_bytes_find_runs_add (runs, bytes, run_start,
+						       offset - run_start, page_sz);
+			run_start = G_MAXSIZE;
+		}
 	}
-	return TRUE;
+	if (run_start != G_MAXSIZE) {
+		fu_common_bytes_find_runs_add (runs, bytes, run_start,
+					       bufsz - run_start, page_sz);
+	}
+	return runs;
 }
 
 /**
@@ -2281,6 +2792,19 @@ fu_common_kernel_locked_down (void)
 #endif
 }
 
+#ifdef HAVE_CPUID_H
+/* basic leaves from 0x0, extended leaves from 0x80000000 */
+#define FU_COMMON_CPUID_LEAVES_MAX		0x20
+
+typedef struct {
+	guint32		 regs[4];
+	gboolean	 valid;
+} FuCommonCpuidLeaf;
+
+static FuCommonCpuidLeaf fu_common_cpuid_leaves[2][FU_COMMON_CPUID_LEAVES_MAX];
+G_LOCK_DEFINE_STATIC (fu_common_cpuid_leaves);
+#endif
+
 /**
  * fu_common_cpuid:
  * @leaf: The CPUID level, now called the 'leaf' by Intel
@@ -2290,7 +2814,9 @@ fu_common_kernel_locked_down (void)
  * @edx: (out) (nullable): EDX register
  * @error: A #GError or NULL
  *
- * Calls CPUID and returns the registers for the given leaf.
+ * Calls CPUID and returns the registers for the given leaf. The registers
+ * for the common leaves are cached, as CPUID traps to the hypervisor when
+ * running in a virtual machine.
  *
  * Return value: %TRUE if the registers are set.
  *
@@ -2305,6 +2831,7 @@ fu_common_cpuid (guint32 leaf,
 		 GError **error)
 {
 #ifdef HAVE_CPUID_H
+	FuCommonCpuidLeaf *item = NULL;
 	guint eax_tmp = 0;
 	guint ebx_tmp = 0;
 	guint ecx_tmp = 0;
@@ -2312,8 +2839,28 @@ fu_common_cpuid (guint32 leaf,
 
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* get vendor */
-	__get_cpuid_count (leaf, 0x0, &eax_tmp, &ebx_tmp, &ecx_tmp, &edx_tmp);
+	/* already queried */
+	if (leaf < FU_COMMON_CPUID_LEAVES_MAX)
+		item = &fu_common_cpuid_leaves[0][leaf];
+	else if (leaf >= 0x80000000 && leaf - 0x80000000 < FU_COMMON_CPUID_LEAVES_MAX)
+		item = &fu_common_cpuid_leaves[1][leaf - 0x80000000];
+	G_LOCK (fu_common_cpuid_leaves);
+	if (item != NULL && item->valid) {
+		eax_tmp = item->regs[0];
+		ebx_tmp = item->regs[1];
+		ecx_tmp = item->regs[2];
+		edx_tmp = item->regs[3];
+	} else {
+		__get_cpuid_count (leaf, 0x0, &eax_tmp, &ebx_tmp, &ecx_tmp, &edx_tmp);
+		if (item != NULL) {
+			item->regs[0] = eax_tmp;
+			item->regs[1] = ebx_tmp;
+			item->regs[2] = ecx_tmp;
+			item->regs[3] = edx_tmp;
+			item->valid = TRUE;
+		}
+	}
+	G_UNLOCK (fu_common_cpuid_leaves);
 	if (eax != NULL)
 		*eax = eax_tmp;
 	if (ebx != NULL)
@@ -2351,7 +2898,7 @@ fu_common_is_cpu_intel (void)
 /**
  * fu_common_get_cpu_vendor:
  *
- * Uses CPUID to discover the CPU vendor.
+ * Uses CPUID to discover the CPU vendor, which is only done once.
  *
  * Return value: a #FuCpuVendor, e.g. %FU_CPU_VENDOR_AMD if the vendor was AMD.
  *
@@ -2360,27 +2907,224 @@ fu_common_is_cpu_intel (void)
 FuCpuVendor
 fu_common_get_cpu_vendor (void)
 {
+	/* offset by one as zero means not yet set */
+	static gsize vendor_once = 0;
+
+	if (g_once_init_enter (&vendor_once)) {
+		FuCpuVendor vendor = FU_CPU_VENDOR_UNKNOWN;
 #ifdef HAVE_CPUID_H
-	guint ebx = 0;
-	guint ecx = 0;
-	guint edx = 0;
-
-	if (fu_common_cpuid (0x0, NULL, &ebx, &ecx, &edx, NULL)) {
-		if (ebx == signature_INTEL_ebx &&
-		    edx == signature_INTEL_edx &&
-		    ecx == signature_INTEL_ecx) {
-			return FU_CPU_VENDOR_INTEL;
+		guint ebx = 0;
+		guint ecx = 0;
+		guint edx = 0;
+
+		if (fu_common_cpuid (0x0, NULL, &ebx, &ecx, &edx, NULL)) {
+			if (ebx == signature_INTEL_ebx &&
+			    edx == signature_INTEL_edx &&
+			    ecx == signature_INTEL_ecx) {
+				vendor = FU_CPU_VENDOR_INTEL;
+			} else if (ebx == signature_AMD_ebx &&
+				   edx == signature_AMD_edx &&
+				   ecx == signature_AMD_ecx) {
+				vendor = FU_CPU_VENDOR_AMD;
+			}
 		}
-		if (ebx == signature_AMD_ebx &&
-		    edx == signature_AMD_edx &&
-		    ecx == signature_AMD_ecx) {
-			return FU_CPU_VENDOR_AMD;
+#endif
+		g_once_init_leave (&vendor_once, (gsize) vendor + 1);
+	}
+	return (FuCpuVendor) (vendor_once - 1);
+}
+
+/**
+ * fu_common_get_kernel_cmdline:
+ *
+ * Gets the tokens of the kernel command line, which cannot change while the
+ * system is running and so is only read the first time this is called.
+ *
+ * Returns: (transfer none): the non-empty tokens, or an empty list if unknown
+ *
+ * Since: 1.5.8
+ **/
+const gchar * const *
+fu_common_get_kernel_cmdline (void)
+{
+	static gsize tokens_once = 0;
+	static GStrv tokens = NULL;
+
+	if (g_once_init_enter (&tokens_once)) {
+		gsize bufsz = 0;
+		g_autofree gchar *buf = NULL;
+		g_autoptr(GPtrArray) array = g_ptr_array_new ();
+		if (g_file_get_contents ("/proc/cmdline", &buf, &bufsz, NULL) && bufsz > 0) {
+			g_auto(GStrv) split = fu_common_strnsplit (buf, bufsz - 1, " ", -1);
+			for (guint i = 0; split[i] != NULL; i++) {
+				if (split[i][0] == '\0')
+					continue;
+				g_ptr_array_add (array, g_strdup (split[i]));
+			}
 		}
+		g_ptr_array_add (array, NULL);
+		tokens = (GStrv) g_ptr_array_free (g_steal_pointer (&array), FALSE);
+		g_once_init_leave (&tokens_once, 1);
 	}
-#endif
+	return (const gchar * const *) tokens;
+}
 
-	/* failed */
-	return FU_CPU_VENDOR_UNKNOWN;
+/* the total time skipped by fu_common_sleep_us() using the virtual clock */
+static gint64 fu_common_clock_skipped = 0;
+G_LOCK_DEFINE_STATIC (fu_common_clock);
+
+/**
+ * fu_common_sleep_us:
+ * @delay_us: the delay in microseconds
+ *
+ * Sleeps for the given time, in the same way as g_usleep().
+ *
+ * If `FWUPD_VIRTUAL_CLOCK` is set then this returns immediately, and the time
+ * is instead added to the value returned by fu_common_get_monotonic_time().
+ * This allows the self tests and transcript replays to run without waiting
+ * for hardware that is not present.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_common_sleep_us (gulong delay_us)
+{
+	if (g_getenv ("FWUPD_VIRTUAL_CLOCK") == NULL) {
+		g_usleep (delay_us);
+		return;
+	}
+	G_LOCK (fu_common_clock);
+	fu_common_clock_skipped += delay_us;
+	G_UNLOCK (fu_common_clock);
+}
+
+/**
+ * fu_common_get_monotonic_time:
+ *
+ * Gets the monotonic time in microseconds, including any time skipped by
+ * fu_common_sleep_us(). Use g_get_monotonic_time() to measure just the time
+ * actually spent.
+ *
+ * Returns: microseconds
+ *
+ * Since: 1.5.8
+ **/
+gint64
+fu_common_get_monotonic_time (void)
+{
+	gint64 skipped;
+	G_LOCK (fu_common_clock);
+	skipped = fu_common_clock_skipped;
+	G_UNLOCK (fu_common_clock);
+	return g_get_monotonic_time () + skipped;
+}
+
+/* key is the full filename as the tables directory is set in the self tests */
+static GHashTable *fu_common_acpi_tables = NULL;	/* filename : GBytes */
+G_LOCK_DEFINE_STATIC (fu_common_acpi_tables);
+
+#define FU_COMMON_ACPI_TABLE_HEADER_SIZE	0x24
+
+static GBytes *
+fu_common_acpi_table_load (const gchar *fn, GError **error)
+{
+	guint8 checksum = 0;
+	guint32 length = 0;
+	gsize bufsz = 0;
+	const guint8 *buf;
+	g_autoptr(GBytes) blob = NULL;
+
+	/* sysfs does not support mapping the tables, but a copy might */
+	blob = fu_common_get_contents_mapped (fn, NULL);
+	if (blob == NULL || g_bytes_get_size (blob) == 0) {
+		g_clear_pointer (&blob, g_bytes_unref);
+		blob = fu_common_get_contents_bytes (fn, error);
+		if (blob == NULL)
+			return NULL;
+	}
+	buf = g_bytes_get_data (blob, &bufsz);
+	if (bufsz < FU_COMMON_ACPI_TABLE_HEADER_SIZE) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "ACPI table too small, got 0x%x bytes",
+			     (guint) bufsz);
+		return NULL;
+	}
+	if (!fu_common_read_uint32_safe (buf, bufsz, 0x4, &length, G_LITTLE_ENDIAN, error))
+		return NULL;
+	if (length < FU_COMMON_ACPI_TABLE_HEADER_SIZE || length > bufsz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "ACPI table length 0x%x invalid for 0x%x bytes",
+			     length, (guint) bufsz);
+		return NULL;
+	}
+
+	/* all the bytes of the table sum to zero */
+	for (guint32 i = 0; i < length; i++)
+		checksum += buf[i];
+	if (checksum != 0x0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "ACPI table checksum invalid, got 0x%02x",
+			     checksum);
+		return NULL;
+	}
+	if (length == bufsz)
+		return g_steal_pointer (&blob);
+	return fu_common_bytes_new_offset (blob, 0x0, length, error);
+}
+
+/**
+ * fu_common_get_acpi_table:
+ * @signature: A table signature, e.g. `DMAR`
+ * @error: A #GError or NULL
+ *
+ * Gets an ACPI table, which is only read and checksummed the first time it is
+ * requested and then shared by all plugins.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL for error
+ *
+ * Since: 1.5.8
+ **/
+GBytes *
+fu_common_get_acpi_table (const gchar *signature, GError **error)
+{
+	GBytes *blob;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *path = NULL;
+	g_autoptr(GBytes) blob_new = NULL;
+
+	g_return_val_if_fail (signature != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	path = fu_common_get_path (FU_PATH_KIND_ACPI_TABLES);
+	fn = g_build_filename (path, signature, NULL);
+	G_LOCK (fu_common_acpi_tables);
+	if (fu_common_acpi_tables == NULL) {
+		fu_common_acpi_tables = g_hash_table_new_full (g_str_hash, g_str_equal,
+								g_free,
+								(GDestroyNotify) g_bytes_unref);
+	}
+	blob = g_hash_table_lookup (fu_common_acpi_tables, fn);
+	if (blob != NULL) {
+		G_UNLOCK (fu_common_acpi_tables);
+		return g_bytes_ref (blob);
+	}
+	blob_new = fu_common_acpi_table_load (fn, error);
+	if (blob_new == NULL) {
+		G_UNLOCK (fu_common_acpi_tables);
+		g_prefix_error (error, "failed to load %s: ", fn);
+		return NULL;
+	}
+	g_hash_table_insert (fu_common_acpi_tables,
+			     g_steal_pointer (&fn),
+			     g_bytes_ref (blob_new));
+	G_UNLOCK (fu_common_acpi_tables);
+	return g_steal_pointer (&blob_new);
 }
 
 /**
@@ -2395,9 +3139,7 @@ fu_common_get_cpu_vendor (void)
 gboolean
 fu_common_is_live_media (void)
 {
-	gsize bufsz = 0;
-	g_autofree gchar *buf = NULL;
-	g_auto(GStrv) tokens = NULL;
+	const gchar * const *tokens = fu_common_get_kernel_cmdline ();
 	const gchar *args[] = {
 		"rd.live.image",
 		"boot=live",
@@ -2405,13 +3147,8 @@ fu_common_is_live_media (void)
 	};
 	if (g_file_test ("/cdrom/.disk/info", G_FILE_TEST_EXISTS))
 		return TRUE;
-	if (!g_file_get_contents ("/proc/cmdline", &buf, &bufsz, NULL))
-		return FALSE;
-	if (bufsz == 0)
-		return FALSE;
-	tokens = fu_common_strnsplit (buf, bufsz - 1, " ", -1);
 	for (guint i = 0; args[i] != NULL; i++) {
-		if (g_strv_contains ((const gchar * const *) tokens, args[i]))
+		if (g_strv_contains (tokens, args[i]))
 			return TRUE;
 	}
 	return FALSE;
@@ -2439,65 +3176,83 @@ fu_common_get_memory_size (void)
 #endif
 }
 
-static GPtrArray *
-fu_common_get_block_devices (GError **error)
-{
-	GVariantBuilder builder;
-	const gchar *obj;
-	g_autoptr(GVariant) output = NULL;
-	g_autoptr(GDBusProxy) proxy = NULL;
-	g_autoptr(GPtrArray) devices = NULL;
-	g_autoptr(GVariantIter) iter = NULL;
-	g_autoptr(GDBusConnection) connection = NULL;
-
-	connection = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, error);
-	if (connection == NULL) {
-		g_prefix_error (error, "failed to get system bus: ");
-		return NULL;
-	}
-	proxy = g_dbus_proxy_new_sync (connection,
-				       G_DBUS_PROXY_FLAGS_NONE, NULL,
-				       UDISKS_DBUS_SERVICE,
-				       UDISKS_DBUS_PATH,
-				       UDISKS_DBUS_MANAGER_INTERFACE,
-				       NULL, error);
-	if (proxy == NULL) {
+/* created on first use, then kept up to date by the InterfacesAdded and
+ * InterfacesRemoved signals rather than enumerating each time */
+G_LOCK_DEFINE_STATIC (udisks_manager);
+static GDBusObjectManager *udisks_manager = NULL;
+
+static GDBusObjectManager *
+fu_common_get_udisks_manager (GError **error)
+{
+	g_autoptr(GDBusObjectManager) manager = NULL;
+	g_autofree gchar *name_owner = NULL;
+
+	G_LOCK (udisks_manager);
+	if (udisks_manager != NULL) {
+		manager = g_object_ref (udisks_manager);
+		G_UNLOCK (udisks_manager);
+		return g_steal_pointer (&manager);
+	}
+
+	/* deliver signals to the default context, as callers may be
+	 * running from a short-lived thread */
+	g_main_context_push_thread_default (NULL);
+	manager = g_dbus_object_manager_client_new_for_bus_sync (G_BUS_TYPE_SYSTEM,
+								 G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+								 UDISKS_DBUS_SERVICE,
+								 UDISKS_DBUS_PATH_ROOT,
+								 NULL, NULL, NULL,
+								 NULL, error);
+	g_main_context_pop_thread_default (NULL);
+	if (manager == NULL) {
+		G_UNLOCK (udisks_manager);
 		g_prefix_error (error, "failed to find %s: ", UDISKS_DBUS_SERVICE);
 		return NULL;
 	}
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
-	output =  g_dbus_proxy_call_sync (proxy,
-					  "GetBlockDevices",
-					  g_variant_new ("(a{sv})", &builder),
-					  G_DBUS_CALL_FLAGS_NONE,
-					  -1, NULL, error);
-	if (output == NULL) {
-		if (error != NULL)
-			g_dbus_error_strip_remote_error (*error);
-		g_prefix_error (error, "failed to call %s.%s(): ",
-				UDISKS_DBUS_SERVICE,
-				"GetBlockDevices");
+	name_owner = g_dbus_object_manager_client_get_name_owner (G_DBUS_OBJECT_MANAGER_CLIENT (manager));
+	if (name_owner == NULL) {
+		G_UNLOCK (udisks_manager);
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "failed to find %s: not running",
+			     UDISKS_DBUS_SERVICE);
 		return NULL;
 	}
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	g_variant_get (output, "(ao)", &iter);
-	while (g_variant_iter_next (iter, "&o", &obj)) {
-		g_autoptr(GDBusProxy) proxy_blk = NULL;
-		proxy_blk = g_dbus_proxy_new_sync (connection,
-						   G_DBUS_PROXY_FLAGS_NONE, NULL,
-						   UDISKS_DBUS_SERVICE,
-						   obj,
-						   UDISKS_DBUS_INTERFACE_BLOCK,
-						   NULL, error);
-		if (proxy_blk == NULL) {
-			g_prefix_error (error, "failed to initialize d-bus proxy for %s: ", obj);
-			return NULL;
-		}
-		g_ptr_array_add (devices, g_steal_pointer (&proxy_blk));
-	}
+	udisks_manager = g_object_ref (manager);
+	G_UNLOCK (udisks_manager);
+	return g_steal_pointer (&manager);
+}
 
+static GDBusProxy *
+fu_common_get_udisks_proxy (GDBusObjectManager *manager,
+			    const gchar *object_path,
+			    const gchar *interface_name)
+{
+	GDBusInterface *iface;
+	iface = g_dbus_object_manager_get_interface (manager, object_path, interface_name);
+	if (iface == NULL)
+		return NULL;
+	return G_DBUS_PROXY (iface);
+}
 
-	return g_steal_pointer (&devices);
+static GPtrArray *
+fu_common_get_block_devices (GDBusObjectManager *manager)
+{
+	GPtrArray *devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	GList *objects = g_dbus_object_manager_get_objects (manager);
+
+	for (GList *l = objects; l != NULL; l = l->next) {
+		GDBusObject *obj = G_DBUS_OBJECT (l->data);
+		GDBusProxy *proxy_blk;
+		proxy_blk = fu_common_get_udisks_proxy (manager,
+							g_dbus_object_get_object_path (obj),
+							UDISKS_DBUS_INTERFACE_BLOCK);
+		if (proxy_blk != NULL)
+			g_ptr_array_add (devices, proxy_blk);
+	}
+	g_list_free_full (objects, g_object_unref);
+	return devices;
 }
 
 static const gchar *
@@ -2532,50 +3287,41 @@ fu_common_convert_to_gpt_type (const gchar *type)
 GPtrArray *
 fu_common_get_volumes_by_kind (const gchar *kind, GError **error)
 {
+	g_autoptr(GDBusObjectManager) manager = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) volumes = NULL;
 
 	g_return_val_if_fail (kind != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	devices = fu_common_get_block_devices (error);
-	if (devices == NULL)
+	manager = fu_common_get_udisks_manager (error);
+	if (manager == NULL)
 		return NULL;
+	devices = fu_common_get_block_devices (manager);
 	volumes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (guint i = 0; i < devices->len; i++) {
 		GDBusProxy *proxy_blk = g_ptr_array_index (devices, i);
+		const gchar *object_path = g_dbus_proxy_get_object_path (proxy_blk);
 		const gchar *type_str;
 		g_autoptr(FuVolume) vol = NULL;
 		g_autoptr(GDBusProxy) proxy_part = NULL;
 		g_autoptr(GDBusProxy) proxy_fs = NULL;
 		g_autoptr(GVariant) val = NULL;
 
-		proxy_part = g_dbus_proxy_new_sync (g_dbus_proxy_get_connection (proxy_blk),
-						    G_DBUS_PROXY_FLAGS_NONE, NULL,
-						    UDISKS_DBUS_SERVICE,
-						    g_dbus_proxy_get_object_path (proxy_blk),
-						    UDISKS_DBUS_INTERFACE_PARTITION,
-						    NULL, error);
-		if (proxy_part == NULL) {
-			g_prefix_error (error, "failed to initialize d-bus proxy %s: ",
-					g_dbus_proxy_get_object_path (proxy_blk));
-			return NULL;
-		}
+		proxy_part = fu_common_get_udisks_proxy (manager, object_path,
+							 UDISKS_DBUS_INTERFACE_PARTITION);
+		if (proxy_part == NULL)
+			continue;
 		val = g_dbus_proxy_get_cached_property (proxy_part, "Type");
 		if (val == NULL)
 			continue;
 
 		g_variant_get (val, "&s", &type_str);
-		proxy_fs = g_dbus_proxy_new_sync (g_dbus_proxy_get_connection (proxy_blk),
-						  G_DBUS_PROXY_FLAGS_NONE, NULL,
-						  UDISKS_DBUS_SERVICE,
-						  g_dbus_proxy_get_object_path (proxy_blk),
-						  UDISKS_DBUS_INTERFACE_FILESYSTEM,
-						  NULL, error);
+		proxy_fs = fu_common_get_udisks_proxy (manager, object_path,
+						       UDISKS_DBUS_INTERFACE_FILESYSTEM);
 		if (proxy_fs == NULL) {
-			g_prefix_error (error, "failed to initialize d-bus proxy %s: ",
-					g_dbus_proxy_get_object_path (proxy_blk));
-			return NULL;
+			g_debug ("device %s has no filesystem", object_path);
+			continue;
 		}
 		vol = g_object_new (FU_TYPE_VOLUME,
 				    "proxy-block", proxy_blk,
@@ -2585,7 +3331,7 @@ fu_common_get_volumes_by_kind (const gchar *kind, GError **error)
 		/* convert MBR type to GPT type */
 		type_str = fu_common_convert_to_gpt_type (type_str);
 		g_debug ("device %s, type: %s, internal: %d, fs: %s",
-			 g_dbus_proxy_get_object_path (proxy_blk), type_str,
+			 object_path, type_str,
 			 fu_volume_is_internal (vol),
 			 fu_volume_get_id_type (vol));
 		if (g_strcmp0 (type_str, kind) != 0)
@@ -2616,15 +3362,17 @@ fu_common_get_volumes_by_kind (const gchar *kind, GError **error)
 FuVolume *
 fu_common_get_volume_by_device (const gchar *device, GError **error)
 {
+	g_autoptr(GDBusObjectManager) manager = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 
 	g_return_val_if_fail (device != NULL, NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
 	/* find matching block device */
-	devices = fu_common_get_block_devices (error);
-	if (devices == NULL)
+	manager = fu_common_get_udisks_manager (error);
+	if (manager == NULL)
 		return NULL;
+	devices = fu_common_get_block_devices (manager);
 	for (guint i = 0; i < devices->len; i++) {
 		GDBusProxy *proxy_blk = g_ptr_array_index (devices, i);
 		g_autoptr(GVariant) val = NULL;
@@ -2661,14 +3409,16 @@ fu_common_get_volume_by_device (const gchar *device, GError **error)
 FuVolume *
 fu_common_get_volume_by_devnum (guint32 devnum, GError **error)
 {
+	g_autoptr(GDBusObjectManager) manager = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
 	/* find matching block device */
-	devices = fu_common_get_block_devices (error);
-	if (devices == NULL)
+	manager = fu_common_get_udisks_manager (error);
+	if (manager == NULL)
 		return NULL;
+	devices = fu_common_get_block_devices (manager);
 	for (guint i = 0; i < devices->len; i++) {
 		GDBusProxy *proxy_blk = g_ptr_array_index (devices, i);
 		g_autoptr(GVariant) val = NULL;
@@ -2822,6 +3572,46 @@ fu_common_get_esp_for_path (const gchar *esp_path, GError **error)
 	return NULL;
 }
 
+/* lookup tables for the common polynomials, built on first use */
+typedef struct {
+	guint8		 crc8[256];
+	guint16		 crc16[256];
+	guint32		 crc32[8][256];
+} FuCommonCrcTables;
+
+static const FuCommonCrcTables *
+fu_common_crc_get_tables (void)
+{
+	static gsize tables_init = 0;
+	static FuCommonCrcTables tables;
+
+	if (g_once_init_enter (&tables_init)) {
+		for (guint i = 0; i < 256; i++) {
+			guint8 crc8 = (guint8) i;
+			guint16 crc16 = (guint16) i;
+			guint32 crc32 = i;
+			for (guint j = 0; j < 8; j++) {
+				crc8 = (crc8 & 0x80) ? (crc8 << 1) ^ 0x07 : crc8 << 1;
+				crc16 = (crc16 & 0x1) ? (crc16 >> 1) ^ 0xa001 : crc16 >> 1;
+				crc32 = (crc32 >> 1) ^ (0xEDB88320 & -(crc32 & 1));
+			}
+			tables.crc8[i] = crc8;
+			tables.crc16[i] = crc16;
+			tables.crc32[0][i] = crc32;
+		}
+
+		/* for slicing-by-8 */
+		for (guint i = 0; i < 256; i++) {
+			for (guint k = 1; k < 8; k++) {
+				guint32 tmp = tables.crc32[k - 1][i];
+				tables.crc32[k][i] = (tmp >> 8) ^ tables.crc32[0][tmp & 0xff];
+			}
+		}
+		g_once_init_leave (&tables_init, 1);
+	}
+	return &tables;
+}
+
 /**
  * fu_common_crc8:
  * @buf: memory buffer
@@ -2836,16 +3626,11 @@ fu_common_get_esp_for_path (const gchar *esp_path, GError **error)
 guint8
 fu_common_crc8 (const guint8 *buf, gsize bufsz)
 {
-	guint32 crc = 0;
-	for (gsize j = bufsz; j > 0; j--) {
-		crc ^= (*(buf++) << 8);
-		for (guint32 i = 8; i; i--) {
-			if (crc & 0x8000)
-				crc ^= (0x1070 << 3);
-			crc <<= 1;
-		}
-	}
-	return ~((guint8) (crc >> 8));
+	const FuCommonCrcTables *tables = fu_common_crc_get_tables ();
+	guint8 crc = 0;
+	for (gsize i = 0; i < bufsz; i++)
+		crc = tables->crc8[crc ^ buf[i]];
+	return ~crc;
 }
 
 /**
@@ -2862,20 +3647,43 @@ fu_common_crc8 (const guint8 *buf, gsize bufsz)
 guint16
 fu_common_crc16 (const guint8 *buf, gsize bufsz)
 {
+	const FuCommonCrcTables *tables = fu_common_crc_get_tables ();
 	guint16 crc = 0xffff;
-	for (gsize len = bufsz; len > 0; len--) {
-		crc = (guint16) (crc ^ (*buf++));
-		for (guint8 i = 0; i < 8; i++) {
-			if (crc & 0x1) {
-				crc = (crc >> 1) ^ 0xa001;
-			} else {
-				crc >>= 1;
-			}
-		}
-	}
+	for (gsize i = 0; i < bufsz; i++)
+		crc = (crc >> 8) ^ tables->crc16[(crc ^ buf[i]) & 0xff];
 	return ~crc;
 }
 
+/* process 8 bytes per iteration using the pre-computed tables */
+static guint32
+fu_common_crc32_slice8 (const guint8 *buf, gsize bufsz, guint32 crc)
+{
+	const FuCommonCrcTables *tables = fu_common_crc_get_tables ();
+	const guint32 (*t)[256] = tables->crc32;
+
+	for (; bufsz >= 8; bufsz -= 8, buf += 8) {
+		guint32 one = crc ^ ((guint32) buf[0] |
+				     (guint32) buf[1] << 8 |
+				     (guint32) buf[2] << 16 |
+				     (guint32) buf[3] << 24);
+		guint32 two = (guint32) buf[4] |
+			      (guint32) buf[5] << 8 |
+			      (guint32) buf[6] << 16 |
+			      (guint32) buf[7] << 24;
+		crc = t[7][one & 0xff] ^
+		      t[6][(one >> 8) & 0xff] ^
+		      t[5][(one >> 16) & 0xff] ^
+		      t[4][one >> 24] ^
+		      t[3][two & 0xff] ^
+		      t[2][(two >> 8) & 0xff] ^
+		      t[1][(two >> 16) & 0xff] ^
+		      t[0][two >> 24];
+	}
+	for (gsize i = 0; i < bufsz; i++)
+		crc = (crc >> 8) ^ t[0][(crc ^ buf[i]) & 0xff];
+	return crc;
+}
+
 /**
  * fu_common_crc32_full:
  * @buf: memory buffer
@@ -2885,6 +3693,9 @@ fu_common_crc16 (const guint8 *buf, gsize bufsz)
  *
  * Returns the cyclic redundancy check value for the given memory buffer.
  *
+ * The CRC can be calculated incrementally by passing the inverted value
+ * returned from a previous call as the initial @crc value.
+ *
  * Returns: CRC value
  *
  * Since: 1.5.0
@@ -2892,6 +3703,10 @@ fu_common_crc16 (const guint8 *buf, gsize bufsz)
 guint32
 fu_common_crc32_full (const guint8 *buf, gsize bufsz, guint32 crc, guint32 polynomial)
 {
+	/* use lookup tables for the common case */
+	if (polynomial == 0xEDB88320)
+		return ~fu_common_crc32_slice8 (buf, bufsz, crc);
+
 	for (guint32 idx = 0; idx < bufsz; idx++) {
 		guint8 data = *buf++;
 		crc = crc ^ data;
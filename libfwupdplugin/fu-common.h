@@ -110,6 +110,16 @@ gboolean	 fu_common_spawn_sync		(const gchar * const *argv,
 						 GCancellable	*cancellable,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+void		 fu_common_spawn_async		(const gchar * const *argv,
+						 FuOutputHandler handler_cb,
+						 gpointer	 handler_user_data,
+						 guint		 timeout_ms,
+						 GCancellable	*cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer	 callback_data);
+gboolean	 fu_common_spawn_finish		(GAsyncResult	*res,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 
 gchar		*fu_common_get_path		(FuPathKind	 path_kind);
 gchar		*fu_common_realpath		(const gchar	*filename,
@@ -137,6 +147,9 @@ gboolean	 fu_common_set_contents_bytes	(const gchar	*filename,
 GBytes		*fu_common_get_contents_bytes	(const gchar	*filename,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+GBytes		*fu_common_get_contents_mapped	(const gchar	*filename,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 GBytes		*fu_common_get_contents_fd	(gint		 fd,
 						 gsize		 count,
 						 GError		**error)
@@ -173,6 +186,10 @@ GBytes		*fu_common_bytes_align		(GBytes		*bytes,
 						 gsize		 blksz,
 						 gchar		 padval);
 gboolean	 fu_common_bytes_is_empty	(GBytes		*bytes);
+GPtrArray	*fu_common_bytes_find_runs	(GBytes		*bytes,
+						 gsize		 page_sz,
+						 guint8		 erased_value,
+						 gboolean	 erased);
 gboolean	 fu_common_bytes_compare	(GBytes		*bytes1,
 						 GBytes		*bytes2,
 						 GError		**error)
@@ -286,7 +303,13 @@ gboolean	 fu_common_is_cpu_intel		(void)
 G_DEPRECATED_FOR(fu_common_get_cpu_vendor);
 FuCpuVendor	 fu_common_get_cpu_vendor	(void);
 gboolean	 fu_common_is_live_media	(void);
+const gchar * const *fu_common_get_kernel_cmdline (void);
+void		 fu_common_sleep_us		(gulong		 delay_us);
+gint64		 fu_common_get_monotonic_time	(void);
 guint64		 fu_common_get_memory_size	(void);
+GBytes		*fu_common_get_acpi_table	(const gchar	*signature,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 GPtrArray	*fu_common_get_volumes_by_kind	(const gchar	*kind,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
@@ -54,3 +54,12 @@
  * need to be handled as a capsule update.
  */
 #define FU_DEVICE_METADATA_UEFI_CAPSULE_FLAGS	"UefiCapsuleFlags"
+
+/**
+ * FU_DEVICE_METADATA_UPDATE_CHECKSUM:
+ *
+ * The expected checksum of the payload that is being written to the device.
+ * Set by the daemon for the duration of the update, and verified when the
+ * payload is streamed to a device that implements the write_stream vfunc.
+ */
+#define FU_DEVICE_METADATA_UPDATE_CHECKSUM	"UpdateChecksum"
@@ -34,3 +34,21 @@ gchar		*fu_device_get_guids_as_str		(FuDevice	*self);
 GPtrArray	*fu_device_get_possible_plugins		(FuDevice	*self);
 void		 fu_device_add_possible_plugin		(FuDevice	*self,
 							 const gchar	*plugin);
+void		 fu_device_transcript_record		(FuDevice	*self,
+							 const gchar	*id,
+							 const guint8	*buf,
+							 gsize		 bufsz);
+gboolean	 fu_device_transcript_is_replay		(FuDevice	*self);
+gboolean	 fu_device_transcript_replay_write	(FuDevice	*self,
+							 const gchar	*id,
+							 const guint8	*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_device_transcript_replay_read	(FuDevice	*self,
+							 const gchar	*id,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 gsize		*actual_len,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
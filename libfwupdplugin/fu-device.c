@@ -12,16 +12,23 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include "fu-checksum-converter.h"
+#include "fu-chunk.h"
 #include "fu-common.h"
+#include "fu-common-guid.h"
 #include "fu-common-version.h"
+#include "fu-device-metadata.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
 
-#include "fwupd-common.h"
+#include "fwupd-common-private.h"
 #include "fwupd-device-private.h"
 
 #define FU_DEVICE_RETRY_OPEN_COUNT			5
 #define FU_DEVICE_RETRY_OPEN_DELAY			500 /* ms */
+#define FU_DEVICE_POLL_BACKOFF_MAX			8
+#define FU_DEVICE_TRACE_ITEMS_MAX			32
+#define FU_DEVICE_TRACE_SIZE_MAX			256 /* bytes */
 
 /**
  * SECTION:fu-device
@@ -44,28 +51,63 @@ typedef struct {
 	FuDevice			*alternate;
 	FuDevice			*proxy;		/* noref */
 	FuQuirks			*quirks;
+	GHashTable			*firmware_cache;	/* (nullable) */
 	GHashTable			*metadata;	/* (nullable) */
 	GRWLock				 metadata_mutex;
 	GPtrArray			*parent_guids;
 	GRWLock				 parent_guids_mutex;
 	guint				 remove_delay;	/* ms */
 	guint				 progress;
+	gsize				 progress_done;
+	gsize				 progress_total;
+	gint64				 progress_start;	/* monotonic */
 	gint				 order;
 	guint				 priority;
 	guint				 poll_id;
+	guint				 poll_interval;	/* ms */
+	guint				 poll_backoff;
+	guint				 poll_notify_cnt;
+	gulong				 poll_notify_id;
+	guint64				 poll_wakeups;
 	gboolean			 done_probe;
 	gboolean			 done_setup;
 	gboolean			 device_id_valid;
 	guint64				 size_min;
 	guint64				 size_max;
+	guint32				 block_size;
+	GPtrArray			*dirty_chunks;	/* (nullable) (element-type FuChunk) */
+	guint64				 bytes_written;
 	gint				 open_refcount;	/* atomic */
 	GType				 specialized_gtype;
 	GPtrArray			*possible_plugins;
 	GPtrArray			*retry_recs;	/* of FuDeviceRetryRecovery */
 	guint				 retry_delay;
+	guint				 retry_delay_learned;	/* ms */
+	guint64				 retry_cnt;
 	FuDeviceInternalFlags		 internal_flags;
+	GPtrArray			*trace;		/* (nullable) (element-type FuDeviceTraceItem) */
+	guint				 trace_idx;
+	GPtrArray			*transcript;	/* (nullable) (element-type FuDeviceTranscriptItem) */
+	guint				 transcript_idx;
+	gint64				 transcript_last;	/* monotonic */
+	gdouble				 transcript_speed;
+	gchar				*transcript_dir;	/* (nullable) */
+	gboolean			 transcript_replay;
 } FuDevicePrivate;
 
+typedef struct {
+	const gchar			*title;
+	gint64				 timestamp;	/* monotonic */
+	gsize				 bufsz;		/* before truncation */
+	GBytes				*blob;
+} FuDeviceTraceItem;
+
+typedef struct {
+	gchar				*id;
+	gint64				 delta;		/* us since the previous item */
+	GBytes				*blob;
+} FuDeviceTranscriptItem;
+
 typedef struct {
 	GQuark				 domain;
 	gint				 code;
@@ -86,6 +128,9 @@ enum {
 G_DEFINE_TYPE_WITH_PRIVATE (FuDevice, fu_device, FWUPD_TYPE_DEVICE)
 #define GET_PRIVATE(o) (fu_device_get_instance_private (o))
 
+/* the firmware cache may be shared by devices updated from other threads */
+G_LOCK_DEFINE_STATIC (firmware_cache);
+
 static void
 fu_device_get_property (GObject *object, guint prop_id,
 			GValue *value, GParamSpec *pspec)
@@ -178,6 +223,10 @@ fu_device_internal_flag_to_string (FuDeviceInternalFlags flag)
 		return "retry-open";
 	if (flag == FU_DEVICE_INTERNAL_FLAG_REPLUG_MATCH_GUID)
 		return "replug-match-guid";
+	if (flag == FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED)
+		return "skip-unchanged";
+	if (flag == FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF)
+		return "retry-backoff";
 	return NULL;
 }
 
@@ -210,6 +259,10 @@ fu_device_internal_flag_from_string (const gchar *flag)
 		return FU_DEVICE_INTERNAL_FLAG_ENSURE_SEMVER;
 	if (g_strcmp0 (flag, "retry-open") == 0)
 		return FU_DEVICE_INTERNAL_FLAG_RETRY_OPEN;
+	if (g_strcmp0 (flag, "skip-unchanged") == 0)
+		return FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED;
+	if (g_strcmp0 (flag, "retry-backoff") == 0)
+		return FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF;
 	return FU_DEVICE_INTERNAL_FLAG_UNKNOWN;
 }
 
@@ -361,6 +414,80 @@ fu_device_retry_set_delay (FuDevice *self, guint delay)
 	priv->retry_delay = delay;
 }
 
+/**
+ * fu_device_set_retry_delay_learned:
+ * @self: A #FuDevice
+ * @delay: delay in ms, or 0 for unknown
+ *
+ * Sets the delay that previously allowed a retry to succeed, typically
+ * loaded from the history database for other devices of the same model.
+ *
+ * This is only used when %FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF is set.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_device_set_retry_delay_learned (FuDevice *self, guint delay)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->retry_delay_learned = delay;
+}
+
+/**
+ * fu_device_get_retry_delay_learned:
+ * @self: A #FuDevice
+ *
+ * Gets the typical delay that allowed a retry to succeed.
+ *
+ * Returns: delay in ms, or 0 if never learned
+ *
+ * Since: 1.5.8
+ **/
+guint
+fu_device_get_retry_delay_learned (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->retry_delay_learned;
+}
+
+/**
+ * fu_device_get_retry_count:
+ * @self: A #FuDevice
+ *
+ * Gets the number of times a function called using fu_device_retry() has
+ * failed and been retried, which is useful to find devices that waste time.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.8
+ **/
+guint64
+fu_device_get_retry_count (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->retry_cnt;
+}
+
+/* start short, double on each failure up to @delay and add some jitter so
+ * that devices sharing a bus do not retry in lockstep */
+static guint
+fu_device_retry_get_backoff_delay (FuDevice *self, guint delay, guint try)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint64 tmp;
+
+	if (priv->retry_delay_learned > 0)
+		tmp = MAX (priv->retry_delay_learned / 2, 1);
+	else
+		tmp = MAX (delay / 8, 1);
+	tmp <<= MIN (try - 1, 16);
+	tmp = MIN (tmp, delay);
+	return g_random_int_range (tmp - tmp / 4, tmp + 1);
+}
+
 /**
  * fu_device_retry_full:
  * @self: A #FuDevice
@@ -379,6 +506,10 @@ fu_device_retry_set_delay (FuDevice *self, guint delay)
  * If the reset function returns %FALSE, then the function returns straight away
  * without processing any pending retries.
  *
+ * If %FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF is set then @delay is used as the
+ * maximum delay, with the first retry being much quicker. The delay that
+ * allowed the function to succeed is remembered for the next call.
+ *
  * Since: 1.5.5
  **/
 gboolean
@@ -390,22 +521,35 @@ fu_device_retry_full (FuDevice *self,
 		      GError **error)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gboolean backoff;
+	guint delay_try = 0;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (func != NULL, FALSE);
 	g_return_val_if_fail (count >= 1, FALSE);
 	g_return_val_if_fail (error != NULL, FALSE);
 
+	backoff = delay > 0 &&
+		  fu_device_has_internal_flag (self, FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF);
 	for (guint i = 0; ; i++) {
 		g_autoptr(GError) error_local =	NULL;
 
 		/* delay */
-		if (i > 0 && delay > 0)
-			g_usleep (delay * 1000);
+		if (i > 0 && delay > 0) {
+			delay_try = backoff ? fu_device_retry_get_backoff_delay (self, delay, i) : delay;
+			fu_common_sleep_us (delay_try * 1000);
+		}
 
 		/* run function, if success return success */
-		if (func (self, user_data, &error_local))
+		if (func (self, user_data, &error_local)) {
+			if (backoff && i > 0) {
+				if (priv->retry_delay_learned == 0)
+					priv->retry_delay_learned = delay_try;
+				else
+					priv->retry_delay_learned = (priv->retry_delay_learned * 3 + delay_try) / 4;
+			}
 			break;
+		}
 
 		/* sanity check */
 		if (error_local == NULL) {
@@ -424,6 +568,7 @@ fu_device_retry_full (FuDevice *self,
 						    count);
 			return FALSE;
 		}
+		priv->retry_cnt++;
 
 		/* show recoverable error on the console */
 		if (priv->retry_recs->len == 0) {
@@ -513,18 +658,65 @@ fu_device_poll (FuDevice *self, GError **error)
 	return TRUE;
 }
 
+static void fu_device_poll_schedule (FuDevice *self);
+
 static gboolean
 fu_device_poll_cb (gpointer user_data)
 {
 	FuDevice *self = FU_DEVICE (user_data);
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint notify_cnt = priv->poll_notify_cnt;
+	guint poll_id = priv->poll_id;
+	guint poll_backoff;
 	g_autoptr(GError) error_local = NULL;
+
+	priv->poll_wakeups++;
 	if (!fu_device_poll (self, &error_local)) {
 		g_warning ("disabling polling: %s", error_local->message);
 		priv->poll_id = 0;
 		return G_SOURCE_REMOVE;
 	}
-	return G_SOURCE_CONTINUE;
+
+	/* the poll changed the interval itself */
+	if (priv->poll_id != poll_id)
+		return G_SOURCE_REMOVE;
+	if (priv->poll_interval < 1000)
+		return G_SOURCE_CONTINUE;
+
+	/* nothing changed, so wait longer next time */
+	if (priv->poll_notify_cnt != notify_cnt)
+		poll_backoff = 1;
+	else
+		poll_backoff = MIN (priv->poll_backoff * 2, FU_DEVICE_POLL_BACKOFF_MAX);
+	if (poll_backoff == priv->poll_backoff)
+		return G_SOURCE_CONTINUE;
+	priv->poll_backoff = poll_backoff;
+	priv->poll_id = 0;
+	fu_device_poll_schedule (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_device_poll_notify_cb (FuDevice *self, GParamSpec *pspec, gpointer user_data)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	priv->poll_notify_cnt++;
+}
+
+static void
+fu_device_poll_schedule (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint interval = priv->poll_interval * priv->poll_backoff;
+
+	/* use whole seconds so that GLib can wake up for all devices at once */
+	if (interval >= 1000) {
+		priv->poll_id = g_timeout_add_seconds ((interval + 999) / 1000,
+						       fu_device_poll_cb,
+						       self);
+	} else {
+		priv->poll_id = g_timeout_add (interval, fu_device_poll_cb, self);
+	}
 }
 
 /**
@@ -536,6 +728,10 @@ fu_device_poll_cb (gpointer user_data)
  * returns %FALSE then a warning is printed to the console and the poll is
  * disabled until the next call to fu_device_set_poll_interval().
  *
+ * Intervals of one second or more are rounded up to whole seconds so that
+ * wakeups can be shared with other devices, and are backed off up to eight
+ * times when a poll does not change any device property.
+ *
  * Since: 1.1.2
  **/
 void
@@ -549,15 +745,39 @@ fu_device_set_poll_interval (FuDevice *self, guint interval)
 		g_source_remove (priv->poll_id);
 		priv->poll_id = 0;
 	}
-	if (interval == 0)
+	priv->poll_interval = interval;
+	priv->poll_backoff = 1;
+	if (interval == 0) {
+		if (priv->poll_notify_id != 0) {
+			g_signal_handler_disconnect (self, priv->poll_notify_id);
+			priv->poll_notify_id = 0;
+		}
 		return;
-	if (interval % 1000 == 0) {
-		priv->poll_id = g_timeout_add_seconds (interval / 1000,
-						       fu_device_poll_cb,
-						       self);
-	} else {
-		priv->poll_id = g_timeout_add (interval, fu_device_poll_cb, self);
 	}
+	if (priv->poll_notify_id == 0) {
+		priv->poll_notify_id = g_signal_connect (self, "notify",
+							 G_CALLBACK (fu_device_poll_notify_cb),
+							 NULL);
+	}
+	fu_device_poll_schedule (self);
+}
+
+/**
+ * fu_device_get_poll_wakeups:
+ * @self: a #FuDevice
+ *
+ * Gets the number of times the device has been woken up to poll the hardware.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.8
+ **/
+guint64
+fu_device_get_poll_wakeups (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), G_MAXUINT64);
+	return priv->poll_wakeups;
 }
 
 /**
@@ -1003,12 +1223,15 @@ gboolean
 fu_device_has_parent_guid (FuDevice *self, const gchar *guid)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
+	const gchar *guid_tmp;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&priv->parent_guids_mutex);
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (locker != NULL, FALSE);
+	guid_tmp = fwupd_intern_lookup (guid);
+	if (guid_tmp == NULL)
+		return FALSE;
 	for (guint i = 0; i < priv->parent_guids->len; i++) {
-		const gchar *guid_tmp = g_ptr_array_index (priv->parent_guids, i);
-		if (g_strcmp0 (guid_tmp, guid) == 0)
+		if (g_ptr_array_index (priv->parent_guids, i) == guid_tmp)
 			return TRUE;
 	}
 	return FALSE;
@@ -1041,11 +1264,11 @@ fu_device_add_parent_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		const gchar *tmp = fu_common_guid_hash_string_cached (guid);
 		if (fu_device_has_parent_guid (self, tmp))
 			return;
 		g_debug ("using %s for %s", tmp, guid);
-		g_ptr_array_add (priv->parent_guids, g_steal_pointer (&tmp));
+		g_ptr_array_add (priv->parent_guids, (gpointer) fwupd_intern_ref (tmp));
 		return;
 	}
 
@@ -1054,7 +1277,7 @@ fu_device_add_parent_guid (FuDevice *self, const gchar *guid)
 		return;
 	locker = g_rw_lock_writer_locker_new (&priv->parent_guids_mutex);
 	g_return_if_fail (locker != NULL);
-	g_ptr_array_add (priv->parent_guids, g_strdup (guid));
+	g_ptr_array_add (priv->parent_guids, (gpointer) fwupd_intern_ref (guid));
 }
 
 static gboolean
@@ -1201,6 +1424,10 @@ fu_device_set_quirk_kv (FuDevice *self,
 		fu_device_set_firmware_size_max (self, fu_common_strtoull (value));
 		return TRUE;
 	}
+	if (g_strcmp0 (key, FU_QUIRKS_FIRMWARE_BLOCK_SIZE) == 0) {
+		fu_device_set_firmware_block_size (self, fu_common_strtoull (value));
+		return TRUE;
+	}
 	if (g_strcmp0 (key, FU_QUIRKS_FIRMWARE_SIZE) == 0) {
 		fu_device_set_firmware_size (self, fu_common_strtoull (value));
 		return TRUE;
@@ -1385,6 +1612,82 @@ fu_device_get_firmware_size_max (FuDevice *self)
 	return priv->size_max;
 }
 
+/**
+ * fu_device_set_firmware_block_size:
+ * @self: A #FuDevice
+ * @block_size: Size in bytes
+ *
+ * Sets the size of the blocks compared against the device contents when
+ * %FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED is set, typically the erase size.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_device_set_firmware_block_size (FuDevice *self, guint32 block_size)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	priv->block_size = block_size;
+}
+
+/**
+ * fu_device_get_firmware_block_size:
+ * @self: A #FuDevice
+ *
+ * Gets the size of the blocks compared against the device contents.
+ *
+ * Returns: Size in bytes, or 0 if unset
+ *
+ * Since: 1.5.8
+ **/
+guint32
+fu_device_get_firmware_block_size (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->block_size;
+}
+
+/**
+ * fu_device_get_dirty_chunks:
+ * @self: A #FuDevice
+ *
+ * Gets the blocks of the firmware that differ from the device contents. This
+ * is only valid from within the `->write_firmware()` vfunc.
+ *
+ * Returns: (transfer none) (nullable) (element-type FuChunk): chunks, or
+ * %NULL if the entire image should be written
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fu_device_get_dirty_chunks (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
+	return priv->dirty_chunks;
+}
+
+/**
+ * fu_device_get_bytes_written:
+ * @self: A #FuDevice
+ *
+ * Gets the number of firmware bytes that needed writing in the last call to
+ * fu_device_write_firmware(), when %FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED
+ * is set.
+ *
+ * Returns: Size in bytes
+ *
+ * Since: 1.5.8
+ **/
+guint64
+fu_device_get_bytes_written (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+	return priv->bytes_written;
+}
+
 static void
 fu_device_add_guid_safe (FuDevice *self, const gchar *guid)
 {
@@ -1413,7 +1716,7 @@ fu_device_has_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		const gchar *tmp = fu_common_guid_hash_string_cached (guid);
 		return fwupd_device_has_guid (FWUPD_DEVICE (self), tmp);
 	}
 
@@ -1438,7 +1741,7 @@ fu_device_add_instance_id_full (FuDevice *self,
 				FuDeviceInstanceFlags flags)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
-	g_autofree gchar *guid = NULL;
+	const gchar *guid;
 	if (fwupd_guid_is_valid (instance_id)) {
 		g_warning ("use fu_device_add_guid(\"%s\") instead!", instance_id);
 		fu_device_add_guid_safe (self, instance_id);
@@ -1449,7 +1752,7 @@ fu_device_add_instance_id_full (FuDevice *self,
 	 * calling fu_device_add_guid_safe() -- but we want the quirks to match
 	 * so the plugin is set, but not the LVFS metadata to match firmware
 	 * until we're sure the device isn't using _NO_AUTO_INSTANCE_IDS */
-	guid = fwupd_guid_hash_string (instance_id);
+	guid = fu_common_guid_hash_string_cached (instance_id);
 	fu_device_add_guid_quirks (self, guid);
 	if ((flags & FU_DEVICE_INSTANCE_FLAG_ONLY_QUIRKS) == 0)
 		fwupd_device_add_instance_id (FWUPD_DEVICE (self), instance_id);
@@ -1521,7 +1824,7 @@ fu_device_add_counterpart_guid (FuDevice *self, const gchar *guid)
 
 	/* make valid */
 	if (!fwupd_guid_is_valid (guid)) {
-		g_autofree gchar *tmp = fwupd_guid_hash_string (guid);
+		const gchar *tmp = fu_common_guid_hash_string_cached (guid);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), tmp);
 		return;
 	}
@@ -2498,13 +2801,75 @@ fu_device_set_progress (FuDevice *self, guint progress)
 void
 fu_device_set_progress_full (FuDevice *self, gsize progress_done, gsize progress_total)
 {
+	FuDevicePrivate *priv = GET_PRIVATE (self);
 	gdouble percentage = 0.f;
 	g_return_if_fail (FU_IS_DEVICE (self));
+
+	/* a new transfer has started */
+	if (progress_done == 0 ||
+	    progress_done < priv->progress_done ||
+	    progress_total != priv->progress_total)
+		priv->progress_start = fu_common_get_monotonic_time ();
+	priv->progress_done = progress_done;
+	priv->progress_total = progress_total;
+
 	if (progress_total > 0)
 		percentage = (100.f * (gdouble) progress_done) / (gdouble) progress_total;
 	fu_device_set_progress (self, (guint) percentage);
 }
 
+/**
+ * fu_device_get_progress_speed:
+ * @self: A #FuDevice
+ *
+ * Gets the average speed of the transfer last reported using
+ * fu_device_set_progress_full().
+ *
+ * Returns: bytes per second, or 0 if unknown
+ *
+ * Since: 1.5.8
+ **/
+guint64
+fu_device_get_progress_speed (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gint64 elapsed;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+
+	if (priv->progress_start == 0 || priv->progress_done == 0)
+		return 0;
+	elapsed = fu_common_get_monotonic_time () - priv->progress_start;
+	if (elapsed <= 0)
+		return 0;
+	return ((guint64) priv->progress_done * G_USEC_PER_SEC) / (guint64) elapsed;
+}
+
+/**
+ * fu_device_get_progress_remaining:
+ * @self: A #FuDevice
+ *
+ * Gets the predicted time to complete the transfer last reported using
+ * fu_device_set_progress_full(), assuming that the average speed continues.
+ *
+ * Returns: seconds, or 0 if unknown
+ *
+ * Since: 1.5.8
+ **/
+guint
+fu_device_get_progress_remaining (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	guint64 speed;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), 0);
+
+	speed = fu_device_get_progress_speed (self);
+	if (speed == 0 || priv->progress_done >= priv->progress_total)
+		return 0;
+	return (guint) ((priv->progress_total - priv->progress_done) / speed);
+}
+
 /**
  * fu_device_sleep_with_progress:
  * @self: A #FuDevice
@@ -2526,7 +2891,7 @@ fu_device_sleep_with_progress (FuDevice *self, guint delay_secs)
 
 	fu_device_set_progress (self, 0);
 	for (guint i = 0; i < 100; i++) {
-		g_usleep (delay_us_pc);
+		fu_common_sleep_us (delay_us_pc);
 		fu_device_set_progress (self, i + 1);
 	}
 }
@@ -2570,10 +2935,20 @@ fu_device_add_string (FuDevice *self, guint idt, GString *str)
 		g_autofree gchar *sz = g_strdup_printf ("%" G_GUINT64_FORMAT, priv->size_max);
 		fu_common_string_append_kv (str, idt + 1, "FirmwareSizeMax", sz);
 	}
+	if (priv->block_size > 0)
+		fu_common_string_append_kx (str, idt + 1, "FirmwareBlockSize", priv->block_size);
 	if (priv->order != G_MAXINT)
 		fu_common_string_append_ku (str, idt + 1, "Order", priv->order);
 	if (priv->priority > 0)
 		fu_common_string_append_ku (str, idt + 1, "Priority", priv->priority);
+	if (priv->poll_interval > 0) {
+		fu_common_string_append_ku (str, idt + 1, "PollInterval", priv->poll_interval);
+		fu_common_string_append_ku (str, idt + 1, "PollWakeups", priv->poll_wakeups);
+	}
+	if (priv->retry_cnt > 0)
+		fu_common_string_append_ku (str, idt + 1, "RetryCount", priv->retry_cnt);
+	if (priv->retry_delay_learned > 0)
+		fu_common_string_append_ku (str, idt + 1, "RetryDelayLearned", priv->retry_delay_learned);
 	if (priv->metadata != NULL) {
 		g_autoptr(GList) keys = g_hash_table_get_keys (priv->metadata);
 		for (GList *l = keys; l != NULL; l = l->next) {
@@ -2690,6 +3065,52 @@ fu_device_get_release_default (FuDevice *self)
 	return rel;
 }
 
+/* compare each block of the new image with what is on the device */
+static GPtrArray *
+fu_device_build_dirty_chunks (FuDevice *self, FuFirmware *firmware, GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GBytes) fw = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(GPtrArray) dirty = NULL;
+
+	if (klass->read_block == NULL || priv->block_size == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "skip-unchanged requires a block size and ->read_block()");
+		return NULL;
+	}
+	fw = fu_firmware_write (firmware, error);
+	if (fw == NULL)
+		return NULL;
+	dirty = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	chunks = fu_chunk_array_new_from_bytes (fw, 0x0, 0x0, priv->block_size);
+	fu_device_set_status (self, FWUPD_STATUS_DEVICE_VERIFY);
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		g_autoptr(GBytes) blob = NULL;
+		blob = klass->read_block (self,
+					  fu_chunk_get_address (chk),
+					  fu_chunk_get_data_sz (chk),
+					  error);
+		if (blob == NULL) {
+			g_prefix_error (error, "failed to read block @0x%x: ",
+					fu_chunk_get_address (chk));
+			return NULL;
+		}
+		if (g_bytes_get_size (blob) != fu_chunk_get_data_sz (chk) ||
+		    memcmp (g_bytes_get_data (blob, NULL),
+			    fu_chunk_get_data (chk),
+			    fu_chunk_get_data_sz (chk)) != 0)
+			g_ptr_array_add (dirty, g_object_ref (chk));
+		fu_device_set_progress_full (self, (gsize) i + 1, (gsize) chunks->len);
+	}
+	g_debug ("%u of %u blocks need writing", dirty->len, chunks->len);
+	return g_steal_pointer (&dirty);
+}
+
 /**
  * fu_device_write_firmware:
  * @self: A #FuDevice
@@ -2699,6 +3120,9 @@ fu_device_get_release_default (FuDevice *self)
  *
  * Writes firmware to the device by calling a plugin-specific vfunc.
  *
+ * If the device implements write_stream but not prepare_firmware then @fw is
+ * streamed to the device using fu_device_write_firmware_stream().
+ *
  * Returns: %TRUE on success
  *
  * Since: 1.0.8
@@ -2710,12 +3134,23 @@ fu_device_write_firmware (FuDevice *self,
 			  GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gboolean ret;
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autofree gchar *str = NULL;
 
 	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* the payload is written as-is, so it does not have to be parsed */
+	if (klass->write_stream != NULL && klass->prepare_firmware == NULL) {
+		g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_bytes (fw);
+		return fu_device_write_firmware_stream (self, stream,
+							g_bytes_get_size (fw),
+							fu_device_get_metadata (self, FU_DEVICE_METADATA_UPDATE_CHECKSUM),
+							flags, error);
+	}
+
 	/* no plugin-specific method */
 	if (klass->write_firmware == NULL) {
 		g_set_error_literal (error,
@@ -2732,8 +3167,138 @@ fu_device_write_firmware (FuDevice *self,
 	str = fu_firmware_to_string (firmware);
 	g_debug ("installing onto %s:\n%s", fu_device_get_id (self), str);
 
+	/* only write the blocks that need changing */
+	priv->bytes_written = 0;
+	if (fu_device_has_internal_flag (self, FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED) &&
+	    (flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
+		priv->dirty_chunks = fu_device_build_dirty_chunks (self, firmware, error);
+		if (priv->dirty_chunks == NULL)
+			return FALSE;
+		for (guint i = 0; i < priv->dirty_chunks->len; i++) {
+			FuChunk *chk = g_ptr_array_index (priv->dirty_chunks, i);
+			priv->bytes_written += fu_chunk_get_data_sz (chk);
+		}
+		if (priv->dirty_chunks->len == 0) {
+			g_debug ("%s already has identical firmware, skipping write",
+				 fu_device_get_id (self));
+			g_clear_pointer (&priv->dirty_chunks, g_ptr_array_unref);
+			return TRUE;
+		}
+	}
+
 	/* call vfunc */
-	return klass->write_firmware (self, firmware, flags, error);
+	ret = klass->write_firmware (self, firmware, flags, error);
+	g_clear_pointer (&priv->dirty_chunks, g_ptr_array_unref);
+	return ret;
+}
+
+static gboolean
+fu_device_check_firmware_size (FuDevice *self, guint64 fw_sz, GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->size_max > 0 && fw_sz > priv->size_max) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "firmware is %04x bytes larger than the allowed "
+			     "maximum size of %04x bytes",
+			     (guint) (fw_sz - priv->size_max),
+			     (guint) priv->size_max);
+		return FALSE;
+	}
+	if (priv->size_min > 0 && fw_sz < priv->size_min) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "firmware is %04x bytes smaller than the allowed "
+			     "minimum size of %04x bytes",
+			     (guint) (priv->size_min - fw_sz),
+			     (guint) priv->size_max);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_device_write_firmware_stream:
+ * @self: A #FuDevice
+ * @stream: A #GInputStream
+ * @streamsz: The size of the payload in @stream
+ * @checksum: (nullable): The expected SHA1 or SHA256 checksum of the payload
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError
+ *
+ * Writes the payload to the device using the write_stream vfunc, which reads
+ * the payload as it is needed rather than requiring all of it in memory.
+ *
+ * If @checksum is set then the payload is checksummed as it is read, and an
+ * error is returned if the device did not read all of the payload or if the
+ * checksum did not match.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_device_write_firmware_stream (FuDevice *self,
+				 GInputStream *stream,
+				 gsize streamsz,
+				 const gchar *checksum,
+				 FwupdInstallFlags flags,
+				 GError **error)
+{
+	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	const gchar *checksum_actual;
+	g_autoptr(FuChecksumConverter) converter = NULL;
+	g_autoptr(GInputStream) stream_csum = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* no plugin-specific method */
+	if (klass->write_stream == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "not supported");
+		return FALSE;
+	}
+	if (!fu_device_check_firmware_size (self, streamsz, error))
+		return FALSE;
+	g_debug ("streaming 0x%x bytes onto %s",
+		 (guint) streamsz, fu_device_get_id (self));
+
+	/* no data is copied, it is only checksummed on the way through */
+	priv->bytes_written = 0;
+	if (checksum == NULL)
+		return klass->write_stream (self, stream, streamsz, flags, error);
+	converter = fu_checksum_converter_new (fwupd_checksum_guess_kind (checksum));
+	stream_csum = g_converter_input_stream_new (stream, G_CONVERTER (converter));
+	if (!klass->write_stream (self, stream_csum, streamsz, flags, error))
+		return FALSE;
+	if (fu_checksum_converter_get_size (converter) != streamsz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "only 0x%x of 0x%x bytes were read, cannot verify payload",
+			     (guint) fu_checksum_converter_get_size (converter),
+			     (guint) streamsz);
+		return FALSE;
+	}
+	checksum_actual = fu_checksum_converter_get_string (converter);
+	if (g_strcmp0 (checksum_actual, checksum) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "payload checksum invalid, expected %s, got %s",
+			     checksum, checksum_actual);
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
 }
 
 /**
@@ -2762,7 +3327,6 @@ fu_device_prepare_firmware (FuDevice *self,
 			    GError **error)
 {
 	FuDeviceClass *klass = FU_DEVICE_GET_CLASS (self);
-	FuDevicePrivate *priv = GET_PRIVATE (self);
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autoptr(GBytes) fw_def = NULL;
 
@@ -2783,33 +3347,109 @@ fu_device_prepare_firmware (FuDevice *self,
 	/* check size */
 	fw_def = fu_firmware_get_image_default_bytes (firmware, NULL);
 	if (fw_def != NULL) {
-		guint64 fw_sz = (guint64) g_bytes_get_size (fw_def);
-		if (priv->size_max > 0 && fw_sz > priv->size_max) {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "firmware is %04x bytes larger than the allowed "
-				     "maximum size of %04x bytes",
-				     (guint) (fw_sz - priv->size_max),
-				     (guint) priv->size_max);
+		if (!fu_device_check_firmware_size (self, g_bytes_get_size (fw_def), error))
 			return NULL;
-		}
-		if (priv->size_min > 0 && fw_sz < priv->size_min) {
-			g_set_error (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "firmware is %04x bytes smaller than the allowed "
-				     "minimum size of %04x bytes",
-				     (guint) (priv->size_min - fw_sz),
-				     (guint) priv->size_max);
-			return NULL;
-		}
 	}
 
 	/* success */
 	return g_steal_pointer (&firmware);
 }
 
+/**
+ * fu_device_set_firmware_cache:
+ * @self: A #FuDevice
+ * @firmware_cache: (element-type utf8 FuFirmware) (nullable): A #GHashTable
+ *
+ * Sets a parse cache that can be shared by all the devices being updated in
+ * the same transaction. The table should be created using g_str_hash(),
+ * g_str_equal(), g_free() and g_object_unref().
+ *
+ * Setting %NULL stops using any cache previously set.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_device_set_firmware_cache (FuDevice *self, GHashTable *firmware_cache)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_DEVICE (self));
+	if (priv->firmware_cache == firmware_cache)
+		return;
+	if (priv->firmware_cache != NULL)
+		g_hash_table_unref (priv->firmware_cache);
+	priv->firmware_cache = firmware_cache != NULL ? g_hash_table_ref (firmware_cache) : NULL;
+}
+
+/**
+ * fu_device_parse_firmware_cached:
+ * @self: A #FuDevice
+ * @gtype: A #GType, e.g. `FU_TYPE_IHEX_FIRMWARE`
+ * @fw: A #GBytes
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError
+ *
+ * Creates a firmware of type @gtype and parses @fw into it. If a parse cache
+ * has been set using fu_device_set_firmware_cache() and the same payload has
+ * already been parsed as @gtype then the earlier result is returned instead.
+ *
+ * The returned firmware may be shared with other devices and so must be
+ * treated as read-only by the caller.
+ *
+ * Returns: (transfer full): A #FuFirmware, or %NULL for error
+ *
+ * Since: 1.5.8
+ **/
+FuFirmware *
+fu_device_parse_firmware_cached (FuDevice *self,
+				 GType gtype,
+				 GBytes *fw,
+				 FwupdInstallFlags flags,
+				 GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuFirmware *firmware_tmp;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *key = NULL;
+	g_autoptr(FuFirmware) firmware = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), NULL);
+	g_return_val_if_fail (g_type_is_a (gtype, FU_TYPE_FIRMWARE), NULL);
+	g_return_val_if_fail (fw != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* no cache set */
+	if (priv->firmware_cache == NULL) {
+		firmware = g_object_new (gtype, NULL);
+		if (!fu_firmware_parse (firmware, fw, flags, error))
+			return NULL;
+		return g_steal_pointer (&firmware);
+	}
+
+	/* already parsed */
+	checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, fw);
+	key = g_strdup_printf ("%s:%s:%x", g_type_name (gtype), checksum, (guint) flags);
+	G_LOCK (firmware_cache);
+	firmware_tmp = g_hash_table_lookup (priv->firmware_cache, key);
+	if (firmware_tmp != NULL)
+		firmware = g_object_ref (firmware_tmp);
+	G_UNLOCK (firmware_cache);
+	if (firmware != NULL) {
+		g_debug ("using cached %s for %s", g_type_name (gtype), checksum);
+		return g_steal_pointer (&firmware);
+	}
+
+	/* parse without holding the lock, as this may be slow */
+	firmware = g_object_new (gtype, NULL);
+	if (!fu_firmware_parse (firmware, fw, flags, error))
+		return NULL;
+	G_LOCK (firmware_cache);
+	g_hash_table_insert (priv->firmware_cache,
+			     g_steal_pointer (&key),
+			     g_object_ref (firmware));
+	G_UNLOCK (firmware_cache);
+	return g_steal_pointer (&firmware);
+}
+
 /**
  * fu_device_read_firmware:
  * @self: A #FuDevice
@@ -3075,8 +3715,8 @@ fu_device_open (FuDevice *self, GError **error)
 	if (!fu_device_ensure_id (self, error))
 		return FALSE;
 
-	/* subclassed */
-	if (klass->open != NULL) {
+	/* subclassed, unless there is no hardware */
+	if (klass->open != NULL && !priv->transcript_replay) {
 		if (fu_device_has_internal_flag (self, FU_DEVICE_INTERNAL_FLAG_RETRY_OPEN)) {
 			if (!fu_device_retry_full (self, fu_device_open_cb,
 						   FU_DEVICE_RETRY_OPEN_COUNT,
@@ -3141,12 +3781,22 @@ fu_device_close (FuDevice *self, GError **error)
 	if (!g_atomic_int_dec_and_test (&priv->open_refcount))
 		return TRUE;
 
-	/* subclassed */
-	if (klass->close != NULL) {
+	/* subclassed, unless there is no hardware */
+	if (klass->close != NULL && !priv->transcript_replay) {
 		if (!klass->close (self, error))
 			return FALSE;
 	}
 
+	/* save everything recorded so far */
+	if (priv->transcript_dir != NULL && priv->transcript != NULL &&
+	    !priv->transcript_replay) {
+		const gchar *id = fu_device_get_id (self);
+		g_autofree gchar *basename = g_strdup_printf ("%s.txt", id != NULL ? id : "unknown");
+		g_autofree gchar *fn = g_build_filename (priv->transcript_dir, basename, NULL);
+		if (!fu_device_save_transcript (self, fn, error))
+			return FALSE;
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -3246,7 +3896,7 @@ fu_device_convert_instance_ids (FuDevice *self)
 	instance_ids = fwupd_device_get_instance_ids (FWUPD_DEVICE (self));
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		const gchar *guid = fu_common_guid_hash_string_cached (instance_id);
 		fwupd_device_add_guid (FWUPD_DEVICE (self), guid);
 	}
 }
@@ -3551,7 +4201,7 @@ fu_device_incorporate (FuDevice *self, FuDevice *donor)
 	/* call the set_quirk_kv() vfunc for the superclassed object */
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		const gchar *guid = fu_common_guid_hash_string_cached (instance_id);
 		fu_device_add_guid_quirks (self, guid);
 	}
 }
@@ -3650,11 +4300,375 @@ fu_device_init (FuDevice *self)
 {
 	FuDevicePrivate *priv = GET_PRIVATE (self);
 	priv->order = G_MAXINT;
-	priv->parent_guids = g_ptr_array_new_with_free_func (g_free);
+	priv->parent_guids = g_ptr_array_new_with_free_func ((GDestroyNotify) fwupd_intern_unref);
 	priv->possible_plugins = g_ptr_array_new_with_free_func (g_free);
 	priv->retry_recs = g_ptr_array_new_with_free_func (g_free);
 	g_rw_lock_init (&priv->parent_guids_mutex);
 	g_rw_lock_init (&priv->metadata_mutex);
+	priv->transcript_dir = g_strdup (g_getenv ("FWUPD_TRANSCRIPT_DIR"));
+}
+
+static void
+fu_device_trace_item_free (FuDeviceTraceItem *item)
+{
+	g_bytes_unref (item->blob);
+	g_free (item);
+}
+
+static void
+fu_device_trace_item_print (FuDeviceTraceItem *item, gint64 now)
+{
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (item->blob, &bufsz);
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	g_string_append_printf (str, "[-%" G_GINT64_FORMAT "ms] %s:",
+				(now - item->timestamp) / 1000, item->title);
+	for (gsize i = 0; i < bufsz; i++)
+		g_string_append_printf (str, " %02x", buf[i]);
+	if (item->bufsz > bufsz)
+		g_string_append_printf (str, " … [%" G_GSIZE_FORMAT " bytes]", item->bufsz);
+	g_info ("%s", str->str);
+}
+
+/**
+ * fu_device_add_trace:
+ * @self: A #FuDevice
+ * @title: a static string describing the packet, e.g. `SetReport`
+ * @buf: the packet data
+ * @bufsz: the size of @buf
+ *
+ * Records a raw packet sent to or received from the device. Only the last
+ * few packets are kept, and only the start of each is copied, so this is
+ * cheap enough to call for every transfer.
+ *
+ * The packets are printed using fu_device_dump_trace(), or as they are
+ * recorded when `FWUPD_TRACE` is set, e.g. using `fwupdtool --trace`.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_device_add_trace (FuDevice *self, const gchar *title, const guint8 *buf, gsize bufsz)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuDeviceTraceItem *item;
+
+	g_return_if_fail (FU_IS_DEVICE (self));
+	g_return_if_fail (title != NULL);
+	g_return_if_fail (buf != NULL || bufsz == 0);
+
+	item = g_new0 (FuDeviceTraceItem, 1);
+	item->title = title;
+	item->timestamp = fu_common_get_monotonic_time ();
+	item->bufsz = bufsz;
+	item->blob = g_bytes_new (buf, MIN (bufsz, FU_DEVICE_TRACE_SIZE_MAX));
+
+	/* overwrite the oldest item */
+	if (priv->trace == NULL)
+		priv->trace = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_trace_item_free);
+	if (priv->trace->len < FU_DEVICE_TRACE_ITEMS_MAX) {
+		g_ptr_array_add (priv->trace, item);
+	} else {
+		fu_device_trace_item_free (g_ptr_array_index (priv->trace, priv->trace_idx));
+		g_ptr_array_index (priv->trace, priv->trace_idx) = item;
+	}
+	priv->trace_idx = (priv->trace_idx + 1) % FU_DEVICE_TRACE_ITEMS_MAX;
+
+	/* requested by the user */
+	if (g_getenv ("FWUPD_TRACE") != NULL)
+		fu_device_trace_item_print (item, item->timestamp);
+}
+
+/**
+ * fu_device_dump_trace:
+ * @self: A #FuDevice
+ *
+ * Prints the packets recorded with fu_device_add_trace(), oldest first, and
+ * then forgets them. This is typically used when an update has failed.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_device_dump_trace (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	gint64 now = fu_common_get_monotonic_time ();
+
+	g_return_if_fail (FU_IS_DEVICE (self));
+
+	if (priv->trace == NULL)
+		return;
+	g_info ("last %u packets for %s:",
+		priv->trace->len, fu_device_get_id (self));
+	for (guint i = 0; i < priv->trace->len; i++) {
+		guint idx = (priv->trace_idx + i) % priv->trace->len;
+		fu_device_trace_item_print (g_ptr_array_index (priv->trace, idx), now);
+	}
+	g_clear_pointer (&priv->trace, g_ptr_array_unref);
+	priv->trace_idx = 0;
+}
+
+static void
+fu_device_transcript_item_free (FuDeviceTranscriptItem *item)
+{
+	g_free (item->id);
+	g_bytes_unref (item->blob);
+	g_free (item);
+}
+
+static void
+fu_device_ensure_transcript (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->transcript != NULL)
+		return;
+	priv->transcript = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_transcript_item_free);
+}
+
+/**
+ * fu_device_load_transcript:
+ * @self: A #FuDevice
+ * @filename: a transcript previously saved with fu_device_save_transcript()
+ * @speed: how much faster than recorded to replay, or 0 for no delays
+ * @error: A #GError, or %NULL
+ *
+ * Loads a transcript and switches the device to replay mode. From then on
+ * the device is never opened, and each transfer is answered from the
+ * transcript rather than the hardware. Writes must match what was recorded
+ * and arrive in the same order.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_device_load_transcript (FuDevice *self,
+			   const gchar *filename,
+			   gdouble speed,
+			   GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autofree gchar *data = NULL;
+	g_auto(GStrv) lines = NULL;
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (speed >= 0.f, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!g_file_get_contents (filename, &data, NULL, error))
+		return FALSE;
+	g_clear_pointer (&priv->transcript, g_ptr_array_unref);
+	fu_device_ensure_transcript (self);
+	lines = g_strsplit (data, "\n", -1);
+	for (guint i = 0; lines[i] != NULL; i++) {
+		FuDeviceTranscriptItem *item;
+		const gchar *hex;
+		gsize hexsz;
+		g_autofree guint8 *buf = NULL;
+		g_auto(GStrv) split = NULL;
+
+		/* comment or blank */
+		if (lines[i][0] == '\0' || lines[i][0] == '#')
+			continue;
+		split = g_strsplit (lines[i], " ", 3);
+		if (g_strv_length (split) != 3) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid transcript line %u", i + 1);
+			return FALSE;
+		}
+		hex = g_strcmp0 (split[2], "-") == 0 ? "" : split[2];
+		hexsz = strlen (hex);
+		if (hexsz % 2 != 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid transcript data on line %u", i + 1);
+			return FALSE;
+		}
+		buf = g_malloc0 ((hexsz / 2) + 1);
+		for (gsize j = 0; j < hexsz / 2; j++) {
+			gint hi = g_ascii_xdigit_value (hex[j * 2]);
+			gint lo = g_ascii_xdigit_value (hex[(j * 2) + 1]);
+			if (hi < 0 || lo < 0) {
+				g_set_error (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "invalid transcript data on line %u", i + 1);
+				return FALSE;
+			}
+			buf[j] = (hi << 4) | lo;
+		}
+		item = g_new0 (FuDeviceTranscriptItem, 1);
+		item->delta = g_ascii_strtoll (split[0], NULL, 10);
+		item->id = g_strdup (split[1]);
+		item->blob = g_bytes_new (buf, hexsz / 2);
+		g_ptr_array_add (priv->transcript, item);
+	}
+	priv->transcript_idx = 0;
+	priv->transcript_speed = speed;
+	priv->transcript_replay = TRUE;
+	return TRUE;
+}
+
+/**
+ * fu_device_save_transcript:
+ * @self: A #FuDevice
+ * @filename: a filename to write
+ * @error: A #GError, or %NULL
+ *
+ * Saves the transfers recorded as the device was used. Transfers are only
+ * recorded when `FWUPD_TRANSCRIPT_DIR` is set, e.g. using
+ * `fwupdtool --record`, in which case the transcript is also saved into that
+ * directory each time the device is closed.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_device_save_transcript (FuDevice *self, const gchar *filename, GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GString) str = g_string_new (NULL);
+
+	g_return_val_if_fail (FU_IS_DEVICE (self), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (fu_device_get_name (self) != NULL)
+		g_string_append_printf (str, "# %s\n", fu_device_get_name (self));
+	for (guint i = 0; priv->transcript != NULL && i < priv->transcript->len; i++) {
+		FuDeviceTranscriptItem *item = g_ptr_array_index (priv->transcript, i);
+		gsize bufsz = 0;
+		const guint8 *buf = g_bytes_get_data (item->blob, &bufsz);
+		g_string_append_printf (str, "%" G_GINT64_FORMAT " %s ",
+					item->delta, item->id);
+		for (gsize j = 0; j < bufsz; j++)
+			g_string_append_printf (str, "%02x", buf[j]);
+		if (bufsz == 0)
+			g_string_append (str, "-");
+		g_string_append (str, "\n");
+	}
+	return g_file_set_contents (filename, str->str, str->len, error);
+}
+
+/* records a successful transfer when FWUPD_TRANSCRIPT_DIR is set */
+void
+fu_device_transcript_record (FuDevice *self,
+			     const gchar *id,
+			     const guint8 *buf,
+			     gsize bufsz)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuDeviceTranscriptItem *item;
+	gint64 now;
+
+	if (priv->transcript_dir == NULL || priv->transcript_replay)
+		return;
+	now = fu_common_get_monotonic_time ();
+	fu_device_ensure_transcript (self);
+	item = g_new0 (FuDeviceTranscriptItem, 1);
+	item->id = g_strdup (id);
+	item->delta = priv->transcript_last > 0 ? now - priv->transcript_last : 0;
+	item->blob = g_bytes_new (buf, bufsz);
+	g_ptr_array_add (priv->transcript, item);
+	priv->transcript_last = now;
+}
+
+gboolean
+fu_device_transcript_is_replay (FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	return priv->transcript_replay;
+}
+
+static FuDeviceTranscriptItem *
+fu_device_transcript_replay_next (FuDevice *self, const gchar *id, GError **error)
+{
+	FuDevicePrivate *priv = GET_PRIVATE (self);
+	FuDeviceTranscriptItem *item;
+
+	if (priv->transcript_idx >= priv->transcript->len) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "transcript ended, but got %s", id);
+		return NULL;
+	}
+	item = g_ptr_array_index (priv->transcript, priv->transcript_idx);
+	if (g_strcmp0 (item->id, id) != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "transcript expected %s at %u, but got %s",
+			     item->id, priv->transcript_idx, id);
+		return NULL;
+	}
+	priv->transcript_idx++;
+
+	/* play at the recorded speed, or faster */
+	if (priv->transcript_speed > 0.f && item->delta > 0)
+		fu_common_sleep_us ((gulong) ((gdouble) item->delta / priv->transcript_speed));
+	return item;
+}
+
+/* checks the data written matches the transcript */
+gboolean
+fu_device_transcript_replay_write (FuDevice *self,
+				   const gchar *id,
+				   const guint8 *buf,
+				   gsize bufsz,
+				   GError **error)
+{
+	FuDeviceTranscriptItem *item;
+	g_autoptr(GBytes) blob = g_bytes_new_static (buf, bufsz);
+
+	item = fu_device_transcript_replay_next (self, id, error);
+	if (item == NULL)
+		return FALSE;
+	if (!g_bytes_equal (item->blob, blob)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "%s data did not match transcript", id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* copies the recorded data into @buf */
+gboolean
+fu_device_transcript_replay_read (FuDevice *self,
+				  const gchar *id,
+				  guint8 *buf,
+				  gsize bufsz,
+				  gsize *actual_len,
+				  GError **error)
+{
+	FuDeviceTranscriptItem *item;
+	gsize itemsz = 0;
+	const guint8 *itembuf;
+
+	item = fu_device_transcript_replay_next (self, id, error);
+	if (item == NULL)
+		return FALSE;
+	itembuf = g_bytes_get_data (item->blob, &itemsz);
+	if (itemsz > bufsz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "%s transcript has 0x%x bytes, buffer only 0x%x",
+			     id, (guint) itemsz, (guint) bufsz);
+		return FALSE;
+	}
+	if (itemsz > 0)
+		memcpy (buf, itembuf, itemsz);
+	if (actual_len != NULL)
+		*actual_len = itemsz;
+	return TRUE;
 }
 
 static void
@@ -3672,6 +4686,8 @@ fu_device_finalize (GObject *object)
 		g_object_remove_weak_pointer (G_OBJECT (priv->proxy), (gpointer *) &priv->proxy);
 	if (priv->quirks != NULL)
 		g_object_unref (priv->quirks);
+	if (priv->firmware_cache != NULL)
+		g_hash_table_unref (priv->firmware_cache);
 	if (priv->poll_id != 0)
 		g_source_remove (priv->poll_id);
 	if (priv->metadata != NULL)
@@ -3679,12 +4695,19 @@ fu_device_finalize (GObject *object)
 	g_ptr_array_unref (priv->parent_guids);
 	g_ptr_array_unref (priv->possible_plugins);
 	g_ptr_array_unref (priv->retry_recs);
+	if (priv->dirty_chunks != NULL)
+		g_ptr_array_unref (priv->dirty_chunks);
+	if (priv->trace != NULL)
+		g_ptr_array_unref (priv->trace);
+	if (priv->transcript != NULL)
+		g_ptr_array_unref (priv->transcript);
 	g_free (priv->alternate_id);
 	g_free (priv->equivalent_id);
 	g_free (priv->physical_id);
 	g_free (priv->logical_id);
 	g_free (priv->backend_id);
 	g_free (priv->proxy_guid);
+	g_free (priv->transcript_dir);
 
 	G_OBJECT_CLASS (fu_device_parent_class)->finalize (object);
 }
@@ -95,8 +95,19 @@ struct _FuDeviceClass
 	GBytes			*(*dump_firmware)	(FuDevice	*self,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+	GBytes			*(*read_block)		(FuDevice	*self,
+							 guint32	 address,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+	gboolean		 (*write_stream)	(FuDevice	*self,
+							 GInputStream	*stream,
+							 gsize		 streamsz,
+							 FwupdInstallFlags flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 	/*< private >*/
-	gpointer	padding[11];
+	gpointer	padding[9];
 };
 
 /**
@@ -208,6 +219,8 @@ FuDevice	*fu_device_new				(void);
  * @FU_DEVICE_INTERNAL_FLAG_MD_SET_ICON:		Set the device icon from the metadata if available
  * @FU_DEVICE_INTERNAL_FLAG_RETRY_OPEN:			Retry the device open up to 5 times if it fails
  * @FU_DEVICE_INTERNAL_FLAG_REPLUG_MATCH_GUID:		Match GUIDs on device replug where the physical and logical IDs will be different
+ * @FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED:		Only write the firmware blocks that differ from what is on the device
+ * @FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF:		Use a short and increasing delay between retries
  *
  * The device internal flags.
  **/
@@ -222,6 +235,8 @@ typedef enum {
 	FU_DEVICE_INTERNAL_FLAG_MD_SET_ICON		= (1llu << 6),	/* Since: 1.5.5 */
 	FU_DEVICE_INTERNAL_FLAG_RETRY_OPEN		= (1llu << 7),	/* Since: 1.5.5 */
 	FU_DEVICE_INTERNAL_FLAG_REPLUG_MATCH_GUID	= (1llu << 8),	/* Since: 1.5.8 */
+	FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED		= (1llu << 9),	/* Since: 1.5.8 */
+	FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF		= (1llu << 10),	/* Since: 1.5.8 */
 	/*< private >*/
 	FU_DEVICE_INTERNAL_FLAG_UNKNOWN			= G_MAXUINT64,
 } FuDeviceInternalFlags;
@@ -326,12 +341,19 @@ void		 fu_device_set_firmware_size_max	(FuDevice	*self,
 							 guint64	 size_max);
 guint64		 fu_device_get_firmware_size_min	(FuDevice	*self);
 guint64		 fu_device_get_firmware_size_max	(FuDevice	*self);
+void		 fu_device_set_firmware_block_size	(FuDevice	*self,
+							 guint32	 block_size);
+guint32		 fu_device_get_firmware_block_size	(FuDevice	*self);
+GPtrArray	*fu_device_get_dirty_chunks		(FuDevice	*self);
+guint64		 fu_device_get_bytes_written		(FuDevice	*self);
 guint		 fu_device_get_progress			(FuDevice	*self);
 void		 fu_device_set_progress			(FuDevice	*self,
 							 guint		 progress);
 void		 fu_device_set_progress_full		(FuDevice	*self,
 							 gsize		 progress_done,
 							 gsize		 progress_total);
+guint64		 fu_device_get_progress_speed		(FuDevice	*self);
+guint		 fu_device_get_progress_remaining	(FuDevice	*self);
 void		 fu_device_sleep_with_progress		(FuDevice	*self,
 							 guint		 delay_secs);
 void		 fu_device_set_quirks			(FuDevice	*self,
@@ -350,11 +372,26 @@ gboolean	 fu_device_write_firmware		(FuDevice	*self,
 							 FwupdInstallFlags flags,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_device_write_firmware_stream	(FuDevice	*self,
+							 GInputStream	*stream,
+							 gsize		 streamsz,
+							 const gchar	*checksum,
+							 FwupdInstallFlags flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 FuFirmware	*fu_device_prepare_firmware		(FuDevice	*self,
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fu_device_set_firmware_cache		(FuDevice	*self,
+							 GHashTable	*firmware_cache);
+FuFirmware	*fu_device_parse_firmware_cached	(FuDevice	*self,
+							 GType		 gtype,
+							 GBytes		*fw,
+							 FwupdInstallFlags flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 FuFirmware	*fu_device_read_firmware		(FuDevice	*self,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
@@ -407,8 +444,27 @@ gboolean	 fu_device_poll				(FuDevice	*self,
 							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fu_device_set_poll_interval		(FuDevice	*self,
 							 guint		 interval);
+guint64		 fu_device_get_poll_wakeups		(FuDevice	*self);
 void		 fu_device_retry_set_delay		(FuDevice	*self,
 							 guint		 delay);
+void		 fu_device_set_retry_delay_learned	(FuDevice	*self,
+							 guint		 delay);
+guint		 fu_device_get_retry_delay_learned	(FuDevice	*self);
+guint64		 fu_device_get_retry_count		(FuDevice	*self);
+void		 fu_device_add_trace			(FuDevice	*self,
+							 const gchar	*title,
+							 const guint8	*buf,
+							 gsize		 bufsz);
+void		 fu_device_dump_trace			(FuDevice	*self);
+gboolean	 fu_device_load_transcript		(FuDevice	*self,
+							 const gchar	*filename,
+							 gdouble	 speed,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_device_save_transcript		(FuDevice	*self,
+							 const gchar	*filename,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fu_device_retry_add_recovery		(FuDevice	*self,
 							 GQuark		 domain,
 							 gint		 code,
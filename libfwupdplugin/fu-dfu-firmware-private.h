@@ -32,6 +32,10 @@ guint8		 fu_dfu_firmware_get_footer_len		(FuDfuFirmware	*self);
 GBytes		*fu_dfu_firmware_append_footer		(FuDfuFirmware	*self,
 							 GBytes		*contents,
 							 GError		**error);
+gboolean	 fu_dfu_firmware_write_footer_stream	(FuDfuFirmware	*self,
+							 GOutputStream	*stream,
+							 guint32	 crc,
+							 GError		**error);
 gboolean	 fu_dfu_firmware_parse_footer		(FuDfuFirmware	*self,
 							 GBytes		*fw,
 							 FwupdInstallFlags flags,
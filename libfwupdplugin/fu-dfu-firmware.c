@@ -325,6 +325,27 @@ fu_dfu_firmware_append_footer (FuDfuFirmware *self, GBytes *contents, GError **e
 	return g_byte_array_free_to_bytes (buf);
 }
 
+/* @crc is the running state of everything already written to @stream */
+gboolean
+fu_dfu_firmware_write_footer_stream (FuDfuFirmware *self,
+				     GOutputStream *stream,
+				     guint32 crc,
+				     GError **error)
+{
+	FuDfuFirmwarePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+
+	fu_byte_array_append_uint16 (buf, priv->release, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, priv->pid, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, priv->vid, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint16 (buf, priv->version, G_LITTLE_ENDIAN);
+	g_byte_array_append (buf, (const guint8 *) "UFD", 3);
+	fu_byte_array_append_uint8 (buf, sizeof(FuDfuFirmwareFooter));
+	crc = ~fu_common_crc32_full (buf->data, buf->len, crc, 0xEDB88320);
+	fu_byte_array_append_uint32 (buf, crc, G_LITTLE_ENDIAN);
+	return g_output_stream_write_all (stream, buf->data, buf->len, NULL, NULL, error);
+}
+
 static GBytes *
 fu_dfu_firmware_write (FuFirmware *firmware, GError **error)
 {
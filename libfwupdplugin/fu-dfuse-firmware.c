@@ -216,45 +216,36 @@ fu_dfuse_firmware_parse (FuFirmware *firmware,
 	return TRUE;
 }
 
-static GBytes *
-fu_firmware_image_chunk_write (FuChunk *chk)
+static gboolean
+fu_dfuse_firmware_write_data (GOutputStream *stream,
+			      const guint8 *buf,
+			      gsize bufsz,
+			      guint32 *crc,
+			      GError **error)
 {
-	DfuSeElementHdr hdr = { 0x0 };
-	const guint8 *data = fu_chunk_get_data (chk);
-	gsize length = fu_chunk_get_data_sz (chk);
-	g_autoptr(GByteArray) buf = NULL;
-
-	buf = g_byte_array_sized_new (sizeof(DfuSeElementHdr) + length);
-	hdr.address = GUINT32_TO_LE (fu_chunk_get_address (chk));
-	hdr.size = GUINT32_TO_LE (length);
-	g_byte_array_append (buf, (const guint8 *) &hdr, sizeof(hdr));
-	g_byte_array_append (buf, data, length);
-	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+	*crc = ~fu_common_crc32_full (buf, bufsz, *crc, 0xEDB88320);
+	return g_output_stream_write_all (stream, buf, bufsz, NULL, NULL, error);
 }
 
-static GBytes *
-fu_dfuse_firmware_image_write (FuFirmwareImage *image, GError **error)
+static gsize
+fu_dfuse_firmware_chunks_get_size (GPtrArray *chunks)
 {
-	DfuSeImageHdr hdr = { 0x0 };
 	gsize totalsz = 0;
-	g_autoptr(GByteArray) buf = NULL;
-	g_autoptr(GPtrArray) blobs = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
-
-	/* get total size */
-	blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
-	chunks = fu_firmware_image_get_chunks (image, error);
-	if (chunks == NULL)
-		return NULL;
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
-		GBytes *bytes = fu_firmware_image_chunk_write (chk);
-		g_ptr_array_add (blobs, bytes);
-		totalsz += g_bytes_get_size (bytes);
+		totalsz += sizeof(DfuSeElementHdr) + fu_chunk_get_data_sz (chk);
 	}
+	return totalsz;
+}
 
-	/* mutable output buffer */
-	buf = g_byte_array_sized_new (sizeof(DfuSeImageHdr) + totalsz);
+static gboolean
+fu_dfuse_firmware_image_write_stream (FuFirmwareImage *image,
+				      GPtrArray *chunks,
+				      GOutputStream *stream,
+				      guint32 *crc,
+				      GError **error)
+{
+	DfuSeImageHdr hdr = { 0x0 };
 
 	/* add prefix */
 	memcpy (hdr.sig, "Target", 6);
@@ -265,71 +256,79 @@ fu_dfuse_firmware_image_write (FuFirmwareImage *image, GError **error)
 			   fu_firmware_image_get_id (image),
 			   sizeof(hdr.target_name));
 	}
-	hdr.target_size = GUINT32_TO_LE (totalsz);
+	hdr.target_size = GUINT32_TO_LE (fu_dfuse_firmware_chunks_get_size (chunks));
 	hdr.chunks = GUINT32_TO_LE (chunks->len);
-	g_byte_array_append (buf, (const guint8 *) &hdr, sizeof(hdr));
-
-	/* copy data */
-	for (guint i = 0; i < blobs->len; i++) {
-		GBytes *blob = g_ptr_array_index (blobs, i);
-		g_byte_array_append (buf,
-				     g_bytes_get_data (blob, NULL),
-				     g_bytes_get_size (blob));
+	if (!fu_dfuse_firmware_write_data (stream, (const guint8 *) &hdr,
+					   sizeof(hdr), crc, error))
+		return FALSE;
+
+	/* each element, without copying the data */
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		DfuSeElementHdr hdr_elem = { 0x0 };
+		hdr_elem.address = GUINT32_TO_LE (fu_chunk_get_address (chk));
+		hdr_elem.size = GUINT32_TO_LE (fu_chunk_get_data_sz (chk));
+		if (!fu_dfuse_firmware_write_data (stream, (const guint8 *) &hdr_elem,
+						   sizeof(hdr_elem), crc, error))
+			return FALSE;
+		if (!fu_dfuse_firmware_write_data (stream,
+						   fu_chunk_get_data (chk),
+						   fu_chunk_get_data_sz (chk),
+						   crc, error))
+			return FALSE;
 	}
-	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+	return TRUE;
 }
 
-static GBytes *
-fu_dfuse_firmware_write (FuFirmware *firmware, GError **error)
+static gboolean
+fu_dfuse_firmware_write_stream (FuFirmware *firmware, GOutputStream *stream, GError **error)
 {
 	DfuSeHdr hdr = { 0x0 };
 	gsize totalsz = 0;
-	g_autoptr(GByteArray) buf = NULL;
-	g_autoptr(GBytes) blob_noftr = NULL;
-	g_autoptr(GPtrArray) blobs = NULL;
+	guint32 crc = 0xFFFFFFFF;
+	g_autoptr(GPtrArray) chunks_all = NULL;
 	g_autoptr(GPtrArray) images = NULL;
 
-	/* create mutable output buffer */
-	blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	/* sizes are needed in the headers before any data is written */
 	images = fu_firmware_get_images (FU_FIRMWARE (firmware));
+	if (images->len > G_MAXUINT8) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "too many (%u) images to write DfuSe file",
+			     images->len);
+		return FALSE;
+	}
+	chunks_all = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
 	for (guint i = 0; i < images->len; i++) {
 		FuFirmwareImage *img = g_ptr_array_index (images, i);
-		g_autoptr(GBytes) blob = NULL;
-		blob = fu_dfuse_firmware_image_write (img, error);
-		if (blob == NULL)
-			return NULL;
-		totalsz += g_bytes_get_size (blob);
-		g_ptr_array_add (blobs, g_steal_pointer (&blob));
+		GPtrArray *chunks = fu_firmware_image_get_chunks (img, error);
+		if (chunks == NULL)
+			return FALSE;
+		totalsz += sizeof(DfuSeImageHdr) + fu_dfuse_firmware_chunks_get_size (chunks);
+		g_ptr_array_add (chunks_all, chunks);
 	}
-	buf = g_byte_array_sized_new (sizeof(DfuSeHdr) + totalsz);
 
 	/* DfuSe header */
 	memcpy (hdr.sig, "DfuSe", 5);
 	hdr.ver = 0x01;
 	hdr.image_size = GUINT32_TO_LE (sizeof(hdr) + totalsz);
-	if (images->len > G_MAXUINT8) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INTERNAL,
-			     "too many (%u) images to write DfuSe file",
-			     images->len);
-		return NULL;
-	}
 	hdr.targets = (guint8) images->len;
-	g_byte_array_append (buf, (const guint8 *) &hdr, sizeof(hdr));
-
-	/* copy images */
-	for (guint i = 0; i < blobs->len; i++) {
-		GBytes *blob = g_ptr_array_index (blobs, i);
-		g_byte_array_append (buf,
-				     g_bytes_get_data (blob, NULL),
-				     g_bytes_get_size (blob));
+	if (!fu_dfuse_firmware_write_data (stream, (const guint8 *) &hdr,
+					   sizeof(hdr), &crc, error))
+		return FALSE;
+
+	/* each image */
+	for (guint i = 0; i < images->len; i++) {
+		FuFirmwareImage *img = g_ptr_array_index (images, i);
+		GPtrArray *chunks = g_ptr_array_index (chunks_all, i);
+		if (!fu_dfuse_firmware_image_write_stream (img, chunks, stream, &crc, error))
+			return FALSE;
 	}
 
-	/* return blob */
-	blob_noftr = g_byte_array_free_to_bytes (g_steal_pointer (&buf));
-	return fu_dfu_firmware_append_footer (FU_DFU_FIRMWARE (firmware),
-					      blob_noftr, error);
+	/* DFU footer, including the CRC of everything before it */
+	return fu_dfu_firmware_write_footer_stream (FU_DFU_FIRMWARE (firmware),
+						    stream, crc, error);
 }
 
 static void
@@ -343,7 +342,9 @@ fu_dfuse_firmware_class_init (FuDfuseFirmwareClass *klass)
 {
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
 	klass_firmware->parse = fu_dfuse_firmware_parse;
-	klass_firmware->write = fu_dfuse_firmware_write;
+	/* do not inherit the single-image DFU writer */
+	klass_firmware->write = NULL;
+	klass_firmware->write_stream = fu_dfuse_firmware_write_stream;
 }
 
 /**
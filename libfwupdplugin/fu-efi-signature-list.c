@@ -24,6 +24,9 @@
 
 struct _FuEfiSignatureList {
 	FuFirmware		 parent_instance;
+	GHashTable		*checksums;	/* SHA256:1 */
+	gboolean		 checksums_only;
+	guint			 csum_cnt;
 };
 
 G_DEFINE_TYPE (FuEfiSignatureList, fu_efi_signature_list, FU_TYPE_FIRMWARE)
@@ -39,6 +42,7 @@ fu_efi_signature_list_parse_item (FuEfiSignatureList *self,
 {
 	fwupd_guid_t guid;
 	gsize sig_datasz;
+	g_autofree gchar *checksum = NULL;
 	g_autofree gchar *sig_owner = NULL;
 	g_autofree guint8 *sig_data = NULL;
 	g_autoptr(FuEfiSignature) sig = NULL;
@@ -70,9 +74,20 @@ fu_efi_signature_list_parse_item (FuEfiSignatureList *self,
 		return FALSE;
 	}
 
-	/* create item */
+	/* the hash set is used for lookups without iterating the images */
+	checksum = fu_efi_signature_checksum_for_data (sig_kind, G_CHECKSUM_SHA256,
+						       sig_data, sig_datasz);
 	sig_owner = fwupd_guid_to_string (&guid, FWUPD_GUID_FLAG_MIXED_ENDIAN);
-	data = g_bytes_new (sig_data, sig_datasz);
+	if (sig_kind == FU_EFI_SIGNATURE_KIND_SHA256 &&
+	    g_strcmp0 (sig_owner, FU_EFI_SIGNATURE_GUID_OVMF) != 0 &&
+	    g_strcmp0 (sig_owner, FU_EFI_SIGNATURE_GUID_OVMF_LEGACY) != 0)
+		self->csum_cnt++;
+	g_hash_table_add (self->checksums, g_steal_pointer (&checksum));
+	if (self->checksums_only)
+		return TRUE;
+
+	/* create item */
+	data = g_bytes_new_take (g_steal_pointer (&sig_data), sig_datasz);
 	sig = fu_efi_signature_new (sig_kind, sig_owner);
 	fu_firmware_image_set_bytes (FU_FIRMWARE_IMAGE (sig), data);
 	fu_firmware_add_image (FU_FIRMWARE (self), FU_FIRMWARE_IMAGE (sig));
@@ -151,27 +166,6 @@ fu_efi_signature_list_parse_list (FuEfiSignatureList *self,
 	return TRUE;
 }
 
-static gchar *
-fu_efi_signature_list_get_version (FuEfiSignatureList *self)
-{
-	guint csum_cnt = 0;
-	const gchar *ignored_guids[] = {
-		FU_EFI_SIGNATURE_GUID_OVMF,
-		FU_EFI_SIGNATURE_GUID_OVMF_LEGACY,
-		NULL };
-	g_autoptr(GPtrArray) sigs = NULL;
-	sigs = fu_firmware_get_images (FU_FIRMWARE (self));
-	for (guint i = 0; i < sigs->len; i++) {
-		FuEfiSignature *sig = g_ptr_array_index (sigs, i);
-		if (fu_efi_signature_get_kind (sig) != FU_EFI_SIGNATURE_KIND_SHA256)
-			continue;
-		if (g_strv_contains (ignored_guids, fu_efi_signature_get_owner (sig)))
-			continue;
-		csum_cnt++;
-	}
-	return g_strdup_printf ("%u", csum_cnt);
-}
-
 static gboolean
 fu_efi_signature_list_parse (FuFirmware *firmware,
 			     GBytes *fw,
@@ -186,6 +180,9 @@ fu_efi_signature_list_parse (FuFirmware *firmware,
 	const guint8 *buf = g_bytes_get_data (fw, &bufsz);
 	g_autofree gchar *version_str = NULL;
 
+	g_hash_table_remove_all (self->checksums);
+	self->csum_cnt = 0;
+
 	/* this allows us to skip the efi permissions uint32_t or even the
 	 * Microsoft PKCS-7 signature */
 	if ((flags & FWUPD_INSTALL_FLAG_NO_SEARCH) == 0) {
@@ -212,10 +209,9 @@ fu_efi_signature_list_parse (FuFirmware *firmware,
 			return FALSE;
 	}
 
-	/* set version */
-	version_str = fu_efi_signature_list_get_version (self);
-	if (version_str != NULL)
-		fu_firmware_set_version (firmware, version_str);
+	/* set version, ignoring the OVMF test hashes */
+	version_str = g_strdup_printf ("%u", self->csum_cnt);
+	fu_firmware_set_version (firmware, version_str);
 
 	/* success */
 	return TRUE;
@@ -250,6 +246,45 @@ fu_efi_signature_list_write (FuFirmware *firmware, GError **error)
 	return g_byte_array_free_to_bytes (buf);
 }
 
+/**
+ * fu_efi_signature_list_set_checksums_only:
+ * @self: A #FuEfiSignatureList
+ * @checksums_only: boolean
+ *
+ * Sets if a #FuEfiSignature image should not be created for each signature
+ * when parsing, which is useful when only fu_efi_signature_list_has_checksum()
+ * is going to be used on a large list.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_efi_signature_list_set_checksums_only (FuEfiSignatureList *self,
+					  gboolean checksums_only)
+{
+	g_return_if_fail (FU_IS_EFI_SIGNATURE_LIST (self));
+	self->checksums_only = checksums_only;
+}
+
+/**
+ * fu_efi_signature_list_has_checksum:
+ * @self: A #FuEfiSignatureList
+ * @checksum: a lowercase SHA256 hash, e.g. an Authenticode checksum
+ *
+ * Finds out if any signature in the parsed list has the checksum, using the
+ * same checksum as fu_firmware_image_get_checksum() with %G_CHECKSUM_SHA256.
+ *
+ * Returns: %TRUE if found
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_efi_signature_list_has_checksum (FuEfiSignatureList *self, const gchar *checksum)
+{
+	g_return_val_if_fail (FU_IS_EFI_SIGNATURE_LIST (self), FALSE);
+	g_return_val_if_fail (checksum != NULL, FALSE);
+	return g_hash_table_contains (self->checksums, checksum);
+}
+
 /**
  * fu_efi_signature_list_new:
  *
@@ -263,10 +298,20 @@ fu_efi_signature_list_new (void)
 	return g_object_new (FU_TYPE_EFI_SIGNATURE_LIST, NULL);
 }
 
+static void
+fu_efi_signature_list_finalize (GObject *obj)
+{
+	FuEfiSignatureList *self = FU_EFI_SIGNATURE_LIST (obj);
+	g_hash_table_unref (self->checksums);
+	G_OBJECT_CLASS (fu_efi_signature_list_parent_class)->finalize (obj);
+}
+
 static void
 fu_efi_signature_list_class_init (FuEfiSignatureListClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
+	object_class->finalize = fu_efi_signature_list_finalize;
 	klass_firmware->parse = fu_efi_signature_list_parse;
 	klass_firmware->write = fu_efi_signature_list_write;
 }
@@ -274,4 +319,5 @@ fu_efi_signature_list_class_init (FuEfiSignatureListClass *klass)
 static void
 fu_efi_signature_list_init (FuEfiSignatureList *self)
 {
+	self->checksums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
@@ -12,3 +12,7 @@
 G_DECLARE_FINAL_TYPE (FuEfiSignatureList, fu_efi_signature_list, FU, EFI_SIGNATURE_LIST, FuFirmware)
 
 FuFirmware		*fu_efi_signature_list_new		(void);
+void			 fu_efi_signature_list_set_checksums_only (FuEfiSignatureList *self,
+								  gboolean	 checksums_only);
+gboolean		 fu_efi_signature_list_has_checksum	(FuEfiSignatureList *self,
+								 const gchar	*checksum);
@@ -10,3 +10,7 @@
 
 FuEfiSignature	*fu_efi_signature_new			(FuEfiSignatureKind kind,
 							 const gchar	*owner);
+gchar		*fu_efi_signature_checksum_for_data	(FuEfiSignatureKind kind,
+							 GChecksumType	 csum_kind,
+							 const guint8	*buf,
+							 gsize		 bufsz);
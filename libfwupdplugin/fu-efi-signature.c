@@ -99,29 +99,38 @@ fu_efi_signature_get_owner (FuEfiSignature *self)
 	return self->owner;
 }
 
-static gchar *
-fu_efi_signature_get_checksum (FuFirmwareImage *firmware_image,
-			       GChecksumType csum_kind,
-			       GError **error)
+/* also used by FuEfiSignatureList when not creating a FuEfiSignature */
+gchar *
+fu_efi_signature_checksum_for_data (FuEfiSignatureKind kind,
+				    GChecksumType csum_kind,
+				    const guint8 *buf,
+				    gsize bufsz)
 {
-	FuEfiSignature *self = FU_EFI_SIGNATURE (firmware_image);
-	g_autoptr(GBytes) data = fu_firmware_image_get_bytes (firmware_image);
-
 	/* special case: this is *literally* a hash */
-	if (self->kind == FU_EFI_SIGNATURE_KIND_SHA256 &&
+	if (kind == FU_EFI_SIGNATURE_KIND_SHA256 &&
 	    csum_kind == G_CHECKSUM_SHA256) {
-		GString *str;
-		const guint8 *buf;
-		gsize bufsz = 0;
-		buf = g_bytes_get_data (data, &bufsz);
-		str = g_string_new (NULL);
+		GString *str = g_string_sized_new (bufsz * 2);
 		for (gsize i = 0; i < bufsz; i++)
 			g_string_append_printf (str, "%02x", buf[i]);
 		return g_string_free (str, FALSE);
 	}
 
 	/* fallback */
-	return g_compute_checksum_for_bytes (csum_kind, data);
+	return g_compute_checksum_for_data (csum_kind, buf, bufsz);
+}
+
+static gchar *
+fu_efi_signature_get_checksum (FuFirmwareImage *firmware_image,
+			       GChecksumType csum_kind,
+			       GError **error)
+{
+	FuEfiSignature *self = FU_EFI_SIGNATURE (firmware_image);
+	gsize bufsz = 0;
+	const guint8 *buf;
+	g_autoptr(GBytes) data = fu_firmware_image_get_bytes (firmware_image);
+
+	buf = g_bytes_get_data (data, &bufsz);
+	return fu_efi_signature_checksum_for_data (self->kind, csum_kind, buf, bufsz);
 }
 
 static void
@@ -36,6 +36,141 @@ fu_efivar_get_filename (const gchar *guid, const gchar *name)
 	return g_strdup_printf ("%s/%s-%s", efivardir, name, guid);
 }
 
+/* a snapshot of efivarfs built from one directory scan, with the contents of
+ * each variable read on first use; only used after fu_efivar_set_cache_enabled() */
+typedef struct {
+	guint32			 attr;
+	GBytes			*blob;		/* (nullable): not yet read */
+} FuEfivarCacheItem;
+
+G_LOCK_DEFINE_STATIC (efivar_cache);
+static gboolean efivar_cache_enabled = FALSE;
+static GHashTable *efivar_cache = NULL;		/* (nullable) name-guid : FuEfivarCacheItem */
+static GPtrArray *efivar_cache_names = NULL;	/* (nullable) name-guid, in directory order */
+static GFileMonitor *efivar_cache_monitor = NULL;
+static gint efivar_read_count = 0;
+
+static void
+fu_efivar_cache_item_free (FuEfivarCacheItem *item)
+{
+	if (item->blob != NULL)
+		g_bytes_unref (item->blob);
+	g_free (item);
+}
+
+static void
+fu_efivar_cache_invalidate (void)
+{
+	G_LOCK (efivar_cache);
+	g_clear_pointer (&efivar_cache, g_hash_table_unref);
+	g_clear_pointer (&efivar_cache_names, g_ptr_array_unref);
+	G_UNLOCK (efivar_cache);
+}
+
+/* must be called with the lock held, returns %FALSE if the cache is unused */
+static gboolean
+fu_efivar_cache_ensure_locked (void)
+{
+	const gchar *fn;
+	g_autofree gchar *efivardir = NULL;
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!efivar_cache_enabled)
+		return FALSE;
+	if (efivar_cache != NULL)
+		return TRUE;
+	efivardir = fu_efivar_get_path ();
+	g_atomic_int_inc (&efivar_read_count);
+	dir = g_dir_open (efivardir, 0, &error_local);
+	if (dir == NULL) {
+		g_debug ("not caching efivars: %s", error_local->message);
+		return FALSE;
+	}
+	efivar_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					      (GDestroyNotify) fu_efivar_cache_item_free);
+	efivar_cache_names = g_ptr_array_new_with_free_func (g_free);
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		g_hash_table_insert (efivar_cache, g_strdup (fn), g_new0 (FuEfivarCacheItem, 1));
+		g_ptr_array_add (efivar_cache_names, g_strdup (fn));
+	}
+	return TRUE;
+}
+
+static void
+fu_efivar_cache_monitor_changed_cb (GFileMonitor *monitor,
+				    GFile *file,
+				    GFile *other_file,
+				    GFileMonitorEvent event_type,
+				    gpointer user_data)
+{
+	fu_efivar_cache_invalidate ();
+}
+
+/**
+ * fu_efivar_set_cache_enabled:
+ * @enabled: %TRUE to cache variables
+ * @error: A #GError
+ *
+ * Snapshots the list of variables with one directory scan and keeps the
+ * contents of each variable after it is first read. The snapshot is discarded
+ * when efivarfs is modified, either by this process or by anything else.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_efivar_set_cache_enabled (gboolean enabled, GError **error)
+{
+	g_autofree gchar *efivardir = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFileMonitor) monitor = NULL;
+
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* disable */
+	if (!enabled) {
+		fu_efivar_cache_invalidate ();
+		G_LOCK (efivar_cache);
+		efivar_cache_enabled = FALSE;
+		monitor = g_steal_pointer (&efivar_cache_monitor);
+		G_UNLOCK (efivar_cache);
+		return TRUE;
+	}
+
+	/* watch for changes made by other processes */
+	efivardir = fu_efivar_get_path ();
+	file = g_file_new_for_path (efivardir);
+	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, error);
+	if (monitor == NULL)
+		return FALSE;
+	g_signal_connect (monitor, "changed",
+			  G_CALLBACK (fu_efivar_cache_monitor_changed_cb), NULL);
+	G_LOCK (efivar_cache);
+	g_set_object (&efivar_cache_monitor, monitor);
+	efivar_cache_enabled = TRUE;
+	G_UNLOCK (efivar_cache);
+	fu_efivar_cache_invalidate ();
+	return TRUE;
+}
+
+/**
+ * fu_efivar_get_read_count:
+ *
+ * Gets the number of times efivarfs has been read from, which is useful when
+ * profiling how effective the cache is.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.8
+ **/
+guint
+fu_efivar_get_read_count (void)
+{
+	return (guint) g_atomic_int_get (&efivar_read_count);
+}
+
 /**
  * fu_efivar_supported:
  * @error: #GError
@@ -190,6 +325,7 @@ fu_efivar_delete (const gchar *guid, const gchar *name, GError **error)
 		g_prefix_error (error, "failed to set %s as mutable: ", fn);
 		return FALSE;
 	}
+	fu_efivar_cache_invalidate ();
 	return g_file_delete (file, NULL, error);
 }
 
@@ -229,6 +365,7 @@ fu_efivar_delete_with_glob (const gchar *guid, const gchar *name_glob, GError **
 				g_prefix_error (error, "failed to set %s as mutable: ", keyfn);
 				return FALSE;
 			}
+			fu_efivar_cache_invalidate ();
 			if (!g_file_delete (file, NULL, error))
 				return FALSE;
 		}
@@ -275,27 +412,22 @@ fu_efivar_exists (const gchar *guid, const gchar *name)
 	if (name == NULL)
 		return fu_efivar_exists_guid (guid);
 
+	G_LOCK (efivar_cache);
+	if (fu_efivar_cache_ensure_locked ()) {
+		g_autofree gchar *name_guid = g_strdup_printf ("%s-%s", name, guid);
+		gboolean ret = g_hash_table_contains (efivar_cache, name_guid);
+		G_UNLOCK (efivar_cache);
+		return ret;
+	}
+	G_UNLOCK (efivar_cache);
+
 	fn = fu_efivar_get_filename (guid, name);
+	g_atomic_int_inc (&efivar_read_count);
 	return g_file_test (fn, G_FILE_TEST_EXISTS);
 }
 
-/**
- * fu_efivar_get_data:
- * @guid: Globally unique identifier
- * @name: Variable name
- * @data: Data to set
- * @data_sz: Size of data
- * @attr: Attributes
- * @error: A #GError
- *
- * Gets the data from a UEFI variable in NVRAM
- *
- * Returns: %TRUE on success
- *
- * Since: 1.4.0
- **/
-gboolean
-fu_efivar_get_data (const gchar *guid, const gchar *name, guint8 **data,
+static gboolean
+fu_efivar_get_data_fs (const gchar *guid, const gchar *name, guint8 **data,
 		       gsize *data_sz, guint32 *attr, GError **error)
 {
 #ifndef _WIN32
@@ -308,12 +440,9 @@ fu_efivar_get_data (const gchar *guid, const gchar *name, guint8 **data,
 	g_autoptr(GFileInfo) info = NULL;
 	g_autoptr(GInputStream) istr = NULL;
 
-	g_return_val_if_fail (guid != NULL, FALSE);
-	g_return_val_if_fail (name != NULL, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
 	/* open file as stream */
 	fn = fu_efivar_get_filename (guid, name);
+	g_atomic_int_inc (&efivar_read_count);
 	file = g_file_new_for_path (fn);
 	istr = G_INPUT_STREAM (g_file_read (file, NULL, error));
 	if (istr == NULL)
@@ -368,6 +497,77 @@ fu_efivar_get_data (const gchar *guid, const gchar *name, guint8 **data,
 #endif
 }
 
+/**
+ * fu_efivar_get_data:
+ * @guid: Globally unique identifier
+ * @name: Variable name
+ * @data: Data to set
+ * @data_sz: Size of data
+ * @attr: Attributes
+ * @error: A #GError
+ *
+ * Gets the data from a UEFI variable in NVRAM
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 1.4.0
+ **/
+gboolean
+fu_efivar_get_data (const gchar *guid, const gchar *name, guint8 **data,
+		       gsize *data_sz, guint32 *attr, GError **error)
+{
+	FuEfivarCacheItem *item;
+	g_autofree gchar *name_guid = NULL;
+	g_autofree guint8 *data_tmp = NULL;
+	gsize data_sz_tmp = 0;
+	guint32 attr_tmp = 0;
+
+	g_return_val_if_fail (guid != NULL, FALSE);
+	g_return_val_if_fail (name != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* not using the snapshot */
+	G_LOCK (efivar_cache);
+	if (!fu_efivar_cache_ensure_locked ()) {
+		G_UNLOCK (efivar_cache);
+		return fu_efivar_get_data_fs (guid, name, data, data_sz, attr, error);
+	}
+	name_guid = g_strdup_printf ("%s-%s", name, guid);
+	item = g_hash_table_lookup (efivar_cache, name_guid);
+	if (item == NULL) {
+		G_UNLOCK (efivar_cache);
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "efivar %s does not exist", name_guid);
+		return FALSE;
+	}
+
+	/* read on first use */
+	if (item->blob == NULL) {
+		if (!fu_efivar_get_data_fs (guid, name, &data_tmp, &data_sz_tmp,
+					    &attr_tmp, error)) {
+			G_UNLOCK (efivar_cache);
+			return FALSE;
+		}
+		item->attr = attr_tmp;
+		item->blob = g_bytes_new (data_tmp, data_sz_tmp);
+	}
+	if (attr != NULL)
+		*attr = item->attr;
+	if (data_sz != NULL)
+		*data_sz = g_bytes_get_size (item->blob);
+	if (data != NULL) {
+		gsize bufsz = 0;
+		const guint8 *buf = g_bytes_get_data (item->blob, &bufsz);
+		*data = g_malloc0 (bufsz);
+		if (bufsz > 0)
+			memcpy (*data, buf, bufsz);
+	}
+	G_UNLOCK (efivar_cache);
+	return TRUE;
+}
+
 /**
  * fu_efivar_get_data_bytes:
  * @guid: Globally unique identifier
@@ -399,6 +599,16 @@ fu_efivar_get_data_bytes (const gchar *guid,
 	return g_bytes_new_take (data, datasz);
 }
 
+static void
+fu_efivar_add_name_for_guid (GPtrArray *names, const gchar *name_guid, const gchar *guid)
+{
+	gsize name_guidsz = strlen (name_guid);
+	if (name_guidsz < 38)
+		return;
+	if (g_strcmp0 (name_guid + name_guidsz - 36, guid) == 0)
+		g_ptr_array_add (names, g_strndup (name_guid, name_guidsz - 37));
+}
+
 /**
  * fu_efivar_get_names:
  * @guid: Globally unique identifier
@@ -423,17 +633,21 @@ fu_efivar_get_names (const gchar *guid, GError **error)
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
 	/* find names with matching GUID */
-	dir = g_dir_open (path, 0, error);
-	if (dir == NULL)
-		return NULL;
-	while ((name_guid = g_dir_read_name (dir)) != NULL) {
-		gsize name_guidsz = strlen (name_guid);
-		if (name_guidsz < 38)
-			continue;
-		if (g_strcmp0 (name_guid + name_guidsz - 36, guid) == 0) {
-			g_ptr_array_add (names,
-					 g_strndup (name_guid, name_guidsz - 37));
+	G_LOCK (efivar_cache);
+	if (fu_efivar_cache_ensure_locked ()) {
+		for (guint i = 0; i < efivar_cache_names->len; i++) {
+			name_guid = g_ptr_array_index (efivar_cache_names, i);
+			fu_efivar_add_name_for_guid (names, name_guid, guid);
 		}
+		G_UNLOCK (efivar_cache);
+	} else {
+		G_UNLOCK (efivar_cache);
+		g_atomic_int_inc (&efivar_read_count);
+		dir = g_dir_open (path, 0, error);
+		if (dir == NULL)
+			return NULL;
+		while ((name_guid = g_dir_read_name (dir)) != NULL)
+			fu_efivar_add_name_for_guid (names, name_guid, guid);
 	}
 
 	/* nothing found */
@@ -561,6 +775,7 @@ fu_efivar_set_data (const gchar *guid, const gchar *name, const guint8 *data,
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
 	/* create empty file so we can clear the immutable bit before writing */
+	fu_efivar_cache_invalidate ();
 	if (!g_file_query_exists (file, NULL)) {
 		g_autoptr(GFileOutputStream) ostr_tmp = NULL;
 		ostr_tmp = g_file_create (file,
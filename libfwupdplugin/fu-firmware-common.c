@@ -282,3 +282,69 @@ fu_firmware_strparse_uint32_safe (const gchar *data,
 		*value = (guint32) g_ascii_strtoull (buffer, NULL, 16);
 	return TRUE;
 }
+
+static inline guint8
+fu_firmware_strparse_nibble (gchar c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return 0xff;
+}
+
+/**
+ * fu_firmware_strparse_hex_safe:
+ * @data: source string
+ * @datasz: size of @data, typcally the same as `strlen(data)`
+ * @offset: offset in chars into @data to read
+ * @buf: destination buffer
+ * @bufsz: number of bytes to write into @buf
+ * @error: A #GError or %NULL
+ *
+ * Parses @bufsz bytes from a string of base 16 digits, which must be
+ * @bufsz * 2 characters in length. Unlike fu_firmware_strparse_uint8_safe()
+ * this does not need a temporary copy of each pair of digits, and any
+ * character that is not a hex digit is an error.
+ *
+ * Return value: %TRUE if parsed, %FALSE otherwise
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_firmware_strparse_hex_safe (const gchar *data,
+			       gsize datasz,
+			       gsize offset,
+			       guint8 *buf,
+			       gsize bufsz,
+			       GError **error)
+{
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (buf != NULL || bufsz == 0, FALSE);
+
+	if (offset > datasz || (datasz - offset) / 2 < bufsz) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_READ,
+			     "requested read of 0x%02x chars at 0x%02x "
+			     "from a string of size 0x%02x",
+			     (guint) bufsz * 2, (guint) offset, (guint) datasz);
+		return FALSE;
+	}
+	for (gsize i = 0; i < bufsz; i++) {
+		guint8 hi = fu_firmware_strparse_nibble (data[offset + (i * 2)]);
+		guint8 lo = fu_firmware_strparse_nibble (data[offset + (i * 2) + 1]);
+		if ((hi | lo) & 0xf0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "invalid hex digit at 0x%02x",
+				     (guint) (offset + (i * 2)));
+			return FALSE;
+		}
+		buf[i] = (hi << 4) | lo;
+	}
+	return TRUE;
+}
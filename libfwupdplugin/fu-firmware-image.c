@@ -28,6 +28,8 @@ typedef struct {
 	gchar			*version;
 	gchar			*filename;
 	GPtrArray		*chunks;	/* nullable, element-type FuChunk */
+	GBytes			*bytes_deferred;	/* nullable */
+	FwupdInstallFlags	 flags_deferred;
 } FuFirmwareImagePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuFirmwareImage, fu_firmware_image, G_TYPE_OBJECT)
@@ -295,11 +297,75 @@ GBytes *
 fu_firmware_image_get_bytes (FuFirmwareImage *self)
 {
 	FuFirmwareImagePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GError) error_local = NULL;
 	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), NULL);
+	if (!fu_firmware_image_ensure_parsed (self, &error_local)) {
+		g_warning ("failed to parse deferred image %s: %s",
+			   priv->id, error_local->message);
+		return NULL;
+	}
 	if (priv->bytes == NULL)
 		return NULL;
 	return g_bytes_ref (priv->bytes);
 }
+
+/**
+ * fu_firmware_image_parse_deferred:
+ * @self: a #FuFirmwareImage
+ * @fw: A #GBytes
+ * @flags: some #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ *
+ * Records the image data without parsing it. The image is parsed using
+ * fu_firmware_image_parse() the first time the data is accessed, for instance
+ * using fu_firmware_image_get_bytes() or fu_firmware_image_write().
+ *
+ * Any properties set by the subclassed parse vfunc, e.g. the version, are not
+ * available until the image has been parsed.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_firmware_image_parse_deferred (FuFirmwareImage *self,
+				  GBytes *fw,
+				  FwupdInstallFlags flags)
+{
+	FuFirmwareImagePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_FIRMWARE_IMAGE (self));
+	g_return_if_fail (fw != NULL);
+	g_return_if_fail (priv->bytes == NULL);
+	if (priv->bytes_deferred != NULL)
+		g_bytes_unref (priv->bytes_deferred);
+	priv->bytes_deferred = g_bytes_ref (fw);
+	priv->flags_deferred = flags;
+}
+
+/**
+ * fu_firmware_image_ensure_parsed:
+ * @self: a #FuFirmwareImage
+ * @error: A #GError, or %NULL
+ *
+ * Parses the image data set with fu_firmware_image_parse_deferred(), if it has
+ * not already been parsed.
+ *
+ * Returns: %TRUE for success, or if the image was not deferred
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_firmware_image_ensure_parsed (FuFirmwareImage *self, GError **error)
+{
+	FuFirmwareImagePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GBytes) fw = NULL;
+
+	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* nothing to do, or already in progress from the vfunc */
+	if (priv->bytes_deferred == NULL)
+		return TRUE;
+	fw = g_steal_pointer (&priv->bytes_deferred);
+	return fu_firmware_image_parse (self, fw, priv->flags_deferred, error);
+}
 /**
  * fu_firmware_image_get_chunks:
  * @self: a #FuFirmwareImage
@@ -319,6 +385,9 @@ fu_firmware_image_get_chunks (FuFirmwareImage *self, GError **error)
 	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (!fu_firmware_image_ensure_parsed (self, error))
+		return NULL;
+
 	/* set */
 	if (priv->chunks != NULL)
 		return g_ptr_array_ref (priv->chunks);
@@ -386,6 +455,9 @@ fu_firmware_image_get_checksum (FuFirmwareImage *self,
 	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (!fu_firmware_image_ensure_parsed (self, error))
+		return NULL;
+
 	/* subclassed */
 	if (klass->get_checksum != NULL)
 		return klass->get_checksum (self, csum_kind, error);
@@ -545,6 +617,9 @@ fu_firmware_image_write (FuFirmwareImage *self, GError **error)
 	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (!fu_firmware_image_ensure_parsed (self, error))
+		return NULL;
+
 	/* optional vfunc */
 	if (klass->write != NULL)
 		return klass->write (self, error);
@@ -597,6 +672,9 @@ fu_firmware_image_write_chunk (FuFirmwareImage *self,
 	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (!fu_firmware_image_ensure_parsed (self, error))
+		return NULL;
+
 	/* check address requested is larger than base address */
 	if (address < priv->addr) {
 		g_set_error (error,
@@ -658,6 +736,10 @@ fu_firmware_image_add_string (FuFirmwareImage *self, guint idt, GString *str)
 		fu_common_string_append_kx (str, idt, "Data",
 					    g_bytes_get_size (priv->bytes));
 	}
+	if (priv->bytes_deferred != NULL) {
+		fu_common_string_append_kx (str, idt, "DataDeferred",
+					    g_bytes_get_size (priv->bytes_deferred));
+	}
 
 	/* add chunks */
 	if (priv->chunks != NULL) {
@@ -705,6 +787,8 @@ fu_firmware_image_finalize (GObject *object)
 	g_free (priv->filename);
 	if (priv->bytes != NULL)
 		g_bytes_unref (priv->bytes);
+	if (priv->bytes_deferred != NULL)
+		g_bytes_unref (priv->bytes_deferred);
 	if (priv->chunks != NULL)
 		g_ptr_array_unref (priv->chunks);
 	G_OBJECT_CLASS (fu_firmware_image_parent_class)->finalize (object);
@@ -81,6 +81,12 @@ gboolean	 fu_firmware_image_parse	(FuFirmwareImage	*self,
 						 FwupdInstallFlags	 flags,
 						 GError			**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+void		 fu_firmware_image_parse_deferred	(FuFirmwareImage	*self,
+						 GBytes			*fw,
+						 FwupdInstallFlags	 flags);
+gboolean	 fu_firmware_image_ensure_parsed	(FuFirmwareImage	*self,
+						 GError			**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fu_firmware_image_build	(FuFirmwareImage	*self,
 						 XbNode			*n,
 						 GError			**error)
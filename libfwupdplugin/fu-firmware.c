@@ -53,6 +53,8 @@ fu_firmware_flag_to_string (FuFirmwareFlags flag)
 		return "has-checksum";
 	if (flag == FU_FIRMWARE_FLAG_HAS_VID_PID)
 		return "has-vid-pid";
+	if (flag == FU_FIRMWARE_FLAG_DEFER_IMAGES)
+		return "defer-images";
 	return NULL;
 }
 
@@ -77,6 +79,8 @@ fu_firmware_flag_from_string (const gchar *flag)
 		return FU_FIRMWARE_FLAG_HAS_CHECKSUM;
 	if (g_strcmp0 (flag, "has-vid-pid") == 0)
 		return FU_FIRMWARE_FLAG_HAS_VID_PID;
+	if (g_strcmp0 (flag, "defer-images") == 0)
+		return FU_FIRMWARE_FLAG_DEFER_IMAGES;
 	return FU_FIRMWARE_FLAG_NONE;
 }
 
@@ -425,12 +429,21 @@ fu_firmware_parse_file (FuFirmware *self, GFile *file, FwupdInstallFlags flags,
 {
 	gchar *buf = NULL;
 	gsize bufsz = 0;
+	g_autofree gchar *fn = NULL;
 	g_autoptr(GBytes) fw = NULL;
 
 	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
 	g_return_val_if_fail (G_IS_FILE (file), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* map local files rather than copying them */
+	fn = g_file_get_path (file);
+	if (fn != NULL) {
+		fw = fu_common_get_contents_mapped (fn, error);
+		if (fw == NULL)
+			return FALSE;
+		return fu_firmware_parse (self, fw, flags, error);
+	}
 	if (!g_file_load_contents (file, NULL, &buf, &bufsz, NULL, error))
 		return FALSE;
 	fw = g_bytes_new_take (buf, bufsz);
@@ -460,10 +473,58 @@ fu_firmware_write (FuFirmware *self, GError **error)
 	if (klass->write != NULL)
 		return klass->write (self, error);
 
+	/* subclassed, so collect the stream into memory */
+	if (klass->write_stream != NULL) {
+		g_autoptr(GOutputStream) ostream = g_memory_output_stream_new_resizable ();
+		if (!klass->write_stream (self, ostream, error))
+			return NULL;
+		if (!g_output_stream_close (ostream, NULL, error))
+			return NULL;
+		return g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+	}
+
 	/* just add default blob */
 	return fu_firmware_get_image_default_bytes (self, error);
 }
 
+/**
+ * fu_firmware_write_stream:
+ * @self: A #FuFirmware
+ * @stream: A #GOutputStream
+ * @error: A #GError, or %NULL
+ *
+ * Writes a firmware to a stream, typically packing the images into a binary
+ * blob. Subclasses implementing the `write_stream` vfunc can avoid building
+ * the entire output blob in memory.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_firmware_write_stream (FuFirmware *self, GOutputStream *stream, GError **error)
+{
+	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS (self);
+	g_autoptr(GBytes) blob = NULL;
+
+	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
+	g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* subclassed */
+	if (klass->write_stream != NULL)
+		return klass->write_stream (self, stream, error);
+
+	/* fall back to the blob */
+	blob = fu_firmware_write (self, error);
+	if (blob == NULL)
+		return FALSE;
+	return g_output_stream_write_all (stream,
+					  g_bytes_get_data (blob, NULL),
+					  g_bytes_get_size (blob),
+					  NULL, NULL, error);
+}
+
 /**
  * fu_firmware_write_file:
  * @self: A #FuFirmware
@@ -479,21 +540,61 @@ fu_firmware_write (FuFirmware *self, GError **error)
 gboolean
 fu_firmware_write_file (FuFirmware *self, GFile *file, GError **error)
 {
-	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GFileOutputStream) ostream = NULL;
+	g_autoptr(GOutputStream) ostream_buf = NULL;
 
 	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
 	g_return_val_if_fail (G_IS_FILE (file), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	blob = fu_firmware_write (self, error);
-	if (blob == NULL)
+	ostream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+	if (ostream == NULL)
+		return FALSE;
+	ostream_buf = g_buffered_output_stream_new (G_OUTPUT_STREAM (ostream));
+	if (!fu_firmware_write_stream (self, ostream_buf, error)) {
+		/* closing with a cancelled cancellable keeps the original file */
+		g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+		g_cancellable_cancel (cancellable);
+		g_output_stream_close (G_OUTPUT_STREAM (ostream), cancellable, NULL);
 		return FALSE;
-	return g_file_replace_contents (file,
-					g_bytes_get_data (blob, NULL),
-					g_bytes_get_size (blob),
-					NULL, FALSE,
-					G_FILE_CREATE_NONE,
-					NULL, NULL, error);
+	}
+	return g_output_stream_close (ostream_buf, NULL, error);
+}
+
+/**
+ * fu_firmware_parse_image:
+ * @self: A #FuFirmware
+ * @img: A #FuFirmwareImage
+ * @fw: A #GBytes
+ * @flags: some #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE
+ * @error: A #GError, or %NULL
+ *
+ * Parses an image contained in the firmware. If %FU_FIRMWARE_FLAG_DEFER_IMAGES
+ * is set then the image is only parsed when the image data is first used.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_firmware_parse_image (FuFirmware *self,
+			 FuFirmwareImage *img,
+			 GBytes *fw,
+			 FwupdInstallFlags flags,
+			 GError **error)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE (self);
+
+	g_return_val_if_fail (FU_IS_FIRMWARE (self), FALSE);
+	g_return_val_if_fail (FU_IS_FIRMWARE_IMAGE (img), FALSE);
+	g_return_val_if_fail (fw != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (priv->flags & FU_FIRMWARE_FLAG_DEFER_IMAGES) {
+		fu_firmware_image_parse_deferred (img, fw, flags);
+		return TRUE;
+	}
+	return fu_firmware_image_parse (img, fw, flags, error);
 }
 
 /**
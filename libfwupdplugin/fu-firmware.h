@@ -39,8 +39,12 @@ struct _FuFirmwareClass
 							 XbNode		*n,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+	gboolean		 (*write_stream)	(FuFirmware	*self,
+							 GOutputStream	*stream,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 	/*< private >*/
-	gpointer		 padding[27];
+	gpointer		 padding[26];
 };
 
 /**
@@ -50,6 +54,7 @@ struct _FuFirmwareClass
  * @FU_FIRMWARE_FLAG_DEDUPE_IDX:		Dedupe imges by IDX
  * @FU_FIRMWARE_FLAG_HAS_CHECKSUM:		Has a CRC or checksum to test internal consistency
  * @FU_FIRMWARE_FLAG_HAS_VID_PID:		Has a vendor or product ID in the firmware
+ * @FU_FIRMWARE_FLAG_DEFER_IMAGES:		Only parse images when the data is used
  *
  * The firmware flags.
  **/
@@ -58,6 +63,7 @@ struct _FuFirmwareClass
 #define FU_FIRMWARE_FLAG_DEDUPE_IDX		(1u << 1)	/* Since: 1.5.0 */
 #define FU_FIRMWARE_FLAG_HAS_CHECKSUM		(1u << 2)	/* Since: 1.5.6 */
 #define FU_FIRMWARE_FLAG_HAS_VID_PID		(1u << 3)	/* Since: 1.5.6 */
+#define FU_FIRMWARE_FLAG_DEFER_IMAGES		(1u << 4)	/* Since: 1.5.8 */
 typedef guint64 FuFirmwareFlags;
 
 const gchar	*fu_firmware_flag_to_string		(FuFirmwareFlags flag);
@@ -114,7 +120,17 @@ gboolean	 fu_firmware_write_file			(FuFirmware	*self,
 							 GFile		*file,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_firmware_write_stream		(FuFirmware	*self,
+							 GOutputStream	*stream,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 
+gboolean	 fu_firmware_parse_image		(FuFirmware	*self,
+							 FuFirmwareImage *img,
+							 GBytes		*fw,
+							 FwupdInstallFlags flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 void		 fu_firmware_add_image			(FuFirmware	*self,
 							 FuFirmwareImage *img);
 gboolean	 fu_firmware_remove_image		(FuFirmware	*self,
@@ -170,15 +170,27 @@ fu_fmap_firmware_parse (FuFirmware *firmware,
 	return TRUE;
 }
 
-static GBytes *
-fu_fmap_firmware_write (FuFirmware *firmware, GError **error)
+static gboolean
+fu_fmap_firmware_write_padding (GOutputStream *stream, gsize padsz, GError **error)
+{
+	static const guint8 buf[0x1000] = { 0x0 };
+	while (padsz > 0) {
+		gsize chunksz = MIN (padsz, sizeof(buf));
+		if (!g_output_stream_write_all (stream, buf, chunksz, NULL, NULL, error))
+			return FALSE;
+		padsz -= chunksz;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_fmap_firmware_write_stream (FuFirmware *firmware, GOutputStream *stream, GError **error)
 {
 	FuFmapFirmware *self = FU_FMAP_FIRMWARE (firmware);
 	FuFmapFirmwarePrivate *priv = GET_PRIVATE (self);
 	gsize total_sz;
 	gsize offset;
 	g_autoptr(GPtrArray) images = fu_firmware_get_images (firmware);
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
 	FuFmap hdr = {
 		.signature = { FMAP_SIGNATURE },
 		.ver_major = 0x1,
@@ -190,8 +202,8 @@ fu_fmap_firmware_write (FuFirmware *firmware, GError **error)
 	};
 
 	/* pad to offset */
-	if (priv->offset > 0)
-		fu_byte_array_set_size (buf, priv->offset);
+	if (!fu_fmap_firmware_write_padding (stream, priv->offset, error))
+		return FALSE;
 
 	/* add header */
 	total_sz = offset = sizeof(hdr) + (sizeof(FuFmapArea) * images->len);
@@ -201,7 +213,8 @@ fu_fmap_firmware_write (FuFirmware *firmware, GError **error)
 		total_sz += g_bytes_get_size (fw);
 	}
 	hdr.size = GUINT32_TO_LE (priv->offset + total_sz);
-	g_byte_array_append (buf, (const guint8 *) &hdr, sizeof(hdr));
+	if (!g_output_stream_write_all (stream, &hdr, sizeof(hdr), NULL, NULL, error))
+		return FALSE;
 
 	/* add each area */
 	for (guint i = 0; i < images->len; i++) {
@@ -216,21 +229,24 @@ fu_fmap_firmware_write (FuFirmware *firmware, GError **error)
 		};
 		if (id != NULL)
 			strncpy ((gchar *) area.name, id, sizeof(area.name) - 1);
-		g_byte_array_append (buf, (const guint8 *) &area, sizeof(area));
+		if (!g_output_stream_write_all (stream, &area, sizeof(area), NULL, NULL, error))
+			return FALSE;
 		offset += g_bytes_get_size (fw);
 	}
 
-	/* add the images */
+	/* add the images, without copying the data */
 	for (guint i = 0; i < images->len; i++) {
 		FuFirmwareImage *img = g_ptr_array_index (images, i);
 		g_autoptr(GBytes) fw = fu_firmware_image_get_bytes (img);
-		g_byte_array_append (buf,
-				     g_bytes_get_data (fw, NULL),
-				     g_bytes_get_size (fw));
+		if (!g_output_stream_write_all (stream,
+						g_bytes_get_data (fw, NULL),
+						g_bytes_get_size (fw),
+						NULL, NULL, error))
+			return FALSE;
 	}
 
 	/* success */
-	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+	return TRUE;
 }
 
 static gboolean
@@ -263,7 +279,7 @@ fu_fmap_firmware_class_init (FuFmapFirmwareClass *klass)
 	FuFirmwareClass *klass_firmware = FU_FIRMWARE_CLASS (klass);
 	klass_firmware->to_string = fu_fmap_firmware_to_string;
 	klass_firmware->parse = fu_fmap_firmware_parse;
-	klass_firmware->write = fu_fmap_firmware_write;
+	klass_firmware->write_stream = fu_fmap_firmware_write_stream;
 	klass_firmware->build = fu_fmap_firmware_build;
 }
 
@@ -5,26 +5,75 @@
  */
 
 #include <glib.h>
+#include <stdlib.h>
 
 __attribute__((weak)) extern int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size);
 __attribute__((weak)) extern int LLVMFuzzerInitialize(int *argc, char ***argv);
 
+/* set up by afl-clang-fast when building for AFL++ persistent mode */
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+__AFL_FUZZ_INIT();
+#endif
+
+static void
+fu_fuzzer_run_file (const gchar *filename, guint iterations)
+{
+	gsize bufsz;
+	const guint8 *buf;
+	gdouble elapsed;
+	g_autoptr(GMappedFile) mapped_file = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = NULL;
+
+	g_printerr ("Running: %s\n", filename);
+	mapped_file = g_mapped_file_new (filename, FALSE, &error);
+	if (mapped_file == NULL) {
+		g_printerr ("Failed to load: %s\n", error->message);
+		return;
+	}
+	buf = (const guint8 *) g_mapped_file_get_contents (mapped_file);
+	bufsz = g_mapped_file_get_length (mapped_file);
+	timer = g_timer_new ();
+	for (guint i = 0; i < iterations; i++)
+		LLVMFuzzerTestOneInput (buf, bufsz);
+	elapsed = g_timer_elapsed (timer, NULL);
+	if (iterations > 1 && elapsed > 0.f) {
+		g_printerr ("Done, %u execs in %.2fs: %.0f execs/s\n",
+			    iterations, elapsed, (gdouble) iterations / elapsed);
+		return;
+	}
+	g_printerr ("Done\n");
+}
+
 int
 main (int argc, char **argv)
 {
+	guint iterations = 1;
+	const gchar *tmp;
+
 	g_assert (LLVMFuzzerTestOneInput != NULL);
 	if (LLVMFuzzerInitialize != NULL)
 		LLVMFuzzerInitialize (&argc, &argv);
-	for (int i = 1; i < argc; i++) {
-		gsize bufsz = 0;
-		g_autofree gchar *buf = NULL;
-		g_autoptr(GError) error = NULL;
-		g_printerr ("Running: %s\n", argv[i]);
-		if (!g_file_get_contents (argv[i], &buf, &bufsz, &error)) {
-			g_printerr ("Failed to load: %s\n", error->message);
-			continue;
-		}
-		LLVMFuzzerTestOneInput ((const guint8 *)buf, bufsz);
-		g_printerr ("Done\n");
+
+	/* run each input many times to measure the parser throughput */
+	tmp = g_getenv ("FWUPD_FUZZER_ITERATIONS");
+	if (tmp != NULL)
+		iterations = MAX (g_ascii_strtoull (tmp, NULL, 10), 1);
+
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+	/* no files, so keep the process alive and let AFL++ feed each input
+	 * using shared memory rather than forking for every one */
+	if (argc < 2) {
+		const guint8 *buf;
+		__AFL_INIT();
+		buf = __AFL_FUZZ_TESTCASE_BUF;
+		while (__AFL_LOOP (10000))
+			LLVMFuzzerTestOneInput (buf, __AFL_FUZZ_TESTCASE_LEN);
+		return EXIT_SUCCESS;
 	}
+#endif
+
+	for (int i = 1; i < argc; i++)
+		fu_fuzzer_run_file (argv[i], iterations);
+	return EXIT_SUCCESS;
 }
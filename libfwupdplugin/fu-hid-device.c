@@ -8,6 +8,7 @@
 
 #include "config.h"
 
+#include "fu-device-private.h"
 #include "fu-hid-device.h"
 
 #define FU_HID_REPORT_GET				0x01
@@ -18,6 +19,8 @@
 #define FU_HID_REPORT_TYPE_FEATURE			0x03
 
 #define FU_HID_DEVICE_RETRIES				10
+#define FU_HID_DEVICE_POLL_DELAY_MIN			1	/* ms */
+#define FU_HID_DEVICE_POLL_DELAY_MAX			32	/* ms */
 
 /**
  * SECTION:fu-hid-device
@@ -34,6 +37,9 @@ typedef struct
 	guint8			 interface;
 	gboolean		 interface_autodetect;
 	FuHidDeviceFlags	 flags;
+	guint			 report_cnt;
+	guint64			 report_total_us;
+	guint64			 report_max_us;
 } FuHidDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuHidDevice, fu_hid_device, FU_TYPE_USB_DEVICE)
@@ -155,6 +161,15 @@ fu_hid_device_close (FuDevice *device, GError **error)
 	}
 
 #ifdef HAVE_GUSB
+	/* round-trip statistics */
+	if (priv->report_cnt > 0) {
+		g_debug ("%u reports, average %" G_GUINT64_FORMAT "us, "
+			 "max %" G_GUINT64_FORMAT "us",
+			 priv->report_cnt,
+			 priv->report_total_us / priv->report_cnt,
+			 priv->report_max_us);
+	}
+
 	/* release */
 	if ((priv->flags & FU_HID_DEVICE_FLAG_NO_KERNEL_REBIND) == 0)
 		flags |= G_USB_DEVICE_CLAIM_INTERFACE_BIND_KERNEL_DRIVER;
@@ -244,6 +259,18 @@ typedef struct {
 	FuHidDeviceFlags flags;
 } FuHidDeviceRetryHelper;
 
+#ifdef HAVE_GUSB
+static void
+fu_hid_device_add_report_time (FuHidDevice *self, gint64 start)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	guint64 elapsed = g_get_monotonic_time () - start;
+	priv->report_cnt++;
+	priv->report_total_us += elapsed;
+	priv->report_max_us = MAX (priv->report_max_us, elapsed);
+}
+#endif
+
 static gboolean
 fu_hid_device_set_report_internal (FuHidDevice *self,
 				   FuHidDeviceRetryHelper *helper,
@@ -253,7 +280,9 @@ fu_hid_device_set_report_internal (FuHidDevice *self,
 	FuHidDevicePrivate *priv = GET_PRIVATE (self);
 	GUsbDevice *usb_device;
 	gsize actual_len = 0;
+	gint64 start;
 	guint16 wvalue = (FU_HID_REPORT_TYPE_OUTPUT << 8) | helper->value;
+	g_autofree gchar *id = NULL;
 
 	/* special case */
 	if (helper->flags & FU_HID_DEVICE_FLAG_IS_FEATURE)
@@ -266,7 +295,16 @@ fu_hid_device_set_report_internal (FuHidDevice *self,
 		fu_common_dump_raw (G_LOG_DOMAIN, title,
 				    helper->buf, helper->bufsz);
 	}
+	fu_device_add_trace (FU_DEVICE (self), "HID::SetReport",
+			     helper->buf, helper->bufsz);
+	id = g_strdup_printf ("SetReport:0x%04x", wvalue);
+	if (fu_device_transcript_is_replay (FU_DEVICE (self))) {
+		return fu_device_transcript_replay_write (FU_DEVICE (self), id,
+							  helper->buf, helper->bufsz,
+							  error);
+	}
 	usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	start = g_get_monotonic_time ();
 	if (!g_usb_device_control_transfer (usb_device,
 					    G_USB_DEVICE_DIRECTION_HOST_TO_DEVICE,
 					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
@@ -277,9 +315,12 @@ fu_hid_device_set_report_internal (FuHidDevice *self,
 					    &actual_len,
 					    helper->timeout,
 					    NULL, error)) {
+		fu_hid_device_add_report_time (self, start);
 		g_prefix_error (error, "failed to SetReport: ");
 		return FALSE;
 	}
+	fu_hid_device_add_report_time (self, start);
+	fu_device_transcript_record (FU_DEVICE (self), id, helper->buf, actual_len);
 	if ((helper->flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 && actual_len != helper->bufsz) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
 			     "wrote %" G_GSIZE_FORMAT ", requested %" G_GSIZE_FORMAT " bytes",
@@ -360,7 +401,9 @@ fu_hid_device_get_report_internal (FuHidDevice *self,
 	FuHidDevicePrivate *priv = GET_PRIVATE (self);
 	GUsbDevice *usb_device;
 	gsize actual_len = 0;
+	gint64 start;
 	guint16 wvalue = (FU_HID_REPORT_TYPE_INPUT << 8) | helper->value;
+	g_autofree gchar *id = NULL;
 
 	/* special case */
 	if (helper->flags & FU_HID_DEVICE_FLAG_IS_FEATURE)
@@ -373,19 +416,30 @@ fu_hid_device_get_report_internal (FuHidDevice *self,
 		fu_common_dump_raw (G_LOG_DOMAIN, title,
 				    helper->buf, actual_len);
 	}
-	usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	if (!g_usb_device_control_transfer (usb_device,
-					    G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
-					    G_USB_DEVICE_REQUEST_TYPE_CLASS,
-					    G_USB_DEVICE_RECIPIENT_INTERFACE,
-					    FU_HID_REPORT_GET,
-					    wvalue, priv->interface,
-					    helper->buf, helper->bufsz,
-					    &actual_len, /* actual length */
-					    helper->timeout,
-					    NULL, error)) {
-		g_prefix_error (error, "failed to GetReport: ");
-		return FALSE;
+	id = g_strdup_printf ("GetReport:0x%04x", wvalue);
+	if (fu_device_transcript_is_replay (FU_DEVICE (self))) {
+		if (!fu_device_transcript_replay_read (FU_DEVICE (self), id,
+						       helper->buf, helper->bufsz,
+						       &actual_len, error))
+			return FALSE;
+	} else {
+		usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+		start = g_get_monotonic_time ();
+		if (!g_usb_device_control_transfer (usb_device,
+						    G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+						    G_USB_DEVICE_REQUEST_TYPE_CLASS,
+						    G_USB_DEVICE_RECIPIENT_INTERFACE,
+						    FU_HID_REPORT_GET,
+						    wvalue, priv->interface,
+						    helper->buf, helper->bufsz,
+						    &actual_len, /* actual length */
+						    helper->timeout,
+						    NULL, error)) {
+			fu_hid_device_add_report_time (self, start);
+			g_prefix_error (error, "failed to GetReport: ");
+			return FALSE;
+		}
+		fu_hid_device_add_report_time (self, start);
 	}
 	if (g_getenv ("FU_HID_DEVICE_VERBOSE") != NULL) {
 		g_autofree gchar *title = NULL;
@@ -393,6 +447,9 @@ fu_hid_device_get_report_internal (FuHidDevice *self,
 					 wvalue, priv->interface);
 		fu_common_dump_raw (G_LOG_DOMAIN, title, helper->buf, actual_len);
 	}
+	fu_device_add_trace (FU_DEVICE (self), "HID::GetReport",
+			     helper->buf, actual_len);
+	fu_device_transcript_record (FU_DEVICE (self), id, helper->buf, actual_len);
 	if ((helper->flags & FU_HID_DEVICE_FLAG_ALLOW_TRUNC) == 0 && actual_len != helper->bufsz) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
 			     "read %" G_GSIZE_FORMAT ", requested %" G_GSIZE_FORMAT " bytes",
@@ -464,6 +521,167 @@ fu_hid_device_get_report (FuHidDevice *self,
 	return fu_hid_device_get_report_internal (self, &helper, error);
 }
 
+/**
+ * fu_hid_device_poll_report:
+ * @self: A #FuHidDevice
+ * @value: low byte of wValue
+ * @buf: a mutable buffer of data to receive
+ * @bufsz: Size of @buf
+ * @timeout: timeout of each GetReport in ms
+ * @flags: #FuHidDeviceFlags e.g. %FU_HID_DEVICE_FLAG_ALLOW_TRUNC
+ * @func: (scope call): a #FuHidDevicePollFunc to check the report
+ * @user_data: user data to pass to @func
+ * @poll_timeout: total time to wait in ms
+ * @error: a #GError or %NULL
+ *
+ * Calls GetReport on the hardware until @func returns %TRUE.
+ *
+ * If @func fails with %G_IO_ERROR_BUSY then the report is requested again
+ * after a short delay, which is doubled each time up to a maximum of 32ms.
+ * This allows fast devices to respond with very little latency without
+ * saturating the bus when the device is doing something slow like erasing.
+ * Any other error from @func is returned to the caller.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_hid_device_poll_report (FuHidDevice *self,
+			   guint8 value,
+			   guint8 *buf,
+			   gsize bufsz,
+			   guint timeout,
+			   FuHidDeviceFlags flags,
+			   FuHidDevicePollFunc func,
+			   gpointer user_data,
+			   guint poll_timeout,
+			   GError **error)
+{
+	gulong delay = FU_HID_DEVICE_POLL_DELAY_MIN;
+	gint64 start = fu_common_get_monotonic_time ();
+
+	g_return_val_if_fail (FU_HID_DEVICE (self), FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (;;) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_hid_device_get_report (self, value, buf, bufsz,
+					       timeout, flags, error))
+			return FALSE;
+		if (func (self, buf, bufsz, user_data, &error_local))
+			return TRUE;
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_BUSY)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+		if ((fu_common_get_monotonic_time () - start) / 1000 > poll_timeout) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_TIMED_OUT,
+				     "timed out after %ums: %s",
+				     poll_timeout, error_local->message);
+			return FALSE;
+		}
+		fu_common_sleep_us (delay * 1000);
+		delay = MIN (delay * 2, FU_HID_DEVICE_POLL_DELAY_MAX);
+	}
+}
+
+/**
+ * fu_hid_device_set_reports:
+ * @self: A #FuHidDevice
+ * @value: low byte of wValue
+ * @reports: (element-type GByteArray): reports to send
+ * @timeout: timeout of each SetReport in ms
+ * @flags: #FuHidDeviceFlags e.g. %FU_HID_DEVICE_FLAG_ALLOW_TRUNC
+ * @check_interval: number of reports to send between calls to @func, or 0
+ * @func: (scope call) (nullable): a #FuDeviceRetryFunc to check the device status
+ * @user_data: user data to pass to @func
+ * @error: a #GError or %NULL
+ *
+ * Calls SetReport on the hardware for each report in turn, updating the
+ * device progress as each is sent.
+ *
+ * If @func is set then it is called after every @check_interval reports and
+ * always after the last report, so devices that only need the status checked
+ * occasionally do not have to wait for a round trip after every report.
+ * If @check_interval is 0 then @func is only called once all the reports
+ * have been sent.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_hid_device_set_reports (FuHidDevice *self,
+			   guint8 value,
+			   GPtrArray *reports,
+			   guint timeout,
+			   FuHidDeviceFlags flags,
+			   guint check_interval,
+			   FuDeviceRetryFunc func,
+			   gpointer user_data,
+			   GError **error)
+{
+	g_return_val_if_fail (FU_HID_DEVICE (self), FALSE);
+	g_return_val_if_fail (reports != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (guint i = 0; i < reports->len; i++) {
+		GByteArray *report = g_ptr_array_index (reports, i);
+		if (!fu_hid_device_set_report (self, value,
+					       report->data, report->len,
+					       timeout, flags, error)) {
+			g_prefix_error (error, "failed to send report %u: ", i);
+			return FALSE;
+		}
+		if (func != NULL &&
+		    ((check_interval > 0 && (i + 1) % check_interval == 0) ||
+		     i + 1 == reports->len)) {
+			if (!func (FU_DEVICE (self), user_data, error)) {
+				g_prefix_error (error,
+						"failed to check status after report %u: ",
+						i);
+				return FALSE;
+			}
+		}
+		fu_device_set_progress_full (FU_DEVICE (self), i + 1, reports->len);
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_hid_device_get_report_stats:
+ * @self: A #FuHidDevice
+ * @cnt: (out) (optional): number of reports sent or received
+ * @avg_us: (out) (optional): average round-trip time in microseconds
+ * @max_us: (out) (optional): maximum round-trip time in microseconds
+ *
+ * Gets statistics about the SetReport and GetReport requests made since the
+ * device was created, which is useful when tuning poll intervals.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_hid_device_get_report_stats (FuHidDevice *self,
+				guint *cnt,
+				guint64 *avg_us,
+				guint64 *max_us)
+{
+	FuHidDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_HID_DEVICE (self));
+	if (cnt != NULL)
+		*cnt = priv->report_cnt;
+	if (avg_us != NULL)
+		*avg_us = priv->report_cnt > 0 ? priv->report_total_us / priv->report_cnt : 0;
+	if (max_us != NULL)
+		*max_us = priv->report_max_us;
+}
+
 static void
 fu_hid_device_init (FuHidDevice *self)
 {
@@ -45,6 +45,24 @@ typedef enum {
 	FU_HID_DEVICE_FLAG_LAST
 } FuHidDeviceFlags;
 
+/**
+ * FuHidDevicePollFunc:
+ * @self: A #FuHidDevice
+ * @buf: the report received from the device
+ * @bufsz: Size of @buf
+ * @user_data: user data
+ * @error: a #GError or %NULL
+ *
+ * Checks a report received by fu_hid_device_poll_report().
+ *
+ * Returns: %TRUE if the device is ready, or %FALSE with %G_IO_ERROR_BUSY to poll again
+ **/
+typedef gboolean (*FuHidDevicePollFunc)			(FuHidDevice	*self,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 gpointer	 user_data,
+							 GError		**error);
+
 FuHidDevice	*fu_hid_device_new			(GUsbDevice	*usb_device);
 void		 fu_hid_device_add_flag			(FuHidDevice	*self,
 							 FuHidDeviceFlags flag);
@@ -67,3 +85,28 @@ gboolean	 fu_hid_device_get_report		(FuHidDevice	*self,
 							 FuHidDeviceFlags flags,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_hid_device_poll_report		(FuHidDevice	*self,
+							 guint8		 value,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 guint		 timeout,
+							 FuHidDeviceFlags flags,
+							 FuHidDevicePollFunc func,
+							 gpointer	 user_data,
+							 guint		 poll_timeout,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_hid_device_set_reports		(FuHidDevice	*self,
+							 guint8		 value,
+							 GPtrArray	*reports,
+							 guint		 timeout,
+							 FuHidDeviceFlags flags,
+							 guint		 check_interval,
+							 FuDeviceRetryFunc func,
+							 gpointer	 user_data,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+void		 fu_hid_device_get_report_stats		(FuHidDevice	*self,
+							 guint		*cnt,
+							 guint64	*avg_us,
+							 guint64	*max_us);
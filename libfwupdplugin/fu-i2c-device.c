@@ -0,0 +1,438 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuI2cDevice"
+
+#include "config.h"
+
+#ifdef HAVE_I2C_DEV_H
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#endif
+
+#include "fu-common.h"
+#include "fu-device-private.h"
+#include "fu-i2c-device.h"
+
+/**
+ * SECTION:fu-i2c-device
+ * @short_description: an I²C device
+ *
+ * An object that represents an I²C device using the i2c-dev interface.
+ *
+ * Combined write-then-read transactions and SMBus block transfers are used
+ * when the adapter supports them, falling back to plain reads and writes.
+ *
+ * See also: #FuUdevDevice
+ */
+
+typedef struct
+{
+	guint16			 address;
+	gulong			 funcs;
+} FuI2cDevicePrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE (FuI2cDevice, fu_i2c_device, FU_TYPE_UDEV_DEVICE)
+
+#define GET_PRIVATE(o) (fu_i2c_device_get_instance_private (o))
+
+static void
+fu_i2c_device_to_string (FuDevice *device, guint idt, GString *str)
+{
+	FuI2cDevice *self = FU_I2C_DEVICE (device);
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+
+	/* FuUdevDevice->to_string */
+	FU_DEVICE_CLASS (fu_i2c_device_parent_class)->to_string (device, idt, str);
+
+	fu_common_string_append_kx (str, idt, "I2cAddress", priv->address);
+	fu_common_string_append_kx (str, idt, "I2cFuncs", priv->funcs);
+}
+
+static gboolean
+fu_i2c_device_probe (FuDevice *device, GError **error)
+{
+	/* FuUdevDevice->probe */
+	if (!FU_DEVICE_CLASS (fu_i2c_device_parent_class)->probe (device, error))
+		return FALSE;
+
+	/* check is valid */
+	if (g_strcmp0 (fu_udev_device_get_subsystem (FU_UDEV_DEVICE (device)), "i2c-dev") != 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "is not correct subsystem=%s, expected i2c-dev",
+			     fu_udev_device_get_subsystem (FU_UDEV_DEVICE (device)));
+		return FALSE;
+	}
+	if (fu_udev_device_get_device_file (FU_UDEV_DEVICE (device)) == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "no device file");
+		return FALSE;
+	}
+
+	/* set the physical ID */
+	return fu_udev_device_set_physical_id (FU_UDEV_DEVICE (device), "i2c", error);
+}
+
+static gboolean
+fu_i2c_device_open (FuDevice *device, GError **error)
+{
+#ifdef HAVE_I2C_DEV_H
+	FuI2cDevice *self = FU_I2C_DEVICE (device);
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GError) error_local = NULL;
+
+	/* FuUdevDevice->open */
+	if (!FU_DEVICE_CLASS (fu_i2c_device_parent_class)->open (device, error))
+		return FALSE;
+
+	/* what the adapter can do; if this fails only plain I/O is used */
+	priv->funcs = 0;
+	if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self), I2C_FUNCS,
+				   (guint8 *) &priv->funcs, NULL, &error_local))
+		g_debug ("failed to get functionality: %s", error_local->message);
+
+	/* set target address */
+	if (priv->address != 0x0) {
+		gint addr = priv->address;
+		if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self), I2C_SLAVE,
+					   GINT_TO_POINTER (addr), NULL, NULL)) {
+			if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self), I2C_SLAVE_FORCE,
+						   GINT_TO_POINTER (addr), NULL, error)) {
+				g_prefix_error (error,
+						"failed to set target address to 0x%x: ",
+						priv->address);
+				return FALSE;
+			}
+		}
+	}
+
+	/* success */
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as <linux/i2c-dev.h> not found");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_i2c_device_get_address:
+ * @self: A #FuI2cDevice
+ *
+ * Gets the target address.
+ *
+ * Returns: integer, or 0x0 if unset
+ *
+ * Since: 1.5.8
+ **/
+guint16
+fu_i2c_device_get_address (FuI2cDevice *self)
+{
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), 0x0);
+	return priv->address;
+}
+
+/**
+ * fu_i2c_device_set_address:
+ * @self: A #FuI2cDevice
+ * @address: integer, e.g. 0x15
+ *
+ * Sets the target address, which is set when the device is opened.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_i2c_device_set_address (FuI2cDevice *self, guint16 address)
+{
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_if_fail (FU_IS_I2C_DEVICE (self));
+	priv->address = address;
+}
+
+/**
+ * fu_i2c_device_has_functionality:
+ * @self: A #FuI2cDevice
+ * @funcs: a bitfield of `I2C_FUNC_*` values, e.g. `I2C_FUNC_I2C`
+ *
+ * Finds out if the adapter supports all of the given functionality. This is
+ * only known once the device has been opened.
+ *
+ * Returns: %TRUE if supported
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_has_functionality (FuI2cDevice *self, gulong funcs)
+{
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	return (priv->funcs & funcs) == funcs;
+}
+
+/**
+ * fu_i2c_device_write:
+ * @self: A #FuI2cDevice
+ * @buf: data to write
+ * @bufsz: size of @buf
+ * @error: A #GError, or %NULL
+ *
+ * Writes data to the target address.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_write (FuI2cDevice *self, const guint8 *buf, gsize bufsz, GError **error)
+{
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	return fu_udev_device_pwrite_full (FU_UDEV_DEVICE (self), 0x0, buf, bufsz, error);
+}
+
+/**
+ * fu_i2c_device_read:
+ * @self: A #FuI2cDevice
+ * @buf: buffer to read into
+ * @bufsz: size of @buf
+ * @error: A #GError, or %NULL
+ *
+ * Reads data from the target address.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_read (FuI2cDevice *self, guint8 *buf, gsize bufsz, GError **error)
+{
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	return fu_udev_device_pread_full (FU_UDEV_DEVICE (self), 0x0, buf, bufsz, error);
+}
+
+/**
+ * fu_i2c_device_write_read:
+ * @self: A #FuI2cDevice
+ * @tx: data to write
+ * @txsz: size of @tx
+ * @rx: buffer to read into
+ * @rxsz: size of @rx
+ * @error: A #GError, or %NULL
+ *
+ * Writes data and then reads the response. If the adapter supports plain I²C
+ * transfers this is done as one combined transaction with a repeated start,
+ * otherwise as a separate write and read.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_write_read (FuI2cDevice *self,
+			  const guint8 *tx, gsize txsz,
+			  guint8 *rx, gsize rxsz,
+			  GError **error)
+{
+#ifdef HAVE_I2C_DEV_H
+	FuI2cDevicePrivate *priv = GET_PRIVATE (self);
+#endif
+
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	g_return_val_if_fail (tx != NULL, FALSE);
+	g_return_val_if_fail (rx != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+#ifdef HAVE_I2C_DEV_H
+	/* the transcript only knows about plain reads and writes */
+	if (fu_i2c_device_has_functionality (self, I2C_FUNC_I2C) &&
+	    !fu_device_transcript_is_replay (FU_DEVICE (self)) &&
+	    txsz <= G_MAXUINT16 && rxsz <= G_MAXUINT16) {
+		struct i2c_msg msgs[] = {
+			{
+				.addr	= priv->address,
+				.flags	= 0,
+				.len	= txsz,
+				.buf	= (guint8 *) tx,
+			},
+			{
+				.addr	= priv->address,
+				.flags	= I2C_M_RD,
+				.len	= rxsz,
+				.buf	= rx,
+			},
+		};
+		struct i2c_rdwr_ioctl_data data = {
+			.msgs	= msgs,
+			.nmsgs	= G_N_ELEMENTS (msgs),
+		};
+		return fu_udev_device_ioctl (FU_UDEV_DEVICE (self), I2C_RDWR,
+					     (guint8 *) &data, NULL, error);
+	}
+#endif
+	if (!fu_i2c_device_write (self, tx, txsz, error))
+		return FALSE;
+	return fu_i2c_device_read (self, rx, rxsz, error);
+}
+
+#ifdef HAVE_I2C_DEV_H
+static gboolean
+fu_i2c_device_smbus_block (FuI2cDevice *self,
+			   guint8 read_write,
+			   guint8 cmd,
+			   union i2c_smbus_data *buf,
+			   GError **error)
+{
+	struct i2c_smbus_ioctl_data data = {
+		.read_write	= read_write,
+		.command	= cmd,
+		.size		= I2C_SMBUS_I2C_BLOCK_DATA,
+		.data		= buf,
+	};
+	return fu_udev_device_ioctl (FU_UDEV_DEVICE (self), I2C_SMBUS,
+				     (guint8 *) &data, NULL, error);
+}
+#endif
+
+/**
+ * fu_i2c_device_smbus_write_block:
+ * @self: A #FuI2cDevice
+ * @cmd: the SMBus command byte
+ * @buf: data to write
+ * @bufsz: size of @buf, no larger than 32 bytes
+ * @error: A #GError, or %NULL
+ *
+ * Writes an SMBus I²C block, which the adapter may be able to do faster than
+ * a plain write. This fails if the adapter does not support
+ * `I2C_FUNC_SMBUS_WRITE_I2C_BLOCK`.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_smbus_write_block (FuI2cDevice *self,
+				 guint8 cmd,
+				 const guint8 *buf,
+				 gsize bufsz,
+				 GError **error)
+{
+#ifdef HAVE_I2C_DEV_H
+	union i2c_smbus_data data = { 0x0 };
+
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_i2c_device_has_functionality (self, I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "adapter does not support SMBus block writes");
+		return FALSE;
+	}
+	if (bufsz > I2C_SMBUS_BLOCK_MAX) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "SMBus block limited to %u bytes, got %u",
+			     (guint) I2C_SMBUS_BLOCK_MAX, (guint) bufsz);
+		return FALSE;
+	}
+	data.block[0] = bufsz;
+	if (!fu_memcpy_safe (data.block, sizeof(data.block), 0x1,	/* dst */
+			     buf, bufsz, 0x0,				/* src */
+			     bufsz, error))
+		return FALSE;
+	return fu_i2c_device_smbus_block (self, I2C_SMBUS_WRITE, cmd, &data, error);
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as <linux/i2c-dev.h> not found");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_i2c_device_smbus_read_block:
+ * @self: A #FuI2cDevice
+ * @cmd: the SMBus command byte
+ * @buf: buffer to read into
+ * @bufsz: size of @buf, no larger than 32 bytes
+ * @error: A #GError, or %NULL
+ *
+ * Reads an SMBus I²C block. This fails if the adapter does not support
+ * `I2C_FUNC_SMBUS_READ_I2C_BLOCK`.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_i2c_device_smbus_read_block (FuI2cDevice *self,
+				guint8 cmd,
+				guint8 *buf,
+				gsize bufsz,
+				GError **error)
+{
+#ifdef HAVE_I2C_DEV_H
+	union i2c_smbus_data data = { 0x0 };
+
+	g_return_val_if_fail (FU_IS_I2C_DEVICE (self), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_i2c_device_has_functionality (self, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "adapter does not support SMBus block reads");
+		return FALSE;
+	}
+	if (bufsz > I2C_SMBUS_BLOCK_MAX) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "SMBus block limited to %u bytes, got %u",
+			     (guint) I2C_SMBUS_BLOCK_MAX, (guint) bufsz);
+		return FALSE;
+	}
+	data.block[0] = bufsz;
+	if (!fu_i2c_device_smbus_block (self, I2C_SMBUS_READ, cmd, &data, error))
+		return FALSE;
+	return fu_memcpy_safe (buf, bufsz, 0x0,				/* dst */
+			       data.block, sizeof(data.block), 0x1,	/* src */
+			       bufsz, error);
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as <linux/i2c-dev.h> not found");
+	return FALSE;
+#endif
+}
+
+static void
+fu_i2c_device_init (FuI2cDevice *self)
+{
+}
+
+static void
+fu_i2c_device_class_init (FuI2cDeviceClass *klass)
+{
+	FuDeviceClass *device_class = FU_DEVICE_CLASS (klass);
+	device_class->to_string = fu_i2c_device_to_string;
+	device_class->probe = fu_i2c_device_probe;
+	device_class->open = fu_i2c_device_open;
+}
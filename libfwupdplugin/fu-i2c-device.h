@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-udev-device.h"
+
+#define FU_TYPE_I2C_DEVICE (fu_i2c_device_get_type ())
+G_DECLARE_DERIVABLE_TYPE (FuI2cDevice, fu_i2c_device, FU, I2C_DEVICE, FuUdevDevice)
+
+struct _FuI2cDeviceClass
+{
+	FuUdevDeviceClass	parent_class;
+	gpointer		__reserved[31];
+};
+
+guint16		 fu_i2c_device_get_address		(FuI2cDevice	*self);
+void		 fu_i2c_device_set_address		(FuI2cDevice	*self,
+							 guint16	 address);
+gboolean	 fu_i2c_device_has_functionality	(FuI2cDevice	*self,
+							 gulong		 funcs);
+gboolean	 fu_i2c_device_write			(FuI2cDevice	*self,
+							 const guint8	*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_i2c_device_read			(FuI2cDevice	*self,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_i2c_device_write_read		(FuI2cDevice	*self,
+							 const guint8	*tx,
+							 gsize		 txsz,
+							 guint8		*rx,
+							 gsize		 rxsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_i2c_device_smbus_write_block	(FuI2cDevice	*self,
+							 guint8		 cmd,
+							 const guint8	*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_i2c_device_smbus_read_block		(FuI2cDevice	*self,
+							 guint8		 cmd,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
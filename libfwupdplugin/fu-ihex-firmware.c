@@ -54,24 +54,26 @@ static void
 fu_ihex_firmware_record_free (FuIhexFirmwareRecord *rcd)
 {
 	g_string_free (rcd->buf, TRUE);
-	g_byte_array_unref (rcd->data);
+	if (rcd->data != NULL)
+		g_byte_array_unref (rcd->data);
 	g_free (rcd);
 }
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuIhexFirmwareRecord, fu_ihex_firmware_record_free)
 
 static FuIhexFirmwareRecord *
-fu_ihex_firmware_record_new (guint ln, const gchar *line,
+fu_ihex_firmware_record_new (guint ln, const gchar *line, gsize linesz,
 			     FwupdInstallFlags flags, GError **error)
 {
 	g_autoptr(FuIhexFirmwareRecord) rcd = NULL;
-	gsize linesz = strlen (line);
+	gboolean verify_checksum = (flags & FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM) == 0;
+	guint8 hdr[4] = { 0x0 };
+	guint8 buf[0xff + 1] = { 0x0 };
 	guint line_end;
-	guint16 addr16 = 0;
 
 	/* check starting token */
 	if (line[0] != ':') {
-		g_autofree gchar *strsafe = fu_common_strsafe (line, 5);
+		g_autofree gchar *strsafe = fu_common_strsafe (line, MIN (linesz, 5));
 		if (strsafe != NULL) {
 			g_set_error (error,
 				     FWUPD_ERROR,
@@ -90,19 +92,16 @@ fu_ihex_firmware_record_new (guint ln, const gchar *line,
 	/* length, 16-bit address, type */
 	rcd = g_new0 (FuIhexFirmwareRecord, 1);
 	rcd->ln = ln;
-	rcd->data = g_byte_array_new ();
-	rcd->buf = g_string_new (line);
-	if (!fu_firmware_strparse_uint8_safe (line, linesz, 1, &rcd->byte_cnt, error))
-		return NULL;
-	if (!fu_firmware_strparse_uint16_safe (line, linesz, 3, &addr16, error))
-		return NULL;
-	rcd->addr = addr16;
-	if (!fu_firmware_strparse_uint8_safe (line, linesz, 7, &rcd->record_type, error))
+	rcd->buf = g_string_new_len (line, linesz);
+	if (!fu_firmware_strparse_hex_safe (line, linesz, 1, hdr, sizeof(hdr), error))
 		return NULL;
+	rcd->byte_cnt = hdr[0];
+	rcd->addr = fu_common_read_uint16 (hdr + 1, G_BIG_ENDIAN);
+	rcd->record_type = hdr[3];
 
 	/* position of checksum */
 	line_end = 9 + rcd->byte_cnt * 2;
-	if (line_end > (guint) rcd->buf->len) {
+	if (line_end > (guint) linesz) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
@@ -111,15 +110,19 @@ fu_ihex_firmware_record_new (guint ln, const gchar *line,
 		return NULL;
 	}
 
+	/* decode the data, and the checksum after it if required */
+	if (!fu_firmware_strparse_hex_safe (line, linesz, 9, buf,
+					    rcd->byte_cnt + (verify_checksum ? 1 : 0),
+					    error))
+		return NULL;
+
 	/* verify checksum */
-	if ((flags & FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM) == 0) {
+	if (verify_checksum) {
 		guint8 checksum = 0;
-		for (guint i = 1; i < line_end + 2; i += 2) {
-			guint8 data_tmp = 0;
-			if (!fu_firmware_strparse_uint8_safe (line, linesz, i, &data_tmp, error))
-				return NULL;
-			checksum += data_tmp;
-		}
+		for (guint i = 0; i < sizeof(hdr); i++)
+			checksum += hdr[i];
+		for (guint i = 0; i < (guint) rcd->byte_cnt + 1; i++)
+			checksum += buf[i];
 		if (checksum != 0)  {
 			g_set_error (error,
 				     FWUPD_ERROR,
@@ -131,12 +134,8 @@ fu_ihex_firmware_record_new (guint ln, const gchar *line,
 	}
 
 	/* add data */
-	for (guint i = 9; i < line_end; i += 2) {
-		guint8 tmp_c = 0;
-		if (!fu_firmware_strparse_uint8_safe (line, linesz, i, &tmp_c, error))
-			return NULL;
-		fu_byte_array_append_uint8 (rcd->data, tmp_c);
-	}
+	rcd->data = g_byte_array_sized_new (rcd->byte_cnt);
+	g_byte_array_append (rcd->data, buf, rcd->byte_cnt);
 	return g_steal_pointer (&rcd);
 }
 
@@ -167,16 +166,28 @@ fu_ihex_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 	FuIhexFirmware *self = FU_IHEX_FIRMWARE (firmware);
 	gsize sz = 0;
 	const gchar *data = g_bytes_get_data (fw, &sz);
-	g_auto(GStrv) lines = fu_common_strnsplit (data, sz, "\n", -1);
+	gsize offset = 0;
 
-	for (guint ln = 0; lines[ln] != NULL; ln++) {
+	/* scan the lines in place rather than splitting a copy */
+	for (guint ln = 0; offset < sz; ln++) {
+		const gchar *line = data + offset;
+		const gchar *eol = memchr (line, '\n', sz - offset);
+		gsize linesz = eol != NULL ? (gsize) (eol - line) : sz - offset;
 		g_autoptr(FuIhexFirmwareRecord) rcd = NULL;
-		g_strdelimit (lines[ln], "\r\x1a", '\0');
-		if (g_str_has_prefix (lines[ln], ";"))
+
+		/* ignore anything after a carriage return or EOF marker */
+		offset += linesz + 1;
+		for (gsize i = 0; i < linesz; i++) {
+			if (line[i] == '\r' || line[i] == '\x1a' || line[i] == '\0') {
+				linesz = i;
+				break;
+			}
+		}
+		if (linesz == 0)
 			continue;
-		if (lines[ln][0] == '\0')
+		if (line[0] == ';')
 			continue;
-		rcd = fu_ihex_firmware_record_new (ln + 1, lines[ln], flags, error);
+		rcd = fu_ihex_firmware_record_new (ln + 1, line, linesz, flags, error);
 		if (rcd == NULL) {
 			g_prefix_error (error, "invalid line %u: ", ln + 1);
 			return FALSE;
@@ -201,9 +212,18 @@ fu_ihex_firmware_parse (FuFirmware *firmware,
 	guint32 addr_last = 0x0;
 	guint32 img_addr = G_MAXUINT32;
 	guint32 seg_addr = 0x0;
+	guint buf_sz = 0;
 	g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (NULL);
 	g_autoptr(GBytes) img_bytes = NULL;
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GByteArray) buf = NULL;
+
+	/* allocate once for the data, ignoring any holes */
+	for (guint k = 0; k < self->records->len; k++) {
+		FuIhexFirmwareRecord *rcd = g_ptr_array_index (self->records, k);
+		if (rcd->record_type == FU_IHEX_FIRMWARE_RECORD_TYPE_DATA)
+			buf_sz += rcd->data->len;
+	}
+	buf = g_byte_array_sized_new (buf_sz);
 
 	/* parse records */
 	for (guint k = 0; k < self->records->len; k++) {
@@ -257,13 +277,14 @@ fu_ihex_firmware_parse (FuFirmware *firmware,
 				return FALSE;
 			}
 			if (addr_last > 0x0 && len_hole > 1) {
+				guint buf_len = buf->len;
 				g_debug ("filling address 0x%08x to 0x%08x on line %u",
 					 addr_last + 1, addr_last + len_hole - 1, rcd->ln);
-				for (guint j = 1; j < len_hole; j++) {
-					/* although 0xff might be clearer,
-					 * we can't write 0xffff to pic14 */
-					fu_byte_array_append_uint8 (buf, 0x00);
-				}
+
+				/* although 0xff might be clearer,
+				 * we can't write 0xffff to pic14 */
+				g_byte_array_set_size (buf, buf_len + len_hole - 1);
+				memset (buf->data + buf_len, 0x00, len_hole - 1);
 			}
 			addr_last = addr + rcd->data->len - 1;
 
@@ -380,8 +401,25 @@ fu_ihex_firmware_emit_chunk (GString *str,
 	g_string_append_printf (str, "%02X\n", (guint) (((~checksum) + 0x01) & 0xff));
 }
 
+/* records are tiny, so batch them up before writing */
+#define FU_IHEX_FIRMWARE_FLUSH_THRESHOLD	0x10000
+
 static gboolean
-fu_ihex_firmware_image_to_string (FuFirmwareImage *img, GString *str, GError **error)
+fu_ihex_firmware_flush (GString *str, GOutputStream *stream, gsize threshold, GError **error)
+{
+	if (str->len < threshold)
+		return TRUE;
+	if (!g_output_stream_write_all (stream, str->str, str->len, NULL, NULL, error))
+		return FALSE;
+	g_string_truncate (str, 0);
+	return TRUE;
+}
+
+static gboolean
+fu_ihex_firmware_image_write_stream (FuFirmwareImage *img,
+				     GString *str,
+				     GOutputStream *stream,
+				     GError **error)
 {
 	const guint8 *data;
 	const guint chunk_size = 16;
@@ -419,28 +457,32 @@ fu_ihex_firmware_image_to_string (FuFirmwareImage *img, GString *str, GError **e
 		address_tmp &= 0xffff;
 		fu_ihex_firmware_emit_chunk (str, address_tmp,
 					     record_type, data + i, chunk_len);
+		if (!fu_ihex_firmware_flush (str, stream,
+					     FU_IHEX_FIRMWARE_FLUSH_THRESHOLD,
+					     error))
+			return FALSE;
 	}
 	return TRUE;
 }
 
-static GBytes *
-fu_ihex_firmware_write (FuFirmware *firmware, GError **error)
+static gboolean
+fu_ihex_firmware_write_stream (FuFirmware *firmware, GOutputStream *stream, GError **error)
 {
 	g_autoptr(GPtrArray) imgs = NULL;
 	g_autoptr(GString) str = NULL;
 
 	/* write all the element data */
-	str = g_string_new ("");
+	str = g_string_sized_new (FU_IHEX_FIRMWARE_FLUSH_THRESHOLD + 0x100);
 	imgs = fu_firmware_get_images (firmware);
 	for (guint i = 0; i < imgs->len; i++) {
 		FuFirmwareImage *img = g_ptr_array_index (imgs, i);
-		if (!fu_ihex_firmware_image_to_string (img, str, error))
-			return NULL;
+		if (!fu_ihex_firmware_image_write_stream (img, str, stream, error))
+			return FALSE;
 	}
 
 	/* add EOF */
 	fu_ihex_firmware_emit_chunk (str, 0x0, FU_IHEX_FIRMWARE_RECORD_TYPE_EOF, NULL, 0);
-	return g_bytes_new (str->str, str->len);
+	return fu_ihex_firmware_flush (str, stream, 0, error);
 }
 
 static void
@@ -466,7 +508,7 @@ fu_ihex_firmware_class_init (FuIhexFirmwareClass *klass)
 	object_class->finalize = fu_ihex_firmware_finalize;
 	klass_firmware->parse = fu_ihex_firmware_parse;
 	klass_firmware->tokenize = fu_ihex_firmware_tokenize;
-	klass_firmware->write = fu_ihex_firmware_write;
+	klass_firmware->write_stream = fu_ihex_firmware_write_stream;
 }
 
 /**
@@ -264,25 +264,32 @@ fu_io_channel_read_bytes (FuIOChannel *self,
 }
 
 /**
- * fu_io_channel_read_byte_array:
+ * fu_io_channel_read_byte_array_full:
  * @self: a #FuIOChannel
  * @max_size: maximum size of the returned blob, or -1 for no limit
  * @timeout_ms: timeout in ms
  * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
+ * @func: (scope call) (nullable): a #FuIOChannelReadFunc
+ * @user_data: user data to pass to @func
  * @error: a #GError, or %NULL
  *
  * Reads bytes from the TTY, that will fail if exceeding @timeout_ms.
  *
+ * If @func is set it is called each time more data is received, and the read
+ * completes as soon as it returns %TRUE rather than waiting for the timeout.
+ *
  * Returns: (transfer full): a #GByteArray, or %NULL for error
  *
- * Since: 1.3.2
+ * Since: 1.5.8
  **/
 GByteArray *
-fu_io_channel_read_byte_array (FuIOChannel *self,
-			       gssize max_size,
-			       guint timeout_ms,
-			       FuIOChannelFlags flags,
-			       GError **error)
+fu_io_channel_read_byte_array_full (FuIOChannel *self,
+				    gssize max_size,
+				    guint timeout_ms,
+				    FuIOChannelFlags flags,
+				    FuIOChannelReadFunc func,
+				    gpointer user_data,
+				    GError **error)
 {
 	GPollFD fds = {
 		.fd = self->fd,
@@ -354,6 +361,10 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 				break;
 			if (flags & FU_IO_CHANNEL_FLAG_SINGLE_SHOT)
 				break;
+
+			/* the caller has the complete response */
+			if (len > 0 && func != NULL && func (buf2, user_data))
+				break;
 			continue;
 		}
 		if (fds.revents & G_IO_ERR) {
@@ -393,6 +404,31 @@ fu_io_channel_read_byte_array (FuIOChannel *self,
 	return g_steal_pointer (&buf2);
 }
 
+/**
+ * fu_io_channel_read_byte_array:
+ * @self: a #FuIOChannel
+ * @max_size: maximum size of the returned blob, or -1 for no limit
+ * @timeout_ms: timeout in ms
+ * @flags: some #FuIOChannelFlags, e.g. %FU_IO_CHANNEL_FLAG_SINGLE_SHOT
+ * @error: a #GError, or %NULL
+ *
+ * Reads bytes from the TTY, that will fail if exceeding @timeout_ms.
+ *
+ * Returns: (transfer full): a #GByteArray, or %NULL for error
+ *
+ * Since: 1.3.2
+ **/
+GByteArray *
+fu_io_channel_read_byte_array (FuIOChannel *self,
+			       gssize max_size,
+			       guint timeout_ms,
+			       FuIOChannelFlags flags,
+			       GError **error)
+{
+	return fu_io_channel_read_byte_array_full (self, max_size, timeout_ms,
+						   flags, NULL, NULL, error);
+}
+
 /**
  * fu_io_channel_read_raw:
  * @self: a #FuIOChannel
@@ -30,6 +30,18 @@ typedef enum {
 	FU_IO_CHANNEL_FLAG_LAST
 } FuIOChannelFlags;
 
+/**
+ * FuIOChannelReadFunc:
+ * @buf: the data received so far
+ * @user_data: user data
+ *
+ * Checks if the response read from the TTY is complete.
+ *
+ * Returns: %TRUE if no more data is expected
+ **/
+typedef gboolean (*FuIOChannelReadFunc)	(GByteArray	*buf,
+					 gpointer	 user_data);
+
 FuIOChannel	*fu_io_channel_unix_new		(gint		 fd);
 FuIOChannel	*fu_io_channel_new_file		(const gchar	*filename,
 						 GError		**error)
@@ -78,3 +90,11 @@ GByteArray	*fu_io_channel_read_byte_array	(FuIOChannel	*self,
 						 FuIOChannelFlags flags,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+GByteArray	*fu_io_channel_read_byte_array_full (FuIOChannel *self,
+						 gssize		 max_size,
+						 guint		 timeout_ms,
+						 FuIOChannelFlags flags,
+						 FuIOChannelReadFunc func,
+						 gpointer	 user_data,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
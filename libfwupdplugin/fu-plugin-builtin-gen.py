@@ -0,0 +1,89 @@
+#!/usr/bin/python3
+""" Builds the table of plugins that are linked into the daemon """
+
+# pylint: disable=invalid-name,wrong-import-position,pointless-string-statement
+
+"""
+SPDX-License-Identifier: LGPL-2.1+
+"""
+
+import os
+import re
+import sys
+
+
+def usage(return_code):
+    """ print usage and exit with the supplied return code """
+    if return_code == 0:
+        out = sys.stdout
+    else:
+        out = sys.stderr
+    out.write("usage: fu-plugin-builtin-gen.py <VFUNCS-HEADER> <OUTPUT> <PLUGIN>...")
+    sys.exit(return_code)
+
+
+def parse_vfuncs(filename):
+    """ the return type and arguments of each vfunc that is renamed when built in """
+    with open(filename, 'r') as f:
+        data = f.read()
+    renamed = re.findall(r'^#define\s+(fu_plugin_\w+)\s+FU_PLUGIN_BUILTIN_SYMBOL', data, re.M)
+    vfuncs = []
+    for m in re.finditer(r'^(void|gboolean)\s+(fu_plugin_\w+)\s*\(([^;]*?)\)[^;]*;',
+                         data, re.M | re.S):
+        if m.group(2) not in renamed:
+            sys.stderr.write('%s is not renamed in %s\n' % (m.group(2), filename))
+            sys.exit(1)
+        vfuncs.append((m.group(1), m.group(2), ' '.join(m.group(3).split())))
+    if not vfuncs:
+        sys.stderr.write('no vfuncs found in %s\n' % filename)
+        sys.exit(1)
+    return vfuncs
+
+
+def guess_name_from_fn(filename):
+    """ the same as fu_plugin_guess_name_from_fn() """
+    basename = os.path.basename(filename)
+    prefix = 'libfu_plugin_'
+    if not basename.startswith(prefix):
+        sys.stderr.write('%s is not a plugin\n' % filename)
+        sys.exit(1)
+    return basename[len(prefix):].split('.')[0]
+
+
+if __name__ == '__main__':
+    if {'-?', '--help', '--usage'}.intersection(set(sys.argv)):
+        usage(0)
+    if len(sys.argv) < 3:
+        usage(1)
+    vfuncs = parse_vfuncs(sys.argv[1])
+    names = sorted([guess_name_from_fn(fn) for fn in sys.argv[3:]])
+    lines = []
+    lines.append('/* generated by fu-plugin-builtin-gen.py, do not edit */')
+    lines.append('')
+    lines.append('#include "config.h"')
+    lines.append('')
+    lines.append('#include "fu-plugin-builtin.h"')
+    lines.append('')
+
+    # plugins only implement some of the vfuncs
+    for name in names:
+        for rettype, vfunc, args in vfuncs:
+            lines.append('extern %s fu_plugin_builtin_%s_%s (%s) __attribute__((weak));' %
+                         (rettype, name, vfunc, args))
+    lines.append('')
+    for name in names:
+        lines.append('static const FuPluginSymbol fu_plugin_builtin_%s[] = {' % name)
+        for _, vfunc, _ in vfuncs:
+            lines.append('\t{ "%s", (gpointer) fu_plugin_builtin_%s_%s },' %
+                         (vfunc, name, vfunc))
+        lines.append('\t{ NULL, NULL }')
+        lines.append('};')
+        lines.append('')
+    lines.append('const FuPluginBuiltin fu_plugin_builtins[] = {')
+    for name in names:
+        lines.append('\t{ "%s", fu_plugin_builtin_%s },' % (name, name))
+    lines.append('\t{ NULL, NULL }')
+    lines.append('};')
+    with open(sys.argv[2], 'w') as f2:
+        f2.write('\n'.join(lines))
+        f2.write('\n')
@@ -11,6 +11,18 @@
 #include "fu-security-attrs.h"
 #include "fu-smbios.h"
 
+/**
+ * FuPluginSymbol:
+ * @name: The vfunc name, e.g. `fu_plugin_coldplug`
+ * @func: (nullable): The implementation, or %NULL if not implemented
+ *
+ * A vfunc of a plugin that was linked into the daemon.
+ **/
+typedef struct {
+	const gchar	*name;
+	gpointer	 func;
+} FuPluginSymbol;
+
 FuPlugin	*fu_plugin_new				(void);
 gboolean	 fu_plugin_is_open			(FuPlugin	*self);
 void		 fu_plugin_set_usb_context		(FuPlugin	*self,
@@ -42,10 +54,18 @@ gboolean	 fu_plugin_has_rule			(FuPlugin	*self,
 							 FuPluginRule	 rule,
 							 const gchar	*name);
 GHashTable	*fu_plugin_get_report_metadata		(FuPlugin	*self);
+GType		 fu_plugin_get_device_gtype		(FuPlugin	*self);
+void		 fu_plugin_get_runner_stats		(FuPlugin	*self,
+							 guint64	*calls,
+							 guint64	*cputime);
 gboolean	 fu_plugin_open				(FuPlugin	*self,
 							 const gchar	*filename,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_plugin_open_builtin			(FuPlugin	*self,
+							 const FuPluginSymbol *symbols,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fu_plugin_runner_startup		(FuPlugin	*self,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
@@ -17,6 +17,38 @@
 #include "fwupd-security-attr-private.h"
 #endif
 
+/* when linked into the daemon each plugin gets its own copy of the vfuncs,
+ * which fu-plugin-builtin-gen.py puts into the registration table */
+#if defined(HAVE_PLUGIN_BUILTIN) && defined(FU_PLUGIN_BUILTIN)
+#define FU_PLUGIN_BUILTIN_SYMBOL(sym)	G_PASTE (G_PASTE (fu_plugin_builtin_, FU_PLUGIN_BUILTIN), G_PASTE (_, sym))
+#define fu_plugin_init			FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_init)
+#define fu_plugin_destroy		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_destroy)
+#define fu_plugin_startup		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_startup)
+#define fu_plugin_coldplug		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_coldplug)
+#define fu_plugin_coldplug_prepare	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_coldplug_prepare)
+#define fu_plugin_coldplug_cleanup	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_coldplug_cleanup)
+#define fu_plugin_recoldplug		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_recoldplug)
+#define fu_plugin_update		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_update)
+#define fu_plugin_verify		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_verify)
+#define fu_plugin_unlock		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_unlock)
+#define fu_plugin_activate		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_activate)
+#define fu_plugin_clear_results		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_clear_results)
+#define fu_plugin_get_results		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_get_results)
+#define fu_plugin_update_attach		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_update_attach)
+#define fu_plugin_update_detach		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_update_detach)
+#define fu_plugin_update_prepare	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_update_prepare)
+#define fu_plugin_update_cleanup	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_update_cleanup)
+#define fu_plugin_composite_prepare	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_composite_prepare)
+#define fu_plugin_composite_cleanup	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_composite_cleanup)
+#define fu_plugin_backend_device_added	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_backend_device_added)
+#define fu_plugin_backend_device_changed	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_backend_device_changed)
+#define fu_plugin_backend_device_removed	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_backend_device_removed)
+#define fu_plugin_device_added		FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_device_added)
+#define fu_plugin_device_created	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_device_created)
+#define fu_plugin_device_registered	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_device_registered)
+#define fu_plugin_add_security_attrs	FU_PLUGIN_BUILTIN_SYMBOL (fu_plugin_add_security_attrs)
+#endif
+
 /**
  * SECTION:fu-plugin-vfuncs
  * @short_description: Virtual functions for plugins
@@ -12,6 +12,7 @@
 #include <gmodule.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #ifdef HAVE_VALGRIND
 #include <valgrind.h>
@@ -20,6 +21,7 @@
 #include "fu-device-private.h"
 #include "fu-plugin-private.h"
 #include "fu-mutex.h"
+#include "fu-usdt-private.h"
 
 /**
  * SECTION:fu-plugin
@@ -36,6 +38,7 @@ static void fu_plugin_finalize			 (GObject *object);
 
 typedef struct {
 	GModule			*module;
+	const FuPluginSymbol	*symbols;		/* (nullable): when built in */
 	guint			 order;
 	guint			 priority;
 	GPtrArray		*rules[FU_PLUGIN_RULE_LAST];
@@ -51,7 +54,17 @@ typedef struct {
 	GHashTable		*cache;			/* (nullable): platform_id:GObject */
 	GRWLock			 cache_mutex;
 	GHashTable		*report_metadata;	/* (nullable): key:value */
+	GMutex			 custom_flags_mutex;	/* for @custom_flags */
+	GHashTable		*custom_flags;		/* (nullable): flag:1, from HwId quirks */
+	guint			 custom_flags_hwids;	/* number of HwIds used for @custom_flags */
 	FuPluginData		*data;
+	/* optional vfuncs called for every device, resolved once when opened */
+	gpointer		 device_registered_func;
+	gpointer		 backend_device_changed_func;
+	gpointer		 backend_device_removed_func;
+	GMutex			 stats_mutex;		/* for @stats_cputime and @stats_calls */
+	guint64			 stats_cputime;		/* us */
+	guint64			 stats_calls;
 } FuPluginPrivate;
 
 enum {
@@ -114,7 +127,24 @@ gboolean
 fu_plugin_is_open (FuPlugin *self)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
-	return priv->module != NULL;
+	return priv->module != NULL || priv->symbols != NULL;
+}
+
+/* from the module, or from the table when linked into the daemon */
+static gboolean
+fu_plugin_get_symbol (FuPlugin *self, const gchar *symbol_name, gpointer *symbol)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	if (priv->module != NULL)
+		return g_module_symbol (priv->module, symbol_name, symbol);
+	*symbol = NULL;
+	for (guint i = 0; priv->symbols != NULL && priv->symbols[i].name != NULL; i++) {
+		if (g_strcmp0 (priv->symbols[i].name, symbol_name) == 0) {
+			*symbol = priv->symbols[i].func;
+			break;
+		}
+	}
+	return *symbol != NULL;
 }
 
 /**
@@ -403,6 +433,29 @@ fu_plugin_guess_name_from_fn (const gchar *filename)
 	return name;
 }
 
+/* resolves the per-device vfuncs and runs init */
+static void
+fu_plugin_init_symbols (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	FuPluginInitFunc func = NULL;
+
+	/* most plugins implement none of these */
+	fu_plugin_get_symbol (self, "fu_plugin_device_registered",
+			      &priv->device_registered_func);
+	fu_plugin_get_symbol (self, "fu_plugin_backend_device_changed",
+			      &priv->backend_device_changed_func);
+	fu_plugin_get_symbol (self, "fu_plugin_backend_device_removed",
+			      &priv->backend_device_removed_func);
+
+	/* optional */
+	fu_plugin_get_symbol (self, "fu_plugin_init", (gpointer *) &func);
+	if (func != NULL) {
+		g_debug ("init(%s)", fu_plugin_get_name (self));
+		func (self);
+	}
+}
+
 /**
  * fu_plugin_open:
  * @self: A #FuPlugin
@@ -419,7 +472,6 @@ gboolean
 fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
-	FuPluginInitFunc func = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
 	g_return_val_if_fail (filename != NULL, FALSE);
@@ -443,13 +495,41 @@ fu_plugin_open (FuPlugin *self, const gchar *filename, GError **error)
 		fu_plugin_set_name (self, str);
 	}
 
-	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_init", (gpointer *) &func);
-	if (func != NULL) {
-		g_debug ("init(%s)", filename);
-		func (self);
-	}
+	fu_plugin_init_symbols (self);
+	return TRUE;
+}
+
+/**
+ * fu_plugin_open_builtin:
+ * @self: A #FuPlugin
+ * @symbols: (array zero-terminated=1): The vfuncs linked into the daemon
+ * @error: A #GError or NULL
+ *
+ * Opens a plugin that was linked into the daemon rather than built as a
+ * module, using a table rather than looking up each symbol in a #GModule.
+ *
+ * Returns: TRUE for success, FALSE for fail
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_plugin_open_builtin (FuPlugin *self, const FuPluginSymbol *symbols, GError **error)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
 
+	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
+	g_return_val_if_fail (symbols != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (fu_plugin_get_name (self) == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "builtin plugin has no name");
+		return FALSE;
+	}
+	priv->symbols = symbols;
+	fu_plugin_init_symbols (self);
 	return TRUE;
 }
 
@@ -741,6 +821,7 @@ fu_plugin_has_custom_flag (FuPlugin *self, const gchar *flag)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	GPtrArray *hwids = fu_plugin_get_hwids (self);
+	g_autoptr(GMutexLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
 	g_return_val_if_fail (flag != NULL, FALSE);
@@ -749,21 +830,30 @@ fu_plugin_has_custom_flag (FuPlugin *self, const gchar *flag)
 	if (hwids == NULL)
 		return FALSE;
 
-	/* search each hwid */
-	for (guint i = 0; i < hwids->len; i++) {
-		const gchar *hwid = g_ptr_array_index (hwids, i);
-		const gchar *value;
-		g_autofree gchar *key = g_strdup_printf ("HwId=%s", hwid);
-
-		/* does prefixed quirk exist */
-		value = fu_quirks_lookup_by_id (priv->quirks, key, FU_QUIRKS_FLAGS);
-		if (value != NULL) {
-			g_auto(GStrv) quirks = g_strsplit (value, ",", -1);
-			if (g_strv_contains ((const gchar * const *) quirks, flag))
-				return TRUE;
+	/* search each hwid once, as the quirks do not change */
+	locker = g_mutex_locker_new (&priv->custom_flags_mutex);
+	if (priv->custom_flags == NULL || priv->custom_flags_hwids != hwids->len) {
+		g_clear_pointer (&priv->custom_flags, g_hash_table_unref);
+		priv->custom_flags = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		priv->custom_flags_hwids = hwids->len;
+		for (guint i = 0; i < hwids->len; i++) {
+			const gchar *hwid = g_ptr_array_index (hwids, i);
+			const gchar *value;
+			g_autofree gchar *key = g_strdup_printf ("HwId=%s", hwid);
+
+			/* does prefixed quirk exist */
+			value = fu_quirks_lookup_by_id (priv->quirks, key, FU_QUIRKS_FLAGS);
+			if (value != NULL) {
+				g_auto(GStrv) quirks = g_strsplit (value, ",", -1);
+				for (guint j = 0; quirks[j] != NULL; j++) {
+					g_hash_table_insert (priv->custom_flags,
+							     g_steal_pointer (&quirks[j]),
+							     GUINT_TO_POINTER (1));
+				}
+			}
 		}
 	}
-	return FALSE;
+	return g_hash_table_contains (priv->custom_flags, flag);
 }
 
 /**
@@ -863,7 +953,9 @@ void
 fu_plugin_set_hwids (FuPlugin *self, FuHwids *hwids)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->custom_flags_mutex);
 	g_set_object (&priv->hwids, hwids);
+	g_clear_pointer (&priv->custom_flags, g_hash_table_unref);
 }
 
 /**
@@ -897,7 +989,9 @@ void
 fu_plugin_set_quirks (FuPlugin *self, FuQuirks *quirks)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->custom_flags_mutex);
 	g_set_object (&priv->quirks, quirks);
+	g_clear_pointer (&priv->custom_flags, g_hash_table_unref);
 }
 
 /**
@@ -1198,6 +1292,53 @@ fu_plugin_device_read_firmware (FuPlugin *self, FuDevice *device, GError **error
 	return fu_device_attach (device, error);
 }
 
+/* the runners can be called from worker threads, so use the thread clock */
+static gint64
+fu_plugin_runner_cputime (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+	if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+#endif
+	return 0;
+}
+
+static void
+fu_plugin_runner_add_cputime (FuPlugin *self, gint64 cputime)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	gint64 cputime_now = fu_plugin_runner_cputime ();
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&priv->stats_mutex);
+	if (cputime_now > cputime)
+		priv->stats_cputime += cputime_now - cputime;
+	priv->stats_calls++;
+}
+
+/**
+ * fu_plugin_get_runner_stats:
+ * @self: a #FuPlugin
+ * @calls: (out) (optional): number of plugin vfuncs called
+ * @cputime: (out) (optional): CPU time used by the vfuncs in microseconds
+ *
+ * Gets statistics about the plugin vfuncs called by the runners since the
+ * plugin was loaded, which is useful to find plugins using too much CPU.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_plugin_get_runner_stats (FuPlugin *self, guint64 *calls, guint64 *cputime)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_autoptr(GMutexLocker) locker = NULL;
+	g_return_if_fail (FU_IS_PLUGIN (self));
+	locker = g_mutex_locker_new (&priv->stats_mutex);
+	if (calls != NULL)
+		*calls = priv->stats_calls;
+	if (cputime != NULL)
+		*cputime = priv->stats_cputime;
+}
+
 /**
  * fu_plugin_runner_startup:
  * @self: a #FuPlugin
@@ -1212,8 +1353,9 @@ fu_plugin_device_read_firmware (FuPlugin *self, FuDevice *device, GError **error
 gboolean
 fu_plugin_runner_startup (FuPlugin *self, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1221,15 +1363,20 @@ fu_plugin_runner_startup (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_startup", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_startup", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("startup(%s)", fu_plugin_get_name (self));
-	if (!func (self, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "startup", fu_plugin_get_name (self), NULL);
+	ret = func (self, &error_local);
+	FU_USDT_PROBE4 (runner__done, "startup", fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in startup(%s)",
 				    fu_plugin_get_name (self));
@@ -1252,8 +1399,9 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 				 FuPluginDeviceFunc device_func,
 				 GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1261,11 +1409,11 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	fu_plugin_get_symbol (self, symbol_name, (gpointer *) &func);
 	if (func == NULL) {
 		if (device_func != NULL) {
 			g_debug ("running superclassed %s(%s)",
@@ -1275,7 +1423,14 @@ fu_plugin_runner_device_generic (FuPlugin *self, FuDevice *device,
 		return TRUE;
 	}
 	g_debug ("%s(%s)", symbol_name + 10, fu_plugin_get_name (self));
-	if (!func (self, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, symbol_name + 10,
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, symbol_name + 10,
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in %s(%s)",
 				    fu_plugin_get_name (self), symbol_name + 10);
@@ -1297,8 +1452,9 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 					 FuDevice *device,
 					 const gchar *symbol_name, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginFlaggedDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1306,15 +1462,22 @@ fu_plugin_runner_flagged_device_generic (FuPlugin *self, FwupdInstallFlags flags
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	fu_plugin_get_symbol (self, symbol_name, (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("%s(%s)", symbol_name + 10, fu_plugin_get_name (self));
-	if (!func (self, flags, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, symbol_name + 10,
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, flags, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, symbol_name + 10,
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in %s(%s)",
 				    fu_plugin_get_name (self), symbol_name + 10);
@@ -1336,8 +1499,9 @@ static gboolean
 fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 				       const gchar *symbol_name, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceArrayFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1345,15 +1509,20 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	fu_plugin_get_symbol (self, symbol_name, (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("%s(%s)", symbol_name + 10, fu_plugin_get_name (self));
-	if (!func (self, devices, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, symbol_name + 10, fu_plugin_get_name (self), NULL);
+	ret = func (self, devices, &error_local);
+	FU_USDT_PROBE4 (runner__done, symbol_name + 10, fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in for %s(%s)",
 				    fu_plugin_get_name (self), symbol_name + 10);
@@ -1384,8 +1553,9 @@ fu_plugin_runner_device_array_generic (FuPlugin *self, GPtrArray *devices,
 gboolean
 fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1393,15 +1563,20 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_coldplug", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("coldplug(%s)", fu_plugin_get_name (self));
-	if (!func (self, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "coldplug", fu_plugin_get_name (self), NULL);
+	ret = func (self, &error_local);
+	FU_USDT_PROBE4 (runner__done, "coldplug", fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in coldplug(%s)",
 				    fu_plugin_get_name (self));
@@ -1431,8 +1606,9 @@ fu_plugin_runner_coldplug (FuPlugin *self, GError **error)
 gboolean
 fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1440,15 +1616,20 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_recoldplug", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_recoldplug", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("recoldplug(%s)", fu_plugin_get_name (self));
-	if (!func (self, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "recoldplug", fu_plugin_get_name (self), NULL);
+	ret = func (self, &error_local);
+	FU_USDT_PROBE4 (runner__done, "recoldplug", fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in recoldplug(%s)",
 				    fu_plugin_get_name (self));
@@ -1479,8 +1660,9 @@ fu_plugin_runner_recoldplug (FuPlugin *self, GError **error)
 gboolean
 fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1488,15 +1670,20 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug_prepare", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_coldplug_prepare", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("coldplug_prepare(%s)", fu_plugin_get_name (self));
-	if (!func (self, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "coldplug_prepare", fu_plugin_get_name (self), NULL);
+	ret = func (self, &error_local);
+	FU_USDT_PROBE4 (runner__done, "coldplug_prepare", fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in coldplug_prepare(%s)",
 				    fu_plugin_get_name (self));
@@ -1527,8 +1714,9 @@ fu_plugin_runner_coldplug_prepare (FuPlugin *self, GError **error)
 gboolean
 fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginStartupFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1536,15 +1724,20 @@ fu_plugin_runner_coldplug_cleanup (FuPlugin *self, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_coldplug_cleanup", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_coldplug_cleanup", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("coldplug_cleanup(%s)", fu_plugin_get_name (self));
-	if (!func (self, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "coldplug_cleanup", fu_plugin_get_name (self), NULL);
+	ret = func (self, &error_local);
+	FU_USDT_PROBE4 (runner__done, "coldplug_cleanup", fu_plugin_get_name (self), NULL, ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in coldplug_cleanup(%s)",
 				    fu_plugin_get_name (self));
@@ -1727,29 +1920,34 @@ fu_plugin_runner_update_reload (FuPlugin *self, FuDevice *device, GError **error
 void
 fu_plugin_runner_add_security_attrs (FuPlugin *self, FuSecurityAttrs *attrs)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginSecurityAttrsFunc func = NULL;
 	const gchar *symbol_name = "fu_plugin_add_security_attrs";
+	gint64 cputime;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return;
 
 	/* optional, but gets called even for disabled plugins */
-	g_module_symbol (priv->module, symbol_name, (gpointer *) &func);
+	fu_plugin_get_symbol (self, symbol_name, (gpointer *) &func);
 	if (func == NULL)
 		return;
 	g_debug ("%s(%s)", symbol_name + 10, fu_plugin_get_name (self));
+	cputime = fu_plugin_runner_cputime ();
 	func (self, attrs);
+	fu_plugin_runner_add_cputime (self, cputime);
 }
 
 /**
  * fu_plugin_add_udev_subsystem:
  * @self: a #FuPlugin
- * @subsystem: a subsystem name, e.g. `pciport`
+ * @subsystem: a subsystem name, e.g. `pciport`, or `block/disk`
  *
  * Registers the udev subsystem to be watched by the daemon.
  *
+ * If a devtype is included then only devices of that type are added, which
+ * avoids probing devices the plugin would reject.
+ *
  * Plugins can use this method only in fu_plugin_init()
  *
  * Since: 1.1.2
@@ -1790,6 +1988,24 @@ fu_plugin_set_device_gtype (FuPlugin *self, GType device_gtype)
 	priv->device_gtype = device_gtype;
 }
 
+/**
+ * fu_plugin_get_device_gtype:
+ * @self: a #FuPlugin
+ *
+ * Gets the device #GType which is used when creating devices.
+ *
+ * Returns: a #GType, or %G_TYPE_INVALID if unset
+ *
+ * Since: 1.5.8
+ **/
+GType
+fu_plugin_get_device_gtype (FuPlugin *self)
+{
+	FuPluginPrivate *priv = GET_PRIVATE (self);
+	g_return_val_if_fail (FU_IS_PLUGIN (self), G_TYPE_INVALID);
+	return priv->device_gtype;
+}
+
 static gchar *
 fu_common_string_uncamelcase (const gchar *str)
 {
@@ -1842,7 +2058,7 @@ fu_plugin_check_supported_device (FuPlugin *self, FuDevice *device)
 	GPtrArray *instance_ids = fu_device_get_instance_ids (device);
 	for (guint i = 0; i < instance_ids->len; i++) {
 		const gchar *instance_id = g_ptr_array_index (instance_ids, i);
-		g_autofree gchar *guid = fwupd_guid_hash_string (instance_id);
+		const gchar *guid = fu_common_guid_hash_string_cached (instance_id);
 		if (fu_plugin_check_supported (self, guid))
 			return TRUE;
 	}
@@ -1942,6 +2158,8 @@ fu_plugin_runner_backend_device_added (FuPlugin *self, FuDevice *device, GError
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -1953,11 +2171,11 @@ fu_plugin_runner_backend_device_added (FuPlugin *self, FuDevice *device, GError
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_backend_device_added", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_backend_device_added", (gpointer *) &func);
 	if (func == NULL) {
 		if (priv->device_gtype != G_TYPE_INVALID ||
 		    fu_device_get_specialized_gtype (device) != G_TYPE_INVALID) {
@@ -1970,7 +2188,14 @@ fu_plugin_runner_backend_device_added (FuPlugin *self, FuDevice *device, GError
 		return FALSE;
 	}
 	g_debug ("backend_device_added(%s)", fu_plugin_get_name (self));
-	if (!func (self, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "backend_device_added",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, "backend_device_added",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in backend_device_added(%s)",
 				    fu_plugin_get_name (self));
@@ -2021,7 +2246,9 @@ gboolean
 fu_plugin_runner_backend_device_changed (FuPlugin *self, FuDevice *device, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
-	FuPluginDeviceFunc func = NULL;
+	FuPluginDeviceFunc func = priv->backend_device_changed_func;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2033,15 +2260,21 @@ fu_plugin_runner_backend_device_changed (FuPlugin *self, FuDevice *device, GErro
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_backend_device_changed", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("udev_device_changed(%s)", fu_plugin_get_name (self));
-	if (!func (self, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "backend_device_changed",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, "backend_device_changed",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in udev_device_changed(%s)",
 				    fu_plugin_get_name (self));
@@ -2070,21 +2303,23 @@ fu_plugin_runner_backend_device_changed (FuPlugin *self, FuDevice *device, GErro
 void
 fu_plugin_runner_device_added (FuPlugin *self, FuDevice *device)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceRegisterFunc func = NULL;
+	gint64 cputime;
 
 	/* not enabled */
 	if (fu_plugin_has_flag (self, FWUPD_PLUGIN_FLAG_DISABLED))
 		return;
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_device_added", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_device_added", (gpointer *) &func);
 	if (func == NULL)
 		return;
 	g_debug ("fu_plugin_device_added(%s)", fu_plugin_get_name (self));
+	cputime = fu_plugin_runner_cputime ();
 	func (self, device);
+	fu_plugin_runner_add_cputime (self, cputime);
 }
 
 /**
@@ -2099,8 +2334,12 @@ fu_plugin_runner_device_added (FuPlugin *self, FuDevice *device)
 void
 fu_plugin_runner_device_removed (FuPlugin *self, FuDevice *device)
 {
+	FuPluginPrivate *priv = GET_PRIVATE (self);
 	g_autoptr(GError) error_local= NULL;
 
+	/* optional */
+	if (priv->backend_device_removed_func == NULL)
+		return;
 	if (!fu_plugin_runner_device_generic (self, device,
 					      "fu_plugin_backend_device_removed",
 					      NULL,
@@ -2121,19 +2360,20 @@ void
 fu_plugin_runner_device_register (FuPlugin *self, FuDevice *device)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
-	FuPluginDeviceRegisterFunc func = NULL;
+	FuPluginDeviceRegisterFunc func = priv->device_registered_func;
 
 	/* not enabled */
 	if (fu_plugin_has_flag (self, FWUPD_PLUGIN_FLAG_DISABLED))
 		return;
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_device_registered", (gpointer *) &func);
 	if (func != NULL) {
+		gint64 cputime = fu_plugin_runner_cputime ();
 		g_debug ("fu_plugin_device_registered(%s)", fu_plugin_get_name (self));
 		func (self, device);
+		fu_plugin_runner_add_cputime (self, cputime);
 	}
 }
 
@@ -2152,7 +2392,6 @@ fu_plugin_runner_device_register (FuPlugin *self, FuDevice *device)
 gboolean
 fu_plugin_runner_device_created (FuPlugin *self, FuDevice *device, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2162,11 +2401,11 @@ fu_plugin_runner_device_created (FuPlugin *self, FuDevice *device, GError **erro
 	/* not enabled */
 	if (fu_plugin_has_flag (self, FWUPD_PLUGIN_FLAG_DISABLED))
 		return TRUE;
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_device_created", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_device_created", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("fu_plugin_device_created(%s)", fu_plugin_get_name (self));
@@ -2192,9 +2431,10 @@ fu_plugin_runner_verify (FuPlugin *self,
 			 FuPluginVerifyFlags flags,
 			 GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginVerifyFunc func = NULL;
 	GPtrArray *checksums;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2206,11 +2446,11 @@ fu_plugin_runner_verify (FuPlugin *self,
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_verify", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_verify", (gpointer *) &func);
 	if (func == NULL) {
 		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY)) {
 			g_set_error (error,
@@ -2236,7 +2476,14 @@ fu_plugin_runner_verify (FuPlugin *self,
 
 	/* run vfunc */
 	g_debug ("verify(%s)", fu_plugin_get_name (self));
-	if (!func (self, device, flags, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "verify",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, flags, &error_local);
+	FU_USDT_PROBE4 (runner__done, "verify",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		g_autoptr(GError) error_attach = NULL;
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in verify(%s)",
@@ -2382,8 +2629,9 @@ fu_plugin_runner_update (FuPlugin *self,
 			 FwupdInstallFlags flags,
 			 GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginUpdateFunc update_func;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2397,20 +2645,34 @@ fu_plugin_runner_update (FuPlugin *self,
 	}
 
 	/* no object loaded */
-	if (priv->module == NULL) {
+	if (!fu_plugin_is_open (self)) {
 		g_debug ("module not enabled, skipping");
 		return TRUE;
 	}
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_update", (gpointer *) &update_func);
+	fu_plugin_get_symbol (self, "fu_plugin_update", (gpointer *) &update_func);
 	if (update_func == NULL) {
 		g_debug ("superclassed write_firmware(%s)", fu_plugin_get_name (self));
-		return fu_plugin_device_write_firmware (self, device, blob_fw, flags, error);
+		cputime = fu_plugin_runner_cputime ();
+		FU_USDT_PROBE3 (runner__start, "write_firmware",
+				fu_plugin_get_name (self), fu_device_get_id (device));
+		ret = fu_plugin_device_write_firmware (self, device, blob_fw, flags, error);
+		FU_USDT_PROBE4 (runner__done, "write_firmware",
+				fu_plugin_get_name (self), fu_device_get_id (device), ret);
+		fu_plugin_runner_add_cputime (self, cputime);
+		return ret;
 	}
 
 	/* online */
-	if (!update_func (self, device, blob_fw, flags, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "update",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = update_func (self, device, blob_fw, flags, &error_local);
+	FU_USDT_PROBE4 (runner__done, "update",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in update(%s)",
 				    fu_plugin_get_name (self));
@@ -2451,8 +2713,9 @@ fu_plugin_runner_update (FuPlugin *self,
 gboolean
 fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2464,15 +2727,22 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_clear_results", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_clear_results", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("clear_result(%s)", fu_plugin_get_name (self));
-	if (!func (self, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "clear_results",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, "clear_results",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in clear_result(%s)",
 				    fu_plugin_get_name (self));
@@ -2504,8 +2774,9 @@ fu_plugin_runner_clear_results (FuPlugin *self, FuDevice *device, GError **error
 gboolean
 fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 {
-	FuPluginPrivate *priv = GET_PRIVATE (self);
 	FuPluginDeviceFunc func = NULL;
+	gboolean ret;
+	gint64 cputime;
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail (FU_IS_PLUGIN (self), FALSE);
@@ -2517,15 +2788,22 @@ fu_plugin_runner_get_results (FuPlugin *self, FuDevice *device, GError **error)
 		return TRUE;
 
 	/* no object loaded */
-	if (priv->module == NULL)
+	if (!fu_plugin_is_open (self))
 		return TRUE;
 
 	/* optional */
-	g_module_symbol (priv->module, "fu_plugin_get_results", (gpointer *) &func);
+	fu_plugin_get_symbol (self, "fu_plugin_get_results", (gpointer *) &func);
 	if (func == NULL)
 		return TRUE;
 	g_debug ("get_results(%s)", fu_plugin_get_name (self));
-	if (!func (self, device, &error_local)) {
+	cputime = fu_plugin_runner_cputime ();
+	FU_USDT_PROBE3 (runner__start, "get_results",
+			fu_plugin_get_name (self), fu_device_get_id (device));
+	ret = func (self, device, &error_local);
+	FU_USDT_PROBE4 (runner__done, "get_results",
+			fu_plugin_get_name (self), fu_device_get_id (device), ret);
+	fu_plugin_runner_add_cputime (self, cputime);
+	if (!ret) {
 		if (error_local == NULL) {
 			g_critical ("unset plugin error in get_results(%s)",
 				    fu_plugin_get_name (self));
@@ -2629,6 +2907,8 @@ void
 fu_plugin_add_rule (FuPlugin *self, FuPluginRule rule, const gchar *name)
 {
 	FuPluginPrivate *priv = fu_plugin_get_instance_private (self);
+	if (fu_plugin_has_rule (self, rule, name))
+		return;
 	if (priv->rules[rule] == NULL)
 		priv->rules[rule] = g_ptr_array_new_with_free_func (g_free);
 	g_ptr_array_add (priv->rules[rule], g_strdup (name));
@@ -2881,6 +3161,8 @@ fu_plugin_init (FuPlugin *self)
 {
 	FuPluginPrivate *priv = GET_PRIVATE (self);
 	g_rw_lock_init (&priv->cache_mutex);
+	g_mutex_init (&priv->custom_flags_mutex);
+	g_mutex_init (&priv->stats_mutex);
 }
 
 static void
@@ -2891,10 +3173,12 @@ fu_plugin_finalize (GObject *object)
 	FuPluginInitFunc func = NULL;
 
 	g_rw_lock_clear (&priv->cache_mutex);
+	g_mutex_clear (&priv->custom_flags_mutex);
+	g_mutex_clear (&priv->stats_mutex);
 
 	/* optional */
-	if (priv->module != NULL) {
-		g_module_symbol (priv->module, "fu_plugin_destroy", (gpointer *) &func);
+	if (fu_plugin_is_open (self)) {
+		fu_plugin_get_symbol (self, "fu_plugin_destroy", (gpointer *) &func);
 		if (func != NULL) {
 			g_debug ("destroy(%s)", fu_plugin_get_name (self));
 			func (self);
@@ -2923,6 +3207,8 @@ fu_plugin_finalize (GObject *object)
 		g_hash_table_unref (priv->report_metadata);
 	if (priv->cache != NULL)
 		g_hash_table_unref (priv->cache);
+	if (priv->custom_flags != NULL)
+		g_hash_table_unref (priv->custom_flags);
 	g_free (priv->build_hash);
 	g_free (priv->data);
 	/* Must happen as the last step to avoid prematurely
@@ -53,8 +53,21 @@ struct _FuQuirks
 	GObject			 parent_instance;
 	FuQuirksLoadFlags	 load_flags;
 	XbSilo			*silo;
+	XbSilo			*silo_overlay;	/* (nullable) when @silo was prebuilt */
+	GHashTable		*index;		/* (nullable) group-key:GArray of FuQuirksEntry */
+	GRWLock			 index_mutex;
+	XbQuery			*query_kv;	/* (nullable) */
+	XbQuery			*query_group;	/* (nullable) */
+	gint			 lookup_hits;
+	gint			 lookup_misses;
 };
 
+/* strings are owned by the silo */
+typedef struct {
+	const gchar		*key;
+	const gchar		*value;
+} FuQuirksEntry;
+
 G_DEFINE_TYPE (FuQuirks, fu_quirks, G_TYPE_OBJECT)
 
 static gchar *
@@ -138,9 +151,13 @@ fu_quirks_filename_sort_cb (gconstpointer a, gconstpointer b)
 	return g_strcmp0 (stra, strb);
 }
 
+/* files listed in @skip are already in the prebuilt silo, and the basenames of
+ * the files that are added are appended to @sources if provided */
 static gboolean
 fu_quirks_add_quirks_for_path (FuQuirks *self, XbBuilder *builder,
-			       const gchar *path, GError **error)
+			       const gchar *path, GHashTable *skip,
+			       XbBuilderNode *sources, guint *cnt,
+			       GError **error)
 {
 	const gchar *tmp;
 	g_autofree gchar *path_hw = NULL;
@@ -159,6 +176,8 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, XbBuilder *builder,
 			g_debug ("skipping invalid file %s", tmp);
 			continue;
 		}
+		if (skip != NULL && g_hash_table_contains (skip, tmp))
+			continue;
 		g_ptr_array_add (filenames, g_build_filename (path_hw, tmp, NULL));
 	}
 
@@ -191,36 +210,174 @@ fu_quirks_add_quirks_for_path (FuQuirks *self, XbBuilder *builder,
 
 		/* watch the file for changes */
 		xb_builder_import_source (builder, source);
+		if (sources != NULL) {
+			g_autofree gchar *basename = g_path_get_basename (filename);
+			xb_builder_node_insert_text (sources, "source", basename, NULL);
+		}
+		if (cnt != NULL)
+			(*cnt)++;
 	}
 
 	/* success */
 	return TRUE;
 }
 
+static void
+fu_quirks_index_entries_free (GArray *entries)
+{
+	g_array_unref (entries);
+}
+
+static gboolean
+fu_quirks_add_index_for_silo (GHashTable *index, XbSilo *silo, GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	devices = xb_silo_query (silo, "quirk/device", 0, &error_local);
+	if (devices == NULL) {
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+			g_debug ("no quirk entries found");
+		} else {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return FALSE;
+		}
+	}
+	for (guint i = 0; devices != NULL && i < devices->len; i++) {
+		XbNode *n = g_ptr_array_index (devices, i);
+		const gchar *group_key = xb_node_get_attr (n, "id");
+		GArray *entries;
+		g_autoptr(GPtrArray) values = NULL;
+
+		if (group_key == NULL)
+			continue;
+		entries = g_hash_table_lookup (index, group_key);
+		if (entries == NULL) {
+			entries = g_array_new (FALSE, FALSE, sizeof(FuQuirksEntry));
+			g_hash_table_insert (index, (gpointer) group_key, entries);
+		}
+		values = xb_node_get_children (n);
+		for (guint j = 0; j < values->len; j++) {
+			XbNode *c = g_ptr_array_index (values, j);
+			FuQuirksEntry entry = {
+				.key = xb_node_get_attr (c, "key"),
+				.value = xb_node_get_text (c),
+			};
+			if (entry.key == NULL)
+				continue;
+			g_array_append_val (entries, entry);
+		}
+	}
+	return TRUE;
+}
+
+/* build a group-key -> entries index from all the silos, so that the
+ * common case of looking up a key never has to run an XPath query */
+static gboolean
+fu_quirks_build_index (FuQuirks *self, GError **error)
+{
+	g_autoptr(GHashTable) index = NULL;
+
+	index = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+				       (GDestroyNotify) fu_quirks_index_entries_free);
+	if (!fu_quirks_add_index_for_silo (index, self->silo, error))
+		return FALSE;
+	if (self->silo_overlay != NULL &&
+	    !fu_quirks_add_index_for_silo (index, self->silo_overlay, error))
+		return FALSE;
+	g_debug ("built quirk index of %u groups", g_hash_table_size (index));
+	self->index = g_steal_pointer (&index);
+	return TRUE;
+}
+
+/* the silo compiled at install time, with the basenames of the files it
+ * was built from added to @sources */
+static XbSilo *
+fu_quirks_load_prebuilt (const gchar *path, GHashTable *sources, GError **error)
+{
+	g_autofree gchar *fn = g_build_filename (path, "quirks.xmlb", NULL);
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GPtrArray) nodes = NULL;
+	g_autoptr(XbSilo) silo = xb_silo_new ();
+
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "%s does not exist", fn);
+		return NULL;
+	}
+	file = g_file_new_for_path (fn);
+	if (!xb_silo_load_from_file (silo, file, XB_SILO_LOAD_FLAG_WATCH_BLOB, NULL, error))
+		return NULL;
+	nodes = xb_silo_query (silo, "sources/source", 0, error);
+	if (nodes == NULL)
+		return NULL;
+	for (guint i = 0; i < nodes->len; i++) {
+		XbNode *n = g_ptr_array_index (nodes, i);
+		g_hash_table_add (sources, g_strdup (xb_node_get_text (n)));
+	}
+	return g_steal_pointer (&silo);
+}
+
+static gboolean
+fu_quirks_is_valid (FuQuirks *self)
+{
+	if (self->silo == NULL || !xb_silo_is_valid (self->silo))
+		return FALSE;
+	if (self->silo_overlay != NULL && !xb_silo_is_valid (self->silo_overlay))
+		return FALSE;
+	return TRUE;
+}
+
 static gboolean
 fu_quirks_check_silo (FuQuirks *self, GError **error)
 {
 	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_WATCH_BLOB;
+	guint cnt = 0;
 	g_autofree gchar *cachedirpkg = NULL;
 	g_autofree gchar *datadir = NULL;
 	g_autofree gchar *localstatedir = NULL;
 	g_autofree gchar *xmlbfn = NULL;
 	g_autoptr(GFile) file = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GError) error_prebuilt = NULL;
+	g_autoptr(GHashTable) prebuilt_sources = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
 	g_autoptr(XbBuilder) builder = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_prebuilt = NULL;
 
 	/* everything is okay */
-	if (self->silo != NULL && xb_silo_is_valid (self->silo))
+	if (fu_quirks_is_valid (self))
 		return TRUE;
 
-	/* system datadir */
-	builder = xb_builder_new ();
+	/* check again now we have the lock */
+	locker = g_rw_lock_writer_locker_new (&self->index_mutex);
+	if (fu_quirks_is_valid (self))
+		return TRUE;
+
+	/* use the silo compiled at install time if it matches this libxmlb */
 	datadir = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
-	if (!fu_quirks_add_quirks_for_path (self, builder, datadir, error))
+	prebuilt_sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	silo_prebuilt = fu_quirks_load_prebuilt (datadir, prebuilt_sources, &error_prebuilt);
+	if (silo_prebuilt == NULL) {
+		if (!g_error_matches (error_prebuilt, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND))
+			g_debug ("ignoring prebuilt quirks: %s", error_prebuilt->message);
+		g_hash_table_remove_all (prebuilt_sources);
+	}
+
+	/* system datadir, only for files added since the prebuilt silo */
+	builder = xb_builder_new ();
+	if (!fu_quirks_add_quirks_for_path (self, builder, datadir,
+					    silo_prebuilt != NULL ? prebuilt_sources : NULL,
+					    NULL, &cnt, error))
 		return FALSE;
 
 	/* something we can write when using Ostree */
 	localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
-	if (!fu_quirks_add_quirks_for_path (self, builder, localstatedir, error))
+	if (!fu_quirks_add_quirks_for_path (self, builder, localstatedir,
+					    NULL, NULL, &cnt, error))
 		return FALSE;
 
 	/* load silo */
@@ -234,8 +391,76 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 	}
 	if (self->load_flags & FU_QUIRKS_LOAD_FLAG_READONLY_FS)
 		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
-	self->silo = xb_builder_ensure (builder, file, compile_flags, NULL, error);
-	return self->silo != NULL;
+	g_clear_object (&self->silo);
+	g_clear_object (&self->silo_overlay);
+	g_clear_object (&self->query_kv);
+	g_clear_object (&self->query_group);
+	g_clear_pointer (&self->index, g_hash_table_unref);
+
+	/* nothing to compile */
+	if (silo_prebuilt != NULL && cnt == 0) {
+		g_debug ("using prebuilt quirks");
+		self->silo = g_steal_pointer (&silo_prebuilt);
+	} else {
+		silo = xb_builder_ensure (builder, file, compile_flags, NULL, error);
+		if (silo == NULL)
+			return FALSE;
+		if (silo_prebuilt != NULL) {
+			g_debug ("using prebuilt quirks with %u overlay files", cnt);
+			self->silo = g_steal_pointer (&silo_prebuilt);
+			self->silo_overlay = g_steal_pointer (&silo);
+		} else {
+			self->silo = g_steal_pointer (&silo);
+		}
+	}
+
+	/* if this fails then fall back to prepared queries, which are only
+	 * run against one silo */
+	if (!fu_quirks_build_index (self, &error_local)) {
+		if (self->silo_overlay != NULL) {
+			g_propagate_prefixed_error (error, g_steal_pointer (&error_local),
+						    "failed to build quirk index: ");
+			return FALSE;
+		}
+		g_warning ("failed to build quirk index: %s", error_local->message);
+	}
+	return TRUE;
+}
+
+/**
+ * fu_quirks_compile_to_file:
+ * @self: A #FuQuirks
+ * @path: A directory containing `quirks.d`, e.g. `/usr/share/fwupd`
+ * @file: A #GFile, typically `quirks.xmlb` in @path
+ * @error: A #GError, or %NULL
+ *
+ * Compiles all the quirk files in @path into a silo. If saved as `quirks.xmlb`
+ * in the system data directory it is used by fu_quirks_load() so that only the
+ * quirk files added afterwards have to be parsed.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_quirks_compile_to_file (FuQuirks *self, const gchar *path, GFile *file, GError **error)
+{
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderNode) sources = xb_builder_node_new ("sources");
+	g_autoptr(XbSilo) silo = NULL;
+
+	g_return_val_if_fail (FU_IS_QUIRKS (self), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	if (!fu_quirks_add_quirks_for_path (self, builder, path, NULL, sources, NULL, error))
+		return FALSE;
+	xb_builder_import_node (builder, sources);
+	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (silo == NULL)
+		return FALSE;
+	return xb_silo_save_to_file (silo, file, NULL, error);
 }
 
 /**
@@ -253,10 +478,11 @@ fu_quirks_check_silo (FuQuirks *self, GError **error)
 const gchar *
 fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 {
+	GArray *entries;
 	g_autofree gchar *group_key = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	g_autoptr(XbNode) n = NULL;
-	g_autoptr(XbQuery) query = NULL;
 #if LIBXMLB_CHECK_VERSION(0,3,0)
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT ();
 #endif
@@ -270,39 +496,57 @@ fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 		g_warning ("failed to build silo: %s", error->message);
 		return NULL;
 	}
+	locker = g_rw_lock_reader_locker_new (&self->index_mutex);
 
-	/* query */
+	/* use the index */
 	group_key = fu_quirks_build_group_key (group);
-	query = xb_query_new_full (self->silo,
-				   "quirk/device[@id=?]/value[@key=?]",
-				   XB_QUERY_FLAG_NONE,
-				   &error);
-	if (query == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return NULL;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return NULL;
-		g_warning ("failed to build query: %s", error->message);
+	if (self->index != NULL) {
+		entries = g_hash_table_lookup (self->index, group_key);
+		for (guint i = 0; entries != NULL && i < entries->len; i++) {
+			FuQuirksEntry *entry = &g_array_index (entries, FuQuirksEntry, i);
+			if (g_strcmp0 (entry->key, key) == 0) {
+				g_atomic_int_inc (&self->lookup_hits);
+				return entry->value;
+			}
+		}
+		g_atomic_int_inc (&self->lookup_misses);
 		return NULL;
 	}
 
+	/* fall back to a prepared query */
+	if (self->query_kv == NULL) {
+		self->query_kv = xb_query_new_full (self->silo,
+						    "quirk/device[@id=?]/value[@key=?]",
+						    XB_QUERY_FLAG_NONE,
+						    &error);
+		if (self->query_kv == NULL) {
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+				return NULL;
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				return NULL;
+			g_warning ("failed to build query: %s", error->message);
+			return NULL;
+		}
+	}
+
 #if LIBXMLB_CHECK_VERSION(0,3,0)
 	xb_value_bindings_bind_str (xb_query_context_get_bindings (&context), 0, group_key, NULL);
 	xb_value_bindings_bind_str (xb_query_context_get_bindings (&context), 1, key, NULL);
-	n = xb_silo_query_first_with_context (self->silo, query, &context, &error);
+	n = xb_silo_query_first_with_context (self->silo, self->query_kv, &context, &error);
 #else
-	if (!xb_query_bind_str (query, 0, group_key, &error)) {
+	if (!xb_query_bind_str (self->query_kv, 0, group_key, &error)) {
 		g_warning ("failed to bind 0: %s", error->message);
 		return NULL;
 	}
-	if (!xb_query_bind_str (query, 1, key, &error)) {
+	if (!xb_query_bind_str (self->query_kv, 1, key, &error)) {
 		g_warning ("failed to bind 1: %s", error->message);
 		return NULL;
 	}
-	n = xb_silo_query_first_full (self->silo, query, &error);
+	n = xb_silo_query_first_full (self->silo, self->query_kv, &error);
 #endif
 
 	if (n == NULL) {
+		g_atomic_int_inc (&self->lookup_misses);
 		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
 			return NULL;
 		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
@@ -310,6 +554,7 @@ fu_quirks_lookup_by_id (FuQuirks *self, const gchar *group, const gchar *key)
 		g_warning ("failed to query: %s", error->message);
 		return NULL;
 	}
+	g_atomic_int_inc (&self->lookup_hits);
 	return xb_node_get_text (n);
 }
 
@@ -333,7 +578,7 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 	g_autofree gchar *group_key = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) results = NULL;
-	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
 #if LIBXMLB_CHECK_VERSION(0,3,0)
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT ();
 #endif
@@ -347,34 +592,64 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 		g_warning ("failed to build silo: %s", error->message);
 		return FALSE;
 	}
+	locker = g_rw_lock_reader_locker_new (&self->index_mutex);
 
-	/* query */
+	/* use the index */
 	group_key = fu_quirks_build_group_key (group);
-	query = xb_query_new_full (self->silo,
-				   "quirk/device[@id=?]/value",
-				   XB_QUERY_FLAG_NONE,
-				   &error);
-	if (query == NULL) {
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+	if (self->index != NULL) {
+		GArray *entries_tmp = g_hash_table_lookup (self->index, group_key);
+		g_autoptr(GArray) entries = NULL;
+		g_autoptr(XbSilo) silo = NULL;
+		g_autoptr(XbSilo) silo_overlay = NULL;
+		if (entries_tmp == NULL || entries_tmp->len == 0) {
+			g_atomic_int_inc (&self->lookup_misses);
 			return FALSE;
-		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+		}
+		g_atomic_int_inc (&self->lookup_hits);
+
+		/* the callback may do more lookups, so drop the lock but keep
+		 * the silos alive as they own the strings */
+		entries = g_array_ref (entries_tmp);
+		silo = g_object_ref (self->silo);
+		if (self->silo_overlay != NULL)
+			silo_overlay = g_object_ref (self->silo_overlay);
+		g_clear_pointer (&locker, g_rw_lock_reader_locker_free);
+		for (guint i = 0; i < entries->len; i++) {
+			FuQuirksEntry *entry = &g_array_index (entries, FuQuirksEntry, i);
+			iter_cb (self, entry->key, entry->value, user_data);
+		}
+		return TRUE;
+	}
+
+	/* fall back to a prepared query */
+	if (self->query_group == NULL) {
+		self->query_group = xb_query_new_full (self->silo,
+						       "quirk/device[@id=?]/value",
+						       XB_QUERY_FLAG_NONE,
+						       &error);
+		if (self->query_group == NULL) {
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+				return FALSE;
+			if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
+				return FALSE;
+			g_warning ("failed to build query: %s", error->message);
 			return FALSE;
-		g_warning ("failed to build query: %s", error->message);
-		return FALSE;
+		}
 	}
 
 #if LIBXMLB_CHECK_VERSION(0,3,0)
 	xb_value_bindings_bind_str (xb_query_context_get_bindings (&context), 0, group_key, NULL);
-	results = xb_silo_query_with_context (self->silo, query, &context, &error);
+	results = xb_silo_query_with_context (self->silo, self->query_group, &context, &error);
 #else
-	if (!xb_query_bind_str (query, 0, group_key, &error)) {
+	if (!xb_query_bind_str (self->query_group, 0, group_key, &error)) {
 		g_warning ("failed to bind 0: %s", error->message);
 		return FALSE;
 	}
-	results = xb_silo_query_full (self->silo, query, &error);
+	results = xb_silo_query_full (self->silo, self->query_group, &error);
 #endif
 
 	if (results == NULL) {
+		g_atomic_int_inc (&self->lookup_misses);
 		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
 			return FALSE;
 		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
@@ -382,6 +657,8 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 		g_warning ("failed to query: %s", error->message);
 		return FALSE;
 	}
+	g_atomic_int_inc (&self->lookup_hits);
+	g_clear_pointer (&locker, g_rw_lock_reader_locker_free);
 	for (guint i = 0; i < results->len; i++) {
 		XbNode *n = g_ptr_array_index (results, i);
 		iter_cb (self,
@@ -392,6 +669,27 @@ fu_quirks_lookup_by_id_iter (FuQuirks *self, const gchar *group,
 	return TRUE;
 }
 
+/**
+ * fu_quirks_get_lookup_stats:
+ * @self: A #FuQuirks
+ * @hits: (out) (optional): number of lookups that found an entry
+ * @misses: (out) (optional): number of lookups that found nothing
+ *
+ * Gets the number of lookups done since the quirks were loaded, which is
+ * useful when profiling the cost of adding instance IDs to devices.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_quirks_get_lookup_stats (FuQuirks *self, guint *hits, guint *misses)
+{
+	g_return_if_fail (FU_IS_QUIRKS (self));
+	if (hits != NULL)
+		*hits = (guint) g_atomic_int_get (&self->lookup_hits);
+	if (misses != NULL)
+		*misses = (guint) g_atomic_int_get (&self->lookup_misses);
+}
+
 /**
  * fu_quirks_load: (skip)
  * @self: A #FuQuirks
@@ -423,14 +721,28 @@ fu_quirks_class_init (FuQuirksClass *klass)
 static void
 fu_quirks_init (FuQuirks *self)
 {
+	g_rw_lock_init (&self->index_mutex);
 }
 
 static void
 fu_quirks_finalize (GObject *obj)
 {
 	FuQuirks *self = FU_QUIRKS (obj);
+	if (self->lookup_hits > 0 || self->lookup_misses > 0) {
+		g_debug ("quirk lookups: %i hits, %i misses",
+			 self->lookup_hits, self->lookup_misses);
+	}
+	if (self->index != NULL)
+		g_hash_table_unref (self->index);
+	if (self->query_kv != NULL)
+		g_object_unref (self->query_kv);
+	if (self->query_group != NULL)
+		g_object_unref (self->query_group);
 	if (self->silo != NULL)
 		g_object_unref (self->silo);
+	if (self->silo_overlay != NULL)
+		g_object_unref (self->silo_overlay);
+	g_rw_lock_clear (&self->index_mutex);
 	G_OBJECT_CLASS (fu_quirks_parent_class)->finalize (obj);
 }
 
@@ -43,6 +43,14 @@ gboolean	 fu_quirks_lookup_by_id_iter		(FuQuirks	*self,
 							 const gchar	*group,
 							 FuQuirksIter	 iter_cb,
 							 gpointer	 user_data);
+void		 fu_quirks_get_lookup_stats		(FuQuirks	*self,
+							 guint		*hits,
+							 guint		*misses);
+gboolean	 fu_quirks_compile_to_file		(FuQuirks	*self,
+							 const gchar	*path,
+							 GFile		*file,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 
 #define	FU_QUIRKS_PLUGIN			"Plugin"
 #define	FU_QUIRKS_FLAGS				"Flags"
@@ -61,6 +69,7 @@ gboolean	 fu_quirks_lookup_by_id_iter		(FuQuirks	*self,
 #define	FU_QUIRKS_FIRMWARE_SIZE_MIN		"FirmwareSizeMin"
 #define	FU_QUIRKS_FIRMWARE_SIZE_MAX		"FirmwareSizeMax"
 #define	FU_QUIRKS_FIRMWARE_SIZE			"FirmwareSize"
+#define	FU_QUIRKS_FIRMWARE_BLOCK_SIZE		"FirmwareBlockSize"
 #define	FU_QUIRKS_INSTALL_DURATION		"InstallDuration"
 #define	FU_QUIRKS_VERSION_FORMAT		"VersionFormat"
 #define	FU_QUIRKS_GTYPE				"GType"
@@ -6,13 +6,19 @@
 
 #include "config.h"
 
+#include <fcntl.h>
 #include <string.h>
+#ifdef HAVE_MMAN_H
+#include <sys/mman.h>
+#endif
+#include <unistd.h>
 #include <xmlb.h>
 #include <fwupd.h>
 #include <fwupdplugin.h>
 #include <libgcab.h>
 #include <glib/gstdio.h>
 
+#include "fu-checksum-converter.h"
 #include "fu-device-private.h"
 #include "fu-plugin-private.h"
 #include "fu-security-attrs-private.h"
@@ -119,6 +125,126 @@ fu_archive_cab_func (void)
 	g_assert_null (data_tmp);
 }
 
+static gboolean
+fu_archive_lazy_iterate_cb (FuArchive *self,
+			    const gchar *filename,
+			    GBytes *bytes,
+			    gpointer user_data,
+			    GError **error)
+{
+	guint *cnt = (guint *) user_data;
+	g_assert_nonnull (bytes);
+	(*cnt)++;
+	return TRUE;
+}
+
+static void
+fu_archive_lazy_func (void)
+{
+	gboolean ret;
+	guint cnt = 0;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuArchive) archive = NULL;
+	g_autoptr(GBytes) data = NULL;
+	g_autoptr(GError) error = NULL;
+	GBytes *data_tmp;
+
+#ifndef HAVE_LIBARCHIVE
+	g_test_skip ("no libarchive support");
+	return;
+#endif
+
+	filename = g_build_filename (TESTDATADIR_DST, "colorhug", "colorhug-als-3.0.2.cab", NULL);
+	data = fu_common_get_contents_bytes (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data);
+
+	archive = fu_archive_new (data, FU_ARCHIVE_FLAG_LAZY, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (archive);
+
+	/* decompressed on first use, and then cached */
+	data_tmp = fu_archive_lookup_by_fn (archive, "firmware.bin", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_tmp);
+	checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA1, data_tmp);
+	g_assert_cmpstr (checksum, ==, "7c0ae84b191822bcadbdcbe2f74a011695d783c7");
+	g_assert_true (fu_archive_lookup_by_fn (archive, "firmware.bin", &error) == data_tmp);
+	g_assert_no_error (error);
+
+	data_tmp = fu_archive_lookup_by_fn (archive, "NOTGOINGTOEXIST.xml", &error);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null (data_tmp);
+	g_clear_error (&error);
+
+	ret = fu_archive_iterate (archive, fu_archive_lazy_iterate_cb, &cnt, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (cnt, >=, 2);
+}
+
+#if defined(HAVE_MEMFD_CREATE) && defined(F_ADD_SEALS)
+static void
+fu_common_contents_fd_func (void)
+{
+	const gchar *buf = "hello world";
+	gint fd;
+	g_autoptr(GBytes) data_fd = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* sealed memfd is mapped rather than copied */
+	fd = memfd_create ("fwupd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	g_assert_cmpint (fd, >=, 0);
+	g_assert_cmpint (write (fd, buf, strlen (buf)), ==, strlen (buf));
+	g_assert_cmpint (fcntl (fd, F_ADD_SEALS,
+				F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE), ==, 0);
+	data_fd = fu_common_get_contents_fd (dup (fd), 1024, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_fd);
+	g_assert_cmpint (g_bytes_get_size (data_fd), ==, strlen (buf));
+	g_assert_cmpint (memcmp (g_bytes_get_data (data_fd, NULL), buf, strlen (buf)), ==, 0);
+
+	/* larger than the limit */
+	g_clear_pointer (&data_fd, g_bytes_unref);
+	data_fd = fu_common_get_contents_fd (fd, 4, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_null (data_fd);
+}
+#endif
+
+static void
+fu_common_contents_mapped_func (void)
+{
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GBytes) data = NULL;
+	g_autoptr(GBytes) data_mapped = NULL;
+	g_autoptr(GBytes) data_slice = NULL;
+	g_autoptr(GError) error = NULL;
+
+	filename = g_build_filename (TESTDATADIR_SRC, "metadata.xml", NULL);
+	data = fu_common_get_contents_bytes (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data);
+	data_mapped = fu_common_get_contents_mapped (filename, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_mapped);
+	g_assert_true (g_bytes_equal (data, data_mapped));
+
+	/* slices refer to the mapped data */
+	data_slice = fu_common_bytes_new_offset (data_mapped, 1, 4, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (data_slice);
+	g_assert_true (g_bytes_get_data (data_slice, NULL) ==
+		       (const guint8 *) g_bytes_get_data (data_mapped, NULL) + 1);
+
+	/* does not exist */
+	g_clear_pointer (&data_mapped, g_bytes_unref);
+	data_mapped = fu_common_get_contents_mapped ("/does/not/exist", &error);
+	g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+	g_assert_null (data_mapped);
+}
+
 static void
 fu_common_byte_array_func (void)
 {
@@ -140,10 +266,55 @@ fu_common_byte_array_func (void)
 static void
 fu_common_crc_func (void)
 {
+	guint32 crc;
 	guint8 buf[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
 	g_assert_cmpint (fu_common_crc8 (buf, sizeof(buf)), ==, 0x7A);
 	g_assert_cmpint (fu_common_crc16 (buf, sizeof(buf)), ==, 0x4DF1);
 	g_assert_cmpint (fu_common_crc32 (buf, sizeof(buf)), ==, 0x40EFAB9E);
+
+	/* incremental */
+	crc = fu_common_crc32_full (buf, 4, 0xFFFFFFFF, 0xEDB88320);
+	crc = fu_common_crc32_full (buf + 4, sizeof(buf) - 4, ~crc, 0xEDB88320);
+	g_assert_cmpint (crc, ==, 0x40EFAB9E);
+}
+
+static guint32
+fu_common_crc32_bitwise (const guint8 *buf, gsize bufsz)
+{
+	guint32 crc = 0xFFFFFFFF;
+	for (gsize i = 0; i < bufsz; i++) {
+		crc ^= buf[i];
+		for (guint bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+static void
+fu_common_crc_performance_func (void)
+{
+	gdouble elapsed_bitwise;
+	gdouble elapsed_table;
+	guint32 crc_bitwise = 0;
+	guint32 crc_table = 0;
+	g_autofree guint8 *buf = g_malloc (0x100000 + 3);
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	for (guint i = 0; i < 0x100000 + 3; i++)
+		buf[i] = (guint8) g_random_int ();
+
+	/* check we get the same result as the simple version */
+	g_timer_reset (timer);
+	for (guint i = 0; i < 10; i++)
+		crc_bitwise = fu_common_crc32_bitwise (buf, 0x100000 + 3);
+	elapsed_bitwise = g_timer_elapsed (timer, NULL);
+	g_timer_reset (timer);
+	for (guint i = 0; i < 10; i++)
+		crc_table = fu_common_crc32 (buf, 0x100000 + 3);
+	elapsed_table = g_timer_elapsed (timer, NULL);
+	g_assert_cmpint (crc_table, ==, crc_bitwise);
+	g_print ("bitwise=%.1fMB/s table=%.1fMB/s ",
+		 10.f / elapsed_bitwise, 10.f / elapsed_table);
 }
 
 static void
@@ -214,6 +385,49 @@ fu_device_open_refcount_func (void)
 	g_assert_false (ret);
 }
 
+static void
+fu_device_firmware_cache_func (void)
+{
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(FuFirmware) firmware1 = NULL;
+	g_autoptr(FuFirmware) firmware2 = NULL;
+	g_autoptr(FuFirmware) firmware3 = NULL;
+	g_autoptr(FuFirmware) firmware4 = NULL;
+	g_autoptr(GBytes) fw1 = g_bytes_new_static ("hello", 5);
+	g_autoptr(GBytes) fw2 = g_bytes_new_static ("world", 5);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) firmware_cache = NULL;
+
+	/* shared between both devices */
+	firmware_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						g_free, (GDestroyNotify) g_object_unref);
+	fu_device_set_firmware_cache (device1, firmware_cache);
+	fu_device_set_firmware_cache (device2, firmware_cache);
+	firmware1 = fu_device_parse_firmware_cached (device1, FU_TYPE_FIRMWARE, fw1,
+						     FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware1);
+	firmware2 = fu_device_parse_firmware_cached (device2, FU_TYPE_FIRMWARE, fw1,
+						     FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (firmware1 == firmware2);
+
+	/* different payload */
+	firmware3 = fu_device_parse_firmware_cached (device2, FU_TYPE_FIRMWARE, fw2,
+						     FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (firmware1 != firmware3);
+	g_assert_cmpint (g_hash_table_size (firmware_cache), ==, 2);
+
+	/* no cache */
+	fu_device_set_firmware_cache (device1, NULL);
+	firmware4 = fu_device_parse_firmware_cached (device1, FU_TYPE_FIRMWARE, fw1,
+						     FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (firmware1 != firmware4);
+}
+
 static void
 fu_device_metadata_func (void)
 {
@@ -253,6 +467,8 @@ fu_smbios_func (void)
 	g_autofree gchar *dump = NULL;
 	g_autoptr(FuSmbios) smbios = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) array = NULL;
+	g_autoptr(GPtrArray) array_missing = NULL;
 
 	smbios = fu_smbios_new ();
 	ret = fu_smbios_setup (smbios, &error);
@@ -278,6 +494,15 @@ fu_smbios_func (void)
 	str = fu_smbios_get_string (smbios, FU_SMBIOS_STRUCTURE_TYPE_BIOS, 0x04, &error);
 	g_assert_no_error (error);
 	g_assert_cmpstr (str, ==, "LENOVO");
+
+	/* get all structures of one type */
+	array = fu_smbios_get_data_array (smbios, FU_SMBIOS_STRUCTURE_TYPE_BIOS, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (array);
+	g_assert_cmpint (array->len, ==, 1);
+	array_missing = fu_smbios_get_data_array (smbios, 0xff, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_null (array_missing);
 }
 
 static void
@@ -350,6 +575,114 @@ fu_common_strsafe_func (void)
 	}
 }
 
+static void
+fu_common_bytes_find_runs_func (void)
+{
+	guint8 buf[0x50];
+	FuChunk *chk;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GPtrArray) runs = NULL;
+	g_autoptr(GPtrArray) runs_erased = NULL;
+	g_autoptr(GPtrArray) runs_all = NULL;
+
+	/* erased, data, data, erased, partial trailing page with data */
+	memset (buf, 0xff, sizeof(buf));
+	buf[0x13] = 0x00;
+	buf[0x2f] = 0x12;
+	buf[0x4f] = 0x34;
+	blob = g_bytes_new_static (buf, sizeof(buf));
+	g_assert_false (fu_common_bytes_is_empty (blob));
+
+	runs = fu_common_bytes_find_runs (blob, 0x10, 0xff, FALSE);
+	g_assert_cmpint (runs->len, ==, 2);
+	chk = g_ptr_array_index (runs, 0);
+	g_assert_cmpint (fu_chunk_get_address (chk), ==, 0x10);
+	g_assert_cmpint (fu_chunk_get_page (chk), ==, 0x1);
+	g_assert_cmpint (fu_chunk_get_data_sz (chk), ==, 0x20);
+	g_assert_true (fu_chunk_get_data (chk) == buf + 0x10);
+	chk = g_ptr_array_index (runs, 1);
+	g_assert_cmpint (fu_chunk_get_idx (chk), ==, 1);
+	g_assert_cmpint (fu_chunk_get_address (chk), ==, 0x40);
+	g_assert_cmpint (fu_chunk_get_data_sz (chk), ==, 0x10);
+
+	runs_erased = fu_common_bytes_find_runs (blob, 0x10, 0xff, TRUE);
+	g_assert_cmpint (runs_erased->len, ==, 2);
+	chk = g_ptr_array_index (runs_erased, 0);
+	g_assert_cmpint (fu_chunk_get_address (chk), ==, 0x0);
+	g_assert_cmpint (fu_chunk_get_data_sz (chk), ==, 0x10);
+	chk = g_ptr_array_index (runs_erased, 1);
+	g_assert_cmpint (fu_chunk_get_address (chk), ==, 0x30);
+	g_assert_cmpint (fu_chunk_get_data_sz (chk), ==, 0x10);
+
+	/* one page */
+	runs_all = fu_common_bytes_find_runs (blob, 0x0, 0xff, FALSE);
+	g_assert_cmpint (runs_all->len, ==, 1);
+	chk = g_ptr_array_index (runs_all, 0);
+	g_assert_cmpint (fu_chunk_get_data_sz (chk), ==, sizeof(buf));
+}
+
+static void
+fu_common_guid_hash_cached_func (void)
+{
+	const gchar *guid1 = fu_common_guid_hash_string_cached ("python.org");
+	const gchar *guid2 = fu_common_guid_hash_string_cached ("python.org");
+	g_assert_cmpstr (guid1, ==, "886313e1-3b8a-5372-9b90-0c9aee199e5d");
+	g_assert_true (guid1 == guid2);
+	g_assert_null (fu_common_guid_hash_string_cached (""));
+
+	/* evicted entries are hashed again to the same string */
+	for (guint i = 0; i < 5000; i++) {
+		g_autofree gchar *str = g_strdup_printf ("USB\\VID_273F&PID_%04X", i);
+		g_assert_nonnull (fu_common_guid_hash_string_cached (str));
+	}
+	guid2 = fu_common_guid_hash_string_cached ("python.org");
+	g_assert_true (guid1 == guid2);
+}
+
+static void
+fu_common_jcat_cached_func (void)
+{
+	g_autofree gchar *csum = NULL;
+	g_autoptr(GBytes) blob = g_bytes_new_static ("hello", 5);
+	g_autoptr(GBytes) blob_csum = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results1 = NULL;
+	g_autoptr(GPtrArray) results2 = NULL;
+	g_autoptr(GPtrArray) results3 = NULL;
+	g_autoptr(JcatBlob) jcat_blob = NULL;
+	g_autoptr(JcatContext) jcat_context = jcat_context_new ();
+	g_autoptr(JcatItem) jcat_item = jcat_item_new ("hello.bin");
+
+	csum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	blob_csum = g_bytes_new (csum, strlen (csum));
+	jcat_blob = jcat_blob_new (JCAT_BLOB_KIND_SHA256, blob_csum);
+	jcat_item_add_blob (jcat_item, jcat_blob);
+
+	/* the second verification is the same result */
+	results1 = fu_common_jcat_verify_item_cached (jcat_context, blob, jcat_item,
+						      JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM,
+						      &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (results1);
+	g_assert_cmpint (results1->len, ==, 1);
+	results2 = fu_common_jcat_verify_item_cached (jcat_context, blob, jcat_item,
+						      JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM,
+						      &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (results2);
+	g_assert_cmpint (results2->len, ==, 1);
+	g_assert_true (g_ptr_array_index (results1, 0) == g_ptr_array_index (results2, 0));
+
+	/* verified again */
+	fu_common_jcat_invalidate_cache (jcat_context);
+	results3 = fu_common_jcat_verify_item_cached (jcat_context, blob, jcat_item,
+						      JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM,
+						      &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (results3);
+	g_assert_true (g_ptr_array_index (results1, 0) != g_ptr_array_index (results3, 0));
+}
+
 static void
 fu_common_uri_scheme_func (void)
 {
@@ -493,11 +826,61 @@ fu_plugin_delay_func (void)
 	g_clear_object (&device_tmp);
 }
 
+static void
+fu_plugin_builtin_test_init (FuPlugin *plugin)
+{
+	fu_plugin_set_build_hash (plugin, "builtin");
+}
+
+static gboolean
+fu_plugin_builtin_test_startup (FuPlugin *plugin, GError **error)
+{
+	g_set_error_literal (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no hardware");
+	return FALSE;
+}
+
+static void
+fu_plugin_builtin_func (void)
+{
+	gboolean ret;
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GError) error = NULL;
+	const FuPluginSymbol symbols[] = {
+		{ "fu_plugin_init", (gpointer) fu_plugin_builtin_test_init },
+		{ "fu_plugin_startup", (gpointer) fu_plugin_builtin_test_startup },
+		{ "fu_plugin_coldplug", NULL },
+		{ NULL, NULL }
+	};
+
+	/* needs a name as there is no filename to guess from */
+	g_assert_false (fu_plugin_is_open (plugin));
+	ret = fu_plugin_open_builtin (plugin, symbols, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* init is called when opened, and unimplemented vfuncs are skipped */
+	fu_plugin_set_name (plugin, "builtin");
+	ret = fu_plugin_open_builtin (plugin, symbols, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_true (fu_plugin_is_open (plugin));
+	g_assert_cmpstr (fu_plugin_get_build_hash (plugin), ==, "builtin");
+	ret = fu_plugin_runner_coldplug (plugin, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_plugin_runner_startup (plugin, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert_false (ret);
+}
+
 static void
 fu_plugin_quirks_func (void)
 {
 	const gchar *tmp;
 	gboolean ret;
+	guint hits = 0;
+	guint misses = 0;
 	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
 	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
 	g_autoptr(GError) error = NULL;
@@ -522,6 +905,44 @@ fu_plugin_quirks_func (void)
 	g_assert_cmpstr (tmp, ==, NULL);
 	tmp = fu_plugin_lookup_quirk_by_id (plugin, "bb9ec3e2-77b3-53bc-a1f1-b05916715627", "Flags");
 	g_assert_cmpstr (tmp, ==, "clever");
+
+	/* check the index was used */
+	fu_quirks_get_lookup_stats (quirks, &hits, &misses);
+	g_assert_cmpint (hits, ==, 4);
+	g_assert_cmpint (misses, ==, 3);
+}
+
+static void
+fu_plugin_quirks_prebuilt_func (void)
+{
+	const gchar *tmp;
+	gboolean ret;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(FuQuirks) quirks_prebuilt = fu_quirks_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	/* compile the test quirks */
+	fn = g_build_filename ("/tmp/fwupd-self-test/quirks-prebuilt", "quirks.xmlb", NULL);
+	ret = fu_common_mkdir_parent (fn, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	file = g_file_new_for_path (fn);
+	ret = fu_quirks_compile_to_file (quirks, TESTDATADIR_SRC, file, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* use it without any quirks.d */
+	g_setenv ("FWUPD_DATADIR", "/tmp/fwupd-self-test/quirks-prebuilt", TRUE);
+	ret = fu_quirks_load (quirks_prebuilt, FU_QUIRKS_LOAD_FLAG_NONE, &error);
+	g_setenv ("FWUPD_DATADIR", TESTDATADIR_SRC, TRUE);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	tmp = fu_quirks_lookup_by_id (quirks_prebuilt, "USB\\VID_0A5C&PID_6412", "Flags");
+	g_assert_cmpstr (tmp, ==, "ignore-runtime");
+	tmp = fu_quirks_lookup_by_id (quirks_prebuilt, "baz", "Unfound");
+	g_assert_cmpstr (tmp, ==, NULL);
 }
 
 static void
@@ -579,6 +1000,26 @@ fu_plugin_quirks_device_func (void)
 	g_assert (fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_UPDATABLE));
 }
 
+static void
+fu_common_cpuid_func (void)
+{
+	guint32 ebx1 = 0, ecx1 = 0, edx1 = 0;
+	guint32 ebx2 = 0, ecx2 = 0, edx2 = 0;
+	g_autoptr(GError) error = NULL;
+
+	if (!fu_common_cpuid (0x0, NULL, &ebx1, &ecx1, &edx1, &error)) {
+		g_test_skip (error->message);
+		return;
+	}
+
+	/* cached values must match */
+	g_assert_true (fu_common_cpuid (0x0, NULL, &ebx2, &ecx2, &edx2, NULL));
+	g_assert_cmpint (ebx1, ==, ebx2);
+	g_assert_cmpint (ecx1, ==, ecx2);
+	g_assert_cmpint (edx1, ==, edx2);
+	g_assert_cmpint (fu_common_get_cpu_vendor (), ==, fu_common_get_cpu_vendor ());
+}
+
 static void fu_common_kernel_lockdown_func (void)
 {
 	gboolean ret;
@@ -609,6 +1050,7 @@ fu_common_firmware_builder_func (void)
 	g_autofree gchar *archive_fn = NULL;
 	g_autoptr(GBytes) archive_blob = NULL;
 	g_autoptr(GBytes) firmware_blob = NULL;
+	g_autoptr(GBytes) firmware_blob2 = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* get test file */
@@ -637,6 +1079,15 @@ fu_common_firmware_builder_func (void)
 	/* check it */
 	data = g_bytes_get_data (firmware_blob, NULL);
 	g_assert_cmpstr (data, ==, "xobdnas eht ni gninnur");
+
+	/* the same archive is not built again */
+	firmware_blob2 = fu_common_firmware_builder (archive_blob,
+						     "startup.sh",
+						     "firmware.bin",
+						     &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (firmware_blob2);
+	g_assert_true (g_bytes_equal (firmware_blob, firmware_blob2));
 }
 
 static void
@@ -748,6 +1199,51 @@ fu_common_spawn_timeout_func (void)
 	g_assert_cmpint (lines, ==, 1);
 }
 
+typedef struct {
+	GMainLoop	*loop;
+	guint		 pending;
+	guint		 failed;
+} FuCommonSpawnAsyncHelper;
+
+static void
+fu_common_spawn_async_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuCommonSpawnAsyncHelper *helper = (FuCommonSpawnAsyncHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+	if (!fu_common_spawn_finish (res, &error)) {
+		g_debug ("failed: %s", error->message);
+		helper->failed++;
+	}
+	if (--helper->pending == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_common_spawn_async_func (void)
+{
+	guint lines = 0;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+	FuCommonSpawnAsyncHelper helper = { loop, 2, 0 };
+	const gchar *argv[3] = { "replace", "test", NULL };
+
+#ifdef _WIN32
+	g_test_skip ("Known failures on Windows right now, skipping spawn async test");
+	return;
+#endif
+
+	/* both children run at the same time */
+	fn = g_build_filename (TESTDATADIR_SRC, "spawn.sh", NULL);
+	argv[0] = fn;
+	fu_common_spawn_async (argv, fu_test_stdout_cb, &lines, 0, NULL,
+			       fu_common_spawn_async_done_cb, &helper);
+	fu_common_spawn_async (argv, fu_test_stdout_cb, &lines, 50, NULL,
+			       fu_common_spawn_async_done_cb, &helper);
+	g_main_loop_run (loop);
+	g_assert_cmpint (helper.failed, ==, 1);
+	g_assert_cmpint (lines, ==, 7);
+}
+
 static void
 fu_common_endian_func (void)
 {
@@ -1034,6 +1530,83 @@ fu_common_store_cab_error_wrong_size_func (void)
 	g_assert_null (silo);
 }
 
+static void
+fu_common_store_cab_sha256_func (void)
+{
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	blob = _build_cab (GCAB_COMPRESSION_NONE,
+			   "acme.metainfo.xml",
+	"<component type=\"firmware\">\n"
+	"  <id>com.acme.example.firmware</id>\n"
+	"  <releases>\n"
+	"    <release version=\"1.2.3\">\n"
+	"      <checksum target=\"content\" type=\"sha256\">486ea46224d1bb4fb680f34f7c9ad96a8f24ec88be73ea8e5a6c65260e9cb8a7</checksum>\n"
+	"    </release>\n"
+	"  </releases>\n"
+	"</component>",
+			   "firmware.bin", "world",
+			   NULL);
+	silo = fu_common_cab_build_silo (blob, 10240, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (silo);
+}
+
+static void
+fu_common_store_cab_performance_func (void)
+{
+	const gsize payloadsz = 0x800000;
+	g_autofree gchar *payload1 = g_strnfill (payloadsz, '1');
+	g_autofree gchar *payload2 = g_strnfill (payloadsz, '2');
+	g_autofree gchar *payload3 = g_strnfill (payloadsz, '3');
+	g_autofree gchar *csum1 = NULL;
+	g_autofree gchar *csum2 = NULL;
+	g_autofree gchar *csum3 = NULL;
+	g_autofree gchar *metainfo1 = NULL;
+	g_autofree gchar *metainfo2 = NULL;
+	g_autofree gchar *metainfo3 = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *metainfo_fmt =
+	"<component type=\"firmware\">\n"
+	"  <id>com.acme.example.firmware%u</id>\n"
+	"  <releases>\n"
+	"    <release version=\"1.2.3\">\n"
+	"      <checksum filename=\"firmware%u.bin\" target=\"content\" type=\"sha1\">%s</checksum>\n"
+	"    </release>\n"
+	"  </releases>\n"
+	"</component>";
+
+	/* a capsule, EC and ME payload in one archive */
+	csum1 = g_compute_checksum_for_string (G_CHECKSUM_SHA1, payload1, -1);
+	metainfo1 = g_strdup_printf (metainfo_fmt, 1u, 1u, csum1);
+	csum2 = g_compute_checksum_for_string (G_CHECKSUM_SHA1, payload2, -1);
+	metainfo2 = g_strdup_printf (metainfo_fmt, 2u, 2u, csum2);
+	csum3 = g_compute_checksum_for_string (G_CHECKSUM_SHA1, payload3, -1);
+	metainfo3 = g_strdup_printf (metainfo_fmt, 3u, 3u, csum3);
+	blob = _build_cab (GCAB_COMPRESSION_NONE,
+			   "firmware1.metainfo.xml", metainfo1,
+			   "firmware1.bin", payload1,
+			   "firmware2.metainfo.xml", metainfo2,
+			   "firmware2.bin", payload2,
+			   "firmware3.metainfo.xml", metainfo3,
+			   "firmware3.bin", payload3,
+			   NULL);
+
+	/* parse the archive end to end */
+	g_timer_reset (timer);
+	silo = fu_common_cab_build_silo (blob, payloadsz * 4, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (silo);
+	g_print ("parse=%.1fMB/s ",
+		 (gdouble) g_bytes_get_size (blob) / (1024.f * 1024.f) /
+		 g_timer_elapsed (timer, NULL));
+}
+
 static void
 fu_common_store_cab_error_missing_file_func (void)
 {
@@ -1113,6 +1686,91 @@ fu_device_poll_cb (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+static void
+fu_device_trace_func (void)
+{
+	guint8 buf[0x400] = { 0x0 };
+	g_autoptr(FuDevice) device = fu_device_new ();
+
+	/* nothing recorded */
+	fu_device_dump_trace (device);
+
+	/* only the most recent packets are kept */
+	for (guint i = 0; i < 40; i++) {
+		buf[0] = i;
+		fu_device_add_trace (device, "Packet", buf, sizeof(buf));
+	}
+	g_test_expect_message ("FuDevice", G_LOG_LEVEL_INFO, "last 32 packets for *");
+	g_test_expect_message ("FuDevice", G_LOG_LEVEL_INFO, "*Packet: 08 00*[1024 bytes]");
+	fu_device_dump_trace (device);
+	g_test_assert_expected_messages ();
+
+	/* forgotten once dumped */
+	fu_device_dump_trace (device);
+}
+
+static void
+fu_device_transcript_func (void)
+{
+	gboolean ret;
+	gsize actual_len = 0;
+	guint8 buf[4] = { 0x0 };
+	const guint8 buf_write[] = { 0x01, 0x02, 0x03 };
+	const guint8 buf_read[] = { 0xde, 0xad };
+	g_autofree gchar *fn = NULL;
+	g_autoptr(FuDevice) device1 = NULL;
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(GError) error = NULL;
+
+	/* record */
+	fn = g_build_filename (g_get_tmp_dir (), "fwupd-transcript.txt", NULL);
+	g_setenv ("FWUPD_TRANSCRIPT_DIR", g_get_tmp_dir (), TRUE);
+	device1 = fu_device_new ();
+	g_unsetenv ("FWUPD_TRANSCRIPT_DIR");
+	fu_device_transcript_record (device1, "Write", buf_write, sizeof(buf_write));
+	fu_device_transcript_record (device1, "Read", buf_read, sizeof(buf_read));
+	fu_device_transcript_record (device1, "Read", NULL, 0);
+	ret = fu_device_save_transcript (device1, fn, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* replay without delays */
+	ret = fu_device_load_transcript (device2, fn, 0.f, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_true (fu_device_transcript_is_replay (device2));
+	ret = fu_device_transcript_replay_write (device2, "Write",
+						 buf_write, sizeof(buf_write),
+						 &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_transcript_replay_read (device2, "Read", buf, sizeof(buf),
+						&actual_len, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (actual_len, ==, 2);
+	g_assert_cmpint (buf[1], ==, 0xad);
+
+	/* out of order */
+	ret = fu_device_transcript_replay_write (device2, "Write",
+						 buf_write, sizeof(buf_write),
+						 &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+	g_clear_error (&error);
+
+	/* different data */
+	ret = fu_device_load_transcript (device2, fn, 0.f, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_device_transcript_replay_write (device2, "Write",
+						 buf_read, sizeof(buf_read),
+						 &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+	g_unlink (fn);
+}
+
 static void
 fu_device_poll_func (void)
 {
@@ -1295,6 +1953,73 @@ fu_device_incorporate_func (void)
 	g_assert_cmpint (fu_device_get_icons(device)->len, ==, 1);
 }
 
+static void
+fu_chunk_iter_func (void)
+{
+	FuChunkIter iter;
+	guint cnt = 0;
+	g_autoptr(GBytes) blob = g_bytes_new_static ("0123456789abcdef", 16);
+	g_autoptr(GBytes) blob_chk = NULL;
+
+	/* same as fu_chunk_array_new() */
+	fu_chunk_iter_init_bytes (&iter, blob, 0x0, 10, 4);
+	g_assert_cmpint (fu_chunk_iter_get_length (&iter), ==, 5);
+	while (fu_chunk_iter_next (&iter)) {
+		if (cnt == 2) {
+			g_assert_cmpint (fu_chunk_iter_get_idx (&iter), ==, 2);
+			g_assert_cmpint (fu_chunk_iter_get_page (&iter), ==, 0);
+			g_assert_cmpint (fu_chunk_iter_get_address (&iter), ==, 0x8);
+			g_assert_cmpint (fu_chunk_iter_get_offset (&iter), ==, 0x8);
+			g_assert_cmpint (fu_chunk_iter_get_data_sz (&iter), ==, 2);
+			g_assert_cmpint (memcmp (fu_chunk_iter_get_data (&iter), "89", 2), ==, 0);
+			blob_chk = fu_chunk_iter_get_bytes (&iter);
+			g_assert_cmpint (g_bytes_get_size (blob_chk), ==, 2);
+		}
+		cnt++;
+	}
+	g_assert_cmpint (cnt, ==, 5);
+
+	/* the first byte is on the previous page */
+	fu_chunk_iter_init (&iter, NULL, 6, 0x3, 4, 0);
+	g_assert_true (fu_chunk_iter_next (&iter));
+	g_assert_cmpint (fu_chunk_iter_get_page (&iter), ==, 0);
+	g_assert_cmpint (fu_chunk_iter_get_address (&iter), ==, 0x3);
+	g_assert_cmpint (fu_chunk_iter_get_data_sz (&iter), ==, 1);
+	g_assert_null (fu_chunk_iter_get_data (&iter));
+	g_assert_true (fu_chunk_iter_next (&iter));
+	g_assert_cmpint (fu_chunk_iter_get_page (&iter), ==, 1);
+	g_assert_cmpint (fu_chunk_iter_get_address (&iter), ==, 0x0);
+	g_assert_cmpint (fu_chunk_iter_get_data_sz (&iter), ==, 4);
+	g_assert_true (fu_chunk_iter_next (&iter));
+	g_assert_cmpint (fu_chunk_iter_get_page (&iter), ==, 2);
+	g_assert_cmpint (fu_chunk_iter_get_data_sz (&iter), ==, 1);
+	g_assert_false (fu_chunk_iter_next (&iter));
+}
+
+static void
+fu_checksum_converter_func (void)
+{
+	gboolean ret;
+	gsize bufsz = 0;
+	guint8 buf[0x100] = { 0x0 };
+	g_autoptr(FuChecksumConverter) converter = fu_checksum_converter_new (G_CHECKSUM_SHA256);
+	g_autoptr(GBytes) blob = g_bytes_new_static ("hello world", 11);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream_mem = g_memory_input_stream_new_from_bytes (blob);
+	g_autoptr(GInputStream) stream = NULL;
+
+	/* data is passed through unchanged */
+	stream = g_converter_input_stream_new (stream_mem, G_CONVERTER (converter));
+	ret = g_input_stream_read_all (stream, buf, sizeof(buf), &bufsz, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (bufsz, ==, 11);
+	g_assert_cmpint (memcmp (buf, "hello world", 11), ==, 0);
+	g_assert_cmpint (fu_checksum_converter_get_size (converter), ==, 11);
+	g_assert_cmpstr (fu_checksum_converter_get_string (converter), ==,
+			 "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9");
+}
+
 static void
 fu_chunk_func (void)
 {
@@ -1577,6 +2302,92 @@ fu_common_version_func (void)
 	}
 }
 
+static gboolean
+fu_io_channel_read_done_cb (GByteArray *buf, gpointer user_data)
+{
+	const gchar *terminator = (const gchar *) user_data;
+	gsize terminatorsz = strlen (terminator);
+	if (buf->len < terminatorsz)
+		return FALSE;
+	return memcmp (buf->data + buf->len - terminatorsz, terminator, terminatorsz) == 0;
+}
+
+static void
+fu_io_channel_read_func (void)
+{
+#ifndef _WIN32
+	gint fds[2] = { -1, -1 };
+	const gchar *res = "\r\n+FOO: 1\r\n\r\nOK\r\n";
+	g_autoptr(FuIOChannel) io_channel = NULL;
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	g_assert_cmpint (pipe (fds), ==, 0);
+	io_channel = fu_io_channel_unix_new (fds[0]);
+	g_assert_cmpint (write (fds[1], res, strlen (res)), ==, strlen (res));
+
+	/* returns as soon as the terminator is seen, not after the timeout */
+	buf = fu_io_channel_read_byte_array_full (io_channel, -1, 5000,
+						  FU_IO_CHANNEL_FLAG_NONE,
+						  fu_io_channel_read_done_cb,
+						  (gpointer) "\r\nOK\r\n",
+						  &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (buf);
+	g_assert_cmpint (buf->len, ==, strlen (res));
+	g_assert_cmpfloat (g_timer_elapsed (timer, NULL), <, 1.f);
+	close (fds[1]);
+#else
+	g_test_skip ("pipes not supported on Windows");
+#endif
+}
+
+static void
+fu_common_acpi_table_func (void)
+{
+	gboolean ret;
+	guint8 buf[0x30] = { 'T', 'E', 'S', 'T', 0x30, 0x0, 0x0, 0x0 };
+	guint8 checksum = 0;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* table is padded, and sums to zero */
+	for (guint i = 0; i < 0x30; i++)
+		checksum += buf[i];
+	buf[0x9] = 0x100 - checksum;
+	g_setenv ("FWUPD_ACPITABLESDIR", "/tmp/fwupd-self-test/acpi", TRUE);
+	ret = fu_common_mkdir_parent ("/tmp/fwupd-self-test/acpi/TEST", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/acpi/TEST",
+				   (const gchar *) buf, sizeof(buf), &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	blob1 = fu_common_get_acpi_table ("TEST", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob1);
+	g_assert_cmpint (g_bytes_get_size (blob1), ==, 0x30);
+
+	/* shared */
+	blob2 = fu_common_get_acpi_table ("TEST", &error);
+	g_assert_no_error (error);
+	g_assert_true (g_bytes_get_data (blob1, NULL) == g_bytes_get_data (blob2, NULL));
+
+	/* invalid checksum */
+	buf[0x9] ^= 0xff;
+	ret = g_file_set_contents ("/tmp/fwupd-self-test/acpi/BAD0",
+				   (const gchar *) buf, sizeof(buf), &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	blob3 = fu_common_get_acpi_table ("BAD0", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_null (blob3);
+	g_unsetenv ("FWUPD_ACPITABLESDIR");
+}
+
 static void
 fu_common_vercmp_func (void)
 {
@@ -1626,6 +2437,48 @@ fu_common_vercmp_func (void)
 	g_assert_cmpint (fu_common_vercmp_full (NULL, NULL, FWUPD_VERSION_FORMAT_UNKNOWN), ==, G_MAXINT);
 }
 
+static gint
+fu_common_version_key_cmp_helper (const gchar *version_a,
+				  const gchar *version_b,
+				  FwupdVersionFormat fmt)
+{
+	FuVersionKey key_a;
+	FuVersionKey key_b;
+	fu_common_version_key_init (&key_a, version_a, fmt);
+	fu_common_version_key_init (&key_b, version_b, fmt);
+	return fu_common_version_key_cmp (&key_a, &key_b);
+}
+
+static void
+fu_common_version_key_func (void)
+{
+	const gchar *versions[] = {
+		"1.2.3", "001.002.003", "1.2.4", "1.2.2", "1.2.3.1", "1.2.3a",
+		"1.2.3b", "alpha", "beta", "1.2a.3", "1.2b.3", "1.2.3~rc1",
+		"1.2.3~rc2", "1..2", "1.2.", ".1", "1.2.3.4.5.6.7.8.9.10", "",
+		"0x00000002", "0x2", "0x10", "16", "20200101", NULL };
+	const FwupdVersionFormat fmts[] = {
+		FWUPD_VERSION_FORMAT_UNKNOWN,
+		FWUPD_VERSION_FORMAT_PLAIN,
+		FWUPD_VERSION_FORMAT_HEX,
+		FWUPD_VERSION_FORMAT_TRIPLET };
+
+	/* same result as the string comparison, including with a long version */
+	for (guint k = 0; k < G_N_ELEMENTS (fmts); k++) {
+		for (guint i = 0; versions[i] != NULL; i++) {
+			for (guint j = 0; versions[j] != NULL; j++) {
+				gint rc1 = fu_common_vercmp_full (versions[i], versions[j], fmts[k]);
+				gint rc2 = fu_common_version_key_cmp_helper (versions[i], versions[j], fmts[k]);
+				g_assert_cmpint (rc1, ==, rc2);
+			}
+		}
+	}
+
+	/* invalid */
+	g_assert_cmpint (fu_common_version_key_cmp_helper ("1", NULL, FWUPD_VERSION_FORMAT_UNKNOWN), ==, G_MAXINT);
+	g_assert_cmpint (fu_common_version_key_cmp_helper (NULL, NULL, FWUPD_VERSION_FORMAT_UNKNOWN), ==, G_MAXINT);
+}
+
 static void
 fu_firmware_ihex_func (void)
 {
@@ -1833,6 +2686,34 @@ fu_firmware_srec_tokenization_func (void)
 	g_assert_cmpint (rcd->buf->data[0], ==, 0x50);
 }
 
+static void
+fu_firmware_strparse_hex_func (void)
+{
+	gboolean ret;
+	guint8 buf[4] = { 0x0 };
+	g_autoptr(GError) error = NULL;
+
+	/* mixed case */
+	ret = fu_firmware_strparse_hex_safe (":DeadBeef", 9, 1, buf, sizeof(buf), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (buf[0], ==, 0xde);
+	g_assert_cmpint (buf[1], ==, 0xad);
+	g_assert_cmpint (buf[2], ==, 0xbe);
+	g_assert_cmpint (buf[3], ==, 0xef);
+
+	/* too short */
+	ret = fu_firmware_strparse_hex_safe (":DeadBee", 8, 1, buf, sizeof(buf), &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* not hex */
+	ret = fu_firmware_strparse_hex_safe (":DeadBeeg", 9, 1, buf, sizeof(buf), &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert (!ret);
+}
+
 static void
 fu_firmware_build_func (void)
 {
@@ -1932,9 +2813,12 @@ fu_firmware_dfuse_func (void)
 	gboolean ret;
 	g_autofree gchar *filename = NULL;
 	g_autoptr(FuFirmware) firmware = fu_dfuse_firmware_new ();
+	g_autofree gchar *filename_tmp = NULL;
 	g_autoptr(GBytes) roundtrip_orig = NULL;
 	g_autoptr(GBytes) roundtrip = NULL;
+	g_autoptr(GBytes) roundtrip_file = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
 
 	/* load a DfuSe firmware */
 	filename = g_build_filename (TESTDATADIR_SRC, "firmware.dfuse", NULL);
@@ -1955,6 +2839,22 @@ fu_firmware_dfuse_func (void)
 	ret = fu_common_bytes_compare (roundtrip, roundtrip_orig, &error);
 	g_assert_no_error (error);
 	g_assert_true (ret);
+
+	/* streamed directly to a file */
+	filename_tmp = g_build_filename ("/tmp/fwupd-self-test", "firmware.dfuse", NULL);
+	ret = fu_common_mkdir_parent (filename_tmp, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	file = g_file_new_for_path (filename_tmp);
+	ret = fu_firmware_write_file (firmware, file, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	roundtrip_file = fu_common_get_contents_bytes (filename_tmp, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (roundtrip_file);
+	ret = fu_common_bytes_compare (roundtrip_file, roundtrip_orig, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
 }
 
 static void
@@ -2002,6 +2902,74 @@ fu_firmware_fmap_func (void)
 	g_assert_true (ret);
 }
 
+static void
+fu_firmware_defer_images_func (void)
+{
+	gboolean ret;
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuFirmware) firmware = fu_firmware_new ();
+	g_autoptr(FuFirmwareImage) img = fu_firmware_image_new (NULL);
+	g_autoptr(GBytes) blob = g_bytes_new_static ("deadbeef", 8);
+	g_autoptr(GBytes) blob_tmp = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* only recorded */
+	fu_firmware_add_flag (firmware, FU_FIRMWARE_FLAG_DEFER_IMAGES);
+	ret = fu_firmware_parse_image (firmware, img, blob, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	str = fu_firmware_image_to_string (img);
+	g_assert_nonnull (g_strstr_len (str, -1, "DataDeferred"));
+
+	/* parsed on first use */
+	blob_tmp = fu_firmware_image_get_bytes (img);
+	g_assert_nonnull (blob_tmp);
+	g_assert_cmpint (g_bytes_get_size (blob_tmp), ==, 8);
+	ret = fu_firmware_image_ensure_parsed (img, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+}
+
+static void
+fu_efi_signature_list_checksum_func (void)
+{
+	gboolean ret;
+	const gchar *csum = "0101010101010101010101010101010101010101010101010101010101010101";
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) imgs = NULL;
+	const guint8 sig_type[] = { 0x26, 0x16, 0xc4, 0xc1, 0x4c, 0x50, 0x92, 0x40,
+				    0xac, 0xa9, 0x41, 0xf9, 0x36, 0x93, 0x43, 0x28 };
+
+	/* one EFI_CERT_SHA256 in an EFI_SIGNATURE_LIST */
+	g_byte_array_append (buf, sig_type, sizeof(sig_type));
+	fu_byte_array_append_uint32 (buf, 0x1c + 16 + 32, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, 0, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32 (buf, 16 + 32, G_LITTLE_ENDIAN);
+	for (guint i = 0; i < 16; i++)
+		fu_byte_array_append_uint8 (buf, 0x0);
+	for (guint i = 0; i < 32; i++)
+		fu_byte_array_append_uint8 (buf, 0x1);
+	blob = g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+
+	for (guint j = 0; j < 2; j++) {
+		g_autoptr(FuFirmware) siglist = fu_efi_signature_list_new ();
+		fu_efi_signature_list_set_checksums_only (FU_EFI_SIGNATURE_LIST (siglist), j == 1);
+		ret = fu_firmware_parse (siglist, blob, FWUPD_INSTALL_FLAG_NO_SEARCH, &error);
+		g_assert_no_error (error);
+		g_assert_true (ret);
+		g_assert_cmpstr (fu_firmware_get_version (siglist), ==, "1");
+		g_assert_true (fu_efi_signature_list_has_checksum (FU_EFI_SIGNATURE_LIST (siglist), csum));
+		g_assert_false (fu_efi_signature_list_has_checksum (FU_EFI_SIGNATURE_LIST (siglist), "deadbeef"));
+
+		/* no images are created when only doing lookups */
+		imgs = fu_firmware_get_images (siglist);
+		g_assert_cmpint (imgs->len, ==, j == 1 ? 0 : 1);
+		g_clear_pointer (&imgs, g_ptr_array_unref);
+	}
+}
+
 static void
 fu_firmware_new_from_gtypes_func (void)
 {
@@ -2270,6 +3238,57 @@ fu_efivar_func (void)
 	g_assert_false (ret);
 }
 
+static void
+fu_efivar_cache_func (void)
+{
+	gboolean ret;
+	guint read_count;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+	ret = fu_efivar_set_cache_enabled (TRUE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	ret = fu_efivar_set_data (FU_EFIVAR_GUID_EFI_GLOBAL, "Test",
+				  (guint8 *) "1", 1, 0, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* only the first read touches efivarfs */
+	blob1 = fu_efivar_get_data_bytes (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob1);
+	read_count = fu_efivar_get_read_count ();
+	blob2 = fu_efivar_get_data_bytes (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob2);
+	g_assert_true (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "Test"));
+	g_assert_false (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "NotGoingToExist"));
+	g_assert_cmpint (fu_efivar_get_read_count (), ==, read_count);
+
+	/* writing invalidates the snapshot */
+	ret = fu_efivar_set_data (FU_EFIVAR_GUID_EFI_GLOBAL, "Test",
+				  (guint8 *) "2", 1, 0, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	blob3 = fu_efivar_get_data_bytes (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", NULL, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (blob3);
+	g_assert_cmpint (((const guint8 *) g_bytes_get_data (blob3, NULL))[0], ==, '2');
+	g_assert_cmpint (fu_efivar_get_read_count (), >, read_count);
+
+	/* deleting too */
+	ret = fu_efivar_delete (FU_EFIVAR_GUID_EFI_GLOBAL, "Test", &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_false (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "Test"));
+	ret = fu_efivar_set_cache_enabled (FALSE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+}
+
 typedef struct {
 	guint cnt_success;
 	guint cnt_failed;
@@ -2358,6 +3377,43 @@ fu_device_retry_hardware_func (void)
 	g_assert_cmpint (helper.cnt_failed, ==, 2);
 }
 
+static void
+fu_device_retry_backoff_func (void)
+{
+	gboolean ret;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	FuDeviceRetryHelper helper = {
+		.cnt_success = 0,
+		.cnt_failed = 0,
+	};
+
+	/* the first retries are much quicker than the maximum delay */
+	fu_device_add_internal_flag (device, FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF);
+	ret = fu_device_retry_full (device, fu_device_retry_success_3rd_try, 3, 800,
+				    &helper, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+	g_assert_cmpint (helper.cnt_failed, ==, 2);
+	g_assert_cmpint (fu_device_get_retry_count (device), ==, 2);
+	g_assert_cmpfloat (g_timer_elapsed (timer, NULL), <, 0.8f);
+	g_assert_cmpint (fu_device_get_retry_delay_learned (device), >, 0);
+	g_assert_cmpint (fu_device_get_retry_delay_learned (device), <=, 200);
+}
+
+static void
+fu_common_virtual_clock_func (void)
+{
+	gint64 real_start = g_get_monotonic_time ();
+	gint64 start = fu_common_get_monotonic_time ();
+
+	/* the time is skipped, not spent */
+	fu_common_sleep_us (10 * G_USEC_PER_SEC);
+	g_assert_cmpint (fu_common_get_monotonic_time () - start, >=, 10 * G_USEC_PER_SEC);
+	g_assert_cmpint (g_get_monotonic_time () - real_start, <, G_USEC_PER_SEC);
+}
+
 static void
 fu_security_attrs_hsi_func (void)
 {
@@ -2472,21 +3528,37 @@ main (int argc, char **argv)
 	g_setenv ("FWUPD_SYSFSFWDIR", TESTDATADIR_SRC, TRUE);
 	g_setenv ("FWUPD_OFFLINE_TRIGGER", "/tmp/fwupd-self-test/system-update", TRUE);
 	g_setenv ("FWUPD_LOCALSTATEDIR", "/tmp/fwupd-self-test/var", TRUE);
+	g_setenv ("FWUPD_VIRTUAL_CLOCK", "1", TRUE);
 
 	g_test_add_func ("/fwupd/security-attrs{hsi}", fu_security_attrs_hsi_func);
 	g_test_add_func ("/fwupd/plugin{devices}", fu_plugin_devices_func);
 	g_test_add_func ("/fwupd/plugin{delay}", fu_plugin_delay_func);
+	g_test_add_func ("/fwupd/plugin{builtin}", fu_plugin_builtin_func);
 	g_test_add_func ("/fwupd/plugin{quirks}", fu_plugin_quirks_func);
+	g_test_add_func ("/fwupd/plugin{quirks-prebuilt}", fu_plugin_quirks_prebuilt_func);
 	g_test_add_func ("/fwupd/plugin{quirks-performance}", fu_plugin_quirks_performance_func);
 	g_test_add_func ("/fwupd/plugin{quirks-device}", fu_plugin_quirks_device_func);
+	g_test_add_func ("/fwupd/checksum-converter", fu_checksum_converter_func);
 	g_test_add_func ("/fwupd/chunk", fu_chunk_func);
+	g_test_add_func ("/fwupd/chunk{iter}", fu_chunk_iter_func);
 	g_test_add_func ("/fwupd/common{byte-array}", fu_common_byte_array_func);
+#if defined(HAVE_MEMFD_CREATE) && defined(F_ADD_SEALS)
+	g_test_add_func ("/fwupd/common{contents-fd}", fu_common_contents_fd_func);
+#endif
+	g_test_add_func ("/fwupd/common{contents-mapped}", fu_common_contents_mapped_func);
 	g_test_add_func ("/fwupd/common{crc}", fu_common_crc_func);
+	g_test_add_func ("/fwupd/common{crc-performance}", fu_common_crc_performance_func);
+	g_test_add_func ("/fwupd/common{bytes-find-runs}", fu_common_bytes_find_runs_func);
+	g_test_add_func ("/fwupd/common{guid-hash-cached}", fu_common_guid_hash_cached_func);
+	g_test_add_func ("/fwupd/common{jcat-cached}", fu_common_jcat_cached_func);
 	g_test_add_func ("/fwupd/common{string-append-kv}", fu_common_string_append_kv_func);
 	g_test_add_func ("/fwupd/common{version-guess-format}", fu_common_version_guess_format_func);
 	g_test_add_func ("/fwupd/common{version}", fu_common_version_func);
 	g_test_add_func ("/fwupd/common{version-semver}", fu_common_version_semver_func);
+	g_test_add_func ("/fwupd/io-channel{read}", fu_io_channel_read_func);
+	g_test_add_func ("/fwupd/common{acpi-table}", fu_common_acpi_table_func);
 	g_test_add_func ("/fwupd/common{vercmp}", fu_common_vercmp_func);
+	g_test_add_func ("/fwupd/common{version-key}", fu_common_version_key_func);
 	g_test_add_func ("/fwupd/common{strstrip}", fu_common_strstrip_func);
 	g_test_add_func ("/fwupd/common{endian}", fu_common_endian_func);
 	g_test_add_func ("/fwupd/common{cab-success}", fu_common_store_cab_func);
@@ -2497,13 +3569,18 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/common{cab-error-wrong-checksum}", fu_common_store_cab_error_wrong_checksum_func);
 	g_test_add_func ("/fwupd/common{cab-error-missing-file}", fu_common_store_cab_error_missing_file_func);
 	g_test_add_func ("/fwupd/common{cab-error-size}", fu_common_store_cab_error_size_func);
+	g_test_add_func ("/fwupd/common{cab-success-sha256}", fu_common_store_cab_sha256_func);
+	g_test_add_func ("/fwupd/common{cab-performance}", fu_common_store_cab_performance_func);
 	g_test_add_func ("/fwupd/common{spawn)", fu_common_spawn_func);
 	g_test_add_func ("/fwupd/common{spawn-timeout)", fu_common_spawn_timeout_func);
+	g_test_add_func ("/fwupd/common{spawn-async)", fu_common_spawn_async_func);
 	g_test_add_func ("/fwupd/common{firmware-builder}", fu_common_firmware_builder_func);
+	g_test_add_func ("/fwupd/common{cpuid}", fu_common_cpuid_func);
 	g_test_add_func ("/fwupd/common{kernel-lockdown}", fu_common_kernel_lockdown_func);
 	g_test_add_func ("/fwupd/common{strsafe}", fu_common_strsafe_func);
 	g_test_add_func ("/fwupd/common{uri-scheme}", fu_common_uri_scheme_func);
 	g_test_add_func ("/fwupd/efivar", fu_efivar_func);
+	g_test_add_func ("/fwupd/efivar{cache}", fu_efivar_cache_func);
 	g_test_add_func ("/fwupd/hwids", fu_hwids_func);
 	g_test_add_func ("/fwupd/smbios", fu_smbios_func);
 	g_test_add_func ("/fwupd/smbios3", fu_smbios3_func);
@@ -2515,13 +3592,17 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/firmware{ihex-offset}", fu_firmware_ihex_offset_func);
 	g_test_add_func ("/fwupd/firmware{ihex-signed}", fu_firmware_ihex_signed_func);
 	g_test_add_func ("/fwupd/firmware{srec-tokenization}", fu_firmware_srec_tokenization_func);
+	g_test_add_func ("/fwupd/firmware{strparse-hex}", fu_firmware_strparse_hex_func);
 	g_test_add_func ("/fwupd/firmware{srec}", fu_firmware_srec_func);
 	g_test_add_func ("/fwupd/firmware{dfu}", fu_firmware_dfu_func);
 	g_test_add_func ("/fwupd/firmware{dfuse}", fu_firmware_dfuse_func);
 	g_test_add_func ("/fwupd/firmware{fmap}", fu_firmware_fmap_func);
+	g_test_add_func ("/fwupd/firmware{defer-images}", fu_firmware_defer_images_func);
 	g_test_add_func ("/fwupd/firmware{gtypes}", fu_firmware_new_from_gtypes_func);
+	g_test_add_func ("/fwupd/efi-signature-list{checksum}", fu_efi_signature_list_checksum_func);
 	g_test_add_func ("/fwupd/archive{invalid}", fu_archive_invalid_func);
 	g_test_add_func ("/fwupd/archive{cab}", fu_archive_cab_func);
+	g_test_add_func ("/fwupd/archive{lazy}", fu_archive_lazy_func);
 	g_test_add_func ("/fwupd/device", fu_device_func);
 	g_test_add_func ("/fwupd/device{instance-ids}", fu_device_instance_ids_func);
 	g_test_add_func ("/fwupd/device{flags}", fu_device_flags_func);
@@ -2530,13 +3611,18 @@ main (int argc, char **argv)
 	g_test_add_func ("/fwupd/device{incorporate}", fu_device_incorporate_func);
 	if (g_test_slow ())
 		g_test_add_func ("/fwupd/device{poll}", fu_device_poll_func);
+	g_test_add_func ("/fwupd/device{trace}", fu_device_trace_func);
+	g_test_add_func ("/fwupd/device{transcript}", fu_device_transcript_func);
 	g_test_add_func ("/fwupd/device-locker{success}", fu_device_locker_func);
 	g_test_add_func ("/fwupd/device-locker{fail}", fu_device_locker_fail_func);
 	g_test_add_func ("/fwupd/device{metadata}", fu_device_metadata_func);
+	g_test_add_func ("/fwupd/device{firmware-cache}", fu_device_firmware_cache_func);
 	g_test_add_func ("/fwupd/device{open-refcount}", fu_device_open_refcount_func);
 	g_test_add_func ("/fwupd/device{version-format}", fu_device_version_format_func);
 	g_test_add_func ("/fwupd/device{retry-success}", fu_device_retry_success_func);
 	g_test_add_func ("/fwupd/device{retry-failed}", fu_device_retry_failed_func);
 	g_test_add_func ("/fwupd/device{retry-hardware}", fu_device_retry_hardware_func);
+	g_test_add_func ("/fwupd/device{retry-backoff}", fu_device_retry_backoff_func);
+	g_test_add_func ("/fwupd/common{virtual-clock}", fu_common_virtual_clock_func);
 	return g_test_run ();
 }
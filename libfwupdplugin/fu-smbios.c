@@ -19,6 +19,8 @@ struct _FuSmbios {
 	FuFirmware		 parent_instance;
 	guint32			 structure_table_len;
 	GPtrArray		*items;
+	GPtrArray		*items_by_type[0x100];	/* (nullable) (element-type FuSmbiosItem) */
+	GPtrArray		*tables;		/* (element-type GBytes) */
 };
 
 /* little endian */
@@ -57,11 +59,20 @@ typedef struct {
 	guint8			 type;
 	guint16			 handle;
 	GByteArray		*buf;
-	GPtrArray		*strings;
+	GPtrArray		*strings;	/* may point into @tables */
 } FuSmbiosItem;
 
 G_DEFINE_TYPE (FuSmbios, fu_smbios, FU_TYPE_FIRMWARE)
 
+static void
+fu_smbios_add_item (FuSmbios *self, FuSmbiosItem *item)
+{
+	if (self->items_by_type[item->type] == NULL)
+		self->items_by_type[item->type] = g_ptr_array_new ();
+	g_ptr_array_add (self->items_by_type[item->type], item);
+	g_ptr_array_add (self->items, item);
+}
+
 static void
 fu_smbios_convert_dt_value (FuSmbios *self, guint8 type, guint8 offset, guint8 value)
 {
@@ -100,7 +111,7 @@ fu_smbios_setup_from_path_dt (FuSmbios *self, const gchar *path, GError **error)
 		item->type = i;
 		item->buf = g_byte_array_new ();
 		item->strings = g_ptr_array_new_with_free_func (g_free);
-		g_ptr_array_add (self->items, item);
+		fu_smbios_add_item (self, item);
 	}
 
 	/* if it has a battery it is portable (probably a laptop) */
@@ -139,8 +150,16 @@ fu_smbios_setup_from_path_dt (FuSmbios *self, const gchar *path, GError **error)
 }
 
 static gboolean
-fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError **error)
+fu_smbios_setup_from_data (FuSmbios *self, const guint8 *data, gsize sz, GError **error)
 {
+	GBytes *table;
+	const guint8 *buf;
+
+	/* keep one copy of the table so the string tables can point into it */
+	table = g_bytes_new (data, sz);
+	g_ptr_array_add (self->tables, table);
+	buf = g_bytes_get_data (table, NULL);
+
 	/* go through each structure */
 	for (gsize i = 0; i < sz; i++) {
 		FuSmbiosItem *item;
@@ -176,9 +195,9 @@ fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError *
 		item->type = str_type;
 		item->handle = GUINT16_FROM_LE (str_handle);
 		item->buf = g_byte_array_sized_new (str_len);
-		item->strings = g_ptr_array_new_with_free_func (g_free);
+		item->strings = g_ptr_array_new ();
 		g_byte_array_append (item->buf, buf + i, str_len);
-		g_ptr_array_add (self->items, item);
+		fu_smbios_add_item (self, item);
 
 		/* jump to the end of the struct */
 		i += str_len;
@@ -193,7 +212,7 @@ fu_smbios_setup_from_data (FuSmbios *self, const guint8 *buf, gsize sz, GError *
 				if (start_offset == i)
 					break;
 				g_ptr_array_add (item->strings,
-						 g_strdup ((const gchar *) &buf[start_offset]));
+						 (gpointer) &buf[start_offset]);
 				start_offset = i + 1;
 			}
 		}
@@ -516,12 +535,46 @@ fu_smbios_to_string (FuSmbios *self)
 static FuSmbiosItem *
 fu_smbios_get_item_for_type (FuSmbios *self, guint8 type)
 {
-	for (guint i = 0; i < self->items->len; i++) {
-		FuSmbiosItem *item = g_ptr_array_index (self->items, i);
-		if (item->type == type)
-			return item;
+	if (self->items_by_type[type] == NULL)
+		return NULL;
+	return g_ptr_array_index (self->items_by_type[type], 0);
+}
+
+/**
+ * fu_smbios_get_data_array:
+ * @self: A #FuSmbios
+ * @type: A structure type, e.g. %FU_SMBIOS_STRUCTURE_TYPE_BIOS
+ * @error: A #GError or %NULL
+ *
+ * Reads all the SMBIOS data blobs of a specific type, in the order they are
+ * listed in the structure table. Each blob includes the SMBIOS section header.
+ *
+ * Returns: (transfer container) (element-type GBytes): blobs, or %NULL if not found
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fu_smbios_get_data_array (FuSmbios *self, guint8 type, GError **error)
+{
+	GPtrArray *items;
+	g_autoptr(GPtrArray) array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+
+	g_return_val_if_fail (FU_IS_SMBIOS (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	items = self->items_by_type[type];
+	if (items == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "no structure with type %02x", type);
+		return NULL;
 	}
-	return NULL;
+	for (guint i = 0; i < items->len; i++) {
+		FuSmbiosItem *item = g_ptr_array_index (items, i);
+		g_ptr_array_add (array, g_bytes_new (item->buf->data, item->buf->len));
+	}
+	return g_steal_pointer (&array);
 }
 
 /**
@@ -678,7 +731,12 @@ static void
 fu_smbios_finalize (GObject *object)
 {
 	FuSmbios *self = FU_SMBIOS (object);
+	for (guint i = 0; i < G_N_ELEMENTS (self->items_by_type); i++) {
+		if (self->items_by_type[i] != NULL)
+			g_ptr_array_unref (self->items_by_type[i]);
+	}
 	g_ptr_array_unref (self->items);
+	g_ptr_array_unref (self->tables);
 	G_OBJECT_CLASS (fu_smbios_parent_class)->finalize (object);
 }
 
@@ -696,6 +754,7 @@ static void
 fu_smbios_init (FuSmbios *self)
 {
 	self->items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_smbios_item_free);
+	self->tables = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
 }
 
 /**
@@ -75,3 +75,6 @@ guint		 fu_smbios_get_integer		(FuSmbios	*self,
 GBytes		*fu_smbios_get_data		(FuSmbios	*self,
 						 guint8		 type,
 						 GError		**error);
+GPtrArray	*fu_smbios_get_data_array	(FuSmbios	*self,
+						 guint8		 type,
+						 GError		**error);
@@ -87,31 +87,36 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 	FuSrecFirmware *self = FU_SREC_FIRMWARE (firmware);
 	const gchar *data;
 	gboolean got_eof = FALSE;
+	gsize offset = 0;
 	gsize sz = 0;
-	g_auto(GStrv) lines = NULL;
 
-	/* parse records */
+	/* parse records, scanning the lines in place */
 	data = g_bytes_get_data (fw, &sz);
-	lines = fu_common_strnsplit (data, sz, "\n", -1);
-	for (guint ln = 0; lines[ln] != NULL; ln++) {
+	for (guint ln = 0; offset < sz; ln++) {
 		FuSrecFirmwareRecord *rcd;
-		const gchar *line = lines[ln];
-		gsize linesz;
-		guint32 rec_addr32;
-		guint16 rec_addr16;
+		const gchar *line = data + offset;
+		const gchar *eol = memchr (line, '\n', sz - offset);
+		gsize linesz = eol != NULL ? (gsize) (eol - line) : sz - offset;
+		guint32 rec_addr32 = 0;
 		guint8 addrsz = 0;		/* bytes */
-		guint8 rec_count;		/* words */
+		guint8 rec_count = 0;		/* words */
 		guint8 rec_kind;
+		guint8 buf[0xff] = { 0x0 };	/* address, data, checksum */
 
 		/* ignore blank lines */
-		g_strdelimit (lines[ln], "\r", '\0');
-		linesz = strlen (line);
+		offset += linesz + 1;
+		for (gsize i = 0; i < linesz; i++) {
+			if (line[i] == '\r' || line[i] == '\0') {
+				linesz = i;
+				break;
+			}
+		}
 		if (linesz == 0)
 			continue;
 
 		/* check starting token */
 		if (line[0] != 'S') {
-			g_autofree gchar *strsafe = fu_common_strsafe (line, 3);
+			g_autofree gchar *strsafe = fu_common_strsafe (line, MIN (linesz, 3));
 			if (strsafe != NULL) {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -129,10 +134,10 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 		}
 
 		/* kind, count, address, (data), checksum, linefeed */
-		rec_kind = line[1] - '0';
-		if (!fu_firmware_strparse_uint8_safe (line, linesz, 2, &rec_count, error))
+		rec_kind = linesz > 1 ? line[1] - '0' : 0xff;
+		if (!fu_firmware_strparse_hex_safe (line, linesz, 2, &rec_count, 1, error))
 			return FALSE;
-		if (rec_count * 2 != linesz - 4) {
+		if (rec_count == 0 || rec_count * 2 != linesz - 4) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
@@ -142,25 +147,17 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 			return FALSE;
 		}
 
+		/* decode everything after the count in one pass */
+		if (!fu_firmware_strparse_hex_safe (line, linesz, 4, buf, rec_count, error))
+			return FALSE;
+
 		/* checksum check */
 		if ((flags & FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM) == 0) {
-			guint8 rec_csum = 0;
-			guint8 rec_csum_expected;
-			for (guint8 i = 0; i < rec_count; i++) {
-				guint8 csum_tmp = 0;
-				if (!fu_firmware_strparse_uint8_safe (line, linesz,
-								      (i * 2) + 2,
-								      &csum_tmp,
-								      error))
-					return FALSE;
-				rec_csum += csum_tmp;
-			}
+			guint8 rec_csum = rec_count;
+			guint8 rec_csum_expected = buf[rec_count - 1];
+			for (guint8 i = 0; i < rec_count - 1; i++)
+				rec_csum += buf[i];
 			rec_csum ^= 0xff;
-			if (!fu_firmware_strparse_uint8_safe (line, linesz,
-							      (rec_count * 2) + 2,
-							      &rec_csum_expected,
-							      error))
-				return FALSE;
 			if (rec_csum != rec_csum_expected) {
 				g_set_error (error,
 					     FWUPD_ERROR,
@@ -215,29 +212,16 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 		}
 
 		/* parse address */
-		switch (addrsz) {
-		case 2:
-			if (!fu_firmware_strparse_uint16_safe (line, linesz,
-							       4, &rec_addr16,
-							       error))
-				return FALSE;
-			rec_addr32 = rec_addr16;
-			break;
-		case 3:
-			if (!fu_firmware_strparse_uint24_safe (line, linesz,
-							       4, &rec_addr32,
-							       error))
-				return FALSE;
-			break;
-		case 4:
-			if (!fu_firmware_strparse_uint32_safe (line, linesz,
-							       4, &rec_addr32,
-							       error))
-				return FALSE;
-			break;
-		default:
-			g_assert_not_reached ();
+		if (rec_count < addrsz + 1) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "record too short for address at line %u",
+				     ln + 1);
+			return FALSE;
 		}
+		for (guint8 i = 0; i < addrsz; i++)
+			rec_addr32 = (rec_addr32 << 8) | buf[i];
 
 		g_debug ("line %03u S%u addr:0x%04x datalen:0x%02x",
 			 ln + 1, rec_kind, rec_addr32,
@@ -245,14 +229,8 @@ fu_srec_firmware_tokenize (FuFirmware *firmware, GBytes *fw,
 
 		/* data */
 		rcd = fu_srec_firmware_record_new (ln + 1, rec_kind, rec_addr32);
-		if (rec_kind == 1 || rec_kind == 2 || rec_kind == 3) {
-			for (gsize i = 4 + (addrsz * 2); i <= rec_count * 2; i += 2) {
-				guint8 tmp = 0;
-				if (!fu_firmware_strparse_uint8_safe (line, linesz, i, &tmp, error))
-					return FALSE;
-				fu_byte_array_append_uint8 (rcd->buf, tmp);
-			}
-		}
+		if (rec_kind == 1 || rec_kind == 2 || rec_kind == 3)
+			g_byte_array_append (rcd->buf, buf + addrsz, rec_count - addrsz - 1);
 		g_ptr_array_add (self->records, rcd);
 	}
 
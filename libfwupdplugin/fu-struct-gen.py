@@ -0,0 +1,232 @@
+#!/usr/bin/python3
+""" Builds bounds-checked parse and write functions from a struct description """
+
+# pylint: disable=invalid-name,wrong-import-position,pointless-string-statement
+
+"""
+SPDX-License-Identifier: LGPL-2.1+
+"""
+
+import os
+import re
+import sys
+
+# type: (C type, size, GLib swap macro suffix or None)
+TYPES = {
+    'u8': ('guint8', 1, None),
+    'u16le': ('guint16', 2, 'GUINT16_%s_LE'),
+    'u16be': ('guint16', 2, 'GUINT16_%s_BE'),
+    'u32le': ('guint32', 4, 'GUINT32_%s_LE'),
+    'u32be': ('guint32', 4, 'GUINT32_%s_BE'),
+    'u64le': ('guint64', 8, 'GUINT64_%s_LE'),
+    'u64be': ('guint64', 8, 'GUINT64_%s_BE'),
+}
+
+
+def usage(return_code):
+    """ print usage and exit with the supplied return code """
+    if return_code == 0:
+        out = sys.stdout
+    else:
+        out = sys.stderr
+    out.write("usage: fu-struct-gen.py <INPUT> <SOURCE> <HEADER>")
+    sys.exit(return_code)
+
+
+class Field:
+    """ a fixed-size member of a struct """
+
+    def __init__(self, name, kind, offset):
+        self.name = name
+        self.kind = kind
+        self.offset = offset
+        self.array = 0
+        m = re.fullmatch(r'u8\[(0x[0-9a-fA-F]+|[0-9]+)\]', kind)
+        if m:
+            self.array = int(m.group(1), 0)
+            self.ctype = 'guint8'
+            self.size = self.array
+            self.swap = None
+        elif kind in TYPES:
+            self.ctype, self.size, self.swap = TYPES[kind]
+        else:
+            raise ValueError('unknown type %s' % kind)
+
+
+class Struct:
+    """ a named struct with fields at known offsets """
+
+    def __init__(self, name):
+        if not re.fullmatch(r'Fu[A-Z][A-Za-z0-9]*', name):
+            raise ValueError('invalid struct name %s' % name)
+        self.name = name
+        self.fields = []
+        self.size = 0
+        self.prefix = re.sub(r'(?<!^)(?=[A-Z])', '_', name).lower()
+
+    def add_field(self, name, kind, offset):
+        """ add a field, at the end of the previous field if no offset is set """
+        if offset is None:
+            offset = self.size
+        if offset < self.size:
+            raise ValueError('%s.%s at 0x%x overlaps previous field' %
+                             (self.name, name, offset))
+        field = Field(name, kind, offset)
+        self.fields.append(field)
+        self.size = field.offset + field.size
+
+    def to_header(self):
+        """ typedef, size and prototypes """
+        lines = []
+        lines.append('#define %s_SIZE 0x%x' % (self.prefix.upper(), self.size))
+        lines.append('')
+        lines.append('typedef struct {')
+        for field in self.fields:
+            if field.array:
+                lines.append('\t%s\t\t\t %s[0x%x];' %
+                             (field.ctype, field.name, field.array))
+            else:
+                lines.append('\t%s\t\t\t %s;' % (field.ctype, field.name))
+        lines.append('} %s;' % self.name)
+        lines.append('')
+        lines.append('gboolean\t %s_parse\t(%s *st,' % (self.prefix, self.name))
+        lines.append('\t\t\t\t const guint8 *buf,')
+        lines.append('\t\t\t\t gsize bufsz,')
+        lines.append('\t\t\t\t gsize offset,')
+        lines.append('\t\t\t\t GError **error);')
+        lines.append('gboolean\t %s_write\t(const %s *st,' % (self.prefix, self.name))
+        lines.append('\t\t\t\t guint8 *buf,')
+        lines.append('\t\t\t\t gsize bufsz,')
+        lines.append('\t\t\t\t gsize offset,')
+        lines.append('\t\t\t\t GError **error);')
+        lines.append('')
+        return lines
+
+    def _check_bounds(self):
+        lines = []
+        lines.append('\tif (offset > bufsz || bufsz - offset < %s_SIZE) {' %
+                     self.prefix.upper())
+        lines.append('\t\tg_set_error (error,')
+        lines.append('\t\t\t     FWUPD_ERROR,')
+        lines.append('\t\t\t     FWUPD_ERROR_INVALID_FILE,')
+        lines.append('\t\t\t     "%s requires 0x%%x bytes at 0x%%" G_GSIZE_MODIFIER "x, '
+                     'buffer was 0x%%" G_GSIZE_MODIFIER "x",' % self.name)
+        lines.append('\t\t\t     (guint) %s_SIZE, offset, bufsz);' % self.prefix.upper())
+        lines.append('\t\treturn FALSE;')
+        lines.append('\t}')
+        return lines
+
+    def to_source(self):
+        """ parse and write functions """
+        lines = []
+        lines.append('gboolean')
+        lines.append('%s_parse (%s *st,' % (self.prefix, self.name))
+        lines.append('\t\tconst guint8 *buf,')
+        lines.append('\t\tgsize bufsz,')
+        lines.append('\t\tgsize offset,')
+        lines.append('\t\tGError **error)')
+        lines.append('{')
+        lines.append('\tconst guint8 *ptr;')
+        lines.append('')
+        lines.append('\tg_return_val_if_fail (st != NULL, FALSE);')
+        lines.append('\tg_return_val_if_fail (buf != NULL, FALSE);')
+        lines.append('')
+        lines.extend(self._check_bounds())
+        lines.append('\tptr = buf + offset;')
+        for field in self.fields:
+            if field.array:
+                lines.append('\tmemcpy (st->%s, ptr + 0x%x, sizeof(st->%s));' %
+                             (field.name, field.offset, field.name))
+            elif field.swap is None:
+                lines.append('\tst->%s = ptr[0x%x];' % (field.name, field.offset))
+            else:
+                lines.append('\tmemcpy (&st->%s, ptr + 0x%x, sizeof(st->%s));' %
+                             (field.name, field.offset, field.name))
+                lines.append('\tst->%s = %s (st->%s);' %
+                             (field.name, field.swap % 'FROM', field.name))
+        lines.append('\treturn TRUE;')
+        lines.append('}')
+        lines.append('')
+        lines.append('gboolean')
+        lines.append('%s_write (const %s *st,' % (self.prefix, self.name))
+        lines.append('\t\tguint8 *buf,')
+        lines.append('\t\tgsize bufsz,')
+        lines.append('\t\tgsize offset,')
+        lines.append('\t\tGError **error)')
+        lines.append('{')
+        lines.append('\tguint8 *ptr;')
+        lines.append('')
+        lines.append('\tg_return_val_if_fail (st != NULL, FALSE);')
+        lines.append('\tg_return_val_if_fail (buf != NULL, FALSE);')
+        lines.append('')
+        lines.extend(self._check_bounds())
+        lines.append('\tptr = buf + offset;')
+        for field in self.fields:
+            if field.array:
+                lines.append('\tmemcpy (ptr + 0x%x, st->%s, sizeof(st->%s));' %
+                             (field.offset, field.name, field.name))
+            elif field.swap is None:
+                lines.append('\tptr[0x%x] = st->%s;' % (field.offset, field.name))
+            else:
+                lines.append('\t{')
+                lines.append('\t\t%s tmp = %s (st->%s);' %
+                             (field.ctype, field.swap % 'TO', field.name))
+                lines.append('\t\tmemcpy (ptr + 0x%x, &tmp, sizeof(tmp));' %
+                             field.offset)
+                lines.append('\t}')
+        lines.append('\treturn TRUE;')
+        lines.append('}')
+        lines.append('')
+        return lines
+
+
+def parse_structs(filename):
+    """ parse the description into a list of Struct objects """
+    structs = []
+    with open(filename, 'r') as f:
+        for lineno, line in enumerate(f.readlines(), 1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            sections = line.split()
+            try:
+                if sections[0] == 'struct' and len(sections) == 2:
+                    structs.append(Struct(sections[1]))
+                    continue
+                if not structs:
+                    raise ValueError('field outside of struct')
+                offset = None
+                if len(sections) == 3 and sections[2].startswith('@'):
+                    offset = int(sections[2][1:], 0)
+                elif len(sections) != 2:
+                    raise ValueError('expected NAME TYPE [@OFFSET]')
+                structs[-1].add_field(sections[0], sections[1], offset)
+            except ValueError as e:
+                sys.stderr.write('%s:%u: %s\n' % (filename, lineno, str(e)))
+                sys.exit(1)
+    return structs
+
+
+if __name__ == '__main__':
+    if {'-?', '--help', '--usage'}.intersection(set(sys.argv)):
+        usage(0)
+    if len(sys.argv) != 4:
+        usage(1)
+    fn_input = os.path.basename(sys.argv[1])
+    items = parse_structs(sys.argv[1])
+    with open(sys.argv[3], 'w') as f2:
+        f2.write('/* generated from %s by fu-struct-gen.py, do not edit */\n\n' % fn_input)
+        f2.write('#pragma once\n\n')
+        f2.write('#include <glib.h>\n\n')
+        for item in items:
+            f2.write('\n'.join(item.to_header()))
+            f2.write('\n')
+    with open(sys.argv[2], 'w') as f2:
+        f2.write('/* generated from %s by fu-struct-gen.py, do not edit */\n\n' % fn_input)
+        f2.write('#include "config.h"\n\n')
+        f2.write('#include <string.h>\n')
+        f2.write('#include <libfwupd/fwupd-error.h>\n\n')
+        f2.write('#include "%s"\n\n' % os.path.basename(sys.argv[3]))
+        for item in items:
+            f2.write('\n'.join(item.to_source()))
+            f2.write('\n')
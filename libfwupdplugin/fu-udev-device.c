@@ -46,7 +46,9 @@ typedef struct
 	gchar			*driver;
 	gchar			*device_file;
 	gint			 fd;
+	gint			 fd_kept;	/* closed, but not yet close()d */
 	FuUdevDeviceFlags	 flags;
+	GBytes			*config;	/* snapshot of PCI config space */
 } FuUdevDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuUdevDevice, fu_udev_device, FU_TYPE_DEVICE)
@@ -69,6 +71,17 @@ static guint signals[SIGNAL_LAST] = { 0 };
 
 #define GET_PRIVATE(o) (fu_udev_device_get_instance_private (o))
 
+/* the device node may now be different, so do not reuse the fd */
+static void
+fu_udev_device_drop_kept_fd (FuUdevDevice *self)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	if (priv->fd_kept > 0) {
+		g_close (priv->fd_kept, NULL);
+		priv->fd_kept = 0;
+	}
+}
+
 /**
  * fu_udev_device_emit_changed:
  * @self: A #FuUdevDevice
@@ -80,9 +93,11 @@ static guint signals[SIGNAL_LAST] = { 0 };
 void
 fu_udev_device_emit_changed (FuUdevDevice *self)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	g_autoptr(GError) error = NULL;
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
 	g_debug ("FuUdevDevice emit changed");
+	g_clear_pointer (&priv->config, g_bytes_unref);
 	if (!fu_device_rescan (FU_DEVICE (self), &error))
 		g_debug ("%s", error->message);
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
@@ -539,6 +554,9 @@ fu_udev_device_set_dev (FuUdevDevice *self, GUdevDevice *udev_device)
 
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
 
+	fu_udev_device_drop_kept_fd (self);
+	g_clear_pointer (&priv->config, g_bytes_unref);
+
 #ifdef HAVE_GUDEV
 	/* the net subsystem is not a real hardware class */
 	if (udev_device != NULL &&
@@ -1162,6 +1180,7 @@ fu_udev_device_set_readonly (FuUdevDevice *self, gboolean readonly)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
+	fu_udev_device_drop_kept_fd (self);
 	priv->flags = readonly ? FU_UDEV_DEVICE_FLAG_OPEN_READ :
 				 FU_UDEV_DEVICE_FLAG_OPEN_READ |
 				 FU_UDEV_DEVICE_FLAG_OPEN_WRITE;
@@ -1184,6 +1203,8 @@ fu_udev_device_set_flags (FuUdevDevice *self, FuUdevDeviceFlags flags)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	g_return_if_fail (FU_IS_UDEV_DEVICE (self));
+	if (priv->flags != flags)
+		fu_udev_device_drop_kept_fd (self);
 	priv->flags = flags;
 
 #ifdef HAVE_GUDEV
@@ -1203,8 +1224,11 @@ fu_udev_device_open (FuDevice *device, GError **error)
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	FuUdevDeviceClass *klass = FU_UDEV_DEVICE_GET_CLASS (device);
 
-	/* open device */
-	if (priv->device_file != NULL && priv->flags != FU_UDEV_DEVICE_FLAG_NONE) {
+	/* reuse the file descriptor from the last time the device was open */
+	if (priv->fd_kept > 0) {
+		priv->fd = priv->fd_kept;
+		priv->fd_kept = 0;
+	} else if (priv->device_file != NULL && priv->flags != FU_UDEV_DEVICE_FLAG_NONE) {
 		gint flags;
 		if (priv->flags & FU_UDEV_DEVICE_FLAG_OPEN_READ &&
 		    priv->flags & FU_UDEV_DEVICE_FLAG_OPEN_WRITE) {
@@ -1289,8 +1313,13 @@ fu_udev_device_close (FuDevice *device, GError **error)
 			return FALSE;
 	}
 
-	/* close device */
+	/* close device, or keep it around for next time */
 	if (priv->fd > 0) {
+		if (priv->flags & FU_UDEV_DEVICE_FLAG_KEEP_OPEN && priv->fd_kept == 0) {
+			priv->fd_kept = priv->fd;
+			priv->fd = 0;
+			return TRUE;
+		}
 		if (!g_close (priv->fd, error))
 			return FALSE;
 		priv->fd = 0;
@@ -1324,12 +1353,26 @@ fu_udev_device_ioctl (FuUdevDevice *self,
 #ifdef HAVE_IOCTL_H
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
 	gint rc_tmp;
+	gsize bufsz = 0;
+	g_autofree gchar *id = NULL;
 
 	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
 	g_return_val_if_fail (request != 0x0, FALSE);
 	g_return_val_if_fail (buf != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* the data size is only known when encoded in the request */
+#ifdef _IOC_SIZE
+	bufsz = _IOC_SIZE (request);
+#endif
+	id = g_strdup_printf ("Ioctl:0x%lx", request);
+	if (fu_device_transcript_is_replay (FU_DEVICE (self))) {
+		if (rc != NULL)
+			*rc = 0;
+		return fu_device_transcript_replay_read (FU_DEVICE (self), id,
+							 buf, bufsz, NULL, error);
+	}
+
 	/* not open! */
 	if (priv->fd == 0) {
 		g_set_error (error,
@@ -1366,6 +1409,7 @@ fu_udev_device_ioctl (FuUdevDevice *self,
 #endif
 		return FALSE;
 	}
+	fu_device_transcript_record (FU_DEVICE (self), id, buf, bufsz);
 	return TRUE;
 #else
 	g_set_error (error,
@@ -1396,11 +1440,29 @@ fu_udev_device_pread_full (FuUdevDevice *self, goffset port,
 			   GError **error)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	g_autofree gchar *id = g_strdup_printf ("Pread:0x%x", (guint) port);
 
 	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
 	g_return_val_if_fail (buf != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* no hardware */
+	if (fu_device_transcript_is_replay (FU_DEVICE (self))) {
+		gsize actual_len = 0;
+		if (!fu_device_transcript_replay_read (FU_DEVICE (self), id,
+						       buf, bufsz, &actual_len, error))
+			return FALSE;
+		if (actual_len != bufsz) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "failed to read from port 0x%04x: short read",
+				     (guint) port);
+			return FALSE;
+		}
+		return TRUE;
+	}
+
 	/* not open! */
 	if (priv->fd == 0) {
 		g_set_error (error,
@@ -1422,6 +1484,7 @@ fu_udev_device_pread_full (FuUdevDevice *self, goffset port,
 			     strerror (errno));
 		return FALSE;
 	}
+	fu_device_transcript_record (FU_DEVICE (self), id, buf, bufsz);
 	return TRUE;
 #else
 	g_set_error_literal (error,
@@ -1432,6 +1495,54 @@ fu_udev_device_pread_full (FuUdevDevice *self, goffset port,
 #endif
 }
 
+/**
+ * fu_udev_device_read_config:
+ * @self: A #FuUdevDevice
+ * @offset: offset into the PCI config space
+ * @buf: (out): data
+ * @bufsz: size of @buf
+ * @error: A #GError, or %NULL
+ *
+ * Reads from a snapshot of the PCI config space, which is read from the device
+ * on first use and then shared by all callers until the device changes.
+ * The first 256 bytes are read unless the extended config space is requested.
+ *
+ * The device must have been opened with %FU_UDEV_DEVICE_FLAG_USE_CONFIG.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_udev_device_read_config (FuUdevDevice *self, goffset offset,
+			    guint8 *buf, gsize bufsz,
+			    GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	gsize configsz = FU_UDEV_DEVICE_CONFIG_SIZE;
+
+	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
+	g_return_val_if_fail (buf != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* read all of the config space the caller needs in one go */
+	if ((gsize) offset + bufsz > configsz)
+		configsz = FU_UDEV_DEVICE_CONFIG_SIZE_EXTENDED;
+	if (priv->config == NULL || g_bytes_get_size (priv->config) < configsz) {
+		g_autofree guint8 *config = g_malloc0 (configsz);
+		if (!fu_udev_device_pread_full (self, 0x0, config, configsz, error)) {
+			g_prefix_error (error, "failed to read config space: ");
+			return FALSE;
+		}
+		g_clear_pointer (&priv->config, g_bytes_unref);
+		priv->config = g_bytes_new_take (g_steal_pointer (&config), configsz);
+	}
+	return fu_memcpy_safe (buf, bufsz, 0x0,				/* dst */
+			       g_bytes_get_data (priv->config, NULL),
+			       g_bytes_get_size (priv->config), offset,	/* src */
+			       bufsz, error);
+}
+
 /**
  * fu_udev_device_pwrite_full:
  * @self: A #FuUdevDevice
@@ -1452,10 +1563,17 @@ fu_udev_device_pwrite_full (FuUdevDevice *self, goffset port,
 			    GError **error)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE (self);
+	g_autofree gchar *id = g_strdup_printf ("Pwrite:0x%x", (guint) port);
 
 	g_return_val_if_fail (FU_IS_UDEV_DEVICE (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* no hardware */
+	if (fu_device_transcript_is_replay (FU_DEVICE (self))) {
+		return fu_device_transcript_replay_write (FU_DEVICE (self), id,
+							  buf, bufsz, error);
+	}
+
 	/* not open! */
 	if (priv->fd == 0) {
 		g_set_error (error,
@@ -1477,6 +1595,7 @@ fu_udev_device_pwrite_full (FuUdevDevice *self, goffset port,
 			     strerror (errno));
 		return FALSE;
 	}
+	fu_device_transcript_record (FU_DEVICE (self), id, buf, bufsz);
 	return TRUE;
 #else
 	g_set_error_literal (error,
@@ -1757,10 +1876,14 @@ fu_udev_device_finalize (GObject *object)
 	g_free (priv->subsystem);
 	g_free (priv->driver);
 	g_free (priv->device_file);
+	if (priv->config != NULL)
+		g_bytes_unref (priv->config);
 	if (priv->udev_device != NULL)
 		g_object_unref (priv->udev_device);
 	if (priv->fd > 0)
 		g_close (priv->fd, NULL);
+	if (priv->fd_kept > 0)
+		g_close (priv->fd_kept, NULL);
 
 	G_OBJECT_CLASS (fu_udev_device_parent_class)->finalize (object);
 }
@@ -43,6 +43,7 @@ struct _FuUdevDeviceClass
  * @FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT:	Get the vendor ID fallback from the parent
  * @FU_UDEV_DEVICE_FLAG_USE_CONFIG:		Read and write from the device config
  * @FU_UDEV_DEVICE_FLAG_OPEN_NONBLOCK:		Open nonblocking, e.g. O_NONBLOCK
+ * @FU_UDEV_DEVICE_FLAG_KEEP_OPEN:		Keep the device file open when closed, until the device changes
  *
  * Flags used when opening the device using fu_device_open().
  **/
@@ -53,10 +54,15 @@ typedef enum {
 	FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT	= 1 << 2,
 	FU_UDEV_DEVICE_FLAG_USE_CONFIG		= 1 << 3,
 	FU_UDEV_DEVICE_FLAG_OPEN_NONBLOCK	= 1 << 4,
+	FU_UDEV_DEVICE_FLAG_KEEP_OPEN		= 1 << 5,
 	/*< private >*/
 	FU_UDEV_DEVICE_FLAG_LAST
 } FuUdevDeviceFlags;
 
+/* PCI config space, without and with the PCIe extended capabilities */
+#define FU_UDEV_DEVICE_CONFIG_SIZE		0x100
+#define FU_UDEV_DEVICE_CONFIG_SIZE_EXTENDED	0x1000
+
 FuUdevDevice	*fu_udev_device_new			(GUdevDevice	*udev_device);
 GUdevDevice	*fu_udev_device_get_dev			(FuUdevDevice	*self);
 const gchar	*fu_udev_device_get_device_file		(FuUdevDevice	*self);
@@ -112,6 +118,12 @@ gboolean	 fu_udev_device_pread_full		(FuUdevDevice	*self,
 							 gsize		 bufsz,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_udev_device_read_config		(FuUdevDevice	*self,
+							 goffset	 offset,
+							 guint8		*buf,
+							 gsize		 bufsz,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 const gchar	*fu_udev_device_get_sysfs_attr		 (FuUdevDevice	*self,
 							  const gchar	*attr,
 							  GError	**error);
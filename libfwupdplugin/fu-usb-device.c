@@ -24,6 +24,7 @@ typedef struct
 {
 	GUsbDevice		*usb_device;
 	FuDeviceLocker		*usb_device_locker;
+	gboolean		 descriptors_loaded;
 } FuUsbDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (FuUsbDevice, fu_usb_device, FU_TYPE_DEVICE)
@@ -158,28 +159,19 @@ fu_usb_device_query_hub (FuUsbDevice *self, GError **error)
 }
 #endif
 
+#ifdef HAVE_GUSB
+/* each string descriptor is a control transfer, so only read them the first
+ * time the device is opened rather than on every open */
 static gboolean
-fu_usb_device_open (FuDevice *device, GError **error)
+fu_usb_device_ensure_descriptors (FuUsbDevice *self, GError **error)
 {
-	FuUsbDevice *self = FU_USB_DEVICE (device);
+	FuDevice *device = FU_DEVICE (self);
 	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
-	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (device);
-	g_autoptr(FuDeviceLocker) locker = NULL;
-#ifdef HAVE_GUSB
 	guint idx;
 
-	g_return_val_if_fail (FU_IS_USB_DEVICE (self), FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	/* already open */
-	if (priv->usb_device_locker != NULL)
+	if (priv->descriptors_loaded)
 		return TRUE;
 
-	/* open */
-	locker = fu_device_locker_new (priv->usb_device, error);
-	if (locker == NULL)
-		return FALSE;
-
 	/* get vendor */
 	if (fu_device_get_vendor (device) == NULL) {
 		idx = g_usb_device_get_manufacturer_index (priv->usb_device);
@@ -263,6 +255,36 @@ fu_usb_device_open (FuDevice *device, GError **error)
 		if (!fu_usb_device_query_hub (self, error))
 			return FALSE;
 	}
+
+	/* success */
+	priv->descriptors_loaded = TRUE;
+	return TRUE;
+}
+#endif
+
+static gboolean
+fu_usb_device_open (FuDevice *device, GError **error)
+{
+	FuUsbDevice *self = FU_USB_DEVICE (device);
+	FuUsbDevicePrivate *priv = GET_PRIVATE (self);
+	FuUsbDeviceClass *klass = FU_USB_DEVICE_GET_CLASS (device);
+	g_autoptr(FuDeviceLocker) locker = NULL;
+#ifdef HAVE_GUSB
+	g_return_val_if_fail (FU_IS_USB_DEVICE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* already open */
+	if (priv->usb_device_locker != NULL)
+		return TRUE;
+
+	/* open */
+	locker = fu_device_locker_new (priv->usb_device, error);
+	if (locker == NULL)
+		return FALSE;
+
+	/* string descriptors, custom indexes and the hub descriptor */
+	if (!fu_usb_device_ensure_descriptors (self, error))
+		return FALSE;
 #endif
 
 	/* subclassed */
@@ -500,6 +522,7 @@ fu_usb_device_set_dev (FuUsbDevice *device, GUsbDevice *usb_device)
 
 	/* allow replacement */
 	g_set_object (&priv->usb_device, usb_device);
+	priv->descriptors_loaded = FALSE;
 	if (usb_device == NULL) {
 		g_clear_object (&priv->usb_device_locker);
 		return;
@@ -589,6 +612,234 @@ fu_usb_device_get_dev (FuUsbDevice *device)
 	return priv->usb_device;
 }
 
+#ifdef HAVE_GUSB
+typedef struct {
+	FuUsbDevice		*self;
+	GPtrArray		*chunks;
+	guint8			 endpoint;
+	guint			 max_in_flight;
+	guint			 timeout_ms;
+	FuUsbDeviceTransferFlags flags;
+	guint			 idx_submitted;
+	guint			 in_flight;
+	gsize			 done_sz;
+	gsize			 total_sz;
+	GCancellable		*cancellable;
+	GMainLoop		*loop;
+	GError			*error;
+} FuUsbDeviceTransferHelper;
+
+typedef struct {
+	FuUsbDeviceTransferHelper *helper;
+	FuChunk			*chk;
+} FuUsbDeviceTransferItem;
+
+static void fu_usb_device_write_chunks_submit (FuUsbDeviceTransferHelper *helper);
+
+static gchar *
+fu_usb_device_transfer_id (guint8 endpoint, FuUsbDeviceTransferFlags flags)
+{
+	if (flags & FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT)
+		return g_strdup_printf ("Interrupt:0x%02x", endpoint);
+	return g_strdup_printf ("Bulk:0x%02x", endpoint);
+}
+
+static void
+fu_usb_device_write_chunks_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuUsbDeviceTransferItem *item = (FuUsbDeviceTransferItem *) user_data;
+	FuUsbDeviceTransferHelper *helper = item->helper;
+	GUsbDevice *usb_device = G_USB_DEVICE (source);
+	gsize chk_sz = fu_chunk_get_data_sz (item->chk);
+	gssize actual;
+	g_autoptr(GError) error_local = NULL;
+
+	if (helper->flags & FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT)
+		actual = g_usb_device_interrupt_transfer_finish (usb_device, res, &error_local);
+	else
+		actual = g_usb_device_bulk_transfer_finish (usb_device, res, &error_local);
+	helper->in_flight--;
+
+	/* only the first failure is interesting, the others were cancelled */
+	if (actual < 0) {
+		if (helper->error == NULL) {
+			g_propagate_prefixed_error (&helper->error,
+						    g_steal_pointer (&error_local),
+						    "failed to write chunk 0x%x: ",
+						    fu_chunk_get_idx (item->chk));
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else if ((gsize) actual != chk_sz) {
+		if (helper->error == NULL) {
+			g_set_error (&helper->error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_PARTIAL_INPUT,
+				     "only sent %" G_GSSIZE_FORMAT "/%"
+				     G_GSIZE_FORMAT " bytes of chunk 0x%x",
+				     actual, chk_sz,
+				     fu_chunk_get_idx (item->chk));
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else {
+		g_autofree gchar *id = fu_usb_device_transfer_id (helper->endpoint, helper->flags);
+		fu_device_transcript_record (FU_DEVICE (helper->self), id,
+					     fu_chunk_get_data (item->chk), chk_sz);
+		helper->done_sz += chk_sz;
+		if (helper->flags & FU_USB_DEVICE_TRANSFER_FLAG_PROGRESS) {
+			fu_device_set_progress_full (FU_DEVICE (helper->self),
+						     helper->done_sz,
+						     helper->total_sz);
+		}
+	}
+	g_free (item);
+
+	/* keep the pipeline full */
+	fu_usb_device_write_chunks_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_usb_device_write_chunks_submit (FuUsbDeviceTransferHelper *helper)
+{
+	FuUsbDevicePrivate *priv = GET_PRIVATE (helper->self);
+
+	while (helper->error == NULL &&
+	       helper->in_flight < helper->max_in_flight &&
+	       helper->idx_submitted < helper->chunks->len) {
+		FuUsbDeviceTransferItem *item = g_new0 (FuUsbDeviceTransferItem, 1);
+		FuChunk *chk = g_ptr_array_index (helper->chunks, helper->idx_submitted++);
+
+		/* libusb does not write to the buffer of an OUT transfer */
+		item->helper = helper;
+		item->chk = chk;
+		helper->in_flight++;
+		if (helper->flags & FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT) {
+			g_usb_device_interrupt_transfer_async (priv->usb_device,
+							       helper->endpoint,
+							       (guint8 *) fu_chunk_get_data (chk),
+							       fu_chunk_get_data_sz (chk),
+							       helper->timeout_ms,
+							       helper->cancellable,
+							       fu_usb_device_write_chunks_cb,
+							       item);
+		} else {
+			g_usb_device_bulk_transfer_async (priv->usb_device,
+							  helper->endpoint,
+							  (guint8 *) fu_chunk_get_data (chk),
+							  fu_chunk_get_data_sz (chk),
+							  helper->timeout_ms,
+							  helper->cancellable,
+							  fu_usb_device_write_chunks_cb,
+							  item);
+		}
+	}
+}
+#endif
+
+/**
+ * fu_usb_device_write_chunks:
+ * @device: A #FuUsbDevice
+ * @endpoint: the OUT endpoint address, e.g. `0x01`
+ * @chunks: (element-type FuChunk): chunks of data to send
+ * @max_in_flight: the maximum number of transfers to queue at once, e.g. 4
+ * @timeout_ms: the timeout for each transfer in milliseconds
+ * @flags: some #FuUsbDeviceTransferFlags, e.g. %FU_USB_DEVICE_TRANSFER_FLAG_PROGRESS
+ * @error: A #GError, or %NULL
+ *
+ * Writes each chunk to the device as a bulk or interrupt transfer, keeping
+ * up to @max_in_flight transfers queued so that the link is never idle while
+ * waiting for a completion. The chunks are sent in order.
+ *
+ * If any transfer fails then the remaining transfers are cancelled.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_usb_device_write_chunks (FuUsbDevice *device,
+			    guint8 endpoint,
+			    GPtrArray *chunks,
+			    guint max_in_flight,
+			    guint timeout_ms,
+			    FuUsbDeviceTransferFlags flags,
+			    GError **error)
+{
+#ifdef HAVE_GUSB
+	FuUsbDevicePrivate *priv = GET_PRIVATE (device);
+	FuUsbDeviceTransferHelper helper = {
+		.self		= device,
+		.chunks		= chunks,
+		.endpoint	= endpoint,
+		.max_in_flight	= MAX (max_in_flight, 1),
+		.timeout_ms	= timeout_ms,
+		.flags		= flags,
+	};
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+
+	g_return_val_if_fail (FU_IS_USB_DEVICE (device), FALSE);
+	g_return_val_if_fail (chunks != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* no hardware */
+	if (fu_device_transcript_is_replay (FU_DEVICE (device))) {
+		g_autofree gchar *id = fu_usb_device_transfer_id (endpoint, flags);
+		for (guint i = 0; i < chunks->len; i++) {
+			FuChunk *chk = g_ptr_array_index (chunks, i);
+			if (!fu_device_transcript_replay_write (FU_DEVICE (device), id,
+								fu_chunk_get_data (chk),
+								fu_chunk_get_data_sz (chk),
+								error))
+				return FALSE;
+			if (flags & FU_USB_DEVICE_TRANSFER_FLAG_PROGRESS)
+				fu_device_set_progress_full (FU_DEVICE (device), i + 1, chunks->len);
+		}
+		return TRUE;
+	}
+
+	/* not open */
+	if (priv->usb_device == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "no USB device");
+		return FALSE;
+	}
+
+	/* nothing to do */
+	if (chunks->len == 0)
+		return TRUE;
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		helper.total_sz += fu_chunk_get_data_sz (chk);
+	}
+
+	/* completions are dispatched to the thread-default context */
+	helper.cancellable = cancellable;
+	helper.loop = loop;
+	g_main_context_push_thread_default (context);
+	fu_usb_device_write_chunks_submit (&helper);
+	g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+#else
+	g_set_error_literal (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "Not supported as <gusb.h> is unavailable");
+	return FALSE;
+#endif
+}
+
 static void
 fu_usb_device_incorporate (FuDevice *self, FuDevice *donor)
 {
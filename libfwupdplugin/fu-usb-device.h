@@ -15,6 +15,7 @@ typedef GObject GUsbDevice;
 #define G_USB_CHECK_VERSION(a,c,b)	0
 #endif
 
+#include "fu-chunk.h"
 #include "fu-plugin.h"
 #include "fu-udev-device.h"
 
@@ -33,6 +34,22 @@ struct _FuUsbDeviceClass
 	gpointer	__reserved[28];
 };
 
+/**
+ * FuUsbDeviceTransferFlags:
+ * @FU_USB_DEVICE_TRANSFER_FLAG_NONE:		No flags set, use bulk transfers
+ * @FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT:	Use interrupt transfers
+ * @FU_USB_DEVICE_TRANSFER_FLAG_PROGRESS:	Set the device progress as chunks complete
+ *
+ * Flags used when writing chunks using fu_usb_device_write_chunks().
+ **/
+typedef enum {
+	FU_USB_DEVICE_TRANSFER_FLAG_NONE	= 0,
+	FU_USB_DEVICE_TRANSFER_FLAG_INTERRUPT	= 1 << 0,
+	FU_USB_DEVICE_TRANSFER_FLAG_PROGRESS	= 1 << 1,
+	/*< private >*/
+	FU_USB_DEVICE_TRANSFER_FLAG_LAST
+} FuUsbDeviceTransferFlags;
+
 FuUsbDevice	*fu_usb_device_new			(GUsbDevice	*usb_device);
 guint16		 fu_usb_device_get_vid			(FuUsbDevice	*self);
 guint16		 fu_usb_device_get_pid			(FuUsbDevice	*self);
@@ -44,3 +61,11 @@ gboolean	 fu_usb_device_is_open			(FuUsbDevice	*device);
 GUdevDevice	*fu_usb_device_find_udev_device		(FuUsbDevice	*device,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 fu_usb_device_write_chunks		(FuUsbDevice	*device,
+							 guint8		 endpoint,
+							 GPtrArray	*chunks,
+							 guint		 max_in_flight,
+							 guint		 timeout_ms,
+							 FuUsbDeviceTransferFlags flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+/* static probes in the fwupd provider, listed with `bpftrace -l usdt:PATH:*`;
+ * a double underscore in the name is shown as a dash by systemtap */
+#ifdef HAVE_SDT_H
+#include <sys/sdt.h>
+#define FU_USDT_PROBE1(name,a1)			DTRACE_PROBE1(fwupd,name,a1)
+#define FU_USDT_PROBE2(name,a1,a2)		DTRACE_PROBE2(fwupd,name,a1,a2)
+#define FU_USDT_PROBE3(name,a1,a2,a3)		DTRACE_PROBE3(fwupd,name,a1,a2,a3)
+#define FU_USDT_PROBE4(name,a1,a2,a3,a4)	DTRACE_PROBE4(fwupd,name,a1,a2,a3,a4)
+#else
+#define FU_USDT_PROBE1(name,a1)			do {} while (0)
+#define FU_USDT_PROBE2(name,a1,a2)		do {} while (0)
+#define FU_USDT_PROBE3(name,a1,a2,a3)		do {} while (0)
+#define FU_USDT_PROBE4(name,a1,a2,a3,a4)	do {} while (0)
+#endif
@@ -38,6 +38,9 @@ enum {
 
 G_DEFINE_TYPE (FuVolume, fu_volume, G_TYPE_OBJECT)
 
+static gint volume_mount_count = 0;
+static gint volume_unmount_count = 0;
+
 static void
 fu_volume_finalize (GObject *obj)
 {
@@ -306,9 +309,41 @@ fu_volume_mount (FuVolume *self, GError **error)
 	if (val == NULL)
 		return FALSE;
 	g_variant_get (val, "(s)", &self->mount_path);
+	g_atomic_int_inc (&volume_mount_count);
 	return TRUE;
 }
 
+/**
+ * fu_volume_get_mount_count:
+ *
+ * Gets the number of times any volume has been mounted, which is useful when
+ * profiling how often the ESP is mounted during a transaction.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.8
+ **/
+guint
+fu_volume_get_mount_count (void)
+{
+	return (guint) g_atomic_int_get (&volume_mount_count);
+}
+
+/**
+ * fu_volume_get_unmount_count:
+ *
+ * Gets the number of times any volume has been unmounted.
+ *
+ * Returns: integer
+ *
+ * Since: 1.5.8
+ **/
+guint
+fu_volume_get_unmount_count (void)
+{
+	return (guint) g_atomic_int_get (&volume_unmount_count);
+}
+
 /**
  * fu_volume_is_internal:
  * @self: a @FuVolume
@@ -391,6 +426,7 @@ fu_volume_unmount (FuVolume *self, GError **error)
 		return FALSE;
 	g_free (self->mount_path);
 	self->mount_path = NULL;
+	g_atomic_int_inc (&volume_unmount_count);
 	return TRUE;
 }
 
@@ -37,3 +37,5 @@ FuDeviceLocker	*fu_volume_locker		(FuVolume	*self,
 						 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 fu_volume_is_internal		(FuVolume	*self);
 gchar		*fu_volume_get_id_type		(FuVolume	*self);
+guint		 fu_volume_get_mount_count	(void);
+guint		 fu_volume_get_unmount_count	(void);
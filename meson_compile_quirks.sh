@@ -0,0 +1,11 @@
+#!/bin/sh
+if [ -z $MESON_INSTALL_PREFIX ]; then
+    echo 'This is meant to be ran from Meson only!'
+    exit 1
+fi
+
+QUIRKS_COMPILE=$1
+PKGDATADIR=$2
+
+echo 'Compiling quirks'
+${QUIRKS_COMPILE} ${PKGDATADIR}
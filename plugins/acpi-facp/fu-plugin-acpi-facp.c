@@ -18,8 +18,6 @@ fu_plugin_init (FuPlugin *plugin)
 void
 fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
-	g_autofree gchar *fn = NULL;
-	g_autofree gchar *path = NULL;
 	g_autoptr(FuAcpiFacp) facp = NULL;
 	g_autoptr(FwupdSecurityAttr) attr = NULL;
 	g_autoptr(GBytes) blob = NULL;
@@ -32,17 +30,15 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	fu_security_attrs_append (attrs, attr);
 
 	/* load FACP table */
-	path = fu_common_get_path (FU_PATH_KIND_ACPI_TABLES);
-	fn = g_build_filename (path, "FACP", NULL);
-	blob = fu_common_get_contents_bytes (fn, &error_local);
+	blob = fu_common_get_acpi_table ("FACP", &error_local);
 	if (blob == NULL) {
-		g_warning ("failed to load %s: %s", fn, error_local->message);
+		g_warning ("%s", error_local->message);
 		fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
 		return;
 	}
 	facp = fu_acpi_facp_new (blob, &error_local);
 	if (facp == NULL) {
-		g_warning ("failed to parse %s: %s", fn, error_local->message);
+		g_warning ("failed to parse FACP: %s", error_local->message);
 		fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
 		return;
 	}
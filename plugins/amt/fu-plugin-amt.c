@@ -442,25 +442,105 @@ amt_get_provisioning_state (mei_context *mei_cl, guint8 *state, GError **error)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(mei_context, mei_context_free)
 #pragma clang diagnostic pop
 
-static FuDevice *
-fu_plugin_amt_create_device (GError **error)
+static const uuid_le MEI_IAMTHIF = UUID_LE(0x12f80028, 0xb4b7, 0x4b2d,  \
+			0xac, 0xa8, 0x46, 0xe0, 0xff, 0x65, 0x81, 0x4c);
+
+/* connecting to the ME is slow, so ask it once and then reuse the replies
+ * until the ME is next reset, which also needs the system to be rebooted */
+static gchar *
+fu_plugin_amt_get_cache_filename (void)
+{
+	g_autofree gchar *cachedir = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedir, "amt", "replies.gvariant", NULL);
+}
+
+static gchar *
+fu_plugin_amt_get_boot_id (void)
+{
+	gsize bufsz = 0;
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *procfs = fu_common_get_path (FU_PATH_KIND_PROCFS);
+	g_autofree gchar *fn = g_build_filename (procfs, "sys", "kernel", "random", "boot_id", NULL);
+	if (!g_file_get_contents (fn, &buf, &bufsz, NULL))
+		return NULL;
+	g_strstrip (buf);
+	if (buf[0] == '\0')
+		return NULL;
+	return g_steal_pointer (&buf);
+}
+
+static gboolean
+fu_plugin_amt_cache_load (struct amt_code_versions *ver, guint8 *state)
+{
+	const gchar *boot_id_cached = NULL;
+	gconstpointer buf;
+	gsize bufsz = 0;
+	g_autofree gchar *boot_id = fu_plugin_amt_get_boot_id ();
+	g_autofree gchar *fn = fu_plugin_amt_get_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariant) ver_val = NULL;
+
+	if (boot_id == NULL)
+		return FALSE;
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return FALSE;
+	blob = fu_common_get_contents_bytes (fn, NULL);
+	if (blob == NULL)
+		return FALSE;
+	val = g_variant_new_from_bytes (G_VARIANT_TYPE ("(sy@ay)"), blob, FALSE);
+	if (!g_variant_is_normal_form (val))
+		return FALSE;
+	g_variant_get (val, "(&sy@ay)", &boot_id_cached, state, &ver_val);
+	if (g_strcmp0 (boot_id, boot_id_cached) != 0)
+		return FALSE;
+	buf = g_variant_get_fixed_array (ver_val, &bufsz, sizeof(guint8));
+	if (bufsz != sizeof(*ver))
+		return FALSE;
+	memcpy (ver, buf, sizeof(*ver));
+
+	/* do not trust the file any more than the ME itself */
+	if (ver->count > AMT_VERSIONS_NUMBER)
+		return FALSE;
+	for (guint32 i = 0; i < ver->count; i++) {
+		if (memchr (ver->versions[i].description.string, '\0', AMT_UNICODE_STRING_LEN) == NULL ||
+		    memchr (ver->versions[i].version.string, '\0', AMT_UNICODE_STRING_LEN) == NULL)
+			return FALSE;
+	}
+	g_debug ("using cached AMT replies from %s", fn);
+	return TRUE;
+}
+
+static void
+fu_plugin_amt_cache_save (const struct amt_code_versions *ver, guint8 state)
+{
+	g_autofree gchar *boot_id = fu_plugin_amt_get_boot_id ();
+	g_autofree gchar *fn = fu_plugin_amt_get_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	if (boot_id == NULL)
+		return;
+	val = g_variant_ref_sink (g_variant_new ("(sy@ay)", boot_id, state,
+						 g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+									    ver, sizeof(*ver),
+									    sizeof(guint8))));
+	blob = g_variant_get_data_as_bytes (val);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !fu_common_set_contents_bytes (fn, blob, &error_local))
+		g_debug ("failed to save AMT replies: %s", error_local->message);
+}
+
+static gboolean
+fu_plugin_amt_query (struct amt_code_versions *ver, guint8 *state, GError **error)
 {
-	guint8 state;
-	struct amt_code_versions ver;
-	fwupd_guid_t uu;
-	g_autofree gchar *guid_buf = NULL;
 	g_autofree struct amt_host_if_resp_header *response = NULL;
-	g_autoptr(FuDevice) dev = NULL;
-	g_autoptr(GString) version_bl = g_string_new (NULL);
-	g_autoptr(GString) version_fw = g_string_new (NULL);
 	g_autoptr(mei_context) ctx = g_new0 (mei_context, 1);
 
-	const uuid_le MEI_IAMTHIF = UUID_LE(0x12f80028, 0xb4b7, 0x4b2d,  \
-				0xac, 0xa8, 0x46, 0xe0, 0xff, 0x65, 0x81, 0x4c);
-
 	/* create context */
 	if (!mei_context_new (ctx, &MEI_IAMTHIF, 0, error))
-		return NULL;
+		return FALSE;
 
 	/* check version */
 	if (!amt_host_if_call (ctx,
@@ -471,13 +551,33 @@ fu_plugin_amt_create_device (GError **error)
 			       5000,
 			       error)) {
 		g_prefix_error (error, "Failed to check version: ");
-		return NULL;
+		return FALSE;
 	}
 	if (!amt_verify_code_versions (response, error)) {
 		g_prefix_error (error, "failed to verify code versions: ");
-		return NULL;
+		return FALSE;
+	}
+	memcpy (ver, response->data, sizeof(struct amt_code_versions));
+	return amt_get_provisioning_state (ctx, state, error);
+}
+
+static FuDevice *
+fu_plugin_amt_create_device (GError **error)
+{
+	guint8 state = 0;
+	struct amt_code_versions ver;
+	fwupd_guid_t uu;
+	g_autofree gchar *guid_buf = NULL;
+	g_autoptr(FuDevice) dev = NULL;
+	g_autoptr(GString) version_bl = g_string_new (NULL);
+	g_autoptr(GString) version_fw = g_string_new (NULL);
+
+	/* use the ME replies from earlier in this boot if possible */
+	if (!fu_plugin_amt_cache_load (&ver, &state)) {
+		if (!fu_plugin_amt_query (&ver, &state, error))
+			return NULL;
+		fu_plugin_amt_cache_save (&ver, state);
 	}
-	memcpy (&ver, response->data, sizeof(struct amt_code_versions));
 
 	dev = fu_device_new ();
 	fu_device_set_id (dev, "/dev/mei0");
@@ -485,8 +585,6 @@ fu_plugin_amt_create_device (GError **error)
 	fu_device_add_flag (dev, FWUPD_DEVICE_FLAG_INTERNAL);
 	fu_device_add_icon (dev, "computer");
 	fu_device_add_parent_guid (dev, "main-system-firmware");
-	if (!amt_get_provisioning_state (ctx, &state, error))
-		return NULL;
 	switch (state) {
 	case 0:
 		fu_device_set_name (dev, "Intel AMT [unprovisioned]");
@@ -505,7 +603,7 @@ fu_plugin_amt_create_device (GError **error)
 				    "out-of-band management");
 
 	/* add guid */
-	memcpy (&uu, &ctx->guid, 16);
+	memcpy (&uu, &MEI_IAMTHIF, 16);
 	guid_buf = fwupd_guid_to_string ((const fwupd_guid_t *) &uu, FWUPD_GUID_FLAG_NONE);
 	fu_device_add_guid (dev, guid_buf);
 
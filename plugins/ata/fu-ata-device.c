@@ -33,6 +33,7 @@ struct ata_tf {
 #define ATA_OP_IDENTIFY			0xec
 #define ATA_OP_FLUSH_CACHE		0xe7
 #define ATA_OP_DOWNLOAD_MICROCODE	0x92
+#define ATA_OP_DOWNLOAD_MICROCODE_DMA	0x93
 #define ATA_OP_STANDBY_IMMEDIATE	0xe0
 
 #define ATA_SUBCMD_MICROCODE_OBSOLETE			0x01
@@ -50,6 +51,7 @@ struct ata_tf {
 #define SG_ATA_PROTO_NON_DATA		(3 << 1)
 #define SG_ATA_PROTO_PIO_IN		(4 << 1)
 #define SG_ATA_PROTO_PIO_OUT		(5 << 1)
+#define SG_ATA_PROTO_DMA		(6 << 1)
 
 enum {
 	SG_CDB2_TLEN_NODATA	= 0 << 0,
@@ -71,6 +73,7 @@ struct _FuAtaDevice {
 	guint			 usb_depth;
 	guint16			 transfer_blocks;
 	guint8			 transfer_mode;
+	gboolean		 download_dma;
 	guint32			 oui;
 };
 
@@ -112,6 +115,7 @@ fu_ata_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuAtaDevice *self = FU_ATA_DEVICE (device);
 	fu_common_string_append_kx (str, idt, "TransferMode", self->transfer_mode);
 	fu_common_string_append_kx (str, idt, "TransferBlocks", self->transfer_blocks);
+	fu_common_string_append_kb (str, idt, "DownloadDma", self->download_dma);
 	if (self->oui != 0x0)
 		fu_common_string_append_kx (str, idt, "OUI", self->oui);
 	fu_common_string_append_ku (str, idt, "PciDepth", self->pci_depth);
@@ -342,6 +346,9 @@ fu_ata_device_parse_id (FuAtaDevice *self, const guint8 *buf, gsize sz, GError *
 		return FALSE;
 	}
 
+	/* DOWNLOAD_MICROCODE_DMA is optional */
+	self->download_dma = (id[69] & (1 << 8)) > 0;
+
 	fu_ata_device_parse_id_maybe_dell (self, id);
 
 	/* firmware will be applied when the device restarts */
@@ -362,7 +369,7 @@ fu_ata_device_parse_id (FuAtaDevice *self, const guint8 *buf, gsize sz, GError *
 	/* fall back to a sane block size */
 	if (self->transfer_blocks == 0x0)
 		self->transfer_blocks = xfer_min;
-	else if (self->transfer_blocks == 0xffff)
+	else if (self->transfer_blocks > xfer_max)
 		self->transfer_blocks = xfer_max;
 
 	/* get values in case the kernel didn't */
@@ -487,8 +494,10 @@ fu_ata_device_command (FuAtaDevice *self, struct ata_tf *tf,
 	guint8 sb[32] = { 0x0 };
 	sg_io_hdr_t io_hdr = { 0x0 };
 
-	/* map _TO_DEV to PIO mode */
-	if (dxfer_direction == SG_DXFER_TO_DEV)
+	/* map _TO_DEV to PIO mode, unless using the DMA variant */
+	if (tf->command == ATA_OP_DOWNLOAD_MICROCODE_DMA)
+		cdb[1] = SG_ATA_PROTO_DMA;
+	else if (dxfer_direction == SG_DXFER_TO_DEV)
 		cdb[1] = SG_ATA_PROTO_PIO_OUT;
 	else if (dxfer_direction == SG_DXFER_FROM_DEV)
 		cdb[1] = SG_ATA_PROTO_PIO_IN;
@@ -668,10 +677,12 @@ fu_ata_device_fw_download (FuAtaDevice *self,
 	struct ata_tf tf = { 0x0 };
 	guint32 block_count = data_sz / FU_ATA_BLOCK_SIZE;
 	guint32 buffer_offset = addr / FU_ATA_BLOCK_SIZE;
+	g_autoptr(GError) error_local = NULL;
 
 	/* write block */
 	tf.dev = 0xa0 | ATA_USING_LBA;
-	tf.command = ATA_OP_DOWNLOAD_MICROCODE;
+	tf.command = self->download_dma ? ATA_OP_DOWNLOAD_MICROCODE_DMA :
+					  ATA_OP_DOWNLOAD_MICROCODE;
 	tf.feat = self->transfer_mode;
 	tf.nsect = block_count & 0xff;
 	tf.lbal = block_count >> 8;
@@ -679,10 +690,21 @@ fu_ata_device_fw_download (FuAtaDevice *self,
 	tf.lbah = buffer_offset >> 8;
 	if (!fu_ata_device_command (self, &tf, SG_DXFER_TO_DEV,
 				    120 * 1000, /* a long time! */
-				    (guint8 *) data, data_sz, error)) {
-		g_prefix_error (error, "failed to write firmware @0x%0x: ",
-				(guint) addr);
-		return FALSE;
+				    (guint8 *) data, data_sz, &error_local)) {
+		if (tf.command != ATA_OP_DOWNLOAD_MICROCODE_DMA) {
+			g_propagate_prefixed_error (error,
+						    g_steal_pointer (&error_local),
+						    "failed to write firmware @0x%0x: ",
+						    (guint) addr);
+			return FALSE;
+		}
+
+		/* the same segment can be resent using PIO mode */
+		g_debug ("DOWNLOAD_MICROCODE_DMA failed, using PIO: %s",
+			 error_local->message);
+		self->download_dma = FALSE;
+		return fu_ata_device_fw_download (self, idx, addr,
+						  data, data_sz, error);
 	}
 
 	/* check drive status */
@@ -34,12 +34,14 @@
 #include "fu-bcm57xx-dict-image.h"
 
 #define FU_BCM57XX_BLOCK_SZ		0x4000 /* 16kb */
+#define FU_BCM57XX_TRANSFER_SZ_MAX	0x80000 /* 512kb */
 
 struct _FuBcm57xxDevice {
 	FuUdevDevice		 parent_instance;
 	FuBcm57xxRecoveryDevice	*recovery;
 	gchar			*ethtool_iface;
 	int			 ethtool_fd;
+	gsize			 transfer_sz;
 };
 
 G_DEFINE_TYPE (FuBcm57xxDevice, fu_bcm57xx_device, FU_TYPE_UDEV_DEVICE)
@@ -50,6 +52,7 @@ fu_bcm57xx_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuBcm57xxDevice *self = FU_BCM57XX_DEVICE (device);
 	FU_DEVICE_CLASS (fu_bcm57xx_device_parent_class)->to_string (device, idt, str);
 	fu_common_string_append_kv (str, idt, "EthtoolIface", self->ethtool_iface);
+	fu_common_string_append_kx (str, idt, "TransferSize", self->transfer_sz);
 }
 
 static gboolean
@@ -241,6 +244,50 @@ fu_bcm57xx_device_nvram_read (FuBcm57xxDevice *self,
 #endif
 }
 
+/* use the largest request the driver accepts, shrinking on failure */
+static gboolean
+fu_bcm57xx_device_nvram_transfer (FuBcm57xxDevice *self,
+				  guint8 *buf,
+				  gsize bufsz,
+				  gboolean write,
+				  GError **error)
+{
+	FuDevice *device = FU_DEVICE (self);
+	gsize offset = 0;
+
+	while (offset < bufsz) {
+		gboolean ret;
+		gsize chunksz = MIN (self->transfer_sz, bufsz - offset);
+		g_autoptr(GError) error_local = NULL;
+
+		if (write) {
+			ret = fu_bcm57xx_device_nvram_write (self, offset,
+							     buf + offset, chunksz,
+							     &error_local);
+		} else {
+			ret = fu_bcm57xx_device_nvram_read (self, offset,
+							    buf + offset, chunksz,
+							    &error_local);
+		}
+		if (!ret) {
+			if (self->transfer_sz <= FU_BCM57XX_BLOCK_SZ) {
+				g_propagate_error (error, g_steal_pointer (&error_local));
+				return FALSE;
+			}
+			self->transfer_sz /= 2;
+			g_debug ("%s, retrying with 0x%x bytes",
+				 error_local->message,
+				 (guint) self->transfer_sz);
+			continue;
+		}
+		offset += chunksz;
+		fu_device_set_progress_full (device, offset, bufsz);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static gboolean
 fu_bcm57xx_device_nvram_check (FuBcm57xxDevice *self, GError **error)
 {
@@ -342,24 +389,25 @@ fu_bcm57xx_device_dump_firmware (FuDevice *device, GError **error)
 	FuBcm57xxDevice *self = FU_BCM57XX_DEVICE (device);
 	const gsize bufsz = fu_device_get_firmware_size_max (FU_DEVICE (self));
 	g_autofree guint8 *buf = g_malloc0 (bufsz);
-	g_autoptr(GPtrArray) chunks = NULL;
 
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_READ);
-	chunks = fu_chunk_array_mutable_new (buf, bufsz, 0x0, 0x0, FU_BCM57XX_BLOCK_SZ);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_bcm57xx_device_nvram_read (self, fu_chunk_get_address (chk),
-						   fu_chunk_get_data_out (chk),
-						   fu_chunk_get_data_sz (chk),
-						   error))
-			return NULL;
-		fu_device_set_progress_full (device, i, chunks->len - 1);
-	}
+	if (!fu_bcm57xx_device_nvram_transfer (self, buf, bufsz, FALSE, error))
+		return NULL;
 
 	/* read from hardware */
 	return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
 }
 
+static GBytes *
+fu_bcm57xx_device_read_block (FuDevice *device, guint32 address, gsize bufsz, GError **error)
+{
+	FuBcm57xxDevice *self = FU_BCM57XX_DEVICE (device);
+	g_autofree guint8 *buf = g_malloc0 (bufsz);
+	if (!fu_bcm57xx_device_nvram_read (self, address, buf, bufsz, error))
+		return NULL;
+	return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
+}
+
 static FuFirmware *
 fu_bcm57xx_device_read_firmware (FuDevice *device, GError **error)
 {
@@ -472,9 +520,37 @@ fu_bcm57xx_device_write_firmware (FuDevice *device,
 				  GError **error)
 {
 	FuBcm57xxDevice *self = FU_BCM57XX_DEVICE (device);
+	GPtrArray *chunks_dirty = fu_device_get_dirty_chunks (device);
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GBytes) blob_verify = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
+
+	/* only the blocks that differ from the NVRAM contents */
+	if (chunks_dirty != NULL) {
+		fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+		for (guint i = 0; i < chunks_dirty->len; i++) {
+			FuChunk *chk = g_ptr_array_index (chunks_dirty, i);
+			g_autoptr(GBytes) blob_tmp = NULL;
+			if (!fu_bcm57xx_device_nvram_write (self, fu_chunk_get_address (chk),
+							    fu_chunk_get_data (chk),
+							    fu_chunk_get_data_sz (chk),
+							    error))
+				return FALSE;
+			blob_tmp = fu_bcm57xx_device_read_block (device,
+								 fu_chunk_get_address (chk),
+								 fu_chunk_get_data_sz (chk),
+								 error);
+			if (blob_tmp == NULL)
+				return FALSE;
+			if (!fu_common_bytes_compare_raw (fu_chunk_get_data (chk),
+							  fu_chunk_get_data_sz (chk),
+							  g_bytes_get_data (blob_tmp, NULL),
+							  g_bytes_get_size (blob_tmp),
+							  error))
+				return FALSE;
+			fu_device_set_progress_full (device, i + 1, chunks_dirty->len);
+		}
+		return fu_device_activate (device, error);
+	}
 
 	/* build the images into one linear blob of the correct size */
 	fu_device_set_status (device, FWUPD_STATUS_DECOMPRESSING);
@@ -484,16 +560,11 @@ fu_bcm57xx_device_write_firmware (FuDevice *device,
 
 	/* hit hardware */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	chunks = fu_chunk_array_new_from_bytes (blob, 0x0, 0x0, FU_BCM57XX_BLOCK_SZ);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_bcm57xx_device_nvram_write (self, fu_chunk_get_address (chk),
-						    fu_chunk_get_data (chk),
-						    fu_chunk_get_data_sz (chk),
-						    error))
-			return FALSE;
-		fu_device_set_progress_full (device, i, chunks->len - 1);
-	}
+	if (!fu_bcm57xx_device_nvram_transfer (self,
+					       (guint8 *) g_bytes_get_data (blob, NULL),
+					       g_bytes_get_size (blob),
+					       TRUE, error))
+		return FALSE;
 
 	/* verify */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_VERIFY);
@@ -617,6 +688,9 @@ fu_bcm57xx_device_init (FuBcm57xxDevice *self)
 
 	/* other values are set from a quirk */
 	fu_device_set_firmware_size (FU_DEVICE (self), BCM_FIRMWARE_SIZE);
+	fu_device_set_firmware_block_size (FU_DEVICE (self), FU_BCM57XX_BLOCK_SZ);
+	fu_device_add_internal_flag (FU_DEVICE (self), FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED);
+	self->transfer_sz = FU_BCM57XX_TRANSFER_SZ_MAX;
 
 	/* used for recovery in case of ethtool failure and for APE reset */
 	self->recovery = fu_bcm57xx_recovery_device_new ();
@@ -645,6 +719,7 @@ fu_bcm57xx_device_class_init (FuBcm57xxDeviceClass *klass)
 	klass_device->write_firmware = fu_bcm57xx_device_write_firmware;
 	klass_device->read_firmware = fu_bcm57xx_device_read_firmware;
 	klass_device->dump_firmware = fu_bcm57xx_device_dump_firmware;
+	klass_device->read_block = fu_bcm57xx_device_read_block;
 	klass_device->probe = fu_bcm57xx_device_probe;
 	klass_device->to_string = fu_bcm57xx_device_to_string;
 }
@@ -133,7 +133,7 @@ fu_bcm57xx_firmware_parse_stage1 (FuBcm57xxFirmware *self,
 	blob = fu_common_bytes_new_offset (fw, stage1_off, stage1_sz, error);
 	if (blob == NULL)
 		return NULL;
-	if (!fu_firmware_image_parse (img, blob, flags, error))
+	if (!fu_firmware_parse_image (FU_FIRMWARE (self), img, blob, flags, error))
 		return NULL;
 
 	/* needed for stage2 */
@@ -179,7 +179,7 @@ fu_bcm57xx_firmware_parse_stage2 (FuBcm57xxFirmware *self,
 	blob = fu_common_bytes_new_offset (fw, stage2_off + 0x8, stage2_sz, error);
 	if (blob == NULL)
 		return NULL;
-	if (!fu_firmware_image_parse (img, blob, flags, error))
+	if (!fu_firmware_parse_image (FU_FIRMWARE (self), img, blob, flags, error))
 		return NULL;
 
 	/* success */
@@ -247,7 +247,7 @@ fu_bcm57xx_firmware_parse_dict (FuBcm57xxFirmware *self, GBytes *fw, guint idx,
 	blob = fu_common_bytes_new_offset (fw, dict_off, dict_sz, error);
 	if (blob == NULL)
 		return FALSE;
-	if (!fu_firmware_image_parse (img, blob, flags, error))
+	if (!fu_firmware_parse_image (FU_FIRMWARE (self), img, blob, flags, error))
 		return FALSE;
 
 	/* success */
@@ -28,6 +28,15 @@ struct _FuCcgxDmcDevice {
 
 G_DEFINE_TYPE (FuCcgxDmcDevice, fu_ccgx_dmc_device, FU_TYPE_USB_DEVICE)
 
+/* the bulk-out of the next row is in flight while the previous is programmed */
+typedef struct {
+	GMainLoop		*loop;
+	GCancellable		*cancellable;
+	GError			*error;
+	gsize			 row_size;
+	gboolean		 pending;
+} FuCcgxDmcDeviceRowHelper;
+
 static gboolean
 fu_ccgx_dmc_device_get_dock_id (FuCcgxDmcDevice *self,
 				DmcDockIdentity *dock_id,
@@ -271,26 +280,61 @@ fu_ccgx_dmc_device_send_write_command (FuCcgxDmcDevice *self,
 	return TRUE;
 }
 
-static gboolean
+static void
+fu_ccgx_dmc_device_send_row_data_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuCcgxDmcDeviceRowHelper *helper = (FuCcgxDmcDeviceRowHelper *) user_data;
+	gssize actual;
+	g_autoptr(GError) error_local = NULL;
+
+	actual = g_usb_device_bulk_transfer_finish (G_USB_DEVICE (source), res, &error_local);
+	if (actual < 0) {
+		g_propagate_prefixed_error (&helper->error,
+					    g_steal_pointer (&error_local),
+					    "write row data error: ");
+	} else if ((gsize) actual != helper->row_size) {
+		g_set_error (&helper->error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "write row data error: only wrote %" G_GSSIZE_FORMAT " bytes",
+			     actual);
+	}
+	helper->pending = FALSE;
+	g_main_loop_quit (helper->loop);
+}
+
+static void
 fu_ccgx_dmc_device_send_row_data (FuCcgxDmcDevice *self,
-				  const guint8 *row_buffer,
-				  guint16 row_size,
-				  GError **error)
+				  FuCcgxDmcDeviceRowHelper *helper,
+				  GBytes *data_rcd)
+{
+	gsize row_size = 0;
+	const guint8 *row_buffer = g_bytes_get_data (data_rcd, &row_size);
+
+	/* OUT transfers never write to the buffer */
+	helper->row_size = row_size;
+	helper->pending = TRUE;
+	g_usb_device_bulk_transfer_async (fu_usb_device_get_dev (FU_USB_DEVICE (self)),
+					  self->ep_bulk_out,
+					  (guint8 *) row_buffer, row_size,
+					  DMC_BULK_OUT_PIPE_TIMEOUT,
+					  helper->cancellable,
+					  fu_ccgx_dmc_device_send_row_data_cb,
+					  helper);
+}
+
+static gboolean
+fu_ccgx_dmc_device_wait_row_data (FuCcgxDmcDeviceRowHelper *helper, GError **error)
 {
-	g_return_val_if_fail (row_buffer != NULL, FALSE);
-
-	if (!g_usb_device_bulk_transfer (fu_usb_device_get_dev (FU_USB_DEVICE (self)),
-					 self->ep_bulk_out,
-					 (guint8 *)row_buffer, row_size, NULL,
-					 DMC_BULK_OUT_PIPE_TIMEOUT,
-					 NULL, error)) {
-		g_prefix_error (error, "write row data error: ");
+	if (helper->pending)
+		g_main_loop_run (helper->loop);
+	if (helper->error != NULL) {
+		g_propagate_error (error, g_steal_pointer (&helper->error));
 		return FALSE;
 	}
 	return TRUE;
 }
 
-
 static void
 fu_ccgx_dmc_device_to_string (FuDevice *device, guint idt, GString *str)
 {
@@ -337,6 +381,46 @@ fu_ccgx_dmc_get_image_write_status_cb (FuDevice *device, gpointer user_data, GEr
 	return TRUE;
 }
 
+static gboolean
+fu_ccgx_dmc_write_firmware_rows (FuCcgxDmcDevice *self,
+				 FuCcgxDmcDeviceRowHelper *helper,
+				 GPtrArray *data_records,
+				 gsize *fw_data_written,
+				 const gsize fw_data_size,
+				 GError **error)
+{
+	if (data_records->len == 0)
+		return TRUE;
+
+	/* send the next row while the device is busy writing this one, and
+	 * rely on the endpoint NAKing until it has space */
+	fu_ccgx_dmc_device_send_row_data (self, helper, g_ptr_array_index (data_records, 0));
+	for (guint32 data_index = 0; data_index < data_records->len; data_index++) {
+		GBytes *data_rcd = g_ptr_array_index (data_records, data_index);
+
+		/* write row data */
+		if (!fu_ccgx_dmc_device_wait_row_data (helper, error))
+			return FALSE;
+		if (data_index + 1 < data_records->len) {
+			fu_ccgx_dmc_device_send_row_data (self, helper,
+							  g_ptr_array_index (data_records,
+									     data_index + 1));
+		}
+
+		/* get status */
+		if (!fu_device_retry (FU_DEVICE (self),
+				      fu_ccgx_dmc_get_image_write_status_cb,
+				      DMC_FW_WRITE_STATUS_RETRY_COUNT,
+				      NULL, error))
+			return FALSE;
+
+		/* increase fw written size */
+		*fw_data_written += g_bytes_get_size (data_rcd);
+		fu_device_set_progress_full (FU_DEVICE (self), *fw_data_written, fw_data_size);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_ccgx_dmc_write_firmware_image (FuDevice *device,
 				  FuCcgxDmcFirmwareImageRecord *img_rcd,
@@ -346,6 +430,13 @@ fu_ccgx_dmc_write_firmware_image (FuDevice *device,
 {
 	FuCcgxDmcDevice *self = FU_CCGX_DMC_DEVICE (device);
 	GPtrArray *seg_records;
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	FuCcgxDmcDeviceRowHelper helper = {
+		.loop		= loop,
+		.cancellable	= cancellable,
+	};
 
 	g_return_val_if_fail (img_rcd != NULL, FALSE);
 	g_return_val_if_fail (fw_data_written != NULL, FALSE);
@@ -353,8 +444,8 @@ fu_ccgx_dmc_write_firmware_image (FuDevice *device,
 	/* get segment records */
 	seg_records = img_rcd->seg_records;
 	for (guint32 seg_index = 0; seg_index < seg_records->len; seg_index++) {
-		GPtrArray *data_records = NULL;
 		FuCcgxDmcFirmwareSegmentRecord *seg_rcd = g_ptr_array_index (seg_records, seg_index);
+		gboolean ret;
 
 		/* write start row and number of rows to a device */
 		if (!fu_ccgx_dmc_device_send_write_command (self,
@@ -363,32 +454,21 @@ fu_ccgx_dmc_write_firmware_image (FuDevice *device,
 							    error))
 			return FALSE;
 
-		/* get data records */
-		data_records = seg_rcd->data_records;
-		for (guint32 data_index = 0; data_index < data_records->len; data_index++) {
-			GBytes *data_rcd = g_ptr_array_index (data_records, data_index);
-			const guint8 *row_buffer = NULL;
-			gsize row_size = 0;
-
-			/* write row data */
-			row_buffer = g_bytes_get_data (data_rcd, &row_size);
-			if (!fu_ccgx_dmc_device_send_row_data (self,
-							       row_buffer,
-							       (guint16) row_size,
-							       error))
-				return FALSE;
-
-			/* increase fw written size */
-			*fw_data_written += row_size;
-			fu_device_set_progress_full (device, *fw_data_written, fw_data_size);
-
-			/* get status */
-			if (!fu_device_retry (FU_DEVICE (self),
-					      fu_ccgx_dmc_get_image_write_status_cb,
-					      DMC_FW_WRITE_STATUS_RETRY_COUNT,
-					      NULL, error))
-				return FALSE;
+		/* write data records */
+		g_main_context_push_thread_default (context);
+		ret = fu_ccgx_dmc_write_firmware_rows (self, &helper,
+						       seg_rcd->data_records,
+						       fw_data_written,
+						       fw_data_size,
+						       error);
+		if (helper.pending) {
+			g_cancellable_cancel (cancellable);
+			g_main_loop_run (loop);
 		}
+		g_main_context_pop_thread_default (context);
+		g_clear_error (&helper.error);
+		if (!ret)
+			return FALSE;
 	}
 	return TRUE;
 }
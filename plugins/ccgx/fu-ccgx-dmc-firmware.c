@@ -83,15 +83,16 @@ fu_ccgx_dmc_firmware_to_string (FuFirmware *firmware, guint idt, GString *str)
 
 static gboolean
 fu_ccgx_dmc_firmware_parse_segment (FuFirmware *firmware,
-				    const guint8 *buf,
-				    gsize bufsz,
+				    GBytes *fw,
 				    FuCcgxDmcFirmwareImageRecord *img_rcd,
 				    gsize *seg_off,
 				    FwupdInstallFlags flags,
 				    GError **error)
 {
 	FuCcgxDmcFirmware *self = FU_CCGX_DMC_FIRMWARE (firmware);
+	gsize bufsz = 0;
 	gsize row_off;
+	const guint8 *buf = g_bytes_get_data (fw, &bufsz);
 	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA256);
 
 	/* set row data offset in current image */
@@ -101,7 +102,6 @@ fu_ccgx_dmc_firmware_parse_segment (FuFirmware *firmware,
 	img_rcd->seg_records = g_ptr_array_new_with_free_func ((GFreeFunc) fu_ccgx_dmc_firmware_segment_record_free);
 	for (guint32 i = 0; i < img_rcd->num_img_segments; i++) {
 		guint16 row_size_bytes = 0;
-		g_autofree guint8 *row_buf = NULL;
 		g_autoptr(FuCcgxDmcFirmwareSegmentRecord) seg_rcd = NULL;
 
 		/* read segment info  */
@@ -121,24 +121,21 @@ fu_ccgx_dmc_firmware_parse_segment (FuFirmware *firmware,
 		/* create data record array in segment record */
 		seg_rcd->data_records = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
 
-		/* read row data in segment */
-		row_buf = g_malloc0 (row_size_bytes);
+		/* read row data in segment, referencing rather than copying */
 		for (int row = 0; row < seg_rcd->num_rows; row++) {
 			g_autoptr(GBytes) data_rcd = NULL;
 
 			/* read row data */
-			if (!fu_memcpy_safe (row_buf, row_size_bytes, 0x0,	/* dst */
-					     buf, bufsz, row_off,		/* src */
-					     row_size_bytes, error)) {
+			data_rcd = fu_common_bytes_new_offset (fw, row_off, row_size_bytes, error);
+			if (data_rcd == NULL) {
 				g_prefix_error (error, "failed to read row data: ");
 				return FALSE;
 			}
 
 			/* update hash */
-			g_checksum_update (csum, (guchar *) row_buf, row_size_bytes);
+			g_checksum_update (csum, (const guchar *) buf + row_off, row_size_bytes);
 
 			/* add row data to data record */
-			data_rcd = g_bytes_new (row_buf, row_size_bytes);
 			g_ptr_array_add (seg_rcd->data_records, g_steal_pointer (&data_rcd));
 
 			/* increment row data offset */
@@ -173,12 +170,13 @@ fu_ccgx_dmc_firmware_parse_segment (FuFirmware *firmware,
 static gboolean
 fu_ccgx_dmc_firmware_parse_image (FuFirmware *firmware,
 				  guint8 image_count,
-				  const guint8 *buf,
-				  gsize bufsz,
+				  GBytes *fw,
 				  FwupdInstallFlags flags,
 				  GError **error)
 {
 	FuCcgxDmcFirmware *self = FU_CCGX_DMC_FIRMWARE (firmware);
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (fw, &bufsz);
 	gsize img_off = sizeof(FwctInfo);
 	gsize seg_off = sizeof(FwctInfo) + image_count * sizeof(FwctImageInfo);
 
@@ -224,7 +222,7 @@ fu_ccgx_dmc_firmware_parse_image (FuFirmware *firmware,
 			return FALSE;
 
 		/* parse segment */
-		if (!fu_ccgx_dmc_firmware_parse_segment (firmware, buf, bufsz, img_rcd,
+		if (!fu_ccgx_dmc_firmware_parse_segment (firmware, fw, img_rcd,
 							 &seg_off, flags, error))
 			return FALSE;
 
@@ -330,7 +328,7 @@ fu_ccgx_dmc_firmware_parse (FuFirmware *firmware,
 					&hdr_image_count, error))
 		return FALSE;
 	if (!fu_ccgx_dmc_firmware_parse_image (firmware, hdr_image_count,
-					       buf, bufsz, flags, error))
+					       fw, flags, error))
 		return FALSE;
 
 	/* add something, although we'll use the records for the update */
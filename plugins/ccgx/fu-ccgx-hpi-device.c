@@ -86,6 +86,7 @@ typedef struct {
 	guint16			 addr;
 	const guint8		*buf;
 	gsize			 bufsz;
+	gboolean		 clear_events;
 } FuCcgxHpiFlashWriteRetryHelper;
 
 typedef struct {
@@ -875,10 +876,15 @@ fu_ccgx_hpi_write_flash_cb (FuDevice *device, gpointer user_data, GError **error
 		helper->addr >> 8,
 	};
 
-	if (!fu_ccgx_hpi_device_clear_all_events (self,
-						  HPI_CMD_COMMAND_CLEAR_EVENT_TIME_MS,
-						  error))
-		return FALSE;
+	/* the previous row consumed its own response, so only wait for stray
+	 * events on the first row or when retrying */
+	if (helper->clear_events) {
+		if (!fu_ccgx_hpi_device_clear_all_events (self,
+							  HPI_CMD_COMMAND_CLEAR_EVENT_TIME_MS,
+							  error))
+			return FALSE;
+	}
+	helper->clear_events = TRUE;
 
 	/* write data to memory */
 	addr_tmp = self->hpi_addrsz > 1 ? HPI_DEV_REG_FLASH_MEM : CY_PD_REG_BOOTDATA_MEMORY_ADDR;
@@ -918,12 +924,14 @@ fu_ccgx_hpi_write_flash (FuCcgxHpiDevice *self,
 			 guint16 addr,
 			 const guint8 *buf,
 			 guint16 bufsz,
+			 gboolean clear_events,
 			 GError **error)
 {
 	FuCcgxHpiFlashWriteRetryHelper helper = {
 		.addr = addr,
 		.buf = buf,
 		.bufsz = bufsz,
+		.clear_events = clear_events,
 	};
 	return fu_device_retry (FU_DEVICE (self),
 			        fu_ccgx_hpi_write_flash_cb,
@@ -1214,7 +1222,7 @@ fu_ccgx_hpi_save_metadata (FuCcgxHpiDevice *self,
 		return FALSE;
 	if (!fu_ccgx_hpi_write_flash (self, addr,
 				      buf, self->flash_row_size,
-				      error)) {
+				      TRUE, error)) {
 		g_prefix_error (error, "fw metadata write error: ");
 		return FALSE;
 	}
@@ -1259,7 +1267,7 @@ fu_ccgx_hpi_write_firmware (FuDevice *device,
 		if (!fu_ccgx_hpi_write_flash (self, rcd->row_number,
 					      g_bytes_get_data (rcd->data, NULL),
 					      g_bytes_get_size (rcd->data),
-					      error)) {
+					      i == 0, error)) {
 			g_prefix_error (error, "fw write error @0x%x: ", rcd->row_number);
 			return FALSE;
 		}
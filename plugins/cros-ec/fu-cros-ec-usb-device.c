@@ -21,6 +21,7 @@
 #define FLUSH_TIMEOUT_MS		10
 #define BULK_SEND_TIMEOUT_MS		2000
 #define BULK_RECV_TIMEOUT_MS		5000
+#define BULK_SEND_MAX_IN_FLIGHT		4
 #define CROS_EC_REMOVE_DELAY_RE_ENUMERATE              20000
 
 #define UPDATE_DONE			0xB007AB1E
@@ -518,24 +519,21 @@ fu_cros_ec_usb_device_transfer_block (FuDevice *device, gpointer user_data,
 		return FALSE;
 	}
 
-	/* send the block, chunk by chunk */
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
+	/* send the block, keeping several chunks queued */
+	if (!fu_usb_device_write_chunks (FU_USB_DEVICE (self),
+					 self->ep_num,
+					 chunks,
+					 BULK_SEND_MAX_IN_FLIGHT,
+					 BULK_SEND_TIMEOUT_MS,
+					 FU_USB_DEVICE_TRANSFER_FLAG_NONE,
+					 error)) {
+		g_prefix_error (error, "failed at sending chunk: ");
 
-		if (!fu_cros_ec_usb_device_do_xfer (self,
-						    fu_chunk_get_data (chk),
-						    fu_chunk_get_data_sz (chk),
-						    NULL,
-						    0, FALSE,
-						    NULL, error)) {
-			g_prefix_error (error, "failed at sending chunk: ");
-
-			/* flush all data from endpoint to recover in case of error */
-			if (!fu_cros_ec_usb_device_recovery (device, NULL)) {
-				g_debug ("failed to flush to idle");
-			}
-			return FALSE;
+		/* flush all data from endpoint to recover in case of error */
+		if (!fu_cros_ec_usb_device_recovery (device, NULL)) {
+			g_debug ("failed to flush to idle");
 		}
+		return FALSE;
 	}
 
 	/* get the reply */
@@ -646,6 +644,20 @@ fu_cros_ec_usb_device_transfer_section (FuDevice *device,
 	return TRUE;
 }
 
+/* the writeable region already runs this exact build */
+static gboolean
+fu_cros_ec_usb_device_section_is_current (FuCrosEcUsbDevice *self,
+					  FuCrosEcFirmwareSection *section)
+{
+	if (section->version.dirty || self->version.dirty)
+		return FALSE;
+	if (g_strcmp0 (section->version.boardname, self->version.boardname) != 0)
+		return FALSE;
+	if (g_strcmp0 (section->version.triplet, self->version.triplet) != 0)
+		return FALSE;
+	return g_strcmp0 (section->version.sha1, self->version.sha1) == 0;
+}
+
 static void
 fu_cros_ec_usb_device_send_done (FuDevice *device)
 {
@@ -802,10 +814,15 @@ fu_cros_ec_usb_device_write_firmware (FuDevice *device,
 		FuCrosEcFirmwareSection *section = g_ptr_array_index (sections, i);
 
 		if (section->ustatus == FU_CROS_EC_FW_NEEDED) {
-			if (!fu_cros_ec_usb_device_transfer_section (device,
-								     firmware,
-								     section,
-								     error)) {
+			/* still counted so the RO/RW sequence carries on */
+			if ((flags & FWUPD_INSTALL_FLAG_FORCE) == 0 &&
+			    fu_cros_ec_usb_device_section_is_current (self, section)) {
+				g_debug ("section %s already has %s, skipping",
+					 section->name, section->raw_version);
+			} else if (!fu_cros_ec_usb_device_transfer_section (device,
+									    firmware,
+									    section,
+									    error)) {
 				return FALSE;
 			}
 			num_txed_sections++;
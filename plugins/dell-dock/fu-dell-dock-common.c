@@ -57,6 +57,22 @@ fu_dell_dock_will_replug (FuDevice *device)
 	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
 }
 
+/* the new firmware is only used after the single dock reboot done when the
+ * whole transaction has been written */
+void
+fu_dell_dock_stage_for_reboot (FuDevice *device)
+{
+	FuDevice *parent;
+
+	g_return_if_fail (FU_IS_DEVICE (device));
+
+	parent = FU_IS_DELL_DOCK_EC (device) ? device : fu_device_get_parent (device);
+	if (parent == NULL || !FU_IS_DELL_DOCK_EC (parent))
+		return;
+	g_debug ("staged %s for dock reboot", fu_device_get_name (device));
+	fu_dell_dock_ec_set_staged (parent, TRUE);
+}
+
 void
 fu_dell_dock_clone_updatable (FuDevice *device)
 {
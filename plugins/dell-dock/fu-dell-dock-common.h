@@ -33,5 +33,6 @@ gboolean	fu_dell_dock_set_power		(FuDevice *device,
 						 gboolean enabled,
 						 GError **error);
 void		 fu_dell_dock_will_replug	(FuDevice *device);
+void		 fu_dell_dock_stage_for_reboot	(FuDevice *device);
 
 void		 fu_dell_dock_clone_updatable	(FuDevice *device);
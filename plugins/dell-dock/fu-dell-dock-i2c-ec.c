@@ -144,6 +144,7 @@ struct _FuDellDockEc {
 	gchar				*ec_minimum_version;
 	guint64				 blob_version_offset;
 	guint8				 passive_flow;
+	gboolean			 staged;
 	guint32				 dock_unlock_status;
 };
 
@@ -666,6 +667,21 @@ fu_dell_dock_ec_reboot_dock (FuDevice *device, GError **error)
 	return fu_dell_dock_ec_write (device, 3, (guint8 *) &cmd, error);
 }
 
+/* a component has been written and is waiting for the dock reboot */
+void
+fu_dell_dock_ec_set_staged (FuDevice *device, gboolean staged)
+{
+	FuDellDockEc *self = FU_DELL_DOCK_EC (device);
+	self->staged = staged;
+}
+
+gboolean
+fu_dell_dock_ec_get_staged (FuDevice *device)
+{
+	FuDellDockEc *self = FU_DELL_DOCK_EC (device);
+	return self->staged;
+}
+
 static gboolean
 fu_dell_dock_get_ec_status (FuDevice *device,
 			    FuDellDockECFWUpdateStatus *status_out,
@@ -819,6 +835,7 @@ fu_dell_dock_ec_write_fw (FuDevice *device,
 	/* activate passive behavior */
 	self->passive_flow |= PASSIVE_RESET_MASK;
 	fu_device_add_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
+	fu_dell_dock_stage_for_reboot (device);
 	return TRUE;
 }
 
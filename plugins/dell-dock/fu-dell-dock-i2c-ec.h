@@ -34,6 +34,9 @@ gboolean	 fu_dell_dock_ec_modify_lock		(FuDevice *self,
 
 gboolean	fu_dell_dock_ec_reboot_dock		(FuDevice *device,
 							 GError **error);
+void		 fu_dell_dock_ec_set_staged		(FuDevice *device,
+							 gboolean staged);
+gboolean	 fu_dell_dock_ec_get_staged		(FuDevice *device);
 
 const gchar	*fu_dell_dock_ec_get_mst_version	(FuDevice *device);
 const gchar	*fu_dell_dock_ec_get_tbt_version	(FuDevice *device);
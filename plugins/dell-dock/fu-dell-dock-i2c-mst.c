@@ -844,6 +844,7 @@ fu_dell_dock_mst_write_fw (FuDevice *device,
 
 	/* dock will reboot to re-read; this is to appease the daemon */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_RESTART);
+	fu_dell_dock_stage_for_reboot (device);
 	fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
 	fu_device_set_version (device, dynamic_version);
 
@@ -202,9 +202,11 @@ fu_plugin_composite_cleanup (FuPlugin *plugin,
 	FuDevice *dev = NULL;
 	g_autoptr(FuDeviceLocker) locker = NULL;
 	gboolean needs_activation = FALSE;
+	gboolean needs_reboot;
 
 	if (parent == NULL)
 		return TRUE;
+	needs_reboot = fu_dell_dock_ec_get_staged (parent);
 
 	/* if thunderbolt is in the transaction it needs to be activated separately */
 	for (guint i = 0; i < devices->len; i++) {
@@ -214,6 +216,7 @@ fu_plugin_composite_cleanup (FuPlugin *plugin,
 			/* the kernel and/or thunderbolt plugin have been configured to let HW finish the update */
 			if (fu_device_has_flag (dev, FWUPD_DEVICE_FLAG_USABLE_DURING_UPDATE)) {
 				fu_dell_dock_ec_tbt_passive (parent);
+				needs_reboot = TRUE;
 			/* run the update immediately - no kernel support */
 			} else {
 				needs_activation = TRUE;
@@ -222,12 +225,19 @@ fu_plugin_composite_cleanup (FuPlugin *plugin,
 		}
 	}
 
+	/* every component is staged, so nothing is used until this one reboot */
+	if (!needs_reboot && !needs_activation) {
+		g_debug ("no dock components written, skipping reboot");
+		return TRUE;
+	}
+
 	locker = fu_device_locker_new (parent, error);
 	if (locker == NULL)
 		return FALSE;
 
 	if (!fu_dell_dock_ec_reboot_dock (parent, error))
 		return FALSE;
+	fu_dell_dock_ec_set_staged (parent, FALSE);
 
 	/* close this first so we don't have an error from the thunderbolt activation */
 	if (!fu_device_locker_close (locker, error))
@@ -104,6 +104,7 @@ typedef struct {
 	guint16			 transfer_size;
 	guint8			 iface_number;
 	guint			 dnload_timeout;
+	gint64			 dnload_timeout_start;	/* monotonic, us */
 	guint			 timeout_ms;
 } FuDfuDevicePrivate;
 
@@ -190,6 +191,27 @@ fu_dfu_device_get_download_timeout (FuDfuDevice *self)
 	return priv->dnload_timeout;
 }
 
+/**
+ * fu_dfu_device_wait_download_timeout:
+ * @self: a #FuDfuDevice
+ *
+ * Waits for the poll timeout returned by the last GetStatus request, minus
+ * any time that has already elapsed since the device replied.
+ **/
+void
+fu_dfu_device_wait_download_timeout (FuDfuDevice *self)
+{
+	FuDfuDevicePrivate *priv = GET_PRIVATE (self);
+	gint64 elapsed;
+
+	g_return_if_fail (FU_IS_DFU_DEVICE (self));
+
+	elapsed = g_get_monotonic_time () - priv->dnload_timeout_start;
+	if (elapsed < 0 || elapsed >= (gint64) priv->dnload_timeout * 1000)
+		return;
+	g_usleep (((gint64) priv->dnload_timeout * 1000) - elapsed);
+}
+
 /**
  * fu_dfu_device_set_transfer_size:
  * @self: a #FuDfuDevice
@@ -924,6 +946,7 @@ fu_dfu_device_refresh (FuDfuDevice *self, GError **error)
 
 	/* status or state changed */
 	fu_dfu_device_set_status (self, buf[0]);
+	priv->dnload_timeout_start = g_get_monotonic_time ();
 	if (fu_device_has_custom_flag (FU_DEVICE (self), "ignore-polltimeout")) {
 		priv->dnload_timeout = DFU_DEVICE_DNLOAD_TIMEOUT_DEFAULT;
 	} else {
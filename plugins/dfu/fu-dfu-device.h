@@ -95,6 +95,7 @@ void		 fu_dfu_device_set_timeout		(FuDfuDevice	*self,
 void		 fu_dfu_device_error_fixup		(FuDfuDevice	*self,
 							 GError		**error);
 guint		 fu_dfu_device_get_download_timeout	(FuDfuDevice	*self);
+void		 fu_dfu_device_wait_download_timeout	(FuDfuDevice	*self);
 gchar		*fu_dfu_device_get_attributes_as_string	(FuDfuDevice	*self);
 gboolean	 fu_dfu_device_ensure_interface		(FuDfuDevice	*self,
 							 GError		**error);
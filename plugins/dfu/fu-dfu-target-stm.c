@@ -242,49 +242,26 @@ fu_dfu_target_stm_erase_address (FuDfuTarget *target, guint32 address, GError **
 }
 
 static gboolean
-fu_dfu_target_stm_download_element (FuDfuTarget *target,
-				    FuChunk *chk,
-				    FuDfuTargetTransferFlags flags,
-				    GError **error)
+fu_dfu_target_stm_erase_chunks (FuDfuTarget *target, GPtrArray *chunks, GError **error)
 {
-	FuDfuDevice *device = fu_dfu_target_get_device (target);
-	FuDfuSector *sector;
-	guint nr_chunks;
-	guint zone_last = G_MAXUINT;
-	guint16 transfer_size = fu_dfu_device_get_transfer_size (device);
-	g_autoptr(GBytes) bytes = NULL;
-	g_autoptr(GPtrArray) sectors_array = NULL;
-	g_autoptr(GHashTable) sectors_hash = NULL;
-
-	/* round up as we have to transfer incomplete blocks */
-	bytes = fu_chunk_get_bytes (chk);
-	nr_chunks = (guint) ceil ((gdouble) g_bytes_get_size (bytes) /
-				  (gdouble) transfer_size);
-	if (nr_chunks == 0) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "zero-length firmware");
-		return FALSE;
-	}
-
-	/* 1st pass: work out which sectors need erasing */
-	sectors_array = g_ptr_array_new ();
-	sectors_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
-	for (guint i = 0; i < nr_chunks; i++) {
-		guint32 offset_dev;
-
-		/* for DfuSe devices we need to handle the erase and setting
-		 * the sectory address manually */
-		offset_dev = i * transfer_size;
-		while (offset_dev < (i + 1) * transfer_size) {
-			sector = fu_dfu_target_get_sector_for_addr (target, fu_chunk_get_address (chk) + offset_dev);
+	g_autoptr(GPtrArray) sectors_array = g_ptr_array_new ();
+	g_autoptr(GHashTable) sectors_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	/* 1st pass: work out which sectors need erasing for all elements, so
+	 * that a sector shared by two elements is only erased once */
+	for (guint j = 0; j < chunks->len; j++) {
+		FuChunk *chk = g_ptr_array_index (chunks, j);
+		guint32 addr = fu_chunk_get_address (chk);
+		guint32 addr_end = addr + fu_chunk_get_data_sz (chk);
+
+		while (addr < addr_end) {
+			FuDfuSector *sector = fu_dfu_target_get_sector_for_addr (target, addr);
 			if (sector == NULL) {
 				g_set_error (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_NOT_SUPPORTED,
 					     "no memory sector at 0x%04x",
-					     (guint) fu_chunk_get_address (chk) + offset_dev);
+					     (guint) addr);
 				return FALSE;
 			}
 			if (!fu_dfu_sector_has_cap (sector, DFU_SECTOR_CAP_WRITEABLE)) {
@@ -292,7 +269,7 @@ fu_dfu_target_stm_download_element (FuDfuTarget *target,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_NOT_SUPPORTED,
 					     "memory sector at 0x%04x is not writable",
-					     (guint) fu_chunk_get_address (chk) + offset_dev);
+					     (guint) addr);
 				return FALSE;
 			}
 
@@ -307,14 +284,14 @@ fu_dfu_target_stm_download_element (FuDfuTarget *target,
 					 fu_dfu_sector_get_address (sector),
 					 fu_dfu_sector_get_address (sector) + fu_dfu_sector_get_size (sector));
 			}
-			offset_dev += fu_dfu_sector_get_size (sector);
+			addr = fu_dfu_sector_get_address (sector) + fu_dfu_sector_get_size (sector);
 		}
 	}
 
 	/* 2nd pass: actually erase sectors */
 	fu_dfu_target_set_action (target, FWUPD_STATUS_DEVICE_ERASE);
 	for (guint i = 0; i < sectors_array->len; i++) {
-		sector = g_ptr_array_index (sectors_array, i);
+		FuDfuSector *sector = g_ptr_array_index (sectors_array, i);
 		g_debug ("erasing sector at 0x%04x",
 			 fu_dfu_sector_get_address (sector));
 		if (!fu_dfu_target_stm_erase_address (target,
@@ -325,8 +302,35 @@ fu_dfu_target_stm_download_element (FuDfuTarget *target,
 	}
 	fu_dfu_target_set_percentage_raw (target, 100);
 	fu_dfu_target_set_action (target, FWUPD_STATUS_IDLE);
+	return TRUE;
+}
 
-	/* 3rd pass: write data */
+static gboolean
+fu_dfu_target_stm_download_element (FuDfuTarget *target,
+				    FuChunk *chk,
+				    FuDfuTargetTransferFlags flags,
+				    GError **error)
+{
+	FuDfuDevice *device = fu_dfu_target_get_device (target);
+	FuDfuSector *sector = NULL;
+	guint nr_chunks;
+	guint zone_last = G_MAXUINT;
+	guint16 transfer_size = fu_dfu_device_get_transfer_size (device);
+	g_autoptr(GBytes) bytes = NULL;
+
+	/* round up as we have to transfer incomplete blocks */
+	bytes = fu_chunk_get_bytes (chk);
+	nr_chunks = (guint) ceil ((gdouble) g_bytes_get_size (bytes) /
+				  (gdouble) transfer_size);
+	if (nr_chunks == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "zero-length firmware");
+		return FALSE;
+	}
+
+	/* write data, the sectors were erased in ->erase_chunks() */
 	fu_dfu_target_set_action (target, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < nr_chunks; i++) {
 		gsize length;
@@ -339,8 +343,18 @@ fu_dfu_target_stm_download_element (FuDfuTarget *target,
 		offset_dev = fu_chunk_get_address (chk) + offset;
 
 		/* for DfuSe devices we need to set the address manually */
-		sector = fu_dfu_target_get_sector_for_addr (target, offset_dev);
-		g_assert (sector != NULL);
+		if (sector == NULL ||
+		    offset_dev >= fu_dfu_sector_get_address (sector) + fu_dfu_sector_get_size (sector)) {
+			sector = fu_dfu_target_get_sector_for_addr (target, offset_dev);
+			if (sector == NULL) {
+				g_set_error (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_NOT_SUPPORTED,
+					     "no memory sector at 0x%04x",
+					     (guint) offset_dev);
+				return FALSE;
+			}
+		}
 
 		/* manually set the sector address */
 		if (fu_dfu_sector_get_zone (sector) != zone_last) {
@@ -366,17 +380,16 @@ fu_dfu_target_stm_download_element (FuDfuTarget *target,
 		g_debug ("writing sector at 0x%04x (0x%" G_GSIZE_FORMAT ")",
 			 offset_dev,
 			 g_bytes_get_size (bytes_tmp));
-		/* ST uses wBlockNum=0 for DfuSe commands and wBlockNum=1 is reserved */
+
+		/* ST uses wBlockNum=0 for DfuSe commands and wBlockNum=1 is
+		 * reserved; this also waits for the state machine to get back
+		 * to DNLOAD-IDLE so no extra GetStatus is required */
 		if (!fu_dfu_target_download_chunk (target,
 						   (i + 2),
 						   bytes_tmp,
 						   error))
 			return FALSE;
 
-		/* getting the status moves the state machine to DNLOAD-IDLE */
-		if (!fu_dfu_target_check_status (target, error))
-			return FALSE;
-
 		/* update UI */
 		fu_dfu_target_set_percentage (target, offset, g_bytes_get_size (bytes));
 	}
@@ -402,6 +415,7 @@ fu_dfu_target_stm_class_init (FuDfuTargetStmClass *klass)
 	klass_target->mass_erase = fu_dfu_target_stm_mass_erase;
 	klass_target->upload_element = fu_dfu_target_stm_upload_element;
 	klass_target->download_element = fu_dfu_target_stm_download_element;
+	klass_target->erase_chunks = fu_dfu_target_stm_erase_chunks;
 }
 
 FuDfuTarget *
@@ -151,7 +151,7 @@ fu_dfu_target_get_sector_for_addr (FuDfuTarget *self, guint32 addr)
 		FuDfuSector *sector = g_ptr_array_index (priv->sectors, i);
 		if (addr < fu_dfu_sector_get_address (sector))
 			continue;
-		if (addr > fu_dfu_sector_get_address (sector) +
+		if (addr >= fu_dfu_sector_get_address (sector) +
 				fu_dfu_sector_get_size (sector))
 			continue;
 		return sector;
@@ -532,7 +532,7 @@ fu_dfu_target_check_status (FuDfuTarget *self, GError **error)
 	/* wait for dfuDNBUSY to not be set */
 	while (fu_dfu_device_get_state (priv->device) == FU_DFU_STATE_DFU_DNBUSY) {
 		g_debug ("waiting for FU_DFU_STATE_DFU_DNBUSY to clear");
-		g_usleep (fu_dfu_device_get_download_timeout (priv->device) * 1000);
+		fu_dfu_device_wait_download_timeout (priv->device);
 		if (!fu_dfu_device_refresh (priv->device, error))
 			return FALSE;
 		/* this is a really long time to save fwupd in case
@@ -820,9 +820,9 @@ fu_dfu_target_download_chunk (FuDfuTarget *self, guint16 index, GBytes *bytes, G
 		fu_dfu_target_set_action (self,FWUPD_STATUS_DEVICE_BUSY);
 	}
 	if (fu_dfu_device_get_download_timeout (priv->device) > 0) {
-		g_debug ("sleeping for %ums…",
+		g_debug ("waiting for up to %ums…",
 			 fu_dfu_device_get_download_timeout (priv->device));
-		g_usleep (fu_dfu_device_get_download_timeout (priv->device) * 1000);
+		fu_dfu_device_wait_download_timeout (priv->device);
 	}
 
 	/* find out if the write was successful, waiting for BUSY to clear */
@@ -1315,6 +1315,7 @@ fu_dfu_target_download (FuDfuTarget *self,
 			GError **error)
 {
 	FuDfuTargetPrivate *priv = GET_PRIVATE (self);
+	FuDfuTargetClass *klass = FU_DFU_TARGET_GET_CLASS (self);
 	g_autoptr(GPtrArray) chunks = NULL;
 
 	g_return_val_if_fail (FU_IS_DFU_TARGET (self), FALSE);
@@ -1349,23 +1350,32 @@ fu_dfu_target_download (FuDfuTarget *self,
 				     "no image chunks");
 		return FALSE;
 	}
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		g_debug ("downloading chunk at 0x%04x",
-			 fu_chunk_get_address (chk));
 
-		/* auto-detect missing firmware address -- this assumes
-		 * that the first target is the main program memory and that
-		 * there is only one element in the firmware file */
-		if (flags & DFU_TARGET_TRANSFER_FLAG_ADDR_HEURISTIC &&
-		    fu_chunk_get_address (chk) == 0x0 &&
-		    chunks->len == 1 &&
-		    priv->sectors->len > 0) {
+	/* auto-detect missing firmware address -- this assumes
+	 * that the first target is the main program memory and that
+	 * there is only one element in the firmware file */
+	if (flags & DFU_TARGET_TRANSFER_FLAG_ADDR_HEURISTIC &&
+	    chunks->len == 1 &&
+	    priv->sectors->len > 0) {
+		FuChunk *chk = g_ptr_array_index (chunks, 0);
+		if (fu_chunk_get_address (chk) == 0x0) {
 			FuDfuSector *sector = g_ptr_array_index (priv->sectors, 0);
 			g_debug ("fixing up firmware address from 0x0 to 0x%x",
 				 fu_dfu_sector_get_address (sector));
 			fu_chunk_set_address (chk, fu_dfu_sector_get_address (sector));
 		}
+	}
+
+	/* erase everything the elements cover in one pass */
+	if (klass->erase_chunks != NULL) {
+		if (!klass->erase_chunks (self, chunks, error))
+			return FALSE;
+	}
+
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		g_debug ("downloading chunk at 0x%04x",
+			 fu_chunk_get_address (chk));
 
 		/* download to device */
 		if (!fu_dfu_target_download_element (self, chk, flags, error))
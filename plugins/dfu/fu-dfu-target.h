@@ -65,6 +65,9 @@ struct _FuDfuTargetClass
 							 FuChunk	*chk,
 							 FuDfuTargetTransferFlags flags,
 							 GError		**error);
+	gboolean		 (*erase_chunks)	(FuDfuTarget	*self,
+							 GPtrArray	*chunks,
+							 GError		**error);
 };
 
 GPtrArray	*fu_dfu_target_get_sectors		(FuDfuTarget	*self);
@@ -27,6 +27,7 @@ typedef struct {
 	GCancellable		*cancellable;
 	GPtrArray		*cmd_array;
 	gboolean		 force;
+	gboolean		 all_devices;
 	gchar			*device_vid_pid;
 	guint16			 transfer_size;
 	FuQuirks		*quirks;
@@ -170,6 +171,41 @@ fu_dfu_tool_run (FuDfuTool *self,
 	return FALSE;
 }
 
+static gboolean
+fu_dfu_tool_parse_vid_pid (FuDfuTool *self, guint16 *vid, guint16 *pid, GError **error)
+{
+	gchar *tmp;
+	guint64 tmp_pid;
+	guint64 tmp_vid;
+
+	tmp_vid = g_ascii_strtoull (self->device_vid_pid, &tmp, 16);
+	if (tmp_vid == 0 || tmp_vid > G_MAXUINT16) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	if (tmp[0] != ':') {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	tmp_pid = g_ascii_strtoull (tmp + 1, NULL, 16);
+	if (tmp_pid == 0 || tmp_pid > G_MAXUINT16) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid format of VID:PID");
+		return FALSE;
+	}
+	*vid = (guint16) tmp_vid;
+	*pid = (guint16) tmp_pid;
+	return TRUE;
+}
+
 static FuDfuDevice *
 fu_dfu_tool_get_default_device (FuDfuTool *self, GError **error)
 {
@@ -184,41 +220,19 @@ fu_dfu_tool_get_default_device (FuDfuTool *self, GError **error)
 
 	/* we specified it manually */
 	if (self->device_vid_pid != NULL) {
-		gchar *tmp;
-		guint64 pid;
-		guint64 vid;
+		guint16 pid = 0;
+		guint16 vid = 0;
 		g_autoptr(FuDfuDevice) device = NULL;
 		g_autoptr(GUsbDevice) usb_device = NULL;
 
 		/* parse */
-		vid = g_ascii_strtoull (self->device_vid_pid, &tmp, 16);
-		if (vid == 0 || vid > G_MAXUINT16) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
-			return NULL;
-		}
-		if (tmp[0] != ':') {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
+		if (!fu_dfu_tool_parse_vid_pid (self, &vid, &pid, error))
 			return NULL;
-		}
-		pid = g_ascii_strtoull (tmp + 1, NULL, 16);
-		if (pid == 0 || pid > G_MAXUINT16) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "Invalid format of VID:PID");
-			return NULL;
-		}
 
 		/* find device */
 		usb_device = g_usb_context_find_by_vid_pid (usb_context,
-							    (guint16) vid,
-							    (guint16) pid,
+							    vid,
+							    pid,
 							    error);
 		if (usb_device == NULL) {
 			g_set_error (error,
@@ -251,6 +265,49 @@ fu_dfu_tool_get_default_device (FuDfuTool *self, GError **error)
 	return NULL;
 }
 
+/* all the DFU devices, optionally matching --device */
+static GPtrArray *
+fu_dfu_tool_get_devices (FuDfuTool *self, GError **error)
+{
+	guint16 pid = 0;
+	guint16 vid = 0;
+	g_autoptr(GUsbContext) usb_context = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) usb_devices = NULL;
+
+	if (self->device_vid_pid != NULL) {
+		if (!fu_dfu_tool_parse_vid_pid (self, &vid, &pid, error))
+			return NULL;
+	}
+	usb_context = g_usb_context_new (error);
+	if (usb_context == NULL)
+		return NULL;
+	g_usb_context_enumerate (usb_context);
+	usb_devices = g_usb_context_get_devices (usb_context);
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < usb_devices->len; i++) {
+		GUsbDevice *usb_device = g_ptr_array_index (usb_devices, i);
+		g_autoptr(FuDfuDevice) device = NULL;
+		if (self->device_vid_pid != NULL &&
+		    (g_usb_device_get_vid (usb_device) != vid ||
+		     g_usb_device_get_pid (usb_device) != pid))
+			continue;
+		device = fu_dfu_device_new (usb_device);
+		fu_device_set_quirks (FU_DEVICE (device), self->quirks);
+		if (!fu_device_probe (FU_DEVICE (device), NULL))
+			continue;
+		g_ptr_array_add (devices, g_steal_pointer (&device));
+	}
+	if (devices->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_FOUND,
+				     "no DFU devices found");
+		return NULL;
+	}
+	return g_steal_pointer (&devices);
+}
+
 static gboolean
 fu_dfu_device_wait_for_replug (FuDfuTool *self, FuDfuDevice *device, guint timeout, GError **error)
 {
@@ -471,6 +528,16 @@ fu_tool_action_changed_cb (FuDevice *device, GParamSpec *pspec, FuDfuTool *self)
 		 fu_device_get_progress (device));
 }
 
+static void
+fu_tool_action_changed_multiple_cb (FuDevice *device, GParamSpec *pspec, FuDfuTool *self)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (device));
+	g_print ("%s\t%s:\t%u%%\n",
+		 g_usb_device_get_platform_id (usb_device),
+		 fwupd_status_to_string (fu_device_get_status (device)),
+		 fu_device_get_progress (device));
+}
+
 static gboolean
 fu_dfu_tool_read_alt (FuDfuTool *self, gchar **values, GError **error)
 {
@@ -762,31 +829,11 @@ fu_dfu_tool_write_alt (FuDfuTool *self, gchar **values, GError **error)
 }
 
 static gboolean
-fu_dfu_tool_write (FuDfuTool *self, gchar **values, GError **error)
+fu_dfu_tool_write_device (FuDfuTool *self, FuDfuDevice *device, GBytes *fw, GError **error)
 {
 	FwupdInstallFlags flags = FWUPD_INSTALL_FLAG_NONE;
-	g_autoptr(FuDfuDevice) device = NULL;
-	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(FuDeviceLocker) locker  = NULL;
 
-	/* check args */
-	if (g_strv_length (values) < 1) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Invalid arguments, expected FILENAME");
-		return FALSE;
-	}
-
-	/* open file */
-	fw = fu_common_get_contents_bytes (values[0], error);
-	if (fw == NULL)
-		return FALSE;
-
-	/* open correct device */
-	device = fu_dfu_tool_get_default_device (self, error);
-	if (device == NULL)
-		return FALSE;
 	locker = fu_device_locker_new (device, error);
 	if (locker == NULL)
 		return FALSE;
@@ -810,10 +857,6 @@ fu_dfu_tool_write (FuDfuTool *self, gchar **values, GError **error)
 	}
 
 	/* transfer */
-	g_signal_connect (device, "notify::status",
-			  G_CALLBACK (fu_tool_action_changed_cb), self);
-	g_signal_connect (device, "notify::progress",
-			  G_CALLBACK (fu_tool_action_changed_cb), self);
 	if (!fu_device_write_firmware (FU_DEVICE (device), fw, flags, error))
 		return FALSE;
 
@@ -826,6 +869,115 @@ fu_dfu_tool_write (FuDfuTool *self, gchar **values, GError **error)
 			return FALSE;
 	}
 
+	/* success */
+	return TRUE;
+}
+
+typedef struct {
+	FuDfuTool		*self;
+	FuDfuDevice		*device;
+	GBytes			*fw;
+	GError			*error;
+} FuDfuToolWriteHelper;
+
+static gpointer
+fu_dfu_tool_write_thread_cb (gpointer user_data)
+{
+	FuDfuToolWriteHelper *helper = (FuDfuToolWriteHelper *) user_data;
+	fu_dfu_tool_write_device (helper->self, helper->device,
+				  helper->fw, &helper->error);
+	return NULL;
+}
+
+/* each device is independent, so flash them all at the same time */
+static gboolean
+fu_dfu_tool_write_multiple (FuDfuTool *self, GBytes *fw, GError **error)
+{
+	guint failures = 0;
+	g_autofree FuDfuToolWriteHelper *helpers = NULL;
+	g_autofree GThread **threads = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	devices = fu_dfu_tool_get_devices (self, error);
+	if (devices == NULL)
+		return FALSE;
+	helpers = g_new0 (FuDfuToolWriteHelper, devices->len);
+	threads = g_new0 (GThread *, devices->len);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDfuDevice *device = g_ptr_array_index (devices, i);
+		helpers[i].self = self;
+		helpers[i].device = device;
+		helpers[i].fw = fw;
+		g_signal_connect (device, "notify::status",
+				  G_CALLBACK (fu_tool_action_changed_multiple_cb), self);
+		g_signal_connect (device, "notify::progress",
+				  G_CALLBACK (fu_tool_action_changed_multiple_cb), self);
+		threads[i] = g_thread_new ("dfu-write",
+					   fu_dfu_tool_write_thread_cb,
+					   &helpers[i]);
+	}
+	for (guint i = 0; i < devices->len; i++)
+		g_thread_join (threads[i]);
+
+	/* show a summary */
+	for (guint i = 0; i < devices->len; i++) {
+		GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (helpers[i].device));
+		if (helpers[i].error != NULL) {
+			g_print ("%s\t%s\n",
+				 g_usb_device_get_platform_id (usb_device),
+				 helpers[i].error->message);
+			g_error_free (helpers[i].error);
+			failures++;
+			continue;
+		}
+		g_print ("%s\t%u bytes successfully downloaded to device\n",
+			 g_usb_device_get_platform_id (usb_device),
+			 (guint) g_bytes_get_size (fw));
+	}
+	if (failures > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_WRITE,
+			     "failed to write %u of %u devices",
+			     failures, devices->len);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_dfu_tool_write (FuDfuTool *self, gchar **values, GError **error)
+{
+	g_autoptr(FuDfuDevice) device = NULL;
+	g_autoptr(GBytes) fw = NULL;
+
+	/* check args */
+	if (g_strv_length (values) < 1) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "Invalid arguments, expected FILENAME");
+		return FALSE;
+	}
+
+	/* open file */
+	fw = fu_common_get_contents_bytes (values[0], error);
+	if (fw == NULL)
+		return FALSE;
+	if (self->all_devices)
+		return fu_dfu_tool_write_multiple (self, fw, error);
+
+	/* open correct device */
+	device = fu_dfu_tool_get_default_device (self, error);
+	if (device == NULL)
+		return FALSE;
+	g_signal_connect (device, "notify::status",
+			  G_CALLBACK (fu_tool_action_changed_cb), self);
+	g_signal_connect (device, "notify::progress",
+			  G_CALLBACK (fu_tool_action_changed_cb), self);
+	if (!fu_dfu_tool_write_device (self, device, fw, error))
+		return FALSE;
+
 	/* success */
 	g_print ("%u bytes successfully downloaded to device\n",
 		 (guint) g_bytes_get_size (fw));
@@ -864,6 +1016,8 @@ main (int argc, char *argv[])
 			_("Specify the number of bytes per USB transfer"), _("BYTES") },
 		{ "force", '\0', 0, G_OPTION_ARG_NONE, &self->force,
 			_("Force the action ignoring all warnings"), NULL },
+		{ "all", 'a', 0, G_OPTION_ARG_NONE, &self->all_devices,
+			_("Write to all matching devices at the same time"), NULL },
 		{ NULL}
 	};
 
@@ -4,8 +4,6 @@
  * SPDX-License-Identifier: LGPL-2.1+
  */
 
-#include <linux/i2c-dev.h>
-
 #include "config.h"
 
 #include "fu-elantp-common.h"
@@ -14,8 +12,7 @@
 #include "fu-chunk.h"
 
 struct _FuElantpI2cDevice {
-	FuUdevDevice		 parent_instance;
-	guint16			 i2c_addr;
+	FuI2cDevice		 parent_instance;
 	guint16			 ic_page_count;
 	guint16			 iap_type;
 	guint16			 iap_ctrl;
@@ -25,13 +22,14 @@ struct _FuElantpI2cDevice {
 	guint8			 pattern;
 };
 
-G_DEFINE_TYPE (FuElantpI2cDevice, fu_elantp_i2c_device, FU_TYPE_UDEV_DEVICE)
+G_DEFINE_TYPE (FuElantpI2cDevice, fu_elantp_i2c_device, FU_TYPE_I2C_DEVICE)
 
 static void
 fu_elantp_i2c_device_to_string (FuDevice *device, guint idt, GString *str)
 {
 	FuElantpI2cDevice *self = FU_ELANTP_I2C_DEVICE (device);
-	fu_common_string_append_kx (str, idt, "I2cAddr", self->i2c_addr);
+	fu_common_string_append_kx (str, idt, "I2cAddr",
+				    fu_i2c_device_get_address (FU_I2C_DEVICE (self)));
 	fu_common_string_append_kx (str, idt, "ModuleId", self->module_id);
 	fu_common_string_append_kx (str, idt, "Pattern", self->pattern);
 	fu_common_string_append_kx (str, idt, "FwPageSize", self->fw_page_size);
@@ -40,34 +38,6 @@ fu_elantp_i2c_device_to_string (FuDevice *device, guint idt, GString *str)
 	fu_common_string_append_kx (str, idt, "IapCtrl", self->iap_ctrl);
 }
 
-static gboolean
-fu_elantp_i2c_device_probe (FuDevice *device, GError **error)
-{
-	/* FuUdevDevice->probe */
-	if (!FU_DEVICE_CLASS (fu_elantp_i2c_device_parent_class)->probe (device, error))
-		return FALSE;
-
-	/* check is valid */
-	if (g_strcmp0 (fu_udev_device_get_subsystem (FU_UDEV_DEVICE (device)), "i2c-dev") != 0) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_NOT_SUPPORTED,
-			     "is not correct subsystem=%s, expected i2c-dev",
-			     fu_udev_device_get_subsystem (FU_UDEV_DEVICE (device)));
-		return FALSE;
-	}
-	if (fu_udev_device_get_device_file (FU_UDEV_DEVICE (device)) == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_NOT_SUPPORTED,
-				     "no device file");
-		return FALSE;
-	}
-
-	/* set the physical ID */
-	return fu_udev_device_set_physical_id (FU_UDEV_DEVICE (device), "i2c", error);
-}
-
 static gboolean
 fu_elantp_i2c_device_send_cmd (FuElantpI2cDevice *self,
 			       guint8 *tx, gssize txsz,
@@ -76,11 +46,9 @@ fu_elantp_i2c_device_send_cmd (FuElantpI2cDevice *self,
 {
 	if (g_getenv ("FWUPD_ELANTP_VERBOSE") != NULL)
 		fu_common_dump_raw (G_LOG_DOMAIN, "Write", tx, txsz);
-	if (!fu_udev_device_pwrite_full (FU_UDEV_DEVICE (self), 0, tx, txsz, error))
-		return FALSE;
 	if (rxsz == 0)
-		return TRUE;
-	if (!fu_udev_device_pread_full (FU_UDEV_DEVICE (self), 0, rx, rxsz, error))
+		return fu_i2c_device_write (FU_I2C_DEVICE (self), tx, txsz, error);
+	if (!fu_i2c_device_write_read (FU_I2C_DEVICE (self), tx, txsz, rx, rxsz, error))
 		return FALSE;
 	if (g_getenv ("FWUPD_ELANTP_VERBOSE") != NULL)
 		fu_common_dump_raw (G_LOG_DOMAIN, "Read", rx, rxsz);
@@ -283,28 +251,14 @@ fu_elantp_i2c_device_setup (FuDevice *device, GError **error)
 static gboolean
 fu_elantp_i2c_device_open (FuDevice *device, GError **error)
 {
-	FuElantpI2cDevice *self = FU_ELANTP_I2C_DEVICE (device);
-	gint addr = self->i2c_addr;
 	guint8 tx_buf[] = { 0x02, 0x01 };
 
-	/* FuUdevDevice->open */
+	/* FuI2cDevice->open */
 	if (!FU_DEVICE_CLASS (fu_elantp_i2c_device_parent_class)->open (device, error))
 		return FALSE;
 
-	/* set target address */
-	if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (device), I2C_SLAVE,
-				   GINT_TO_POINTER (addr), NULL, NULL)) {
-		if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (device), I2C_SLAVE_FORCE,
-					   GINT_TO_POINTER (addr), NULL, error)) {
-			g_prefix_error (error,
-					"failed to set target address to 0x%x: ",
-					self->i2c_addr);
-			return FALSE;
-		}
-	}
-
 	/* read i2c device */
-	return fu_udev_device_pwrite_full (FU_UDEV_DEVICE (device), 0x0, tx_buf, sizeof(tx_buf), error);
+	return fu_i2c_device_write (FU_I2C_DEVICE (device), tx_buf, sizeof(tx_buf), error);
 }
 
 static FuFirmware *
@@ -518,9 +472,17 @@ fu_elantp_i2c_device_detach (FuDevice *device, GError **error)
 					     self->iap_password,
 					     error))
 		return FALSE;
-	g_usleep (ELANTP_DELAY_UNLOCK * 1000);
-	if (!fu_elantp_i2c_device_ensure_iap_ctrl (self, error))
-		return FALSE;
+
+	/* poll for the unlock rather than always waiting for the worst case */
+	for (guint delay_ms = 5, elapsed_ms = 0; elapsed_ms < ELANTP_DELAY_UNLOCK;) {
+		g_usleep (delay_ms * 1000);
+		elapsed_ms += delay_ms;
+		delay_ms = MIN (delay_ms * 2, ELANTP_DELAY_UNLOCK - elapsed_ms);
+		if (!fu_elantp_i2c_device_ensure_iap_ctrl (self, error))
+			return FALSE;
+		if (self->iap_ctrl & ETP_FW_IAP_CHECK_PW)
+			break;
+	}
 	if ((self->iap_ctrl & ETP_FW_IAP_CHECK_PW) == 0) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -607,7 +569,7 @@ fu_elantp_i2c_device_set_quirk_kv (FuDevice *device,
 					     "values <= 0xffff");
 			return FALSE;
 		}
-		self->i2c_addr = (guint16) tmp;
+		fu_i2c_device_set_address (FU_I2C_DEVICE (self), (guint16) tmp);
 		return TRUE;
 	}
 	g_set_error_literal (error,
@@ -651,6 +613,5 @@ fu_elantp_i2c_device_class_init (FuElantpI2cDeviceClass *klass)
 	klass_device->reload = fu_elantp_i2c_device_setup;
 	klass_device->write_firmware = fu_elantp_i2c_device_write_firmware;
 	klass_device->prepare_firmware = fu_elantp_i2c_device_prepare_firmware;
-	klass_device->probe = fu_elantp_i2c_device_probe;
 	klass_device->open = fu_elantp_i2c_device_open;
 }
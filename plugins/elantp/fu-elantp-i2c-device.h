@@ -9,4 +9,4 @@
 #include "fu-plugin.h"
 
 #define FU_TYPE_ELANTP_I2C_DEVICE (fu_elantp_i2c_device_get_type ())
-G_DECLARE_FINAL_TYPE (FuElantpI2cDevice, fu_elantp_i2c_device, FU, ELANTP_I2C_DEVICE, FuUdevDevice)
+G_DECLARE_FINAL_TYPE (FuElantpI2cDevice, fu_elantp_i2c_device, FU, ELANTP_I2C_DEVICE, FuI2cDevice)
@@ -63,6 +63,9 @@
 #define EXT_CSD_UPDATE_DISABLE		(1<<0)
 #define EXT_CSD_CMD_SET_NORMAL		(1<<0)
 
+/* the FFU mode switch commands are sent in the same multi-cmd ioctl */
+#define FU_EMMC_DEVICE_WRITE_CMDS_MAX	(MMC_IOC_MAX_CMDS - 2)
+
 struct _FuEmmcDevice {
 	FuUdevDevice		 parent_instance;
 	guint32			 sect_size;
@@ -329,6 +332,9 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	guint32 sect_done = 0;
 	guint8 ext_csd[512];
 	guint failure_cnt = 0;
+	guint write_cmds = FU_EMMC_DEVICE_WRITE_CMDS_MAX;
+	guint write_block_size = fu_device_get_firmware_block_size (device);
+	struct mmc_ioc_cmd cmd_normal = { 0x0 };
 	g_autofree struct mmc_ioc_multi_cmd *multi_cmd = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GPtrArray) chunks = NULL;
@@ -347,10 +353,14 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	      ext_csd[EXT_CSD_FFU_ARG_2] << 16 |
 	      ext_csd[EXT_CSD_FFU_ARG_3] << 24;
 
+	/* send as many sectors as possible in each ioctl, unless a smaller
+	 * transfer size has been set with a quirk */
+	if (write_block_size >= self->sect_size)
+		write_cmds = MIN (write_block_size / self->sect_size, write_cmds);
+
 	/* prepare multi_cmd to be sent */
 	multi_cmd = g_malloc0 (sizeof(struct mmc_ioc_multi_cmd) +
-			       3 * sizeof(struct mmc_ioc_cmd));
-	multi_cmd->num_of_cmds = 3;
+			       (write_cmds + 2) * sizeof(struct mmc_ioc_cmd));
 
 	/* put device into ffu mode */
 	multi_cmd->cmds[0].opcode = MMC_SWITCH;
@@ -361,33 +371,42 @@ fu_emmc_device_write_firmware (FuDevice *device,
 	multi_cmd->cmds[0].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
 	multi_cmd->cmds[0].write_flag = 1;
 
-	/* send image chunk */
-	multi_cmd->cmds[1].opcode = MMC_WRITE_BLOCK;
-	multi_cmd->cmds[1].blksz = self->sect_size;
-	multi_cmd->cmds[1].blocks = 1;
-	multi_cmd->cmds[1].arg = arg;
-	multi_cmd->cmds[1].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
-	multi_cmd->cmds[1].write_flag = 1;
+	/* send image chunks */
+	for (guint j = 0; j < write_cmds; j++) {
+		multi_cmd->cmds[j + 1].opcode = MMC_WRITE_BLOCK;
+		multi_cmd->cmds[j + 1].blksz = self->sect_size;
+		multi_cmd->cmds[j + 1].blocks = 1;
+		multi_cmd->cmds[j + 1].arg = arg;
+		multi_cmd->cmds[j + 1].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
+		multi_cmd->cmds[j + 1].write_flag = 1;
+	}
 
 	/* return device into normal mode */
-	multi_cmd->cmds[2].opcode = MMC_SWITCH;
-	multi_cmd->cmds[2].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
-				 (EXT_CSD_MODE_CONFIG << 16) |
-				 (EXT_CSD_NORMAL_MODE << 8) |
-				  EXT_CSD_CMD_SET_NORMAL;
-	multi_cmd->cmds[2].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
-	multi_cmd->cmds[2].write_flag = 1;
+	cmd_normal.opcode = MMC_SWITCH;
+	cmd_normal.arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
+			 (EXT_CSD_MODE_CONFIG << 16) |
+			 (EXT_CSD_NORMAL_MODE << 8) |
+			  EXT_CSD_CMD_SET_NORMAL;
+	cmd_normal.flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
+	cmd_normal.write_flag = 1;
 
 	/* build packets */
 	chunks = fu_chunk_array_new_from_bytes (fw,
 						0x00,	/* start addr */
 						0x00,	/* page_sz */
-						self->sect_size);
+						write_cmds * self->sect_size);
 	while (sect_done == 0) {
 		for (guint i = 0; i < chunks->len; i++) {
 			FuChunk *chk = g_ptr_array_index (chunks, i);
+			const guint8 *data = fu_chunk_get_data (chk);
+			guint blocks = fu_chunk_get_data_sz (chk) / self->sect_size;
 
-			mmc_ioc_cmd_set_data (multi_cmd->cmds[1], fu_chunk_get_data (chk));
+			/* one sector per write command */
+			for (guint j = 0; j < blocks; j++)
+				mmc_ioc_cmd_set_data (multi_cmd->cmds[j + 1],
+						      data + (j * self->sect_size));
+			multi_cmd->cmds[blocks + 1] = cmd_normal;
+			multi_cmd->num_of_cmds = blocks + 2;
 
 			if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
 						   MMC_IOC_MULTI_CMD, (guint8 *) multi_cmd,
@@ -396,7 +415,7 @@ fu_emmc_device_write_firmware (FuDevice *device,
 				g_prefix_error (error, "multi-cmd failed: ");
 				/* multi-cmd ioctl failed before exiting from ffu mode */
 				if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
-							   MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[2],
+							   MMC_IOC_CMD, (guint8 *) &cmd_normal,
 							   NULL, &error_local)) {
 					g_prefix_error (error, "%s: ",
 							error_local->message);
@@ -468,7 +487,7 @@ fu_emmc_device_write_firmware (FuDevice *device,
 			/* In case multi-cmd ioctl failed before exiting from ffu mode */
 			g_prefix_error (error, "multi-cmd failed setting install mode: ");
 			if (!fu_udev_device_ioctl (FU_UDEV_DEVICE (self),
-						   MMC_IOC_CMD, (guint8 *) &multi_cmd->cmds[2],
+						   MMC_IOC_CMD, (guint8 *) &cmd_normal,
 						   NULL, &error_local)) {
 				g_prefix_error (error, "%s: ",
 						error_local->message);
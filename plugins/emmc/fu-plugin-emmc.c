@@ -14,6 +14,6 @@ void
 fu_plugin_init (FuPlugin *plugin)
 {
 	fu_plugin_set_build_hash (plugin, FU_BUILD_HASH);
-	fu_plugin_add_udev_subsystem (plugin, "block");
+	fu_plugin_add_udev_subsystem (plugin, "block/disk");
 	fu_plugin_set_device_gtype (plugin, FU_TYPE_EMMC_DEVICE);
 }
@@ -12,6 +12,7 @@
 #include "fu-archive.h"
 #include "fu-chunk.h"
 #include "fu-fastboot-device.h"
+#include "fu-fastboot-struct.h"
 
 #define FASTBOOT_REMOVE_DELAY_RE_ENUMERATE	60000 /* ms */
 #define FASTBOOT_TRANSACTION_TIMEOUT		1000 /* ms */
@@ -19,11 +20,18 @@
 #define FASTBOOT_EP_IN				0x81
 #define FASTBOOT_EP_OUT				0x01
 #define FASTBOOT_CMD_BUFSZ			64 /* bytes */
+#define FASTBOOT_DOWNLOAD_IN_FLIGHT		4
+
+#define FASTBOOT_SPARSE_MAGIC			0xed26ff3a
+#define FASTBOOT_SPARSE_BLKSZ			4096 /* bytes */
+#define FASTBOOT_SPARSE_CHUNK_TYPE_RAW		0xcac1
+#define FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE	0xcac3
 
 struct _FuFastbootDevice {
 	FuUsbDevice			 parent_instance;
 	gboolean			 secure;
 	guint				 blocksz;
+	guint64				 max_download_size;
 	guint8				 intf_nr;
 };
 
@@ -35,6 +43,7 @@ fu_fastboot_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
 	fu_common_string_append_kx (str, idt, "InterfaceNumber", self->intf_nr);
 	fu_common_string_append_kx (str, idt, "BlockSize", self->blocksz);
+	fu_common_string_append_kx (str, idt, "MaxDownloadSize", self->max_download_size);
 	fu_common_string_append_kb (str, idt, "Secure", self->secure);
 }
 
@@ -268,13 +277,109 @@ fu_fastboot_device_flash (FuDevice *device, const gchar *partition, GError **err
 				       error);
 }
 
+typedef struct {
+	FuFastbootDevice	*self;
+	const guint8		*buf;
+	gsize			 bufsz;
+	gsize			 offset_submitted;
+	gsize			 done_sz;
+	guint			 in_flight;
+	GCancellable		*cancellable;
+	GMainLoop		*loop;
+	GError			*error;
+} FuFastbootDeviceDownloadHelper;
+
+typedef struct {
+	FuFastbootDeviceDownloadHelper	*helper;
+	gsize				 sz;
+} FuFastbootDeviceDownloadItem;
+
+static void fu_fastboot_device_download_submit (FuFastbootDeviceDownloadHelper *helper);
+
+static void
+fu_fastboot_device_download_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuFastbootDeviceDownloadItem *item = (FuFastbootDeviceDownloadItem *) user_data;
+	FuFastbootDeviceDownloadHelper *helper = item->helper;
+	gssize actual;
+	g_autoptr(GError) error_local = NULL;
+
+	actual = g_usb_device_bulk_transfer_finish (G_USB_DEVICE (source),
+						    res, &error_local);
+	helper->in_flight--;
+
+	/* only the first failure is interesting, the others were cancelled */
+	if (actual < 0) {
+		if (helper->error == NULL) {
+			g_propagate_prefixed_error (&helper->error,
+						    g_steal_pointer (&error_local),
+						    "failed to do bulk transfer: ");
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else if ((gsize) actual != item->sz) {
+		if (helper->error == NULL) {
+			g_set_error (&helper->error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "only wrote %" G_GSSIZE_FORMAT "bytes", actual);
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else {
+		helper->done_sz += item->sz;
+		fu_device_set_progress_full (FU_DEVICE (helper->self),
+					     helper->done_sz, helper->bufsz * 2);
+	}
+	g_free (item);
+
+	/* keep the pipeline full */
+	fu_fastboot_device_download_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_fastboot_device_download_submit (FuFastbootDeviceDownloadHelper *helper)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (helper->self));
+
+	while (helper->error == NULL &&
+	       helper->in_flight < FASTBOOT_DOWNLOAD_IN_FLIGHT &&
+	       helper->offset_submitted < helper->bufsz) {
+		FuFastbootDeviceDownloadItem *item = g_new0 (FuFastbootDeviceDownloadItem, 1);
+		gsize offset = helper->offset_submitted;
+		item->helper = helper;
+		item->sz = MIN (helper->bufsz - offset, helper->self->blocksz);
+		helper->offset_submitted += item->sz;
+		helper->in_flight++;
+
+		/* OUT transfers never write to the buffer */
+		g_usb_device_bulk_transfer_async (usb_device,
+						  FASTBOOT_EP_OUT,
+						  (guint8 *) helper->buf + offset,
+						  item->sz,
+						  FASTBOOT_TRANSACTION_TIMEOUT,
+						  helper->cancellable,
+						  fu_fastboot_device_download_cb,
+						  item);
+	}
+}
+
 static gboolean
 fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 {
 	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
 	gsize sz = g_bytes_get_size (fw);
 	g_autofree gchar *tmp = g_strdup_printf ("download:%08x", (guint) sz);
-	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	FuFastbootDeviceDownloadHelper helper = {
+		.self		= self,
+		.buf		= g_bytes_get_data (fw, NULL),
+		.bufsz		= sz,
+		.cancellable	= cancellable,
+		.loop		= loop,
+	};
 
 	/* tell the client the size of data to expect */
 	if (!fu_fastboot_device_cmd (device, tmp,
@@ -282,20 +387,19 @@ fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 				     error))
 		return FALSE;
 
-	/* send the data in chunks */
+	/* stream the data with several bulk transfers queued so the device
+	 * never waits for the host between blocks */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	chunks = fu_chunk_array_new_from_bytes (fw,
-						0x00,	/* start addr */
-						0x00,	/* page_sz */
-						self->blocksz);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
-		if (!fu_fastboot_device_write (device,
-					       fu_chunk_get_data (chk),
-					       fu_chunk_get_data_sz (chk),
-					       error))
-			return FALSE;
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len * 2);
+	if (g_getenv ("FWUPD_FASTBOOT_VERBOSE") != NULL)
+		g_debug ("writing 0x%x bytes", (guint) sz);
+	g_main_context_push_thread_default (context);
+	fu_fastboot_device_download_submit (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
 	}
 	if (!fu_fastboot_device_read (device, NULL,
 				      FU_FASTBOOT_DEVICE_READ_FLAG_STATUS_POLL, error))
@@ -303,6 +407,145 @@ fu_fastboot_device_download (FuDevice *device, GBytes *fw, GError **error)
 	return TRUE;
 }
 
+/* a sparse image that writes @blk_cnt blocks of @fw at @blk_start, and
+ * skips everything else in the partition */
+static GBytes *
+fu_fastboot_device_sparse_piece (GBytes *fw,
+				 guint32 blk_start,
+				 guint32 blk_cnt,
+				 guint32 blk_total,
+				 GError **error)
+{
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (fw, &bufsz);
+	gsize offset = (gsize) blk_start * FASTBOOT_SPARSE_BLKSZ;
+	gsize datasz = MIN ((gsize) blk_cnt * FASTBOOT_SPARSE_BLKSZ, bufsz - offset);
+	gsize pos = FU_FASTBOOT_SPARSE_HEADER_SIZE;
+	FuFastbootSparseChunk chunk = { 0x0 };
+	FuFastbootSparseHeader hdr = {
+		.magic		= FASTBOOT_SPARSE_MAGIC,
+		.major_version	= 1,
+		.file_hdr_sz	= FU_FASTBOOT_SPARSE_HEADER_SIZE,
+		.chunk_hdr_sz	= FU_FASTBOOT_SPARSE_CHUNK_SIZE,
+		.blk_sz		= FASTBOOT_SPARSE_BLKSZ,
+		.total_blks	= blk_total,
+		.total_chunks	= 1,
+	};
+	g_autoptr(GByteArray) piece = g_byte_array_new ();
+
+	if (blk_start > 0)
+		hdr.total_chunks++;
+	if (blk_start + blk_cnt < blk_total)
+		hdr.total_chunks++;
+	fu_byte_array_set_size (piece,
+				FU_FASTBOOT_SPARSE_HEADER_SIZE +
+				hdr.total_chunks * FU_FASTBOOT_SPARSE_CHUNK_SIZE +
+				(gsize) blk_cnt * FASTBOOT_SPARSE_BLKSZ);
+	if (!fu_fastboot_sparse_header_write (&hdr, piece->data, piece->len, 0x0, error))
+		return NULL;
+
+	/* skip the blocks before */
+	if (blk_start > 0) {
+		chunk.chunk_type = FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE;
+		chunk.chunk_sz = blk_start;
+		chunk.total_sz = FU_FASTBOOT_SPARSE_CHUNK_SIZE;
+		if (!fu_fastboot_sparse_chunk_write (&chunk, piece->data, piece->len, pos, error))
+			return NULL;
+		pos += FU_FASTBOOT_SPARSE_CHUNK_SIZE;
+	}
+
+	/* the data, zero padded to a whole block */
+	chunk.chunk_type = FASTBOOT_SPARSE_CHUNK_TYPE_RAW;
+	chunk.chunk_sz = blk_cnt;
+	chunk.total_sz = FU_FASTBOOT_SPARSE_CHUNK_SIZE + blk_cnt * FASTBOOT_SPARSE_BLKSZ;
+	if (!fu_fastboot_sparse_chunk_write (&chunk, piece->data, piece->len, pos, error))
+		return NULL;
+	pos += FU_FASTBOOT_SPARSE_CHUNK_SIZE;
+	if (!fu_memcpy_safe (piece->data, piece->len, pos,		/* dst */
+			     buf, bufsz, offset,			/* src */
+			     datasz, error))
+		return NULL;
+	pos += (gsize) blk_cnt * FASTBOOT_SPARSE_BLKSZ;
+
+	/* skip the blocks after */
+	if (blk_start + blk_cnt < blk_total) {
+		chunk.chunk_type = FASTBOOT_SPARSE_CHUNK_TYPE_DONT_CARE;
+		chunk.chunk_sz = blk_total - blk_start - blk_cnt;
+		chunk.total_sz = FU_FASTBOOT_SPARSE_CHUNK_SIZE;
+		if (!fu_fastboot_sparse_chunk_write (&chunk, piece->data, piece->len, pos, error))
+			return NULL;
+	}
+	return g_byte_array_free_to_bytes (g_steal_pointer (&piece));
+}
+
+/* images larger than the device can accept in one download are split into
+ * sparse images that each write part of the partition */
+static gboolean
+fu_fastboot_device_download_flash (FuDevice *device,
+				   GBytes *fw,
+				   const gchar *partition,
+				   GError **error)
+{
+	FuFastbootDevice *self = FU_FASTBOOT_DEVICE (device);
+	gsize sz = g_bytes_get_size (fw);
+	guint32 magic = 0x0;
+	guint32 blk_total;
+	guint32 blk_per_piece;
+	gsize overhead = FU_FASTBOOT_SPARSE_HEADER_SIZE + 3 * FU_FASTBOOT_SPARSE_CHUNK_SIZE;
+
+	/* fits in one go */
+	if (self->max_download_size == 0 || sz <= self->max_download_size) {
+		if (!fu_fastboot_device_download (device, fw, error))
+			return FALSE;
+		return fu_fastboot_device_flash (device, partition, error);
+	}
+
+	/* splitting an existing sparse image needs the chunks rewriting */
+	if (fu_common_read_uint32_safe (g_bytes_get_data (fw, NULL), sz, 0x0,
+					&magic, G_LITTLE_ENDIAN, NULL) &&
+	    magic == FASTBOOT_SPARSE_MAGIC) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "sparse image for %s is larger than max-download-size 0x%x",
+			     partition, (guint) self->max_download_size);
+		return FALSE;
+	}
+	if (self->max_download_size < overhead + FASTBOOT_SPARSE_BLKSZ) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "max-download-size 0x%x too small for sparse images",
+			     (guint) self->max_download_size);
+		return FALSE;
+	}
+	if (sz / FASTBOOT_SPARSE_BLKSZ >= G_MAXUINT32) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "image for %s is too large", partition);
+		return FALSE;
+	}
+	blk_total = (sz + FASTBOOT_SPARSE_BLKSZ - 1) / FASTBOOT_SPARSE_BLKSZ;
+	blk_per_piece = MIN ((self->max_download_size - overhead) / FASTBOOT_SPARSE_BLKSZ,
+			     G_MAXUINT32 / FASTBOOT_SPARSE_BLKSZ);
+	g_debug ("splitting 0x%x bytes for %s into sparse images of 0x%x blocks",
+		 (guint) sz, partition, blk_per_piece);
+	for (guint32 blk = 0; blk < blk_total; blk += blk_per_piece) {
+		g_autoptr(GBytes) piece = NULL;
+		piece = fu_fastboot_device_sparse_piece (fw, blk,
+							 MIN (blk_per_piece, blk_total - blk),
+							 blk_total, error);
+		if (piece == NULL)
+			return FALSE;
+		if (!fu_fastboot_device_download (device, piece, error))
+			return FALSE;
+		if (!fu_fastboot_device_flash (device, partition, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_fastboot_device_setup (FuDevice *device, GError **error)
 {
@@ -312,6 +555,8 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	g_autofree gchar *version = NULL;
 	g_autofree gchar *secure = NULL;
 	g_autofree gchar *version_bootloader = NULL;
+	g_autofree gchar *max_download_size = NULL;
+	g_autoptr(GError) error_local = NULL;
 
 	/* product */
 	if (!fu_fastboot_device_getvar (device, "product", &product, error))
@@ -347,6 +592,17 @@ fu_fastboot_device_setup (FuDevice *device, GError **error)
 	if (secure != NULL && secure[0] != '\0')
 		self->secure = TRUE;
 
+	/* optional, and always hex even without the prefix */
+	if (!fu_fastboot_device_getvar (device, "max-download-size",
+					&max_download_size, &error_local)) {
+		g_debug ("no max-download-size: %s", error_local->message);
+	} else if (max_download_size != NULL) {
+		const gchar *tmp = max_download_size;
+		if (g_str_has_prefix (tmp, "0x"))
+			tmp += 2;
+		self->max_download_size = g_ascii_strtoull (tmp, NULL, 16);
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -379,9 +635,7 @@ fu_fastboot_device_write_qfil_part (FuDevice *device,
 		partition += 2;
 
 	/* flash the partition */
-	if (!fu_fastboot_device_download (device, data, error))
-		return FALSE;
-	return fu_fastboot_device_flash (device, partition, error);
+	return fu_fastboot_device_download_flash (device, data, partition, error);
 }
 
 static gboolean
@@ -504,9 +758,7 @@ fu_fastboot_device_write_motorola_part (FuDevice *device,
 		}
 
 		/* flash the partition */
-		if (!fu_fastboot_device_download (device, data, error))
-			return FALSE;
-		return fu_fastboot_device_flash (device, partition, error);
+		return fu_fastboot_device_download_flash (device, data, partition, error);
 	}
 
 	/* dumb operation that doesn't expect a response */
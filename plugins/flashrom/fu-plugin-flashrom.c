@@ -327,6 +327,21 @@ fu_plugin_update (FuPlugin *plugin,
 	gint rc;
 	const guint8 *buf = g_bytes_get_data (blob_fw, &sz);
 
+	/* check before touching the hardware */
+	if (sz != data->flash_size) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "invalid image size 0x%x, expected 0x%x",
+			     (guint) sz, (guint) data->flash_size);
+		return FALSE;
+	}
+
+	/* the layout from any previous update is replaced */
+	if (data->layout != NULL) {
+		flashrom_layout_release (data->layout);
+		data->layout = NULL;
+	}
 	if (flashrom_layout_read_from_ifd (&data->layout, data->flashctx, NULL, 0)) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -346,14 +361,6 @@ fu_plugin_update (FuPlugin *plugin,
 
 	/* write region */
 	flashrom_layout_set (data->flashctx, data->layout);
-	if (sz != data->flash_size) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_NOT_SUPPORTED,
-			     "invalid image size 0x%x, expected 0x%x",
-			     (guint) sz, (guint) data->flash_size);
-		return FALSE;
-	}
 
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	fu_device_set_progress (device, 0); /* urgh */
@@ -11,10 +11,14 @@
 #include "fu-fresco-pd-device.h"
 #include "fu-fresco-pd-firmware.h"
 
+/* largest transfer used when the device accepts more than one byte */
+#define FU_FRESCO_PD_DEVICE_BLOCK_SIZE		64
+
 struct _FuFrescoPdDevice
 {
 	FuUsbDevice		 parent_instance;
 	guint8			 customer_id;
+	gboolean		 block_transfers;
 };
 
 G_DEFINE_TYPE (FuFrescoPdDevice, fu_fresco_pd_device, FU_TYPE_USB_DEVICE)
@@ -24,6 +28,7 @@ fu_fresco_pd_device_to_string (FuDevice *device, guint idt, GString *str)
 {
 	FuFrescoPdDevice *self = FU_FRESCO_PD_DEVICE (device);
 	fu_common_string_append_ku (str, idt, "CustomerID", self->customer_id);
+	fu_common_string_append_kb (str, idt, "BlockTransfers", self->block_transfers);
 }
 
 static gboolean
@@ -162,6 +167,96 @@ fu_fresco_pd_device_or_byte (FuFrescoPdDevice *self,
 	return fu_fresco_pd_device_write_byte (self, offset, buf, error);
 }
 
+static gboolean
+fu_fresco_pd_device_read_block (FuFrescoPdDevice *self,
+				guint16 offset,
+				guint8 *buf,
+				guint16 bufsz,
+				GError **error)
+{
+	/* one byte per transfer */
+	if (!self->block_transfers) {
+		for (guint16 i = 0; i < bufsz; i++) {
+			if (!fu_fresco_pd_device_read_byte (self, offset + i, &buf[i], error))
+				return FALSE;
+		}
+		return TRUE;
+	}
+	for (guint16 i = 0; i < bufsz; i += FU_FRESCO_PD_DEVICE_BLOCK_SIZE) {
+		guint16 len = MIN (bufsz - i, FU_FRESCO_PD_DEVICE_BLOCK_SIZE);
+		if (!fu_fresco_pd_device_transfer_read (self, offset + i, buf + i, len, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* only writes the runs of bytes that differ from what is already there */
+static gboolean
+fu_fresco_pd_device_set_block (FuFrescoPdDevice *self,
+			       guint16 offset,
+			       const guint8 *buf,
+			       guint16 bufsz,
+			       GError **error)
+{
+	guint8 current[FU_FRESCO_PD_DEVICE_BLOCK_SIZE] = { 0x0 };
+
+	g_return_val_if_fail (bufsz <= FU_FRESCO_PD_DEVICE_BLOCK_SIZE, FALSE);
+
+	if (!fu_fresco_pd_device_read_block (self, offset, current, bufsz, error))
+		return FALSE;
+	for (guint16 i = 0; i < bufsz;) {
+		guint16 len = 0;
+		if (current[i] == buf[i]) {
+			i++;
+			continue;
+		}
+		while (i + len < bufsz && current[i + len] != buf[i + len])
+			len++;
+		memcpy (current + i, buf + i, len);
+		if (self->block_transfers) {
+			if (!fu_fresco_pd_device_transfer_write (self, offset + i,
+								 current + i, len,
+								 error))
+				return FALSE;
+		} else {
+			for (guint16 j = i; j < i + len; j++) {
+				if (!fu_fresco_pd_device_write_byte (self, offset + j,
+								     current[j], error))
+					return FALSE;
+			}
+		}
+		i += len;
+	}
+
+	/* be paranoid, and never use block writes again if they did not work */
+	if (self->block_transfers) {
+		guint8 verify[FU_FRESCO_PD_DEVICE_BLOCK_SIZE] = { 0x0 };
+		if (!fu_fresco_pd_device_read_block (self, offset, verify, bufsz, error))
+			return FALSE;
+		if (memcmp (verify, buf, bufsz) != 0) {
+			g_debug ("block write at 0x%04x failed, using byte writes",
+				 offset);
+			self->block_transfers = FALSE;
+			return fu_fresco_pd_device_set_block (self, offset, buf, bufsz, error);
+		}
+	}
+	return TRUE;
+}
+
+/* the same bytes read one at a time and in one transfer must match */
+static void
+fu_fresco_pd_device_probe_block_transfers (FuFrescoPdDevice *self, const guint8 ver[4])
+{
+	guint8 buf[4] = { 0x0 };
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_fresco_pd_device_transfer_read (self, 0x3000, buf, sizeof(buf), &error_local)) {
+		g_debug ("block transfers not supported: %s", error_local->message);
+		return;
+	}
+	self->block_transfers = memcmp (buf, ver, sizeof(buf)) == 0;
+}
+
 static gboolean
 fu_fresco_pd_device_setup (FuDevice *device, GError **error)
 {
@@ -180,6 +275,7 @@ fu_fresco_pd_device_setup (FuDevice *device, GError **error)
 	}
 	version = fu_fresco_pd_version_from_buf (ver);
 	fu_device_set_version (FU_DEVICE (self), version);
+	fu_fresco_pd_device_probe_block_transfers (self, ver);
 
 	/* get customer ID */
 	self->customer_id = ver[1];
@@ -289,14 +385,10 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 	/* fill safe code in the boot code */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint16 i = 0; i < 0x400; i += 3) {
-		for (guint j = 0; j < 3; j++) {
-			if (!fu_fresco_pd_device_read_byte (self,
-							    begin_addr + i + j,
-							    &config[j],
-							    error)) {
-				g_prefix_error (error, "failed to read config byte %u: ", j);
-				return FALSE;
-			}
+		if (!fu_fresco_pd_device_read_block (self, begin_addr + i,
+						     config, sizeof(config), error)) {
+			g_prefix_error (error, "failed to read config: ");
+			return FALSE;
 		}
 		if (config[0] == start_symbols[0] &&
 		    config[1] == start_symbols[1]) {
@@ -308,11 +400,9 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 	}
 	g_debug ("begin_addr: 0x%04x", begin_addr);
 	for (guint16 i = begin_addr + 3; i < begin_addr + 0x400; i += 3) {
-		for (guint j = 0; j < 3; j++) {
-			if (!fu_fresco_pd_device_read_byte (self, i + j, &config[j], error)) {
-				g_prefix_error (error, "failed to read config byte %u: ", j);
-				return FALSE;
-			}
+		if (!fu_fresco_pd_device_read_block (self, i, config, sizeof(config), error)) {
+			g_prefix_error (error, "failed to read config: ");
+			return FALSE;
 		}
 		if (config[0] == 0x74 && config[1] == 0x06 && config[2] != 0x22) {
 			if (!fu_fresco_pd_device_write_byte (self, i + 2, 0x22, error))
@@ -326,8 +416,13 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 
 	/* copy buf offset [0 - 0x3FFFF] to mmio address [0x2000 - 0x5FFF] */
 	g_debug ("fill firmware body");
-	for (guint16 byte_index = 0; byte_index < 0x4000; byte_index++) {
-		if (!fu_fresco_pd_device_set_byte (self, byte_index + 0x2000, buf[byte_index], error))
+	for (guint16 byte_index = 0; byte_index < 0x4000;
+	     byte_index += FU_FRESCO_PD_DEVICE_BLOCK_SIZE) {
+		if (!fu_fresco_pd_device_set_block (self,
+						    byte_index + 0x2000,
+						    buf + byte_index,
+						    FU_FRESCO_PD_DEVICE_BLOCK_SIZE,
+						    error))
 			return FALSE;
 		fu_device_set_progress_full (device, (gsize) byte_index, 0x4000);
 	}
@@ -337,21 +432,11 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 	 * write file buf 0x4220 ~ 0x4225, 6 bytes to internal address 0x6620 ~ 0x6625
 	 * write file buf 0x4230, 1 byte, to internal address 0x6630 */
 	g_debug ("update customize data");
-	for (guint16 byte_index = 0; byte_index < 6; byte_index++) {
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6600 + byte_index,
-						   buf[0x4200 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6610 + byte_index,
-						   buf[0x4210 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   0x6620 + byte_index,
-						   buf[0x4220 + byte_index],
-						   error))
+	for (guint16 i = 0; i < 3; i++) {
+		if (!fu_fresco_pd_device_set_block (self,
+						    0x6600 + (i * 0x10),
+						    buf + 0x4200 + (i * 0x10),
+						    6, error))
 			return FALSE;
 	}
 	if (!fu_fresco_pd_device_set_byte (self, 0x6630, buf[0x4230], error))
@@ -360,21 +445,14 @@ fu_fresco_pd_device_write_firmware (FuDevice *device,
 	/* overwrite firmware file's boot code area (0x4020 ~ 0x41ff) to the area on the device marked by begin_addr
 	 * example: if the begin_addr = 0x6420, then copy file buf [0x4020 ~ 0x41ff] to device offset[0x6420 ~ 0x65ff] */
 	g_debug ("write boot configuration area");
-	for (guint16 byte_index = 0; byte_index < 0x1e0; byte_index += 3) {
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 0,
-						   buf[0x4020 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 1,
-						   buf[0x4021 + byte_index],
-						   error))
-			return FALSE;
-		if (!fu_fresco_pd_device_set_byte (self,
-						   begin_addr + byte_index + 2,
-						   buf[0x4022 + byte_index],
-						   error))
+	for (guint16 byte_index = 0; byte_index < 0x1e0;
+	     byte_index += FU_FRESCO_PD_DEVICE_BLOCK_SIZE) {
+		if (!fu_fresco_pd_device_set_block (self,
+						    begin_addr + byte_index,
+						    buf + 0x4020 + byte_index,
+						    MIN (0x1e0 - byte_index,
+							 FU_FRESCO_PD_DEVICE_BLOCK_SIZE),
+						    error))
 			return FALSE;
 	}
 
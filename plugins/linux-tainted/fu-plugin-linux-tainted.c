@@ -8,9 +8,16 @@
 
 #include "fu-plugin-vfuncs.h"
 
+typedef enum {
+	FU_PLUGIN_LINUX_TAINTED_INVALID,
+	FU_PLUGIN_LINUX_TAINTED_NO,
+	FU_PLUGIN_LINUX_TAINTED_YES,
+} FuPluginLinuxTainted;
+
 struct FuPluginData {
 	GFile			*file;
 	GFileMonitor		*monitor;
+	FuPluginLinuxTainted	 tainted;
 };
 
 void
@@ -32,6 +39,28 @@ fu_plugin_destroy (FuPlugin *plugin)
 	}
 }
 
+/* only read when the file changes rather than on every HSI refresh */
+static void
+fu_plugin_linux_tainted_rescan (FuPlugin *plugin)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	gsize bufsz = 0;
+	g_autofree gchar *buf = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!g_file_load_contents (data->file, NULL, &buf, &bufsz, NULL, &error_local)) {
+		g_autofree gchar *fn = g_file_get_path (data->file);
+		g_warning ("could not open %s: %s", fn, error_local->message);
+		data->tainted = FU_PLUGIN_LINUX_TAINTED_INVALID;
+		return;
+	}
+	if (g_strcmp0 (buf, "0\n") != 0) {
+		data->tainted = FU_PLUGIN_LINUX_TAINTED_YES;
+		return;
+	}
+	data->tainted = FU_PLUGIN_LINUX_TAINTED_NO;
+}
+
 static void
 fu_plugin_linux_tainted_changed_cb (GFileMonitor *monitor,
 				 GFile *file,
@@ -40,6 +69,7 @@ fu_plugin_linux_tainted_changed_cb (GFileMonitor *monitor,
 				 gpointer user_data)
 {
 	FuPlugin *plugin = FU_PLUGIN (user_data);
+	fu_plugin_linux_tainted_rescan (plugin);
 	fu_plugin_security_changed (plugin);
 }
 
@@ -58,6 +88,7 @@ fu_plugin_startup (FuPlugin *plugin, GError **error)
 		return FALSE;
 	g_signal_connect (data->monitor, "changed",
 			  G_CALLBACK (fu_plugin_linux_tainted_changed_cb), plugin);
+	fu_plugin_linux_tainted_rescan (plugin);
 	return TRUE;
 }
 
@@ -65,10 +96,7 @@ void
 fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
-	gsize bufsz = 0;
-	g_autofree gchar *buf = NULL;
 	g_autoptr(FwupdSecurityAttr) attr = NULL;
-	g_autoptr(GError) error_local = NULL;
 
 	/* create attr */
 	attr = fwupd_security_attr_new (FWUPD_SECURITY_ATTR_ID_KERNEL_TAINTED);
@@ -77,13 +105,11 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 	fu_security_attrs_append (attrs, attr);
 
 	/* load file */
-	if (!g_file_load_contents (data->file, NULL, &buf, &bufsz, NULL, &error_local)) {
-		g_autofree gchar *fn = g_file_get_path (data->file);
-		g_warning ("could not open %s: %s", fn, error_local->message);
+	if (data->tainted == FU_PLUGIN_LINUX_TAINTED_INVALID) {
 		fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
 		return;
 	}
-	if (g_strcmp0 (buf, "0\n") != 0) {
+	if (data->tainted == FU_PLUGIN_LINUX_TAINTED_YES) {
 		fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_TAINTED);
 		return;
 	}
@@ -78,51 +78,18 @@ fu_logitech_hidpp_bootloader_nordic_setup (FuLogitechHidPpBootloader *self, GErr
 	return TRUE;
 }
 
+/* WRITE and WRITE_RAM_BUFFER use distinct error codes so one check works for both */
 static gboolean
-fu_logitech_hidpp_bootloader_nordic_write_signature (FuLogitechHidPpBootloader *self,
-					       guint16 addr, guint8 len, const guint8 *data,
-					       GError **error)
+fu_logitech_hidpp_bootloader_nordic_check_cb (FuLogitechHidPpBootloader *self,
+					      FuLogitechHidPpBootloaderRequest *req,
+					      GError **error)
 {
-	g_autoptr(FuLogitechHidPpBootloaderRequest) req = fu_logitech_hidpp_bootloader_request_new();
-	req->cmd = 0xC0;
-	req->addr = addr;
-	req->len = len;
-	memcpy (req->data, data, req->len);
-	if (!fu_logitech_hidpp_bootloader_request (self, req, error)) {
-		g_prefix_error (error, "failed to write sig @0x%02x: ", addr);
-		return FALSE;
-	}
 	if (req->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_RAM_BUFFER_INVALID_ADDR) {
 		g_set_error (error,
 			     G_IO_ERROR,
 			     G_IO_ERROR_FAILED,
 			     "failed to write @%04x: signature is too big",
-			     addr);
-		return FALSE;
-	}
-	return TRUE;
-}
-
-static gboolean
-fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
-				     guint16 addr, guint8 len, const guint8 *data,
-				     GError **error)
-{
-	g_autoptr(FuLogitechHidPpBootloaderRequest) req = fu_logitech_hidpp_bootloader_request_new ();
-	req->cmd = FU_UNIFYING_BOOTLOADER_CMD_WRITE;
-	req->addr = addr;
-	req->len = len;
-	if (req->len > 28) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_FAILED,
-			     "failed to write @%04x: data length too large %02x",
-			     addr, req->len);
-		return FALSE;
-	}
-	memcpy (req->data, data, req->len);
-	if (!fu_logitech_hidpp_bootloader_request (self, req, error)) {
-		g_prefix_error (error, "failed to transfer fw @0x%02x: ", addr);
+			     req->addr);
 		return FALSE;
 	}
 	if (req->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_INVALID_ADDR) {
@@ -130,7 +97,7 @@ fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
 			     G_IO_ERROR,
 			     G_IO_ERROR_FAILED,
 			     "failed to write @%04x: invalid address",
-			     addr);
+			     req->addr);
 		return FALSE;
 	}
 	if (req->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_VERIFY_FAIL) {
@@ -138,7 +105,7 @@ fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
 			     G_IO_ERROR,
 			     G_IO_ERROR_FAILED,
 			     "failed to write @%04x: failed to verify flash content",
-			     addr);
+			     req->addr);
 		return FALSE;
 	}
 	if (req->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_NONZERO_START) {
@@ -148,7 +115,7 @@ fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
 			     G_IO_ERROR,
 			     G_IO_ERROR_FAILED,
 			     "failed to write @%04x: only 1 byte write of 0xff supported",
-			     addr);
+			     req->addr);
 		return FALSE;
 	}
 	if (req->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_INVALID_CRC) {
@@ -156,12 +123,37 @@ fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
 			     G_IO_ERROR,
 			     G_IO_ERROR_FAILED,
 			     "failed to write @%04x: invalid CRC",
-			     addr);
+			     req->addr);
 		return FALSE;
 	}
 	return TRUE;
 }
 
+static gboolean
+fu_logitech_hidpp_bootloader_nordic_write (FuLogitechHidPpBootloader *self,
+				     guint16 addr, guint8 len, const guint8 *data,
+				     GError **error)
+{
+	g_autoptr(FuLogitechHidPpBootloaderRequest) req = fu_logitech_hidpp_bootloader_request_new ();
+	req->cmd = FU_UNIFYING_BOOTLOADER_CMD_WRITE;
+	req->addr = addr;
+	req->len = len;
+	if (req->len > 28) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to write @%04x: data length too large %02x",
+			     addr, req->len);
+		return FALSE;
+	}
+	memcpy (req->data, data, req->len);
+	if (!fu_logitech_hidpp_bootloader_request (self, req, error)) {
+		g_prefix_error (error, "failed to transfer fw @0x%02x: ", addr);
+		return FALSE;
+	}
+	return fu_logitech_hidpp_bootloader_nordic_check_cb (self, req, error);
+}
+
 static gboolean
 fu_logitech_hidpp_bootloader_nordic_erase (FuLogitechHidPpBootloader *self, guint16 addr, GError **error)
 {
@@ -203,6 +195,7 @@ fu_logitech_hidpp_bootloader_nordic_write_firmware (FuDevice *device,
 	guint16 addr;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GPtrArray) reqs = NULL;
+	g_autoptr(GPtrArray) reqs_write = g_ptr_array_new_with_free_func (g_free);
 
 	/* get default image */
 	fw = fu_firmware_get_image_default_bytes (firmware, error);
@@ -222,29 +215,31 @@ fu_logitech_hidpp_bootloader_nordic_write_firmware (FuDevice *device,
 	reqs = fu_logitech_hidpp_bootloader_parse_requests (self, fw, error);
 	if (reqs == NULL)
 		return FALSE;
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 1; i < reqs->len; i++) {
-		gboolean res;
+		FuLogitechHidPpBootloaderRequest *req = fu_logitech_hidpp_bootloader_request_new ();
 		payload = g_ptr_array_index (reqs, i);
-
-		if (payload->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_SIGNATURE) {
-			res = fu_logitech_hidpp_bootloader_nordic_write_signature (self,
-										   payload->addr,
-										   payload->len,
-										   payload->data,
-										   error);
-		} else {
-			res = fu_logitech_hidpp_bootloader_nordic_write (self,
-									 payload->addr,
-									 payload->len,
-									 payload->data,
-									 error);
-		}
-
-		if (!res)
+		g_ptr_array_add (reqs_write, req);
+		if (payload->len > 28) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "failed to write @%04x: data length too large %02x",
+				     payload->addr, payload->len);
 			return FALSE;
-		fu_device_set_progress_full (device, i * 32, reqs->len * 32);
+		}
+		if (payload->cmd == FU_UNIFYING_BOOTLOADER_CMD_WRITE_SIGNATURE)
+			req->cmd = FU_UNIFYING_BOOTLOADER_CMD_WRITE_RAM_BUFFER;
+		else
+			req->cmd = FU_UNIFYING_BOOTLOADER_CMD_WRITE;
+		req->addr = payload->addr;
+		req->len = payload->len;
+		memcpy (req->data, payload->data, req->len);
 	}
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
+	if (!fu_logitech_hidpp_bootloader_request_many (self, reqs_write,
+							fu_logitech_hidpp_bootloader_nordic_check_cb,
+							error))
+		return FALSE;
 
 	/* send the first managed packet last, excluding the reset vector */
 	payload = g_ptr_array_index (reqs, 0);
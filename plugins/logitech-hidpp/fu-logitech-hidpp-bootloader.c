@@ -19,11 +19,14 @@ typedef struct
 	guint16			 flash_addr_lo;
 	guint16			 flash_addr_hi;
 	guint16			 flash_blocksize;
+	guint			 request_window;
 } FuLogitechHidPpBootloaderPrivate;
 
 #define FU_UNIFYING_DEVICE_EP1				0x81
 #define FU_UNIFYING_DEVICE_EP3				0x83
 
+#define FU_UNIFYING_BOOTLOADER_REQUEST_WINDOW_MAX	16
+
 G_DEFINE_TYPE_WITH_PRIVATE (FuLogitechHidPpBootloader, fu_logitech_hidpp_bootloader, FU_TYPE_HID_DEVICE)
 
 #define GET_PRIVATE(o) (fu_logitech_hidpp_bootloader_get_instance_private (o))
@@ -36,6 +39,7 @@ fu_logitech_hidpp_bootloader_to_string (FuDevice *device, guint idt, GString *st
 	fu_common_string_append_kx (str, idt, "FlashAddrHigh", priv->flash_addr_hi);
 	fu_common_string_append_kx (str, idt, "FlashAddrLow", priv->flash_addr_lo);
 	fu_common_string_append_kx (str, idt, "FlashBlockSize", priv->flash_blocksize);
+	fu_common_string_append_ku (str, idt, "RequestWindow", priv->request_window);
 }
 
 FuLogitechHidPpBootloaderRequest *
@@ -335,15 +339,13 @@ fu_logitech_hidpp_bootloader_close (FuDevice *device, GError **error)
 	return FU_DEVICE_CLASS (fu_logitech_hidpp_bootloader_parent_class)->close (device, error);
 }
 
-gboolean
-fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
-				      FuLogitechHidPpBootloaderRequest *req,
-				      GError **error)
+static gboolean
+fu_logitech_hidpp_bootloader_send (FuLogitechHidPpBootloader *self,
+				   FuLogitechHidPpBootloaderRequest *req,
+				   GError **error)
 {
 	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
-	gsize actual_length = 0;
 	guint8 buf_request[32];
-	guint8 buf_response[32];
 
 	/* build packet */
 	memset (buf_request, 0x00, sizeof (buf_request));
@@ -371,28 +373,17 @@ fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 			return FALSE;
 		}
 	}
+	return TRUE;
+}
 
-	/* no response required when rebooting */
-	if (usb_device != NULL &&
-	    req->cmd == FU_UNIFYING_BOOTLOADER_CMD_REBOOT) {
-		g_autoptr(GError) error_ignore = NULL;
-		if (!g_usb_device_interrupt_transfer (usb_device,
-						      FU_UNIFYING_DEVICE_EP1,
-						      buf_response,
-						      sizeof (buf_response),
-						      &actual_length,
-						      FU_UNIFYING_DEVICE_TIMEOUT_MS,
-						      NULL,
-						      &error_ignore)) {
-			g_debug ("ignoring: %s", error_ignore->message);
-		} else {
-			if (g_getenv ("FWUPD_LOGITECH_HIDPP") != NULL) {
-				fu_common_dump_raw (G_LOG_DOMAIN, "device->host",
-						    buf_response, actual_length);
-			}
-		}
-		return TRUE;
-	}
+static gboolean
+fu_logitech_hidpp_bootloader_recv (FuLogitechHidPpBootloader *self,
+				   FuLogitechHidPpBootloaderRequest *req,
+				   GError **error)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+	gsize actual_length = 0;
+	guint8 buf_response[32];
 
 	/* get response */
 	memset (buf_response, 0x00, sizeof (buf_response));
@@ -410,7 +401,7 @@ fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 		}
 	} else {
 		/* emulated */
-		buf_response[0] = buf_request[0];
+		buf_response[0] = req->cmd;
 		if (buf_response[0] == FU_UNIFYING_BOOTLOADER_CMD_GET_MEMINFO) {
 			buf_response[3] = 0x06; /* len */
 			buf_response[4] = 0x40; /* lo MSB */
@@ -452,9 +443,112 @@ fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
 	return TRUE;
 }
 
+gboolean
+fu_logitech_hidpp_bootloader_request (FuLogitechHidPpBootloader *self,
+				      FuLogitechHidPpBootloaderRequest *req,
+				      GError **error)
+{
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (self));
+
+	if (!fu_logitech_hidpp_bootloader_send (self, req, error))
+		return FALSE;
+
+	/* no response required when rebooting */
+	if (usb_device != NULL &&
+	    req->cmd == FU_UNIFYING_BOOTLOADER_CMD_REBOOT) {
+		gsize actual_length = 0;
+		guint8 buf_response[32];
+		g_autoptr(GError) error_ignore = NULL;
+		if (!g_usb_device_interrupt_transfer (usb_device,
+						      FU_UNIFYING_DEVICE_EP1,
+						      buf_response,
+						      sizeof (buf_response),
+						      &actual_length,
+						      FU_UNIFYING_DEVICE_TIMEOUT_MS,
+						      NULL,
+						      &error_ignore)) {
+			g_debug ("ignoring: %s", error_ignore->message);
+		} else {
+			if (g_getenv ("FWUPD_LOGITECH_HIDPP") != NULL) {
+				fu_common_dump_raw (G_LOG_DOMAIN, "device->host",
+						    buf_response, actual_length);
+			}
+		}
+		return TRUE;
+	}
+
+	return fu_logitech_hidpp_bootloader_recv (self, req, error);
+}
+
+/* sends up to RequestWindow requests before waiting for the first response,
+ * which is safe as the bootloader processes and replies to them in order */
+gboolean
+fu_logitech_hidpp_bootloader_request_many (FuLogitechHidPpBootloader *self,
+					   GPtrArray *reqs,
+					   FuLogitechHidPpBootloaderCheckFunc func,
+					   GError **error)
+{
+	FuLogitechHidPpBootloaderPrivate *priv = GET_PRIVATE (self);
+	guint idx_sent = 0;
+
+	for (guint i = 0; i < reqs->len; i++) {
+		FuLogitechHidPpBootloaderRequest *req = g_ptr_array_index (reqs, i);
+
+		/* keep the window full */
+		while (idx_sent < reqs->len && idx_sent - i < priv->request_window) {
+			FuLogitechHidPpBootloaderRequest *req_tmp = g_ptr_array_index (reqs, idx_sent);
+			if (!fu_logitech_hidpp_bootloader_send (self, req_tmp, error)) {
+				g_prefix_error (error, "failed to send @0x%04x: ", req_tmp->addr);
+				return FALSE;
+			}
+			idx_sent++;
+		}
+		if (!fu_logitech_hidpp_bootloader_recv (self, req, error)) {
+			g_prefix_error (error, "failed to transfer @0x%04x: ", req->addr);
+			return FALSE;
+		}
+		if (func != NULL && !func (self, req, error))
+			return FALSE;
+		fu_device_set_progress_full (FU_DEVICE (self), i + 1, reqs->len);
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_logitech_hidpp_bootloader_set_quirk_kv (FuDevice *device,
+					   const gchar *key,
+					   const gchar *value,
+					   GError **error)
+{
+	FuLogitechHidPpBootloader *self = FU_UNIFYING_BOOTLOADER (device);
+	FuLogitechHidPpBootloaderPrivate *priv = GET_PRIVATE (self);
+
+	if (g_strcmp0 (key, "LogitechHidppBootloaderWindow") == 0) {
+		guint64 tmp = fu_common_strtoull (value);
+		if (tmp >= 1 && tmp <= FU_UNIFYING_BOOTLOADER_REQUEST_WINDOW_MAX) {
+			priv->request_window = tmp;
+			return TRUE;
+		}
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "invalid request window");
+		return FALSE;
+	}
+
+	/* failed */
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "quirk key not supported");
+	return FALSE;
+}
+
 static void
 fu_logitech_hidpp_bootloader_init (FuLogitechHidPpBootloader *self)
 {
+	FuLogitechHidPpBootloaderPrivate *priv = GET_PRIVATE (self);
+	priv->request_window = 1;
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_UPDATABLE);
 	fu_device_add_flag (FU_DEVICE (self), FWUPD_DEVICE_FLAG_IS_BOOTLOADER);
 	fu_device_add_internal_flag (FU_DEVICE (self), FU_DEVICE_INTERNAL_FLAG_REPLUG_MATCH_GUID);
@@ -474,4 +568,5 @@ fu_logitech_hidpp_bootloader_class_init (FuLogitechHidPpBootloaderClass *klass)
 	klass_device->setup = fu_logitech_hidpp_bootloader_setup;
 	klass_device->open = fu_logitech_hidpp_bootloader_open;
 	klass_device->close = fu_logitech_hidpp_bootloader_close;
+	klass_device->set_quirk_kv = fu_logitech_hidpp_bootloader_set_quirk_kv;
 }
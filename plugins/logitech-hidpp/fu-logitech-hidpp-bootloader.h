@@ -59,6 +59,10 @@ typedef struct __attribute__((packed)) {
 
 FuLogitechHidPpBootloaderRequest	*fu_logitech_hidpp_bootloader_request_new	(void);
 
+typedef gboolean (*FuLogitechHidPpBootloaderCheckFunc)	(FuLogitechHidPpBootloader	*self,
+							 FuLogitechHidPpBootloaderRequest *req,
+							 GError				**error);
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-function"
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuLogitechHidPpBootloaderRequest, g_free);
@@ -70,6 +74,10 @@ GPtrArray	*fu_logitech_hidpp_bootloader_parse_requests	(FuLogitechHidPpBootloade
 gboolean	 fu_logitech_hidpp_bootloader_request		(FuLogitechHidPpBootloader	*self,
 								 FuLogitechHidPpBootloaderRequest *req,
 								 GError				**error);
+gboolean	 fu_logitech_hidpp_bootloader_request_many	(FuLogitechHidPpBootloader	*self,
+								 GPtrArray			*reqs,
+								 FuLogitechHidPpBootloaderCheckFunc func,
+								 GError				**error);
 
 guint16		 fu_logitech_hidpp_bootloader_get_addr_lo	(FuLogitechHidPpBootloader	*self);
 guint16		 fu_logitech_hidpp_bootloader_get_addr_hi	(FuLogitechHidPpBootloader	*self);
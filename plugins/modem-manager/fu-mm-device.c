@@ -343,11 +343,36 @@ fu_mm_device_probe (FuDevice *device, GError **error)
 	}
 }
 
+/* the response is complete when the last line is a final result code */
+static gboolean
+fu_mm_device_at_cmd_done_cb (GByteArray *buf, gpointer user_data)
+{
+	const gchar *final[] = { "OK", "ERROR", "+CME ERROR:", "+CMS ERROR:", NULL };
+	gsize linesz;
+	guint start;
+
+	if (buf->len < 2 || memcmp (buf->data + buf->len - 2, "\r\n", 2) != 0)
+		return FALSE;
+	for (start = buf->len - 2; start > 0; start--) {
+		if (buf->data[start - 1] == '\n')
+			break;
+	}
+	linesz = buf->len - 2 - start;
+	for (guint i = 0; final[i] != NULL; i++) {
+		gsize finalsz = strlen (final[i]);
+		if (linesz >= finalsz &&
+		    memcmp (buf->data + start, final[i], finalsz) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static gboolean
 fu_mm_device_at_cmd (FuMmDevice *self, const gchar *cmd, GError **error)
 {
 	const gchar *buf;
 	gsize bufsz = 0;
+	g_autoptr(GByteArray) at_buf = NULL;
 	g_autoptr(GBytes) at_req  = NULL;
 	g_autoptr(GBytes) at_res  = NULL;
 	g_autofree gchar *cmd_cr = g_strdup_printf ("%s\r\n", cmd);
@@ -363,12 +388,15 @@ fu_mm_device_at_cmd (FuMmDevice *self, const gchar *cmd, GError **error)
 	}
 
 	/* response */
-	at_res = fu_io_channel_read_bytes (self->io_channel, -1, 1500,
-					   FU_IO_CHANNEL_FLAG_SINGLE_SHOT, error);
-	if (at_res == NULL) {
+	at_buf = fu_io_channel_read_byte_array_full (self->io_channel, -1, 1500,
+						     FU_IO_CHANNEL_FLAG_NONE,
+						     fu_mm_device_at_cmd_done_cb,
+						     NULL, error);
+	if (at_buf == NULL) {
 		g_prefix_error (error, "failed to read response for %s: ", cmd);
 		return FALSE;
 	}
+	at_res = g_byte_array_free_to_bytes (g_steal_pointer (&at_buf));
 	if (g_getenv ("FWUPD_MODEM_MANAGER_VERBOSE") != NULL)
 		fu_common_dump_bytes (G_LOG_DOMAIN, "read", at_res);
 	buf = g_bytes_get_data (at_res, &bufsz);
@@ -557,6 +585,7 @@ fu_mm_qmi_pdc_archive_iterate_mcfg (FuArchive	*archive,
 	file_info = g_new0 (FuMmFileInfo, 1);
 	file_info->filename = g_strdup (filename);
 	file_info->bytes = g_bytes_ref (bytes);
+	file_info->digest = fu_qmi_pdc_updater_get_checksum (bytes);
 	file_info->active = fu_mm_should_be_active (fu_device_get_version (FU_DEVICE (ctx->device)), filename);
 	g_ptr_array_add (ctx->file_infos, file_info);
 	return TRUE;
@@ -606,6 +635,14 @@ fu_mm_device_write_firmware_qmi_pdc (FuDevice *device, GBytes *fw, GArray **acti
 	if (archive == NULL)
 		return FALSE;
 
+	/* process the list of MCFG files to write, getting the checksums
+	 * before the modem is opened */
+	if (!fu_archive_iterate (archive,
+				 fu_mm_qmi_pdc_archive_iterate_mcfg,
+				 &archive_context,
+				 error))
+		return FALSE;
+
 	/* boot to fastboot mode */
 	locker = fu_device_locker_new_full (device,
 					    (FuDeviceLockerFunc) fu_mm_device_qmi_open,
@@ -614,20 +651,13 @@ fu_mm_device_write_firmware_qmi_pdc (FuDevice *device, GBytes *fw, GArray **acti
 	if (locker == NULL)
 		return FALSE;
 
-	/* process the list of MCFG files to write */
-	if (!fu_archive_iterate (archive,
-				 fu_mm_qmi_pdc_archive_iterate_mcfg,
-				 &archive_context,
-				 error))
-		return FALSE;
-
 	for (guint i = 0; i < file_infos->len; i++) {
 		FuMmFileInfo *file_info = g_ptr_array_index (file_infos, i);
-		file_info->digest = fu_qmi_pdc_updater_write (archive_context.device->qmi_pdc_updater,
-							      file_info->filename,
-							      file_info->bytes,
-							      &archive_context.error);
-		if (file_info->digest == NULL) {
+		if (!fu_qmi_pdc_updater_write (archive_context.device->qmi_pdc_updater,
+					       file_info->filename,
+					       file_info->bytes,
+					       file_info->digest,
+					       &archive_context.error)) {
 			g_prefix_error (&archive_context.error,
 					"Failed to write file '%s':", file_info->filename);
 			break;
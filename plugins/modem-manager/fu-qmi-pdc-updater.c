@@ -212,6 +212,8 @@ fu_qmi_pdc_updater_close (FuQmiPdcUpdater *self, GError **error)
 	return TRUE;
 }
 
+/* the PDC service has no way to query the chunk size, and this is the
+ * largest size that is accepted by all the modems we know about */
 #define QMI_LOAD_CHUNK_SIZE 0x400
 
 typedef struct {
@@ -222,6 +224,7 @@ typedef struct {
 	guint		 timeout_id;
 	GBytes		*blob;
 	GArray		*digest;
+	GArray		*chunk;		/* reused for each request */
 	gsize		 offset;
 	guint		 token;
 } WriteContext;
@@ -343,7 +346,6 @@ static void
 fu_qmi_pdc_updater_load_config (WriteContext *ctx)
 {
 	g_autoptr(QmiMessagePdcLoadConfigInput) input = NULL;
-	g_autoptr(GArray) chunk = NULL;
 	gsize full_size;
 	gsize chunk_size;
 	g_autoptr(GError) error = NULL;
@@ -357,9 +359,8 @@ fu_qmi_pdc_updater_load_config (WriteContext *ctx)
 	else
 		chunk_size = QMI_LOAD_CHUNK_SIZE;
 
-	chunk = g_array_sized_new (FALSE, FALSE, sizeof (guint8), chunk_size);
-	g_array_set_size (chunk, chunk_size);
-	if (!fu_memcpy_safe ((guint8 *)chunk->data, chunk_size, 0x0,			/* dst */
+	g_array_set_size (ctx->chunk, chunk_size);
+	if (!fu_memcpy_safe ((guint8 *)ctx->chunk->data, chunk_size, 0x0,		/* dst */
 			     (const guint8 *)g_bytes_get_data (ctx->blob, NULL),	/* src */
 			     g_bytes_get_size (ctx->blob), ctx->offset,
 			     chunk_size, &error)) {
@@ -370,7 +371,7 @@ fu_qmi_pdc_updater_load_config (WriteContext *ctx)
 							    QMI_PDC_CONFIGURATION_TYPE_SOFTWARE,
 							    ctx->digest,
 							    full_size,
-							    chunk,
+							    ctx->chunk,
 							    NULL);
 	ctx->offset += chunk_size;
 
@@ -378,7 +379,7 @@ fu_qmi_pdc_updater_load_config (WriteContext *ctx)
 				    fu_qmi_pdc_updater_load_config_ready, ctx);
 }
 
-static GArray *
+GArray *
 fu_qmi_pdc_updater_get_checksum (GBytes *blob)
 {
 	gsize file_size;
@@ -399,11 +400,16 @@ fu_qmi_pdc_updater_get_checksum (GBytes *blob)
 	return digest;
 }
 
-GArray *
-fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self, const gchar *filename, GBytes *blob, GError **error)
+gboolean
+fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self,
+			  const gchar *filename,
+			  GBytes *blob,
+			  GArray *digest,
+			  GError **error)
 {
 	g_autoptr(GMainLoop) mainloop = g_main_loop_new (NULL, FALSE);
-	g_autoptr(GArray) digest = fu_qmi_pdc_updater_get_checksum (blob);
+	g_autoptr(GArray) chunk = g_array_sized_new (FALSE, FALSE, sizeof (guint8),
+						     QMI_LOAD_CHUNK_SIZE);
 	WriteContext ctx = {
 		.mainloop = mainloop,
 		.qmi_client = self->qmi_client,
@@ -412,6 +418,7 @@ fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self, const gchar *filename, GBytes *
 		.timeout_id = 0,
 		.blob = blob,
 		.digest = digest,
+		.chunk = chunk,
 		.offset = 0,
 		.token = 0,
 	};
@@ -421,10 +428,10 @@ fu_qmi_pdc_updater_write (FuQmiPdcUpdater *self, const gchar *filename, GBytes *
 
 	if (ctx.error != NULL) {
 		g_propagate_error (error, ctx.error);
-		return NULL;
+		return FALSE;
 	}
 
-	return g_steal_pointer (&digest);
+	return TRUE;
 }
 
 typedef struct {
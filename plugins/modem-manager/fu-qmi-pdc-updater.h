@@ -15,9 +15,11 @@ G_DECLARE_FINAL_TYPE (FuQmiPdcUpdater, fu_qmi_pdc_updater, FU, QMI_PDC_UPDATER,
 FuQmiPdcUpdater	*fu_qmi_pdc_updater_new		(const gchar		*qmi_port);
 gboolean	 fu_qmi_pdc_updater_open	(FuQmiPdcUpdater	*self,
 						 GError			**error);
-GArray		*fu_qmi_pdc_updater_write	(FuQmiPdcUpdater	*self,
+GArray		*fu_qmi_pdc_updater_get_checksum	(GBytes		*blob);
+gboolean	 fu_qmi_pdc_updater_write	(FuQmiPdcUpdater	*self,
 						 const gchar		*filename,
 						 GBytes			*blob,
+						 GArray			*digest,
 						 GError			**error);
 gboolean	 fu_qmi_pdc_updater_activate	(FuQmiPdcUpdater	*self,
 						 GArray			*digest,
@@ -6,19 +6,23 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <sys/ioctl.h>
 #include <linux/nvme_ioctl.h>
 
-#include "fu-chunk.h"
 #include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
-#define FU_NVME_ID_CTRL_SIZE	0x1000
+#define FU_NVME_ID_CTRL_SIZE		0x1000
+#define FU_NVME_WRITE_BLOCK_SIZE_MIN	0x1000
+#define FU_NVME_WRITE_BLOCK_SIZE_MAX	0x40000
 
 struct _FuNvmeDevice {
 	FuUdevDevice		 parent_instance;
 	guint			 pci_depth;
-	guint64			 write_block_size;
+	guint64			 write_block_size;	/* from quirk */
+	guint64			 write_granularity;	/* FWUG, or 0 for unknown */
+	guint64			 write_max_size;	/* MDTS, or 0 for unlimited */
 };
 
 G_DEFINE_TYPE (FuNvmeDevice, fu_nvme_device, FU_TYPE_UDEV_DEVICE)
@@ -29,6 +33,10 @@ fu_nvme_device_to_string (FuDevice *device, guint idt, GString *str)
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
 	FU_DEVICE_CLASS (fu_nvme_device_parent_class)->to_string (device, idt, str);
 	fu_common_string_append_ku (str, idt, "PciDepth", self->pci_depth);
+	if (self->write_granularity > 0)
+		fu_common_string_append_kx (str, idt, "WriteGranularity", self->write_granularity);
+	if (self->write_max_size > 0)
+		fu_common_string_append_kx (str, idt, "WriteMaxSize", self->write_max_size);
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -190,6 +198,7 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 {
 	guint8 fawr;
 	guint8 fwug;
+	guint8 mdts;
 	guint8 nfws;
 	guint8 s1ro;
 	g_autofree gchar *gu = NULL;
@@ -219,10 +228,18 @@ fu_nvme_device_parse_cns (FuNvmeDevice *self, const guint8 *buf, gsize sz, GErro
 	if (sr != NULL)
 		fu_device_set_version (FU_DEVICE (self), sr);
 
-	/* firmware update granularity (FWUG) */
+	/* maximum data transfer size (MDTS) in units of the minimum page size,
+	 * assumed to be 4KiB */
+	mdts = buf[77];
+	if (mdts != 0x00 && mdts < 32)
+		self->write_max_size = ((guint64) 1 << mdts) * 0x1000;
+
+	/* firmware update granularity (FWUG), where 0xff means no restriction */
 	fwug = buf[319];
-	if (fwug != 0x00 && fwug != 0xff)
-		self->write_block_size = ((guint64) fwug) * 0x1000;
+	if (fwug == 0xff)
+		self->write_granularity = FU_NVME_WRITE_BLOCK_SIZE_MIN;
+	else if (fwug != 0x00)
+		self->write_granularity = ((guint64) fwug) * 0x1000;
 
 	/* firmware slot information */
 	fawr = (buf[260] & 0x10) >> 4;
@@ -310,51 +327,76 @@ fu_nvme_device_setup (FuDevice *device, GError **error)
 	return TRUE;
 }
 
+/* as few commands as possible, each a whole number of granules */
+static guint64
+fu_nvme_device_get_write_block_size (FuNvmeDevice *self)
+{
+	guint64 block_size = FU_NVME_WRITE_BLOCK_SIZE_MAX;
+
+	/* set explicitly */
+	if (self->write_block_size > 0)
+		return self->write_block_size;
+
+	/* no granularity reported, so be conservative */
+	if (self->write_granularity == 0)
+		return FU_NVME_WRITE_BLOCK_SIZE_MIN;
+
+	if (self->write_max_size > 0)
+		block_size = MIN (block_size, self->write_max_size);
+	block_size -= block_size % self->write_granularity;
+	if (block_size == 0)
+		block_size = self->write_granularity;
+	return block_size;
+}
+
 static gboolean
-fu_nvme_device_write_firmware (FuDevice *device,
-			       FuFirmware *firmware,
-			       FwupdInstallFlags flags,
-			       GError **error)
+fu_nvme_device_write_stream (FuDevice *device,
+			     GInputStream *stream,
+			     gsize streamsz,
+			     FwupdInstallFlags flags,
+			     GError **error)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE (device);
-	g_autoptr(GBytes) fw2 = NULL;
-	g_autoptr(GBytes) fw = NULL;
-	g_autoptr(GPtrArray) chunks = NULL;
-	guint64 block_size = self->write_block_size > 0 ?
-			     self->write_block_size : 0x1000;
-
-	/* get default image */
-	fw = fu_firmware_get_image_default_bytes (firmware, error);
-	if (fw == NULL)
-		return FALSE;
-
-	/* some vendors provide firmware files whose sizes are not multiples
-	 * of blksz *and* the device won't accept blocks of different sizes */
-	if (fu_device_has_custom_flag (device, "force-align")) {
-		fw2 = fu_common_bytes_align (fw, block_size, 0xff);
-	} else {
-		fw2 = g_bytes_ref (fw);
-	}
-
-	/* build packets */
-	chunks = fu_chunk_array_new_from_bytes (fw2,
-						0x00,		/* start_addr */
-						0x00,		/* page_sz */
-						block_size);	/* block size */
-
-	/* write each block */
+	guint64 block_size = fu_nvme_device_get_write_block_size (self);
+	guint chunks = (streamsz + block_size - 1) / block_size;
+	g_autofree guint8 *buf = g_malloc (block_size);
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* write each block as it is read, so only one is ever in memory */
+	g_debug ("writing %u chunks of 0x%x bytes",
+		 chunks, (guint) block_size);
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
+	for (guint i = 0; i < chunks; i++) {
+		gsize bufsz = 0;
+		if (!g_input_stream_read_all (stream, buf, block_size, &bufsz, NULL, error)) {
+			g_prefix_error (error, "failed to read chunk %u: ", i);
+			return FALSE;
+		}
+		if (bufsz == 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "payload truncated at chunk %u", i);
+			return FALSE;
+		}
+
+		/* some vendors provide firmware files whose sizes are not multiples
+		 * of blksz *and* the device won't accept blocks of different sizes */
+		if (bufsz < block_size && fu_device_has_custom_flag (device, "force-align")) {
+			memset (buf + bufsz, 0xff, block_size - bufsz);
+			bufsz = block_size;
+		}
+		g_timer_start (timer);
 		if (!fu_nvme_device_fw_download (self,
-						 fu_chunk_get_address (chk),
-						 fu_chunk_get_data (chk),
-						 fu_chunk_get_data_sz (chk),
+						 (guint32) (i * block_size),
+						 buf,
+						 (guint32) bufsz,
 						 error)) {
 			g_prefix_error (error, "failed to write chunk %u: ", i);
 			return FALSE;
 		}
-		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks->len + 1);
+		g_debug ("chunk %u took %.1fms", i, g_timer_elapsed (timer, NULL) * 1000.f);
+		fu_device_set_progress_full (device, (gsize) i, (gsize) chunks + 1);
 	}
 
 	/* commit */
@@ -402,6 +444,7 @@ fu_nvme_device_init (FuNvmeDevice *self)
 	fu_device_add_protocol (FU_DEVICE (self), "org.nvmexpress");
 	fu_udev_device_set_flags (FU_UDEV_DEVICE (self),
 				  FU_UDEV_DEVICE_FLAG_OPEN_READ |
+				  FU_UDEV_DEVICE_FLAG_KEEP_OPEN |
 				  FU_UDEV_DEVICE_FLAG_VENDOR_FROM_PARENT);
 }
 
@@ -420,7 +463,7 @@ fu_nvme_device_class_init (FuNvmeDeviceClass *klass)
 	klass_device->to_string = fu_nvme_device_to_string;
 	klass_device->set_quirk_kv = fu_nvme_device_set_quirk_kv;
 	klass_device->setup = fu_nvme_device_setup;
-	klass_device->write_firmware = fu_nvme_device_write_firmware;
+	klass_device->write_stream = fu_nvme_device_write_stream;
 	klass_device->probe = fu_nvme_device_probe;
 }
 
@@ -23,7 +23,8 @@ fu_optionrom_device_probe (FuDevice *device, GError **error)
 	if (!FU_DEVICE_CLASS (fu_optionrom_device_parent_class)->probe (device, error))
 		return FALSE;
 
-	/* does the device even have ROM? */
+	/* does the device even have ROM? the contents are only read when
+	 * dumping or verifying as enabling the ROM BAR can be slow */
 	fn = g_build_filename (fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device)), "rom", NULL);
 	if (!g_file_test (fn, G_FILE_TEST_EXISTS)) {
 		g_set_error_literal (error,
@@ -37,14 +38,58 @@ fu_optionrom_device_probe (FuDevice *device, GError **error)
 	return fu_udev_device_set_physical_id (FU_UDEV_DEVICE (device), "pci", error);
 }
 
+/* the kernel only exposes the ROM BAR contents while it is enabled */
+static gboolean
+fu_optionrom_device_set_rom_enabled (GFile *file, gboolean enabled, GError **error)
+{
+	g_autoptr(GFileOutputStream) output_stream = NULL;
+	output_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
+					NULL, error);
+	if (output_stream == NULL)
+		return FALSE;
+	return g_output_stream_write (G_OUTPUT_STREAM (output_stream),
+				      enabled ? "1" : "0", 1,
+				      NULL, error) >= 0;
+}
+
+static GByteArray *
+fu_optionrom_device_read_stream (GInputStream *stream, GError **error)
+{
+	guint number_reads = 0;
+	g_autoptr(GByteArray) buf = g_byte_array_new ();
+
+	/* ensure we got enough data to fill the buffer */
+	while (TRUE) {
+		gssize sz;
+		guint8 tmp[32 * 1024] = { 0x0 };
+		sz = g_input_stream_read (stream, tmp, sizeof(tmp), NULL, error);
+		if (sz == 0)
+			break;
+		g_debug ("ROM returned 0x%04x bytes", (guint) sz);
+		if (sz < 0)
+			return NULL;
+		g_byte_array_append (buf, tmp, sz);
+
+		/* check the firmware isn't serving us small chunks */
+		if (number_reads++ > 1024) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "firmware not fulfilling requests");
+			return NULL;
+		}
+	}
+	return g_steal_pointer (&buf);
+}
+
 static GBytes *
 fu_optionrom_device_dump_firmware (FuDevice *device, GError **error)
 {
 	FuUdevDevice *udev_device = FU_UDEV_DEVICE (device);
-	guint number_reads = 0;
+	gboolean sysfs;
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *rom_fn = NULL;
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
+	g_autoptr(GByteArray) buf = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GFile) file = NULL;
 	g_autoptr(GInputStream) stream = NULL;
@@ -72,38 +117,21 @@ fu_optionrom_device_dump_firmware (FuDevice *device, GError **error)
 
 	/* we have to enable the read for devices */
 	fn = g_file_get_path (file);
-	if (g_str_has_prefix (fn, "/sys")) {
-		g_autoptr(GFileOutputStream) output_stream = NULL;
-		output_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
-						NULL, error);
-		if (output_stream == NULL)
-			return NULL;
-		if (g_output_stream_write (G_OUTPUT_STREAM (output_stream), "1", 1,
-					   NULL, error) < 0)
+	sysfs = g_str_has_prefix (fn, "/sys");
+	if (sysfs) {
+		if (!fu_optionrom_device_set_rom_enabled (file, TRUE, error))
 			return NULL;
 	}
+	buf = fu_optionrom_device_read_stream (stream, error);
 
-	/* ensure we got enough data to fill the buffer */
-	while (TRUE) {
-		gssize sz;
-		guint8 tmp[32 * 1024] = { 0x0 };
-		sz = g_input_stream_read (stream, tmp, sizeof(tmp), NULL, error);
-		if (sz == 0)
-			break;
-		g_debug ("ROM returned 0x%04x bytes", (guint) sz);
-		if (sz < 0)
-			return NULL;
-		g_byte_array_append (buf, tmp, sz);
-
-		/* check the firmware isn't serving us small chunks */
-		if (number_reads++ > 1024) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INVALID_FILE,
-					     "firmware not fulfilling requests");
-			return NULL;
-		}
+	/* do not leave the ROM BAR decoding once finished */
+	if (sysfs) {
+		g_autoptr(GError) error_disable = NULL;
+		if (!fu_optionrom_device_set_rom_enabled (file, FALSE, &error_disable))
+			g_warning ("failed to disable ROM: %s", error_disable->message);
 	}
+	if (buf == NULL)
+		return NULL;
 	if (buf->len < 512) {
 		g_set_error (error,
 			     FWUPD_ERROR,
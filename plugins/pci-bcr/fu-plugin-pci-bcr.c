@@ -176,7 +176,8 @@ fu_plugin_backend_device_added (FuPlugin *plugin, FuDevice *device, GError **err
 		return FALSE;
 
 	/* grab BIOS Control Register */
-	if (!fu_udev_device_pread (FU_UDEV_DEVICE (device), priv->bcr_addr, &priv->bcr, error)) {
+	if (!fu_udev_device_read_config (FU_UDEV_DEVICE (device), priv->bcr_addr,
+					 &priv->bcr, sizeof(priv->bcr), error)) {
 		g_prefix_error (error, "could not read BCR: ");
 		return FALSE;
 	}
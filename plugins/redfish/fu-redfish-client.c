@@ -19,10 +19,16 @@
 #include "fu-redfish-client.h"
 #include "fu-redfish-common.h"
 
+/* maximum number of inventory members to fetch at the same time */
+#define FU_REDFISH_CLIENT_MAX_IN_FLIGHT		8
+
 struct _FuRedfishClient
 {
 	GObject			 parent_instance;
 	CURL			*curl;
+	CURLM			*multi;		/* shares connections between requests */
+	GHashTable		*cache;		/* uri_path:FuRedfishClientCacheItem */
+	gboolean		 expand_supported;
 	gchar			*hostname;
 	guint			 port;
 	gchar			*update_uri_path;
@@ -40,6 +46,43 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(curlptr, curl_free)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(CURLU, curl_url_cleanup)
 #endif
 
+typedef struct {
+	gchar			*etag;
+	GBytes			*blob;
+} FuRedfishClientCacheItem;
+
+typedef struct {
+	CURL			*curl;
+	gchar			*uri;
+	const gchar		*uri_path;
+	GByteArray		*buf;
+	gchar			*etag;
+	struct curl_slist	*headers;
+} FuRedfishClientRequest;
+
+static void
+fu_redfish_client_cache_item_free (FuRedfishClientCacheItem *item)
+{
+	g_free (item->etag);
+	g_bytes_unref (item->blob);
+	g_free (item);
+}
+
+static void
+fu_redfish_client_request_free (FuRedfishClientRequest *req)
+{
+	if (req->curl != NULL)
+		curl_easy_cleanup (req->curl);
+	if (req->headers != NULL)
+		curl_slist_free_all (req->headers);
+	g_byte_array_unref (req->buf);
+	g_free (req->etag);
+	g_free (req->uri);
+	g_free (req);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuRedfishClientRequest, fu_redfish_client_request_free)
+
 static size_t
 fu_redfish_client_fetch_data_cb (char *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -49,73 +92,176 @@ fu_redfish_client_fetch_data_cb (char *ptr, size_t size, size_t nmemb, void *use
 	return realsize;
 }
 
-static GBytes *
-fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+static size_t
+fu_redfish_client_fetch_header_cb (char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-	CURLcode res;
-	g_autofree gchar *port = g_strdup_printf ("%u", self->port);
-	g_autoptr(GByteArray) buf = g_byte_array_new ();
-#ifdef HAVE_LIBCURL_7_62_0
-	g_autoptr(CURLU) uri = NULL;
-#else
-	g_autofree gchar *uri = NULL;
-#endif
+	FuRedfishClientRequest *req = (FuRedfishClientRequest *) userdata;
+	gsize realsize = size * nmemb;
+	if (realsize > 5 && g_ascii_strncasecmp (ptr, "ETag:", 5) == 0) {
+		g_free (req->etag);
+		req->etag = g_strstrip (g_strndup (ptr + 5, realsize - 5));
+	}
+	return realsize;
+}
 
-	/* create URI */
-#ifdef HAVE_LIBCURL_7_62_0
-	uri = curl_url ();
-	curl_url_set (uri, CURLU_DEFAULT_SCHEME, self->use_https ? "https" : "http", 0);
-	curl_url_set (uri, CURLUPART_PATH, uri_path, 0);
-	curl_url_set (uri, CURLUPART_HOST, self->hostname, 0);
-	curl_url_set (uri, CURLUPART_PORT, port, 0);
-	if (curl_easy_setopt (self->curl, CURLOPT_CURLU, uri) != CURLE_OK) {
+/* the request inherits the credentials and TLS options from self->curl */
+static FuRedfishClientRequest *
+fu_redfish_client_request_new (FuRedfishClient *self, const gchar *uri_path, GError **error)
+{
+	FuRedfishClientCacheItem *item = g_hash_table_lookup (self->cache, uri_path);
+	g_autoptr(FuRedfishClientRequest) req = g_new0 (FuRedfishClientRequest, 1);
+
+	req->uri_path = uri_path;
+	req->buf = g_byte_array_new ();
+	req->uri = g_strdup_printf ("%s://%s:%u%s",
+				    self->use_https ? "https" : "http",
+				    self->hostname,
+				    self->port,
+				    uri_path);
+	req->curl = curl_easy_duphandle (self->curl);
+	if (req->curl == NULL ||
+	    curl_easy_setopt (req->curl, CURLOPT_URL, req->uri) != CURLE_OK) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_INVALID_FILE,
 				     "failed to create message for URI");
 		return NULL;
 	}
-#else
-	uri = g_strdup_printf ("%s://%s:%s%s",
-			       self->use_https ? "https" : "http",
-			       self->hostname,
-			       port,
-			       uri_path);
-	if (curl_easy_setopt (self->curl, CURLOPT_URL, uri) != CURLE_OK) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_FILE,
-				     "failed to create message for URI");
-		return NULL;
+	curl_easy_setopt (req->curl, CURLOPT_PRIVATE, req);
+	curl_easy_setopt (req->curl, CURLOPT_WRITEFUNCTION, fu_redfish_client_fetch_data_cb);
+	curl_easy_setopt (req->curl, CURLOPT_WRITEDATA, req->buf);
+	curl_easy_setopt (req->curl, CURLOPT_HEADERFUNCTION, fu_redfish_client_fetch_header_cb);
+	curl_easy_setopt (req->curl, CURLOPT_HEADERDATA, req);
+
+	/* only download the member again if it has changed */
+	if (item != NULL && item->etag != NULL) {
+		g_autofree gchar *hdr = g_strdup_printf ("If-None-Match: %s", item->etag);
+		req->headers = curl_slist_append (req->headers, hdr);
+		curl_easy_setopt (req->curl, CURLOPT_HTTPHEADER, req->headers);
 	}
-#endif
-	curl_easy_setopt (self->curl, CURLOPT_WRITEFUNCTION, fu_redfish_client_fetch_data_cb);
-	curl_easy_setopt (self->curl, CURLOPT_WRITEDATA, buf);
-	res = curl_easy_perform (self->curl);
+	return g_steal_pointer (&req);
+}
+
+static GBytes *
+fu_redfish_client_request_finish (FuRedfishClient *self,
+				  FuRedfishClientRequest *req,
+				  CURLcode res,
+				  GError **error)
+{
+	FuRedfishClientCacheItem *item;
+	glong status_code = 0;
+	g_autoptr(GBytes) blob = NULL;
+
 	if (res != CURLE_OK) {
-		glong status_code = 0;
-#ifdef HAVE_LIBCURL_7_62_0
-		g_autoptr(curlptr) uri_str = NULL;
-#endif
-		curl_easy_getinfo (self->curl, CURLINFO_RESPONSE_CODE, &status_code);
-#ifdef HAVE_LIBCURL_7_62_0
-		curl_url_get (uri, CURLUPART_URL, &uri_str, 0);
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INVALID_FILE,
-			     "failed to download %s: %s",
-			     uri_str, curl_easy_strerror (res));
-#else
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to download %s: %s",
-			     uri, curl_easy_strerror (res));
-#endif
+			     req->uri, curl_easy_strerror (res));
 		return NULL;
 	}
 
-	return g_byte_array_free_to_bytes (g_steal_pointer (&buf));
+	/* not modified since the last coldplug */
+	curl_easy_getinfo (req->curl, CURLINFO_RESPONSE_CODE, &status_code);
+	item = g_hash_table_lookup (self->cache, req->uri_path);
+	if (status_code == 304 && item != NULL)
+		return g_bytes_ref (item->blob);
+
+	blob = g_byte_array_free_to_bytes (g_steal_pointer (&req->buf));
+	req->buf = g_byte_array_new ();
+	if (status_code == 200 && req->etag != NULL) {
+		item = g_new0 (FuRedfishClientCacheItem, 1);
+		item->etag = g_strdup (req->etag);
+		item->blob = g_bytes_ref (blob);
+		g_hash_table_insert (self->cache, g_strdup (req->uri_path), item);
+	}
+	return g_steal_pointer (&blob);
+}
+
+/* fetches each of @uri_paths using a bounded number of concurrent requests,
+ * returning the data in the same order */
+static GPtrArray *
+fu_redfish_client_fetch_data_many (FuRedfishClient *self, GPtrArray *uri_paths, GError **error)
+{
+	guint done = 0;
+	guint idx = 0;
+	g_autoptr(GPtrArray) blobs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	g_autoptr(GPtrArray) reqs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_redfish_client_request_free);
+	g_autoptr(GError) error_local = NULL;
+
+	for (guint i = 0; i < uri_paths->len; i++) {
+		const gchar *uri_path = g_ptr_array_index (uri_paths, i);
+		FuRedfishClientRequest *req = fu_redfish_client_request_new (self, uri_path, error);
+		if (req == NULL)
+			return NULL;
+		g_ptr_array_add (reqs, req);
+		g_ptr_array_add (blobs, NULL);
+	}
+
+	while (done < reqs->len && error_local == NULL) {
+		CURLMsg *msg;
+		gint msgs_left = 0;
+		gint running = 0;
+
+		/* keep the pipeline full */
+		while (idx < reqs->len && idx - done < FU_REDFISH_CLIENT_MAX_IN_FLIGHT) {
+			FuRedfishClientRequest *req = g_ptr_array_index (reqs, idx++);
+			curl_multi_add_handle (self->multi, req->curl);
+		}
+		if (curl_multi_perform (self->multi, &running) != CURLM_OK) {
+			g_set_error_literal (&error_local,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INTERNAL,
+					     "failed to perform requests");
+			break;
+		}
+		while ((msg = curl_multi_info_read (self->multi, &msgs_left)) != NULL) {
+			FuRedfishClientRequest *req = NULL;
+			GBytes *blob;
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+			curl_easy_getinfo (msg->easy_handle, CURLINFO_PRIVATE, (gchar **) &req);
+			curl_multi_remove_handle (self->multi, req->curl);
+			done++;
+			if (error_local != NULL)
+				continue;
+			blob = fu_redfish_client_request_finish (self, req, msg->data.result, &error_local);
+			if (blob == NULL)
+				continue;
+			for (guint i = 0; i < reqs->len; i++) {
+				if (g_ptr_array_index (reqs, i) == req) {
+					g_ptr_array_index (blobs, i) = blob;
+					break;
+				}
+			}
+		}
+		if (running > 0)
+			curl_multi_wait (self->multi, NULL, 0, 1000, NULL);
+	}
+
+	/* cancel anything still in flight; removing a completed handle is a no-op */
+	if (error_local != NULL) {
+		for (guint i = 0; i < idx; i++) {
+			FuRedfishClientRequest *req = g_ptr_array_index (reqs, i);
+			curl_multi_remove_handle (self->multi, req->curl);
+		}
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	return g_steal_pointer (&blobs);
+}
+
+static GBytes *
+fu_redfish_client_fetch_data (FuRedfishClient *self, const gchar *uri_path, GError **error)
+{
+	g_autoptr(GPtrArray) blobs = NULL;
+	g_autoptr(GPtrArray) uri_paths = g_ptr_array_new ();
+
+	g_ptr_array_add (uri_paths, (gpointer) uri_path);
+	blobs = fu_redfish_client_fetch_data_many (self, uri_paths, error);
+	if (blobs == NULL)
+		return NULL;
+	return g_bytes_ref (g_ptr_array_index (blobs, 0));
 }
 
 static gboolean
@@ -178,17 +324,21 @@ fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 				       GError **error)
 {
 	JsonArray *members;
-	JsonNode *node_root;
-	JsonObject *member;
+	g_autoptr(GPtrArray) blobs = NULL;
+	g_autoptr(GPtrArray) member_uris = g_ptr_array_new ();
 
 	members = json_object_get_array_member (collection, "Members");
 	for (guint i = 0; i < json_array_get_length (members); i++) {
-		g_autoptr(JsonParser) parser = json_parser_new ();
-		g_autoptr(GBytes) blob = NULL;
 		JsonObject *member_id;
 		const gchar *member_uri;
 
+		/* already included using $expand */
 		member_id = json_array_get_object_element (members, i);
+		if (json_object_has_member (member_id, "Id")) {
+			if (!fu_redfish_client_coldplug_member (self, member_id, error))
+				return FALSE;
+			continue;
+		}
 		member_uri = json_object_get_string_member (member_id, "@odata.id");
 		if (member_uri == NULL) {
 			g_set_error_literal (error,
@@ -197,11 +347,20 @@ fu_redfish_client_coldplug_collection (FuRedfishClient *self,
 					     "no @odata.id string");
 			return FALSE;
 		}
+		g_ptr_array_add (member_uris, (gpointer) member_uri);
+	}
+	if (member_uris->len == 0)
+		return TRUE;
 
-		/* try to connect */
-		blob = fu_redfish_client_fetch_data (self, member_uri, error);
-		if (blob == NULL)
-			return FALSE;
+	/* try to connect */
+	blobs = fu_redfish_client_fetch_data_many (self, member_uris, error);
+	if (blobs == NULL)
+		return FALSE;
+	for (guint i = 0; i < blobs->len; i++) {
+		GBytes *blob = g_ptr_array_index (blobs, i);
+		JsonNode *node_root;
+		JsonObject *member;
+		g_autoptr(JsonParser) parser = json_parser_new ();
 
 		/* get the member object */
 		if (!json_parser_load_from_data (parser,
@@ -245,6 +404,7 @@ fu_redfish_client_coldplug_inventory (FuRedfishClient *self,
 	JsonNode *node_root;
 	JsonObject *collection;
 	const gchar *collection_uri;
+	g_autofree gchar *collection_uri_expand = NULL;
 
 	if (inventory == NULL) {
 		g_set_error_literal (error,
@@ -263,6 +423,13 @@ fu_redfish_client_coldplug_inventory (FuRedfishClient *self,
 		return FALSE;
 	}
 
+	/* get all the members in one request if possible */
+	if (self->expand_supported) {
+		collection_uri_expand = g_strdup_printf ("%s?$expand=.($levels=1)",
+							 collection_uri);
+		collection_uri = collection_uri_expand;
+	}
+
 	/* try to connect */
 	blob = fu_redfish_client_fetch_data (self, collection_uri, error);
 	if (blob == NULL)
@@ -594,12 +761,62 @@ fu_redfish_client_set_smbios_interfaces (FuRedfishClient *self,
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(curl_mime, curl_mime_free)
 
+typedef struct {
+	GBytes			*blob_fw;
+	gsize			 offset;
+	FuDevice		*device;
+} FuRedfishClientUploadHelper;
+
+/* the payload is read straight from the blob rather than copied by curl */
+static size_t
+fu_redfish_client_upload_read_cb (char *buffer, size_t size, size_t nitems, void *arg)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) arg;
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (helper->blob_fw, &bufsz);
+	gsize len = MIN (size * nitems, bufsz - helper->offset);
+	memcpy (buffer, buf + helper->offset, len);
+	helper->offset += len;
+	return len;
+}
+
+/* required if curl has to send the body again, e.g. for authentication */
+static int
+fu_redfish_client_upload_seek_cb (void *arg, curl_off_t offset, int origin)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) arg;
+	if (origin != SEEK_SET)
+		return CURL_SEEKFUNC_CANTSEEK;
+	if (offset < 0 || (gsize) offset > g_bytes_get_size (helper->blob_fw))
+		return CURL_SEEKFUNC_FAIL;
+	helper->offset = (gsize) offset;
+	return CURL_SEEKFUNC_OK;
+}
+
+static int
+fu_redfish_client_upload_progress_cb (void *clientp,
+				      curl_off_t dltotal,
+				      curl_off_t dlnow,
+				      curl_off_t ultotal,
+				      curl_off_t ulnow)
+{
+	FuRedfishClientUploadHelper *helper = (FuRedfishClientUploadHelper *) clientp;
+	if (ultotal > 0)
+		fu_device_set_progress_full (helper->device, (gsize) ulnow, (gsize) ultotal);
+	return 0;
+}
+
 gboolean
 fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_fw,
 			  GError **error)
 {
 	CURLcode res;
 	FwupdRelease *release;
+	FuRedfishClientUploadHelper helper = {
+		.blob_fw = blob_fw,
+		.offset = 0,
+		.device = device,
+	};
 	curl_mimepart *part;
 	g_autofree gchar *filename = NULL;
 	g_autofree gchar *port = g_strdup_printf ("%u", self->port);
@@ -652,9 +869,17 @@ fu_redfish_client_update (FuRedfishClient *self, FuDevice *device, GBytes *blob_
 	/* Create the multipart request */
 	curl_easy_setopt (self->curl, CURLOPT_MIMEPOST, mime);
 	part = curl_mime_addpart (mime);
-	curl_mime_data (part, g_bytes_get_data (blob_fw, NULL), g_bytes_get_size (blob_fw));
+	curl_mime_data_cb (part, (curl_off_t) g_bytes_get_size (blob_fw),
+			   fu_redfish_client_upload_read_cb,
+			   fu_redfish_client_upload_seek_cb,
+			   NULL, &helper);
 	curl_mime_type (part, "application/octet-stream");
+	curl_easy_setopt (self->curl, CURLOPT_XFERINFOFUNCTION, fu_redfish_client_upload_progress_cb);
+	curl_easy_setopt (self->curl, CURLOPT_XFERINFODATA, &helper);
+	curl_easy_setopt (self->curl, CURLOPT_NOPROGRESS, 0L);
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	res = curl_easy_perform (self->curl);
+	curl_easy_setopt (self->curl, CURLOPT_NOPROGRESS, 1L);
 	if (res != CURLE_OK) {
 		glong status_code = 0;
 #ifdef HAVE_LIBCURL_7_62_0
@@ -780,6 +1005,21 @@ fu_redfish_client_setup (FuRedfishClient *self, GBytes *smbios_table, GError **e
 	g_debug ("UUID:     %s",
 		 json_object_get_string_member (obj_root, "UUID"));
 
+	/* can we get collection members without a request for each */
+	if (json_object_has_member (obj_root, "ProtocolFeaturesSupported")) {
+		JsonObject *features = json_object_get_object_member (obj_root, "ProtocolFeaturesSupported");
+		if (features != NULL && json_object_has_member (features, "ExpandQuery")) {
+			JsonObject *expand = json_object_get_object_member (features, "ExpandQuery");
+			if (expand != NULL &&
+			    json_object_has_member (expand, "NoLinks") &&
+			    json_object_has_member (expand, "Levels") &&
+			    json_object_get_boolean_member (expand, "NoLinks") &&
+			    json_object_get_boolean_member (expand, "Levels"))
+				self->expand_supported = TRUE;
+		}
+	}
+	g_debug ("Expand:   %s", self->expand_supported ? "yes" : "no");
+
 	if (json_object_has_member (obj_root, "UpdateService"))
 		obj_update_service = json_object_get_object_member (obj_root, "UpdateService");
 	if (obj_update_service == NULL) {
@@ -850,6 +1090,9 @@ fu_redfish_client_finalize (GObject *object)
 	FuRedfishClient *self = FU_REDFISH_CLIENT (object);
 	if (self->curl != NULL)
 		curl_easy_cleanup (self->curl);
+	if (self->multi != NULL)
+		curl_multi_cleanup (self->multi);
+	g_hash_table_unref (self->cache);
 	g_free (self->update_uri_path);
 	g_free (self->push_uri_path);
 	g_free (self->hostname);
@@ -869,6 +1112,14 @@ fu_redfish_client_init (FuRedfishClient *self)
 {
 	self->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	self->curl = curl_easy_init ();
+	self->multi = curl_multi_init ();
+	self->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					     (GDestroyNotify) fu_redfish_client_cache_item_free);
+#ifdef CURLPIPE_MULTIPLEX
+	curl_multi_setopt (self->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+	curl_multi_setopt (self->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+			   (glong) FU_REDFISH_CLIENT_MAX_IN_FLIGHT);
 
 	/* since DSP0266 makes Basic Authorization a requirement,
 	 * it is safe to use Basic Auth for all implementations */
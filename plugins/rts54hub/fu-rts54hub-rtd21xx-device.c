@@ -136,10 +136,10 @@ fu_rts54hub_rtd21xx_device_set_quirk_kv (FuDevice *device,
 }
 
 static gboolean
-fu_rts54hub_rtd21xx_device_i2c_write (FuRts54hubRtd21xxDevice *self,
-				      guint8 target_addr, guint8 sub_addr,
-				      const guint8 *data, gsize datasz,
-				      GError **error)
+fu_rts54hub_rtd21xx_device_i2c_write_raw (FuRts54hubRtd21xxDevice *self,
+					  guint8 target_addr, guint8 sub_addr,
+					  const guint8 *data, gsize datasz,
+					  GError **error)
 {
 	FuRts54HubDevice *parent;
 
@@ -162,6 +162,18 @@ fu_rts54hub_rtd21xx_device_i2c_write (FuRts54hubRtd21xxDevice *self,
 				target_addr, sub_addr);
 		return FALSE;
 	}
+	return TRUE;
+}
+
+static gboolean
+fu_rts54hub_rtd21xx_device_i2c_write (FuRts54hubRtd21xxDevice *self,
+				      guint8 target_addr, guint8 sub_addr,
+				      const guint8 *data, gsize datasz,
+				      GError **error)
+{
+	if (!fu_rts54hub_rtd21xx_device_i2c_write_raw (self, target_addr, sub_addr,
+						       data, datasz, error))
+		return FALSE;
 	g_usleep (I2C_DELAY_AFTER_SEND);
 	return TRUE;
 }
@@ -486,14 +498,17 @@ fu_rts54hub_rtd21xx_device_write_firmware (FuDevice *device,
 						ISP_DATA_BLOCKSIZE);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
+
+		/* the busy status is polled before the next block or command,
+		 * so there is no need for a fixed delay after each block */
 		if (!fu_rts54hub_rtd21xx_device_read_status (self, NULL, error))
 			return FALSE;
-		if (!fu_rts54hub_rtd21xx_device_i2c_write (self,
-							   UC_FOREGROUND_SLAVE_ADDR,
-							   UC_FOREGROUND_ISP_DATA_OPCODE,
-							   fu_chunk_get_data (chk),
-							   fu_chunk_get_data_sz (chk),
-							   error)) {
+		if (!fu_rts54hub_rtd21xx_device_i2c_write_raw (self,
+							       UC_FOREGROUND_SLAVE_ADDR,
+							       UC_FOREGROUND_ISP_DATA_OPCODE,
+							       fu_chunk_get_data (chk),
+							       fu_chunk_get_data_sz (chk),
+							       error)) {
 			g_prefix_error (error,
 					"failed to write @0x%04x: ",
 					fu_chunk_get_address (chk));
@@ -580,6 +595,7 @@ fu_rts54hub_rtd21xx_device_init (FuRts54hubRtd21xxDevice *self)
 	fu_device_set_install_duration (FU_DEVICE (self), 100); /* seconds */
 	fu_device_set_logical_id (FU_DEVICE (self), "I2C");
 	fu_device_retry_set_delay (FU_DEVICE (self), 30); /* ms */
+	fu_device_add_internal_flag (FU_DEVICE (self), FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF);
 }
 
 static void
@@ -147,22 +147,32 @@ fu_superio_device_check_id (FuSuperioDevice *self, GError **error)
 	return TRUE;
 }
 
+/* the EC normally responds within a few port reads, so spin without a timer
+ * for a while before falling back to sleeping between polls */
+#define FU_SUPERIO_DEVICE_WAIT_SPIN_CNT		256
+#define FU_SUPERIO_DEVICE_WAIT_SLEEP_US		10
+
 static gboolean
 fu_superio_device_wait_for (FuSuperioDevice *self, guint8 mask, gboolean set, GError **error)
 {
 	FuSuperioDevicePrivate *priv = GET_PRIVATE (self);
-	g_autoptr(GTimer) timer = g_timer_new ();
-	do {
+	g_autoptr(GTimer) timer = NULL;
+	for (guint i = 0; ; i++) {
 		guint8 status = 0x00;
 		if (!fu_udev_device_pread (FU_UDEV_DEVICE (self), priv->pm1_iobad1, &status, error))
 			return FALSE;
-		if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT)
-			break;
 		if (set && (status & mask) != 0)
 			return TRUE;
 		if (!set && (status & mask) == 0)
 			return TRUE;
-	} while (TRUE);
+		if (i < FU_SUPERIO_DEVICE_WAIT_SPIN_CNT)
+			continue;
+		if (timer == NULL)
+			timer = g_timer_new ();
+		else if (g_timer_elapsed (timer, NULL) > FU_PLUGIN_SUPERIO_TIMEOUT)
+			break;
+		g_usleep (FU_SUPERIO_DEVICE_WAIT_SLEEP_US);
+	}
 	g_set_error (error,
 		     G_IO_ERROR,
 		     G_IO_ERROR_TIMED_OUT,
@@ -535,10 +535,27 @@ fu_superio_it89_device_check_eflash (FuSuperioDevice *self, GError **error)
 static gboolean
 fu_superio_it89_device_write_chunk (FuSuperioDevice *self, FuChunk *chk, GError **error)
 {
+	g_autoptr(GBytes) fw0 = NULL;
 	g_autoptr(GBytes) fw1 = NULL;
 	g_autoptr(GBytes) fw2 = NULL;
 	g_autoptr(GBytes) fw3 = NULL;
 
+	/* skip the page if it already has the new contents */
+	fw2 = g_bytes_new_static (fu_chunk_get_data (chk), fu_chunk_get_data_sz (chk));
+	fw0 = fu_superio_it89_device_read_addr (self, fu_chunk_get_address (chk),
+						fu_chunk_get_data_sz (chk), NULL,
+						error);
+	if (fw0 == NULL) {
+		g_prefix_error (error, "failed to read existing bytes @0x%04x: ",
+				(guint) fu_chunk_get_address (chk));
+		return FALSE;
+	}
+	if (g_bytes_compare (fw0, fw2) == 0) {
+		g_debug ("page @0x%04x unchanged, skipping",
+			 (guint) fu_chunk_get_address (chk));
+		return TRUE;
+	}
+
 	/* erase page */
 	if (!fu_superio_it89_device_erase_addr (self, fu_chunk_get_address (chk), error)) {
 		g_prefix_error (error, "failed to erase @0x%04x: ", (guint) fu_chunk_get_address (chk));
@@ -563,7 +580,6 @@ fu_superio_it89_device_write_chunk (FuSuperioDevice *self, FuChunk *chk, GError
 	}
 
 	/* skip empty page */
-	fw2 = g_bytes_new_static (fu_chunk_get_data (chk), fu_chunk_get_data_sz (chk));
 	if (fu_common_bytes_is_empty (fw2))
 		return TRUE;
 
@@ -30,6 +30,8 @@
 #define PAYLOAD_SIZE_512K		0x80000
 #define PAYLOAD_SIZE_64K		0x10000
 #define MAX_RETRY_COUNTS		10
+#define SECTOR_SIZE			0x1000
+#define SECTOR_RETRY_COUNTS		3
 #define BLOCK_UNIT			64
 #define BANKTAG_0			0
 #define BANKTAG_1			1
@@ -253,6 +255,121 @@ fu_synaptics_mst_device_set_flash_sector_erase (FuSynapticsMstDevice *self,
 	return TRUE;
 }
 
+static gboolean
+fu_synaptics_mst_device_write_blocks (FuSynapticsMstDevice *self,
+				      FuSynapticsMstConnection *connection,
+				      guint32 offset,
+				      const guint8 *data,
+				      guint32 length,
+				      GError **error)
+{
+	for (guint32 i = 0; i < length; i += BLOCK_UNIT) {
+		guint32 unit_sz = MIN (length - i, BLOCK_UNIT);
+		if (!fu_synaptics_mst_connection_rc_set_command (connection,
+								 UPDC_WRITE_TO_EEPROM,
+								 unit_sz,
+								 offset + i,
+								 data + i,
+								 error)) {
+			g_prefix_error (error, "can't write flash offset 0x%04x: ",
+					offset + i);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* the device calculates either an additive checksum or the CRC-16 */
+static gboolean
+fu_synaptics_mst_device_check_sector (FuSynapticsMstDevice *self,
+				      FuSynapticsMstConnection *connection,
+				      guint32 offset,
+				      const guint8 *data,
+				      guint32 length,
+				      gboolean use_crc16,
+				      gboolean *matched,
+				      GError **error)
+{
+	guint32 checksum = 0;
+	guint32 flash_checksum = 0;
+
+	if (use_crc16) {
+		checksum = fu_synaptics_mst_device_get_crc (0, CRC_16, length, data);
+		g_usleep (1000);	/* wait crc calculation */
+		if (!fu_synaptics_mst_connection_rc_special_get_command (connection,
+									 UPDC_CAL_EEPROM_CHECK_CRC16,
+									 length, offset,
+									 NULL, 4,
+									 (guint8 *) &flash_checksum,
+									 error)) {
+			g_prefix_error (error, "failed to get sector CRC: ");
+			return FALSE;
+		}
+	} else {
+		for (guint32 i = 0; i < length; i++)
+			checksum += data[i];
+		if (!fu_synaptics_mst_device_get_flash_checksum (self, length, offset,
+								 &flash_checksum, error))
+			return FALSE;
+	}
+	*matched = checksum == flash_checksum;
+	return TRUE;
+}
+
+/* verify each sector and only rewrite the ones that do not match, optionally
+ * erasing them first; @verified is set to FALSE if any could not be fixed */
+static gboolean
+fu_synaptics_mst_device_verify_sectors (FuSynapticsMstDevice *self,
+					FuSynapticsMstConnection *connection,
+					guint32 offset,
+					const guint8 *data,
+					guint32 length,
+					gboolean use_crc16,
+					gboolean erase,
+					gboolean *verified,
+					GError **error)
+{
+	for (guint32 idx = 0; idx < length; idx += SECTOR_SIZE) {
+		guint32 sector_sz = MIN (length - idx, SECTOR_SIZE);
+		for (guint retries_cnt = 0; ; retries_cnt++) {
+			gboolean matched = FALSE;
+			if (!fu_synaptics_mst_device_check_sector (self, connection,
+								   offset + idx,
+								   data + idx,
+								   sector_sz,
+								   use_crc16,
+								   &matched,
+								   error))
+				return FALSE;
+			if (matched)
+				break;
+			if (retries_cnt >= SECTOR_RETRY_COUNTS) {
+				g_debug ("sector 0x%x still did not match", offset + idx);
+				*verified = FALSE;
+				return TRUE;
+			}
+			g_debug ("attempt %u: sector 0x%x did not match, rewriting",
+				 retries_cnt, offset + idx);
+			if (erase) {
+				if (!fu_synaptics_mst_device_set_flash_sector_erase (self,
+										     FLASH_SECTOR_ERASE_4K,
+										     (offset + idx) / SECTOR_SIZE,
+										     error))
+					return FALSE;
+				g_usleep (FLASH_SETTLE_TIME);
+			}
+			if (!fu_synaptics_mst_device_write_blocks (self, connection,
+								   offset + idx,
+								   data + idx,
+								   sector_sz,
+								   error))
+				return FALSE;
+		}
+	}
+	*verified = TRUE;
+	return TRUE;
+}
+
 static gboolean
 fu_synaptics_mst_device_update_esm (FuSynapticsMstDevice *self,
 				    const guint8 *payload_data,
@@ -375,9 +492,12 @@ fu_synaptics_mst_device_update_tesla_leaf_firmware (FuSynapticsMstDevice *self,
 	connection = fu_synaptics_mst_connection_new (fu_udev_device_get_fd (FU_UDEV_DEVICE (self)),
 						      self->layer, self->rad);
 	for (guint32 retries_cnt = 0; ; retries_cnt++) {
+		gboolean verified = FALSE;
 		guint32 checksum = 0;
 		guint32 flash_checksum = 0;
 
+		offset = 0;
+		data_to_write = payload_len;
 		if (!fu_synaptics_mst_device_set_flash_sector_erase (self, 0xffff, 0, error))
 			return FALSE;
 		g_debug ("Waiting for flash clear to settle");
@@ -414,6 +534,24 @@ fu_synaptics_mst_device_update_tesla_leaf_firmware (FuSynapticsMstDevice *self,
 						     (goffset) (write_loops -1) * 100);
 		}
 
+		/* rewrite any sectors that were not programmed correctly; the
+		 * whole chip is erased if that is not enough */
+		if (!fu_synaptics_mst_device_verify_sectors (self, connection,
+							     0, payload_data, payload_len,
+							     FALSE, FALSE, &verified,
+							     error))
+			return FALSE;
+		if (!verified) {
+			if (retries_cnt > MAX_RETRY_COUNTS) {
+				g_set_error_literal (error,
+						     G_IO_ERROR,
+						     G_IO_ERROR_INVALID_DATA,
+						     "sector checksum mismatched");
+				return FALSE;
+			}
+			continue;
+		}
+
 		/* check data just written */
 		for (guint32 i = 0; i < payload_len; i++)
 			checksum += *(payload_data + i);
@@ -508,6 +646,7 @@ fu_synaptics_mst_device_update_panamera_firmware (FuSynapticsMstDevice *self,
 		write_loops++;
 
 	for (guint32 retries_cnt = 0; ; retries_cnt++) {
+		gboolean verified = FALSE;
 		guint32 checksum = 0;
 		guint32 erase_offset;
 		guint32 flash_checksum = 0;
@@ -558,6 +697,26 @@ fu_synaptics_mst_device_update_panamera_firmware (FuSynapticsMstDevice *self,
 						     (goffset) (write_loops -1) * 100);
 		}
 
+		/* erase and rewrite any sectors with the wrong CRC so that a
+		 * single bad write does not mean erasing the whole bank */
+		if (!fu_synaptics_mst_device_verify_sectors (self, connection,
+							     EEPROM_BANK_OFFSET * bank_to_update,
+							     payload_data, fw_size,
+							     TRUE, TRUE, &verified,
+							     error))
+			return FALSE;
+		if (!verified) {
+			if (retries_cnt > MAX_RETRY_COUNTS) {
+				g_set_error_literal (error,
+						     G_IO_ERROR,
+						     G_IO_ERROR_INVALID_DATA,
+						     "firmware update fail");
+				return FALSE;
+			}
+			g_usleep (2000);
+			continue;
+		}
+
 		/* verify CRC */
 		checksum = fu_synaptics_mst_device_get_crc (0, 16, fw_size, payload_data );
 		for (guint32 i = 0; i < 4; i++) {
@@ -784,10 +943,11 @@ fu_synaptics_mst_device_prepare_firmware (FuDevice *device,
 					  GError **error)
 {
 	FuSynapticsMstDevice *self = FU_SYNAPTICS_MST_DEVICE (device);
-	g_autoptr(FuFirmware) firmware = fu_synaptics_mst_firmware_new ();
+	g_autoptr(FuFirmware) firmware = NULL;
 
 	/* check firmware and board ID match */
-	if (!fu_firmware_parse (firmware, fw, flags, error))
+	firmware = fu_device_parse_firmware_cached (device, FU_TYPE_SYNAPTICS_MST_FIRMWARE, fw, flags, error);
+	if (firmware == NULL)
 		return NULL;
 	if ((flags & FWUPD_INSTALL_FLAG_IGNORE_VID_PID) == 0 &&
 	    !fu_device_has_custom_flag (device, "ignore-board-id")) {
@@ -6,6 +6,7 @@
 
 #include "config.h"
 
+#include "fu-synaprom-config.h"
 #include "fu-synaprom-device.h"
 #include "fu-synaprom-firmware.h"
 
@@ -18,3 +19,58 @@ fu_plugin_init (FuPlugin *plugin)
 	fu_plugin_set_device_gtype (plugin, FU_TYPE_SYNAPROM_DEVICE);
 	fu_plugin_add_firmware_gtype (plugin, NULL, FU_TYPE_SYNAPROM_FIRMWARE);
 }
+
+static gboolean
+fu_plugin_synaptics_prometheus_has_device (GPtrArray *devices, FuDevice *device)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		if (g_ptr_array_index (devices, i) == device)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	/* the config child is written first, so the firmware can be written
+	 * in the same bootloader session */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		FuDevice *parent = fu_device_get_parent (device);
+		if (!FU_IS_SYNAPROM_CONFIG (device) || !FU_IS_SYNAPROM_DEVICE (parent))
+			continue;
+		if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_INSTALL_PARENT_FIRST))
+			continue;
+		if (!fu_plugin_synaptics_prometheus_has_device (devices, parent))
+			continue;
+		g_debug ("writing %s and %s without attaching in between",
+			 fu_device_get_id (device), fu_device_get_id (parent));
+		fu_synaprom_device_set_attach_deferred (FU_SYNAPROM_DEVICE (parent), TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(FuDeviceLocker) locker = NULL;
+		if (!FU_IS_SYNAPROM_DEVICE (device))
+			continue;
+		if (!fu_synaprom_device_get_attach_deferred (FU_SYNAPROM_DEVICE (device)))
+			continue;
+		fu_synaprom_device_set_attach_deferred (FU_SYNAPROM_DEVICE (device), FALSE);
+
+		/* the firmware was not written after the config */
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
+			continue;
+		locker = fu_device_locker_new (device, error);
+		if (locker == NULL)
+			return FALSE;
+		if (!fu_device_attach (device, error))
+			return FALSE;
+	}
+	return TRUE;
+}
@@ -17,6 +17,7 @@ struct _FuSynapromConfig {
 	FuDevice		 parent_instance;
 	guint32			 configid1;		/* config ID1 */
 	guint32			 configid2;		/* config ID2 */
+	guint16			 version_written;
 };
 
 /* Iotas can exceed the size of available RAM in the part.
@@ -202,8 +203,22 @@ fu_synaprom_config_write_firmware (FuDevice *device,
 				   GError **error)
 {
 	FuDevice *parent = fu_device_get_parent (device);
+	FuSynapromConfig *self = FU_SYNAPROM_CONFIG (device);
+	FuSynapromFirmwareCfgHeader hdr;
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GBytes) fw = NULL;
 
+	/* the version cannot be read back until the device is attached */
+	blob = fu_firmware_get_image_by_id_bytes (firmware, "cfg-update-header", error);
+	if (blob == NULL)
+		return FALSE;
+	if (!fu_memcpy_safe ((guint8 *) &hdr, sizeof(hdr), 0x0,		/* dst */
+			     g_bytes_get_data (blob, NULL),
+			     g_bytes_get_size (blob), 0x0,		/* src */
+			     sizeof(hdr), error))
+		return FALSE;
+	self->version_written = GUINT16_FROM_LE(hdr.version);
+
 	/* get default image */
 	fw = fu_firmware_get_image_by_id_bytes (firmware, "cfg-update-payload", error);
 	if (fw == NULL)
@@ -253,10 +268,33 @@ fu_synaprom_config_close (FuDevice *device, GError **error)
 	return fu_device_close (parent, error);
 }
 
+static gboolean
+fu_synaprom_config_reload (FuDevice *device, GError **error)
+{
+	FuDevice *parent = fu_device_get_parent (device);
+	FuSynapromConfig *self = FU_SYNAPROM_CONFIG (device);
+
+	/* still in the bootloader, so use what was just written */
+	if (fu_synaprom_device_get_attach_deferred (FU_SYNAPROM_DEVICE (parent)) &&
+	    fu_device_has_flag (parent, FWUPD_DEVICE_FLAG_IS_BOOTLOADER)) {
+		g_autofree gchar *version = g_strdup_printf ("%04u", self->version_written);
+		fu_device_set_version (device, version);
+		fu_device_set_version_lowest (device, version);
+		return TRUE;
+	}
+	return fu_synaprom_config_setup (device, error);
+}
+
 static gboolean
 fu_synaprom_config_attach (FuDevice *device, GError **error)
 {
 	FuDevice *parent = fu_device_get_parent (device);
+
+	/* the firmware is written next in the same bootloader session */
+	if (fu_synaprom_device_get_attach_deferred (FU_SYNAPROM_DEVICE (parent))) {
+		g_debug ("deferring attach until the firmware is written");
+		return TRUE;
+	}
 	return fu_device_attach (parent, error);
 }
 
@@ -278,7 +316,7 @@ fu_synaprom_config_class_init (FuSynapromConfigClass *klass)
 	klass_device->open = fu_synaprom_config_open;
 	klass_device->close = fu_synaprom_config_close;
 	klass_device->setup = fu_synaprom_config_setup;
-	klass_device->reload = fu_synaprom_config_setup;
+	klass_device->reload = fu_synaprom_config_reload;
 	klass_device->attach = fu_synaprom_config_attach;
 	klass_device->detach = fu_synaprom_config_detach;
 }
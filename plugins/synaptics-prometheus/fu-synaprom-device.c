@@ -18,6 +18,7 @@ struct _FuSynapromDevice {
 	FuUsbDevice		 parent_instance;
 	guint8			 vmajor;
 	guint8			 vminor;
+	gboolean		 attach_deferred;
 };
 
 /* vendor-specific USB control requets to write DFT word (Hayes) */
@@ -234,13 +235,14 @@ fu_synaprom_device_setup (FuDevice *device, GError **error)
 
 static gboolean
 fu_synaprom_device_cmd_download_chunk (FuSynapromDevice *device,
-				       const GByteArray *chunk,
+				       const guint8 *buf,
+				       gsize bufsz,
 				       GError **error)
 {
 	g_autoptr(GByteArray) request = NULL;
 	g_autoptr(GByteArray) reply = NULL;
 	request = fu_synaprom_request_new (FU_SYNAPROM_CMD_BOOTLDR_PATCH,
-					   chunk->data, chunk->len);
+					   (const gpointer) buf, bufsz);
 	reply = fu_synaprom_reply_new (sizeof(FuSynapromReplyGeneric));
 	return fu_synaprom_device_cmd_send (device, request, reply, 20000, error);
 }
@@ -305,7 +307,6 @@ fu_synaprom_device_write_fw (FuSynapromDevice *self, GBytes *fw, GError **error)
 	buf = g_bytes_get_data (fw, &sz);
 	while (sz != 0) {
 		guint32 chunksz;
-		g_autoptr(GByteArray) chunk = g_byte_array_new ();
 
 		/* get chunk size */
 		if (sz < sizeof(guint32)) {
@@ -326,9 +327,9 @@ fu_synaprom_device_write_fw (FuSynapromDevice *self, GBytes *fw, GError **error)
 			return FALSE;
 		}
 
-		/* download chunk */
-		g_byte_array_append (chunk, buf, chunksz);
-		if (!fu_synaprom_device_cmd_download_chunk (self, chunk, error))
+		/* download chunk; the bootloader replies with the status of
+		 * each patch so the next one cannot be sent before this */
+		if (!fu_synaprom_device_cmd_download_chunk (self, buf, chunksz, error))
 			return FALSE;
 
 		/* next chunk */
@@ -358,6 +359,20 @@ fu_synaprom_device_write_firmware (FuDevice *device,
 	return fu_synaprom_device_write_fw (self, fw, error);
 }
 
+/* when set, the config child does not attach the device after it has been
+ * written as the firmware is going to be written in the same session */
+void
+fu_synaprom_device_set_attach_deferred (FuSynapromDevice *self, gboolean attach_deferred)
+{
+	self->attach_deferred = attach_deferred;
+}
+
+gboolean
+fu_synaprom_device_get_attach_deferred (FuSynapromDevice *self)
+{
+	return self->attach_deferred;
+}
+
 static gboolean
 fu_synaprom_device_attach (FuDevice *device, GError **error)
 {
@@ -29,6 +29,9 @@ gboolean		 fu_synaprom_device_cmd_send	(FuSynapromDevice *device,
 gboolean		 fu_synaprom_device_write_fw 	(FuSynapromDevice *self,
 							 GBytes		 *fw,
 							 GError		 **error);
+void			 fu_synaprom_device_set_attach_deferred	(FuSynapromDevice *self,
+								 gboolean	 attach_deferred);
+gboolean		 fu_synaprom_device_get_attach_deferred	(FuSynapromDevice *self);
 
 /* for self tests */
 void			 fu_synaprom_device_set_version	(FuSynapromDevice *self,
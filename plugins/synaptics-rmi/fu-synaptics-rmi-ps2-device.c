@@ -474,8 +474,10 @@ fu_synaptics_rmi_ps2_device_write_rmi_register (FuSynapticsRmiPs2Device *self,
 		}
 	}
 
-	/* success */
-	g_usleep (1000 * 20);
+	/* every byte was acknowledged unless failures were allowed, in which
+	 * case give the controller time to finish what it was doing */
+	if (allow_failure)
+		g_usleep (1000 * 20);
 	return TRUE;
 }
 
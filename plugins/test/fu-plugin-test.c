@@ -27,10 +27,83 @@ fu_plugin_destroy (FuPlugin *plugin)
 	g_debug ("destroy");
 }
 
+static guint
+fu_plugin_test_get_env_uint (const gchar *key, guint value_default)
+{
+	const gchar *tmp = g_getenv (key);
+	if (tmp == NULL)
+		return value_default;
+	return fu_common_strtoull (tmp);
+}
+
+/* a synthetic fleet of devices to benchmark the engine with, where each
+ * device has one instance ID for each GUID, e.g. TEST\DEV_0001&GUID_00 */
+static gboolean
+fu_plugin_test_coldplug_fleet (FuPlugin *plugin, GError **error)
+{
+	guint devices = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_DEVICES", 200);
+	guint children = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_CHILDREN", 0);
+	guint guids = fu_plugin_test_get_env_uint ("FWUPD_PLUGIN_TEST_GUIDS", 1);
+	gboolean proxies = g_getenv ("FWUPD_PLUGIN_TEST_PROXIES") != NULL;
+
+	for (guint i = 0; i < devices; i++) {
+		g_autofree gchar *id = g_strdup_printf ("TEST\\DEV_%04u", i);
+		g_autoptr(FuDevice) device = fu_device_new ();
+		g_autoptr(GPtrArray) children_array = g_ptr_array_new_with_free_func (g_object_unref);
+
+		fu_device_set_id (device, id);
+		fu_device_set_physical_id (device, id);
+		fu_device_set_name (device, "Fleet Device");
+		fu_device_set_vendor (device, "ACME Corp.");
+		fu_device_add_vendor_id (device, "USB:0x046D");
+		fu_device_add_protocol (device, "com.acme.test");
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE);
+		fu_device_set_version_format (device, FWUPD_VERSION_FORMAT_TRIPLET);
+		fu_device_set_version (device, "1.0.0");
+		for (guint k = 0; k < guids; k++) {
+			g_autofree gchar *devid = g_strdup_printf ("%s&GUID_%02u", id, k);
+			fu_device_add_instance_id (device, devid);
+		}
+		for (guint j = 0; j < children; j++) {
+			g_autofree gchar *id_child = g_strdup_printf ("%s&CHILD_%02u", id, j);
+			g_autoptr(FuDevice) child = fu_device_new ();
+			fu_device_set_id (child, id_child);
+			fu_device_set_physical_id (child, id);
+			fu_device_set_logical_id (child, id_child);
+			fu_device_set_name (child, "Fleet Module");
+			fu_device_add_vendor_id (child, "USB:0x046D");
+			fu_device_add_protocol (child, "com.acme.test");
+			fu_device_add_flag (child, FWUPD_DEVICE_FLAG_UPDATABLE);
+			fu_device_set_version_format (child, FWUPD_VERSION_FORMAT_TRIPLET);
+			fu_device_set_version (child, "1.0.0");
+			for (guint k = 0; k < guids; k++) {
+				g_autofree gchar *devid = g_strdup_printf ("%s&GUID_%02u", id_child, k);
+				fu_device_add_instance_id (child, devid);
+			}
+			if (proxies)
+				fu_device_set_proxy (child, device);
+			fu_device_add_child (device, child);
+			g_ptr_array_add (children_array, g_steal_pointer (&child));
+		}
+
+		/* convert the instance IDs to GUIDs, for the parent and children */
+		if (!fu_device_setup (device, error))
+			return FALSE;
+		fu_plugin_device_add (plugin, device);
+		for (guint j = 0; j < children_array->len; j++)
+			fu_plugin_device_add (plugin, g_ptr_array_index (children_array, j));
+	}
+	return TRUE;
+}
+
 gboolean
 fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 {
 	g_autoptr(FuDevice) device = NULL;
+
+	if (g_strcmp0 (g_getenv ("FWUPD_PLUGIN_TEST"), "fleet") == 0)
+		return fu_plugin_test_coldplug_fleet (plugin, error);
+
 	device = fu_device_new ();
 	fu_device_set_id (device, "FakeDevice");
 	fu_device_add_guid (device, "b585990a-003e-5270-89d5-3705a17f9a43");
@@ -156,19 +229,27 @@ fu_plugin_update (FuPlugin *plugin,
 				     "device was not in supported mode");
 		return FALSE;
 	}
+
+	/* benchmarking the engine, so do not pretend to be slow hardware */
+	if (g_strcmp0 (test, "fleet") == 0) {
+		g_autofree gchar *ver = fu_plugin_test_get_version (blob_fw);
+		if (ver != NULL)
+			fu_device_set_version (device, ver);
+		return TRUE;
+	}
 	fu_device_set_status (device, FWUPD_STATUS_DECOMPRESSING);
 	for (guint i = 1; i <= 100; i++) {
-		g_usleep (1000);
+		fu_common_sleep_us (1000);
 		fu_device_set_progress (device, i);
 	}
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 1; i <= 100; i++) {
-		g_usleep (1000);
+		fu_common_sleep_us (1000);
 		fu_device_set_progress (device, i);
 	}
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_VERIFY);
 	for (guint i = 1; i <= 100; i++) {
-		g_usleep (1000);
+		fu_common_sleep_us (1000);
 		fu_device_set_progress (device, i);
 	}
 
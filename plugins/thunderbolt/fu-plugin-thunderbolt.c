@@ -84,6 +84,60 @@ fu_plugin_init (FuPlugin *plugin)
 	fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_BETTER_THAN, "dell_dock");
 }
 
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	g_autoptr(GPtrArray) retimers = g_ptr_array_new ();
+
+	/* retimers on different ports are written through their own nvmem, so
+	 * write them all and then start the slow authentication together */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		if (!FU_IS_THUNDERBOLT_DEVICE (device))
+			continue;
+		if (!fu_thunderbolt_device_is_retimer (FU_THUNDERBOLT_DEVICE (device)))
+			continue;
+		if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART))
+			continue;
+		g_ptr_array_add (retimers, device);
+	}
+	if (retimers->len < 2)
+		return TRUE;
+	for (guint i = 0; i < retimers->len; i++) {
+		FuThunderboltDevice *device = g_ptr_array_index (retimers, i);
+		fu_thunderbolt_device_set_authenticate_deferred (device, TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(FuDeviceLocker) locker = NULL;
+		if (!FU_IS_THUNDERBOLT_DEVICE (device))
+			continue;
+		if (!fu_thunderbolt_device_get_authenticate_deferred (FU_THUNDERBOLT_DEVICE (device)))
+			continue;
+		fu_thunderbolt_device_set_authenticate_deferred (FU_THUNDERBOLT_DEVICE (device), FALSE);
+
+		/* the image was not written */
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION))
+			continue;
+		locker = fu_device_locker_new (device, error);
+		if (locker == NULL)
+			return FALSE;
+		if (!fu_device_activate (device, error)) {
+			g_prefix_error (error, "could not start thunderbolt device upgrade: ");
+			return FALSE;
+		}
+		fu_device_remove_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
+		fu_device_set_remove_delay (device, FU_PLUGIN_THUNDERBOLT_UPDATE_TIMEOUT);
+	}
+	return TRUE;
+}
+
 gboolean
 fu_plugin_startup (FuPlugin *plugin, GError **error)
 {
@@ -15,6 +15,7 @@
 #include <unistd.h>
 #include <errno.h>
 
+#include "fu-chunk.h"
 #include "fu-common.h"
 #include "fu-device-metadata.h"
 #include "fu-thunderbolt-device.h"
@@ -36,10 +37,11 @@ struct _FuThunderboltDevice {
 	guint16			 gen;
 	gchar			*devpath;
 	const gchar		*auth_method;
+	gboolean		 authenticate_deferred;
 };
 
 #define TBT_NVM_RETRY_TIMEOUT				200	/* ms */
-#define FU_PLUGIN_THUNDERBOLT_UPDATE_TIMEOUT		60000	/* ms */
+#define FU_THUNDERBOLT_DEVICE_WRITE_BLOCK_SIZE		0x1000	/* bytes */
 
 G_DEFINE_TYPE (FuThunderboltDevice, fu_thunderbolt_device, FU_TYPE_UDEV_DEVICE)
 
@@ -512,6 +514,27 @@ fu_thunderbolt_device_setup (FuDevice *device, GError **error)
 	return fu_thunderbolt_device_setup_controller (device, error);
 }
 
+gboolean
+fu_thunderbolt_device_is_retimer (FuThunderboltDevice *self)
+{
+	return self->device_type == FU_THUNDERBOLT_DEVICE_TYPE_RETIMER;
+}
+
+/* when set, the image is only written to the nvmem and the authentication is
+ * started later for all the devices in the transaction at the same time */
+void
+fu_thunderbolt_device_set_authenticate_deferred (FuThunderboltDevice *self,
+						 gboolean authenticate_deferred)
+{
+	self->authenticate_deferred = authenticate_deferred;
+}
+
+gboolean
+fu_thunderbolt_device_get_authenticate_deferred (FuThunderboltDevice *self)
+{
+	return self->authenticate_deferred;
+}
+
 static gboolean
 fu_thunderbolt_device_activate (FuDevice *device, GError **error)
 {
@@ -589,11 +612,10 @@ fu_thunderbolt_device_write_data (FuThunderboltDevice	*self,
 				  GBytes		*blob_fw,
 				  GError		**error)
 {
-	gsize fw_size;
-	gsize nwritten;
-	gssize n;
+	guint32 block_size = fu_device_get_firmware_block_size (FU_DEVICE (self));
 	g_autoptr(GFile) nvmem = NULL;
 	g_autoptr(GOutputStream) os = NULL;
+	g_autoptr(GPtrArray) chunks = NULL;
 
 	nvmem = fu_thunderbolt_device_find_nvmem (self, FALSE, error);
 	if (nvmem == NULL)
@@ -607,38 +629,25 @@ fu_thunderbolt_device_write_data (FuThunderboltDevice	*self,
 	if (os == NULL)
 		return FALSE;
 
-	nwritten = 0;
-	fw_size = g_bytes_get_size (blob_fw);
-	fu_device_set_progress_full (FU_DEVICE (self), nwritten, fw_size);
-
-	do {
-		g_autoptr(GBytes) fw_data = NULL;
-
-		fw_data = fu_common_bytes_new_offset (blob_fw,
-						      nwritten,
-						      fw_size - nwritten,
-						      error);
-		if (fw_data == NULL)
+	/* write in blocks so that progress is reported as the kernel
+	 * accepts each one rather than when the whole image is done */
+	if (block_size == 0)
+		block_size = FU_THUNDERBOLT_DEVICE_WRITE_BLOCK_SIZE;
+	chunks = fu_chunk_array_new_from_bytes (blob_fw, 0x0, 0x0, block_size);
+	fu_device_set_progress_full (FU_DEVICE (self), 0, g_bytes_get_size (blob_fw));
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		gsize nwritten = 0;
+		if (!g_output_stream_write_all (os,
+						fu_chunk_get_data (chk),
+						fu_chunk_get_data_sz (chk),
+						&nwritten,
+						NULL,
+						error))
 			return FALSE;
-
-		n = g_output_stream_write_bytes (os,
-						 fw_data,
-						 NULL,
-						 error);
-		if (n < 0)
-			return FALSE;
-
-		nwritten += n;
-		fu_device_set_progress_full (FU_DEVICE (self), nwritten, fw_size);
-
-	} while (nwritten < fw_size);
-
-	if (nwritten != fw_size) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_WRITE,
-				     "Could not write all data to nvmem");
-		return FALSE;
+		fu_device_set_progress_full (FU_DEVICE (self),
+					     fu_chunk_get_address (chk) + nwritten,
+					     g_bytes_get_size (blob_fw));
 	}
 
 	return g_output_stream_close (os, NULL, error);
@@ -762,6 +771,13 @@ fu_thunderbolt_device_write_firmware (FuDevice *device,
 		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
 	}
 
+	/* activated in the composite cleanup, along with the other retimers */
+	if (self->authenticate_deferred) {
+		g_debug ("deferring authentication of %s", self->devpath);
+		fu_device_add_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
+		return TRUE;
+	}
+
 	/* using an active delayed activation flow later (either shutdown or another plugin) */
 	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_SKIPS_RESTART)) {
 		g_debug ("Skipping Thunderbolt reset per quirk request");
@@ -11,3 +11,10 @@
 
 #define FU_TYPE_THUNDERBOLT_DEVICE (fu_thunderbolt_device_get_type ())
 G_DECLARE_FINAL_TYPE (FuThunderboltDevice, fu_thunderbolt_device, FU, THUNDERBOLT_DEVICE, FuUdevDevice)
+
+#define FU_PLUGIN_THUNDERBOLT_UPDATE_TIMEOUT		60000	/* ms */
+
+gboolean	 fu_thunderbolt_device_is_retimer		(FuThunderboltDevice	*self);
+void		 fu_thunderbolt_device_set_authenticate_deferred (FuThunderboltDevice	*self,
+								 gboolean		 authenticate_deferred);
+gboolean	 fu_thunderbolt_device_get_authenticate_deferred (FuThunderboltDevice	*self);
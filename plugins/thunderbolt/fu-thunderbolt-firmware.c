@@ -11,6 +11,7 @@
 
 #include "fu-common.h"
 #include "fu-thunderbolt-firmware.h"
+#include "fu-thunderbolt-struct.h"
 
 typedef struct
 {
@@ -183,53 +184,6 @@ fu_thunderbolt_firmware_read_location (FuThunderboltFirmware *self,
 	return TRUE;
 }
 
-static gboolean
-fu_thunderbolt_firmware_read_uint8 (FuThunderboltFirmware *self,
-				    FuThunderboltSection section,
-				    guint32 offset,
-				    guint8 *value,
-				    GError **error)
-{
-	return fu_thunderbolt_firmware_read_location (self, section, offset,
-						      value, 1, error);
-}
-
-static gboolean
-fu_thunderbolt_firmware_read_uint16 (FuThunderboltFirmware *self,
-				     FuThunderboltSection section,
-				     guint32 offset,
-				     guint16 *value,
-				     GError **error)
-{
-	guint16 tmp = 0;
-	if (!fu_thunderbolt_firmware_read_location (self, section, offset,
-						    (guint8 *) &tmp, sizeof(tmp),
-						    error)) {
-		g_prefix_error (error, "failed to read uint16: ");
-		return FALSE;
-	}
-	*value = GUINT16_FROM_LE (tmp);
-	return TRUE;
-}
-
-static gboolean
-fu_thunderbolt_firmware_read_uint32 (FuThunderboltFirmware *self,
-				     FuThunderboltSection section,
-				     guint32 offset,
-				     guint32 *value,
-				     GError **error)
-{
-	guint32 tmp = 0;
-	if (!fu_thunderbolt_firmware_read_location (self, section, offset,
-						    (guint8 *) &tmp, sizeof(tmp),
-						    error)) {
-		g_prefix_error (error, "failed to read uint32: ");
-		return FALSE;
-	}
-	*value = GUINT32_FROM_LE (tmp);
-	return TRUE;
-}
-
 /*
  * Size of ucode sections is uint16 value saved at the start of the section,
  * it's in DWORDS (4-bytes) units and it doesn't include itself. We need the
@@ -240,15 +194,16 @@ fu_thunderbolt_firmware_read_uint32 (FuThunderboltFirmware *self,
  */
 static gboolean
 fu_thunderbolt_firmware_read_ucode_section_len (FuThunderboltFirmware *self,
+					        const guint8 *buf,
+					        gsize bufsz,
 					        guint32 offset,
 					        guint16 *value,
 					        GError **error)
 {
-	if (!fu_thunderbolt_firmware_read_uint16 (self,
-						  _SECTION_DIGITAL,
-						  offset,
-						  value,
-						  error)) {
+	FuThunderboltFirmwarePrivate *priv = GET_PRIVATE (self);
+	if (!fu_common_read_uint16_safe (buf, bufsz,
+					 (gsize) priv->sections[_SECTION_DIGITAL] + offset,
+					 value, G_LITTLE_ENDIAN, error)) {
 		g_prefix_error (error, "failed to read ucode section len: ");
 		return FALSE;
 	}
@@ -259,27 +214,25 @@ fu_thunderbolt_firmware_read_ucode_section_len (FuThunderboltFirmware *self,
 
 /* assumes sections[_SECTION_DIGITAL].offset is already set */
 static gboolean
-fu_thunderbolt_firmware_read_sections (FuThunderboltFirmware *self, GError **error)
+fu_thunderbolt_firmware_read_sections (FuThunderboltFirmware *self,
+				       const FuThunderboltDigital *digital,
+				       const guint8 *buf,
+				       gsize bufsz,
+				       GError **error)
 {
 	guint32 offset;
 	FuThunderboltFirmwarePrivate *priv = GET_PRIVATE (self);
 
 	if (priv->gen >= 3 || priv->gen == 0) {
-		if (!fu_thunderbolt_firmware_read_uint32 (self,
-							  _SECTION_DIGITAL,
-							  0x10e,
-							  &offset,
-							  error))
+		FuThunderboltDigitalDrom digital_drom = { 0x0 };
+		if (!fu_thunderbolt_digital_drom_parse (&digital_drom, buf, bufsz,
+							priv->sections[_SECTION_DIGITAL],
+							error)) {
+			g_prefix_error (error, "failed to read drom offset: ");
 			return FALSE;
-		priv->sections[_SECTION_DROM] = offset + priv->sections[_SECTION_DIGITAL];
-
-		if (!fu_thunderbolt_firmware_read_uint32 (self,
-							  _SECTION_DIGITAL,
-							  0x75,
-							  &offset,
-							  error))
-			return FALSE;
-		priv->sections[_SECTION_ARC_PARAMS] = offset + priv->sections[_SECTION_DIGITAL];
+		}
+		priv->sections[_SECTION_DROM] = digital_drom.drom_offset + priv->sections[_SECTION_DIGITAL];
+		priv->sections[_SECTION_ARC_PARAMS] = digital->arc_params_offset + priv->sections[_SECTION_DIGITAL];
 	}
 
 	if (priv->is_host && priv->gen > 2) {
@@ -298,26 +251,9 @@ fu_thunderbolt_firmware_read_sections (FuThunderboltFirmware *self, GError **err
 		 */
 		const guint8 DRAM_FLAG = 1 << 6;
 		guint16 ucode_offset;
-		guint8 available_sections = 0;
-
-		if (!fu_thunderbolt_firmware_read_uint8 (self,
-							 _SECTION_DIGITAL,
-							 0x2,
-							 &available_sections,
-							 error)) {
-			g_prefix_error (error, "failed to read available sections: ");
-			return FALSE;
-		}
-		if (!fu_thunderbolt_firmware_read_uint16 (self,
-							  _SECTION_DIGITAL,
-							  0x3,
-							  &ucode_offset,
-							  error)) {
-			g_prefix_error (error, "failed to read ucode offset: ");
-			return FALSE;
-		}
-		offset = ucode_offset;
-		if ((available_sections & DRAM_FLAG) == 0) {
+
+		offset = digital->ucode_offset;
+		if ((digital->available_sections & DRAM_FLAG) == 0) {
 			g_set_error_literal (error,
 					     FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE,
 					     "Can't find needed FW sections in the FW image file");
@@ -325,8 +261,10 @@ fu_thunderbolt_firmware_read_sections (FuThunderboltFirmware *self, GError **err
 		}
 
 		for (guint8 i = 1; i < DRAM_FLAG; i <<= 1) {
-			if (available_sections & i) {
+			if (digital->available_sections & i) {
 				if (!fu_thunderbolt_firmware_read_ucode_section_len (self,
+										     buf,
+										     bufsz,
 										     offset,
 										     &ucode_offset,
 										     error))
@@ -369,8 +307,10 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 	FuThunderboltFirmware *self = FU_THUNDERBOLT_FIRMWARE (firmware);
 	FuThunderboltFirmwarePrivate *priv = GET_PRIVATE (self);
 	FuThunderboltFirmwareClass *klass_firmware = FU_THUNDERBOLT_FIRMWARE_GET_CLASS (firmware);
+	FuThunderboltDigital digital = { 0x0 };
+	gsize bufsz = 0;
+	const guint8 *buf = g_bytes_get_data (fw, &bufsz);
 
-	guint8 tmp = 0;
 	static const FuThunderboltHwInfo hw_info_arr[] = {
 		{ 0x156D, 2, _FAMILY_FR, 2 }, /* FR 4C */
 		{ 0x156B, 2, _FAMILY_FR, 1 }, /* FR 2C */
@@ -405,38 +345,22 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 			return FALSE;
 	}
 
-	/* is native */
-	if (!fu_thunderbolt_firmware_read_uint8 (self,
-						 _SECTION_DIGITAL,
-						 FU_TBT_OFFSET_NATIVE,
-						 &tmp, error)) {
-		g_prefix_error (error, "failed to read native: ");
+	/* all the digital section header fields at once */
+	if (!fu_thunderbolt_digital_parse (&digital, buf, bufsz,
+					   priv->sections[_SECTION_DIGITAL],
+					   error)) {
+		g_prefix_error (error, "failed to read digital section: ");
 		return FALSE;
 	}
-	priv->is_native = tmp & 0x20;
+	priv->is_native = digital.native & 0x20;
 
 	/* we're only reading the first chunk */
-	if (g_bytes_get_size (fw) == 0x80)
+	if (bufsz == 0x80)
 		return TRUE;
 
 	/* host or device */
-	if (!fu_thunderbolt_firmware_read_uint8 (self,
-						 _SECTION_DIGITAL,
-						 0x10, &tmp, error)) {
-		g_prefix_error (error, "failed to read is-host: ");
-		return FALSE;
-	}
-	priv->is_host = tmp & (1 << 1);
-
-	/* device ID */
-	if (!fu_thunderbolt_firmware_read_uint16 (self,
-						  _SECTION_DIGITAL,
-						  0x5,
-						  &priv->device_id,
-						  error)) {
-		g_prefix_error (error, "failed to read device-id: ");
-		return FALSE;
-	}
+	priv->is_host = digital.flags & (1 << 1);
+	priv->device_id = digital.device_id;
 
 	/* this is best-effort */
 	for (guint i = 0; hw_info_arr[i].id != 0; i++) {
@@ -456,7 +380,7 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 	}
 
 	/* read sections from file */
-	if (!fu_thunderbolt_firmware_read_sections (self, error))
+	if (!fu_thunderbolt_firmware_read_sections (self, &digital, buf, bufsz, error))
 		return FALSE;
 	if (fu_thunderbolt_firmware_missing_needed_drom (self)) {
 		g_set_error_literal (error,
@@ -468,36 +392,27 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 
 	/* vendor:model */
 	if (priv->sections[_SECTION_DROM] != 0) {
-		if (!fu_thunderbolt_firmware_read_uint16 (self,
-							  _SECTION_DROM,
-							  0x10,
-							  &priv->vendor_id,
-							  error)) {
-			g_prefix_error (error, "failed to read vendor-id: ");
-			return FALSE;
-		}
-		if (!fu_thunderbolt_firmware_read_uint16 (self,
-							  _SECTION_DROM,
-							  0x12,
-							  &priv->model_id,
-							  error)) {
-			g_prefix_error (error, "failed to read model-id: ");
+		FuThunderboltDrom drom = { 0x0 };
+		if (!fu_thunderbolt_drom_parse (&drom, buf, bufsz,
+						priv->sections[_SECTION_DROM],
+						error)) {
+			g_prefix_error (error, "failed to read drom: ");
 			return FALSE;
 		}
+		priv->vendor_id = drom.vendor_id;
+		priv->model_id = drom.model_id;
 	}
 
 	/* has PD */
 	if (priv->sections[_SECTION_ARC_PARAMS] != 0) {
-		guint32 pd_pointer = 0x0;
-		if (!fu_thunderbolt_firmware_read_uint32 (self,
-							  _SECTION_ARC_PARAMS,
-							  0x10C,
-							  &pd_pointer,
-							  error)) {
+		FuThunderboltArcParams arc_params = { 0x0 };
+		if (!fu_thunderbolt_arc_params_parse (&arc_params, buf, bufsz,
+						      priv->sections[_SECTION_ARC_PARAMS],
+						      error)) {
 			g_prefix_error (error, "failed to read pd-pointer: ");
 			return FALSE;
 		}
-		priv->has_pd = fu_thunderbolt_firmware_valid_pd_pointer (pd_pointer);
+		priv->has_pd = fu_thunderbolt_firmware_valid_pd_pointer (arc_params.pd_pointer);
 	}
 
 	if (priv->is_host) {
@@ -506,15 +421,7 @@ fu_thunderbolt_firmware_parse (FuFirmware *firmware,
 		case _FAMILY_AR_C:
 		case _FAMILY_TR:
 			/* This is used for comparison between old and new image, not a raw number */
-			if (!fu_thunderbolt_firmware_read_uint8 (self,
-								 _SECTION_DIGITAL,
-								 0x45,
-								 &tmp,
-								 error)) {
-				g_prefix_error (error, "failed to read flash size: ");
-				return FALSE;
-			}
-			priv->flash_size = tmp & 0x07;
+			priv->flash_size = digital.flash_size & 0x07;
 			break;
 		default:
 			break;
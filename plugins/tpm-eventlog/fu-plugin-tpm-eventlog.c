@@ -38,22 +38,22 @@ gboolean
 fu_plugin_coldplug (FuPlugin *plugin, GError **error)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
-	gsize bufsz = 0;
 	const gchar *fn = "/sys/kernel/security/tpm0/binary_bios_measurements";
 	g_autofree gchar *str = NULL;
-	g_autofree guint8 *buf = NULL;
 	g_autoptr(FuTpmEventlogDevice) dev = NULL;
+	g_autoptr(GBytes) blob = NULL;
 
-	if (!g_file_get_contents (fn, (gchar **) &buf, &bufsz, error))
+	blob = fu_common_get_contents_bytes (fn, error);
+	if (blob == NULL)
 		return FALSE;
-	if (bufsz == 0) {
+	if (g_bytes_get_size (blob) == 0) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
 			     "failed to read data from %s", fn);
 		return FALSE;
 	}
-	dev = fu_tpm_eventlog_device_new (buf, bufsz, error);
+	dev = fu_tpm_eventlog_device_new (blob, error);
 	if (dev == NULL)
 		return FALSE;
 	if (!fu_device_setup (FU_DEVICE (dev), error))
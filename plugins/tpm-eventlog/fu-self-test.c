@@ -10,18 +10,17 @@
 
 #include "fu-tpm-eventlog-common.h"
 #include "fu-tpm-eventlog-device.h"
+#include "fu-tpm-eventlog-parser.h"
 
 static void
 fu_test_tpm_eventlog_parse_v1_func (void)
 {
 	const gchar *ci = g_getenv ("CI_NETWORK");
 	const gchar *tmp;
-	gboolean ret;
-	gsize bufsz = 0;
 	g_autofree gchar *fn = NULL;
-	g_autofree guint8 *buf = NULL;
 	g_autofree gchar *str = NULL;
 	g_autoptr(FuTpmEventlogDevice) dev = NULL;
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) pcr0s = NULL;
 
@@ -30,11 +29,11 @@ fu_test_tpm_eventlog_parse_v1_func (void)
 		g_test_skip ("Missing binary_bios_measurements-v1");
 		return;
 	}
-	ret = g_file_get_contents (fn, (gchar **) &buf, &bufsz, &error);
+	blob = fu_common_get_contents_bytes (fn, &error);
 	g_assert_no_error (error);
-	g_assert_true (ret);
+	g_assert_nonnull (blob);
 
-	dev = fu_tpm_eventlog_device_new (buf, bufsz, &error);
+	dev = fu_tpm_eventlog_device_new (blob, &error);
 	g_assert_no_error (error);
 	g_assert_nonnull (dev);
 	str = fu_device_to_string (FU_DEVICE (dev));
@@ -55,13 +54,14 @@ fu_test_tpm_eventlog_parse_v2_func (void)
 {
 	const gchar *ci = g_getenv ("CI_NETWORK");
 	const gchar *tmp;
-	gboolean ret;
+	const guint8 *buf;
 	gsize bufsz = 0;
 	g_autofree gchar *fn = NULL;
-	g_autofree guint8 *buf = NULL;
 	g_autofree gchar *str = NULL;
 	g_autoptr(FuTpmEventlogDevice) dev = NULL;
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) items = NULL;
 	g_autoptr(GPtrArray) pcr0s = NULL;
 
 	fn = g_test_build_filename (G_TEST_DIST, "tests", "binary_bios_measurements-v2", NULL);
@@ -69,11 +69,11 @@ fu_test_tpm_eventlog_parse_v2_func (void)
 		g_test_skip ("Missing binary_bios_measurements-v2");
 		return;
 	}
-	ret = g_file_get_contents (fn, (gchar **) &buf, &bufsz, &error);
+	blob = fu_common_get_contents_bytes (fn, &error);
 	g_assert_no_error (error);
-	g_assert_true (ret);
+	g_assert_nonnull (blob);
 
-	dev = fu_tpm_eventlog_device_new (buf, bufsz, &error);
+	dev = fu_tpm_eventlog_device_new (blob, &error);
 	g_assert_no_error (error);
 	g_assert_nonnull (dev);
 	str = fu_device_to_string (FU_DEVICE (dev));
@@ -90,6 +90,20 @@ fu_test_tpm_eventlog_parse_v2_func (void)
 	g_assert_cmpstr (tmp, ==, "ebead4b31c7c49e193c440cd6ee90bc1b61a3ca6");
 	tmp = g_ptr_array_index (pcr0s, 1);
 	g_assert_cmpstr (tmp, ==, "6d9fed68092cfb91c9552bcb7879e75e1df36efd407af67690dc3389a5722fab");
+
+	/* event data references the log rather than being copied */
+	items = fu_tpm_eventlog_parser_new (blob, FU_TPM_EVENTLOG_PARSER_FLAG_ALL_PCRS, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (items);
+	g_assert_cmpint (items->len, >, pcr0s->len);
+	buf = g_bytes_get_data (blob, &bufsz);
+	for (guint i = 0; i < items->len; i++) {
+		FuTpmEventlogItem *item = g_ptr_array_index (items, i);
+		const guint8 *data = g_bytes_get_data (item->blob, NULL);
+		if (g_bytes_get_size (item->blob) == 0)
+			continue;
+		g_assert_true (data >= buf && data < buf + bufsz);
+	}
 }
 
 int
@@ -97,15 +97,15 @@ fu_tpm_eventlog_device_class_init (FuTpmEventlogDeviceClass *klass)
 }
 
 FuTpmEventlogDevice *
-fu_tpm_eventlog_device_new (const guint8 *buf, gsize bufsz, GError **error)
+fu_tpm_eventlog_device_new (GBytes *blob, GError **error)
 {
 	g_autoptr(FuTpmEventlogDevice) self = NULL;
 
-	g_return_val_if_fail (buf != NULL, NULL);
+	g_return_val_if_fail (blob != NULL, NULL);
 
 	/* create object */
 	self = g_object_new (FU_TYPE_TPM_EVENTLOG_DEVICE, NULL);
-	self->items = fu_tpm_eventlog_parser_new (buf, bufsz,
+	self->items = fu_tpm_eventlog_parser_new (blob,
 						  FU_TPM_EVENTLOG_PARSER_FLAG_NONE,
 						  error);
 	if (self->items == NULL)
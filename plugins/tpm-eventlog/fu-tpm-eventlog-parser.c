@@ -69,206 +69,252 @@ fu_tpm_eventlog_item_to_string (FuTpmEventlogItem *item, guint idt, GString *str
 		fu_common_string_append_kv (str, idt, "BlobStr", blobstr);
 }
 
-static GPtrArray *
-fu_tpm_eventlog_parser_parse_blob_v2 (const guint8 *buf, gsize bufsz,
-				      FuTpmEventlogParserFlags flags,
-				      GError **error)
+/* walks the log one event at a time, only recording offsets into the
+ * original buffer so that no event data has to be copied */
+typedef struct {
+	const guint8		*buf;
+	gsize			 bufsz;
+	gsize			 idx;
+	gboolean		 is_v2;
+} FuTpmEventlogParserCursor;
+
+typedef struct {
+	guint32			 pcr;
+	guint32			 kind;
+	gsize			 checksum_sha1_idx;	/* G_MAXSIZE if unset */
+	gsize			 checksum_sha256_idx;	/* G_MAXSIZE if unset */
+	gsize			 data_idx;
+	guint32			 datasz;
+} FuTpmEventlogParserEvent;
+
+static gboolean
+fu_tpm_eventlog_parser_check_range (FuTpmEventlogParserCursor *cursor,
+				    gsize idx, gsize sz, GError **error)
 {
-	guint32 hdrsz = 0x0;
-	g_autoptr(GPtrArray) items = NULL;
+	if (idx > cursor->bufsz || sz > cursor->bufsz - idx) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_FILE,
+			     "event log truncated: need 0x%x bytes at 0x%x of 0x%x",
+			     (guint) sz, (guint) idx, (guint) cursor->bufsz);
+		return FALSE;
+	}
+	return TRUE;
+}
 
-	/* advance over the header block */
-	if (!fu_common_read_uint32_safe	(buf, bufsz,
-					 FU_TPM_EVENTLOG_V1_IDX_EVENT_SIZE,
-					 &hdrsz, G_LITTLE_ENDIAN, error))
-		return NULL;
-	items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_tpm_eventlog_parser_item_free);
-	for (gsize idx = FU_TPM_EVENTLOG_V1_SIZE + hdrsz; idx < bufsz;) {
-		guint32 pcr = 0;
-		guint32 event_type = 0;
-		guint32 digestcnt = 0;
-		guint32 datasz = 0;
-		g_autoptr(GBytes) checksum_sha1 = NULL;
-		g_autoptr(GBytes) checksum_sha256 = NULL;
-
-		/* read entry */
-		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V2_IDX_PCR,
-						 &pcr, G_LITTLE_ENDIAN, error))
-			return NULL;
-		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V2_IDX_TYPE,
-						 &event_type, G_LITTLE_ENDIAN, error))
-			return NULL;
+static gboolean
+fu_tpm_eventlog_parser_cursor_init (FuTpmEventlogParserCursor *cursor,
+				    const guint8 *buf, gsize bufsz,
+				    GError **error)
+{
+	gchar sig[] = FU_TPM_EVENTLOG_V2_HDR_SIGNATURE;
+
+	cursor->buf = buf;
+	cursor->bufsz = bufsz;
+	cursor->idx = 0;
+	cursor->is_v2 = FALSE;
+
+	/* look for TCG v2 signature */
+	if (!fu_memcpy_safe ((guint8 *) sig, sizeof(sig), 0x0,		/* dst */
+			     buf, bufsz, FU_TPM_EVENTLOG_V1_SIZE,	/* src */
+			     sizeof(sig), error))
+		return FALSE;
+	if (g_strcmp0 (sig, FU_TPM_EVENTLOG_V2_HDR_SIGNATURE) == 0) {
+		guint32 hdrsz = 0x0;
+
+		/* advance over the header block */
 		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V2_IDX_DIGEST_COUNT,
-						 &digestcnt, G_LITTLE_ENDIAN, error))
-			return NULL;
+						 FU_TPM_EVENTLOG_V1_IDX_EVENT_SIZE,
+						 &hdrsz, G_LITTLE_ENDIAN, error))
+			return FALSE;
+		cursor->idx = (gsize) FU_TPM_EVENTLOG_V1_SIZE + hdrsz;
+		cursor->is_v2 = TRUE;
+	}
+	return TRUE;
+}
 
-		/* read checksum block */
-		idx += FU_TPM_EVENTLOG_V2_SIZE;
-		for (guint i = 0; i < digestcnt; i++) {
-			guint16 alg_type = 0;
-			guint32 alg_size = 0;
-			g_autofree guint8 *digest = NULL;
-
-			/* get checksum type */
-			if (!fu_common_read_uint16_safe	(buf, bufsz, idx,
-							 &alg_type, G_LITTLE_ENDIAN, error))
-				return NULL;
-			alg_size = fu_tpm_eventlog_hash_get_size (alg_type);
-			if (alg_size == 0) {
-				g_set_error (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOT_SUPPORTED,
-					     "hash algorithm 0x%x size not known",
-					     alg_type);
-				return NULL;
-			}
-
-			/* build checksum */
-			idx += sizeof(alg_type);
-
-			/* copy hash */
-			digest = g_malloc0 (alg_size);
-			if (!fu_memcpy_safe (digest, alg_size, 0x0,	/* dst */
-					     buf, bufsz, idx,		/* src */
-					     alg_size, error))
-				return NULL;
-
-			/* save this for analysis */
-			if (alg_type == TPM2_ALG_SHA1)
-				checksum_sha1 = g_bytes_new_take (g_steal_pointer (&digest), alg_size);
-			else if (alg_type == TPM2_ALG_SHA256)
-				checksum_sha256 = g_bytes_new_take (g_steal_pointer (&digest), alg_size);
-
-			/* next block */
-			idx += alg_size;
-		}
+static gboolean
+fu_tpm_eventlog_parser_cursor_has_next (FuTpmEventlogParserCursor *cursor)
+{
+	return cursor->idx < cursor->bufsz;
+}
 
-		/* read data block */
-		if (!fu_common_read_uint32_safe	(buf, bufsz, idx,
-						 &datasz, G_LITTLE_ENDIAN, error))
-			return NULL;
-		if (datasz > 1024 * 1024) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOT_SUPPORTED,
-					     "event log item too large");
-			return NULL;
-		}
+static gboolean
+fu_tpm_eventlog_parser_cursor_next_v1 (FuTpmEventlogParserCursor *cursor,
+				       FuTpmEventlogParserEvent *event,
+				       GError **error)
+{
+	const guint8 *buf = cursor->buf;
+	gsize bufsz = cursor->bufsz;
+	gsize idx = cursor->idx;
+
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V1_IDX_PCR,
+					 &event->pcr, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V1_IDX_TYPE,
+					 &event->kind, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V1_IDX_EVENT_SIZE,
+					 &event->datasz, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	event->checksum_sha1_idx = idx + FU_TPM_EVENTLOG_V1_IDX_DIGEST;
+	event->checksum_sha256_idx = G_MAXSIZE;
+	event->data_idx = idx + FU_TPM_EVENTLOG_V1_SIZE;
+	return TRUE;
+}
+
+static gboolean
+fu_tpm_eventlog_parser_cursor_next_v2 (FuTpmEventlogParserCursor *cursor,
+				       FuTpmEventlogParserEvent *event,
+				       GError **error)
+{
+	const guint8 *buf = cursor->buf;
+	gsize bufsz = cursor->bufsz;
+	gsize idx = cursor->idx;
+	guint32 digestcnt = 0;
 
-		/* save blob if PCR=0 */
-		idx += sizeof(datasz);
-		if (pcr == ESYS_TR_PCR0 ||
-		    flags & FU_TPM_EVENTLOG_PARSER_FLAG_ALL_PCRS) {
-			FuTpmEventlogItem *item;
-			g_autofree guint8 *data = NULL;
-
-			/* build item */
-			data = g_malloc0 (datasz);
-			if (!fu_memcpy_safe (data, datasz, 0x0,		/* dst */
-					     buf, bufsz, idx, datasz,	/* src */
-					     error))
-				return NULL;
-
-			/* not normally required */
-			if (g_getenv ("FWUPD_TPM_EVENTLOG_VERBOSE") != NULL) {
-				fu_common_dump_full (G_LOG_DOMAIN, "Event Data",
-						     data, datasz, 20,
-						     FU_DUMP_FLAGS_SHOW_ASCII);
-			}
-			item = g_new0 (FuTpmEventlogItem, 1);
-			item->pcr = pcr;
-			item->kind = event_type;
-			item->checksum_sha1 = g_steal_pointer (&checksum_sha1);
-			item->checksum_sha256 = g_steal_pointer (&checksum_sha256);
-			item->blob = g_bytes_new_take (g_steal_pointer (&data), datasz);
-			g_ptr_array_add (items, item);
+	/* read entry */
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V2_IDX_PCR,
+					 &event->pcr, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V2_IDX_TYPE,
+					 &event->kind, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	if (!fu_common_read_uint32_safe	(buf, bufsz,
+					 idx + FU_TPM_EVENTLOG_V2_IDX_DIGEST_COUNT,
+					 &digestcnt, G_LITTLE_ENDIAN, error))
+		return FALSE;
+
+	/* read checksum block */
+	event->checksum_sha1_idx = G_MAXSIZE;
+	event->checksum_sha256_idx = G_MAXSIZE;
+	idx += FU_TPM_EVENTLOG_V2_SIZE;
+	for (guint i = 0; i < digestcnt; i++) {
+		guint16 alg_type = 0;
+		guint32 alg_size = 0;
+
+		/* get checksum type */
+		if (!fu_common_read_uint16_safe	(buf, bufsz, idx,
+						 &alg_type, G_LITTLE_ENDIAN, error))
+			return FALSE;
+		alg_size = fu_tpm_eventlog_hash_get_size (alg_type);
+		if (alg_size == 0) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "hash algorithm 0x%x size not known",
+				     alg_type);
+			return FALSE;
 		}
+		idx += sizeof(alg_type);
+		if (!fu_tpm_eventlog_parser_check_range (cursor, idx, alg_size, error))
+			return FALSE;
+
+		/* save this for analysis */
+		if (alg_type == TPM2_ALG_SHA1)
+			event->checksum_sha1_idx = idx;
+		else if (alg_type == TPM2_ALG_SHA256)
+			event->checksum_sha256_idx = idx;
+
+		/* next block */
+		idx += alg_size;
+	}
 
-		/* next entry */
-		idx += datasz;
+	/* read data block */
+	if (!fu_common_read_uint32_safe	(buf, bufsz, idx,
+					 &event->datasz, G_LITTLE_ENDIAN, error))
+		return FALSE;
+	event->data_idx = idx + sizeof(event->datasz);
+	return TRUE;
+}
+
+static gboolean
+fu_tpm_eventlog_parser_cursor_next (FuTpmEventlogParserCursor *cursor,
+				    FuTpmEventlogParserEvent *event,
+				    GError **error)
+{
+	if (cursor->is_v2) {
+		if (!fu_tpm_eventlog_parser_cursor_next_v2 (cursor, event, error))
+			return FALSE;
+	} else {
+		if (!fu_tpm_eventlog_parser_cursor_next_v1 (cursor, event, error))
+			return FALSE;
+	}
+	if (event->datasz > 1024 * 1024) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "event log item too large");
+		return FALSE;
 	}
+	if (!fu_tpm_eventlog_parser_check_range (cursor, event->data_idx,
+						 event->datasz, error))
+		return FALSE;
 
-	/* success */
-	return g_steal_pointer (&items);
+	/* next entry */
+	cursor->idx = event->data_idx + event->datasz;
+	return TRUE;
 }
 
 GPtrArray *
-fu_tpm_eventlog_parser_new (const guint8 *buf, gsize bufsz,
+fu_tpm_eventlog_parser_new (GBytes *blob,
 			    FuTpmEventlogParserFlags flags,
 			    GError **error)
 {
-	gchar sig[] = FU_TPM_EVENTLOG_V2_HDR_SIGNATURE;
+	FuTpmEventlogParserCursor cursor = { NULL };
+	gsize bufsz = 0;
+	const guint8 *buf;
+	gboolean verbose = g_getenv ("FWUPD_TPM_EVENTLOG_VERBOSE") != NULL;
 	g_autoptr(GPtrArray) items = NULL;
 
-	g_return_val_if_fail (buf != NULL, NULL);
+	g_return_val_if_fail (blob != NULL, NULL);
 
-	/* look for TCG v2 signature */
-	if (!fu_memcpy_safe ((guint8 *) sig, sizeof(sig), 0x0,		/* dst */
-			     buf, bufsz, FU_TPM_EVENTLOG_V1_SIZE,	/* src */
-			     sizeof(sig), error))
+	buf = g_bytes_get_data (blob, &bufsz);
+	if (!fu_tpm_eventlog_parser_cursor_init (&cursor, buf, bufsz, error))
 		return NULL;
-	if (g_strcmp0 (sig, FU_TPM_EVENTLOG_V2_HDR_SIGNATURE) == 0)
-		return fu_tpm_eventlog_parser_parse_blob_v2 (buf, bufsz, flags, error);
-
-	/* assume v1 structure */
 	items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_tpm_eventlog_parser_item_free);
-	for (gsize idx = 0; idx < bufsz; idx += FU_TPM_EVENTLOG_V1_SIZE) {
-		guint32 datasz = 0;
-		guint32 pcr = 0;
-		guint32 event_type = 0;
-		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V1_IDX_PCR,
-						 &pcr, G_LITTLE_ENDIAN, error))
-			return NULL;
-		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V1_IDX_TYPE,
-						 &event_type, G_LITTLE_ENDIAN, error))
-			return NULL;
-		if (!fu_common_read_uint32_safe	(buf, bufsz,
-						 idx + FU_TPM_EVENTLOG_V1_IDX_EVENT_SIZE,
-						 &datasz, G_LITTLE_ENDIAN, error))
-			return NULL;
-		if (datasz > 1024 * 1024) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOT_SUPPORTED,
-					     "event log item too large");
+	while (fu_tpm_eventlog_parser_cursor_has_next (&cursor)) {
+		FuTpmEventlogParserEvent event = { 0x0 };
+		FuTpmEventlogItem *item;
+
+		if (!fu_tpm_eventlog_parser_cursor_next (&cursor, &event, error))
 			return NULL;
+
+		/* only save PCR=0 unless asked */
+		if (event.pcr != ESYS_TR_PCR0 &&
+		    (flags & FU_TPM_EVENTLOG_PARSER_FLAG_ALL_PCRS) == 0)
+			continue;
+
+		/* build item, referencing the parent blob */
+		item = g_new0 (FuTpmEventlogItem, 1);
+		item->pcr = event.pcr;
+		item->kind = event.kind;
+		if (event.checksum_sha1_idx != G_MAXSIZE) {
+			item->checksum_sha1 = g_bytes_new_from_bytes (blob,
+								      event.checksum_sha1_idx,
+								      TPM2_SHA1_DIGEST_SIZE);
 		}
-		if (pcr == ESYS_TR_PCR0 ||
-		    flags & FU_TPM_EVENTLOG_PARSER_FLAG_ALL_PCRS) {
-			FuTpmEventlogItem *item;
-			guint8 digest[TPM2_SHA1_DIGEST_SIZE] = { 0x0 };
-			g_autofree guint8 *data = NULL;
-
-			/* copy hash */
-			if (!fu_memcpy_safe (digest, sizeof(digest), 0x0,			/* dst */
-					     buf, bufsz, idx + FU_TPM_EVENTLOG_V1_IDX_DIGEST,	/* src */
-					     sizeof(digest), error))
-				return NULL;
-
-			/* build item */
-			data = g_malloc0 (datasz);
-			if (!fu_memcpy_safe (data, datasz, 0x0,					/* dst */
-					     buf, bufsz, idx + FU_TPM_EVENTLOG_V1_SIZE,		/* src */
-					     datasz, error))
-				return NULL;
-			item = g_new0 (FuTpmEventlogItem, 1);
-			item->pcr = pcr;
-			item->kind = event_type;
-			item->checksum_sha1 = g_bytes_new (digest, sizeof(digest));
-			item->blob = g_bytes_new_take (g_steal_pointer (&data), datasz);
-			g_ptr_array_add (items, item);
-
-			/* not normally required */
-			if (g_getenv ("FWUPD_TPM_EVENTLOG_VERBOSE") != NULL)
-				fu_common_dump_bytes (G_LOG_DOMAIN, "Event Data", item->blob);
+		if (event.checksum_sha256_idx != G_MAXSIZE) {
+			item->checksum_sha256 = g_bytes_new_from_bytes (blob,
+									event.checksum_sha256_idx,
+									TPM2_SHA256_DIGEST_SIZE);
+		}
+		item->blob = g_bytes_new_from_bytes (blob, event.data_idx, event.datasz);
+		g_ptr_array_add (items, item);
+
+		/* not normally required */
+		if (verbose) {
+			fu_common_dump_full (G_LOG_DOMAIN, "Event Data",
+					     buf + event.data_idx, event.datasz, 20,
+					     FU_DUMP_FLAGS_SHOW_ASCII);
 		}
-		idx += datasz;
 	}
-	return g_steal_pointer (&items);
 
+	/* success */
+	return g_steal_pointer (&items);
 }
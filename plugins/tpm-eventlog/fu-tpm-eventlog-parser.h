@@ -16,8 +16,7 @@ typedef enum {
 	FU_TPM_EVENTLOG_PARSER_FLAG_LAST
 } FuTpmEventlogParserFlags;
 
-GPtrArray	*fu_tpm_eventlog_parser_new	(const guint8	*buf,
-						 gsize		 bufsz,
+GPtrArray	*fu_tpm_eventlog_parser_new	(GBytes		*blob,
 						 FuTpmEventlogParserFlags flags,
 						 GError		**error);
 void		 fu_tpm_eventlog_item_to_string	(FuTpmEventlogItem *item,
@@ -33,16 +33,16 @@ fu_tmp_eventlog_sort_cb (gconstpointer a, gconstpointer b)
 static gboolean
 fu_tmp_eventlog_process (const gchar *fn, gint pcr, GError **error)
 {
-	gsize bufsz = 0;
-	g_autofree guint8 *buf = NULL;
+	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GPtrArray) items = NULL;
 	g_autoptr(GString) str = g_string_new (NULL);
 	gint max_pcr = 0;
 
 	/* parse this */
-	if (!g_file_get_contents (fn, (gchar **) &buf, &bufsz, error))
+	blob = fu_common_get_contents_bytes (fn, error);
+	if (blob == NULL)
 		return FALSE;
-	items = fu_tpm_eventlog_parser_new (buf, bufsz,
+	items = fu_tpm_eventlog_parser_new (blob,
 					    FU_TPM_EVENTLOG_PARSER_FLAG_ALL_PCRS,
 					    error);
 	if (items == NULL)
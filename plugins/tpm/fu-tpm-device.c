@@ -38,47 +38,67 @@ fu_tpm_device_probe (FuDevice *device, GError **error)
 	return fu_udev_device_set_physical_id (FU_UDEV_DEVICE (device), "tpm", error);
 }
 
+/* the TPM returns as many consecutive properties as fit in one response */
+static GHashTable *
+fu_tpm_device_get_properties (ESYS_CONTEXT *ctx, guint32 first, guint32 last, GError **error)
+{
+	guint32 property = first;
+	g_autoptr(GHashTable) props = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	while (property <= last) {
+		TSS2_RC rc;
+		TPMI_YES_NO more_data = TPM2_NO;
+		TPML_TAGGED_TPM_PROPERTY *tpm_props;
+		g_autofree TPMS_CAPABILITY_DATA *capability = NULL;
+
+		rc = Esys_GetCapability (ctx, ESYS_TR_NONE, ESYS_TR_NONE, ESYS_TR_NONE,
+					 TPM2_CAP_TPM_PROPERTIES, property,
+					 last - property + 1, &more_data, &capability);
+		if (rc != TSS2_RC_SUCCESS) {
+			g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "capability request failed for query %x", property);
+			return NULL;
+		}
+		tpm_props = &capability->data.tpmProperties;
+		if (tpm_props->count == 0)
+			break;
+		for (guint i = 0; i < tpm_props->count; i++) {
+			g_hash_table_insert (props,
+					     GUINT_TO_POINTER (tpm_props->tpmProperty[i].property),
+					     GUINT_TO_POINTER (tpm_props->tpmProperty[i].value));
+		}
+		property = tpm_props->tpmProperty[tpm_props->count - 1].property + 1;
+		if (more_data == TPM2_NO)
+			break;
+	}
+	return g_steal_pointer (&props);
+}
+
 static gboolean
-fu_tpm_device_get_uint32 (ESYS_CONTEXT *ctx, guint32 query, guint32 *val, GError **error)
+fu_tpm_device_get_uint32 (GHashTable *props, guint32 query, guint32 *val, GError **error)
 {
-	TSS2_RC rc;
-	g_autofree TPMS_CAPABILITY_DATA *capability = NULL;
+	gpointer value = NULL;
 
 	g_return_val_if_fail (val != NULL, FALSE);
 
-	rc = Esys_GetCapability (ctx, ESYS_TR_NONE, ESYS_TR_NONE, ESYS_TR_NONE,
-				 TPM2_CAP_TPM_PROPERTIES, query, 1, NULL, &capability);
-	if (rc != TSS2_RC_SUCCESS) {
-		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-			     "capability request failed for query %x", query);
-		return FALSE;
-	}
-	if (capability->data.tpmProperties.count == 0) {
+	if (!g_hash_table_lookup_extended (props, GUINT_TO_POINTER (query), NULL, &value)) {
 		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
 			     "no properties returned for query %x", query);
 		return FALSE;
 	}
-	if (capability->data.tpmProperties.tpmProperty[0].property != query) {
-		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-			     "wrong query returned (got %x expected %x)",
-			     capability->data.tpmProperties.tpmProperty[0].property,
-			     query);
-		return FALSE;
-	}
-
-	*val = capability->data.tpmProperties.tpmProperty[0].value;
+	*val = GPOINTER_TO_UINT (value);
 	return TRUE;
 }
 
 static gchar *
-fu_tpm_device_get_string (ESYS_CONTEXT *ctx, guint32 query, GError **error)
+fu_tpm_device_get_string (GHashTable *props, guint32 query, GError **error)
 {
 	guint32 val_be = 0;
 	guint32 val;
 	gchar result[5] = {'\0'};
 
 	/* return four bytes */
-	if (!fu_tpm_device_get_uint32 (ctx, query, &val_be, error))
+	if (!fu_tpm_device_get_uint32 (props, query, &val_be, error))
 		return NULL;
 	val = GUINT32_FROM_BE(val_be);
 	memcpy (result, (gchar *) &val, 4);
@@ -165,6 +185,7 @@ fu_tpm_device_setup (FuDevice *device, GError **error)
 	g_autofree gchar *vendor_id = NULL;
 	g_autofree gchar *version = NULL;
 	g_autoptr(ESYS_CONTEXT) ctx = NULL;
+	g_autoptr(GHashTable) props = NULL;
 
 	/* setup TSS */
 	rc = Esys_Initialize (&ctx, NULL, NULL);
@@ -180,31 +201,39 @@ fu_tpm_device_setup (FuDevice *device, GError **error)
 		return FALSE;
 	}
 
+	/* read the fixed properties in as few commands as possible */
+	props = fu_tpm_device_get_properties (ctx,
+					      TPM2_PT_FAMILY_INDICATOR,
+					      TPM2_PT_FIRMWARE_VERSION_2,
+					      error);
+	if (props == NULL)
+		return FALSE;
+
 	/* lookup guaranteed details from TPM */
-	self->family = fu_tpm_device_get_string (ctx, TPM2_PT_FAMILY_INDICATOR, error);
+	self->family = fu_tpm_device_get_string (props, TPM2_PT_FAMILY_INDICATOR, error);
 	if (self->family == NULL) {
 		g_prefix_error (error, "failed to read TPM family: ");
 		return FALSE;
 	}
-	manufacturer = fu_tpm_device_get_string (ctx, TPM2_PT_MANUFACTURER, error);
+	manufacturer = fu_tpm_device_get_string (props, TPM2_PT_MANUFACTURER, error);
 	if (manufacturer == NULL) {
 		g_prefix_error (error, "failed to read TPM manufacturer: ");
 		return FALSE;
 	}
-	model1 = fu_tpm_device_get_string (ctx, TPM2_PT_VENDOR_STRING_1, error);
+	model1 = fu_tpm_device_get_string (props, TPM2_PT_VENDOR_STRING_1, error);
 	if (model1 == NULL) {
 		g_prefix_error (error, "failed to read TPM vendor string: ");
 		return FALSE;
 	}
-	if (!fu_tpm_device_get_uint32 (ctx, TPM2_PT_VENDOR_TPM_TYPE, &tpm_type, error)) {
+	if (!fu_tpm_device_get_uint32 (props, TPM2_PT_VENDOR_TPM_TYPE, &tpm_type, error)) {
 		g_prefix_error (error, "failed to read TPM type: ");
 		return FALSE;
 	}
 
 	/* these are not guaranteed by spec and may be NULL */
-	model2 = fu_tpm_device_get_string (ctx, TPM2_PT_VENDOR_STRING_2, error);
-	model3 = fu_tpm_device_get_string (ctx, TPM2_PT_VENDOR_STRING_3, error);
-	model4 = fu_tpm_device_get_string (ctx, TPM2_PT_VENDOR_STRING_4, error);
+	model2 = fu_tpm_device_get_string (props, TPM2_PT_VENDOR_STRING_2, NULL);
+	model3 = fu_tpm_device_get_string (props, TPM2_PT_VENDOR_STRING_3, NULL);
+	model4 = fu_tpm_device_get_string (props, TPM2_PT_VENDOR_STRING_4, NULL);
 	model = g_strjoin ("", model1, model2, model3, model4, NULL);
 
 	/* add GUIDs to daemon */
@@ -224,9 +253,9 @@ fu_tpm_device_setup (FuDevice *device, GError **error)
 	fu_device_set_vendor (device, tmp != NULL ? tmp : manufacturer);
 
 	/* get version */
-	if (!fu_tpm_device_get_uint32 (ctx, TPM2_PT_FIRMWARE_VERSION_1, &version1, error))
+	if (!fu_tpm_device_get_uint32 (props, TPM2_PT_FIRMWARE_VERSION_1, &version1, error))
 		return FALSE;
-	if (!fu_tpm_device_get_uint32 (ctx, TPM2_PT_FIRMWARE_VERSION_2, &version2, error))
+	if (!fu_tpm_device_get_uint32 (props, TPM2_PT_FIRMWARE_VERSION_2, &version2, error))
 		return FALSE;
 	version_raw = ((guint64) version1) << 32 | ((guint64) version2);
 	fu_device_set_version_raw (device, version_raw);
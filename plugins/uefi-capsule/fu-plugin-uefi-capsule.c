@@ -31,6 +31,7 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(GUnixMountEntry, g_unix_mount_free)
 struct FuPluginData {
 	FuUefiBgrt		*bgrt;
 	FuVolume		*esp;
+	FuDeviceLocker		*esp_locker;	/* (nullable): held for a composite update */
 };
 
 void
@@ -55,6 +56,8 @@ void
 fu_plugin_destroy (FuPlugin *plugin)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
+	if (data->esp_locker != NULL)
+		g_object_unref (data->esp_locker);
 	if (data->esp != NULL)
 		g_object_unref (data->esp);
 	g_object_unref (data->bgrt);
@@ -148,22 +151,26 @@ fu_plugin_add_security_attrs (FuPlugin *plugin, FuSecurityAttrs *attrs)
 }
 
 static GBytes *
-fu_plugin_uefi_capsule_get_splash_data (guint width, guint height, GError **error)
+fu_plugin_uefi_capsule_get_splash_archive (GError **error)
 {
-	const gchar * const *langs = g_get_language_names ();
-	g_autofree gchar *datadir_pkg = NULL;
+	g_autofree gchar *datadir_pkg = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
 	g_autofree gchar *filename_archive = NULL;
+	filename_archive = g_build_filename (datadir_pkg, "uefi-capsule-ux.tar.xz", NULL);
+	return fu_common_get_contents_bytes (filename_archive, error);
+}
+
+static GBytes *
+fu_plugin_uefi_capsule_get_splash_data (GBytes *blob_archive,
+					guint width,
+					guint height,
+					GError **error)
+{
+	const gchar * const *langs = g_get_language_names ();
 	g_autofree gchar *langs_str = NULL;
 	g_autoptr(FuArchive) archive = NULL;
-	g_autoptr(GBytes) blob_archive = NULL;
 
-	/* load archive */
-	datadir_pkg = fu_common_get_path (FU_PATH_KIND_DATADIR_PKG);
-	filename_archive = g_build_filename (datadir_pkg, "uefi-capsule-ux.tar.xz", NULL);
-	blob_archive = fu_common_get_contents_bytes (filename_archive, error);
-	if (blob_archive == NULL)
-		return NULL;
-	archive = fu_archive_new (blob_archive, FU_ARCHIVE_FLAG_NONE, error);
+	/* decompress archive */
+	archive = fu_archive_new (blob_archive, FU_ARCHIVE_FLAG_LAZY, error);
 	if (archive == NULL)
 		return NULL;
 
@@ -187,8 +194,8 @@ fu_plugin_uefi_capsule_get_splash_data (guint width, guint height, GError **erro
 	g_set_error (error,
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_NOT_SUPPORTED,
-		     "failed to get splash file for %s in %s",
-		     langs_str, datadir_pkg);
+		     "failed to get splash file for %s",
+		     langs_str);
 	return NULL;
 }
 
@@ -201,10 +208,72 @@ fu_plugin_uefi_capsule_calc_checksum (const guint8 *buf, gsize sz)
 	return csum;
 }
 
+static gchar *
+fu_plugin_uefi_capsule_get_splash_filename (FuPlugin *plugin, FuDevice *device)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	g_autofree gchar *esp_path = fu_volume_get_mount_point (data->esp);
+	g_autofree gchar *directory = fu_uefi_get_esp_path_for_os (device, esp_path);
+	g_autofree gchar *basename = NULL;
+	basename = g_strdup_printf ("fwupd-%s.cap", FU_EFIVAR_GUID_UX_CAPSULE);
+	return g_build_filename (directory, "fw", basename, NULL);
+}
+
+static gchar *
+fu_plugin_uefi_capsule_get_splash_cache_filename (void)
+{
+	g_autofree gchar *cachedir = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedir, "uefi-capsule-ux.ini", NULL);
+}
+
+/* the capsule on the ESP is still the one that was written for this key */
+static gboolean
+fu_plugin_uefi_capsule_splash_is_cached (const gchar *key, const gchar *fn)
+{
+	g_autofree gchar *cache_fn = fu_plugin_uefi_capsule_get_splash_cache_filename ();
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *checksum_esp = NULL;
+	g_autofree gchar *fn_cached = NULL;
+	g_autofree gchar *key_cached = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (!g_key_file_load_from_file (kf, cache_fn, G_KEY_FILE_NONE, NULL))
+		return FALSE;
+	key_cached = g_key_file_get_string (kf, "UxCapsule", "Key", NULL);
+	fn_cached = g_key_file_get_string (kf, "UxCapsule", "Filename", NULL);
+	checksum = g_key_file_get_string (kf, "UxCapsule", "Checksum", NULL);
+	if (g_strcmp0 (key, key_cached) != 0 || g_strcmp0 (fn, fn_cached) != 0)
+		return FALSE;
+	blob = fu_common_get_contents_bytes (fn, NULL);
+	if (blob == NULL)
+		return FALSE;
+	checksum_esp = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	return g_strcmp0 (checksum, checksum_esp) == 0;
+}
+
+static void
+fu_plugin_uefi_capsule_splash_set_cached (const gchar *key,
+					  const gchar *fn,
+					  const gchar *checksum)
+{
+	g_autofree gchar *cache_fn = fu_plugin_uefi_capsule_get_splash_cache_filename ();
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	g_key_file_set_string (kf, "UxCapsule", "Key", key);
+	g_key_file_set_string (kf, "UxCapsule", "Filename", fn);
+	g_key_file_set_string (kf, "UxCapsule", "Checksum", checksum);
+	if (!fu_common_mkdir_parent (cache_fn, &error_local) ||
+	    !g_key_file_save_to_file (kf, cache_fn, &error_local))
+		g_debug ("failed to save UX capsule cache: %s", error_local->message);
+}
+
 static gboolean
 fu_plugin_uefi_capsule_write_splash_data (FuPlugin *plugin,
 					  FuDevice *device,
 					  GBytes *blob,
+					  const gchar *key,
 					  GError **error)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
@@ -220,10 +289,8 @@ fu_plugin_uefi_capsule_write_splash_data (FuPlugin *plugin,
 		.header_size = sizeof(efi_capsule_header_t),
 		.capsule_image_size = 0
 	};
-	g_autofree gchar *esp_path = NULL;
 	g_autofree gchar *fn = NULL;
-	g_autofree gchar *directory = NULL;
-	g_autofree gchar *basename = NULL;
+	g_autoptr(GChecksum) checksum = g_checksum_new (G_CHECKSUM_SHA256);
 	g_autoptr(GFile) ofile = NULL;
 	g_autoptr(GOutputStream) ostream = NULL;
 
@@ -237,10 +304,7 @@ fu_plugin_uefi_capsule_write_splash_data (FuPlugin *plugin,
 	}
 
 	/* save to a predicatable filename */
-	esp_path = fu_volume_get_mount_point (data->esp);
-	directory = fu_uefi_get_esp_path_for_os (device, esp_path);
-	basename = g_strdup_printf ("fwupd-%s.cap", FU_EFIVAR_GUID_UX_CAPSULE);
-	fn = g_build_filename (directory, "fw", basename, NULL);
+	fn = fu_plugin_uefi_capsule_get_splash_filename (plugin, device);
 	if (!fu_common_mkdir_parent (fn, error))
 		return FALSE;
 	ofile = g_file_new_for_path (fn);
@@ -286,6 +350,14 @@ fu_plugin_uefi_capsule_write_splash_data (FuPlugin *plugin,
 	size = g_output_stream_write_bytes (ostream, blob, NULL, error);
 	if (size < 0)
 		return FALSE;
+	if (!g_output_stream_close (ostream, NULL, error))
+		return FALSE;
+
+	/* so the next update can reuse the file */
+	g_checksum_update (checksum, (const guchar *) &capsule_header, capsule_header.header_size);
+	g_checksum_update (checksum, (const guchar *) &header, sizeof(header));
+	g_checksum_update (checksum, g_bytes_get_data (blob, NULL), g_bytes_get_size (blob));
+	fu_plugin_uefi_capsule_splash_set_cached (key, fn, g_checksum_get_string (checksum));
 
 	/* write display capsule location as UPDATE_INFO */
 	return fu_uefi_device_write_update_info (FU_UEFI_DEVICE (device), fn,
@@ -298,10 +370,16 @@ static gboolean
 fu_plugin_uefi_capsule_update_splash (FuPlugin *plugin, FuDevice *device, GError **error)
 {
 	FuPluginData *data = fu_plugin_get_data (plugin);
+	const gchar * const *langs = g_get_language_names ();
 	guint best_idx = G_MAXUINT;
 	guint32 lowest_border_pixels = G_MAXUINT;
 	guint32 screen_height = 768;
 	guint32 screen_width = 1024;
+	g_autofree gchar *checksum_archive = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *key = NULL;
+	g_autofree gchar *langs_str = NULL;
+	g_autoptr(GBytes) blob_archive = NULL;
 	g_autoptr(GBytes) image_bmp = NULL;
 
 	struct {
@@ -365,15 +443,37 @@ fu_plugin_uefi_capsule_update_splash (FuPlugin *plugin, FuDevice *device, GError
 		return FALSE;
 	}
 
+	/* everything that changes the capsule, without decompressing the archive */
+	blob_archive = fu_plugin_uefi_capsule_get_splash_archive (error);
+	if (blob_archive == NULL)
+		return FALSE;
+	checksum_archive = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_archive);
+	langs_str = g_strjoinv (",", (gchar **) langs);
+	key = g_strdup_printf ("%s;%ux%u;%ux%u;%u;%s", langs_str,
+			       sizes[best_idx].width, sizes[best_idx].height,
+			       screen_width, screen_height,
+			       (guint) (fu_uefi_bgrt_get_yoffset (data->bgrt) +
+					fu_uefi_bgrt_get_height (data->bgrt)),
+			       checksum_archive);
+	fn = fu_plugin_uefi_capsule_get_splash_filename (plugin, device);
+	if (fu_plugin_uefi_capsule_splash_is_cached (key, fn)) {
+		g_debug ("reusing UX capsule %s", fn);
+		return fu_uefi_device_write_update_info (FU_UEFI_DEVICE (device), fn,
+							 "fwupd-ux-capsule",
+							 FU_EFIVAR_GUID_UX_CAPSULE,
+							 error);
+	}
+
 	/* get the raw data */
-	image_bmp = fu_plugin_uefi_capsule_get_splash_data (sizes[best_idx].width,
+	image_bmp = fu_plugin_uefi_capsule_get_splash_data (blob_archive,
+							    sizes[best_idx].width,
 							    sizes[best_idx].height,
 							    error);
 	if (image_bmp == NULL)
 		return FALSE;
 
 	/* perform the upload */
-	return fu_plugin_uefi_capsule_write_splash_data (plugin, device, image_bmp, error);
+	return fu_plugin_uefi_capsule_write_splash_data (plugin, device, image_bmp, key, error);
 }
 
 gboolean
@@ -418,6 +518,77 @@ fu_plugin_update (FuPlugin *plugin,
 	return fu_device_write_firmware (device, blob_fw, flags, error);
 }
 
+static GPtrArray *
+fu_plugin_uefi_capsule_get_composite_devices (FuPlugin *plugin, GPtrArray *devices)
+{
+	GPtrArray *devices_uefi = g_ptr_array_new ();
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		if (!FU_IS_UEFI_DEVICE (device))
+			continue;
+		if (g_strcmp0 (fu_device_get_plugin (device),
+			       fu_plugin_get_name (plugin)) != 0)
+			continue;
+		g_ptr_array_add (devices_uefi, device);
+	}
+	return devices_uefi;
+}
+
+gboolean
+fu_plugin_composite_prepare (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	g_autoptr(GPtrArray) devices_uefi = NULL;
+
+	/* only one reboot is needed however many capsules are being deployed */
+	devices_uefi = fu_plugin_uefi_capsule_get_composite_devices (plugin, devices);
+	if (devices_uefi->len < 2)
+		return TRUE;
+
+	/* mount once for every device rather than in each prepare and cleanup */
+	if (data->esp != NULL && data->esp_locker == NULL) {
+		data->esp_locker = fu_volume_locker (data->esp, error);
+		if (data->esp_locker == NULL)
+			return FALSE;
+	}
+
+	/* remove anything left over from a previous attempt just once */
+	if (!fu_uefi_device_cleanup_esp (g_ptr_array_index (devices_uefi, 0), error))
+		return FALSE;
+	for (guint i = 0; i < devices_uefi->len; i++) {
+		FuUefiDevice *device_uefi = g_ptr_array_index (devices_uefi, i);
+		fu_uefi_device_set_defer_bootnext (device_uefi, TRUE);
+	}
+	return TRUE;
+}
+
+gboolean
+fu_plugin_composite_cleanup (FuPlugin *plugin, GPtrArray *devices, GError **error)
+{
+	FuPluginData *data = fu_plugin_get_data (plugin);
+	FuUefiDevice *device_staged = NULL;
+	g_autoptr(FuDeviceLocker) esp_locker = g_steal_pointer (&data->esp_locker);
+	g_autoptr(GPtrArray) devices_uefi = NULL;
+
+	/* any capsules staged before a failure are still scheduled */
+	devices_uefi = fu_plugin_uefi_capsule_get_composite_devices (plugin, devices);
+	for (guint i = 0; i < devices_uefi->len; i++) {
+		FuUefiDevice *device_uefi = g_ptr_array_index (devices_uefi, i);
+		if (device_staged == NULL && fu_uefi_device_get_staged (device_uefi))
+			device_staged = device_uefi;
+		fu_uefi_device_set_defer_bootnext (device_uefi, FALSE);
+	}
+	if (device_staged != NULL) {
+		if (!fu_uefi_device_write_bootnext (device_staged, error))
+			return FALSE;
+	}
+
+	/* unmount if mounted in fu_plugin_composite_prepare() */
+	if (esp_locker != NULL)
+		return fu_device_locker_close (esp_locker, error);
+	return TRUE;
+}
+
 static void
 fu_plugin_uefi_capsule_load_config (FuPlugin *plugin, FuDevice *device)
 {
@@ -8,10 +8,12 @@
 
 #include <efivar/efiboot.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <stdio.h>
 
 #include "fwupd-error.h"
 
+#include "fu-common.h"
 #include "fu-ucs2.h"
 #include "fu-uefi-bootmgr.h"
 #include "fu-uefi-common.h"
@@ -252,13 +254,21 @@ static gboolean
 fu_uefi_cmp_asset (const gchar *source, const gchar *target)
 {
 	gsize len = 0;
+	GStatBuf source_stat;
+	GStatBuf target_stat;
 	g_autofree gchar *source_checksum = NULL;
 	g_autofree gchar *source_data = NULL;
 	g_autofree gchar *target_checksum = NULL;
 	g_autofree gchar *target_data = NULL;
 
 	/* nothing in target yet */
-	if (!g_file_test (target, G_FILE_TEST_EXISTS))
+	if (g_stat (target, &target_stat) != 0)
+		return FALSE;
+
+	/* reading from the ESP is slow, so check the size first */
+	if (g_stat (source, &source_stat) != 0)
+		return FALSE;
+	if (source_stat.st_size != target_stat.st_size)
 		return FALSE;
 
 	/* test if the file needs to be updated */
@@ -276,16 +286,11 @@ fu_uefi_cmp_asset (const gchar *source, const gchar *target)
 static gboolean
 fu_uefi_copy_asset (const gchar *source, const gchar *target, GError **error)
 {
-	g_autoptr(GFile) source_file = g_file_new_for_path (source);
-	g_autoptr(GFile) target_file = g_file_new_for_path (target);
-
-	if (!g_file_copy (source_file,
-			  target_file,
-			  G_FILE_COPY_OVERWRITE,
-			  NULL,
-			  NULL,
-			  NULL,
-			  error)) {
+	g_autoptr(GBytes) blob = NULL;
+
+	blob = fu_common_get_contents_bytes (source, error);
+	if (blob == NULL ||
+	    !fu_uefi_esp_write_file (target, blob, error)) {
 		g_prefix_error (error, "Failed to copy %s to %s: ",
 				source, target);
 		return FALSE;
@@ -316,6 +321,7 @@ fu_uefi_bootmgr_bootnext (FuDevice *device,
 	g_autofree guint8 *opt = NULL;
 	g_autofree gchar *source_app = NULL;
 	g_autofree gchar *target_app = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
 
 	/* skip for self tests */
 	if (g_getenv ("FWUPD_UEFI_TEST") != NULL)
@@ -374,8 +380,16 @@ fu_uefi_bootmgr_bootnext (FuDevice *device,
 	if (!fu_uefi_cmp_asset (source_app, target_app)) {
 		if (!fu_uefi_copy_asset (source_app, target_app, error))
 			return FALSE;
+	} else {
+		g_debug ("%s is already up to date", target_app);
 	}
 
+	/* the capsule and loader must be on disk before using BootNext */
+	g_timer_reset (timer);
+	if (!fu_uefi_esp_sync (esp_path, error))
+		return FALSE;
+	g_debug ("syncing %s took %.1fms", esp_path, g_timer_elapsed (timer, NULL) * 1000.f);
+
 	/* no shim, so use this directly */
 	if (use_fwup_path)
 		filepath = target_app;
@@ -8,6 +8,10 @@
 #include "config.h"
 
 #include <efivar.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
 
 #include "fu-common.h"
 #include "fu-uefi-common.h"
@@ -273,3 +277,118 @@ fu_uefi_read_file_as_uint64 (const gchar *path, const gchar *attr_name)
 		return 0x0;
 	return fu_common_strtoull (data);
 }
+
+/* sysfs attributes are tiny, so read them relative to the entry directory
+ * without the overhead of building a path and using GIO for each one */
+gchar *
+fu_uefi_read_file_at (gint dirfd, const gchar *attr_name)
+{
+	gchar buf[128] = { '\0' };
+	gssize len;
+	gint fd = openat (dirfd, attr_name, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	len = read (fd, buf, sizeof(buf) - 1);
+	g_close (fd, NULL);
+	if (len < 0)
+		return NULL;
+	buf[len] = '\0';
+	g_strdelimit (buf, "\n", '\0');
+	return g_strdup (buf);
+}
+
+guint64
+fu_uefi_read_file_at_as_uint64 (gint dirfd, const gchar *attr_name)
+{
+	g_autofree gchar *data = fu_uefi_read_file_at (dirfd, attr_name);
+	if (data == NULL)
+		return 0x0;
+	return fu_common_strtoull (data);
+}
+
+/* the ESP is usually FAT where replacing a file using a temporary file and
+ * a rename is slow, so write it in place and sync once in fu_uefi_esp_sync() */
+gboolean
+fu_uefi_esp_write_file (const gchar *fn, GBytes *blob, GError **error)
+{
+	const guint8 *buf;
+	gsize bufsz = 0;
+	gsize offset = 0;
+	gint fd;
+
+	if (!fu_common_mkdir_parent (fn, error))
+		return FALSE;
+	buf = g_bytes_get_data (blob, &bufsz);
+	g_debug ("writing %s with %" G_GSIZE_FORMAT " bytes", fn, bufsz);
+	fd = g_open (fn, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to open %s: %s",
+			     fn, g_strerror (errno));
+		return FALSE;
+	}
+
+#ifdef HAVE_FALLOCATE
+	/* reserve all the clusters now so a full ESP fails before writing */
+	if (bufsz > 0 &&
+	    fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, bufsz) < 0 &&
+	    errno != EOPNOTSUPP) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to allocate %" G_GSIZE_FORMAT " bytes for %s: %s",
+			     bufsz, fn, g_strerror (errno));
+		g_close (fd, NULL);
+		return FALSE;
+	}
+#endif
+
+	while (offset < bufsz) {
+		gssize wrote = write (fd, buf + offset, bufsz - offset);
+		if (wrote < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error (error,
+				     G_IO_ERROR,
+				     g_io_error_from_errno (errno),
+				     "failed to write %s: %s",
+				     fn, g_strerror (errno));
+			g_close (fd, NULL);
+			return FALSE;
+		}
+		offset += wrote;
+	}
+	return g_close (fd, error);
+}
+
+/* flush everything written by fu_uefi_esp_write_file() to the disk */
+gboolean
+fu_uefi_esp_sync (const gchar *esp_path, GError **error)
+{
+#ifdef HAVE_SYNCFS
+	gint fd = g_open (esp_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to open %s: %s",
+			     esp_path, g_strerror (errno));
+		return FALSE;
+	}
+	if (syncfs (fd) < 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     g_io_error_from_errno (errno),
+			     "failed to sync %s: %s",
+			     esp_path, g_strerror (errno));
+		g_close (fd, NULL);
+		return FALSE;
+	}
+	return g_close (fd, error);
+#else
+	sync ();
+	return TRUE;
+#endif
+}
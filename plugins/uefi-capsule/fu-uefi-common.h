@@ -79,3 +79,12 @@ GPtrArray	*fu_uefi_get_esrt_entry_paths	(const gchar	*esrt_path,
 						 GError		**error);
 guint64		 fu_uefi_read_file_as_uint64	(const gchar	*path,
 						 const gchar	*attr_name);
+gchar		*fu_uefi_read_file_at		(gint		 dirfd,
+						 const gchar	*attr_name);
+guint64		 fu_uefi_read_file_at_as_uint64	(gint		 dirfd,
+						 const gchar	*attr_name);
+gboolean	 fu_uefi_esp_write_file		(const gchar	*fn,
+						 GBytes		*blob,
+						 GError		**error);
+gboolean	 fu_uefi_esp_sync		(const gchar	*esp_path,
+						 GError		**error);
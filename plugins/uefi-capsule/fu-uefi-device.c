@@ -7,6 +7,8 @@
 
 #include "config.h"
 
+#include <fcntl.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <efivar.h>
 #include <efivar/efiboot.h>
@@ -37,6 +39,8 @@ struct _FuUefiDevice {
 	gboolean		 missing_header;
 	gboolean		 automounted_esp;
 	gboolean		 requires_header;
+	gboolean		 defer_bootnext;
+	gboolean		 staged;
 };
 
 G_DEFINE_TYPE (FuUefiDevice, fu_uefi_device, FU_TYPE_DEVICE)
@@ -456,27 +460,43 @@ fu_uefi_check_asset (FuDevice *device, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_uefi_device_cleanup_esp (FuDevice *device, GError **error)
+gboolean
+fu_uefi_device_cleanup_esp (FuUefiDevice *self, GError **error)
 {
-	FuUefiDevice *self = FU_UEFI_DEVICE (device);
-	g_autofree gchar *esp_path = fu_volume_get_mount_point (self->esp);
+	g_autofree gchar *esp_path = NULL;
 	g_autofree gchar *pattern = NULL;
+	g_autofree gchar *ux_basename = NULL;
+	g_autoptr(FuDeviceLocker) locker = NULL;
 	g_autoptr(GPtrArray) files = NULL;
 
+	g_return_val_if_fail (FU_IS_UEFI_DEVICE (self), FALSE);
+
 	/* in case we call capsule install twice before reboot */
 	if (fu_efivar_exists (FU_EFIVAR_GUID_EFI_GLOBAL, "BootNext"))
 		return TRUE;
 
+	/* mount if required */
+	locker = fu_volume_locker (self->esp, error);
+	if (locker == NULL)
+		return FALSE;
+	esp_path = fu_volume_get_mount_point (self->esp);
+
 	/* delete any files matching the glob in the ESP */
 	files = fu_common_get_files_recursive (esp_path, error);
 	if (files == NULL)
 		return FALSE;
 	pattern = g_build_filename (esp_path, "EFI/*/fw/fwupd*.cap", NULL);
+	ux_basename = g_strdup_printf ("fwupd-%s.cap", FU_EFIVAR_GUID_UX_CAPSULE);
 	for (guint i = 0; i < files->len; i++) {
 		const gchar *fn = g_ptr_array_index (files, i);
 		if (fu_common_fnmatch (pattern, fn)) {
-			g_autoptr(GFile) file = g_file_new_for_path (fn);
+			g_autofree gchar *basename = g_path_get_basename (fn);
+			g_autoptr(GFile) file = NULL;
+
+			/* the UX capsule is reused if the splash is unchanged */
+			if (g_strcmp0 (basename, ux_basename) == 0)
+				continue;
+			file = g_file_new_for_path (fn);
 			g_debug ("deleting %s", fn);
 			if (!g_file_delete (file, NULL, error))
 				return FALSE;
@@ -496,17 +516,25 @@ fu_uefi_device_prepare (FuDevice *device,
 			GError **error)
 {
 	FuUefiDevice *self = FU_UEFI_DEVICE (device);
+	g_autoptr(GTimer) timer = g_timer_new ();
 
 	/* mount if required */
 	self->esp_locker = fu_volume_locker (self->esp, error);
 	if (self->esp_locker == NULL)
 		return FALSE;
+	g_debug ("mounting ESP took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
 
-	/* sanity checks */
-	if (!fu_uefi_device_cleanup_esp (device, error))
-		return FALSE;
+	/* sanity checks; a composite update is cleaned up by the plugin */
+	g_timer_reset (timer);
+	if (!self->defer_bootnext) {
+		if (!fu_uefi_device_cleanup_esp (self, error))
+			return FALSE;
+		g_debug ("cleaning ESP took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
+	}
+	g_timer_reset (timer);
 	if (!fu_uefi_device_check_esp_free (device, error))
 		return FALSE;
+	g_debug ("checking ESP free space took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
 	if (!fu_uefi_check_asset (device, error))
 		return FALSE;
 
@@ -528,6 +556,63 @@ fu_uefi_device_cleanup (FuDevice *device,
 	return TRUE;
 }
 
+static gboolean
+fu_uefi_device_setup_bootnext (FuUefiDevice *self, const gchar *esp_path, GError **error)
+{
+	FuDevice *device = FU_DEVICE (self);
+	FuUefiBootmgrFlags flags = FU_UEFI_BOOTMGR_FLAG_NONE;
+	const gchar *bootmgr_desc = "Linux Firmware Updater";
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* update the firmware before the bootloader runs */
+	if (fu_device_get_metadata_boolean (device, "RequireShimForSecureBoot"))
+		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_FOR_SB;
+	if (fu_device_has_custom_flag (device, "use-shim-unique"))
+		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_UNIQUE;
+
+	/* some legacy devices use the old name to deduplicate boot entries */
+	if (fu_device_has_custom_flag (device, "use-legacy-bootmgr-desc"))
+		bootmgr_desc = "Linux-Firmware-Updater";
+	if (!fu_uefi_bootmgr_bootnext (device, esp_path, bootmgr_desc, flags, error))
+		return FALSE;
+	g_debug ("setting up BootNext took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
+	return TRUE;
+}
+
+/* only stage the capsule when writing so that all the capsules in a composite
+ * update get applied by one UpdateCapsule() call after the same reboot */
+void
+fu_uefi_device_set_defer_bootnext (FuUefiDevice *self, gboolean defer_bootnext)
+{
+	g_return_if_fail (FU_IS_UEFI_DEVICE (self));
+	self->defer_bootnext = defer_bootnext;
+	self->staged = FALSE;
+}
+
+/* the capsule was written while BootNext was deferred */
+gboolean
+fu_uefi_device_get_staged (FuUefiDevice *self)
+{
+	g_return_val_if_fail (FU_IS_UEFI_DEVICE (self), FALSE);
+	return self->staged;
+}
+
+gboolean
+fu_uefi_device_write_bootnext (FuUefiDevice *self, GError **error)
+{
+	g_autofree gchar *esp_path = NULL;
+	g_autoptr(FuDeviceLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_UEFI_DEVICE (self), FALSE);
+
+	/* mount if required */
+	locker = fu_volume_locker (self->esp, error);
+	if (locker == NULL)
+		return FALSE;
+	esp_path = fu_volume_get_mount_point (self->esp);
+	return fu_uefi_device_setup_bootnext (self, esp_path, error);
+}
+
 static gboolean
 fu_uefi_device_write_firmware (FuDevice *device,
 			       FuFirmware *firmware,
@@ -535,8 +620,6 @@ fu_uefi_device_write_firmware (FuDevice *device,
 			       GError **error)
 {
 	FuUefiDevice *self = FU_UEFI_DEVICE (device);
-	FuUefiBootmgrFlags flags = FU_UEFI_BOOTMGR_FLAG_NONE;
-	const gchar *bootmgr_desc = "Linux Firmware Updater";
 	g_autofree gchar *esp_path = fu_volume_get_mount_point (self->esp);
 	g_autoptr(GBytes) fixed_fw = NULL;
 	g_autoptr(GBytes) fw = NULL;
@@ -544,6 +627,7 @@ fu_uefi_device_write_firmware (FuDevice *device,
 	g_autofree gchar *directory = NULL;
 	g_autofree gchar *fn = NULL;
 	g_autofree gchar *varname = fu_uefi_device_build_varname (self);
+	g_autoptr(GTimer) timer = g_timer_new ();
 
 	/* ensure we have the existing state */
 	if (self->fw_class == NULL) {
@@ -563,13 +647,12 @@ fu_uefi_device_write_firmware (FuDevice *device,
 	directory = fu_uefi_get_esp_path_for_os (device, esp_path);
 	basename = g_strdup_printf ("fwupd-%s.cap", self->fw_class);
 	fn = g_build_filename (directory, "fw", basename, NULL);
-	if (!fu_common_mkdir_parent (fn, error))
-		return FALSE;
 	fixed_fw = fu_uefi_device_fixup_firmware (device, fw, error);
 	if (fixed_fw == NULL)
 		return FALSE;
-	if (!fu_common_set_contents_bytes (fn, fixed_fw, error))
+	if (!fu_uefi_esp_write_file (fn, fixed_fw, error))
 		return FALSE;
+	g_debug ("writing capsule took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
 
 	/* delete the logs to save space; use fwupdate to debug the EFI binary */
 	if (fu_efivar_exists (FU_EFIVAR_GUID_FWUPDATE, "FWUPDATE_VERBOSE")) {
@@ -584,19 +667,18 @@ fu_uefi_device_write_firmware (FuDevice *device,
 	}
 
 	/* set the blob header shared with fwupd.efi */
+	g_timer_reset (timer);
 	if (!fu_uefi_device_write_update_info (self, fn, varname, self->fw_class, error))
 		return FALSE;
+	g_debug ("writing update info took %.1fms", g_timer_elapsed (timer, NULL) * 1000.f);
 
-	/* update the firmware before the bootloader runs */
-	if (fu_device_get_metadata_boolean (device, "RequireShimForSecureBoot"))
-		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_FOR_SB;
-	if (fu_device_has_custom_flag (device, "use-shim-unique"))
-		flags |= FU_UEFI_BOOTMGR_FLAG_USE_SHIM_UNIQUE;
-
-	/* some legacy devices use the old name to deduplicate boot entries */
-	if (fu_device_has_custom_flag (device, "use-legacy-bootmgr-desc"))
-		bootmgr_desc = "Linux-Firmware-Updater";
-	if (!fu_uefi_bootmgr_bootnext (device, esp_path, bootmgr_desc, flags, error))
+	/* the plugin sets BootNext when all the capsules are staged */
+	if (self->defer_bootnext) {
+		g_debug ("deferring BootNext for %s", fu_device_get_id (device));
+		self->staged = TRUE;
+		return TRUE;
+	}
+	if (!fu_uefi_device_setup_bootnext (self, esp_path, error))
 		return FALSE;
 
 	/* success! */
@@ -756,8 +838,8 @@ fu_uefi_device_class_init (FuUefiDeviceClass *klass)
 FuUefiDevice *
 fu_uefi_device_new_from_entry (const gchar *entry_path, GError **error)
 {
+	gint dirfd;
 	g_autoptr(FuUefiDevice) self = NULL;
-	g_autofree gchar *fw_class_fn = NULL;
 	g_autofree gchar *id = NULL;
 
 	g_return_val_if_fail (entry_path != NULL, NULL);
@@ -768,16 +850,18 @@ fu_uefi_device_new_from_entry (const gchar *entry_path, GError **error)
 	/* assume a uint64_t unless told otherwise by a quirk entry or metadata */
 	fu_device_set_version_format (FU_DEVICE (self), FWUPD_VERSION_FORMAT_NUMBER);
 
-	/* read values from sysfs */
-	fw_class_fn = g_build_filename (entry_path, "fw_class", NULL);
-	if (g_file_get_contents (fw_class_fn, &self->fw_class, NULL, NULL))
-		g_strdelimit (self->fw_class, "\n", '\0');
-	self->capsule_flags = fu_uefi_read_file_as_uint64 (entry_path, "capsule_flags");
-	self->kind = fu_uefi_read_file_as_uint64 (entry_path, "fw_type");
-	self->fw_version = fu_uefi_read_file_as_uint64 (entry_path, "fw_version");
-	self->last_attempt_status = fu_uefi_read_file_as_uint64 (entry_path, "last_attempt_status");
-	self->last_attempt_version = fu_uefi_read_file_as_uint64 (entry_path, "last_attempt_version");
-	self->fw_version_lowest = fu_uefi_read_file_as_uint64 (entry_path, "lowest_supported_fw_version");
+	/* read values from sysfs, opening the entry directory just once */
+	dirfd = open (entry_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirfd >= 0) {
+		self->fw_class = fu_uefi_read_file_at (dirfd, "fw_class");
+		self->capsule_flags = fu_uefi_read_file_at_as_uint64 (dirfd, "capsule_flags");
+		self->kind = fu_uefi_read_file_at_as_uint64 (dirfd, "fw_type");
+		self->fw_version = fu_uefi_read_file_at_as_uint64 (dirfd, "fw_version");
+		self->last_attempt_status = fu_uefi_read_file_at_as_uint64 (dirfd, "last_attempt_status");
+		self->last_attempt_version = fu_uefi_read_file_at_as_uint64 (dirfd, "last_attempt_version");
+		self->fw_version_lowest = fu_uefi_read_file_at_as_uint64 (dirfd, "lowest_supported_fw_version");
+		g_close (dirfd, NULL);
+	}
 
 	/* the hardware instance is not in the ESRT table and we should really
 	 * write the EFI stub to query with FMP -- but we still have not ever
@@ -61,3 +61,10 @@ gboolean	 fu_uefi_device_write_update_info	(FuUefiDevice	*self,
 							 const gchar	*varname,
 							 const gchar	*guid,
 							 GError		**error);
+gboolean	 fu_uefi_device_cleanup_esp		(FuUefiDevice	*self,
+							 GError		**error);
+void		 fu_uefi_device_set_defer_bootnext	(FuUefiDevice	*self,
+							 gboolean	 defer_bootnext);
+gboolean	 fu_uefi_device_get_staged		(FuUefiDevice	*self);
+gboolean	 fu_uefi_device_write_bootnext		(FuUefiDevice	*self,
+							 GError		**error);
@@ -61,13 +61,11 @@ fu_dbxtool_siglist_inclusive (FuFirmware *outer, FuFirmware *inner)
 	for (guint i = 0; i < sigs->len; i++) {
 		FuEfiSignature *sig = g_ptr_array_index (sigs, i);
 		g_autofree gchar *checksum = NULL;
-		g_autoptr(FuFirmwareImage) img = NULL;
 		checksum = fu_firmware_image_get_checksum (FU_FIRMWARE_IMAGE (sig),
 							   G_CHECKSUM_SHA256, NULL);
 		if (checksum == NULL)
 			continue;
-		img = fu_firmware_get_image_by_checksum (outer, checksum, NULL);
-		if (img == NULL)
+		if (!fu_efi_signature_list_has_checksum (FU_EFI_SIGNATURE_LIST (outer), checksum))
 			return FALSE;
 	}
 	return TRUE;
@@ -39,6 +39,34 @@ fu_efi_image_func (void)
 	g_assert_cmpstr (csum, ==, "e99707d4378140c01eb3f867240d5cc9e237b126d3db0c3b4bbcd3da1720ddff");
 }
 
+static void
+fu_efi_image_cache_func (void)
+{
+	const gchar *ci = g_getenv ("CI_NETWORK");
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GHashTable) hashes1 = NULL;
+	g_autoptr(GHashTable) hashes2 = NULL;
+	g_autoptr(GPtrArray) fns = g_ptr_array_new_with_free_func (g_free);
+
+	fn = g_test_build_filename (G_TEST_DIST, "tests", "fwupdx64.efi", NULL);
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS) && ci == NULL) {
+		g_test_skip ("Missing fwupdx64.efi");
+		return;
+	}
+	g_ptr_array_add (fns, g_strdup (fn));
+	g_ptr_array_add (fns, g_test_build_filename (G_TEST_DIST, "fu-self-test.c", NULL));
+
+	/* computed, then read back from the cache */
+	hashes1 = fu_uefi_dbx_get_authenticode_hashes (fns);
+	g_assert_cmpint (g_hash_table_size (hashes1), ==, 1);
+	g_assert_cmpstr (g_hash_table_lookup (hashes1, fn), ==,
+			 "e99707d4378140c01eb3f867240d5cc9e237b126d3db0c3b4bbcd3da1720ddff");
+	hashes2 = fu_uefi_dbx_get_authenticode_hashes (fns);
+	g_assert_cmpint (g_hash_table_size (hashes2), ==, 1);
+	g_assert_cmpstr (g_hash_table_lookup (hashes2, fn), ==,
+			 "e99707d4378140c01eb3f867240d5cc9e237b126d3db0c3b4bbcd3da1720ddff");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -47,8 +75,10 @@ main (int argc, char **argv)
 	/* only critical and error are fatal */
 	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
 	g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+	g_setenv ("FWUPD_LOCALSTATEDIR", "/tmp/fwupd-self-test/var", TRUE);
 
 	/* tests go here */
 	g_test_add_func ("/uefi-dbx/image", fu_efi_image_func);
+	g_test_add_func ("/uefi-dbx/image{cache}", fu_efi_image_cache_func);
 	return g_test_run ();
 }
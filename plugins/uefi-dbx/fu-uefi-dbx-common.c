@@ -6,6 +6,8 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+
 #include "fwupd-error.h"
 
 #include "fu-common.h"
@@ -34,10 +36,136 @@ fu_uefi_dbx_get_authenticode_hash (const gchar *fn, GError **error)
 	return g_strdup (fu_efi_image_get_checksum (img));
 }
 
+typedef struct {
+	const gchar	*fn;
+	gchar		*key;		/* size:mtime:ctime */
+	gchar		*checksum;
+	GError		*error;
+} FuUefiDbxHashHelper;
+
+static void
+fu_uefi_dbx_hash_helper_free (FuUefiDbxHashHelper *helper)
+{
+	g_free (helper->key);
+	g_free (helper->checksum);
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_free (helper);
+}
+
+static void
+fu_uefi_dbx_hash_thread_cb (gpointer data, gpointer user_data)
+{
+	FuUefiDbxHashHelper *helper = (FuUefiDbxHashHelper *) data;
+	helper->checksum = fu_uefi_dbx_get_authenticode_hash (helper->fn, &helper->error);
+}
+
+static gchar *
+fu_uefi_dbx_hash_cache_filename (void)
+{
+	g_autofree gchar *cachedir = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedir, "uefi-dbx", "authenticode.cache", NULL);
+}
+
+/* the ctime is included as the mtime can be set from userspace */
+static gchar *
+fu_uefi_dbx_hash_cache_key (const gchar *fn)
+{
+	GStatBuf st = { 0x0 };
+	if (g_stat (fn, &st) != 0)
+		return NULL;
+	return g_strdup_printf ("%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+				(guint64) st.st_size,
+				(gint64) st.st_mtime,
+				(gint64) st.st_ctime);
+}
+
+/* returns filename:checksum, skipping files that are not PE images; files
+ * that have not changed since they were last hashed are not read again */
+GHashTable *
+fu_uefi_dbx_get_authenticode_hashes (GPtrArray *fns)
+{
+	gboolean cache_changed = FALSE;
+	GThreadPool *pool;
+	g_autofree gchar *cache_fn = fu_uefi_dbx_hash_cache_filename ();
+	g_autoptr(GError) error_cache = NULL;
+	g_autoptr(GHashTable) hashes = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+	g_autoptr(GPtrArray) helpers = NULL;
+
+	/* files that are new or changed since last time */
+	hashes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	helpers = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_uefi_dbx_hash_helper_free);
+	if (!g_key_file_load_from_file (kf, cache_fn, G_KEY_FILE_NONE, &error_cache))
+		g_debug ("no Authenticode cache: %s", error_cache->message);
+	for (guint i = 0; i < fns->len; i++) {
+		FuUefiDbxHashHelper *helper;
+		const gchar *fn = g_ptr_array_index (fns, i);
+		g_autofree gchar *key = fu_uefi_dbx_hash_cache_key (fn);
+		g_autofree gchar *key_cached = NULL;
+
+		key_cached = g_key_file_get_string (kf, fn, "Key", NULL);
+		if (key != NULL && g_strcmp0 (key, key_cached) == 0) {
+			g_autofree gchar *checksum = g_key_file_get_string (kf, fn, "Checksum", NULL);
+			if (checksum != NULL) {
+				g_hash_table_insert (hashes, g_strdup (fn), g_steal_pointer (&checksum));
+				continue;
+			}
+		}
+		helper = g_new0 (FuUefiDbxHashHelper, 1);
+		helper->fn = fn;
+		helper->key = g_steal_pointer (&key);
+		g_ptr_array_add (helpers, helper);
+	}
+	g_debug ("%u Authenticode hashes cached, %u to compute",
+		 g_hash_table_size (hashes), helpers->len);
+
+	/* each file is independent, so hash them concurrently */
+	pool = g_thread_pool_new (fu_uefi_dbx_hash_thread_cb, NULL,
+				  (gint) g_get_num_processors (), TRUE, NULL);
+	for (guint i = 0; i < helpers->len; i++) {
+		FuUefiDbxHashHelper *helper = g_ptr_array_index (helpers, i);
+		if (pool == NULL || !g_thread_pool_push (pool, helper, NULL))
+			fu_uefi_dbx_hash_thread_cb (helper, NULL);
+	}
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+
+	/* collect results */
+	for (guint i = 0; i < helpers->len; i++) {
+		FuUefiDbxHashHelper *helper = g_ptr_array_index (helpers, i);
+		if (helper->checksum == NULL) {
+			g_debug ("failed to get checksum for %s: %s",
+				 helper->fn, helper->error->message);
+			continue;
+		}
+		if (helper->key != NULL) {
+			g_key_file_set_string (kf, helper->fn, "Key", helper->key);
+			g_key_file_set_string (kf, helper->fn, "Checksum", helper->checksum);
+			cache_changed = TRUE;
+		}
+		g_hash_table_insert (hashes,
+				     g_strdup (helper->fn),
+				     g_steal_pointer (&helper->checksum));
+	}
+
+	/* save for next time, which is not fatal if the cache is read-only */
+	if (cache_changed) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_common_mkdir_parent (cache_fn, &error_local) ||
+		    !g_key_file_save_to_file (kf, cache_fn, &error_local)) {
+			g_debug ("failed to save Authenticode cache: %s",
+				 error_local->message);
+		}
+	}
+	return g_steal_pointer (&hashes);
+}
+
 static gboolean
 fu_uefi_dbx_signature_list_validate_volume (FuEfiSignatureList *siglist, FuVolume *esp, GError **error)
 {
 	g_autofree gchar *esp_path = NULL;
+	g_autoptr(GHashTable) hashes = NULL;
 	g_autoptr(GPtrArray) files = NULL;
 
 	/* get list of files contained in the ESP */
@@ -47,25 +175,19 @@ fu_uefi_dbx_signature_list_validate_volume (FuEfiSignatureList *siglist, FuVolum
 	files = fu_common_get_files_recursive (esp_path, error);
 	if (files == NULL)
 		return FALSE;
+	hashes = fu_uefi_dbx_get_authenticode_hashes (files);
 
 	/* verify each file does not exist in the ESP */
 	for (guint i = 0; i < files->len; i++) {
 		const gchar *fn = g_ptr_array_index (files, i);
-		g_autofree gchar *checksum = NULL;
-		g_autoptr(FuFirmwareImage) img = NULL;
-		g_autoptr(GError) error_local = NULL;
+		const gchar *checksum = g_hash_table_lookup (hashes, fn);
 
-		/* get checksum of file */
-		checksum = fu_uefi_dbx_get_authenticode_hash (fn, &error_local);
-		if (checksum == NULL) {
-			g_debug ("failed to get checksum for %s: %s", fn, error_local->message);
+		if (checksum == NULL)
 			continue;
-		}
 
 		/* Authenticode signature is present in dbx! */
 		g_debug ("fn=%s, checksum=%s", fn, checksum);
-		img = fu_firmware_get_image_by_checksum (FU_FIRMWARE (siglist), checksum, NULL);
-		if (img != NULL) {
+		if (fu_efi_signature_list_has_checksum (siglist, checksum)) {
 			g_set_error (error,
 				     FWUPD_ERROR,
 				     FWUPD_ERROR_NEEDS_USER_ACTION,
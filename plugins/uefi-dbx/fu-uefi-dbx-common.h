@@ -12,5 +12,6 @@
 
 gchar		*fu_uefi_dbx_get_authenticode_hash	(const gchar	*fn,
 							 GError		**error);
+GHashTable	*fu_uefi_dbx_get_authenticode_hashes	(GPtrArray	*fns);
 gboolean	 fu_uefi_dbx_signature_list_validate	(FuEfiSignatureList	*siglist,
 							 GError		**error);
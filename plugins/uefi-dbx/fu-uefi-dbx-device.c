@@ -77,7 +77,8 @@ fu_uefi_dbx_prepare_firmware (FuDevice *device,
 {
 	g_autoptr(FuFirmware) siglist = fu_efi_signature_list_new ();
 
-	/* parse dbx */
+	/* parse dbx, which is only used for lookups */
+	fu_efi_signature_list_set_checksums_only (FU_EFI_SIGNATURE_LIST (siglist), TRUE);
 	if (!fu_firmware_parse (siglist, fw, flags, error))
 		return NULL;
 
@@ -7,6 +7,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "fu-chunk.h"
 
 #include "fu-vli-device.h"
@@ -252,28 +254,178 @@ fu_vli_device_spi_erase_sector (FuVliDevice *self, guint32 addr, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	FuVliDevice		*self;
+	guint8			*buf;
+	gsize			 bufsz;
+	guint32			 address;
+	gsize			 offset_submitted;
+	gsize			 done_sz;
+	guint			 in_flight;
+	GCancellable		*cancellable;
+	GMainLoop		*loop;
+	GError			*error;
+} FuVliDeviceReadHelper;
+
+typedef struct {
+	FuVliDeviceReadHelper	*helper;
+	gsize			 offset;
+	gsize			 sz;
+} FuVliDeviceReadItem;
+
+static void fu_vli_device_spi_read_submit (FuVliDeviceReadHelper *helper);
+
+static void
+fu_vli_device_spi_read_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuVliDeviceReadItem *item = (FuVliDeviceReadItem *) user_data;
+	FuVliDeviceReadHelper *helper = item->helper;
+	gssize actual;
+	g_autoptr(GError) error_local = NULL;
+
+	actual = g_usb_device_control_transfer_finish (G_USB_DEVICE (source),
+						       res, &error_local);
+	helper->in_flight--;
+
+	/* only the first failure is interesting, the others were cancelled */
+	if (actual < 0) {
+		if (helper->error == NULL) {
+			g_propagate_prefixed_error (&helper->error,
+						    g_steal_pointer (&error_local),
+						    "SPI data read failed @0x%x: ",
+						    (guint) (helper->address + item->offset));
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else if ((gsize) actual != item->sz) {
+		if (helper->error == NULL) {
+			g_set_error (&helper->error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_PARTIAL_INPUT,
+				     "SPI data read incomplete @0x%x, "
+				     "got %" G_GSSIZE_FORMAT "/%" G_GSIZE_FORMAT " bytes",
+				     (guint) (helper->address + item->offset),
+				     actual, item->sz);
+			g_cancellable_cancel (helper->cancellable);
+		}
+	} else {
+		helper->done_sz += item->sz;
+		fu_device_set_progress_full (FU_DEVICE (helper->self),
+					     helper->done_sz, helper->bufsz);
+	}
+	g_free (item);
+
+	/* keep the pipeline full */
+	fu_vli_device_spi_read_submit (helper);
+	if (helper->in_flight == 0)
+		g_main_loop_quit (helper->loop);
+}
+
+static void
+fu_vli_device_spi_read_submit (FuVliDeviceReadHelper *helper)
+{
+	FuVliDeviceClass *klass = FU_VLI_DEVICE_GET_CLASS (helper->self);
+	GUsbDevice *usb_device = fu_usb_device_get_dev (FU_USB_DEVICE (helper->self));
+
+	while (helper->error == NULL &&
+	       helper->in_flight < FU_VLI_DEVICE_READ_IN_FLIGHT &&
+	       helper->offset_submitted < helper->bufsz) {
+		FuVliDeviceReadItem *item;
+		guint8 request = 0x0;
+		guint16 value = 0x0;
+		guint16 index = 0x0;
+		guint32 addr = helper->address + helper->offset_submitted;
+
+		if (!klass->spi_read_setup (helper->self, addr,
+					    &request, &value, &index,
+					    &helper->error)) {
+			g_prefix_error (&helper->error,
+					"SPI data read failed @0x%x: ", addr);
+			g_cancellable_cancel (helper->cancellable);
+			break;
+		}
+		item = g_new0 (FuVliDeviceReadItem, 1);
+		item->helper = helper;
+		item->offset = helper->offset_submitted;
+		item->sz = MIN (helper->bufsz - item->offset, FU_VLI_DEVICE_TXSIZE);
+		helper->offset_submitted += item->sz;
+		helper->in_flight++;
+		g_usb_device_control_transfer_async (usb_device,
+						     G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
+						     G_USB_DEVICE_REQUEST_TYPE_VENDOR,
+						     G_USB_DEVICE_RECIPIENT_DEVICE,
+						     request, value, index,
+						     helper->buf + item->offset,
+						     item->sz,
+						     FU_VLI_DEVICE_TIMEOUT,
+						     helper->cancellable,
+						     fu_vli_device_spi_read_cb,
+						     item);
+	}
+}
+
+/* keep several control transfers queued so the device never waits for the
+ * host to parse one block before the next is requested */
+static gboolean
+fu_vli_device_spi_read_pipelined (FuVliDevice *self, guint32 address,
+				  guint8 *buf, gsize bufsz, GError **error)
+{
+	g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+	g_autoptr(GMainContext) context = g_main_context_new ();
+	g_autoptr(GMainLoop) loop = g_main_loop_new (context, FALSE);
+	FuVliDeviceReadHelper helper = {
+		.self		= self,
+		.buf		= buf,
+		.bufsz		= bufsz,
+		.address	= address,
+		.cancellable	= cancellable,
+		.loop		= loop,
+	};
+
+	/* the completions are dispatched from this private context */
+	g_main_context_push_thread_default (context);
+	fu_vli_device_spi_read_submit (&helper);
+	if (helper.in_flight > 0)
+		g_main_loop_run (loop);
+	g_main_context_pop_thread_default (context);
+	if (helper.error != NULL) {
+		g_propagate_error (error, helper.error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 GBytes *
 fu_vli_device_spi_read (FuVliDevice *self, guint32 address, gsize bufsz, GError **error)
 {
+	FuVliDeviceClass *klass = FU_VLI_DEVICE_GET_CLASS (self);
+	FuChunkIter iter;
+	guint32 length;
 	g_autofree guint8 *buf = g_malloc0 (bufsz);
-	g_autoptr(GPtrArray) chunks = NULL;
+
+	/* the device can queue reads */
+	if (klass->spi_read_setup != NULL) {
+		if (!fu_vli_device_spi_read_pipelined (self, address, buf, bufsz, error))
+			return NULL;
+		return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
+	}
 
 	/* get data from hardware */
-	chunks = fu_chunk_array_mutable_new (buf, bufsz, address, 0x0, FU_VLI_DEVICE_TXSIZE);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
+	fu_chunk_iter_init (&iter, buf, bufsz, address, 0x0, FU_VLI_DEVICE_TXSIZE);
+	length = fu_chunk_iter_get_length (&iter);
+	while (fu_chunk_iter_next (&iter)) {
 		if (!fu_vli_device_spi_read_block (self,
-						  fu_chunk_get_address (chk),
-						  fu_chunk_get_data_out (chk),
-						  fu_chunk_get_data_sz (chk),
+						  fu_chunk_iter_get_address (&iter),
+						  buf + fu_chunk_iter_get_offset (&iter),
+						  fu_chunk_iter_get_data_sz (&iter),
 						  error)) {
 			g_prefix_error (error,
 					"SPI data read failed @0x%x: ",
-					fu_chunk_get_address (chk));
+					fu_chunk_iter_get_address (&iter));
 			return NULL;
 		}
 		fu_device_set_progress_full (FU_DEVICE (self),
-					     (gsize) i, (gsize) chunks->len);
+					     (gsize) fu_chunk_iter_get_idx (&iter),
+					     (gsize) length);
 	}
 	return g_bytes_new_take (g_steal_pointer (&buf), bufsz);
 }
@@ -360,6 +512,104 @@ fu_vli_device_spi_write (FuVliDevice *self,
 	return TRUE;
 }
 
+/* only erase and program the sectors that differ from what is on the flash,
+ * writing the sector holding the CRC block last like fu_vli_device_spi_write() */
+gboolean
+fu_vli_device_spi_write_sectors (FuVliDevice *self,
+				 guint32 address,
+				 const guint8 *buf,
+				 gsize bufsz,
+				 GError **error)
+{
+	FuChunkIter iter;
+	g_autoptr(GPtrArray) chunks = NULL;
+	g_autoptr(GPtrArray) dirty = g_ptr_array_new ();
+
+	/* find the sectors that need changing */
+	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_VERIFY);
+	chunks = fu_chunk_array_new (buf, bufsz, address, 0x0, FU_VLI_DEVICE_SECTOR_SIZE);
+	for (guint i = 0; i < chunks->len; i++) {
+		FuChunk *chk = g_ptr_array_index (chunks, i);
+		g_autoptr(GBytes) blob = NULL;
+		blob = fu_vli_device_spi_read (self,
+					       fu_chunk_get_address (chk),
+					       fu_chunk_get_data_sz (chk),
+					       error);
+		if (blob == NULL)
+			return FALSE;
+		if (memcmp (g_bytes_get_data (blob, NULL),
+			    fu_chunk_get_data (chk),
+			    fu_chunk_get_data_sz (chk)) != 0)
+			g_ptr_array_add (dirty, chk);
+	}
+	g_debug ("%u of %u sectors changed @0x%x",
+		 dirty->len, chunks->len, address);
+	if (dirty->len == 0)
+		return TRUE;
+
+	/* invalidate the image before anything else is changed */
+	if (g_ptr_array_index (dirty, 0) == g_ptr_array_index (chunks, 0)) {
+		FuChunk *chk = g_ptr_array_index (chunks, 0);
+		if (!fu_vli_device_spi_erase_sector (self, fu_chunk_get_address (chk), error)) {
+			g_prefix_error (error, "failed to erase CRC sector: ");
+			return FALSE;
+		}
+	}
+
+	/* erase and write everything else */
+	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_WRITE);
+	for (guint i = 0; i < dirty->len; i++) {
+		FuChunk *chk = g_ptr_array_index (dirty, i);
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(GPtrArray) runs = NULL;
+		if (chk == g_ptr_array_index (chunks, 0))
+			continue;
+		if (!fu_vli_device_spi_erase_sector (self, fu_chunk_get_address (chk), error)) {
+			g_prefix_error (error, "failed to erase sector @0x%x: ",
+					fu_chunk_get_address (chk));
+			return FALSE;
+		}
+
+		/* the sector is now all 0xff, so only program the blocks with data */
+		blob = g_bytes_new_static (fu_chunk_get_data (chk), fu_chunk_get_data_sz (chk));
+		runs = fu_common_bytes_find_runs (blob, FU_VLI_DEVICE_TXSIZE, 0xff, FALSE);
+		for (guint j = 0; j < runs->len; j++) {
+			FuChunk *run = g_ptr_array_index (runs, j);
+			fu_chunk_iter_init (&iter,
+					    fu_chunk_get_data (run),
+					    fu_chunk_get_data_sz (run),
+					    fu_chunk_get_address (chk) +
+					    fu_chunk_get_address (run),
+					    0x0, FU_VLI_DEVICE_TXSIZE);
+			while (fu_chunk_iter_next (&iter)) {
+				if (!fu_vli_device_spi_write_block (self,
+								    fu_chunk_iter_get_address (&iter),
+								    fu_chunk_iter_get_data (&iter),
+								    fu_chunk_iter_get_data_sz (&iter),
+								    error)) {
+					g_prefix_error (error, "failed to write block @0x%x: ",
+							fu_chunk_iter_get_address (&iter));
+					return FALSE;
+				}
+			}
+		}
+		fu_device_set_progress_full (FU_DEVICE (self), (gsize) i, (gsize) dirty->len);
+	}
+
+	/* the CRC block is written last */
+	if (g_ptr_array_index (dirty, 0) == g_ptr_array_index (chunks, 0)) {
+		FuChunk *chk = g_ptr_array_index (chunks, 0);
+		if (!fu_vli_device_spi_write (self,
+					      fu_chunk_get_address (chk),
+					      fu_chunk_get_data (chk),
+					      fu_chunk_get_data_sz (chk),
+					      error))
+			return FALSE;
+	}
+	fu_device_set_progress (FU_DEVICE (self), 100);
+	return TRUE;
+}
+
 gboolean
 fu_vli_device_spi_erase_all (FuVliDevice *self, GError **error)
 {
@@ -399,22 +649,26 @@ fu_vli_device_spi_erase_all (FuVliDevice *self, GError **error)
 gboolean
 fu_vli_device_spi_erase (FuVliDevice *self, guint32 addr, gsize sz, GError **error)
 {
-	g_autoptr(GPtrArray) chunks = fu_chunk_array_new (NULL, sz, addr, 0x0, 0x1000);
+	FuChunkIter iter;
+	guint32 length;
+
 	g_debug ("erasing 0x%x bytes @0x%x", (guint) sz, addr);
-	for (guint i = 0; i < chunks->len; i++) {
-		FuChunk *chk = g_ptr_array_index (chunks, i);
+	fu_chunk_iter_init (&iter, NULL, sz, addr, 0x0, FU_VLI_DEVICE_SECTOR_SIZE);
+	length = fu_chunk_iter_get_length (&iter);
+	while (fu_chunk_iter_next (&iter)) {
 		if (g_getenv ("FWUPD_VLI_USBHUB_VERBOSE") != NULL)
-			g_debug ("erasing @0x%x", fu_chunk_get_address (chk));
+			g_debug ("erasing @0x%x", fu_chunk_iter_get_address (&iter));
 		if (!fu_vli_device_spi_erase_sector (FU_VLI_DEVICE (self),
-						     fu_chunk_get_address (chk),
+						     fu_chunk_iter_get_address (&iter),
 						     error)) {
 			g_prefix_error (error,
 					"failed to erase FW sector @0x%x: ",
-					fu_chunk_get_address (chk));
+					fu_chunk_iter_get_address (&iter));
 			return FALSE;
 		}
 		fu_device_set_progress_full (FU_DEVICE (self),
-					     (gsize) i, (gsize) chunks->len);
+					     (gsize) fu_chunk_iter_get_idx (&iter),
+					     (gsize) length);
 	}
 	return TRUE;
 }
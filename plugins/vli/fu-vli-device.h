@@ -44,6 +44,12 @@ struct _FuVliDeviceClass
 	gboolean		 (*spi_write_status)	(FuVliDevice	*self,
 							 guint8		 status,
 							 GError		**error);
+	gboolean		 (*spi_read_setup)	(FuVliDevice	*self,
+							 guint32	 addr,
+							 guint8		*request,
+							 guint16	*value,
+							 guint16	*index,
+							 GError		**error);
 };
 
 typedef enum {
@@ -60,6 +66,8 @@ typedef enum {
 
 #define FU_VLI_DEVICE_TIMEOUT			3000	/* ms */
 #define FU_VLI_DEVICE_TXSIZE			0x20	/* bytes */
+#define FU_VLI_DEVICE_READ_IN_FLIGHT		4	/* transfers */
+#define FU_VLI_DEVICE_SECTOR_SIZE		0x1000	/* bytes */
 
 void		 fu_vli_device_set_kind			(FuVliDevice	*self,
 							 FuVliDeviceKind device_kind);
@@ -99,3 +107,8 @@ gboolean	 fu_vli_device_spi_write		(FuVliDevice	*self,
 							 const guint8	*buf,
 							 gsize		 bufsz,
 							 GError		**error);
+gboolean	 fu_vli_device_spi_write_sectors	(FuVliDevice	*self,
+							 guint32	 address,
+							 const guint8	*buf,
+							 gsize		 bufsz,
+							 GError		**error);
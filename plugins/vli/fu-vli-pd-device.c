@@ -90,21 +90,33 @@ fu_vli_pd_device_spi_read_status (FuVliDevice *self, guint8 *status, GError **er
 }
 
 static gboolean
-fu_vli_pd_device_spi_read_data (FuVliDevice *self, guint32 addr, guint8 *buf, gsize bufsz, GError **error)
+fu_vli_pd_device_spi_read_setup (FuVliDevice *self, guint32 addr,
+			guint8 *request, guint16 *value, guint16 *index,
+			GError **error)
 {
 	guint8 spi_cmd = 0x0;
-	guint16 value;
-	guint16 index;
 	if (!fu_vli_device_get_spi_cmd (self, FU_VLI_DEVICE_SPI_REQ_READ_DATA,
 					&spi_cmd, error))
 		return FALSE;
-	value = ((addr << 8) & 0xff00) | spi_cmd;
-	index = addr >> 8;
+	*request = 0xc4;
+	*value = ((addr << 8) & 0xff00) | spi_cmd;
+	*index = addr >> 8;
+	return TRUE;
+}
+
+static gboolean
+fu_vli_pd_device_spi_read_data (FuVliDevice *self, guint32 addr, guint8 *buf, gsize bufsz, GError **error)
+{
+	guint8 request = 0x0;
+	guint16 value = 0x0;
+	guint16 index = 0x0;
+	if (!fu_vli_pd_device_spi_read_setup (self, addr, &request, &value, &index, error))
+		return FALSE;
 	return g_usb_device_control_transfer (fu_usb_device_get_dev (FU_USB_DEVICE (self)),
 					      G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
 					      G_USB_DEVICE_REQUEST_TYPE_VENDOR,
 					      G_USB_DEVICE_RECIPIENT_DEVICE,
-					      0xc4, value, index,
+					      request, value, index,
 					      buf, bufsz, NULL,
 					      FU_VLI_DEVICE_TIMEOUT,
 					      NULL, error);
@@ -333,7 +345,7 @@ fu_vli_pd_device_prepare_firmware (FuDevice *device,
 {
 	FuVliPdDevice *self = FU_VLI_PD_DEVICE (device);
 	FuVliDeviceKind device_kind;
-	g_autoptr(FuFirmware) firmware = fu_vli_pd_firmware_new ();
+	g_autoptr(FuFirmware) firmware = NULL;
 
 	/* check size */
 	if (g_bytes_get_size (fw) > fu_device_get_firmware_size_max (device)) {
@@ -347,7 +359,8 @@ fu_vli_pd_device_prepare_firmware (FuDevice *device,
 	}
 
 	/* check is compatible with firmware */
-	if (!fu_firmware_parse (firmware, fw, flags, error))
+	firmware = fu_device_parse_firmware_cached (device, FU_TYPE_VLI_PD_FIRMWARE, fw, flags, error);
+	if (firmware == NULL)
 		return NULL;
 	device_kind = fu_vli_pd_firmware_get_kind (FU_VLI_PD_FIRMWARE (firmware));
 	if (fu_vli_device_get_kind (FU_VLI_DEVICE (self)) != device_kind) {
@@ -705,6 +718,7 @@ fu_vli_pd_device_class_init (FuVliPdDeviceClass *klass)
 	klass_vli_device->spi_chip_erase = fu_vli_pd_device_spi_chip_erase;
 	klass_vli_device->spi_sector_erase = fu_vli_pd_device_spi_sector_erase;
 	klass_vli_device->spi_read_data = fu_vli_pd_device_spi_read_data;
+	klass_vli_device->spi_read_setup = fu_vli_pd_device_spi_read_setup;
 	klass_vli_device->spi_read_status = fu_vli_pd_device_spi_read_status;
 	klass_vli_device->spi_write_data = fu_vli_pd_device_spi_write_data;
 	klass_vli_device->spi_write_enable = fu_vli_pd_device_spi_write_enable;
@@ -116,21 +116,33 @@ fu_vli_usbhub_device_spi_read_status (FuVliDevice *self, guint8 *status, GError
 }
 
 static gboolean
-fu_vli_usbhub_device_spi_read_data (FuVliDevice *self, guint32 addr, guint8 *buf, gsize bufsz, GError **error)
+fu_vli_usbhub_device_spi_read_setup (FuVliDevice *self, guint32 addr,
+			guint8 *request, guint16 *value, guint16 *index,
+			GError **error)
 {
 	guint8 spi_cmd = 0x0;
-	guint16 value;
-	guint16 index;
 	if (!fu_vli_device_get_spi_cmd (self, FU_VLI_DEVICE_SPI_REQ_READ_DATA,
 					&spi_cmd, error))
 		return FALSE;
-	value = ((addr >> 8) & 0xff00) | spi_cmd;
-	index = ((addr << 8) & 0xff00) | ((addr >> 8) & 0x00ff);
+	*request = 0xc4;
+	*value = ((addr >> 8) & 0xff00) | spi_cmd;
+	*index = ((addr << 8) & 0xff00) | ((addr >> 8) & 0x00ff);
+	return TRUE;
+}
+
+static gboolean
+fu_vli_usbhub_device_spi_read_data (FuVliDevice *self, guint32 addr, guint8 *buf, gsize bufsz, GError **error)
+{
+	guint8 request = 0x0;
+	guint16 value = 0x0;
+	guint16 index = 0x0;
+	if (!fu_vli_usbhub_device_spi_read_setup (self, addr, &request, &value, &index, error))
+		return FALSE;
 	return g_usb_device_control_transfer (fu_usb_device_get_dev (FU_USB_DEVICE (self)),
 					      G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST,
 					      G_USB_DEVICE_REQUEST_TYPE_VENDOR,
 					      G_USB_DEVICE_RECIPIENT_DEVICE,
-					      0xc4, value, index,
+					      request, value, index,
 					      buf, bufsz, NULL,
 					      FU_VLI_DEVICE_TIMEOUT,
 					      NULL, error);
@@ -672,10 +684,11 @@ fu_vli_usbhub_device_prepare_firmware (FuDevice *device,
 	FuVliUsbhubDevice *self = FU_VLI_USBHUB_DEVICE (device);
 	FuVliDeviceKind device_kind;
 	guint16 device_id;
-	g_autoptr(FuFirmware) firmware = fu_vli_usbhub_firmware_new ();
+	g_autoptr(FuFirmware) firmware = NULL;
 
 	/* check is compatible with firmware */
-	if (!fu_firmware_parse (firmware, fw, flags, error))
+	firmware = fu_device_parse_firmware_cached (device, FU_TYPE_VLI_USBHUB_FIRMWARE, fw, flags, error);
+	if (firmware == NULL)
 		return NULL;
 	device_kind = fu_vli_usbhub_firmware_get_device_kind (FU_VLI_USBHUB_FIRMWARE (firmware));
 	if (fu_vli_device_get_kind (FU_VLI_DEVICE (self)) != device_kind) {
@@ -884,18 +897,12 @@ fu_vli_usbhub_device_update_v2 (FuVliUsbhubDevice *self, FuFirmware *firmware, G
 	g_debug ("FW2 @0x%x (length 0x%x, offset 0x%x)",
 		 hd2_fw_addr, hd2_fw_sz, hd2_fw_offset);
 
-	/* make space */
-	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_ERASE);
-	if (!fu_vli_device_spi_erase (FU_VLI_DEVICE (self), hd2_fw_addr, hd2_fw_sz, error))
-		return FALSE;
-
-	/* perform the actual write */
-	fu_device_set_status (FU_DEVICE (self), FWUPD_STATUS_DEVICE_WRITE);
-	if (!fu_vli_device_spi_write (FU_VLI_DEVICE (self),
-				      hd2_fw_addr,
-				      buf_fw + hd2_fw_offset,
-				      hd2_fw_sz,
-				      error)) {
+	/* perform the actual write, only changing the sectors that differ */
+	if (!fu_vli_device_spi_write_sectors (FU_VLI_DEVICE (self),
+					      hd2_fw_addr,
+					      buf_fw + hd2_fw_offset,
+					      hd2_fw_sz,
+					      error)) {
 		g_prefix_error (error, "failed to write payload: ");
 		return FALSE;
 	}
@@ -994,6 +1001,7 @@ fu_vli_usbhub_device_class_init (FuVliUsbhubDeviceClass *klass)
 	klass_vli_device->spi_chip_erase = fu_vli_usbhub_device_spi_chip_erase;
 	klass_vli_device->spi_sector_erase = fu_vli_usbhub_device_spi_sector_erase;
 	klass_vli_device->spi_read_data = fu_vli_usbhub_device_spi_read_data;
+	klass_vli_device->spi_read_setup = fu_vli_usbhub_device_spi_read_setup;
 	klass_vli_device->spi_read_status = fu_vli_usbhub_device_spi_read_status;
 	klass_vli_device->spi_write_data = fu_vli_usbhub_device_spi_write_data;
 	klass_vli_device->spi_write_enable = fu_vli_usbhub_device_spi_write_enable;
@@ -146,10 +146,11 @@ fu_vli_usbhub_pd_device_prepare_firmware (FuDevice *device,
 {
 	FuVliUsbhubPdDevice *self = FU_VLI_USBHUB_PD_DEVICE (device);
 	FuVliDeviceKind device_kind;
-	g_autoptr(FuFirmware) firmware = fu_vli_pd_firmware_new ();
+	g_autoptr(FuFirmware) firmware = NULL;
 
 	/* check is compatible with firmware */
-	if (!fu_firmware_parse (firmware, fw, flags, error))
+	firmware = fu_device_parse_firmware_cached (device, FU_TYPE_VLI_PD_FIRMWARE, fw, flags, error);
+	if (firmware == NULL)
 		return NULL;
 	device_kind = fu_vli_pd_firmware_get_kind (FU_VLI_PD_FIRMWARE (firmware));
 	if (self->device_kind != device_kind) {
@@ -210,19 +211,12 @@ fu_vli_usbhub_pd_device_write_firmware (FuDevice *device,
 	if (locker == NULL)
 		return FALSE;
 
-	/* erase */
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
-	buf = g_bytes_get_data (fw, &bufsz);
-	if (!fu_vli_device_spi_erase (FU_VLI_DEVICE (parent),
-				      fu_vli_common_device_kind_get_offset (self->device_kind),
-				      bufsz, error))
-		return FALSE;
-
-	/* write */
+	/* write only the sectors that differ */
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
-	if (!fu_vli_device_spi_write (FU_VLI_DEVICE (parent),
-				      fu_vli_common_device_kind_get_offset (self->device_kind),
-				      buf, bufsz, error))
+	buf = g_bytes_get_data (fw, &bufsz);
+	if (!fu_vli_device_spi_write_sectors (FU_VLI_DEVICE (parent),
+					      fu_vli_common_device_kind_get_offset (self->device_kind),
+					      buf, bufsz, error))
 		return FALSE;
 
 	/* success */
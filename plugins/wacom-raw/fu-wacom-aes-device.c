@@ -199,9 +199,9 @@ fu_wacom_aes_device_write_block (FuWacomAesDevice *self,
 	}
 	memcpy (&req.data, data, datasz);
 
-	/* write */
-	if (!fu_wacom_device_cmd (FU_WACOM_DEVICE (self), &req, &rsp, 1000,
-				  FU_WACOM_DEVICE_CMD_FLAG_NONE, error)) {
+	/* write, polling if the block is still being programmed */
+	if (!fu_wacom_device_cmd (FU_WACOM_DEVICE (self), &req, &rsp, 250,
+				  FU_WACOM_DEVICE_CMD_FLAG_POLL_ON_WAITING, error)) {
 		g_prefix_error (error, "failed to write block %u: ", idx);
 		return FALSE;
 	}
@@ -222,6 +222,8 @@ fu_wacom_aes_device_write_firmware (FuDevice *device, GPtrArray *chunks, GError
 	fu_device_set_status (device, FWUPD_STATUS_DEVICE_WRITE);
 	for (guint i = 0; i < chunks->len; i++) {
 		FuChunk *chk = g_ptr_array_index (chunks, i);
+		if (fu_wacom_common_block_is_empty (fu_chunk_get_data (chk), fu_chunk_get_data_sz (chk)))
+			continue;
 		if (!fu_wacom_aes_device_write_block (self,
 						      fu_chunk_get_idx (chk),
 						      fu_chunk_get_address (chk),
@@ -456,6 +456,7 @@ fu_wac_device_write_firmware (FuDevice *device,
 	gsize blocks_done = 0;
 	gsize blocks_total = 0;
 	g_autofree guint32 *csum_local = NULL;
+	g_autofree gboolean *unchanged = NULL;
 	g_autoptr(FuFirmwareImage) img = NULL;
 	g_autoptr(GHashTable) fd_blobs = NULL;
 
@@ -485,16 +486,6 @@ fu_wac_device_write_firmware (FuDevice *device,
 	if (!fu_wac_device_ensure_checksums (self, error))
 		return FALSE;
 
-	/* clear all checksums of pages */
-	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
-	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
-		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
-		if (fu_wav_device_flash_descriptor_is_wp (fd))
-			continue;
-		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
-			return FALSE;
-	}
-
 	/* get the blobs for each chunk */
 	fd_blobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 					  NULL, (GDestroyNotify) g_bytes_unref);
@@ -515,6 +506,37 @@ fu_wac_device_write_firmware (FuDevice *device,
 		g_hash_table_insert (fd_blobs, fd, blob_block);
 	}
 
+	/* blocks where the device already has the same checksum do not need
+	 * writing, although they are still verified */
+	unchanged = g_new0 (gboolean, self->flash_descriptors->len);
+	if ((flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
+		for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+			FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+			GBytes *blob_block = g_hash_table_lookup (fd_blobs, fd);
+			if (blob_block == NULL || i >= self->checksums->len)
+				continue;
+			if (fu_common_bytes_is_empty (blob_block))
+				continue;
+			if (g_array_index (self->checksums, guint32, i) ==
+			    fu_wac_calculate_checksum32le_bytes (blob_block)) {
+				g_debug ("block %02u unchanged, skipping", i);
+				unchanged[i] = TRUE;
+			}
+		}
+	}
+
+	/* clear all checksums of pages */
+	fu_device_set_status (device, FWUPD_STATUS_DEVICE_ERASE);
+	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		if (fu_wav_device_flash_descriptor_is_wp (fd))
+			continue;
+		if (unchanged[i])
+			continue;
+		if (!fu_wac_device_set_checksum_of_block (self, i, 0x0, error))
+			return FALSE;
+	}
+
 	/* checksum actions post-write */
 	blocks_total = g_hash_table_size (fd_blobs) + 2;
 
@@ -542,6 +564,13 @@ fu_wac_device_write_firmware (FuDevice *device,
 			continue;
 		}
 
+		/* already has the right checksum set */
+		if (unchanged[i]) {
+			csum_local[i] = g_array_index (self->checksums, guint32, i);
+			fu_device_set_progress_full (device, blocks_done++, blocks_total);
+			continue;
+		}
+
 		/* erase entire block */
 		if (!fu_wac_device_erase_block (self, i, error))
 			return FALSE;
@@ -571,8 +600,15 @@ fu_wac_device_write_firmware (FuDevice *device,
 		fu_device_set_progress_full (device, blocks_done++, blocks_total);
 	}
 
-	/* calculate CRC inside device */
+	/* calculate CRC inside device, only for the blocks verified below */
 	for (guint16 i = 0; i < self->flash_descriptors->len; i++) {
+		FuWacFlashDescriptor *fd = g_ptr_array_index (self->flash_descriptors, i);
+		GBytes *blob_block;
+		if (fu_wav_device_flash_descriptor_is_wp (fd))
+			continue;
+		blob_block = g_hash_table_lookup (fd_blobs, fd);
+		if (blob_block == NULL || fu_common_bytes_is_empty (blob_block))
+			continue;
 		if (!fu_wac_device_calculate_checksum_of_block (self, i, error))
 			return FALSE;
 	}
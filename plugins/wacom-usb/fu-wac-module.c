@@ -12,6 +12,8 @@
 #include "fu-wac-common.h"
 #include "fu-wac-device.h"
 
+#define FU_WAC_MODULE_TIMEOUT				5000	/* ms */
+
 #define FU_WAC_MODULE_STATUS_OK				0
 #define FU_WAC_MODULE_STATUS_BUSY			1
 #define FU_WAC_MODULE_STATUS_ERR_CRC			2
@@ -121,18 +123,22 @@ fu_wac_module_to_string (FuDevice *device, guint idt, GString *str)
 }
 
 static gboolean
-fu_wac_module_refresh (FuWacModule *self, GError **error)
+fu_wac_module_status_cb (FuHidDevice *device,
+			 guint8 *buf,
+			 gsize bufsz,
+			 gpointer user_data,
+			 GError **error)
 {
-	FuWacDevice *parent_device = FU_WAC_DEVICE (fu_device_get_parent (FU_DEVICE (self)));
+	FuWacModule *self = FU_WAC_MODULE (user_data);
 	FuWacModulePrivate *priv = GET_PRIVATE (self);
-	guint8 buf[] = { [0] = FU_WAC_REPORT_ID_MODULE,
-			 [1 ... FU_WAC_PACKET_LEN - 1] = 0xff };
 
-	/* get from hardware */
-	if (!fu_wac_device_get_feature_report (parent_device, buf, sizeof(buf),
-					       FU_HID_DEVICE_FLAG_ALLOW_TRUNC,
-					       error)) {
-		g_prefix_error (error, "failed to refresh status: ");
+	/* check packet */
+	if (buf[0] != FU_WAC_REPORT_ID_MODULE) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "command response was %i expected %i",
+			     buf[0], FU_WAC_REPORT_ID_MODULE);
 		return FALSE;
 	}
 
@@ -158,6 +164,23 @@ fu_wac_module_refresh (FuWacModule *self, GError **error)
 		}
 	}
 
+	/* poll again */
+	if (priv->status == FU_WAC_MODULE_STATUS_BUSY) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_BUSY,
+				     "status is busy");
+		return FALSE;
+	}
+	if (priv->status != FU_WAC_MODULE_STATUS_OK) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "Failed to SetFeature: %s",
+			     fu_wac_module_status_to_string (priv->status));
+		return FALSE;
+	}
+
 	/* success */
 	return TRUE;
 }
@@ -172,7 +195,7 @@ fu_wac_module_set_feature (FuWacModule *self,
 	FuWacModulePrivate *priv = GET_PRIVATE (self);
 	const guint8 *data;
 	gsize len = 0;
-	guint busy_poll_loops = 100; /* 1s */
+	guint poll_timeout = 1000; /* ms */
 	guint8 buf[] = { [0] = FU_WAC_REPORT_ID_MODULE,
 			 [1] = priv->fw_type,
 			 [2] = command,
@@ -219,34 +242,18 @@ fu_wac_module_set_feature (FuWacModule *self,
 	/* special case StartProgram, as it can take much longer as it is
 	 * erasing the blocks (15s) */
 	if (command == FU_WAC_MODULE_COMMAND_START)
-		busy_poll_loops *= 15;
+		poll_timeout *= 15;
 
 	/* wait for hardware */
-	for (guint i = 0; i < busy_poll_loops; i++) {
-		if (!fu_wac_module_refresh (self, error))
-			return FALSE;
-		if (priv->status == FU_WAC_MODULE_STATUS_BUSY) {
-			g_usleep (10000); /* 10ms */
-			continue;
-		}
-		if (priv->status == FU_WAC_MODULE_STATUS_OK)
-			break;
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INTERNAL,
-			     "Failed to SetFeature: %s",
-			     fu_wac_module_status_to_string (priv->status));
-		return FALSE;
-	}
-
-	/* too many retries */
-	if (priv->status != FU_WAC_MODULE_STATUS_OK) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INTERNAL,
-			     "Timed out after %u loops with status %s",
-			     busy_poll_loops,
-			     fu_wac_module_status_to_string (priv->status));
+	if (!fu_hid_device_poll_report (FU_HID_DEVICE (parent_device),
+					FU_WAC_REPORT_ID_MODULE,
+					buf, sizeof(buf),
+					FU_WAC_MODULE_TIMEOUT,
+					FU_HID_DEVICE_FLAG_ALLOW_TRUNC |
+					FU_HID_DEVICE_FLAG_IS_FEATURE,
+					fu_wac_module_status_cb, self,
+					poll_timeout, error)) {
+		g_prefix_error (error, "failed to refresh status: ");
 		return FALSE;
 	}
 
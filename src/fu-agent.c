@@ -14,6 +14,7 @@
 #include <glib-unix.h>
 #endif
 #include <locale.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
@@ -30,18 +31,53 @@ struct FuUtilPrivate {
 	FwupdInstallFlags	 flags;
 };
 
+/* the array elements are printed as they are built, so the whole tree is
+ * never held in memory and the first device is output as soon as possible */
+static void
+fu_util_print_json_array_start (const gchar *member_name)
+{
+	g_print ("{\n  \"%s\" : [", member_name);
+}
+
+static void
+fu_util_print_json_array_element (JsonBuilder *builder, gboolean first)
+{
+	g_autofree gchar *data = NULL;
+	g_auto(GStrv) lines = NULL;
+	g_autoptr(JsonGenerator) json_generator = json_generator_new ();
+	g_autoptr(JsonNode) json_root = json_builder_get_root (builder);
+
+	/* indent to match the depth inside the wrapper object */
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	data = json_generator_to_data (json_generator, NULL);
+	lines = g_strsplit (data, "\n", -1);
+	g_print ("%s\n", first ? "" : ",");
+	for (guint i = 0; lines[i] != NULL; i++)
+		g_print ("%s    %s", i > 0 ? "\n" : "", lines[i]);
+	fflush (stdout);
+	json_builder_reset (builder);
+}
+
+static void
+fu_util_print_json_array_end (void)
+{
+	g_print ("\n  ]\n}\n");
+}
+
 static gboolean
-fu_util_add_devices_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
+fu_util_print_devices_json (FuUtilPrivate *priv, GError **error)
 {
+	gboolean first = TRUE;
 	g_autoptr(GPtrArray) devs = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
 
 	/* get results from daemon */
 	devs = fwupd_client_get_devices (priv->client, priv->cancellable, error);
 	if (devs == NULL)
 		return FALSE;
 
-	json_builder_set_member_name (builder, "Devices");
-	json_builder_begin_array (builder);
+	fu_util_print_json_array_start ("Devices");
 	for (guint i = 0; i < devs->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devs, i);
 		g_autoptr(GPtrArray) rels = NULL;
@@ -62,26 +98,29 @@ fu_util_add_devices_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **er
 			}
 		}
 
-		/* add to builder */
+		/* print now rather than at the end */
 		json_builder_begin_object (builder);
 		fwupd_device_to_json (dev, builder);
 		json_builder_end_object (builder);
+		fu_util_print_json_array_element (builder, first);
+		first = FALSE;
 	}
-	json_builder_end_array (builder);
+	fu_util_print_json_array_end ();
 	return TRUE;
 }
 
 static gboolean
-fu_util_add_updates_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
+fu_util_print_updates_json (FuUtilPrivate *priv, GError **error)
 {
+	gboolean first = TRUE;
 	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
 
 	/* get devices from daemon */
 	devices = fwupd_client_get_devices (priv->client, NULL, error);
 	if (devices == NULL)
 		return FALSE;
-	json_builder_set_member_name (builder, "Devices");
-	json_builder_begin_array (builder);
+	fu_util_print_json_array_start ("Devices");
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devices, i);
 		g_autoptr(GPtrArray) rels = NULL;
@@ -104,19 +143,22 @@ fu_util_add_updates_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **er
 			fwupd_device_add_release (dev, rel);
 		}
 
-		/* add to builder */
+		/* print now rather than at the end */
 		json_builder_begin_object (builder);
 		fwupd_device_to_json (dev, builder);
 		json_builder_end_object (builder);
+		fu_util_print_json_array_element (builder, first);
+		first = FALSE;
 	}
-	json_builder_end_array (builder);
+	fu_util_print_json_array_end ();
 	return TRUE;
 }
 
 static gboolean
-fu_util_add_security_attributes_json (FuUtilPrivate *priv, JsonBuilder *builder, GError **error)
+fu_util_print_security_attributes_json (FuUtilPrivate *priv, GError **error)
 {
 	g_autoptr(GPtrArray) attrs = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
 
 	/* not ready yet */
 	if ((priv->flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
@@ -132,27 +174,21 @@ fu_util_add_security_attributes_json (FuUtilPrivate *priv, JsonBuilder *builder,
 	attrs = fwupd_client_get_host_security_attrs (priv->client, NULL, error);
 	if (attrs == NULL)
 		return FALSE;
-	json_builder_set_member_name (builder, "HostSecurityAttributes");
-	json_builder_begin_array (builder);
+	fu_util_print_json_array_start ("HostSecurityAttributes");
 	for (guint i = 0; i < attrs->len; i++) {
 		FwupdSecurityAttr *attr = g_ptr_array_index (attrs, i);
 		json_builder_begin_object (builder);
 		fwupd_security_attr_to_json (attr, builder);
 		json_builder_end_object (builder);
+		fu_util_print_json_array_element (builder, i == 0);
 	}
-	json_builder_end_array (builder);
+	fu_util_print_json_array_end ();
 	return TRUE;
 }
 
 static gboolean
-fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
+fu_util_check_no_args (gchar **values, GError **error)
 {
-	g_autofree gchar *data = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
-
-	/* check args */
 	if (g_strv_length (values) != 0) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -160,117 +196,31 @@ fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
 				     "Invalid arguments");
 		return FALSE;
 	}
-
-	/* create header */
-	builder = json_builder_new ();
-	json_builder_begin_object (builder);
-	if (!fu_util_add_devices_json (priv, builder, error))
-		return FALSE;
-	json_builder_end_object (builder);
-
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
-		return FALSE;
-	}
-
-	/* just print */
-	g_print ("%s\n", data);
 	return TRUE;
 }
 
 static gboolean
-fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
+fu_util_get_devices (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	g_autofree gchar *data = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
-
-	/* check args */
-	if (g_strv_length (values) != 0) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_ARGS,
-				     "Invalid arguments");
-		return FALSE;
-	}
-
-	/* create header */
-	builder = json_builder_new ();
-	json_builder_begin_object (builder);
-	if (!fu_util_add_updates_json (priv, builder, error))
+	if (!fu_util_check_no_args (values, error))
 		return FALSE;
-	json_builder_end_object (builder);
+	return fu_util_print_devices_json (priv, error);
+}
 
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
+static gboolean
+fu_util_get_updates (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	if (!fu_util_check_no_args (values, error))
 		return FALSE;
-	}
-
-	/* just print */
-	g_print ("%s\n", data);
-	return TRUE;
+	return fu_util_print_updates_json (priv, error);
 }
 
 static gboolean
 fu_util_security (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	g_autofree gchar *data = NULL;
-	g_autoptr(JsonBuilder) builder = NULL;
-	g_autoptr(JsonGenerator) json_generator = NULL;
-	g_autoptr(JsonNode) json_root = NULL;
-
-	/* check args */
-	if (g_strv_length (values) != 0) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INVALID_ARGS,
-				     "Invalid arguments");
-		return FALSE;
-	}
-
-	/* create header */
-	builder = json_builder_new ();
-	json_builder_begin_object (builder);
-	if (!fu_util_add_security_attributes_json (priv, builder, error))
-		return FALSE;
-	json_builder_end_object (builder);
-
-	/* export as a string */
-	json_root = json_builder_get_root (builder);
-	json_generator = json_generator_new ();
-	json_generator_set_pretty (json_generator, TRUE);
-	json_generator_set_root (json_generator, json_root);
-	data = json_generator_to_data (json_generator, NULL);
-	if (data == NULL) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "Failed to convert to JSON string");
+	if (!fu_util_check_no_args (values, error))
 		return FALSE;
-	}
-
-	/* just print */
-	g_print ("%s\n", data);
-	return TRUE;
+	return fu_util_print_security_attributes_json (priv, error);
 }
 
 static void
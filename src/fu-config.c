@@ -23,10 +23,13 @@ static guint signals[SIGNAL_LAST] = { 0 };
 
 static void fu_config_finalize	 (GObject *obj);
 
+#define FU_CONFIG_RELOAD_DELAY			500 /* ms */
+
 struct _FuConfig
 {
 	GObject			 parent_instance;
 	GFileMonitor		*monitor;
+	guint			 reload_id;
 	GPtrArray		*disabled_devices;	/* (element-type utf-8) */
 	GPtrArray		*disabled_plugins;	/* (element-type utf-8) */
 	GPtrArray		*approved_firmware;	/* (element-type utf-8) */
@@ -34,9 +37,21 @@ struct _FuConfig
 	GPtrArray		*uri_schemes;		/* (element-type utf-8) */
 	guint64			 archive_size_max;
 	guint			 idle_timeout;
+	guint			 verify_interval;
+	guint			 history_max_entries;
+	guint			 history_max_age;
 	gchar			*config_file;
 	gboolean		 update_motd;
 	gboolean		 enumerate_all_devices;
+	gboolean		 concurrent_coldplug;
+	gboolean		 concurrent_hotplug;
+	gboolean		 concurrent_install;
+	gboolean		 batch_history_writes;
+	gboolean		 threaded_runners;
+	gboolean		 enable_metrics;
+	gboolean		 enable_peer_socket;
+	gboolean		 low_memory;
+	gboolean		 history_keep_unreported;
 };
 
 G_DEFINE_TYPE (FuConfig, fu_config, G_TYPE_OBJECT)
@@ -53,6 +68,9 @@ fu_config_reload (FuConfig *self, GError **error)
 {
 	guint64 archive_size_max;
 	guint idle_timeout;
+	guint64 verify_interval;
+	guint64 history_max_entries;
+	guint64 history_max_age;
 	g_auto(GStrv) approved_firmware = NULL;
 	g_auto(GStrv) blocked_firmware = NULL;
 	g_auto(GStrv) uri_schemes = NULL;
@@ -62,6 +80,15 @@ fu_config_reload (FuConfig *self, GError **error)
 	g_autoptr(GKeyFile) keyfile = g_key_file_new ();
 	g_autoptr(GError) error_update_motd = NULL;
 	g_autoptr(GError) error_enumerate_all = NULL;
+	g_autoptr(GError) error_concurrent_coldplug = NULL;
+	g_autoptr(GError) error_concurrent_hotplug = NULL;
+	g_autoptr(GError) error_concurrent_install = NULL;
+	g_autoptr(GError) error_batch_history_writes = NULL;
+	g_autoptr(GError) error_threaded_runners = NULL;
+	g_autoptr(GError) error_enable_metrics = NULL;
+	g_autoptr(GError) error_enable_peer_socket = NULL;
+	g_autoptr(GError) error_low_memory = NULL;
+	g_autoptr(GError) error_history_keep_unreported = NULL;
 
 	g_debug ("loading config values from %s", self->config_file);
 	if (!g_key_file_load_from_file (keyfile, self->config_file,
@@ -173,6 +200,34 @@ fu_config_reload (FuConfig *self, GError **error)
 	if (idle_timeout > 0)
 		self->idle_timeout = idle_timeout;
 
+	/* get background verification interval */
+	verify_interval = g_key_file_get_uint64 (keyfile,
+						 "fwupd",
+						 "VerifyInterval",
+						 NULL);
+	self->verify_interval = MIN (verify_interval, G_MAXUINT);
+
+	/* get the history retention policy */
+	history_max_entries = g_key_file_get_uint64 (keyfile,
+						     "fwupd",
+						     "HistoryMaxEntries",
+						     NULL);
+	self->history_max_entries = MIN (history_max_entries, G_MAXUINT);
+	history_max_age = g_key_file_get_uint64 (keyfile,
+						 "fwupd",
+						 "HistoryMaxAge",
+						 NULL);
+	self->history_max_age = MIN (history_max_age, G_MAXUINT);
+	self->history_keep_unreported = g_key_file_get_boolean (keyfile,
+								"fwupd",
+								"HistoryKeepUnreported",
+								&error_history_keep_unreported);
+	if (!self->history_keep_unreported && error_history_keep_unreported != NULL) {
+		g_debug ("failed to read HistoryKeepUnreported key: %s",
+			 error_history_keep_unreported->message);
+		self->history_keep_unreported = TRUE;
+	}
+
 	/* get the domains to run in verbose */
 	domains = g_key_file_get_string (keyfile,
 					 "fwupd",
@@ -202,9 +257,103 @@ fu_config_reload (FuConfig *self, GError **error)
 		self->enumerate_all_devices = TRUE;
 	}
 
+	/* whether to coldplug independent plugins in worker threads */
+	self->concurrent_coldplug = g_key_file_get_boolean (keyfile,
+							    "fwupd",
+							    "ConcurrentColdplug",
+							    &error_concurrent_coldplug);
+	if (!self->concurrent_coldplug && error_concurrent_coldplug != NULL) {
+		g_debug ("failed to read ConcurrentColdplug key: %s",
+			 error_concurrent_coldplug->message);
+	}
+
+	/* whether to set up hotplugged devices in per-plugin worker threads */
+	self->concurrent_hotplug = g_key_file_get_boolean (keyfile,
+							   "fwupd",
+							   "ConcurrentHotplug",
+							   &error_concurrent_hotplug);
+	if (!self->concurrent_hotplug && error_concurrent_hotplug != NULL) {
+		g_debug ("failed to read ConcurrentHotplug key: %s",
+			 error_concurrent_hotplug->message);
+	}
+
+	/* whether to install independent devices at the same time */
+	self->concurrent_install = g_key_file_get_boolean (keyfile,
+							   "fwupd",
+							   "ConcurrentInstall",
+							   &error_concurrent_install);
+	if (!self->concurrent_install && error_concurrent_install != NULL) {
+		g_debug ("failed to read ConcurrentInstall key: %s",
+			 error_concurrent_install->message);
+	}
+
+	/* whether to batch the history database writes */
+	self->batch_history_writes = g_key_file_get_boolean (keyfile,
+							     "fwupd",
+							     "BatchHistoryWrites",
+							     &error_batch_history_writes);
+	if (!self->batch_history_writes && error_batch_history_writes != NULL) {
+		g_debug ("failed to read BatchHistoryWrites key: %s",
+			 error_batch_history_writes->message);
+	}
+
+	/* whether to run slow device actions away from the main thread */
+	self->threaded_runners = g_key_file_get_boolean (keyfile,
+							 "fwupd",
+							 "ThreadedRunners",
+							 &error_threaded_runners);
+	if (!self->threaded_runners && error_threaded_runners != NULL) {
+		g_debug ("failed to read ThreadedRunners key: %s",
+			 error_threaded_runners->message);
+	}
+
+	/* whether to answer GetMetrics */
+	self->enable_metrics = g_key_file_get_boolean (keyfile,
+						       "fwupd",
+						       "EnableMetrics",
+						       &error_enable_metrics);
+	if (!self->enable_metrics && error_enable_metrics != NULL) {
+		g_debug ("failed to read EnableMetrics key: %s",
+			 error_enable_metrics->message);
+	}
+
+	/* whether to also listen on a private socket for local clients */
+	self->enable_peer_socket = g_key_file_get_boolean (keyfile,
+							   "fwupd",
+							   "EnablePeerSocket",
+							   &error_enable_peer_socket);
+	if (!self->enable_peer_socket && error_enable_peer_socket != NULL) {
+		g_debug ("failed to read EnablePeerSocket key: %s",
+			 error_enable_peer_socket->message);
+	}
+
+	/* whether to trade CPU time for a smaller resident set */
+	self->low_memory = g_key_file_get_boolean (keyfile,
+						   "fwupd",
+						   "LowMemory",
+						   &error_low_memory);
+	if (!self->low_memory && error_low_memory != NULL) {
+		g_debug ("failed to read LowMemory key: %s",
+			 error_low_memory->message);
+	}
+
 	return TRUE;
 }
 
+static gboolean
+fu_config_reload_cb (gpointer user_data)
+{
+	FuConfig *self = FU_CONFIG (user_data);
+	g_autoptr(GError) error = NULL;
+
+	self->reload_id = 0;
+	if (!fu_config_reload (self, &error))
+		g_warning ("failed to rescan daemon config: %s", error->message);
+	fu_config_emit_changed (self);
+	return G_SOURCE_REMOVE;
+}
+
+/* editors and package upgrades write the file in several steps */
 static void
 fu_config_monitor_changed_cb (GFileMonitor *monitor,
 			      GFile *file,
@@ -213,11 +362,12 @@ fu_config_monitor_changed_cb (GFileMonitor *monitor,
 			      gpointer user_data)
 {
 	FuConfig *self = FU_CONFIG (user_data);
-	g_autoptr(GError) error = NULL;
 	g_debug ("%s changed, reloading all configs", self->config_file);
-	if (!fu_config_reload (self, &error))
-		g_warning ("failed to rescan daemon config: %s", error->message);
-	fu_config_emit_changed (self);
+	if (self->reload_id != 0)
+		g_source_remove (self->reload_id);
+	self->reload_id = g_timeout_add (FU_CONFIG_RELOAD_DELAY,
+					 fu_config_reload_cb,
+					 self);
 }
 
 gboolean
@@ -338,6 +488,90 @@ fu_config_get_enumerate_all_devices (FuConfig *self)
 	return self->enumerate_all_devices;
 }
 
+gboolean
+fu_config_get_concurrent_coldplug (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->concurrent_coldplug;
+}
+
+gboolean
+fu_config_get_concurrent_hotplug (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->concurrent_hotplug;
+}
+
+gboolean
+fu_config_get_concurrent_install (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->concurrent_install;
+}
+
+gboolean
+fu_config_get_batch_history_writes (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->batch_history_writes;
+}
+
+gboolean
+fu_config_get_threaded_runners (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->threaded_runners;
+}
+
+gboolean
+fu_config_get_enable_metrics (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->enable_metrics;
+}
+
+gboolean
+fu_config_get_enable_peer_socket (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->enable_peer_socket;
+}
+
+gboolean
+fu_config_get_low_memory (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), FALSE);
+	return self->low_memory;
+}
+
+guint
+fu_config_get_verify_interval (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), 0);
+	return self->verify_interval;
+}
+
+guint
+fu_config_get_history_max_entries (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), 0);
+	return self->history_max_entries;
+}
+
+guint
+fu_config_get_history_max_age (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), 0);
+	return self->history_max_age;
+}
+
+gboolean
+fu_config_get_history_keep_unreported (FuConfig *self)
+{
+	g_return_val_if_fail (FU_IS_CONFIG (self), TRUE);
+	return self->history_keep_unreported;
+}
+
 static void
 fu_config_class_init (FuConfigClass *klass)
 {
@@ -366,6 +600,8 @@ fu_config_finalize (GObject *obj)
 {
 	FuConfig *self = FU_CONFIG (obj);
 
+	if (self->reload_id != 0)
+		g_source_remove (self->reload_id);
 	if (self->monitor != NULL) {
 		g_file_monitor_cancel (self->monitor);
 		g_object_unref (self->monitor);
@@ -31,3 +31,15 @@ guint		 fu_config_get_uri_scheme_prio		(FuConfig	*self,
 							 const gchar	*protocol);
 gboolean	 fu_config_get_update_motd		(FuConfig	*self);
 gboolean	 fu_config_get_enumerate_all_devices	(FuConfig	*self);
+gboolean	 fu_config_get_concurrent_coldplug	(FuConfig	*self);
+gboolean	 fu_config_get_concurrent_hotplug	(FuConfig	*self);
+gboolean	 fu_config_get_concurrent_install	(FuConfig	*self);
+gboolean	 fu_config_get_batch_history_writes	(FuConfig	*self);
+gboolean	 fu_config_get_threaded_runners		(FuConfig	*self);
+gboolean	 fu_config_get_enable_metrics		(FuConfig	*self);
+gboolean	 fu_config_get_enable_peer_socket	(FuConfig	*self);
+gboolean	 fu_config_get_low_memory		(FuConfig	*self);
+guint		 fu_config_get_verify_interval		(FuConfig	*self);
+guint		 fu_config_get_history_max_entries	(FuConfig	*self);
+guint		 fu_config_get_history_max_age		(FuConfig	*self);
+gboolean	 fu_config_get_history_keep_unreported	(FuConfig	*self);
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuDecompressor"
+
+#include "config.h"
+
+#include <fwupd.h>
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "fu-decompressor.h"
+
+struct _FuDecompressor
+{
+	GObject			 parent_instance;
+	FuDecompressorFormat	 format;
+#ifdef HAVE_LZMA
+	lzma_stream		 lzma;
+#endif
+#ifdef HAVE_ZSTD
+	ZSTD_DStream		*zstd;
+	gboolean		 zstd_frame_done;
+#endif
+};
+
+static void fu_decompressor_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (FuDecompressor, fu_decompressor, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						fu_decompressor_iface_init))
+
+/* no progress was possible, so ask for more input or more space */
+static GConverterResult
+fu_decompressor_convert_stalled (gsize outbuf_size,
+				 GConverterFlags flags,
+				 GError **error)
+{
+	if (flags & G_CONVERTER_FLUSH)
+		return G_CONVERTER_FLUSHED;
+	if (outbuf_size == 0) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NO_SPACE,
+				     "Need more output space");
+		return G_CONVERTER_ERROR;
+	}
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_PARTIAL_INPUT,
+			     "Need more input");
+	return G_CONVERTER_ERROR;
+}
+
+#ifdef HAVE_LZMA
+static gboolean
+fu_decompressor_lzma_init (FuDecompressor *self, GError **error)
+{
+	lzma_ret rc;
+	lzma_stream strm = LZMA_STREAM_INIT;
+
+	self->lzma = strm;
+	rc = lzma_stream_decoder (&self->lzma, UINT64_MAX, LZMA_CONCATENATED);
+	if (rc != LZMA_OK) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to set up xz decoder: %u",
+			     (guint) rc);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static GConverterResult
+fu_decompressor_lzma_convert (FuDecompressor *self,
+			      const void *inbuf,
+			      gsize inbuf_size,
+			      void *outbuf,
+			      gsize outbuf_size,
+			      GConverterFlags flags,
+			      gsize *bytes_read,
+			      gsize *bytes_written,
+			      GError **error)
+{
+	lzma_ret rc;
+
+	self->lzma.next_in = inbuf;
+	self->lzma.avail_in = inbuf_size;
+	self->lzma.next_out = outbuf;
+	self->lzma.avail_out = outbuf_size;
+	rc = lzma_code (&self->lzma,
+			flags & G_CONVERTER_INPUT_AT_END ? LZMA_FINISH : LZMA_RUN);
+	*bytes_read = inbuf_size - self->lzma.avail_in;
+	*bytes_written = outbuf_size - self->lzma.avail_out;
+	if (rc == LZMA_STREAM_END)
+		return G_CONVERTER_FINISHED;
+	if (rc != LZMA_OK && rc != LZMA_BUF_ERROR) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "failed to decompress xz data: %u",
+			     (guint) rc);
+		return G_CONVERTER_ERROR;
+	}
+	if (*bytes_read > 0 || *bytes_written > 0)
+		return G_CONVERTER_CONVERTED;
+	return fu_decompressor_convert_stalled (outbuf_size, flags, error);
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static gboolean
+fu_decompressor_zstd_init (FuDecompressor *self, GError **error)
+{
+	self->zstd = ZSTD_createDStream ();
+	if (self->zstd == NULL) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "failed to set up zstd decoder");
+		return FALSE;
+	}
+	ZSTD_initDStream (self->zstd);
+	return TRUE;
+}
+
+static GConverterResult
+fu_decompressor_zstd_convert (FuDecompressor *self,
+			      const void *inbuf,
+			      gsize inbuf_size,
+			      void *outbuf,
+			      gsize outbuf_size,
+			      GConverterFlags flags,
+			      gsize *bytes_read,
+			      gsize *bytes_written,
+			      GError **error)
+{
+	gsize rc;
+	ZSTD_inBuffer in = { inbuf, inbuf_size, 0 };
+	ZSTD_outBuffer out = { outbuf, outbuf_size, 0 };
+
+	/* the last frame was complete and there is nothing that follows */
+	*bytes_read = 0;
+	*bytes_written = 0;
+	if (inbuf_size == 0 && (flags & G_CONVERTER_INPUT_AT_END) && self->zstd_frame_done)
+		return G_CONVERTER_FINISHED;
+
+	rc = ZSTD_decompressStream (self->zstd, &out, &in);
+	if (ZSTD_isError (rc)) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "failed to decompress zstd data: %s",
+			     ZSTD_getErrorName (rc));
+		return G_CONVERTER_ERROR;
+	}
+	*bytes_read = in.pos;
+	*bytes_written = out.pos;
+
+	/* frames can be concatenated, so only finish at the end of the input */
+	self->zstd_frame_done = rc == 0;
+	if (self->zstd_frame_done &&
+	    (flags & G_CONVERTER_INPUT_AT_END) &&
+	    in.pos == in.size)
+		return G_CONVERTER_FINISHED;
+	if (*bytes_read > 0 || *bytes_written > 0)
+		return G_CONVERTER_CONVERTED;
+	return fu_decompressor_convert_stalled (outbuf_size, flags, error);
+}
+#endif
+
+static GConverterResult
+fu_decompressor_convert (GConverter *converter,
+			 const void *inbuf,
+			 gsize inbuf_size,
+			 void *outbuf,
+			 gsize outbuf_size,
+			 GConverterFlags flags,
+			 gsize *bytes_read,
+			 gsize *bytes_written,
+			 GError **error)
+{
+	FuDecompressor *self = FU_DECOMPRESSOR (converter);
+#ifdef HAVE_LZMA
+	if (self->format == FU_DECOMPRESSOR_FORMAT_XZ) {
+		return fu_decompressor_lzma_convert (self, inbuf, inbuf_size,
+						     outbuf, outbuf_size, flags,
+						     bytes_read, bytes_written,
+						     error);
+	}
+#endif
+#ifdef HAVE_ZSTD
+	if (self->format == FU_DECOMPRESSOR_FORMAT_ZSTD) {
+		return fu_decompressor_zstd_convert (self, inbuf, inbuf_size,
+						     outbuf, outbuf_size, flags,
+						     bytes_read, bytes_written,
+						     error);
+	}
+#endif
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "decompression format not supported");
+	return G_CONVERTER_ERROR;
+}
+
+static void
+fu_decompressor_reset (GConverter *converter)
+{
+	FuDecompressor *self = FU_DECOMPRESSOR (converter);
+#ifdef HAVE_LZMA
+	if (self->format == FU_DECOMPRESSOR_FORMAT_XZ) {
+		lzma_end (&self->lzma);
+		if (!fu_decompressor_lzma_init (self, NULL))
+			g_critical ("failed to reset xz decoder");
+	}
+#endif
+#ifdef HAVE_ZSTD
+	if (self->format == FU_DECOMPRESSOR_FORMAT_ZSTD) {
+		ZSTD_initDStream (self->zstd);
+		self->zstd_frame_done = FALSE;
+	}
+#endif
+}
+
+/**
+ * fu_decompressor_format_supported:
+ * @format: a #FuDecompressorFormat
+ *
+ * Gets if the decompression format was enabled at build time.
+ *
+ * Returns: %TRUE if supported
+ **/
+gboolean
+fu_decompressor_format_supported (FuDecompressorFormat format)
+{
+#ifdef HAVE_LZMA
+	if (format == FU_DECOMPRESSOR_FORMAT_XZ)
+		return TRUE;
+#endif
+#ifdef HAVE_ZSTD
+	if (format == FU_DECOMPRESSOR_FORMAT_ZSTD)
+		return TRUE;
+#endif
+	return FALSE;
+}
+
+static void
+fu_decompressor_iface_init (GConverterIface *iface)
+{
+	iface->convert = fu_decompressor_convert;
+	iface->reset = fu_decompressor_reset;
+}
+
+static void
+fu_decompressor_finalize (GObject *object)
+{
+	FuDecompressor *self = FU_DECOMPRESSOR (object);
+#ifdef HAVE_LZMA
+	if (self->format == FU_DECOMPRESSOR_FORMAT_XZ)
+		lzma_end (&self->lzma);
+#endif
+#ifdef HAVE_ZSTD
+	if (self->zstd != NULL)
+		ZSTD_freeDStream (self->zstd);
+#endif
+	G_OBJECT_CLASS (fu_decompressor_parent_class)->finalize (object);
+}
+
+static void
+fu_decompressor_class_init (FuDecompressorClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_decompressor_finalize;
+}
+
+static void
+fu_decompressor_init (FuDecompressor *self)
+{
+}
+
+/**
+ * fu_decompressor_new:
+ * @format: a #FuDecompressorFormat
+ * @error: A #GError, or %NULL
+ *
+ * Creates a #GConverter that decompresses a stream as it is read, which means
+ * the whole of the compressed and decompressed data is never held in memory.
+ *
+ * Returns: (transfer full): a #FuDecompressor, or %NULL for error
+ **/
+FuDecompressor *
+fu_decompressor_new (FuDecompressorFormat format, GError **error)
+{
+	g_autoptr(FuDecompressor) self = g_object_new (FU_TYPE_DECOMPRESSOR, NULL);
+
+	if (!fu_decompressor_format_supported (format)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "decompression format %u not supported",
+			     (guint) format);
+		return NULL;
+	}
+#ifdef HAVE_LZMA
+	if (format == FU_DECOMPRESSOR_FORMAT_XZ) {
+		if (!fu_decompressor_lzma_init (self, error))
+			return NULL;
+	}
+#endif
+#ifdef HAVE_ZSTD
+	if (format == FU_DECOMPRESSOR_FORMAT_ZSTD) {
+		if (!fu_decompressor_zstd_init (self, error))
+			return NULL;
+	}
+#endif
+	self->format = format;
+	return g_steal_pointer (&self);
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_DECOMPRESSOR (fu_decompressor_get_type ())
+G_DECLARE_FINAL_TYPE (FuDecompressor, fu_decompressor, FU, DECOMPRESSOR, GObject)
+
+typedef enum {
+	FU_DECOMPRESSOR_FORMAT_UNKNOWN,
+	FU_DECOMPRESSOR_FORMAT_XZ,
+	FU_DECOMPRESSOR_FORMAT_ZSTD,
+	/*< private >*/
+	FU_DECOMPRESSOR_FORMAT_LAST
+} FuDecompressorFormat;
+
+FuDecompressor		*fu_decompressor_new			(FuDecompressorFormat	 format,
+								 GError			**error);
+gboolean		 fu_decompressor_format_supported	(FuDecompressorFormat	 format);
@@ -14,7 +14,9 @@
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-mutex.h"
+#include "fu-usdt-private.h"
 
+#include "fwupd-common-private.h"
 #include "fwupd-error.h"
 
 /**
@@ -38,6 +40,15 @@ struct _FuDeviceList
 	GObject			 parent_instance;
 	GPtrArray		*devices;	/* of FuDeviceItem */
 	GRWLock			 devices_mutex;
+	gboolean		 concurrent_replug;
+	GMutex			 index_mutex;
+	gboolean		 index_valid;
+	GPtrArray		*index_ids;	/* of FuDeviceIndexEntry, sorted by key */
+	GHashTable		*index_guids;	/* interned GUID : GPtrArray of FuDeviceIndexEntry */
+	GHashTable		*index_connections; /* physical\nlogical : GPtrArray of FuDeviceIndexEntry */
+	GMutex			 snapshot_mutex;
+	GPtrArray		*snapshot_all;	/* (nullable) (element-type FuDevice) */
+	GPtrArray		*snapshot_active; /* (nullable) (element-type FuDevice) */
 };
 
 enum {
@@ -56,8 +67,177 @@ typedef struct {
 	guint			 remove_id;
 } FuDeviceItem;
 
+/* secondary indexes are rebuilt when the list changes, and any match is
+ * checked against the device in case it has been modified since */
+typedef struct {
+	gchar			*key;
+	FuDeviceItem		*item;		/* no ref */
+	gboolean		 is_old;
+} FuDeviceIndexEntry;
+
 G_DEFINE_TYPE (FuDeviceList, fu_device_list, G_TYPE_OBJECT)
 
+static void
+fu_device_index_entry_free (FuDeviceIndexEntry *entry)
+{
+	g_free (entry->key);
+	g_free (entry);
+}
+
+static FuDeviceIndexEntry *
+fu_device_index_entry_new (const gchar *key, FuDeviceItem *item, gboolean is_old)
+{
+	FuDeviceIndexEntry *entry = g_new0 (FuDeviceIndexEntry, 1);
+	entry->key = g_strdup (key);
+	entry->item = item;
+	entry->is_old = is_old;
+	return entry;
+}
+
+static FuDevice *
+fu_device_index_entry_get_device (FuDeviceIndexEntry *entry)
+{
+	return entry->is_old ? entry->item->device_old : entry->item->device;
+}
+
+static gint
+fu_device_list_index_sort_cb (gconstpointer a, gconstpointer b)
+{
+	FuDeviceIndexEntry *entry1 = *((FuDeviceIndexEntry **) a);
+	FuDeviceIndexEntry *entry2 = *((FuDeviceIndexEntry **) b);
+	return g_strcmp0 (entry1->key, entry2->key);
+}
+
+static gchar *
+fu_device_list_index_connection_key (const gchar *physical_id, const gchar *logical_id)
+{
+	return g_strdup_printf ("%s\n%s", physical_id, logical_id != NULL ? logical_id : "");
+}
+
+static void
+fu_device_list_index_add_guid (GHashTable *hash, const gchar *guid, FuDeviceIndexEntry *entry)
+{
+	GPtrArray *entries = g_hash_table_lookup (hash, guid);
+	if (entries == NULL) {
+		entries = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_index_entry_free);
+		g_hash_table_insert (hash, (gpointer) fwupd_intern_ref (guid), entries);
+	}
+	g_ptr_array_add (entries, entry);
+}
+
+static void
+fu_device_list_index_add (GHashTable *hash, const gchar *key, FuDeviceIndexEntry *entry)
+{
+	GPtrArray *entries = g_hash_table_lookup (hash, key);
+	if (entries == NULL) {
+		entries = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_index_entry_free);
+		g_hash_table_insert (hash, g_strdup (key), entries);
+	}
+	g_ptr_array_add (entries, entry);
+}
+
+/* must be called with devices_mutex held for writing */
+static void
+fu_device_list_index_invalidate (FuDeviceList *self)
+{
+	self->index_valid = FALSE;
+}
+
+/* must be called after devices_mutex is released for writing, as the
+ * snapshot_mutex is held while building the snapshot with it held for reading */
+static void
+fu_device_list_snapshot_invalidate (FuDeviceList *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->snapshot_mutex);
+	g_clear_pointer (&self->snapshot_all, g_ptr_array_unref);
+	g_clear_pointer (&self->snapshot_active, g_ptr_array_unref);
+}
+
+/* must be called with snapshot_mutex held */
+static void
+fu_device_list_snapshot_ensure (FuDeviceList *self)
+{
+	if (self->snapshot_all != NULL)
+		return;
+
+	self->snapshot_all = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	self->snapshot_active = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_rw_lock_reader_lock (&self->devices_mutex);
+	for (guint i = 0; i < self->devices->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+		g_ptr_array_add (self->snapshot_all, g_object_ref (item->device));
+		g_ptr_array_add (self->snapshot_active, g_object_ref (item->device));
+	}
+	for (guint i = 0; i < self->devices->len; i++) {
+		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+		if (item->device_old == NULL)
+			continue;
+		g_ptr_array_add (self->snapshot_all, g_object_ref (item->device_old));
+	}
+	g_rw_lock_reader_unlock (&self->devices_mutex);
+}
+
+static GPtrArray *
+fu_device_list_snapshot_copy (GPtrArray *snapshot)
+{
+	GPtrArray *devices = g_ptr_array_new_full (snapshot->len, (GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < snapshot->len; i++)
+		g_ptr_array_add (devices, g_object_ref (g_ptr_array_index (snapshot, i)));
+	return devices;
+}
+
+/* must be called with devices_mutex held for reading and index_mutex held */
+static void
+fu_device_list_index_ensure (FuDeviceList *self)
+{
+	if (self->index_valid)
+		return;
+
+	g_ptr_array_set_size (self->index_ids, 0);
+	g_hash_table_remove_all (self->index_guids);
+	g_hash_table_remove_all (self->index_connections);
+
+	/* active devices are always added before the old devices */
+	for (guint is_old = 0; is_old < 2; is_old++) {
+		for (guint i = 0; i < self->devices->len; i++) {
+			FuDeviceItem *item = g_ptr_array_index (self->devices, i);
+			FuDevice *device = is_old ? item->device_old : item->device;
+			GPtrArray *guids;
+			const gchar *ids[3] = { NULL };
+
+			if (device == NULL)
+				continue;
+
+			/* exact and abbreviated IDs */
+			ids[0] = fu_device_get_id (device);
+			ids[1] = fu_device_get_equivalent_id (device);
+			for (guint j = 0; ids[j] != NULL; j++) {
+				g_ptr_array_add (self->index_ids,
+						 fu_device_index_entry_new (ids[j], item, is_old));
+			}
+
+			/* GUIDs */
+			guids = fu_device_get_guids (device);
+			for (guint j = 0; j < guids->len; j++) {
+				const gchar *guid = g_ptr_array_index (guids, j);
+				fu_device_list_index_add_guid (self->index_guids, guid,
+							       fu_device_index_entry_new (guid, item, is_old));
+			}
+
+			/* physical and logical connection */
+			if (fu_device_get_physical_id (device) != NULL) {
+				g_autofree gchar *key = NULL;
+				key = fu_device_list_index_connection_key (fu_device_get_physical_id (device),
+									   fu_device_get_logical_id (device));
+				fu_device_list_index_add (self->index_connections, key,
+							  fu_device_index_entry_new (key, item, is_old));
+			}
+		}
+	}
+	g_ptr_array_sort (self->index_ids, fu_device_list_index_sort_cb);
+	self->index_valid = TRUE;
+}
+
 static void
 fu_device_list_emit_device_added (FuDeviceList *self, FuDevice *device)
 {
@@ -80,37 +260,47 @@ fu_device_list_emit_device_changed (FuDeviceList *self, FuDevice *device)
 }
 
 /* we cannot use fu_device_get_children() as this will not find "parent-only"
- * logical relationships added using fu_device_add_parent_guid() */
-static GPtrArray *
-fu_device_list_get_children (FuDeviceList *self, FuDevice *device)
+ * logical relationships added using fu_device_add_parent_guid(), so find the
+ * children of every device in one scan rather than scanning once per device */
+static GHashTable *
+fu_device_list_get_children_all (FuDeviceList *self)
 {
-	GPtrArray *devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	GHashTable *children = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						      NULL, (GDestroyNotify) g_ptr_array_unref);
 	g_rw_lock_reader_lock (&self->devices_mutex);
 	for (guint i = 0; i < self->devices->len; i++) {
 		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (device == fu_device_get_parent (item->device))
-			g_ptr_array_add (devices, g_object_ref (item->device));
+		FuDevice *parent = fu_device_get_parent (item->device);
+		GPtrArray *devices;
+		if (parent == NULL)
+			continue;
+		devices = g_hash_table_lookup (children, parent);
+		if (devices == NULL) {
+			devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+			g_hash_table_insert (children, parent, devices);
+		}
+		g_ptr_array_add (devices, g_object_ref (item->device));
 	}
 	g_rw_lock_reader_unlock (&self->devices_mutex);
-	return devices;
+	return children;
 }
 
 static void
-fu_device_list_depsolve_order_full (FuDeviceList *self, FuDevice *device, guint depth)
+fu_device_list_depsolve_order_full (GHashTable *children_all, FuDevice *device, guint depth)
 {
-	g_autoptr(GPtrArray) children = NULL;
+	GPtrArray *children;
 
 	/* ourself */
 	fu_device_set_order (device, depth);
 
 	/* optional children */
-	children = fu_device_list_get_children (self, device);
-	for (guint i = 0; i < children->len; i++) {
+	children = g_hash_table_lookup (children_all, device);
+	for (guint i = 0; children != NULL && i < children->len; i++) {
 		FuDevice *child = g_ptr_array_index (children, i);
 		if (fu_device_has_flag (child, FWUPD_DEVICE_FLAG_INSTALL_PARENT_FIRST)) {
-			fu_device_list_depsolve_order_full (self, child, depth + 1);
+			fu_device_list_depsolve_order_full (children_all, child, depth + 1);
 		} else {
-			fu_device_list_depsolve_order_full (self, child, depth - 1);
+			fu_device_list_depsolve_order_full (children_all, child, depth - 1);
 		}
 	}
 }
@@ -130,7 +320,8 @@ void
 fu_device_list_depsolve_order (FuDeviceList *self, FuDevice *device)
 {
 	g_autoptr(FuDevice) root = fu_device_get_root (device);
-	fu_device_list_depsolve_order_full (self, root, 0);
+	g_autoptr(GHashTable) children_all = fu_device_list_get_children_all (self);
+	fu_device_list_depsolve_order_full (children_all, root, 0);
 }
 
 /**
@@ -148,23 +339,11 @@ fu_device_list_depsolve_order (FuDeviceList *self, FuDevice *device)
 GPtrArray *
 fu_device_list_get_all (FuDeviceList *self)
 {
-	GPtrArray *devices;
+	g_autoptr(GMutexLocker) locker = NULL;
 	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), NULL);
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-
-	g_rw_lock_reader_lock (&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		g_ptr_array_add (devices, g_object_ref (item->device));
-	}
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		if (item->device_old == NULL)
-			continue;
-		g_ptr_array_add (devices, g_object_ref (item->device_old));
-	}
-	g_rw_lock_reader_unlock (&self->devices_mutex);
-	return devices;
+	locker = g_mutex_locker_new (&self->snapshot_mutex);
+	fu_device_list_snapshot_ensure (self);
+	return fu_device_list_snapshot_copy (self->snapshot_all);
 }
 
 /**
@@ -182,16 +361,11 @@ fu_device_list_get_all (FuDeviceList *self)
 GPtrArray *
 fu_device_list_get_active (FuDeviceList *self)
 {
-	GPtrArray *devices;
+	g_autoptr(GMutexLocker) locker = NULL;
 	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), NULL);
-	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	g_rw_lock_reader_lock (&self->devices_mutex);
-	for (guint i = 0; i < self->devices->len; i++) {
-		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
-		g_ptr_array_add (devices, g_object_ref (item->device));
-	}
-	g_rw_lock_reader_unlock (&self->devices_mutex);
-	return devices;
+	locker = g_mutex_locker_new (&self->snapshot_mutex);
+	fu_device_list_snapshot_ensure (self);
+	return fu_device_list_snapshot_copy (self->snapshot_active);
 }
 
 static FuDeviceItem *
@@ -212,11 +386,35 @@ fu_device_list_find_by_device (FuDeviceList *self, FuDevice *device)
 	return NULL;
 }
 
+/* must be called with devices_mutex held for reading */
+static FuDeviceItem *
+fu_device_list_index_find_by_guid (FuDeviceList *self, const gchar *guid)
+{
+	GPtrArray *entries;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->index_mutex);
+
+	fu_device_list_index_ensure (self);
+	entries = g_hash_table_lookup (self->index_guids, fwupd_intern_lookup (guid));
+	for (guint i = 0; entries != NULL && i < entries->len; i++) {
+		FuDeviceIndexEntry *entry = g_ptr_array_index (entries, i);
+		FuDevice *device = fu_device_index_entry_get_device (entry);
+		if (device != NULL && fu_device_has_guid (device, guid))
+			return entry->item;
+	}
+	return NULL;
+}
+
 static FuDeviceItem *
 fu_device_list_find_by_guid (FuDeviceList *self, const gchar *guid)
 {
+	FuDeviceItem *item;
 	g_autoptr(GRWLockReaderLocker) locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
+
+	/* use the index, falling back to a scan for GUIDs added since */
+	item = fu_device_list_index_find_by_guid (self, guid);
+	if (item != NULL)
+		return item;
 	for (guint i = 0; i < self->devices->len; i++) {
 		FuDeviceItem *item = g_ptr_array_index (self->devices, i);
 		if (fu_device_has_guid (item->device, guid))
@@ -232,16 +430,46 @@ fu_device_list_find_by_guid (FuDeviceList *self, const gchar *guid)
 	return NULL;
 }
 
+/* must be called with devices_mutex held for reading */
+static FuDeviceItem *
+fu_device_list_index_find_by_connection (FuDeviceList *self,
+					 const gchar *physical_id,
+					 const gchar *logical_id)
+{
+	GPtrArray *entries;
+	g_autofree gchar *key = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->index_mutex);
+
+	fu_device_list_index_ensure (self);
+	key = fu_device_list_index_connection_key (physical_id, logical_id);
+	entries = g_hash_table_lookup (self->index_connections, key);
+	for (guint i = 0; entries != NULL && i < entries->len; i++) {
+		FuDeviceIndexEntry *entry = g_ptr_array_index (entries, i);
+		FuDevice *device = fu_device_index_entry_get_device (entry);
+		if (device != NULL &&
+		    g_strcmp0 (fu_device_get_physical_id (device), physical_id) == 0 &&
+		    g_strcmp0 (fu_device_get_logical_id (device), logical_id) == 0)
+			return entry->item;
+	}
+	return NULL;
+}
+
 static FuDeviceItem *
 fu_device_list_find_by_connection (FuDeviceList *self,
 				   const gchar *physical_id,
 				   const gchar *logical_id)
 {
+	FuDeviceItem *item = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 	if (physical_id == NULL)
 		return NULL;
 	locker = g_rw_lock_reader_locker_new (&self->devices_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
+
+	/* use the index, falling back to a scan for IDs changed since */
+	item = fu_device_list_index_find_by_connection (self, physical_id, logical_id);
+	if (item != NULL)
+		return item;
 	for (guint i = 0; i < self->devices->len; i++) {
 		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
 		FuDevice *device = item_tmp->device;
@@ -261,6 +489,68 @@ fu_device_list_find_by_connection (FuDeviceList *self,
 	return NULL;
 }
 
+/* must be called with devices_mutex held for reading */
+static FuDeviceItem *
+fu_device_list_index_find_by_id (FuDeviceList *self,
+				 const gchar *device_id,
+				 gboolean *multiple_matches)
+{
+	FuDeviceItem *item = NULL;
+	FuDeviceItem *item_old = NULL;
+	gboolean multiple = FALSE;
+	gboolean multiple_old = FALSE;
+	gsize device_id_len = strlen (device_id);
+	guint lo = 0;
+	guint hi;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->index_mutex);
+
+	fu_device_list_index_ensure (self);
+
+	/* find the first entry that is not less than the prefix */
+	hi = self->index_ids->len;
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuDeviceIndexEntry *entry = g_ptr_array_index (self->index_ids, mid);
+		if (g_strcmp0 (entry->key, device_id) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* all the entries that match the prefix are next to each other */
+	for (guint i = lo; i < self->index_ids->len; i++) {
+		FuDeviceIndexEntry *entry = g_ptr_array_index (self->index_ids, i);
+		FuDevice *device = fu_device_index_entry_get_device (entry);
+		if (strncmp (entry->key, device_id, device_id_len) != 0)
+			break;
+
+		/* the device has changed ID since the index was built */
+		if (device == NULL ||
+		    (g_strcmp0 (fu_device_get_id (device), entry->key) != 0 &&
+		     g_strcmp0 (fu_device_get_equivalent_id (device), entry->key) != 0))
+			continue;
+		if (entry->is_old) {
+			if (item_old != NULL)
+				multiple_old = TRUE;
+			item_old = entry->item;
+		} else {
+			if (item != NULL)
+				multiple = TRUE;
+			item = entry->item;
+		}
+	}
+
+	/* only use old devices if we didn't find the active device */
+	if (item != NULL) {
+		if (multiple && multiple_matches != NULL)
+			*multiple_matches = TRUE;
+		return item;
+	}
+	if (multiple_old && multiple_matches != NULL)
+		*multiple_matches = TRUE;
+	return item_old;
+}
+
 static FuDeviceItem *
 fu_device_list_find_by_id (FuDeviceList *self,
 			   const gchar *device_id,
@@ -275,9 +565,16 @@ fu_device_list_find_by_id (FuDeviceList *self,
 		return NULL;
 	}
 
-	/* support abbreviated hashes */
+	/* use the sorted index, which also supports abbreviated hashes */
 	device_id_len = strlen (device_id);
 	g_rw_lock_reader_lock (&self->devices_mutex);
+	item = fu_device_list_index_find_by_id (self, device_id, multiple_matches);
+	g_rw_lock_reader_unlock (&self->devices_mutex);
+	if (item != NULL)
+		return item;
+
+	/* fall back to a scan in case the device ID changed */
+	g_rw_lock_reader_lock (&self->devices_mutex);
 	for (guint i = 0; i < self->devices->len; i++) {
 		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
 		const gchar *ids[] = {
@@ -393,7 +690,9 @@ fu_device_list_device_delayed_remove_cb (gpointer user_data)
 		fu_device_list_emit_device_removed (self, child);
 		g_rw_lock_writer_lock (&self->devices_mutex);
 		g_ptr_array_remove (self->devices, child_item);
+		fu_device_list_index_invalidate (self);
 		g_rw_lock_writer_unlock (&self->devices_mutex);
+		fu_device_list_snapshot_invalidate (self);
 	}
 
 	/* just remove now */
@@ -401,7 +700,9 @@ fu_device_list_device_delayed_remove_cb (gpointer user_data)
 	fu_device_list_emit_device_removed (self, item->device);
 	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_ptr_array_remove (self->devices, item);
+	fu_device_list_index_invalidate (self);
 	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_snapshot_invalidate (self);
 	return G_SOURCE_REMOVE;
 }
 
@@ -479,14 +780,18 @@ fu_device_list_remove (FuDeviceList *self, FuDevice *device)
 		fu_device_list_emit_device_removed (self, child);
 		g_rw_lock_writer_lock (&self->devices_mutex);
 		g_ptr_array_remove (self->devices, child_item);
+		fu_device_list_index_invalidate (self);
 		g_rw_lock_writer_unlock (&self->devices_mutex);
+		fu_device_list_snapshot_invalidate (self);
 	}
 
 	/* remove right now */
 	fu_device_list_emit_device_removed (self, item->device);
 	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_ptr_array_remove (self->devices, item);
+	fu_device_list_index_invalidate (self);
 	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_snapshot_invalidate (self);
 }
 
 static void
@@ -519,7 +824,9 @@ fu_device_list_item_finalized_cb (gpointer data, GObject *where_the_object_was)
 		    where_the_object_was);
 	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_ptr_array_remove (self->devices, item);
+	fu_device_list_index_invalidate (self);
 	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_snapshot_invalidate (self);
 }
 
 /* this should never be required, and yet here we are */
@@ -610,8 +917,12 @@ fu_device_list_replace (FuDeviceList *self, FuDeviceItem *item, FuDevice *device
 	}
 
 	/* assign the new device */
+	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_set_object (&item->device_old, item->device);
 	fu_device_list_item_set_device (item, device);
+	fu_device_list_index_invalidate (self);
+	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_snapshot_invalidate (self);
 	fu_device_list_emit_device_changed (self, device);
 
 	/* we were waiting for this... */
@@ -698,7 +1009,9 @@ fu_device_list_add (FuDeviceList *self, FuDevice *device)
 	fu_device_list_item_set_device (item, device);
 	g_rw_lock_writer_lock (&self->devices_mutex);
 	g_ptr_array_add (self->devices, item);
+	fu_device_list_index_invalidate (self);
 	g_rw_lock_writer_unlock (&self->devices_mutex);
+	fu_device_list_snapshot_invalidate (self);
 	fu_device_list_emit_device_added (self, device);
 }
 
@@ -732,6 +1045,15 @@ fu_device_list_get_by_guid (FuDeviceList *self, const gchar *guid, GError **erro
 	return NULL;
 }
 
+typedef struct {
+	FuDeviceList		*self;		/* no ref */
+	FuDeviceItem		*item;		/* no ref */
+	GMainLoop		*loop;
+	guint			 wait_removed;
+	guint			 timeout_id;
+	gboolean		 done;
+} FuDeviceListReplugWaiter;
+
 /* count devices that are disconnected and are waiting to be replugged */
 static guint
 fu_device_list_devices_wait_removed (FuDeviceList *self)
@@ -747,28 +1069,91 @@ fu_device_list_devices_wait_removed (FuDeviceList *self)
 	return cnt;
 }
 
+/* called for every device list and device flag change while waiting */
+static void
+fu_device_list_replug_waiter_check (FuDeviceListReplugWaiter *waiter)
+{
+	guint wait_removed;
+	if (waiter->item == NULL)
+		return;
+	wait_removed = fu_device_list_devices_wait_removed (waiter->self);
+	if (wait_removed != waiter->wait_removed) {
+		g_debug ("devices in wait_removed: %u -> %u",
+			 waiter->wait_removed, wait_removed);
+		waiter->wait_removed = wait_removed;
+	}
+	if (!fu_device_has_flag (waiter->item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG) &&
+	    wait_removed == 0) {
+		waiter->done = TRUE;
+		g_main_loop_quit (waiter->loop);
+	}
+}
+
+static void
+fu_device_list_replug_waiter_device_cb (FuDeviceList *self,
+					FuDevice *device,
+					FuDeviceListReplugWaiter *waiter)
+{
+	fu_device_list_replug_waiter_check (waiter);
+}
+
+static void
+fu_device_list_replug_waiter_removed_cb (FuDeviceList *self,
+					 FuDevice *device,
+					 FuDeviceListReplugWaiter *waiter)
+{
+	/* the delayed removal happened first, so the item is about to be freed */
+	if (waiter->item != NULL && waiter->item->device == device) {
+		waiter->item = NULL;
+		waiter->done = TRUE;
+		g_main_loop_quit (waiter->loop);
+		return;
+	}
+	fu_device_list_replug_waiter_check (waiter);
+}
+
+static void
+fu_device_list_replug_waiter_notify_cb (FuDevice *device,
+					GParamSpec *pspec,
+					FuDeviceListReplugWaiter *waiter)
+{
+	fu_device_list_replug_waiter_check (waiter);
+}
+
+static gboolean
+fu_device_list_replug_waiter_timeout_cb (gpointer user_data)
+{
+	FuDeviceListReplugWaiter *waiter = (FuDeviceListReplugWaiter *) user_data;
+	waiter->timeout_id = 0;
+	g_main_loop_quit (waiter->loop);
+	return G_SOURCE_REMOVE;
+}
+
 /**
- * fu_device_list_wait_for_replug:
+ * fu_device_list_set_concurrent_replug:
  * @self: A #FuDeviceList
- * @device: A #FuDevice
- * @error: A #GError, or %NULL
- *
- * Waits for a specific device to replug if %FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG
- * is set.
- *
- * If the device does not exist this function returns without an error.
+ * @concurrent_replug: boolean
  *
- * Returns: %TRUE for success
+ * Sets if multiple devices may be waiting for replug at the same time, for
+ * instance when independent devices are being updated concurrently. If unset,
+ * any other device still waiting for replug is assumed to be stale.
  *
- * Since: 1.1.2
+ * Since: 1.5.8
  **/
-gboolean
-fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **error)
+void
+fu_device_list_set_concurrent_replug (FuDeviceList *self, gboolean concurrent_replug)
+{
+	g_return_if_fail (FU_IS_DEVICE_LIST (self));
+	self->concurrent_replug = concurrent_replug;
+}
+
+static gboolean
+fu_device_list_wait_for_replug_internal (FuDeviceList *self, FuDevice *device, GError **error)
 {
 	FuDeviceItem *item;
+	FuDeviceListReplugWaiter waiter = { NULL };
 	guint remove_delay;
-	guint wait_removed;
-	guint wait_removed_old = 0;
+	g_autoptr(FuDevice) device_orig = NULL;
 	g_autoptr(GTimer) timer = g_timer_new ();
 
 	g_return_val_if_fail (FU_IS_DEVICE_LIST (self), FALSE);
@@ -786,8 +1171,9 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 		return TRUE;
 	}
 
-	/* check that no other devices are waiting for replug too */
-	for (guint i = 0; i < self->devices->len; i++) {
+	/* check that no other devices are waiting for replug too, unless
+	 * they are being updated at the same time */
+	for (guint i = 0; i < self->devices->len && !self->concurrent_replug; i++) {
 		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
 		if (item_tmp->device != device &&
 		    fu_device_has_flag (item_tmp->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
@@ -811,21 +1197,41 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 		g_debug ("waiting %ums for replug", remove_delay);
 	}
 
-	/* time to unplug and then re-plug */
-	do {
-		/* count how many devices are in the remove waiting state */
-		wait_removed = fu_device_list_devices_wait_removed (self);
-		if (wait_removed != wait_removed_old) {
-			g_debug ("devices in wait_removed: %u -> %u",
-				 wait_removed_old, wait_removed);
-			wait_removed_old = wait_removed;
-		}
-		g_usleep (1000);
-		g_main_context_iteration (NULL, FALSE);
-		if (!fu_device_has_flag (item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG) &&
-		    wait_removed == 0)
-			break;
-	} while (g_timer_elapsed (timer, NULL) * 1000.f < remove_delay);
+	/* time to unplug and then re-plug, waking up only when something changes */
+	waiter.self = self;
+	waiter.item = item;
+	waiter.loop = g_main_loop_new (NULL, FALSE);
+	device_orig = g_object_ref (item->device);
+	g_signal_connect (self, "added",
+			  G_CALLBACK (fu_device_list_replug_waiter_device_cb), &waiter);
+	g_signal_connect (self, "removed",
+			  G_CALLBACK (fu_device_list_replug_waiter_removed_cb), &waiter);
+	g_signal_connect (self, "changed",
+			  G_CALLBACK (fu_device_list_replug_waiter_device_cb), &waiter);
+	g_signal_connect (device_orig, "notify::flags",
+			  G_CALLBACK (fu_device_list_replug_waiter_notify_cb), &waiter);
+	waiter.timeout_id = g_timeout_add (remove_delay,
+					   fu_device_list_replug_waiter_timeout_cb,
+					   &waiter);
+	fu_device_list_replug_waiter_check (&waiter);
+	while (!waiter.done && waiter.timeout_id != 0)
+		g_main_loop_run (waiter.loop);
+	if (waiter.timeout_id != 0)
+		g_source_remove (waiter.timeout_id);
+	g_signal_handlers_disconnect_by_data (self, &waiter);
+	g_signal_handlers_disconnect_by_data (device_orig, &waiter);
+	g_main_loop_unref (waiter.loop);
+
+	/* device was removed for good */
+	if (waiter.item == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_FOUND,
+			     "device %s did not come back",
+			     fu_device_get_id (device));
+		fu_device_remove_flag (device_orig, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG);
+		return FALSE;
+	}
 
 	/* device was not added back to the device list */
 	if (fu_device_has_flag (item->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
@@ -839,7 +1245,7 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 	}
 
 	/* check that no other devices are waiting for replug instead */
-	for (guint i = 0; i < self->devices->len; i++) {
+	for (guint i = 0; i < self->devices->len && !self->concurrent_replug; i++) {
 		FuDeviceItem *item_tmp = g_ptr_array_index (self->devices, i);
 		if (fu_device_has_flag (item_tmp->device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
 			g_warning ("%s is wait-for-replug when %s performed",
@@ -848,11 +1254,39 @@ fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **e
 		}
 	}
 
-	/* the loop was quit without the timer */
-	g_debug ("waited for replug");
+	/* record how long it actually took so the delay can be tuned */
+	g_debug ("waited %.0fms for replug of %ums allowed",
+		 g_timer_elapsed (timer, NULL) * 1000.f, remove_delay);
+	fu_device_set_metadata_integer (item->device, "ReplugDuration",
+					(guint) (g_timer_elapsed (timer, NULL) * 1000.f));
 	return TRUE;
 }
 
+/**
+ * fu_device_list_wait_for_replug:
+ * @self: A #FuDeviceList
+ * @device: A #FuDevice
+ * @error: A #GError, or %NULL
+ *
+ * Waits for a specific device to replug if %FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG
+ * is set.
+ *
+ * If the device does not exist this function returns without an error.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 1.1.2
+ **/
+gboolean
+fu_device_list_wait_for_replug (FuDeviceList *self, FuDevice *device, GError **error)
+{
+	gboolean ret;
+	FU_USDT_PROBE1 (replug__start, fu_device_get_id (device));
+	ret = fu_device_list_wait_for_replug_internal (self, device, error);
+	FU_USDT_PROBE2 (replug__done, fu_device_get_id (device), ret);
+	return ret;
+}
+
 /**
  * fu_device_list_get_by_id:
  * @self: A #FuDeviceList
@@ -939,7 +1373,15 @@ static void
 fu_device_list_init (FuDeviceList *self)
 {
 	self->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_list_item_free);
+	self->index_ids = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_device_index_entry_free);
+	self->index_guids = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						   (GDestroyNotify) fwupd_intern_unref,
+						   (GDestroyNotify) g_ptr_array_unref);
+	self->index_connections = g_hash_table_new_full (g_str_hash, g_str_equal,
+							 g_free, (GDestroyNotify) g_ptr_array_unref);
 	g_rw_lock_init (&self->devices_mutex);
+	g_mutex_init (&self->index_mutex);
+	g_mutex_init (&self->snapshot_mutex);
 }
 
 static void
@@ -948,6 +1390,15 @@ fu_device_list_finalize (GObject *obj)
 	FuDeviceList *self = FU_DEVICE_LIST (obj);
 
 	g_rw_lock_clear (&self->devices_mutex);
+	g_mutex_clear (&self->index_mutex);
+	g_mutex_clear (&self->snapshot_mutex);
+	if (self->snapshot_all != NULL)
+		g_ptr_array_unref (self->snapshot_all);
+	if (self->snapshot_active != NULL)
+		g_ptr_array_unref (self->snapshot_active);
+	g_ptr_array_unref (self->index_ids);
+	g_hash_table_unref (self->index_guids);
+	g_hash_table_unref (self->index_connections);
 	g_ptr_array_unref (self->devices);
 
 	G_OBJECT_CLASS (fu_device_list_parent_class)->finalize (obj);
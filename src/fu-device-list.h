@@ -28,6 +28,8 @@ FuDevice	*fu_device_list_get_by_id		(FuDeviceList	*self,
 FuDevice	*fu_device_list_get_by_guid		(FuDeviceList	*self,
 							 const gchar	*guid,
 							 GError		**error);
+void		 fu_device_list_set_concurrent_replug	(FuDeviceList	*self,
+							 gboolean	 concurrent_replug);
 gboolean	 fu_device_list_wait_for_replug		(FuDeviceList	*self,
 							 FuDevice	*device,
 							 GError		**error);
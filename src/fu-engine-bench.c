@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#include "config.h"
+
+#include <xmlb.h>
+#include <fwupd.h>
+#include <fwupdplugin.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fu-engine.h"
+#include "fu-history.h"
+#include "fu-plugin-list.h"
+#include "fu-plugin-private.h"
+
+typedef struct {
+	guint		 devices;
+	guint		 children;
+	guint		 guids;
+	guint		 releases;
+	guint		 plugins;
+	guint		 repeat;
+	gboolean	 proxies;
+	GPtrArray	*ops;		/* element-type FuEngineBenchOp */
+} FuEngineBench;
+
+typedef struct {
+	gchar		*id;
+	GArray		*samples;	/* element-type gdouble, ms */
+} FuEngineBenchOp;
+
+static void
+fu_engine_bench_op_free (FuEngineBenchOp *op)
+{
+	g_free (op->id);
+	g_array_unref (op->samples);
+	g_free (op);
+}
+
+static void
+fu_engine_bench_add_sample (FuEngineBench *self, const gchar *id, GTimer *timer)
+{
+	FuEngineBenchOp *op = NULL;
+	gdouble elapsed = g_timer_elapsed (timer, NULL) * 1000.f;
+
+	for (guint i = 0; i < self->ops->len; i++) {
+		FuEngineBenchOp *op_tmp = g_ptr_array_index (self->ops, i);
+		if (g_strcmp0 (op_tmp->id, id) == 0) {
+			op = op_tmp;
+			break;
+		}
+	}
+	if (op == NULL) {
+		op = g_new0 (FuEngineBenchOp, 1);
+		op->id = g_strdup (id);
+		op->samples = g_array_new (FALSE, FALSE, sizeof(gdouble));
+		g_ptr_array_add (self->ops, op);
+	}
+	g_array_append_val (op->samples, elapsed);
+}
+
+static void
+fu_engine_bench_free (FuEngineBench *self)
+{
+	if (self->ops != NULL)
+		g_ptr_array_unref (self->ops);
+	g_free (self);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineBench, fu_engine_bench_free)
+
+static gint
+fu_engine_bench_sort_cb (gconstpointer a, gconstpointer b)
+{
+	gdouble da = *((const gdouble *) a);
+	gdouble db = *((const gdouble *) b);
+	if (da < db)
+		return -1;
+	if (da > db)
+		return 1;
+	return 0;
+}
+
+static gdouble
+fu_engine_bench_percentile (GArray *samples, guint pc)
+{
+	guint idx = MIN ((samples->len * pc) / 100, samples->len - 1);
+	return g_array_index (samples, gdouble, idx);
+}
+
+static void
+fu_engine_bench_report (FuEngineBench *self)
+{
+	g_print ("%-16s %8s %10s %10s %10s %10s\n",
+		 "Operation", "Samples", "p50/ms", "p90/ms", "p99/ms", "max/ms");
+	for (guint i = 0; i < self->ops->len; i++) {
+		FuEngineBenchOp *op = g_ptr_array_index (self->ops, i);
+		g_array_sort (op->samples, fu_engine_bench_sort_cb);
+		g_print ("%-16s %8u %10.3f %10.3f %10.3f %10.3f\n",
+			 op->id, op->samples->len,
+			 fu_engine_bench_percentile (op->samples, 50),
+			 fu_engine_bench_percentile (op->samples, 90),
+			 fu_engine_bench_percentile (op->samples, 99),
+			 fu_engine_bench_percentile (op->samples, 100));
+	}
+}
+
+/* this has to match the instance IDs created by the test plugin */
+static void
+fu_engine_bench_metadata_add_component (FuEngineBench *self,
+					GString *xml,
+					const gchar *instance_id)
+{
+	g_autofree gchar *devid = g_strdup_printf ("%s&GUID_00", instance_id);
+	g_autofree gchar *guid = fwupd_guid_hash_string (devid);
+	g_string_append (xml, "  <component type=\"firmware\">\n");
+	g_string_append_printf (xml, "    <id>com.acme.fleet.%s</id>\n", guid);
+	g_string_append (xml, "    <name>Fleet Device</name>\n");
+	g_string_append (xml, "    <provides>\n");
+	g_string_append_printf (xml, "      <firmware type=\"flashed\">%s</firmware>\n", guid);
+	g_string_append (xml, "    </provides>\n");
+	g_string_append (xml, "    <releases>\n");
+	for (guint j = self->releases; j > 0; j--) {
+		g_autofree gchar *csum = NULL;
+		g_autofree gchar *tmp = g_strdup_printf ("%s:%u", guid, j);
+		csum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, tmp, -1);
+		g_string_append_printf (xml, "      <release version=\"1.0.%u\" date=\"2021-01-01\">\n", j);
+		g_string_append (xml, "        <size type=\"installed\">123</size>\n");
+		g_string_append (xml, "        <size type=\"download\">456</size>\n");
+		g_string_append_printf (xml, "        <location>https://example.com/%s.cab</location>\n", csum);
+		g_string_append_printf (xml, "        <checksum filename=\"%s.cab\" target=\"container\" type=\"sha1\">%s</checksum>\n", csum, csum);
+		g_string_append (xml, "      </release>\n");
+	}
+	g_string_append (xml, "    </releases>\n");
+	g_string_append (xml, "  </component>\n");
+}
+
+static XbSilo *
+fu_engine_bench_build_silo (FuEngineBench *self, GError **error)
+{
+	g_autoptr(GString) xml = g_string_new ("<components>\n");
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+
+	for (guint i = 0; i < self->devices; i++) {
+		g_autofree gchar *id = g_strdup_printf ("TEST\\DEV_%04u", i);
+		fu_engine_bench_metadata_add_component (self, xml, id);
+		for (guint j = 0; j < self->children; j++) {
+			g_autofree gchar *id_child = g_strdup_printf ("%s&CHILD_%02u", id, j);
+			fu_engine_bench_metadata_add_component (self, xml, id_child);
+		}
+	}
+	g_string_append (xml, "</components>\n");
+	if (!xb_builder_source_load_xml (source, xml->str,
+					 XB_BUILDER_SOURCE_FLAG_NONE,
+					 error))
+		return NULL;
+	xb_builder_import_source (builder, source);
+	return xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+}
+
+static FuEngine *
+fu_engine_bench_load (FuEngineBench *self, XbSilo *silo, GError **error)
+{
+	g_autofree gchar *pluginfn = NULL;
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+	g_autoptr(GTimer) timer = NULL;
+
+	pluginfn = g_build_filename (PLUGINBUILDDIR,
+				     "libfu_plugin_test." G_MODULE_SUFFIX,
+				     NULL);
+	if (!fu_plugin_open (plugin, pluginfn, error))
+		return NULL;
+	fu_engine_add_plugin (engine, plugin);
+	fu_engine_set_silo (engine, silo);
+
+	timer = g_timer_new ();
+	if (!fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_COLDPLUG, error))
+		return NULL;
+	fu_engine_bench_add_sample (self, "load", timer);
+	return g_steal_pointer (&engine);
+}
+
+/* a synthetic graph where each plugin has a few rules on its neighbours */
+static FuPluginList *
+fu_engine_bench_build_plugin_list (FuEngineBench *self)
+{
+	FuPluginList *plugin_list = fu_plugin_list_new ();
+	for (guint i = 0; i < self->plugins; i++) {
+		g_autofree gchar *name = g_strdup_printf ("plugin%04u", i);
+		g_autoptr(FuPlugin) plugin = fu_plugin_new ();
+		fu_plugin_set_name (plugin, name);
+		if (i > 0) {
+			g_autofree gchar *prev = g_strdup_printf ("plugin%04u", i - 1);
+			g_autofree gchar *half = g_strdup_printf ("plugin%04u", i / 2);
+			fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_RUN_AFTER, prev);
+			fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_RUN_AFTER, half);
+			if (i % 10 == 0)
+				fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_BETTER_THAN, prev);
+		}
+		if (i + 3 < self->plugins) {
+			g_autofree gchar *next = g_strdup_printf ("plugin%04u", i + 3);
+			fu_plugin_add_rule (plugin, FU_PLUGIN_RULE_RUN_BEFORE, next);
+		}
+		fu_plugin_list_add (plugin_list, plugin);
+	}
+	return plugin_list;
+}
+
+static gboolean
+fu_engine_bench_run (FuEngineBench *self, GError **error)
+{
+	guint32 version_raw = 0x01000000 + self->releases;
+	g_autofree gchar *version = NULL;
+	g_autofree gchar *version_str = g_strdup_printf ("0x%x", version_raw);
+	g_autoptr(FuEngine) engine = NULL;
+	g_autoptr(FuEngineRequest) request = fu_engine_request_new ();
+	g_autoptr(FuHistory) history = fu_history_new ();
+	g_autoptr(FwupdRelease) release = fwupd_release_new ();
+	g_autoptr(GBytes) blob_fw = g_bytes_new (version_str, strlen (version_str) + 1);
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* plugin ordering */
+	for (guint i = 0; i < self->repeat; i++) {
+		g_autoptr(FuPluginList) plugin_list = fu_engine_bench_build_plugin_list (self);
+		g_timer_reset (timer);
+		if (!fu_plugin_list_depsolve (plugin_list, error))
+			return FALSE;
+		fu_engine_bench_add_sample (self, "plugin-depsolve", timer);
+	}
+
+	/* generate the metadata */
+	silo = fu_engine_bench_build_silo (self, error);
+	if (silo == NULL)
+		return FALSE;
+
+	/* startup, keeping the last engine */
+	for (guint i = 0; i < self->repeat; i++) {
+		g_clear_object (&engine);
+		engine = fu_engine_bench_load (self, silo, error);
+		if (engine == NULL)
+			return FALSE;
+	}
+
+	/* GetDevices */
+	for (guint i = 0; i < self->repeat; i++) {
+		g_clear_pointer (&devices, g_ptr_array_unref);
+		g_timer_reset (timer);
+		devices = fu_engine_get_devices (engine, error);
+		if (devices == NULL)
+			return FALSE;
+		fu_engine_bench_add_sample (self, "get-devices", timer);
+	}
+	g_printerr ("%u devices\n", devices->len);
+
+	/* GetUpgrades for each device */
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_autoptr(GPtrArray) releases = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_timer_reset (timer);
+		releases = fu_engine_get_upgrades (engine, request,
+						   fu_device_get_id (device),
+						   &error_local);
+		if (releases == NULL) {
+			g_debug ("no upgrades for %s: %s",
+				 fu_device_get_id (device),
+				 error_local->message);
+			continue;
+		}
+		fu_engine_bench_add_sample (self, "get-upgrades", timer);
+	}
+
+	/* install the newest version on each device */
+	version = fu_common_version_from_uint32 (version_raw, FWUPD_VERSION_FORMAT_TRIPLET);
+	fwupd_release_set_version (release, version);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		g_timer_reset (timer);
+		if (!fu_engine_install_blob (engine, device, blob_fw,
+					     FWUPD_INSTALL_FLAG_NONE, error))
+			return FALSE;
+		fu_engine_bench_add_sample (self, "install-blob", timer);
+
+		/* record it like fu_engine_install() would */
+		g_timer_reset (timer);
+		fu_device_set_update_state (device, FWUPD_UPDATE_STATE_SUCCESS);
+		if (!fu_history_add_device (history, device, release, error))
+			return FALSE;
+		fu_engine_bench_add_sample (self, "history-add", timer);
+	}
+
+	/* GetHistory */
+	for (guint i = 0; i < self->repeat; i++) {
+		g_autoptr(GPtrArray) history_devices = NULL;
+		g_timer_reset (timer);
+		history_devices = fu_engine_get_history (engine, error);
+		if (history_devices == NULL)
+			return FALSE;
+		fu_engine_bench_add_sample (self, "get-history", timer);
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static void
+fu_engine_bench_mkroot (void)
+{
+	if (g_file_test ("/tmp/fwupd-engine-bench", G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) error = NULL;
+		if (!fu_common_rmtree ("/tmp/fwupd-engine-bench", &error))
+			g_warning ("failed to mkroot: %s", error->message);
+	}
+	g_mkdir_with_parents ("/tmp/fwupd-engine-bench/var/lib/fwupd", 0755);
+}
+
+int
+main (int argc, char **argv)
+{
+	gboolean proxies = FALSE;
+	gint children = 0;
+	gint devices = 200;
+	gint guids = 1;
+	gint plugins = 500;
+	gint releases = 5;
+	gint repeat = 10;
+	g_autofree gchar *tmp = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GOptionContext) context = g_option_context_new (NULL);
+	g_autoptr(FuEngineBench) self = g_new0 (FuEngineBench, 1);
+	const GOptionEntry options[] = {
+		{ "devices", 'd', 0, G_OPTION_ARG_INT, &devices,
+			"Number of top-level devices to create", NULL },
+		{ "children", 'c', 0, G_OPTION_ARG_INT, &children,
+			"Number of children for each device", NULL },
+		{ "guids", 'g', 0, G_OPTION_ARG_INT, &guids,
+			"Number of GUIDs for each device", NULL },
+		{ "proxies", 'p', 0, G_OPTION_ARG_NONE, &proxies,
+			"Use the parent as the proxy for each child", NULL },
+		{ "releases", 'r', 0, G_OPTION_ARG_INT, &releases,
+			"Number of releases in the metadata for each device", NULL },
+		{ "plugins", '\0', 0, G_OPTION_ARG_INT, &plugins,
+			"Number of synthetic plugins to depsolve", NULL },
+		{ "repeat", '\0', 0, G_OPTION_ARG_INT, &repeat,
+			"Number of times to repeat the engine-wide operations", NULL },
+		{ NULL}
+	};
+
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	if (devices < 1 || children < 0 || guids < 1 || releases < 1 || plugins < 1 || repeat < 1) {
+		g_printerr ("Invalid arguments\n");
+		return EXIT_FAILURE;
+	}
+	self->devices = devices;
+	self->children = children;
+	self->guids = guids;
+	self->releases = releases;
+	self->plugins = plugins;
+	self->repeat = repeat;
+	self->proxies = proxies;
+	self->ops = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_bench_op_free);
+
+	/* use the self test data, but a private state directory */
+	g_setenv ("FWUPD_DATADIR", TESTDATADIR_SRC, TRUE);
+	g_setenv ("FWUPD_PLUGINDIR", TESTDATADIR_SRC, TRUE);
+	g_setenv ("FWUPD_SYSCONFDIR", TESTDATADIR_SRC, TRUE);
+	g_setenv ("FWUPD_SYSFSFWDIR", TESTDATADIR_SRC, TRUE);
+	g_setenv ("FWUPD_LOCALSTATEDIR", "/tmp/fwupd-engine-bench/var", TRUE);
+	g_setenv ("CONFIGURATION_DIRECTORY", TESTDATADIR_SRC, TRUE);
+	fu_engine_bench_mkroot ();
+
+	/* the test plugin creates the devices */
+	g_setenv ("FWUPD_PLUGIN_TEST", "fleet", TRUE);
+	tmp = g_strdup_printf ("%u", self->devices);
+	g_setenv ("FWUPD_PLUGIN_TEST_DEVICES", tmp, TRUE);
+	g_free (tmp);
+	tmp = g_strdup_printf ("%u", self->children);
+	g_setenv ("FWUPD_PLUGIN_TEST_CHILDREN", tmp, TRUE);
+	g_free (tmp);
+	tmp = g_strdup_printf ("%u", self->guids);
+	g_setenv ("FWUPD_PLUGIN_TEST_GUIDS", tmp, TRUE);
+	if (self->proxies)
+		g_setenv ("FWUPD_PLUGIN_TEST_PROXIES", "1", TRUE);
+
+	if (!fu_engine_bench_run (self, &error)) {
+		g_printerr ("Failed to run benchmark: %s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	fu_engine_bench_report (self);
+	return EXIT_SUCCESS;
+}
@@ -15,10 +15,14 @@ struct _FuEngineRequest
 	GObject			 parent_instance;
 	FwupdFeatureFlags	 feature_flags;
 	FwupdDeviceFlags	 device_flags;
+	gchar			*id;
+	gint64			 start;		/* monotonic */
 };
 
 G_DEFINE_TYPE (FuEngineRequest, fu_engine_request, G_TYPE_OBJECT)
 
+static gint fu_engine_request_cnt = 0;
+
 FwupdFeatureFlags
 fu_engine_request_get_feature_flags (FuEngineRequest *self)
 {
@@ -49,16 +53,57 @@ fu_engine_request_set_device_flags (FuEngineRequest *self,
 	self->device_flags = device_flags;
 }
 
+/* used to link the log, history and metrics to the caller */
+const gchar *
+fu_engine_request_get_id (FuEngineRequest *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE_REQUEST (self), NULL);
+	return self->id;
+}
+
+void
+fu_engine_request_set_id (FuEngineRequest *self, const gchar *id)
+{
+	g_return_if_fail (FU_IS_ENGINE_REQUEST (self));
+	g_return_if_fail (id != NULL);
+	if (g_strcmp0 (self->id, id) == 0)
+		return;
+	g_free (self->id);
+	self->id = g_strdup (id);
+}
+
+/* in ms since the request was created */
+gdouble
+fu_engine_request_get_elapsed (FuEngineRequest *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE_REQUEST (self), 0.f);
+	return (gdouble) (g_get_monotonic_time () - self->start) / 1000.f;
+}
+
 static void
 fu_engine_request_init (FuEngineRequest *self)
 {
 	self->device_flags = FWUPD_DEVICE_FLAG_NONE;
 	self->feature_flags = FWUPD_FEATURE_FLAG_NONE;
+	self->start = g_get_monotonic_time ();
+
+	/* unique in this process unless the caller provides one */
+	self->id = g_strdup_printf ("%u", (guint) g_atomic_int_add (&fu_engine_request_cnt, 1) + 1);
+}
+
+static void
+fu_engine_request_finalize (GObject *obj)
+{
+	FuEngineRequest *self = FU_ENGINE_REQUEST (obj);
+	g_free (self->id);
+	G_OBJECT_CLASS (fu_engine_request_parent_class)->finalize (obj);
 }
 
 static void
 fu_engine_request_class_init (FuEngineRequestClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_engine_request_finalize;
 }
 
 FuEngineRequest *
@@ -18,3 +18,7 @@ void			 fu_engine_request_set_feature_flags	(FuEngineRequest	*self,
 FwupdDeviceFlags	 fu_engine_request_get_device_flags	(FuEngineRequest	*self);
 void			 fu_engine_request_set_device_flags	(FuEngineRequest	*self,
 								 FwupdDeviceFlags	 device_flags);
+const gchar		*fu_engine_request_get_id		(FuEngineRequest	*self);
+void			 fu_engine_request_set_id		(FuEngineRequest	*self,
+								 const gchar		*id);
+gdouble			 fu_engine_request_get_elapsed		(FuEngineRequest	*self);
@@ -9,6 +9,8 @@
 #include "config.h"
 
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
 #ifdef HAVE_GIO_UNIX
 #include <gio/gunixinputstream.h>
 #endif
@@ -18,8 +20,13 @@
 #include <sys/utsname.h>
 #endif
 #include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 #include "fwupd-common-private.h"
+#include "fwupd-device-private.h"
 #include "fwupd-enums-private.h"
 #include "fwupd-error.h"
 #include "fwupd-release-private.h"
@@ -29,11 +36,14 @@
 
 #include "fu-cabinet.h"
 #include "fu-common-cab.h"
+#include "fu-common-jcat.h"
 #include "fu-common.h"
 #include "fu-config.h"
 #include "fu-debug.h"
+#include "fu-decompressor.h"
 #include "fu-device-list.h"
 #include "fu-device-private.h"
+#include "fu-efivar.h"
 #include "fu-engine.h"
 #include "fu-engine-helper.h"
 #include "fu-engine-request.h"
@@ -42,16 +52,19 @@
 #include "fu-keyring-utils.h"
 #include "fu-hash.h"
 #include "fu-history.h"
+#include "fu-metrics.h"
 #include "fu-mutex.h"
 #include "fu-plugin.h"
 #include "fu-plugin-list.h"
 #include "fu-plugin-private.h"
+#include "fu-profile.h"
 #include "fu-quirks.h"
 #include "fu-remote-list.h"
 #include "fu-security-attr.h"
 #include "fu-security-attrs-private.h"
 #include "fu-smbios-private.h"
 #include "fu-udev-device-private.h"
+#include "fu-usdt-private.h"
 
 #ifdef HAVE_GUDEV
 #include "fu-udev-backend.h"
@@ -79,6 +92,73 @@
 static void fu_engine_finalize	 (GObject *obj);
 static void fu_engine_ensure_security_attrs	(FuEngine *self);
 
+/* 1ms, 2ms, 4ms … 1024ms and then everything slower */
+#define FU_ENGINE_HOTPLUG_LATENCY_BUCKETS	12
+
+typedef enum {
+	FU_ENGINE_HOTPLUG_STAGE_QUEUE,		/* waiting for a plugin worker */
+	FU_ENGINE_HOTPLUG_STAGE_SETUP,		/* plugin probe and setup */
+	FU_ENGINE_HOTPLUG_STAGE_PUBLISH,	/* adding to the device list */
+	FU_ENGINE_HOTPLUG_STAGE_TOTAL,
+	FU_ENGINE_HOTPLUG_STAGE_LAST
+} FuEngineHotplugStage;
+
+/* wall time spent in each part of fu_engine_install_blob(), saved to the history */
+typedef enum {
+	FU_ENGINE_INSTALL_PHASE_PREPARE,
+	FU_ENGINE_INSTALL_PHASE_DETACH,
+	FU_ENGINE_INSTALL_PHASE_WRITE,
+	FU_ENGINE_INSTALL_PHASE_ATTACH,
+	FU_ENGINE_INSTALL_PHASE_RELOAD,
+	FU_ENGINE_INSTALL_PHASE_CLEANUP,
+	FU_ENGINE_INSTALL_PHASE_REPLUG,		/* waiting for any re-enumeration */
+	FU_ENGINE_INSTALL_PHASE_LAST
+} FuEngineInstallPhase;
+
+/* parsed and verified archives kept for repeated installs of the same file */
+#define FU_ENGINE_CABINET_CACHE_SIZE_MAX	(64 * 1024 * 1024)
+#define FU_ENGINE_VERIFY_PACE			60 /* s */
+#define FU_ENGINE_VERIFY_IDLE_MIN		300 /* s */
+#define FU_ENGINE_HISTORY_PRUNE_PACE		3600 /* s */
+#define FU_ENGINE_DEVICE_CHANGED_DELAY		100 /* ms */
+
+typedef struct {
+	gchar			*checksum;	/* SHA256 of the archive */
+	XbSilo			*silo;
+	gsize			 size;
+	gint64			 atime;		/* monotonic, in usec */
+	gchar			*details_fingerprint;	/* (nullable) */
+	GPtrArray		*details;	/* (nullable) (element-type FuDevice) */
+} FuEngineCabinetCacheItem;
+
+typedef struct {
+	FuEngine		*self;		/* no ref */
+	FuDevice		*device;
+	GPtrArray		*plugins;	/* (element-type FuPlugin) */
+	gint64			 queued;	/* monotonic, in usec */
+	gint64			 started;
+	gint64			 finished;
+	GSource			*source;	/* (nullable) */
+	gboolean		 cancelled;
+} FuEngineHotplugJob;
+
+static void fu_engine_hotplug_job_free	(FuEngineHotplugJob *job);
+
+typedef struct {
+	GMutex			 mutex;		/* held while a job is running */
+	guint			 pending;	/* protected by FuEngine->job_mutex */
+} FuEngineJobLock;
+
+typedef struct {
+	FuEngineJobFunc		 func;
+	gpointer		 user_data;
+	gchar			*device_id;
+	gchar			*lock_id;
+	FuEngineJobLock		*lock;
+} FuEngineJob;
+
+static gboolean fu_engine_job_is_pending (FuEngine *self, FuDevice *device);
+
 struct _FuEngine
 {
 	GObject			 parent_instance;
@@ -92,13 +172,26 @@ struct _FuEngine
 	guint			 percentage;
 	FuHistory		*history;
 	FuIdle			*idle;
-	XbSilo			*silo;
+	GHashTable		*silos_remote;	/* remote-id : XbSilo */
+	GPtrArray		*silos;		/* of XbSilo, in remote priority order */
+	guint			 silos_generation;	/* bumped when @silos is rebuilt */
+	GPtrArray		*silos_guids;	/* of GHashTable (guid : XbNode components), matching @silos */
+	GPtrArray		*cabinet_cache;	/* of FuEngineCabinetCacheItem */
 	gboolean		 coldplug_running;
 	guint			 coldplug_id;
 	guint			 coldplug_delay;
+	GThread			*main_thread;
+	GPtrArray		*install_devices;	/* (nullable) (element-type FuDevice) */
+	GAsyncQueue		*coldplug_events;	/* (element-type FuEngineColdplugEvent) */
+	GHashTable		*hotplug_pools;		/* plugin-name : GThreadPool */
+	GPtrArray		*hotplug_jobs;		/* (element-type FuEngineHotplugJob) */
+	guint			 hotplug_latency[FU_ENGINE_HOTPLUG_STAGE_LAST][FU_ENGINE_HOTPLUG_LATENCY_BUCKETS];
 	FuPluginList		*plugin_list;
 	GPtrArray		*plugin_filter;
+	GHashTable		*plugins_deferred;	/* plugin-name : filename */
+	const FuPluginBuiltin	*plugin_builtins;	/* (nullable): linked into the daemon */
 	GPtrArray		*udev_subsystems;
+	GHashTable		*os_release;		/* (nullable): loaded on first use */
 	FuSmbios		*smbios;
 	FuHwids			*hwids;
 	FuQuirks		*quirks;
@@ -106,12 +199,34 @@ struct _FuEngine
 	GHashTable		*compile_versions;
 	GHashTable		*approved_firmware;	/* (nullable) */
 	GHashTable		*blocked_firmware;	/* (nullable) */
+	guint			 releases_generation;	/* bumped when cached releases are stale */
+	guint			 devices_generation;	/* bumped when a device is added, removed or changed */
 	GHashTable		*firmware_gtypes;
 	gchar			*host_machine_id;
 	JcatContext		*jcat_context;
+	GPtrArray		*pki_monitors;	/* (element-type GFileMonitor) */
 	gboolean		 loaded;
+	gboolean		 offline_plan;	/* only the plugins for the offline update */
+	FuEngineLoadFlags	 load_flags;
+	FuProfile		*profile;
+	FuMetrics		*metrics;
+	GPtrArray		*devices_cached;	/* (nullable) (element-type FwupdDevice) */
 	gchar			*host_security_id;
 	FuSecurityAttrs		*host_security_attrs;
+	GVariant		*host_security_variant;	/* (nullable) */
+	guint64			 host_security_generation;
+	GHashTable		*security_attrs_cache;	/* plugin-name : FuSecurityAttrs */
+	GHashTable		*device_changed_pending;	/* FuDevice : FuDevice */
+	guint			 device_changed_id;
+	FuEngineInstallPhase	 install_phase;
+	FuEngineRequest		*install_request;	/* (nullable) (not owned) */
+	gint64			 install_phase_start;
+	gint64			 install_timings[FU_ENGINE_INSTALL_PHASE_LAST];	/* us */
+	guint			 verify_id;
+	GHashTable		*verify_unsupported;	/* device-id */
+	guint			 history_prune_id;
+	GMutex			 job_mutex;
+	GHashTable		*job_locks;		/* lock-id : FuEngineJobLock */
 };
 
 enum {
@@ -121,6 +236,7 @@ enum {
 	SIGNAL_DEVICE_CHANGED,
 	SIGNAL_STATUS_CHANGED,
 	SIGNAL_PERCENTAGE_CHANGED,
+	SIGNAL_SECURITY_CHANGED,
 	SIGNAL_LAST
 };
 
@@ -128,9 +244,95 @@ static guint signals[SIGNAL_LAST] = { 0 };
 
 G_DEFINE_TYPE (FuEngine, fu_engine, G_TYPE_OBJECT)
 
+typedef enum {
+	FU_ENGINE_MAIN_EVENT_CHANGED,
+	FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED,
+	FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED_DELAYED,
+	FU_ENGINE_MAIN_EVENT_STATUS,
+	FU_ENGINE_MAIN_EVENT_PERCENTAGE,
+	FU_ENGINE_MAIN_EVENT_LAST
+} FuEngineMainEventKind;
+
+typedef struct {
+	FuEngine			*self;
+	FuEngineMainEventKind		 kind;
+	FuDevice			*device;	/* (nullable) */
+	guint				 value;
+} FuEngineMainEvent;
+
+static void fu_engine_emit_changed			(FuEngine	*self);
+static void fu_engine_emit_device_changed		(FuEngine	*self,
+							 FuDevice	*device);
+static void fu_engine_emit_device_changed_delayed	(FuEngine	*self,
+							 FuDevice	*device);
+static void fu_engine_set_status			(FuEngine	*self,
+							 FwupdStatus	 status);
+static void fu_engine_set_percentage			(FuEngine	*self,
+							 guint		 percentage);
+
+static void
+fu_engine_main_event_free (FuEngineMainEvent *event)
+{
+	if (event->device != NULL)
+		g_object_unref (event->device);
+	g_object_unref (event->self);
+	g_free (event);
+}
+
+static gboolean
+fu_engine_main_event_cb (gpointer user_data)
+{
+	FuEngineMainEvent *event = (FuEngineMainEvent *) user_data;
+	switch (event->kind) {
+	case FU_ENGINE_MAIN_EVENT_CHANGED:
+		fu_engine_emit_changed (event->self);
+		break;
+	case FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED:
+		fu_engine_emit_device_changed (event->self, event->device);
+		break;
+	case FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED_DELAYED:
+		fu_engine_emit_device_changed_delayed (event->self, event->device);
+		break;
+	case FU_ENGINE_MAIN_EVENT_STATUS:
+		fu_engine_set_status (event->self, event->value);
+		break;
+	case FU_ENGINE_MAIN_EVENT_PERCENTAGE:
+		fu_engine_set_percentage (event->self, event->value);
+		break;
+	default:
+		break;
+	}
+	return G_SOURCE_REMOVE;
+}
+
+/* signal handlers such as the D-Bus exports are not thread safe, so anything
+ * emitted from a worker thread is replayed in the main context instead */
+static gboolean
+fu_engine_main_event_defer (FuEngine *self,
+			    FuEngineMainEventKind kind,
+			    FuDevice *device,
+			    guint value)
+{
+	FuEngineMainEvent *event;
+	if (g_thread_self () == self->main_thread)
+		return FALSE;
+	event = g_new0 (FuEngineMainEvent, 1);
+	event->self = g_object_ref (self);
+	event->kind = kind;
+	if (device != NULL)
+		event->device = g_object_ref (device);
+	event->value = value;
+	g_main_context_invoke_full (NULL, G_PRIORITY_DEFAULT,
+				    fu_engine_main_event_cb, event,
+				    (GDestroyNotify) fu_engine_main_event_free);
+	return TRUE;
+}
+
 static void
 fu_engine_emit_changed (FuEngine *self)
 {
+	if (fu_engine_main_event_defer (self, FU_ENGINE_MAIN_EVENT_CHANGED, NULL, 0))
+		return;
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 	fu_engine_idle_reset (self);
 
@@ -144,14 +346,132 @@ fu_engine_emit_changed (FuEngine *self)
 	}
 }
 
+/* plugin_name=NULL means every plugin has to be queried again */
+static void
+fu_engine_security_attrs_invalidate (FuEngine *self, const gchar *plugin_name)
+{
+	if (plugin_name == NULL)
+		g_hash_table_remove_all (self->security_attrs_cache);
+	else
+		g_hash_table_remove (self->security_attrs_cache, plugin_name);
+	g_clear_pointer (&self->host_security_id, g_free);
+}
+
 static void
 fu_engine_emit_device_changed (FuEngine *self, FuDevice *device)
 {
+	if (fu_engine_main_event_defer (self, FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED, device, 0))
+		return;
+
+	/* anything queued is superseded */
+	g_hash_table_remove (self->device_changed_pending, device);
+	self->devices_generation++;
+
 	/* invalidate host security attributes */
-	g_clear_pointer (&self->host_security_id, g_free);
+	fu_engine_security_attrs_invalidate (self, fu_device_get_plugin (device));
 	g_signal_emit (self, signals[SIGNAL_DEVICE_CHANGED], 0, device);
 }
 
+static gboolean
+fu_engine_emit_device_changed_delay_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	GHashTableIter iter;
+	gpointer value;
+	g_autoptr(GPtrArray) devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	/* take ownership as emitting may queue more changes */
+	self->device_changed_id = 0;
+	g_hash_table_iter_init (&iter, self->device_changed_pending);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		g_ptr_array_add (devices, value);
+		g_hash_table_iter_steal (&iter);
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_engine_emit_device_changed (self, device);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+/* coalesce frequent changes, e.g. progress, into one signal per device */
+static void
+fu_engine_emit_device_changed_delayed (FuEngine *self, FuDevice *device)
+{
+	if (fu_engine_main_event_defer (self, FU_ENGINE_MAIN_EVENT_DEVICE_CHANGED_DELAYED, device, 0))
+		return;
+	g_hash_table_insert (self->device_changed_pending,
+			     device, g_object_ref (device));
+	if (self->device_changed_id != 0)
+		return;
+	self->device_changed_id = g_timeout_add (FU_ENGINE_DEVICE_CHANGED_DELAY,
+						 fu_engine_emit_device_changed_delay_cb,
+						 self);
+}
+
+static const gchar *
+fu_engine_install_phase_to_string (FuEngineInstallPhase phase)
+{
+	if (phase == FU_ENGINE_INSTALL_PHASE_PREPARE)
+		return "TimingPrepare";
+	if (phase == FU_ENGINE_INSTALL_PHASE_DETACH)
+		return "TimingDetach";
+	if (phase == FU_ENGINE_INSTALL_PHASE_WRITE)
+		return "TimingWrite";
+	if (phase == FU_ENGINE_INSTALL_PHASE_ATTACH)
+		return "TimingAttach";
+	if (phase == FU_ENGINE_INSTALL_PHASE_RELOAD)
+		return "TimingReload";
+	if (phase == FU_ENGINE_INSTALL_PHASE_CLEANUP)
+		return "TimingCleanup";
+	if (phase == FU_ENGINE_INSTALL_PHASE_REPLUG)
+		return "TimingReplug";
+	return NULL;
+}
+
+/* charge the time since the last call to the previous phase */
+static void
+fu_engine_set_install_phase (FuEngine *self, FuEngineInstallPhase phase)
+{
+	gint64 now = g_get_monotonic_time ();
+	if (self->install_phase != FU_ENGINE_INSTALL_PHASE_LAST)
+		self->install_timings[self->install_phase] += now - self->install_phase_start;
+	self->install_phase = phase;
+	self->install_phase_start = now;
+}
+
+static gboolean
+fu_engine_wait_for_replug (FuEngine *self, FuDevice *device, GError **error)
+{
+	FuEngineInstallPhase phase = self->install_phase;
+	gboolean ret;
+
+	/* only count the time when actually installing */
+	if (phase != FU_ENGINE_INSTALL_PHASE_LAST)
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_REPLUG);
+	ret = fu_device_list_wait_for_replug (self->device_list, device, error);
+	if (phase != FU_ENGINE_INSTALL_PHASE_LAST)
+		fu_engine_set_install_phase (self, phase);
+	return ret;
+}
+
+/* in ms, as set by the last call to fu_engine_install_blob() */
+static void
+fu_engine_add_install_timings (FuEngine *self, FwupdRelease *release)
+{
+	if (self->install_request != NULL) {
+		fwupd_release_add_metadata_item (release, "RequestId",
+						 fu_engine_request_get_id (self->install_request));
+	}
+	for (guint i = 0; i < FU_ENGINE_INSTALL_PHASE_LAST; i++) {
+		g_autofree gchar *sz = NULL;
+		sz = g_strdup_printf ("%" G_GINT64_FORMAT, self->install_timings[i] / 1000);
+		fwupd_release_add_metadata_item (release,
+						 fu_engine_install_phase_to_string (i),
+						 sz);
+	}
+}
+
 static gint
 fu_engine_gtypes_sort_cb (gconstpointer a, gconstpointer b)
 {
@@ -203,6 +523,8 @@ fu_engine_get_status (FuEngine *self)
 static void
 fu_engine_set_status (FuEngine *self, FwupdStatus status)
 {
+	if (fu_engine_main_event_defer (self, FU_ENGINE_MAIN_EVENT_STATUS, NULL, status))
+		return;
 	if (self->status == status)
 		return;
 	self->status = status;
@@ -216,6 +538,8 @@ fu_engine_set_status (FuEngine *self, FwupdStatus status)
 static void
 fu_engine_set_percentage (FuEngine *self, guint percentage)
 {
+	if (fu_engine_main_event_defer (self, FU_ENGINE_MAIN_EVENT_PERCENTAGE, NULL, percentage))
+		return;
 	if (self->percentage == percentage)
 		return;
 	self->percentage = percentage;
@@ -229,8 +553,19 @@ fu_engine_progress_notify_cb (FuDevice *device, GParamSpec *pspec, FuEngine *sel
 {
 	if (fu_device_get_status (device) == FWUPD_STATUS_UNKNOWN)
 		return;
-	fu_engine_set_percentage (self, fu_device_get_progress (device));
-	fu_engine_emit_device_changed (self, device);
+
+	/* several devices are being updated at the same time */
+	if (self->install_devices != NULL && self->install_devices->len > 0) {
+		guint total = 0;
+		for (guint i = 0; i < self->install_devices->len; i++) {
+			FuDevice *device_tmp = g_ptr_array_index (self->install_devices, i);
+			total += fu_device_get_progress (device_tmp);
+		}
+		fu_engine_set_percentage (self, total / self->install_devices->len);
+	} else {
+		fu_engine_set_percentage (self, fu_device_get_progress (device));
+	}
+	fu_engine_emit_device_changed_delayed (self, device);
 }
 
 static void
@@ -262,6 +597,7 @@ static void
 fu_engine_device_added_cb (FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
 	fu_engine_watch_device (self, device);
+	self->devices_generation++;
 	g_signal_emit (self, signals[SIGNAL_DEVICE_ADDED], 0, device);
 }
 
@@ -280,6 +616,8 @@ fu_engine_device_removed_cb (FuDeviceList *device_list, FuDevice *device, FuEngi
 {
 	fu_engine_device_runner_device_removed (self, device);
 	g_signal_handlers_disconnect_by_data (device, self);
+	g_hash_table_remove (self->device_changed_pending, device);
+	self->devices_generation++;
 	g_signal_emit (self, signals[SIGNAL_DEVICE_REMOVED], 0, device);
 }
 
@@ -574,20 +912,176 @@ fu_engine_set_release_from_appstream (FuEngine *self,
 	return TRUE;
 }
 
+/* builds the GUID to component posting list for one silo */
+static GHashTable *
+fu_engine_silo_guids_new (XbSilo *silo)
+{
+	GHashTable *silo_guids;
+	g_autoptr(GPtrArray) components = NULL;
+
+	silo_guids = g_hash_table_new_full (g_str_hash, g_str_equal,
+					    g_free, (GDestroyNotify) g_ptr_array_unref);
+	components = xb_silo_query (silo,
+				    "components/component[@type='firmware']",
+				    0, NULL);
+	if (components == NULL)
+		return silo_guids;
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		g_autoptr(GPtrArray) provides = NULL;
+		provides = xb_node_query (component,
+					  "provides/firmware[@type='flashed']",
+					  0, NULL);
+		if (provides == NULL)
+			continue;
+		for (guint j = 0; j < provides->len; j++) {
+			XbNode *provide = g_ptr_array_index (provides, j);
+			const gchar *guid = xb_node_get_text (provide);
+			GPtrArray *postings;
+			if (guid == NULL)
+				continue;
+			postings = g_hash_table_lookup (silo_guids, guid);
+			if (postings == NULL) {
+				postings = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+				g_hash_table_insert (silo_guids, g_strdup (guid), postings);
+			}
+
+			/* a component may list the same GUID more than once */
+			if (postings->len > 0 &&
+			    g_ptr_array_index (postings, postings->len - 1) == component)
+				continue;
+			g_ptr_array_add (postings, g_object_ref (component));
+		}
+	}
+	return silo_guids;
+}
+
+/* builds the container checksum to remote-id index for one silo */
+static GHashTable *
+fu_engine_silo_checksums_new (XbSilo *silo)
+{
+	GHashTable *silo_checksums;
+	g_autoptr(GPtrArray) components = NULL;
+
+	silo_checksums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	components = xb_silo_query (silo,
+				    "components/component[@type='firmware']",
+				    0, NULL);
+	if (components == NULL)
+		return silo_checksums;
+	for (guint i = 0; i < components->len; i++) {
+		XbNode *component = g_ptr_array_index (components, i);
+		const gchar *remote_id;
+		g_autoptr(GPtrArray) csums = NULL;
+
+		csums = xb_node_query (component,
+				       "releases/release/checksum[@target='container']",
+				       0, NULL);
+		if (csums == NULL)
+			continue;
+		remote_id = xb_node_query_text (component,
+						"../custom/value[@key='fwupd::RemoteId']",
+						NULL);
+		if (remote_id == NULL)
+			continue;
+		for (guint j = 0; j < csums->len; j++) {
+			XbNode *csum = g_ptr_array_index (csums, j);
+			const gchar *tmp = xb_node_get_text (csum);
+
+			/* the first component in document order wins */
+			if (tmp == NULL || g_hash_table_contains (silo_checksums, tmp))
+				continue;
+			g_hash_table_insert (silo_checksums, g_strdup (tmp), g_strdup (remote_id));
+		}
+	}
+	return silo_checksums;
+}
+
+/* must be called each time self->silos is changed; the posting list and the
+ * checksum index are attached to the silo so only newly loaded silos get
+ * indexed */
+static void
+fu_engine_silos_guids_rebuild (FuEngine *self)
+{
+	g_ptr_array_set_size (self->silos_guids, 0);
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		GHashTable *silo_guids = g_object_get_data (G_OBJECT (silo), "FuEngine::guids");
+		if (g_object_get_data (G_OBJECT (silo), "FuEngine::checksums") == NULL) {
+			g_object_set_data_full (G_OBJECT (silo), "FuEngine::checksums",
+						fu_engine_silo_checksums_new (silo),
+						(GDestroyNotify) g_hash_table_unref);
+		}
+		if (silo_guids == NULL) {
+			silo_guids = fu_engine_silo_guids_new (silo);
+			g_object_set_data_full (G_OBJECT (silo), "FuEngine::guids", silo_guids,
+						(GDestroyNotify) g_hash_table_unref);
+		}
+		g_ptr_array_add (self->silos_guids, g_hash_table_ref (silo_guids));
+	}
+}
+
+/* returns the firmware components that provide any of the GUIDs, in the same
+ * order as the equivalent XPath union run against each silo in turn */
+static GPtrArray *
+fu_engine_silos_query_guids (FuEngine *self, GPtrArray *guids, guint limit, GError **error)
+{
+	g_autoptr(GPtrArray) results = NULL;
+
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < self->silos_guids->len; i++) {
+		GHashTable *silo_guids = g_ptr_array_index (self->silos_guids, i);
+		guint results_silo = results->len;
+		for (guint j = 0; j < guids->len; j++) {
+			const gchar *guid = g_ptr_array_index (guids, j);
+			GPtrArray *postings = g_hash_table_lookup (silo_guids, guid);
+			if (postings == NULL)
+				continue;
+			for (guint k = 0; k < postings->len; k++) {
+				XbNode *component = g_ptr_array_index (postings, k);
+				gboolean duplicate = FALSE;
+
+				/* only components from this silo can be the same */
+				for (guint l = results_silo; l < results->len; l++) {
+					if (g_ptr_array_index (results, l) == component) {
+						duplicate = TRUE;
+						break;
+					}
+				}
+				if (duplicate)
+					continue;
+				g_ptr_array_add (results, g_object_ref (component));
+				if (limit > 0 && results->len >= limit)
+					return g_steal_pointer (&results);
+			}
+		}
+	}
+	if (results->len == 0) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "no components provide the GUIDs");
+		return NULL;
+	}
+	return g_steal_pointer (&results);
+}
+
 /* finds the remote-id for the first firmware in the silo that matches this
  * container checksum */
 static const gchar *
 fu_engine_get_remote_id_for_checksum (FuEngine *self, const gchar *csum)
 {
-	g_autofree gchar *xpath = NULL;
-	g_autoptr(XbNode) key = NULL;
-	xpath = g_strdup_printf ("components/component[@type='firmware']/releases/release/"
-				 "checksum[@target='container'][text()='%s']/../../"
-				 "../../custom/value[@key='fwupd::RemoteId']", csum);
-	key = xb_silo_query_first (self->silo, xpath, NULL);
-	if (key == NULL)
-		return NULL;
-	return xb_node_get_text (key);
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		GHashTable *silo_checksums = g_object_get_data (G_OBJECT (silo), "FuEngine::checksums");
+		const gchar *remote_id;
+		if (silo_checksums == NULL)
+			continue;
+		remote_id = g_hash_table_lookup (silo_checksums, csum);
+		if (remote_id != NULL)
+			return remote_id;
+	}
+	return NULL;
 }
 
 /**
@@ -775,10 +1269,88 @@ fu_engine_checksum_type_to_string (GChecksumType checksum_type)
 	return "sha1";
 }
 
+static gchar *
+fu_engine_get_boot_id (void)
+{
+	gsize bufsz = 0;
+	g_autofree gchar *buf = NULL;
+	g_autofree gchar *procfs = fu_common_get_path (FU_PATH_KIND_PROCFS);
+	g_autofree gchar *fn = g_build_filename (procfs, "sys", "kernel", "random", "boot_id", NULL);
+	if (!g_file_get_contents (fn, &buf, &bufsz, NULL))
+		return NULL;
+	g_strstrip (buf);
+	if (buf[0] == '\0')
+		return NULL;
+	return g_steal_pointer (&buf);
+}
+
+/* anything that would change the firmware contents changes this too */
+static gchar *
+fu_engine_verify_get_fingerprint (FuDevice *device)
+{
+	g_autofree gchar *boot_id = fu_engine_get_boot_id ();
+	return g_strdup_printf ("%s|%" G_GINT64_MODIFIER "x|%" G_GINT64_MODIFIER "x|%s",
+				fu_device_get_version (device),
+				fu_device_get_version_raw (device),
+				fu_device_get_flags (device),
+				boot_id);
+}
+
+/* reuse the checksums from the last readback unless the device has changed */
+static gboolean
+fu_engine_verify_ensure_checksums (FuEngine *self,
+				   FuPlugin *plugin,
+				   FuDevice *device,
+				   FwupdInstallFlags flags,
+				   GError **error)
+{
+	GPtrArray *checksums;
+	g_autofree gchar *fingerprint = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if ((flags & FWUPD_INSTALL_FLAG_FORCE) == 0) {
+		g_autoptr(GPtrArray) checksums_cached = NULL;
+		fingerprint = fu_engine_verify_get_fingerprint (device);
+		checksums_cached = fu_history_get_verify_cache (self->history,
+								fu_device_get_id (device),
+								fingerprint,
+								NULL);
+		if (checksums_cached != NULL) {
+			g_debug ("using cached checksums for %s",
+				 fu_device_get_id (device));
+			for (guint i = 0; i < checksums_cached->len; i++) {
+				const gchar *checksum = g_ptr_array_index (checksums_cached, i);
+				fu_device_add_checksum (device, checksum);
+			}
+			return TRUE;
+		}
+		g_clear_pointer (&fingerprint, g_free);
+	}
+
+	/* read back from the device */
+	if (!fu_plugin_runner_verify (plugin, device,
+				      FU_PLUGIN_VERIFY_FLAG_NONE,
+				      error))
+		return FALSE;
+	checksums = fu_device_get_checksums (device);
+	if (checksums->len == 0)
+		return TRUE;
+	fingerprint = fu_engine_verify_get_fingerprint (device);
+	if (!fu_history_set_verify_cache (self->history,
+					  fu_device_get_id (device),
+					  fingerprint,
+					  checksums,
+					  &error_local))
+		g_warning ("failed to save checksums: %s", error_local->message);
+	return TRUE;
+}
+
 /**
  * fu_engine_verify_update:
  * @self: A #FuEngine
  * @device_id: A device ID
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE to always read
+ *  back the device
  * @error: A #GError, or %NULL
  *
  * Updates the verification silo entry for a specific device.
@@ -786,7 +1358,10 @@ fu_engine_checksum_type_to_string (GChecksumType checksum_type)
  * Returns: %TRUE for success
  **/
 gboolean
-fu_engine_verify_update (FuEngine *self, const gchar *device_id, GError **error)
+fu_engine_verify_update (FuEngine *self,
+			 const gchar *device_id,
+			 FwupdInstallFlags flags,
+			 GError **error)
 {
 	FuPlugin *plugin;
 	GPtrArray *checksums;
@@ -821,9 +1396,7 @@ fu_engine_verify_update (FuEngine *self, const gchar *device_id, GError **error)
 	/* get the checksum */
 	checksums = fu_device_get_checksums (device);
 	if (checksums->len == 0) {
-		if (!fu_plugin_runner_verify (plugin, device,
-					      FU_PLUGIN_VERIFY_FLAG_NONE,
-					      error))
+		if (!fu_engine_verify_ensure_checksums (self, plugin, device, flags, error))
 			return FALSE;
 		fu_engine_emit_device_changed (self, device);
 	}
@@ -889,19 +1462,11 @@ XbNode *
 fu_engine_get_component_by_guids (FuEngine *self, FuDevice *device)
 {
 	GPtrArray *guids = fu_device_get_guids (device);
-	g_autoptr(GString) xpath = g_string_new (NULL);
-	g_autoptr(XbNode) component = NULL;
-	for (guint i = 0; i < guids->len; i++) {
-		const gchar *guid = g_ptr_array_index (guids, i);
-		xb_string_append_union (xpath,
-					"components/component[@type='firmware']/"
-					"provides/firmware[@type='flashed'][text()='%s']/"
-					"../..", guid);
-	}
-	component = xb_silo_query_first (self->silo, xpath->str, NULL);
-	if (component != NULL)
-		return g_steal_pointer (&component);
-	return NULL;
+	g_autoptr(GPtrArray) components = NULL;
+	components = fu_engine_silos_query_guids (self, guids, 1, NULL);
+	if (components == NULL)
+		return NULL;
+	return g_object_ref (g_ptr_array_index (components, 0));
 }
 
 static XbNode *
@@ -955,16 +1520,17 @@ fu_engine_verify_from_local_metadata (FuEngine *self,
 }
 
 static XbNode *
-fu_engine_verify_from_system_metadata (FuEngine *self,
-				       FuDevice *device,
-				       GError **error)
+fu_engine_verify_from_system_metadata_silo (FuEngine *self,
+					    XbSilo *silo,
+					    FuDevice *device,
+					    GError **error)
 {
 	FwupdVersionFormat fmt = fu_device_get_version_format (device);
 	GPtrArray *guids = fu_device_get_guids (device);
 	g_autoptr(XbQuery) query = NULL;
 
 	/* prepare query with bound GUID parameter */
-	query = xb_query_new_full (self->silo,
+	query = xb_query_new_full (silo,
 				   "components/component[@type='firmware']/"
 				   "provides/firmware[@type='flashed'][text()=?]/"
 				   "../../releases/release",
@@ -986,13 +1552,13 @@ fu_engine_verify_from_system_metadata (FuEngine *self,
 		/* bind GUID and then query */
 #if LIBXMLB_CHECK_VERSION(0,3,0)
 		xb_value_bindings_bind_str (xb_query_context_get_bindings (&context), 0, guid, NULL);
-		releases = xb_silo_query_with_context (self->silo, query, &context, &error_local);
+		releases = xb_silo_query_with_context (silo, query, &context, &error_local);
 #else
 		if (!xb_query_bind_str (query, 0, guid, error)) {
 			g_prefix_error (error, "failed to bind string: ");
 			return NULL;
 		}
-		releases = xb_silo_query_full (self->silo, query, &error_local);
+		releases = xb_silo_query_full (silo, query, &error_local);
 #endif
 		if (releases == NULL) {
 			if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
@@ -1021,36 +1587,60 @@ fu_engine_verify_from_system_metadata (FuEngine *self,
 	return NULL;
 }
 
+static XbNode *
+fu_engine_verify_from_system_metadata (FuEngine *self,
+				       FuDevice *device,
+				       GError **error)
+{
+	for (guint i = 0; i < self->silos->len; i++) {
+		XbSilo *silo = g_ptr_array_index (self->silos, i);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbNode) rel = NULL;
+
+		rel = fu_engine_verify_from_system_metadata_silo (self, silo, device, &error_local);
+		if (rel != NULL)
+			return g_steal_pointer (&rel);
+		if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return NULL;
+		}
+	}
+
+	/* not found */
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "failed to find release");
+	return NULL;
+}
+
 /**
  * fu_engine_verify:
  * @self: A #FuEngine
  * @device_id: A device ID
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE to always read
+ *  back the device
  * @error: A #GError, or %NULL
  *
  * Verifies a device firmware checksum using the verification silo entry.
  *
  * Returns: %TRUE for success
  **/
-gboolean
-fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
+/* @mismatch is set if the device checksums do not match the release */
+static gboolean
+fu_engine_verify_device (FuEngine *self,
+			 FuDevice *device,
+			 FwupdInstallFlags flags,
+			 gboolean *mismatch,
+			 GError **error)
 {
 	FuPlugin *plugin;
 	GPtrArray *checksums;
-	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GString) xpath_csum = g_string_new (NULL);
 	g_autoptr(XbNode) csum = NULL;
 	g_autoptr(XbNode) release = NULL;
 
-	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
-	g_return_val_if_fail (device_id != NULL, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-	/* check the id exists */
-	device = fu_device_list_get_by_id (self->device_list, device_id, error);
-	if (device == NULL)
-		return FALSE;
-
 	/* get the plugin */
 	plugin = fu_plugin_list_find_by_name (self->plugin_list,
 					      fu_device_get_plugin (device),
@@ -1060,8 +1650,7 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 
 	/* update the device firmware hashes if possible */
 	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE)) {
-		if (!fu_plugin_runner_verify (plugin, device,
-					      FU_PLUGIN_VERIFY_FLAG_NONE, error))
+		if (!fu_engine_verify_ensure_checksums (self, plugin, device, flags, error))
 			return FALSE;
 	}
 
@@ -1154,6 +1743,8 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 			     fu_device_get_version (device),
 			     checksums_metadata->str,
 			     checksums_device->str);
+		if (mismatch != NULL)
+			*mismatch = TRUE;
 		return FALSE;
 	}
 
@@ -1161,21 +1752,221 @@ fu_engine_verify (FuEngine *self, const gchar *device_id, GError **error)
 	return TRUE;
 }
 
-static gboolean
-fu_engine_require_vercmp (XbNode *req,
-			  const gchar *version,
-			  FwupdVersionFormat fmt,
-			  GError **error)
+gboolean
+fu_engine_verify (FuEngine *self,
+		  const gchar *device_id,
+		  FwupdInstallFlags flags,
+		  GError **error)
 {
-	gboolean ret = FALSE;
-	gint rc = 0;
-	const gchar *tmp = xb_node_get_attr (req, "compare");
-	const gchar *version_req = xb_node_get_attr (req, "version");
+	g_autoptr(FuDevice) device = NULL;
 
-	if (g_strcmp0 (tmp, "eq") == 0) {
-		rc = fu_common_vercmp_full (version, version_req, fmt);
-		ret = rc == 0;
-	} else if (g_strcmp0 (tmp, "ne") == 0) {
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* check the id exists */
+	device = fu_device_list_get_by_id (self->device_list, device_id, error);
+	if (device == NULL)
+		return FALSE;
+	return fu_engine_verify_device (self, device, flags, NULL, error);
+}
+
+/* verify the device that was checked least recently, if it is due */
+static gboolean
+fu_engine_verify_background_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	FuDevice *device = NULL;
+	GPtrArray *checksums;
+	gboolean mismatch = FALSE;
+	guint64 interval = fu_config_get_verify_interval (self->config);
+	guint64 now = g_get_real_time () / G_USEC_PER_SEC;
+	guint64 timestamp_oldest = G_MAXUINT64;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GError) error_history = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* never compete with a client or an update */
+	if (self->status != FWUPD_STATUS_IDLE ||
+	    fu_idle_get_idle_time (self->idle) < FU_ENGINE_VERIFY_IDLE_MIN)
+		return G_SOURCE_CONTINUE;
+
+	devices = fu_device_list_get_active (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device_tmp = g_ptr_array_index (devices, i);
+		guint64 timestamp = 0;
+		if (!fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_CAN_VERIFY) &&
+		    !fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE))
+			continue;
+		if (fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION) ||
+		    fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
+			continue;
+		if (g_hash_table_contains (self->verify_unsupported,
+					   fu_device_get_id (device_tmp)))
+			continue;
+		if (!fu_history_get_verify_result (self->history,
+						   fu_device_get_id (device_tmp),
+						   &timestamp, NULL, NULL))
+			timestamp = 0;
+		if (timestamp + interval > now)
+			continue;
+		if (timestamp < timestamp_oldest) {
+			timestamp_oldest = timestamp;
+			device = device_tmp;
+		}
+	}
+	if (device == NULL)
+		return G_SOURCE_CONTINUE;
+
+	/* only one device is read back each time to limit the IO */
+	g_debug ("background verify of %s", fu_device_get_id (device));
+	if (!fu_engine_verify_device (self, device, FWUPD_INSTALL_FLAG_NONE,
+				      &mismatch, &error_local)) {
+		if (!mismatch) {
+			g_debug ("cannot verify %s: %s",
+				 fu_device_get_id (device),
+				 error_local->message);
+			g_hash_table_add (self->verify_unsupported,
+					  g_strdup (fu_device_get_id (device)));
+			return G_SOURCE_CONTINUE;
+		}
+		g_warning ("%s", error_local->message);
+	}
+	checksums = fu_device_get_checksums (device);
+	if (!fu_history_add_verify_result (self->history,
+					   fu_device_get_id (device),
+					   checksums->len > 0 ?
+					   g_ptr_array_index (checksums, 0) : NULL,
+					   !mismatch,
+					   &error_history)) {
+		g_warning ("failed to save verify result: %s",
+			   error_history->message);
+	}
+
+	/* only the built-in attestation attr depends on this */
+	g_clear_pointer (&self->host_security_id, g_free);
+	return G_SOURCE_CONTINUE;
+}
+
+/* keep the history database small, but only when nobody is waiting */
+static gboolean
+fu_engine_history_prune_cb (gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	g_autoptr(GError) error_local = NULL;
+
+	if (self->status != FWUPD_STATUS_IDLE ||
+	    fu_idle_get_idle_time (self->idle) < FU_ENGINE_VERIFY_IDLE_MIN)
+		return G_SOURCE_CONTINUE;
+	if (!fu_history_prune (self->history,
+			       fu_config_get_history_max_entries (self->config),
+			       (guint64) fu_config_get_history_max_age (self->config) * 24 * 60 * 60,
+			       fu_config_get_history_keep_unreported (self->config),
+			       &error_local))
+		g_warning ("failed to prune history: %s", error_local->message);
+	return G_SOURCE_CONTINUE;
+}
+
+typedef enum {
+	FU_ENGINE_REQUIREMENT_KIND_UNKNOWN,
+	FU_ENGINE_REQUIREMENT_KIND_ID,
+	FU_ENGINE_REQUIREMENT_KIND_FIRMWARE,
+	FU_ENGINE_REQUIREMENT_KIND_HARDWARE,
+	FU_ENGINE_REQUIREMENT_KIND_CLIENT,
+} FuEngineRequirementKind;
+
+/* a <requires> child prepared once per component */
+typedef struct {
+	FuEngineRequirementKind	 kind;
+	XbNode			*req;
+	GRegex			*vendor_id_regex;	/* (nullable) */
+	gchar			**split;		/* (nullable): HWIDs or client features */
+	FuHwids			*hwids;			/* no ref, for @hwids_match */
+	gboolean		 hwids_match;
+} FuEngineRequirement;
+
+static void
+fu_engine_requirement_free (FuEngineRequirement *requirement)
+{
+	g_object_unref (requirement->req);
+	if (requirement->vendor_id_regex != NULL)
+		g_regex_unref (requirement->vendor_id_regex);
+	g_strfreev (requirement->split);
+	g_free (requirement);
+}
+
+static FuEngineRequirement *
+fu_engine_requirement_new (XbNode *req)
+{
+	FuEngineRequirement *requirement = g_new0 (FuEngineRequirement, 1);
+	const gchar *element = xb_node_get_element (req);
+	const gchar *text = xb_node_get_text (req);
+
+	requirement->req = g_object_ref (req);
+	if (g_strcmp0 (element, "id") == 0) {
+		requirement->kind = FU_ENGINE_REQUIREMENT_KIND_ID;
+	} else if (g_strcmp0 (element, "firmware") == 0) {
+		requirement->kind = FU_ENGINE_REQUIREMENT_KIND_FIRMWARE;
+		if (g_strcmp0 (text, "vendor-id") == 0 &&
+		    xb_node_get_attr (req, "version") != NULL) {
+			requirement->vendor_id_regex = g_regex_new (xb_node_get_attr (req, "version"),
+								    G_REGEX_OPTIMIZE, 0, NULL);
+		}
+	} else if (g_strcmp0 (element, "hardware") == 0) {
+		requirement->kind = FU_ENGINE_REQUIREMENT_KIND_HARDWARE;
+		if (text != NULL)
+			requirement->split = g_strsplit (text, "|", -1);
+	} else if (g_strcmp0 (element, "client") == 0) {
+		requirement->kind = FU_ENGINE_REQUIREMENT_KIND_CLIENT;
+		if (text != NULL)
+			requirement->split = g_strsplit (text, "|", -1);
+	}
+	return requirement;
+}
+
+/* the query is only run once per component, as the result is attached to it */
+static GPtrArray *
+fu_engine_get_requirements_for_component (XbNode *component, GError **error)
+{
+	GPtrArray *requirements;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) reqs = NULL;
+
+	requirements = g_object_get_data (G_OBJECT (component), "FuEngine::requirements");
+	if (requirements != NULL)
+		return requirements;
+	reqs = xb_node_query (component, "requires/*", 0, &error_local);
+	if (reqs == NULL &&
+	    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
+	    !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+		g_propagate_error (error, g_steal_pointer (&error_local));
+		return NULL;
+	}
+	requirements = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_requirement_free);
+	for (guint i = 0; reqs != NULL && i < reqs->len; i++) {
+		XbNode *req = g_ptr_array_index (reqs, i);
+		g_ptr_array_add (requirements, fu_engine_requirement_new (req));
+	}
+	g_object_set_data_full (G_OBJECT (component), "FuEngine::requirements",
+				requirements, (GDestroyNotify) g_ptr_array_unref);
+	return requirements;
+}
+
+static gboolean
+fu_engine_require_vercmp (XbNode *req,
+			  const gchar *version,
+			  FwupdVersionFormat fmt,
+			  GError **error)
+{
+	gboolean ret = FALSE;
+	gint rc = 0;
+	const gchar *tmp = xb_node_get_attr (req, "compare");
+	const gchar *version_req = xb_node_get_attr (req, "version");
+
+	if (g_strcmp0 (tmp, "eq") == 0) {
+		rc = fu_common_vercmp_full (version, version_req, fmt);
+		ret = rc == 0;
+	} else if (g_strcmp0 (tmp, "ne") == 0) {
 		rc = fu_common_vercmp_full (version, version_req, fmt);
 		ret = rc != 0;
 	} else if (g_strcmp0 (tmp, "lt") == 0) {
@@ -1259,9 +2050,10 @@ fu_engine_check_requirement_not_child (FuEngine *self, XbNode *req,
 }
 
 static gboolean
-fu_engine_check_requirement_vendor_id (FuEngine *self, XbNode *req,
+fu_engine_check_requirement_vendor_id (FuEngine *self, FuEngineRequirement *requirement,
 				       FuDevice *device, GError **error)
 {
+	XbNode *req = requirement->req;
 	GPtrArray *vendor_ids;
 	const gchar *vendor_ids_metadata;
 	g_autofree gchar *vendor_ids_device = NULL;
@@ -1289,7 +2081,8 @@ fu_engine_check_requirement_vendor_id (FuEngine *self, XbNode *req,
 
 	/* it is always safe to use a regex, even for simple strings */
 	vendor_ids_device = fu_common_strjoin_array ("|", vendor_ids);
-	if (!g_regex_match_simple (vendor_ids_metadata, vendor_ids_device, 0, 0)) {
+	if (requirement->vendor_id_regex == NULL ||
+	    !g_regex_match (requirement->vendor_id_regex, vendor_ids_device, 0, NULL)) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INVALID_FILE,
@@ -1304,9 +2097,10 @@ fu_engine_check_requirement_vendor_id (FuEngine *self, XbNode *req,
 }
 
 static gboolean
-fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req, FuDevice *device,
-				      FwupdInstallFlags flags, GError **error)
+fu_engine_check_requirement_firmware (FuEngine *self, FuEngineRequirement *requirement,
+				      FuDevice *device, FwupdInstallFlags flags, GError **error)
 {
+	XbNode *req = requirement->req;
 	guint64 depth;
 	g_autoptr(FuDevice) device_actual = g_object_ref (device);
 	g_autoptr(GError) error_local = NULL;
@@ -1382,7 +2176,7 @@ fu_engine_check_requirement_firmware (FuEngine *self, XbNode *req, FuDevice *dev
 	if (g_strcmp0 (xb_node_get_text (req), "vendor-id") == 0) {
 		if (flags & FWUPD_INSTALL_FLAG_IGNORE_VID_PID)
 			return TRUE;
-		return fu_engine_check_requirement_vendor_id (self, req, device_actual, error);
+		return fu_engine_check_requirement_vendor_id (self, requirement, device_actual, error);
 	}
 
 	/* child version */
@@ -1492,39 +2286,48 @@ fu_engine_check_requirement_id (FuEngine *self, XbNode *req, GError **error)
 }
 
 static gboolean
-fu_engine_check_requirement_hardware (FuEngine *self, XbNode *req, GError **error)
+fu_engine_check_requirement_hardware (FuEngine *self,
+				      FuEngineRequirement *requirement,
+				      GError **error)
 {
-	g_auto(GStrv) hwid_split = NULL;
+	/* the HWIDs do not change, so only match them once */
+	if (requirement->hwids != self->hwids) {
+		requirement->hwids = self->hwids;
+		requirement->hwids_match = FALSE;
 
-	/* split and treat as OR */
-	hwid_split = g_strsplit (xb_node_get_text (req), "|", -1);
-	for (guint i = 0; hwid_split[i] != NULL; i++) {
-		if (fu_hwids_has_guid (self->hwids, hwid_split[i])) {
-			g_debug ("HWID provided %s", hwid_split[i]);
-			return TRUE;
+		/* treat as OR */
+		for (guint i = 0; requirement->split != NULL && requirement->split[i] != NULL; i++) {
+			if (fu_hwids_has_guid (self->hwids, requirement->split[i])) {
+				g_debug ("HWID provided %s", requirement->split[i]);
+				requirement->hwids_match = TRUE;
+				break;
+			}
 		}
 	}
+	if (requirement->hwids_match)
+		return TRUE;
 
 	/* nothing matched */
 	g_set_error (error,
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_INVALID_FILE,
 		     "no HWIDs matched %s",
-		     xb_node_get_text (req));
+		     xb_node_get_text (requirement->req));
 	return FALSE;
 }
 
 static gboolean
 fu_engine_check_requirement_client (FuEngine *self,
 				    FuEngineRequest *request,
-				    XbNode *req,
+				    FuEngineRequirement *requirement,
 				    GError **error)
 {
 	FwupdFeatureFlags flags;
-	g_auto(GStrv) feature_split = NULL;
+	gchar **feature_split = requirement->split;
 
-	/* split and treat as AND */
-	feature_split = g_strsplit (xb_node_get_text (req), "|", -1);
+	/* treat as AND */
+	if (feature_split == NULL)
+		return TRUE;
 	flags = fu_engine_request_get_feature_flags (request);
 	for (guint i = 0; feature_split[i] != NULL; i++) {
 		FwupdFeatureFlags flag = fwupd_feature_flag_from_string (feature_split[i]);
@@ -1557,37 +2360,37 @@ fu_engine_check_requirement_client (FuEngine *self,
 static gboolean
 fu_engine_check_requirement (FuEngine *self,
 			     FuEngineRequest *request,
-			     XbNode *req,
+			     FuEngineRequirement *requirement,
 			     FuDevice *device,
 			     FwupdInstallFlags flags,
 			     GError **error)
 {
-	/* ensure component requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "id") == 0)
-		return fu_engine_check_requirement_id (self, req, error);
-
-	/* ensure firmware requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "firmware") == 0) {
+	switch (requirement->kind) {
+	case FU_ENGINE_REQUIREMENT_KIND_ID:
+		/* ensure component requirement */
+		return fu_engine_check_requirement_id (self, requirement->req, error);
+	case FU_ENGINE_REQUIREMENT_KIND_FIRMWARE:
+		/* ensure firmware requirement */
 		if (device == NULL)
 			return TRUE;
-		return fu_engine_check_requirement_firmware (self, req, device,
+		return fu_engine_check_requirement_firmware (self, requirement, device,
 							     flags, error);
+	case FU_ENGINE_REQUIREMENT_KIND_HARDWARE:
+		/* ensure hardware requirement */
+		return fu_engine_check_requirement_hardware (self, requirement, error);
+	case FU_ENGINE_REQUIREMENT_KIND_CLIENT:
+		/* ensure client requirement */
+		return fu_engine_check_requirement_client (self, request, requirement, error);
+	default:
+		break;
 	}
 
-	/* ensure hardware requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "hardware") == 0)
-		return fu_engine_check_requirement_hardware (self, req, error);
-
-	/* ensure client requirement */
-	if (g_strcmp0 (xb_node_get_element (req), "client") == 0)
-		return fu_engine_check_requirement_client (self, request, req, error);
-
 	/* not supported */
 	g_set_error (error,
 		     FWUPD_ERROR,
 		     FWUPD_ERROR_NOT_SUPPORTED,
 		     "cannot handle requirement type %s",
-		     xb_node_get_element (req));
+		     xb_node_get_element (requirement->req));
 	return FALSE;
 }
 
@@ -1614,8 +2417,7 @@ fu_engine_check_requirements (FuEngine *self,
 			      GError **error)
 {
 	FuDevice *device = fu_install_task_get_device (task);
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GPtrArray) reqs = NULL;
+	GPtrArray *requirements;
 
 	/* all install task checks require a device */
 	if (device != NULL) {
@@ -1624,19 +2426,15 @@ fu_engine_check_requirements (FuEngine *self,
 	}
 
 	/* do engine checks */
-	reqs = xb_node_query (fu_install_task_get_component (task),
-			      "requires/*", 0, &error_local);
-	if (reqs != NULL) {
-		for (guint i = 0; i < reqs->len; i++) {
-			XbNode *req = g_ptr_array_index (reqs, i);
-			if (!fu_engine_check_requirement (self, request,
-							  req, device,
-							  flags, error))
-				return FALSE;
-		}
-	} else if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) &&
-		   !g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
-			g_propagate_error (error, g_steal_pointer (&error_local));
+	requirements = fu_engine_get_requirements_for_component (fu_install_task_get_component (task),
+								 error);
+	if (requirements == NULL)
+		return FALSE;
+	for (guint i = 0; i < requirements->len; i++) {
+		FuEngineRequirement *requirement = g_ptr_array_index (requirements, i);
+		if (!fu_engine_check_requirement (self, request,
+						  requirement, device,
+						  flags, error))
 			return FALSE;
 	}
 
@@ -1665,9 +2463,8 @@ fu_engine_get_boot_time (void)
 }
 
 static gboolean
-fu_engine_get_report_metadata_os_release (GHashTable *hash, GError **error)
+fu_engine_get_report_metadata_os_release (FuEngine *self, GHashTable *hash, GError **error)
 {
-	g_autoptr(GHashTable) os_release = NULL;
 	struct {
 		const gchar *key;
 		const gchar *val;
@@ -1678,12 +2475,14 @@ fu_engine_get_report_metadata_os_release (GHashTable *hash, GError **error)
 		{ NULL, NULL }
 	};
 
-	/* get all required os-release keys */
-	os_release = fwupd_get_os_release (error);
-	if (os_release == NULL)
-		return FALSE;
+	/* get all required os-release keys, which only change on upgrade */
+	if (self->os_release == NULL) {
+		self->os_release = fwupd_get_os_release (error);
+		if (self->os_release == NULL)
+			return FALSE;
+	}
 	for (guint i = 0; distro_kv[i].key != NULL; i++) {
-		const gchar *tmp = g_hash_table_lookup (os_release, distro_kv[i].key);
+		const gchar *tmp = g_hash_table_lookup (self->os_release, distro_kv[i].key);
 		if (tmp != NULL) {
 			g_hash_table_insert (hash,
 					     g_strdup (distro_kv[i].val),
@@ -1696,8 +2495,8 @@ fu_engine_get_report_metadata_os_release (GHashTable *hash, GError **error)
 static gboolean
 fu_engine_get_report_metadata_kernel_cmdline (GHashTable *hash, GError **error)
 {
-	gsize bufsz = 0;
-	g_autofree gchar *buf = NULL;
+	const gchar * const *tokens;
+	g_autoptr(GString) cmdline_safe = g_string_new (NULL);
 	const gchar *ignore[] = {
 		"",
 		"auto",
@@ -1762,27 +2561,19 @@ fu_engine_get_report_metadata_kernel_cmdline (GHashTable *hash, GError **error)
 	};
 
 	/* get a PII-safe kernel command line */
-	if (!g_file_get_contents ("/proc/cmdline", &buf, &bufsz, error))
-		return FALSE;
-	if (bufsz > 0) {
-		g_auto(GStrv) tokens = fu_common_strnsplit (buf, bufsz - 1, " ", -1);
-		g_autoptr(GString) cmdline_safe = g_string_new (NULL);
-		for (guint i = 0; tokens[i] != NULL; i++) {
-			g_auto(GStrv) kv = NULL;
-			if (strlen (tokens[i]) == 0)
-				continue;
-			kv = g_strsplit (tokens[i], "=", 2);
-			if (g_strv_contains (ignore, kv[0]))
-				continue;
-			if (cmdline_safe->len > 0)
-				g_string_append (cmdline_safe, " ");
-			g_string_append (cmdline_safe, tokens[i]);
-		}
-		if (cmdline_safe->len > 0) {
-			g_hash_table_insert (hash,
-					     g_strdup ("KernelCmdline"),
-					     g_strdup (cmdline_safe->str));
-		}
+	tokens = fu_common_get_kernel_cmdline ();
+	for (guint i = 0; tokens[i] != NULL; i++) {
+		g_auto(GStrv) kv = g_strsplit (tokens[i], "=", 2);
+		if (g_strv_contains (ignore, kv[0]))
+			continue;
+		if (cmdline_safe->len > 0)
+			g_string_append (cmdline_safe, " ");
+		g_string_append (cmdline_safe, tokens[i]);
+	}
+	if (cmdline_safe->len > 0) {
+		g_hash_table_insert (hash,
+				     g_strdup ("KernelCmdline"),
+				     g_strdup (cmdline_safe->str));
 	}
 	return TRUE;
 }
@@ -1815,7 +2606,7 @@ fu_engine_get_report_metadata (FuEngine *self, GError **error)
 				     g_strdup_printf ("RuntimeVersion(%s)", id),
 				     g_strdup (version));
 	}
-	if (!fu_engine_get_report_metadata_os_release (hash, error))
+	if (!fu_engine_get_report_metadata_os_release (self, hash, error))
 		return NULL;
 	if (!fu_engine_get_report_metadata_kernel_cmdline (hash, error))
 		return NULL;
@@ -1901,17 +2692,241 @@ fu_engine_composite_cleanup (FuEngine *self, GPtrArray *devices, GError **error)
 	return TRUE;
 }
 
+/* adds the device, parents, proxies and plugin so that overlapping sets can
+ * be used to find tasks that cannot be run at the same time */
+static void
+fu_engine_install_task_add_dep_ids (GHashTable *ids, FuDevice *device)
+{
+	for (FuDevice *tmp = device; tmp != NULL; tmp = fu_device_get_parent (tmp)) {
+		FuDevice *proxy = fu_device_get_proxy (tmp);
+		if (g_hash_table_contains (ids, fu_device_get_id (tmp)))
+			break;
+		g_hash_table_add (ids, g_strdup (fu_device_get_id (tmp)));
+		if (fu_device_get_plugin (tmp) != NULL) {
+			g_hash_table_add (ids, g_strdup_printf ("plugin:%s",
+								fu_device_get_plugin (tmp)));
+		}
+		if (proxy != NULL)
+			fu_engine_install_task_add_dep_ids (ids, proxy);
+	}
+}
+
+static gboolean
+fu_engine_install_task_ids_overlap (GHashTable *ids1, GHashTable *ids2)
+{
+	GHashTableIter iter;
+	gpointer key;
+	g_hash_table_iter_init (&iter, ids1);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (g_hash_table_contains (ids2, key))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+typedef FuDevice *(*FuEngineSplitDeviceFunc)	(gpointer	 item);
+
+/* split the tasks or devices into groups that have no shared devices, keeping
+ * the existing order within each group */
+static GPtrArray *
+fu_engine_split_independent (GPtrArray *items, FuEngineSplitDeviceFunc func)
+{
+	GPtrArray *groups = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
+	g_autofree guint *group_ids = g_new0 (guint, items->len);
+	g_autoptr(GHashTable) groups_by_id = NULL;
+	g_autoptr(GPtrArray) item_ids = NULL;
+
+	item_ids = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+	for (guint i = 0; i < items->len; i++) {
+		GHashTable *ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		fu_engine_install_task_add_dep_ids (ids, func (g_ptr_array_index (items, i)));
+		g_ptr_array_add (item_ids, ids);
+		group_ids[i] = i;
+	}
+
+	/* merge any groups that share a device */
+	for (guint i = 0; i < items->len; i++) {
+		for (guint j = 0; j < i; j++) {
+			guint group_old = group_ids[i];
+			if (group_ids[j] == group_old)
+				continue;
+			if (!fu_engine_install_task_ids_overlap (g_ptr_array_index (item_ids, i),
+								 g_ptr_array_index (item_ids, j)))
+				continue;
+			for (guint k = 0; k < items->len; k++) {
+				if (group_ids[k] == group_old)
+					group_ids[k] = group_ids[j];
+			}
+		}
+	}
+
+	/* build each group in the original order */
+	groups_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (guint i = 0; i < items->len; i++) {
+		GObject *item = g_ptr_array_index (items, i);
+		GPtrArray *group = g_hash_table_lookup (groups_by_id,
+							GUINT_TO_POINTER (group_ids[i]));
+		if (group == NULL) {
+			group = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+			g_hash_table_insert (groups_by_id, GUINT_TO_POINTER (group_ids[i]), group);
+			g_ptr_array_add (groups, group);
+		}
+		g_ptr_array_add (group, g_object_ref (item));
+	}
+	return groups;
+}
+
+typedef struct {
+	FuEngine		*self;
+	GPtrArray		*install_tasks;	/* (element-type FuInstallTask) */
+	GBytes			*blob_cab;
+	FwupdInstallFlags	 flags;
+	GThread			*thread;
+	GError			*error;
+	gint			 done;
+} FuEngineInstallHelper;
+
+static void
+fu_engine_install_helper_free (FuEngineInstallHelper *helper)
+{
+	if (helper->thread != NULL)
+		g_thread_join (helper->thread);
+	if (helper->error != NULL)
+		g_error_free (helper->error);
+	g_ptr_array_unref (helper->install_tasks);
+	g_free (helper);
+}
+
+/* tasks from a batch each carry the archive they were loaded from */
+static GBytes *
+fu_engine_install_task_get_blob_cab (FuInstallTask *task, GBytes *blob_cab)
+{
+	GBytes *blob_task = fu_install_task_get_blob_cab (task);
+	return blob_task != NULL ? blob_task : blob_cab;
+}
+
+static gpointer
+fu_engine_install_helper_thread_cb (gpointer user_data)
+{
+	FuEngineInstallHelper *helper = (FuEngineInstallHelper *) user_data;
+	for (guint i = 0; i < helper->install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (helper->install_tasks, i);
+		GBytes *blob_cab = fu_engine_install_task_get_blob_cab (task, helper->blob_cab);
+		if (!fu_engine_install (helper->self, task, blob_cab,
+					helper->flags, &helper->error))
+			break;
+	}
+	g_atomic_int_set (&helper->done, TRUE);
+	g_main_context_wakeup (NULL);
+	return NULL;
+}
+
+static gboolean
+fu_engine_install_tasks_concurrent (FuEngine *self,
+				    GPtrArray *groups,
+				    GBytes *blob_cab,
+				    FwupdInstallFlags flags,
+				    GError **error)
+{
+	gboolean all_done = FALSE;
+	g_autoptr(GPtrArray) helpers = NULL;
+
+	/* start a thread for each independent group of devices */
+	helpers = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_install_helper_free);
+	fu_device_list_set_concurrent_replug (self->device_list, TRUE);
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineInstallHelper *helper = g_new0 (FuEngineInstallHelper, 1);
+		g_autoptr(GError) error_local = NULL;
+		helper->self = self;
+		helper->install_tasks = g_ptr_array_ref (g_ptr_array_index (groups, i));
+		helper->blob_cab = blob_cab;
+		helper->flags = flags;
+		g_ptr_array_add (helpers, helper);
+		helper->thread = g_thread_try_new ("fu-engine-install",
+						   fu_engine_install_helper_thread_cb,
+						   helper, &error_local);
+		if (helper->thread == NULL) {
+			g_warning ("failed to start install thread, using main thread: %s",
+				   error_local->message);
+			fu_engine_install_helper_thread_cb (helper);
+		}
+	}
+
+	/* keep the main context running so that replug events are processed */
+	while (!all_done) {
+		all_done = TRUE;
+		for (guint i = 0; i < helpers->len; i++) {
+			FuEngineInstallHelper *helper = g_ptr_array_index (helpers, i);
+			if (!g_atomic_int_get (&helper->done)) {
+				all_done = FALSE;
+				break;
+			}
+		}
+		if (!all_done)
+			g_main_context_iteration (NULL, TRUE);
+	}
+	fu_device_list_set_concurrent_replug (self->device_list, FALSE);
+
+	/* report the first failure */
+	for (guint i = 0; i < helpers->len; i++) {
+		FuEngineInstallHelper *helper = g_ptr_array_index (helpers, i);
+		if (helper->error != NULL) {
+			g_propagate_error (error, g_steal_pointer (&helper->error));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_engine_install_tasks_run (FuEngine *self,
+			     GPtrArray *install_tasks,
+			     GPtrArray *devices,
+			     GBytes *blob_cab,
+			     FwupdInstallFlags flags,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) groups = NULL;
+
+	/* install independent devices at the same time if allowed */
+	if (fu_config_get_concurrent_install (self->config) &&
+	    (flags & FWUPD_INSTALL_FLAG_OFFLINE) == 0)
+		groups = fu_engine_split_independent (install_tasks,
+						      (FuEngineSplitDeviceFunc) fu_install_task_get_device);
+	if (groups != NULL && groups->len > 1) {
+		gboolean ret;
+		g_debug ("installing %u groups of devices concurrently", groups->len);
+		self->install_devices = g_ptr_array_ref (devices);
+		ret = fu_engine_install_tasks_concurrent (self, groups, blob_cab, flags, error);
+		g_clear_pointer (&self->install_devices, g_ptr_array_unref);
+		return ret;
+	}
+
+	/* all authenticated, so install all the things */
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		if (!fu_engine_install (self, task,
+					fu_engine_install_task_get_blob_cab (task, blob_cab),
+					flags, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * fu_engine_install_tasks:
  * @self: A #FuEngine
  * @request: A #FuEngineRequest
  * @install_tasks: (element-type FuInstallTask): A #FuDevice
- * @blob_cab: The #GBytes of the .cab file
+ * @blob_cab: (nullable): The #GBytes of the .cab file, or %NULL if set on each task
  * @flags: The #FwupdInstallFlags, e.g. %FWUPD_DEVICE_FLAG_UPDATABLE
  * @error: A #GError, or %NULL
  *
  * Installs a specific firmware file on one or more install tasks.
  *
+ * If the tasks were created from more than one archive then @blob_cab should
+ * be %NULL and fu_install_task_set_blob_cab() used on each task instead.
+ *
  * By this point all the requirements and tests should have been done in
  * fu_engine_check_requirements() so this should not fail before running
  * the plugin loader.
@@ -1926,10 +2941,28 @@ fu_engine_install_tasks (FuEngine *self,
 			 FwupdInstallFlags flags,
 			 GError **error)
 {
+	gboolean batch_history;
+	gboolean ret;
+	guint mount_cnt = fu_volume_get_mount_count ();
 	g_autoptr(FuIdleLocker) locker = NULL;
+	g_autoptr(GHashTable) firmware_cache = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_new = NULL;
 
+	/* a job may still be using the plugin */
+	for (guint i = 0; i < install_tasks->len; i++) {
+		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
+		FuDevice *device = fu_install_task_get_device (task);
+		if (fu_engine_job_is_pending (self, device)) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "device %s is busy",
+				     fu_device_get_id (device));
+			return FALSE;
+		}
+	}
+
 	/* do not allow auto-shutdown during this time */
 	locker = fu_idle_locker_new (self->idle, "update");
 	g_assert (locker != NULL);
@@ -1947,18 +2980,59 @@ fu_engine_install_tasks (FuEngine *self,
 		return FALSE;
 	}
 
-	/* all authenticated, so install all the things */
-	for (guint i = 0; i < install_tasks->len; i++) {
-		FuInstallTask *task = g_ptr_array_index (install_tasks, i);
-		if (!fu_engine_install (self, task, blob_cab, flags, error)) {
-			g_autoptr(GError) error_local = NULL;
-			if (!fu_engine_composite_cleanup (self, devices, &error_local)) {
-				g_warning ("failed to cleanup failed composite action: %s",
+	/* write all the history changes at the end of the update; offline
+	 * updates are scheduled using a different history connection */
+	batch_history = fu_config_get_batch_history_writes (self->config) &&
+			(flags & FWUPD_INSTALL_FLAG_OFFLINE) == 0;
+	if (batch_history) {
+		if (!fu_history_transaction_begin (self->history, error))
+			return FALSE;
+	}
+
+	/* identical payloads only get parsed once for the whole transaction */
+	firmware_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						g_free, (GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_device_set_firmware_cache (device, firmware_cache);
+	}
+	self->install_request = request;
+	ret = fu_engine_install_tasks_run (self, install_tasks, devices,
+					   blob_cab, flags, error);
+	self->install_request = NULL;
+	g_debug ("request %s: install of %u devices %s after %.0fms",
+		 fu_engine_request_get_id (request), devices->len,
+		 ret ? "done" : "failed",
+		 fu_engine_request_get_elapsed (request));
+	if (fu_volume_get_mount_count () > mount_cnt) {
+		g_debug ("request %s: mounted volumes %u times",
+			 fu_engine_request_get_id (request),
+			 fu_volume_get_mount_count () - mount_cnt);
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		fu_device_set_firmware_cache (device, NULL);
+	}
+	if (batch_history) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_history_transaction_commit (self->history, &error_local)) {
+			if (ret) {
+				g_propagate_error (error, g_steal_pointer (&error_local));
+				ret = FALSE;
+			} else {
+				g_warning ("failed to commit history: %s",
 					   error_local->message);
 			}
-			return FALSE;
 		}
 	}
+	if (!ret) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_engine_composite_cleanup (self, devices, &error_local)) {
+			g_warning ("failed to cleanup failed composite action: %s",
+				   error_local->message);
+		}
+		return FALSE;
+	}
 
 	/* set all the device statuses back to unknown */
 	for (guint i = 0; i < install_tasks->len; i++) {
@@ -2100,40 +3174,150 @@ fu_engine_offline_setup (GError **error)
 
 }
 
-static gboolean
-fu_engine_offline_invalidate (GError **error)
+static gchar *
+fu_engine_get_offline_plan_filename (const gchar *basename)
 {
-	g_autofree gchar *trigger = fu_common_get_path (FU_PATH_KIND_OFFLINE_TRIGGER);
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GFile) file1 = NULL;
+	g_autofree gchar *localstatedir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	return g_build_filename (localstatedir, basename, NULL);
+}
 
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+/* lets fwupd-offline-update start the daemon with only the plugins needed */
+static gboolean
+fu_engine_offline_plan_add (FuDevice *device,
+			    const gchar *filename,
+			    GBytes *blob_cab,
+			    GError **error)
+{
+	const gchar *id = fu_device_get_id (device);
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *fn = fu_engine_get_offline_plan_filename ("offline.plan");
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
 
-	file1 = g_file_new_for_path (trigger);
-	if (!g_file_query_exists (file1, NULL))
-		return TRUE;
-	if (!g_file_delete (file1, NULL, &error_local)) {
+	if (fu_device_get_plugin (device) == NULL) {
 		g_set_error (error,
 			     FWUPD_ERROR,
 			     FWUPD_ERROR_INTERNAL,
-			     "Cannot delete %s: %s",
-			     trigger,
-			     error_local->message);
+			     "no plugin set for %s", id);
 		return FALSE;
 	}
-	return TRUE;
+
+	/* other devices may already be scheduled */
+	if (g_file_test (fn, G_FILE_TEST_EXISTS)) {
+		if (!g_key_file_load_from_file (kf, fn, G_KEY_FILE_NONE, error))
+			return FALSE;
+	}
+	checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_cab);
+	g_key_file_set_string (kf, id, "Plugin", fu_device_get_plugin (device));
+	g_key_file_set_string (kf, id, "Filename", filename);
+	g_key_file_set_string (kf, id, "Checksum", checksum);
+	return g_key_file_save_to_file (kf, fn, error);
 }
 
-/**
- * fu_engine_schedule_update:
- * @self: a #FuEngine
- * @device: a #FuDevice
- * @release: A #FwupdRelease
- * @blob_cab: A #GBytes
- * @flags: #FwupdInstallFlags
- * @error: A #GError or NULL
- *
- * Schedule an offline update for the device
+/* the plan is renamed by fwupd-offline-update just before it starts the daemon */
+static void
+fu_engine_offline_plan_load (FuEngine *self)
+{
+	g_autofree gchar *fn = fu_engine_get_offline_plan_filename ("offline.plan.active");
+	g_auto(GStrv) groups = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+	g_autoptr(GPtrArray) plugins = g_ptr_array_new_with_free_func (g_free);
+
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return;
+
+	/* only ever used for the boot it was activated for */
+	if (!g_key_file_load_from_file (kf, fn, G_KEY_FILE_NONE, &error_local)) {
+		g_debug ("ignoring offline plan: %s", error_local->message);
+		g_unlink (fn);
+		return;
+	}
+	g_unlink (fn);
+	groups = g_key_file_get_groups (kf, NULL);
+	for (guint i = 0; groups[i] != NULL; i++) {
+		g_autofree gchar *plugin = NULL;
+		g_autofree gchar *filename = NULL;
+		g_autofree gchar *checksum = NULL;
+		g_autofree gchar *checksum_tmp = NULL;
+		g_autoptr(FuDevice) device = NULL;
+		g_autoptr(GBytes) blob = NULL;
+
+		/* a stale plan, e.g. the daemon was already running */
+		device = fu_history_get_device_by_id (self->history, groups[i], NULL);
+		if (device == NULL ||
+		    fu_device_get_update_state (device) != FWUPD_UPDATE_STATE_PENDING) {
+			g_debug ("ignoring offline plan as %s not pending", groups[i]);
+			return;
+		}
+		plugin = g_key_file_get_string (kf, groups[i], "Plugin", NULL);
+		filename = g_key_file_get_string (kf, groups[i], "Filename", NULL);
+		checksum = g_key_file_get_string (kf, groups[i], "Checksum", NULL);
+		if (plugin == NULL || filename == NULL || checksum == NULL) {
+			g_debug ("ignoring incomplete offline plan for %s", groups[i]);
+			return;
+		}
+
+		/* do a full startup if the payload was changed after scheduling */
+		blob = fu_common_get_contents_bytes (filename, &error_local);
+		if (blob == NULL) {
+			g_debug ("ignoring offline plan: %s", error_local->message);
+			return;
+		}
+		checksum_tmp = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+		if (g_strcmp0 (checksum, checksum_tmp) != 0) {
+			g_debug ("ignoring offline plan as %s changed", filename);
+			return;
+		}
+		g_ptr_array_add (plugins, g_steal_pointer (&plugin));
+	}
+	if (plugins->len == 0)
+		return;
+	for (guint i = 0; i < plugins->len; i++) {
+		const gchar *plugin = g_ptr_array_index (plugins, i);
+		g_debug ("only loading %s for offline update", plugin);
+		fu_engine_add_plugin_filter (self, plugin);
+	}
+	self->offline_plan = TRUE;
+}
+
+static gboolean
+fu_engine_offline_invalidate (GError **error)
+{
+	g_autofree gchar *trigger = fu_common_get_path (FU_PATH_KIND_OFFLINE_TRIGGER);
+	g_autofree gchar *plan = fu_engine_get_offline_plan_filename ("offline.plan");
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) file1 = NULL;
+
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* not required */
+	g_unlink (plan);
+
+	file1 = g_file_new_for_path (trigger);
+	if (!g_file_query_exists (file1, NULL))
+		return TRUE;
+	if (!g_file_delete (file1, NULL, &error_local)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "Cannot delete %s: %s",
+			     trigger,
+			     error_local->message);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_engine_schedule_update:
+ * @self: a #FuEngine
+ * @device: a #FuDevice
+ * @release: A #FwupdRelease
+ * @blob_cab: A #GBytes
+ * @flags: #FwupdInstallFlags
+ * @error: A #GError or NULL
+ *
+ * Schedule an offline update for the device
  *
  * Returns: #TRUE for success, #FALSE for failure
  *
@@ -2151,6 +3335,7 @@ fu_engine_schedule_update (FuEngine *self,
 	g_autofree gchar *dirname = NULL;
 	g_autofree gchar *filename = NULL;
 	g_autoptr(FuHistory) history = NULL;
+	g_autoptr(GError) error_plan = NULL;
 	g_autoptr(GFile) file = NULL;
 
 	/* id already exists */
@@ -2201,6 +3386,10 @@ fu_engine_schedule_update (FuEngine *self,
 	if (!fu_history_add_device (history, device, release, error))
 		return FALSE;
 
+	/* not fatal, the offline update just starts every plugin */
+	if (!fu_engine_offline_plan_add (device, filename, blob_cab, &error_plan))
+		g_warning ("failed to save offline plan: %s", error_plan->message);
+
 	/* next boot we run offline */
 	fu_device_set_progress (device, 100);
 	return fu_engine_offline_setup (error);
@@ -2217,11 +3406,14 @@ fu_engine_install_release (FuEngine *self,
 	FuPlugin *plugin;
 	FwupdVersionFormat fmt;
 	GBytes *blob_fw;
+	const gchar *checksum_content = NULL;
 	const gchar *tmp;
+	gboolean ret;
 	g_autofree gchar *version_orig = NULL;
 	g_autofree gchar *version_rel = NULL;
 	g_autoptr(FuDevice) device_tmp = NULL;
 	g_autoptr(FuDevice) device = g_object_ref (device_orig);
+	g_autoptr(FwupdRelease) release_history = NULL;
 	g_autoptr(GBytes) blob_fw2 = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -2246,6 +3438,7 @@ fu_engine_install_release (FuEngine *self,
 			return FALSE;
 	} else {
 		blob_fw2 = g_bytes_ref (blob_fw);
+		checksum_content = xb_node_query_text (rel, "checksum[@target='content']", NULL);
 	}
 
 	/* get the plugin */
@@ -2278,11 +3471,16 @@ fu_engine_install_release (FuEngine *self,
 		fu_device_set_update_state (device, FWUPD_UPDATE_STATE_FAILED);
 		if (!fu_history_add_device (self->history, device, release_tmp, error))
 			return FALSE;
+		release_history = g_steal_pointer (&release_tmp);
 	}
 
 	/* install firmware blob */
 	version_orig = g_strdup (fu_device_get_version (device));
-	if (!fu_engine_install_blob (self, device, blob_fw2, flags, &error_local)) {
+	if (checksum_content != NULL)
+		fu_device_set_metadata (device, FU_DEVICE_METADATA_UPDATE_CHECKSUM, checksum_content);
+	ret = fu_engine_install_blob (self, device, blob_fw2, flags, &error_local);
+	fu_device_remove_metadata (device, FU_DEVICE_METADATA_UPDATE_CHECKSUM);
+	if (!ret) {
 		fu_device_set_status (device, FWUPD_STATUS_IDLE);
 		if (g_error_matches (error_local,
 				     FWUPD_ERROR,
@@ -2305,10 +3503,37 @@ fu_engine_install_release (FuEngine *self,
 		    !fu_history_modify_device (self->history, device, error)) {
 			return FALSE;
 		}
+		if (release_history != NULL) {
+			fu_engine_add_install_timings (self, release_history);
+			if (!fu_history_set_device_metadata (self->history,
+							     fu_device_get_id (device),
+							     fwupd_release_get_metadata (release_history),
+							     error))
+				return FALSE;
+		}
 		g_propagate_error (error, g_steal_pointer (&error_local));
 		return FALSE;
 	}
 
+	/* record how much of the image actually needed writing */
+	if (release_history != NULL &&
+	    fu_device_has_internal_flag (device, FU_DEVICE_INTERNAL_FLAG_SKIP_UNCHANGED)) {
+		g_autofree gchar *sz = NULL;
+		sz = g_strdup_printf ("%" G_GUINT64_FORMAT,
+				      fu_device_get_bytes_written (device));
+		fwupd_release_add_metadata_item (release_history, "BytesWritten", sz);
+	}
+
+	/* record how long each phase took */
+	if (release_history != NULL) {
+		fu_engine_add_install_timings (self, release_history);
+		if (!fu_history_set_device_metadata (self->history,
+						     fu_device_get_id (device),
+						     fwupd_release_get_metadata (release_history),
+						     error))
+			return FALSE;
+	}
+
 	/* the device may have changed */
 	device_tmp = fu_device_list_get_by_id (self->device_list,
 					       fu_device_get_id (device),
@@ -2355,74 +3580,54 @@ fu_engine_install_release (FuEngine *self,
 }
 
 typedef struct {
-	gboolean	 ret;
-	GError		**error;
-	FuEngine	*self;
-	FuDevice	*device;
-} FuEngineSortHelper;
+	XbNode		*rel;
+	gchar		*version;
+	FuVersionKey	 key;
+} FuEngineSortItem;
 
 static gint
 fu_engine_sort_release_versions_cb (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-	FuEngineSortHelper *helper = (FuEngineSortHelper *) user_data;
-	XbNode *na = *((XbNode **) a);
-	XbNode *nb = *((XbNode **) b);
-	g_autofree gchar *va = NULL;
-	g_autofree gchar *vb = NULL;
-
-	/* already failed */
-	if (!helper->ret)
-		return 0;
-
-	/* get the semver from the release */
-	va = fu_engine_get_release_version (helper->self, helper->device, na, helper->error);
-	if (va == NULL) {
-		g_prefix_error (helper->error, "failed to get release version: ");
-		return 0;
-	}
-	vb = fu_engine_get_release_version (helper->self, helper->device, nb, helper->error);
-	if (vb == NULL) {
-		g_prefix_error (helper->error, "failed to get release version: ");
-		return 0;
-	}
-	return fu_common_vercmp_full (va, vb, fu_device_get_version_format (helper->device));
+	const FuEngineSortItem *item_a = (const FuEngineSortItem *) a;
+	const FuEngineSortItem *item_b = (const FuEngineSortItem *) b;
+	return fu_common_version_key_cmp (&item_a->key, &item_b->key);
 }
 
 static gboolean
 fu_engine_sort_releases (FuEngine *self, FuDevice *device, GPtrArray *rels, GError **error)
 {
-	FuEngineSortHelper helper = {
-		.ret = TRUE,
-		.self = self,
-		.device = device,
-		.error = error,
-	};
-	g_ptr_array_sort_with_data (rels, fu_engine_sort_release_versions_cb, &helper);
-	return helper.ret;
+	FwupdVersionFormat fmt = fu_device_get_version_format (device);
+	g_autofree FuEngineSortItem *items = g_new0 (FuEngineSortItem, rels->len);
+	gboolean ret = TRUE;
+
+	/* get the semver from each release once rather than for each compare */
+	for (guint i = 0; i < rels->len; i++) {
+		items[i].rel = g_ptr_array_index (rels, i);
+		items[i].version = fu_engine_get_release_version (self, device, items[i].rel, error);
+		if (items[i].version == NULL) {
+			g_prefix_error (error, "failed to get release version: ");
+			ret = FALSE;
+			break;
+		}
+		fu_common_version_key_init (&items[i].key, items[i].version, fmt);
+	}
+	if (ret) {
+		g_qsort_with_data (items, rels->len, sizeof(FuEngineSortItem),
+				   fu_engine_sort_release_versions_cb, NULL);
+		for (guint i = 0; i < rels->len; i++)
+			rels->pdata[i] = items[i].rel;
+	}
+	for (guint i = 0; i < rels->len; i++)
+		g_free (items[i].version);
+	return ret;
 }
 
-/**
- * fu_engine_install:
- * @self: A #FuEngine
- * @task: A #FuInstallTask
- * @blob_cab: The #GBytes of the .cab file
- * @flags: The #FwupdInstallFlags, e.g. %FWUPD_DEVICE_FLAG_UPDATABLE
- * @error: A #GError, or %NULL
- *
- * Installs a specific firmware file on a device.
- *
- * By this point all the requirements and tests should have been done in
- * fu_engine_check_requirements() so this should not fail before running
- * the plugin loader.
- *
- * Returns: %TRUE for success
- **/
-gboolean
-fu_engine_install (FuEngine *self,
-		   FuInstallTask *task,
-		   GBytes *blob_cab,
-		   FwupdInstallFlags flags,
-		   GError **error)
+static gboolean
+fu_engine_install_internal (FuEngine *self,
+			    FuInstallTask *task,
+			    GBytes *blob_cab,
+			    FwupdInstallFlags flags,
+			    GError **error)
 {
 	XbNode *component = fu_install_task_get_component (task);
 	g_autoptr(FuDevice) device = NULL;
@@ -2542,6 +3747,38 @@ fu_engine_install (FuEngine *self,
 	return TRUE;
 }
 
+/**
+ * fu_engine_install:
+ * @self: A #FuEngine
+ * @task: A #FuInstallTask
+ * @blob_cab: The #GBytes of the .cab file
+ * @flags: The #FwupdInstallFlags, e.g. %FWUPD_DEVICE_FLAG_UPDATABLE
+ * @error: A #GError, or %NULL
+ *
+ * Installs a specific firmware file on a device.
+ *
+ * By this point all the requirements and tests should have been done in
+ * fu_engine_check_requirements() so this should not fail before running
+ * the plugin loader.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_install (FuEngine *self,
+		   FuInstallTask *task,
+		   GBytes *blob_cab,
+		   FwupdInstallFlags flags,
+		   GError **error)
+{
+	gboolean ret;
+	FU_USDT_PROBE1 (install__start,
+			fu_device_get_id (fu_install_task_get_device (task)));
+	ret = fu_engine_install_internal (self, task, blob_cab, flags, error);
+	FU_USDT_PROBE2 (install__done,
+			fu_device_get_id (fu_install_task_get_device (task)), ret);
+	return ret;
+}
+
 /**
  * fu_engine_get_plugins:
  * @self: A #FuPluginList
@@ -2584,12 +3821,12 @@ fu_engine_get_device (FuEngine *self, const gchar *device_id, GError **error)
 	/* wait for device to disconnect and reconnect */
 	root = fu_device_get_root (device1);
 	if (fu_device_has_flag (device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
-		if (!fu_device_list_wait_for_replug (self->device_list, device1, error)) {
+		if (!fu_engine_wait_for_replug (self, device1, error)) {
 			g_prefix_error (error, "failed to wait for detach replug: ");
 			return NULL;
 		}
 	} else if (fu_device_has_flag (root, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
-		if (!fu_device_list_wait_for_replug (self->device_list, root, error)) {
+		if (!fu_engine_wait_for_replug (self, root, error)) {
 			g_prefix_error (error, "failed to wait for detach replug: ");
 			return NULL;
 		}
@@ -2676,7 +3913,7 @@ fu_engine_update_prepare (FuEngine *self,
 
 	/* wait for device to disconnect and reconnect */
 	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
-		if (!fu_device_list_wait_for_replug (self->device_list, device, error)) {
+		if (!fu_engine_wait_for_replug (self, device, error)) {
 			g_prefix_error (error, "failed to wait for prepare replug: ");
 			return FALSE;
 		}
@@ -2710,7 +3947,7 @@ fu_engine_update_cleanup (FuEngine *self,
 
 	/* wait for device to disconnect and reconnect */
 	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG)) {
-		if (!fu_device_list_wait_for_replug (self->device_list, device, error)) {
+		if (!fu_engine_wait_for_replug (self, device, error)) {
 			g_prefix_error (error, "failed to wait for cleanup replug: ");
 			return FALSE;
 		}
@@ -2841,9 +4078,11 @@ fu_engine_update (FuEngine *self,
 		  GError **error)
 {
 	FuPlugin *plugin;
+	guint64 bytes_written;
 	g_autofree gchar *str = NULL;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuDevice) device_pending = NULL;
+	g_autoptr(GTimer) timer = NULL;
 
 	/* cancel the pending action */
 	if (!fu_engine_offline_invalidate (error))
@@ -2863,10 +4102,17 @@ fu_engine_update (FuEngine *self,
 					      error);
 	if (plugin == NULL)
 		return FALSE;
+	bytes_written = fu_device_get_bytes_written (device);
+	timer = g_timer_new ();
 	if (!fu_plugin_runner_update (plugin, device, blob_fw2, flags, error)) {
 		g_autoptr(GError) error_attach = NULL;
 		g_autoptr(GError) error_cleanup = NULL;
 
+		/* show what was last sent and received */
+		fu_device_dump_trace (device);
+		fu_metrics_inc (self->metrics, "fwupd_plugin_update_failures",
+				fu_plugin_get_name (plugin), 1);
+
 		/* attack back into runtime then cleanup */
 		if (!fu_plugin_runner_update_attach (plugin,
 						     device,
@@ -2880,6 +4126,16 @@ fu_engine_update (FuEngine *self,
 		}
 		return FALSE;
 	}
+	fu_metrics_inc (self->metrics, "fwupd_plugin_updates",
+			fu_plugin_get_name (plugin), 1);
+	fu_metrics_inc (self->metrics, "fwupd_plugin_update_written_bytes",
+			fu_plugin_get_name (plugin),
+			fu_device_get_bytes_written (device) - bytes_written);
+	fu_metrics_observe (self->metrics, "fwupd_plugin_update_duration_seconds",
+			    fu_plugin_get_name (plugin),
+			    g_timer_elapsed (timer, NULL),
+			    self->install_request != NULL ?
+			    fu_engine_request_get_id (self->install_request) : NULL);
 
 	/* cleanup */
 	if (device_pending != NULL) {
@@ -2935,10 +4191,15 @@ fu_engine_install_blob (FuEngine *self,
 			FwupdInstallFlags flags,
 			GError **error)
 {
+	gboolean ret = FALSE;
 	guint retries = 0;
 	g_autofree gchar *device_id = NULL;
+	g_autoptr(GError) error_cache = NULL;
 	g_autoptr(GTimer) timer = g_timer_new ();
 
+	/* time each phase so that the history can show where the time went */
+	memset (self->install_timings, 0, sizeof (self->install_timings));
+
 	/* test the firmware is not an empty blob */
 	if (g_bytes_get_size (blob_fw) == 0) {
 		g_set_error (error,
@@ -2951,6 +4212,12 @@ fu_engine_install_blob (FuEngine *self,
 	/* mark this as modified even if we actually fail to do the update */
 	fu_device_set_modified (device, (guint64) g_get_real_time () / G_USEC_PER_SEC);
 
+	/* the same version might be written again, so the readback is stale */
+	if (!fu_history_remove_verify_cache (self->history,
+					     fu_device_get_id (device),
+					     &error_cache))
+		g_warning ("failed to remove checksums: %s", error_cache->message);
+
 	/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
 	 * must return TRUE rather than an error */
 	device_id = g_strdup (fu_device_get_id (device));
@@ -2963,40 +4230,53 @@ fu_engine_install_blob (FuEngine *self,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_INTERNAL,
 					     "aborting device write loop, limit 5");
-			return FALSE;
+			break;
 		}
 
 		/* signal to all the plugins the update is about to happen */
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_PREPARE);
 		if (!fu_engine_update_prepare (self, flags, device_id, error))
-			return FALSE;
+			break;
 
 		/* detach to bootloader mode */
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_DETACH);
 		if (!fu_engine_update_detach (self, device_id, error))
-			return FALSE;
+			break;
 
 		/* install */
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_WRITE);
 		if (!fu_engine_update (self, device_id, blob_fw, flags, error))
-			return FALSE;
+			break;
 
 		/* attach into runtime mode */
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_ATTACH);
 		if (!fu_engine_update_attach (self, device_id, error))
-			return FALSE;
+			break;
 
 		/* the device and plugin both may have changed */
 		device_tmp = fu_engine_get_device (self, device_id, error);
 		if (device_tmp == NULL)
-			return FALSE;
-		if (!fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED))
 			break;
+		if (!fu_device_has_flag (device_tmp, FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED)) {
+			ret = TRUE;
+			break;
+		}
 
 	} while (TRUE);
 
 	/* get the new version number */
-	if (!fu_engine_update_reload (self, device_id, error))
-		return FALSE;
+	if (ret) {
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_RELOAD);
+		ret = fu_engine_update_reload (self, device_id, error);
+	}
 
 	/* signal to all the plugins the update has happened */
-	if (!fu_engine_update_cleanup (self, flags, device_id, error))
+	if (ret) {
+		fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_CLEANUP);
+		ret = fu_engine_update_cleanup (self, flags, device_id, error);
+	}
+	fu_engine_set_install_phase (self, FU_ENGINE_INSTALL_PHASE_LAST);
+	if (!ret)
 		return FALSE;
 
 	/* make the UI update */
@@ -3067,7 +4347,10 @@ fu_engine_set_silo (FuEngine *self, XbSilo *silo)
 {
 	g_return_if_fail (FU_IS_ENGINE (self));
 	g_return_if_fail (XB_IS_SILO (silo));
-	g_set_object (&self->silo, silo);
+	g_hash_table_remove_all (self->silos_remote);
+	g_ptr_array_set_size (self->silos, 0);
+	g_ptr_array_add (self->silos, g_object_ref (silo));
+	fu_engine_silos_guids_rebuild (self);
 }
 
 static gboolean
@@ -3379,65 +4662,245 @@ fu_engine_md_refresh_devices (FuEngine *self)
 	}
 }
 
+/* components are compared by content as the nodes of a reloaded silo are new */
 static gboolean
-fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError **error)
+fu_engine_silo_postings_equal (GPtrArray *postings_old, GPtrArray *postings_new)
 {
-	GPtrArray *remotes;
-	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
+	if (postings_old == NULL && postings_new == NULL)
+		return TRUE;
+	if (postings_old == NULL || postings_new == NULL)
+		return FALSE;
+	if (postings_old->len != postings_new->len)
+		return FALSE;
+	for (guint i = 0; i < postings_old->len; i++) {
+		XbNode *component_old = g_ptr_array_index (postings_old, i);
+		XbNode *component_new = g_ptr_array_index (postings_new, i);
+		g_autofree gchar *xml_old = NULL;
+		g_autofree gchar *xml_new = NULL;
+		xml_old = xb_node_export (component_old, XB_NODE_EXPORT_FLAG_NONE, NULL);
+		xml_new = xb_node_export (component_new, XB_NODE_EXPORT_FLAG_NONE, NULL);
+		if (g_strcmp0 (xml_old, xml_new) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* only refresh the devices with a GUID provided by a changed component in the
+ * silo that was replaced, as the other silos are the same */
+static void
+fu_engine_md_refresh_devices_changed (FuEngine *self, XbSilo *silo_old, XbSilo *silo_new)
+{
+	GHashTable *guids_old = NULL;
+	GHashTable *guids_new = NULL;
+	guint cnt = 0;
+	g_autoptr(GHashTable) guids_done = g_hash_table_new (g_str_hash, g_str_equal);
+	g_autoptr(GPtrArray) devices = fu_device_list_get_all (self->device_list);
+
+	if (silo_old != NULL)
+		guids_old = g_object_get_data (G_OBJECT (silo_old), "FuEngine::guids");
+	if (silo_new != NULL)
+		guids_new = g_object_get_data (G_OBJECT (silo_new), "FuEngine::guids");
+	if ((silo_old != NULL && guids_old == NULL) ||
+	    (silo_new != NULL && guids_new == NULL)) {
+		fu_engine_md_refresh_devices (self);
+		return;
+	}
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		GPtrArray *guids = fu_device_get_guids (device);
+		gboolean changed = FALSE;
+		g_autoptr(XbNode) component = NULL;
+
+		for (guint j = 0; j < guids->len && !changed; j++) {
+			const gchar *guid = g_ptr_array_index (guids, j);
+			gpointer value = NULL;
+			if (!g_hash_table_lookup_extended (guids_done, guid, NULL, &value)) {
+				GPtrArray *postings_old = NULL;
+				GPtrArray *postings_new = NULL;
+				if (guids_old != NULL)
+					postings_old = g_hash_table_lookup (guids_old, guid);
+				if (guids_new != NULL)
+					postings_new = g_hash_table_lookup (guids_new, guid);
+				value = GINT_TO_POINTER (!fu_engine_silo_postings_equal (postings_old,
+											postings_new));
+				g_hash_table_insert (guids_done, (gpointer) guid, value);
+			}
+			changed = GPOINTER_TO_INT (value);
+		}
+		if (!changed)
+			continue;
+
+		/* set or clear the SUPPORTED flag */
+		component = fu_engine_get_component_by_guids (self, device);
+		fu_engine_ensure_device_supported (self, device);
+
+		/* fixup the name and format as needed */
+		fu_engine_md_refresh_device_from_component (self, device, component);
+		cnt++;
+	}
+	g_debug ("refreshed %u of %u devices from metadata", cnt, devices->len);
+}
+
+/* rebuild the merged view of all the remote silos in priority order */
+static void
+fu_engine_silos_rebuild (FuEngine *self)
+{
+	GPtrArray *remotes = fu_remote_list_get_all (self->remote_list);
+	guint cnt = 0;
+
+	g_ptr_array_set_size (self->silos, 0);
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		XbSilo *silo = g_hash_table_lookup (self->silos_remote,
+						    fwupd_remote_get_id (remote));
+		g_autoptr(GPtrArray) components = NULL;
+		if (silo == NULL)
+			continue;
+		components = xb_silo_query (silo,
+					    "components/component[@type='firmware']",
+					    0, NULL);
+		if (components != NULL)
+			cnt += components->len;
+		g_ptr_array_add (self->silos, g_object_ref (silo));
+	}
+	g_debug ("%u components now in %u silos", cnt, self->silos->len);
+	fu_engine_silos_guids_rebuild (self);
+	self->silos_generation++;
+}
+
+typedef struct {
+	gchar			*remote_id;
+	XbBuilder		*builder;
+	GFile			*xmlb;		/* (nullable): nothing to load if unset */
+	XbBuilderCompileFlags	 compile_flags;
+	GTimer			*timer;
+} FuEngineMetadataHelper;
+
+static void
+fu_engine_metadata_helper_free (FuEngineMetadataHelper *helper)
+{
+	g_free (helper->remote_id);
+	g_object_unref (helper->builder);
+	if (helper->xmlb != NULL)
+		g_object_unref (helper->xmlb);
+	g_timer_destroy (helper->timer);
+	g_free (helper);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineMetadataHelper, fu_engine_metadata_helper_free)
+
+/* sets up the builder on the main thread, so that only the compile needs to
+ * be done by the caller, which may be in a worker thread */
+/* gzip is handled by libxmlb itself */
+static FuDecompressorFormat
+fu_engine_metadata_get_decompressor_format (const gchar *filename)
+{
+	if (filename == NULL)
+		return FU_DECOMPRESSOR_FORMAT_UNKNOWN;
+	if (g_str_has_suffix (filename, ".xz"))
+		return FU_DECOMPRESSOR_FORMAT_XZ;
+	if (g_str_has_suffix (filename, ".zst"))
+		return FU_DECOMPRESSOR_FORMAT_ZSTD;
+	return FU_DECOMPRESSOR_FORMAT_UNKNOWN;
+}
+
+static GInputStream *
+fu_engine_builder_source_decompress_cb (XbBuilderSource *source,
+					XbBuilderSourceCtx *ctx,
+					gpointer user_data,
+					GCancellable *cancellable,
+					GError **error)
+{
+	FuDecompressorFormat format = GPOINTER_TO_UINT (user_data);
+	g_autoptr(FuDecompressor) decompressor = fu_decompressor_new (format, error);
+	if (decompressor == NULL)
+		return NULL;
+	return g_converter_input_stream_new (xb_builder_source_ctx_get_stream (ctx),
+					     G_CONVERTER (decompressor));
+}
+
+/* decompress as the XML is parsed rather than all at once */
+static void
+fu_engine_builder_source_add_decompressor (XbBuilderSource *source,
+					   const gchar *content_types,
+					   FuDecompressorFormat format)
+{
+	if (!fu_decompressor_format_supported (format))
+		return;
+#if LIBXMLB_CHECK_VERSION(0,1,15)
+	xb_builder_source_add_simple_adapter (source, content_types,
+					      fu_engine_builder_source_decompress_cb,
+					      GUINT_TO_POINTER (format), NULL);
+#else
+	xb_builder_source_add_adapter (source, content_types,
+				       fu_engine_builder_source_decompress_cb,
+				       GUINT_TO_POINTER (format), NULL);
+#endif
+}
+
+static FuEngineMetadataHelper *
+fu_engine_metadata_helper_new (FuEngine *self,
+			       FwupdRemote *remote,
+			       FuEngineLoadFlags flags,
+			       GError **error)
+{
+	const gchar *path = NULL;
 	g_autofree gchar *cachedirpkg = NULL;
+	g_autofree gchar *basename = NULL;
 	g_autofree gchar *xmlbfn = NULL;
-	g_autoptr(GFile) xmlb = NULL;
-	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(FuEngineMetadataHelper) helper = g_new0 (FuEngineMetadataHelper, 1);
 
-	/* clear existing silo */
-	g_clear_object (&self->silo);
+	helper->remote_id = g_strdup (fwupd_remote_get_id (remote));
+	helper->builder = xb_builder_new ();
+	helper->compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
+	helper->timer = g_timer_new ();
+
+	/* nothing to load */
+	if (!fwupd_remote_get_enabled (remote))
+		return g_steal_pointer (&helper);
+	path = fwupd_remote_get_filename_cache (remote);
+	if (!g_file_test (path, G_FILE_TEST_EXISTS))
+		return g_steal_pointer (&helper);
 
 	/* verbose profiling */
 	if (g_getenv ("FWUPD_XMLB_VERBOSE") != NULL) {
-		xb_builder_set_profile_flags (builder,
+		xb_builder_set_profile_flags (helper->builder,
 					      XB_SILO_PROFILE_FLAG_XPATH |
 					      XB_SILO_PROFILE_FLAG_DEBUG);
 	}
 
-	/* load each enabled metadata file */
-	remotes = fu_remote_list_get_all (self->remote_list);
-	for (guint i = 0; i < remotes->len; i++) {
-		const gchar *path = NULL;
+	/* generate all metadata on demand */
+	if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
+		g_autoptr(GError) error_local = NULL;
+		g_debug ("building metadata for remote '%s'",
+			 fwupd_remote_get_id (remote));
+		if (!fu_engine_create_metadata (self, helper->builder, remote, &error_local)) {
+			g_warning ("failed to generate remote %s: %s",
+				   fwupd_remote_get_id (remote),
+				   error_local->message);
+		}
+	} else {
 		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GFile) file = NULL;
+		g_autoptr(GFile) file = g_file_new_for_path (path);
 		g_autoptr(XbBuilderFixup) fixup = NULL;
 		g_autoptr(XbBuilderNode) custom = NULL;
 		g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
 
-		FwupdRemote *remote = g_ptr_array_index (remotes, i);
-		if (!fwupd_remote_get_enabled (remote))
-			continue;
-		path = fwupd_remote_get_filename_cache (remote);
-		if (!g_file_test (path, G_FILE_TEST_EXISTS))
-			continue;
-
-		/* generate all metadata on demand */
-		if (fwupd_remote_get_kind (remote) == FWUPD_REMOTE_KIND_DIRECTORY) {
-			g_debug ("building metadata for remote '%s'",
-				 fwupd_remote_get_id (remote));
-			if (!fu_engine_create_metadata (self, builder, remote, &error_local)) {
-				g_warning ("failed to generate remote %s: %s",
-					   fwupd_remote_get_id (remote),
-					   error_local->message);
-			}
-			continue;
-		}
+		fu_engine_builder_source_add_decompressor (source,
+							   "application/x-xz,.xz",
+							   FU_DECOMPRESSOR_FORMAT_XZ);
+		fu_engine_builder_source_add_decompressor (source,
+							   "application/zstd,.zst",
+							   FU_DECOMPRESSOR_FORMAT_ZSTD);
 
 		/* save the remote-id in the custom metadata space */
-		file = g_file_new_for_path (path);
 		if (!xb_builder_source_load_file (source, file,
 						  XB_BUILDER_SOURCE_FLAG_NONE,
 						  NULL, &error_local)) {
 			g_warning ("failed to load remote %s: %s",
 				   fwupd_remote_get_id (remote),
 				   error_local->message);
-			continue;
+			return g_steal_pointer (&helper);
 		}
 
 		/* fix up any legacy installed files */
@@ -3460,57 +4923,143 @@ fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError *
 		xb_builder_source_set_info (source, custom);
 
 		/* we need to watch for changes? */
-		xb_builder_import_source (builder, source);
+		xb_builder_import_source (helper->builder, source);
 	}
 
 	/* on a read-only filesystem don't care about the cache GUID */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
-		compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
+		helper->compile_flags |= XB_BUILDER_COMPILE_FLAG_IGNORE_GUID;
 
-	/* ensure silo is up to date */
+	/* the silo is only compiled if the remote changed */
 	cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
-	xmlbfn = g_build_filename (cachedirpkg, "metadata.xmlb", NULL);
-	xmlb = g_file_new_for_path (xmlbfn);
-	self->silo = xb_builder_ensure (builder, xmlb, compile_flags, NULL, error);
-	if (self->silo == NULL)
-		return FALSE;
+	basename = g_strdup_printf ("%s.xmlb", fwupd_remote_get_id (remote));
+	xmlbfn = g_build_filename (cachedirpkg, "metadata", basename, NULL);
+	if (!fu_common_mkdir_parent (xmlbfn, error))
+		return NULL;
+	helper->xmlb = g_file_new_for_path (xmlbfn);
+	return g_steal_pointer (&helper);
+}
 
-	/* print what we've got */
-	components = xb_silo_query (self->silo,
-				    "components/component[@type='firmware']",
-				    0, NULL);
-	if (components != NULL)
-		g_debug ("%u components now in silo", components->len);
+/* does not use the engine, so can be called from any thread */
+static XbSilo *
+fu_engine_metadata_helper_compile (FuEngineMetadataHelper *helper,
+				   GCancellable *cancellable,
+				   GError **error)
+{
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* ensure silo is up to date */
+	silo = xb_builder_ensure (helper->builder, helper->xmlb,
+				  helper->compile_flags, cancellable, error);
+	if (silo == NULL) {
+		g_prefix_error (error, "failed to load remote %s: ", helper->remote_id);
+		return NULL;
+	}
 
 	/* build the index */
-	if (!xb_silo_query_build_index (self->silo,
+	if (!xb_silo_query_build_index (silo,
 					"components/component",
 					"type", error))
-		return FALSE;
-	if (!xb_silo_query_build_index (self->silo,
+		return NULL;
+	if (!xb_silo_query_build_index (silo,
 					"components/component[@type='firmware']/provides/firmware",
 					"type", error))
-		return FALSE;
-	if (!xb_silo_query_build_index (self->silo,
+		return NULL;
+	if (!xb_silo_query_build_index (silo,
 					"components/component[@type='firmware']/provides/firmware",
 					NULL, error))
-		return FALSE;
-
-	/* success */
-	return TRUE;
+		return NULL;
+	return g_steal_pointer (&silo);
 }
 
 static void
-fu_engine_config_changed_cb (FuConfig *config, FuEngine *self)
+fu_engine_metadata_helper_swap (FuEngine *self,
+				FuEngineMetadataHelper *helper,
+				XbSilo *silo)
 {
-	fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (config));
+	g_debug ("loaded metadata for remote %s in %.2fms",
+		 helper->remote_id,
+		 g_timer_elapsed (helper->timer, NULL) * 1000.f);
+	fu_metrics_observe (self->metrics, "fwupd_silo_rebuild_duration_seconds",
+			    helper->remote_id,
+			    g_timer_elapsed (helper->timer, NULL), NULL);
+	g_hash_table_insert (self->silos_remote,
+			     g_strdup (helper->remote_id),
+			     g_object_ref (silo));
 }
 
-static void
-fu_engine_remote_list_changed_cb (FuRemoteList *remote_list, FuEngine *self)
+static gboolean
+fu_engine_load_metadata_store_remote (FuEngine *self,
+				      FwupdRemote *remote,
+				      FuEngineLoadFlags flags,
+				      GError **error)
 {
-	g_autoptr(GError) error_local = NULL;
-	if (!fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE,
+	g_autoptr(FuEngineMetadataHelper) helper = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* clear existing silo */
+	g_hash_table_remove (self->silos_remote, fwupd_remote_get_id (remote));
+
+	/* nothing to load */
+	helper = fu_engine_metadata_helper_new (self, remote, flags, error);
+	if (helper == NULL)
+		return FALSE;
+	if (helper->xmlb == NULL)
+		return TRUE;
+	silo = fu_engine_metadata_helper_compile (helper, NULL, error);
+	if (silo == NULL)
+		return FALSE;
+
+	/* success */
+	fu_engine_metadata_helper_swap (self, helper, silo);
+	return TRUE;
+}
+
+static gboolean
+fu_engine_load_metadata_store_internal (FuEngine *self, FuEngineLoadFlags flags, GError **error)
+{
+	GPtrArray *remotes;
+
+	/* load each enabled metadata file, reusing each cached silo if unchanged */
+	g_hash_table_remove_all (self->silos_remote);
+	remotes = fu_remote_list_get_all (self->remote_list);
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		if (!fu_engine_load_metadata_store_remote (self, remote, flags, error)) {
+			fu_engine_silos_rebuild (self);
+			return FALSE;
+		}
+	}
+
+	/* success */
+	fu_engine_silos_rebuild (self);
+	return TRUE;
+}
+
+static gboolean
+fu_engine_load_metadata_store (FuEngine *self, FuEngineLoadFlags flags, GError **error)
+{
+	gboolean ret;
+	FU_USDT_PROBE1 (metadata__start, flags);
+	ret = fu_engine_load_metadata_store_internal (self, flags, error);
+	FU_USDT_PROBE2 (metadata__done, flags, ret);
+	return ret;
+}
+
+static void
+fu_engine_config_changed_cb (FuConfig *config, FuEngine *self)
+{
+	fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (config));
+}
+
+static void
+fu_engine_remote_list_changed_cb (FuRemoteList *remote_list, FuEngine *self)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	/* the remote URIs and approval are copied into the releases */
+	self->releases_generation++;
+	if (!fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE,
 					    &error_local))
 		g_warning ("Failed to reload metadata store: %s",
 			   error_local->message);
@@ -3591,11 +5140,11 @@ fu_engine_get_system_jcat_result (FuEngine *self, FwupdRemote *remote, GError **
 	jcat_item = jcat_file_get_item_default (jcat_file, error);
 	if (jcat_item == NULL)
 		return NULL;
-	results = jcat_context_verify_item (self->jcat_context,
-					    blob, jcat_item,
-					    JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
-					    JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
-					    error);
+	results = fu_common_jcat_verify_item_cached (self->jcat_context,
+						     blob, jcat_item,
+						     JCAT_VERIFY_FLAG_REQUIRE_CHECKSUM |
+						     JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE,
+						     error);
 	if (results == NULL)
 		return NULL;
 
@@ -3638,33 +5187,29 @@ fu_engine_validate_result_timestamp (JcatResult *jcat_result,
 	return TRUE;
 }
 
-/**
- * fu_engine_update_metadata_bytes:
- * @self: A #FuEngine
- * @remote_id: A remote ID, e.g. `lvfs`
- * @bytes_raw: Blob of metadata
- * @bytes_sig: Blob of metadata signature, typically Jcat binary format
- * @error: A #GError, or %NULL
- *
- * Updates the metadata for a specific remote.
- *
- * Returns: %TRUE for success
- **/
-gboolean
-fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
-			        GBytes *bytes_raw, GBytes *bytes_sig, GError **error)
+static gboolean
+fu_engine_metadata_is_unchanged (FwupdRemote *remote, GBytes *bytes_raw)
+{
+	g_autoptr(GBytes) bytes_old = NULL;
+	bytes_old = fu_common_get_contents_bytes (fwupd_remote_get_filename_cache (remote), NULL);
+	if (bytes_old == NULL)
+		return FALSE;
+	return g_bytes_equal (bytes_old, bytes_raw);
+}
+
+/* verifies and saves the metadata, setting @remote_out if the silo for the
+ * remote needs to be rebuilt */
+static gboolean
+fu_engine_update_metadata_bytes_save (FuEngine *self, const gchar *remote_id,
+				      GBytes *bytes_raw, GBytes *bytes_sig,
+				      FwupdRemote **remote_out, GError **error)
 {
+	FuDecompressorFormat format;
 	FwupdKeyringKind keyring_kind;
 	FwupdRemote *remote;
 	JcatVerifyFlags jcat_flags = JCAT_VERIFY_FLAG_REQUIRE_SIGNATURE;
 	g_autoptr(JcatFile) jcat_file = jcat_file_new ();
 
-	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
-	g_return_val_if_fail (remote_id != NULL, FALSE);
-	g_return_val_if_fail (bytes_raw != NULL, FALSE);
-	g_return_val_if_fail (bytes_sig != NULL, FALSE);
-	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
 	/* check remote is valid */
 	remote = fu_remote_list_get_by_id (self->remote_list, remote_id);
 	if (remote == NULL) {
@@ -3682,6 +5227,18 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 		return FALSE;
 	}
 
+	/* do not replace metadata that can be loaded with some that cannot */
+	format = fu_engine_metadata_get_decompressor_format (fwupd_remote_get_filename_cache (remote));
+	if (format != FU_DECOMPRESSOR_FORMAT_UNKNOWN &&
+	    !fu_decompressor_format_supported (format)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOT_SUPPORTED,
+			     "metadata format for remote %s not supported",
+			     remote_id);
+		return FALSE;
+	}
+
 	/* verify JCatFile, or create a dummy one from legacy data */
 	keyring_kind = fwupd_remote_get_keyring_kind (remote);
 	if (keyring_kind == FWUPD_KEYRING_KIND_JCAT) {
@@ -3718,9 +5275,9 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 		jcat_item = jcat_file_get_item_default (jcat_file, error);
 		if (jcat_item == NULL)
 			return FALSE;
-		results = jcat_context_verify_item (self->jcat_context,
-						    bytes_raw, jcat_item,
-						    jcat_flags, error);
+		results = fu_common_jcat_verify_item_cached (self->jcat_context,
+							     bytes_raw, jcat_item,
+							     jcat_flags, error);
 		if (results == NULL)
 			return FALSE;
 
@@ -3750,6 +5307,19 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 		}
 	}
 
+	/* only the signature was refreshed, so keep the existing silo */
+	if (fu_engine_metadata_is_unchanged (remote, bytes_raw)) {
+		g_debug ("metadata for %s is unchanged, only saving signature",
+			 remote_id);
+		if (keyring_kind != FWUPD_KEYRING_KIND_NONE) {
+			if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache_sig (remote),
+							   bytes_sig, error))
+				return FALSE;
+		}
+		fwupd_remote_set_mtime (remote, (guint64) (g_get_real_time () / G_USEC_PER_SEC));
+		return TRUE;
+	}
+
 	/* save XML and signature to remotes.d */
 	if (!fu_common_set_contents_bytes (fwupd_remote_get_filename_cache (remote),
 					   bytes_raw, error))
@@ -3759,68 +5329,101 @@ fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
 						   bytes_sig, error))
 			return FALSE;
 	}
-	if (!fu_engine_load_metadata_store (self, FU_ENGINE_LOAD_FLAG_NONE, error))
-		return FALSE;
+
+	/* only the silo for this remote needs to be rebuilt */
+	*remote_out = remote;
+	return TRUE;
+}
+
+/* called when the silo for one remote has been replaced */
+static void
+fu_engine_metadata_store_changed (FuEngine *self, const gchar *remote_id, XbSilo *silo_old)
+{
+	fu_engine_silos_rebuild (self);
 
 	/* refresh SUPPORTED flag on devices */
-	fu_engine_md_refresh_devices (self);
+	fu_engine_md_refresh_devices_changed (self, silo_old,
+					      g_hash_table_lookup (self->silos_remote,
+								   remote_id));
 
 	/* invalidate host security attributes */
 	g_clear_pointer (&self->host_security_id, g_free);
 
 	/* make the UI update */
 	fu_engine_emit_changed (self);
-	return TRUE;
 }
 
 /**
- * fu_engine_update_metadata:
+ * fu_engine_update_metadata_bytes:
  * @self: A #FuEngine
  * @remote_id: A remote ID, e.g. `lvfs`
- * @fd: file descriptor of the metadata
- * @fd_sig: file descriptor of the metadata signature
+ * @bytes_raw: Blob of metadata
+ * @bytes_sig: Blob of metadata signature, typically Jcat binary format
  * @error: A #GError, or %NULL
  *
  * Updates the metadata for a specific remote.
  *
- * Note: this will close the fds when done
- *
  * Returns: %TRUE for success
  **/
 gboolean
-fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
-			   gint fd, gint fd_sig, GError **error)
+fu_engine_update_metadata_bytes (FuEngine *self, const gchar *remote_id,
+			        GBytes *bytes_raw, GBytes *bytes_sig, GError **error)
 {
-#ifdef HAVE_GIO_UNIX
-	g_autoptr(GBytes) bytes_raw = NULL;
-	g_autoptr(GBytes) bytes_sig = NULL;
-	g_autoptr(GInputStream) stream_fd = NULL;
-	g_autoptr(GInputStream) stream_sig = NULL;
+	FwupdRemote *remote = NULL;
+	XbSilo *silo_tmp;
+	g_autoptr(XbSilo) silo_old = NULL;
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
 	g_return_val_if_fail (remote_id != NULL, FALSE);
-	g_return_val_if_fail (fd > 0, FALSE);
-	g_return_val_if_fail (fd_sig > 0, FALSE);
+	g_return_val_if_fail (bytes_raw != NULL, FALSE);
+	g_return_val_if_fail (bytes_sig != NULL, FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	if (!fu_engine_update_metadata_bytes_save (self, remote_id,
+						   bytes_raw, bytes_sig,
+						   &remote, error))
+		return FALSE;
+	if (remote == NULL)
+		return TRUE;
+
+	/* only the silo for this remote needs to be rebuilt */
+	silo_tmp = g_hash_table_lookup (self->silos_remote, remote_id);
+	if (silo_tmp != NULL)
+		silo_old = g_object_ref (silo_tmp);
+	if (!fu_engine_load_metadata_store_remote (self, remote,
+						   FU_ENGINE_LOAD_FLAG_NONE,
+						   error)) {
+		fu_engine_silos_rebuild (self);
+		return FALSE;
+	}
+	fu_engine_metadata_store_changed (self, remote_id, silo_old);
+	return TRUE;
+}
+
+/* closes the fds when done */
+static gboolean
+fu_engine_update_metadata_read_fds (gint fd, gint fd_sig,
+				    GBytes **bytes_raw, GBytes **bytes_sig,
+				    GError **error)
+{
+#ifdef HAVE_GIO_UNIX
+	g_autoptr(GInputStream) stream_fd = NULL;
+	g_autoptr(GInputStream) stream_sig = NULL;
+
 	/* ensures the fd's are closed on error */
 	stream_fd = g_unix_input_stream_new (fd, TRUE);
 	stream_sig = g_unix_input_stream_new (fd_sig, TRUE);
 
 	/* read the entire file into memory */
-	bytes_raw = g_input_stream_read_bytes (stream_fd, 0x100000, NULL, error);
-	if (bytes_raw == NULL)
+	*bytes_raw = g_input_stream_read_bytes (stream_fd, 0x100000, NULL, error);
+	if (*bytes_raw == NULL)
 		return FALSE;
 
 	/* read signature */
-	bytes_sig = g_input_stream_read_bytes (stream_sig, 0x100000, NULL, error);
-	if (bytes_sig == NULL)
+	*bytes_sig = g_input_stream_read_bytes (stream_sig, 0x100000, NULL, error);
+	if (*bytes_sig == NULL)
 		return FALSE;
-
-	/* update with blobs */
-	return fu_engine_update_metadata_bytes (self, remote_id,
-						bytes_raw, bytes_sig,
-						error);
+	return TRUE;
 #else
 	g_set_error (error,
 		     FWUPD_ERROR,
@@ -3831,109 +5434,636 @@ fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
 }
 
 /**
- * fu_engine_get_silo_from_blob:
+ * fu_engine_update_metadata:
  * @self: A #FuEngine
- * @blob_cab: A #GBytes
+ * @remote_id: A remote ID, e.g. `lvfs`
+ * @fd: file descriptor of the metadata
+ * @fd_sig: file descriptor of the metadata signature
  * @error: A #GError, or %NULL
  *
- * Creates a silo from a .cab file blob.
+ * Updates the metadata for a specific remote.
  *
- * Returns: (transfer container): a #XbSilo, or %NULL
+ * Note: this will close the fds when done
+ *
+ * Returns: %TRUE for success
  **/
-XbSilo *
-fu_engine_get_silo_from_blob (FuEngine *self, GBytes *blob_cab, GError **error)
+gboolean
+fu_engine_update_metadata (FuEngine *self, const gchar *remote_id,
+			   gint fd, gint fd_sig, GError **error)
 {
-	g_autoptr(FuCabinet) cabinet = fu_cabinet_new ();
-	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(GBytes) bytes_raw = NULL;
+	g_autoptr(GBytes) bytes_sig = NULL;
 
-	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
-	g_return_val_if_fail (blob_cab != NULL, NULL);
-	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (remote_id != NULL, FALSE);
+	g_return_val_if_fail (fd > 0, FALSE);
+	g_return_val_if_fail (fd_sig > 0, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* load file */
-	fu_engine_set_status (self, FWUPD_STATUS_DECOMPRESSING);
-	fu_cabinet_set_size_max (cabinet, fu_engine_get_archive_size_max (self));
-	fu_cabinet_set_jcat_context (cabinet, self->jcat_context);
-	if (!fu_cabinet_parse (cabinet, blob_cab, FU_CABINET_PARSE_FLAG_NONE, error))
-		return NULL;
-	silo = fu_cabinet_get_silo (cabinet);
-	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
-	return g_steal_pointer (&silo);
+	if (!fu_engine_update_metadata_read_fds (fd, fd_sig, &bytes_raw, &bytes_sig, error))
+		return FALSE;
+
+	/* update with blobs */
+	return fu_engine_update_metadata_bytes (self, remote_id,
+						bytes_raw, bytes_sig,
+						error);
 }
 
-static FuDevice *
-fu_engine_get_result_from_component (FuEngine *self,
-				     FuEngineRequest *request,
-				     XbNode *component,
-				     GError **error)
+static void
+fu_engine_update_metadata_thread_cb (GTask *task,
+				     gpointer source_object,
+				     gpointer task_data,
+				     GCancellable *cancellable)
 {
-	FwupdReleaseFlags release_flags = FWUPD_RELEASE_FLAG_NONE;
-	g_autoptr(FuInstallTask) task = NULL;
-	g_autoptr(FuDevice) dev = NULL;
-	g_autoptr(FwupdRelease) rel = NULL;
-	g_autoptr(GError) error_local = NULL;
-	g_autoptr(GPtrArray) provides = NULL;
-	g_autoptr(XbNode) description = NULL;
-	g_autoptr(XbNode) release = NULL;
-#if LIBXMLB_CHECK_VERSION(0,2,0)
-	g_autoptr(XbQuery) query = NULL;
-#endif
+	FuEngineMetadataHelper *helper = (FuEngineMetadataHelper *) task_data;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo = NULL;
 
-	dev = fu_device_new ();
-	provides = xb_node_query (component,
-				  "provides/firmware[@type=$'flashed']",
-				  0, &error_local);
-	if (provides == NULL) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_INTERNAL,
-			     "failed to get release: %s",
-			     error_local->message);
-		return NULL;
+	silo = fu_engine_metadata_helper_compile (helper, cancellable, &error);
+	if (silo == NULL) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
 	}
-	for (guint i = 0; i < provides->len; i++) {
-		XbNode *prov = XB_NODE (g_ptr_array_index (provides, i));
-		const gchar *guid;
-		g_autoptr(FuDevice) device = NULL;
+	g_task_return_pointer (task, g_steal_pointer (&silo), (GDestroyNotify) g_object_unref);
+}
 
-		/* is a online or offline update appropriate */
-		guid = xb_node_get_text (prov);
-		if (guid == NULL)
-			continue;
-		device = fu_device_list_get_by_guid (self->device_list, guid, NULL);
-		if (device != NULL) {
-			fu_device_set_name (dev, fu_device_get_name (device));
-			fu_device_set_flags (dev, fu_device_get_flags (device));
-			fu_device_set_id (dev, fu_device_get_id (device));
-			fu_device_set_version_raw (dev, fu_device_get_version_raw (device));
-			fu_device_set_version_format (dev, fu_device_get_version_format (device));
-			fu_device_set_version (dev, fu_device_get_version (device));
-		}
+/* back in the main thread */
+static void
+fu_engine_update_metadata_compile_cb (GObject *source,
+				      GAsyncResult *res,
+				      gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (source);
+	FuEngineMetadataHelper *helper = g_task_get_task_data (G_TASK (res));
+	XbSilo *silo_tmp;
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_old = NULL;
 
-		/* add GUID */
-		fu_device_add_guid (dev, guid);
-	}
-	if (fu_device_get_guids(dev)->len == 0) {
-		g_set_error_literal (error,
-				     FWUPD_ERROR,
-				     FWUPD_ERROR_INTERNAL,
-				     "component has no GUIDs");
-		return NULL;
+	/* the previous silo is still being used */
+	silo = g_task_propagate_pointer (G_TASK (res), &error);
+	if (silo == NULL) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
 	}
+	silo_tmp = g_hash_table_lookup (self->silos_remote, helper->remote_id);
+	if (silo_tmp != NULL)
+		silo_old = g_object_ref (silo_tmp);
+	fu_engine_metadata_helper_swap (self, helper, silo);
+	fu_engine_metadata_store_changed (self, helper->remote_id, silo_old);
+	g_task_return_boolean (task, TRUE);
+}
 
-	/* check we can install it */
-	task = fu_install_task_new (NULL, component);
-	if (!fu_engine_check_requirements (self, request, task,
-					   FWUPD_INSTALL_FLAG_IGNORE_VID_PID,
-					   error))
-		return NULL;
-
-	/* verify trust */
-#if LIBXMLB_CHECK_VERSION(0,2,0)
-	query = xb_query_new_full (xb_node_get_silo (component),
-				   "releases/release",
-				   XB_QUERY_FLAG_FORCE_NODE_CACHE,
-				   error);
+/**
+ * fu_engine_update_metadata_async:
+ * @self: A #FuEngine
+ * @remote_id: A remote ID, e.g. `lvfs`
+ * @fd: file descriptor of the metadata
+ * @fd_sig: file descriptor of the metadata signature
+ * @cancellable: A #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Updates the metadata for a specific remote, compiling the new silo in a
+ * worker thread. The existing silo is used for queries until the new one has
+ * been compiled.
+ *
+ * Note: this will close the fds when done
+ **/
+void
+fu_engine_update_metadata_async (FuEngine *self, const gchar *remote_id,
+				 gint fd, gint fd_sig,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer callback_data)
+{
+	FwupdRemote *remote = NULL;
+	g_autoptr(FuEngineMetadataHelper) helper = NULL;
+	g_autoptr(GBytes) bytes_raw = NULL;
+	g_autoptr(GBytes) bytes_sig = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = NULL;
+	g_autoptr(GTask) task_compile = NULL;
+
+	g_return_if_fail (FU_IS_ENGINE (self));
+	g_return_if_fail (remote_id != NULL);
+	g_return_if_fail (fd > 0);
+	g_return_if_fail (fd_sig > 0);
+
+	/* verifying and saving is quick */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	if (!fu_engine_update_metadata_read_fds (fd, fd_sig, &bytes_raw, &bytes_sig, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	if (!fu_engine_update_metadata_bytes_save (self, remote_id,
+						   bytes_raw, bytes_sig,
+						   &remote, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	if (remote == NULL) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+	helper = fu_engine_metadata_helper_new (self, remote,
+						FU_ENGINE_LOAD_FLAG_NONE,
+						&error);
+	if (helper == NULL) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* nothing to compile */
+	if (helper->xmlb == NULL) {
+		XbSilo *silo_tmp = g_hash_table_lookup (self->silos_remote, remote_id);
+		g_autoptr(XbSilo) silo_old = NULL;
+		if (silo_tmp != NULL)
+			silo_old = g_object_ref (silo_tmp);
+		g_hash_table_remove (self->silos_remote, remote_id);
+		fu_engine_metadata_store_changed (self, remote_id, silo_old);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* compiling a large catalog is slow */
+	task_compile = g_task_new (self, cancellable,
+				   fu_engine_update_metadata_compile_cb,
+				   g_steal_pointer (&task));
+	g_task_set_task_data (task_compile, g_steal_pointer (&helper),
+			      (GDestroyNotify) fu_engine_metadata_helper_free);
+	g_task_run_in_thread (task_compile, fu_engine_update_metadata_thread_cb);
+}
+
+/**
+ * fu_engine_update_metadata_finish:
+ * @self: A #FuEngine
+ * @res: the #GAsyncResult
+ * @error: A #GError, or %NULL
+ *
+ * Gets the result of fu_engine_update_metadata_async().
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_update_metadata_finish (FuEngine *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+typedef struct {
+	gchar			*remote_id;
+	FuEngineMetadataHelper	*helper;	/* (nullable): nothing to compile */
+	XbSilo			*silo;		/* (nullable): set by the worker */
+	XbSilo			*silo_old;	/* (nullable) */
+	GError			*error;		/* (nullable): set by the worker */
+} FuEngineMetadataBatchItem;
+
+static void
+fu_engine_metadata_batch_item_free (FuEngineMetadataBatchItem *item)
+{
+	g_free (item->remote_id);
+	if (item->helper != NULL)
+		fu_engine_metadata_helper_free (item->helper);
+	if (item->silo != NULL)
+		g_object_unref (item->silo);
+	if (item->silo_old != NULL)
+		g_object_unref (item->silo_old);
+	if (item->error != NULL)
+		g_error_free (item->error);
+	g_free (item);
+}
+
+typedef struct {
+	GPtrArray		*items;		/* FuEngineMetadataBatchItem */
+	GError			*error;		/* (nullable): the first failure */
+} FuEngineMetadataBatch;
+
+static void
+fu_engine_metadata_batch_free (FuEngineMetadataBatch *batch)
+{
+	g_ptr_array_unref (batch->items);
+	if (batch->error != NULL)
+		g_error_free (batch->error);
+	g_free (batch);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineMetadataBatch, fu_engine_metadata_batch_free)
+
+/* keep going so the other remotes can still be updated */
+static void
+fu_engine_metadata_batch_add_error (FuEngineMetadataBatch *batch,
+				    const gchar *remote_id,
+				    GError *error)
+{
+	g_prefix_error (&error, "failed to update metadata for %s: ", remote_id);
+	g_warning ("%s", error->message);
+	if (batch->error == NULL) {
+		batch->error = error;
+		return;
+	}
+	g_error_free (error);
+}
+
+static void
+fu_engine_update_metadata_batch_thread_cb (GTask *task,
+					   gpointer source_object,
+					   gpointer task_data,
+					   GCancellable *cancellable)
+{
+	FuEngineMetadataBatch *batch = (FuEngineMetadataBatch *) task_data;
+	for (guint i = 0; i < batch->items->len; i++) {
+		FuEngineMetadataBatchItem *item = g_ptr_array_index (batch->items, i);
+		if (item->helper == NULL)
+			continue;
+		item->silo = fu_engine_metadata_helper_compile (item->helper,
+								cancellable,
+								&item->error);
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+/* back in the main thread */
+static void
+fu_engine_update_metadata_batch_compile_cb (GObject *source,
+					    GAsyncResult *res,
+					    gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (source);
+	FuEngineMetadataBatch *batch = g_task_get_task_data (G_TASK (res));
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GError) error = NULL;
+
+	if (!g_task_propagate_boolean (G_TASK (res), &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* swap in every silo that compiled before rebuilding the merged view */
+	for (guint i = 0; i < batch->items->len; i++) {
+		FuEngineMetadataBatchItem *item = g_ptr_array_index (batch->items, i);
+		XbSilo *silo_tmp = g_hash_table_lookup (self->silos_remote, item->remote_id);
+		if (item->error != NULL) {
+			fu_engine_metadata_batch_add_error (batch, item->remote_id,
+							    g_steal_pointer (&item->error));
+			continue;
+		}
+		if (silo_tmp != NULL)
+			item->silo_old = g_object_ref (silo_tmp);
+		if (item->silo == NULL) {
+			g_hash_table_remove (self->silos_remote, item->remote_id);
+			continue;
+		}
+		fu_engine_metadata_helper_swap (self, item->helper, item->silo);
+	}
+	fu_engine_silos_rebuild (self);
+
+	/* refresh SUPPORTED flag on devices */
+	for (guint i = 0; i < batch->items->len; i++) {
+		FuEngineMetadataBatchItem *item = g_ptr_array_index (batch->items, i);
+		if (item->silo == NULL && item->silo_old == NULL)
+			continue;
+		fu_engine_md_refresh_devices_changed (self, item->silo_old, item->silo);
+	}
+
+	/* invalidate host security attributes */
+	g_clear_pointer (&self->host_security_id, g_free);
+
+	/* make the UI update */
+	fu_engine_emit_changed (self);
+
+	/* some remotes may have failed */
+	if (batch->error != NULL) {
+		g_task_return_error (task, g_steal_pointer (&batch->error));
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * fu_engine_update_metadata_batch_async:
+ * @self: A #FuEngine
+ * @remote_ids: (element-type utf8): remote IDs, e.g. `lvfs`
+ * @fds: (element-type gint): file descriptors of the metadata and then the
+ * metadata signature for each remote in @remote_ids
+ * @cancellable: A #GCancellable, or %NULL
+ * @callback: the function to run on completion
+ * @callback_data: the data to pass to @callback
+ *
+ * Updates the metadata for several remotes, compiling all the new silos in
+ * one worker thread and then rebuilding the merged view only once.
+ *
+ * If a remote fails to verify or compile then the other remotes are still
+ * updated, and the first error is returned.
+ *
+ * Note: this will close the fds when done
+ **/
+void
+fu_engine_update_metadata_batch_async (FuEngine *self,
+				       GPtrArray *remote_ids,
+				       GArray *fds,
+				       GCancellable *cancellable,
+				       GAsyncReadyCallback callback,
+				       gpointer callback_data)
+{
+	g_autoptr(FuEngineMetadataBatch) batch = g_new0 (FuEngineMetadataBatch, 1);
+	g_autoptr(GTask) task = NULL;
+	g_autoptr(GTask) task_compile = NULL;
+
+	g_return_if_fail (FU_IS_ENGINE (self));
+	g_return_if_fail (remote_ids != NULL);
+	g_return_if_fail (fds != NULL);
+	g_return_if_fail (fds->len == remote_ids->len * 2);
+
+	/* verifying and saving is quick */
+	task = g_task_new (self, cancellable, callback, callback_data);
+	batch->items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_metadata_batch_item_free);
+	for (guint i = 0; i < remote_ids->len; i++) {
+		const gchar *remote_id = g_ptr_array_index (remote_ids, i);
+		FuEngineMetadataBatchItem *item;
+		FwupdRemote *remote = NULL;
+		GError *error = NULL;
+		g_autoptr(GBytes) bytes_raw = NULL;
+		g_autoptr(GBytes) bytes_sig = NULL;
+
+		/* always read so that every fd gets closed */
+		if (!fu_engine_update_metadata_read_fds (g_array_index (fds, gint, i * 2),
+							 g_array_index (fds, gint, (i * 2) + 1),
+							 &bytes_raw, &bytes_sig, &error)) {
+			fu_engine_metadata_batch_add_error (batch, remote_id, error);
+			continue;
+		}
+		if (!fu_engine_update_metadata_bytes_save (self, remote_id,
+							   bytes_raw, bytes_sig,
+							   &remote, &error)) {
+			fu_engine_metadata_batch_add_error (batch, remote_id, error);
+			continue;
+		}
+		if (remote == NULL)
+			continue;
+		item = g_new0 (FuEngineMetadataBatchItem, 1);
+		item->remote_id = g_strdup (remote_id);
+		item->helper = fu_engine_metadata_helper_new (self, remote,
+							      FU_ENGINE_LOAD_FLAG_NONE,
+							      &error);
+		if (item->helper == NULL) {
+			fu_engine_metadata_batch_add_error (batch, remote_id, error);
+			fu_engine_metadata_batch_item_free (item);
+			continue;
+		}
+
+		/* nothing to compile */
+		if (item->helper->xmlb == NULL)
+			g_clear_pointer (&item->helper, fu_engine_metadata_helper_free);
+		g_ptr_array_add (batch->items, item);
+	}
+
+	/* every signature was unchanged, or nothing could be verified */
+	if (batch->items->len == 0) {
+		if (batch->error != NULL) {
+			g_task_return_error (task, g_steal_pointer (&batch->error));
+			return;
+		}
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* compiling large catalogs is slow */
+	task_compile = g_task_new (self, cancellable,
+				   fu_engine_update_metadata_batch_compile_cb,
+				   g_steal_pointer (&task));
+	g_task_set_task_data (task_compile, g_steal_pointer (&batch),
+			      (GDestroyNotify) fu_engine_metadata_batch_free);
+	g_task_run_in_thread (task_compile, fu_engine_update_metadata_batch_thread_cb);
+}
+
+/**
+ * fu_engine_update_metadata_batch_finish:
+ * @self: A #FuEngine
+ * @res: the #GAsyncResult
+ * @error: A #GError, or %NULL
+ *
+ * Gets the result of fu_engine_update_metadata_batch_async().
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_update_metadata_batch_finish (FuEngine *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/**
+ * fu_engine_get_metadata_generation:
+ * @self: A #FuEngine
+ *
+ * Gets a number that is incremented each time the metadata changes, so
+ * that clients can tell when a new catalog is being used.
+ *
+ * Returns: integer
+ **/
+guint
+fu_engine_get_metadata_generation (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), 0);
+	return self->silos_generation;
+}
+
+static void
+fu_engine_cabinet_cache_item_free (FuEngineCabinetCacheItem *item)
+{
+	g_free (item->checksum);
+	g_object_unref (item->silo);
+	g_free (item->details_fingerprint);
+	if (item->details != NULL)
+		g_ptr_array_unref (item->details);
+	g_free (item);
+}
+
+static FuEngineCabinetCacheItem *
+fu_engine_cabinet_cache_lookup (FuEngine *self, const gchar *checksum)
+{
+	for (guint i = 0; i < self->cabinet_cache->len; i++) {
+		FuEngineCabinetCacheItem *item = g_ptr_array_index (self->cabinet_cache, i);
+		if (g_strcmp0 (item->checksum, checksum) == 0) {
+			item->atime = g_get_monotonic_time ();
+			return item;
+		}
+	}
+	return NULL;
+}
+
+static void
+fu_engine_cabinet_cache_add (FuEngine *self,
+			     const gchar *checksum,
+			     XbSilo *silo,
+			     gsize size)
+{
+	FuEngineCabinetCacheItem *item;
+	gsize total = size;
+
+	if (size > FU_ENGINE_CABINET_CACHE_SIZE_MAX)
+		return;
+
+	/* evict the least recently used */
+	for (guint i = 0; i < self->cabinet_cache->len; i++) {
+		FuEngineCabinetCacheItem *item_tmp = g_ptr_array_index (self->cabinet_cache, i);
+		total += item_tmp->size;
+	}
+	while (total > FU_ENGINE_CABINET_CACHE_SIZE_MAX) {
+		guint idx = 0;
+		FuEngineCabinetCacheItem *item_old = g_ptr_array_index (self->cabinet_cache, 0);
+		for (guint i = 1; i < self->cabinet_cache->len; i++) {
+			FuEngineCabinetCacheItem *item_tmp = g_ptr_array_index (self->cabinet_cache, i);
+			if (item_tmp->atime < item_old->atime) {
+				item_old = item_tmp;
+				idx = i;
+			}
+		}
+		total -= item_old->size;
+		g_ptr_array_remove_index_fast (self->cabinet_cache, idx);
+	}
+
+	item = g_new0 (FuEngineCabinetCacheItem, 1);
+	item->checksum = g_strdup (checksum);
+	item->silo = g_object_ref (silo);
+	item->size = size;
+	item->atime = g_get_monotonic_time ();
+	g_ptr_array_add (self->cabinet_cache, item);
+}
+
+static XbSilo *
+fu_engine_get_silo_from_blob_with_checksum (FuEngine *self,
+					    GBytes *blob_cab,
+					    const gchar *checksum,
+					    GError **error)
+{
+	FuEngineCabinetCacheItem *item;
+	g_autoptr(FuCabinet) cabinet = fu_cabinet_new ();
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* already decompressed and verified */
+	item = fu_engine_cabinet_cache_lookup (self, checksum);
+	if (item != NULL) {
+		g_debug ("using cached archive %s", checksum);
+		return g_object_ref (item->silo);
+	}
+
+	/* load file */
+	fu_engine_set_status (self, FWUPD_STATUS_DECOMPRESSING);
+	fu_cabinet_set_size_max (cabinet, fu_engine_get_archive_size_max (self));
+	fu_cabinet_set_jcat_context (cabinet, self->jcat_context);
+	if (!fu_cabinet_parse (cabinet, blob_cab, FU_CABINET_PARSE_FLAG_NONE, error))
+		return NULL;
+	silo = fu_cabinet_get_silo (cabinet);
+	fu_engine_cabinet_cache_add (self, checksum, silo, g_bytes_get_size (blob_cab));
+	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
+	return g_steal_pointer (&silo);
+}
+
+/**
+ * fu_engine_get_silo_from_blob:
+ * @self: A #FuEngine
+ * @blob_cab: A #GBytes
+ * @error: A #GError, or %NULL
+ *
+ * Creates a silo from a .cab file blob.
+ *
+ * Returns: (transfer container): a #XbSilo, or %NULL
+ **/
+XbSilo *
+fu_engine_get_silo_from_blob (FuEngine *self, GBytes *blob_cab, GError **error)
+{
+	g_autofree gchar *checksum = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (blob_cab != NULL, NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob_cab);
+	return fu_engine_get_silo_from_blob_with_checksum (self, blob_cab, checksum, error);
+}
+
+static FuDevice *
+fu_engine_get_result_from_component (FuEngine *self,
+				     FuEngineRequest *request,
+				     XbNode *component,
+				     GError **error)
+{
+	FwupdReleaseFlags release_flags = FWUPD_RELEASE_FLAG_NONE;
+	g_autoptr(FuInstallTask) task = NULL;
+	g_autoptr(FuDevice) dev = NULL;
+	g_autoptr(FwupdRelease) rel = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) provides = NULL;
+	g_autoptr(XbNode) description = NULL;
+	g_autoptr(XbNode) release = NULL;
+#if LIBXMLB_CHECK_VERSION(0,2,0)
+	g_autoptr(XbQuery) query = NULL;
+#endif
+
+	dev = fu_device_new ();
+	provides = xb_node_query (component,
+				  "provides/firmware[@type=$'flashed']",
+				  0, &error_local);
+	if (provides == NULL) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to get release: %s",
+			     error_local->message);
+		return NULL;
+	}
+	for (guint i = 0; i < provides->len; i++) {
+		XbNode *prov = XB_NODE (g_ptr_array_index (provides, i));
+		const gchar *guid;
+		g_autoptr(FuDevice) device = NULL;
+
+		/* is a online or offline update appropriate */
+		guid = xb_node_get_text (prov);
+		if (guid == NULL)
+			continue;
+		device = fu_device_list_get_by_guid (self->device_list, guid, NULL);
+		if (device != NULL) {
+			fu_device_set_name (dev, fu_device_get_name (device));
+			fu_device_set_flags (dev, fu_device_get_flags (device));
+			fu_device_set_id (dev, fu_device_get_id (device));
+			fu_device_set_version_raw (dev, fu_device_get_version_raw (device));
+			fu_device_set_version_format (dev, fu_device_get_version_format (device));
+			fu_device_set_version (dev, fu_device_get_version (device));
+		}
+
+		/* add GUID */
+		fu_device_add_guid (dev, guid);
+	}
+	if (fu_device_get_guids(dev)->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "component has no GUIDs");
+		return NULL;
+	}
+
+	/* check we can install it */
+	task = fu_install_task_new (NULL, component);
+	if (!fu_engine_check_requirements (self, request, task,
+					   FWUPD_INSTALL_FLAG_IGNORE_VID_PID,
+					   error))
+		return NULL;
+
+	/* verify trust */
+#if LIBXMLB_CHECK_VERSION(0,2,0)
+	query = xb_query_new_full (xb_node_get_silo (component),
+				   "releases/release",
+				   XB_QUERY_FLAG_FORCE_NODE_CACHE,
+				   error);
 	if (query == NULL)
 		return NULL;
 	release = xb_node_query_first_full (component, query, &error_local);
@@ -3996,6 +6126,28 @@ fu_engine_get_details_sort_cb (gconstpointer a, gconstpointer b)
 	return 0;
 }
 
+/* everything about the engine and request that changes the details built
+ * for an archive; the devices are matched against so any change invalidates */
+static gchar *
+fu_engine_details_cache_fingerprint (FuEngine *self, FuEngineRequest *request)
+{
+	return g_strdup_printf ("%u|%u|%u|%u|%" G_GUINT64_FORMAT,
+				self->devices_generation,
+				self->silos_generation,
+				self->releases_generation,
+				(guint) fu_engine_request_get_feature_flags (request),
+				(guint64) fu_engine_request_get_device_flags (request));
+}
+
+static GPtrArray *
+fu_engine_details_copy (GPtrArray *details)
+{
+	GPtrArray *results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < details->len; i++)
+		g_ptr_array_add (results, g_object_ref (g_ptr_array_index (details, i)));
+	return results;
+}
+
 /**
  * fu_engine_get_details:
  * @self: A #FuEngine
@@ -4012,8 +6164,11 @@ fu_engine_get_details_sort_cb (gconstpointer a, gconstpointer b)
 GPtrArray *
 fu_engine_get_details (FuEngine *self, FuEngineRequest *request, gint fd, GError **error)
 {
+	FuEngineCabinetCacheItem *item;
 	const gchar *remote_id;
+	g_autofree gchar *checksum = NULL;
 	g_autofree gchar *csum = NULL;
+	g_autofree gchar *fingerprint = NULL;
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) components = NULL;
@@ -4030,7 +6185,16 @@ fu_engine_get_details (FuEngine *self, FuEngineRequest *request, gint fd, GError
 					  error);
 	if (blob == NULL)
 		return NULL;
-	silo = fu_engine_get_silo_from_blob (self, blob, error);
+
+	/* clients often ask about the same archive more than once */
+	checksum = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, blob);
+	fingerprint = fu_engine_details_cache_fingerprint (self, request);
+	item = fu_engine_cabinet_cache_lookup (self, checksum);
+	if (item != NULL && g_strcmp0 (item->details_fingerprint, fingerprint) == 0) {
+		g_debug ("using cached details for %s", checksum);
+		return fu_engine_details_copy (item->details);
+	}
+	silo = fu_engine_get_silo_from_blob_with_checksum (self, blob, checksum, error);
 	if (silo == NULL)
 		return NULL;
 	components = xb_silo_query (silo,
@@ -4102,57 +6266,202 @@ fu_engine_get_details (FuEngine *self, FuEngineRequest *request, gint fd, GError
 	 * is listed first */
 	g_ptr_array_sort (details, fu_engine_get_details_sort_cb);
 
-	return g_steal_pointer (&details);
+	/* save for next time, unless the archive was too large to cache */
+	item = fu_engine_cabinet_cache_lookup (self, checksum);
+	if (item != NULL) {
+		g_free (item->details_fingerprint);
+		if (item->details != NULL)
+			g_ptr_array_unref (item->details);
+		item->details_fingerprint = g_steal_pointer (&fingerprint);
+		item->details = fu_engine_details_copy (details);
+	}
+	return g_steal_pointer (&details);
+}
+
+static gint
+fu_engine_sort_devices_by_priority_name (gconstpointer a, gconstpointer b)
+{
+	FuDevice *dev_a = *((FuDevice **) a);
+	FuDevice *dev_b = *((FuDevice **) b);
+	gint prio_a = fu_device_get_priority (dev_a);
+	gint prio_b = fu_device_get_priority (dev_b);
+	const gchar *name_a = fu_device_get_name (dev_a);
+	const gchar *name_b = fu_device_get_name (dev_b);
+
+	if (prio_a > prio_b)
+		return -1;
+	if (prio_a < prio_b)
+		return 1;
+	if (g_strcmp0 (name_a, name_b) > 0)
+		return 1;
+	if (g_strcmp0 (name_a, name_b) < 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * fu_engine_get_devices:
+ * @self: A #FuEngine
+ * @error: A #GError, or %NULL
+ *
+ * Gets the list of devices.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice): results
+ **/
+GPtrArray *
+fu_engine_get_devices (FuEngine *self, GError **error)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	devices = fu_device_list_get_active (self->device_list);
+	if (devices->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "No detected devices");
+		return NULL;
+	}
+	g_ptr_array_sort (devices, fu_engine_sort_devices_by_priority_name);
+	return g_steal_pointer (&devices);
+}
+
+/**
+ * fu_engine_get_devices_cached:
+ * @self: A #FuEngine
+ *
+ * Gets the devices found when the daemon last ran in this boot, which is only
+ * useful before fu_engine_coldplug() has completed.
+ *
+ * Returns: (transfer container) (element-type FwupdDevice) (nullable): results
+ **/
+GPtrArray *
+fu_engine_get_devices_cached (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	if (self->loaded || self->devices_cached == NULL)
+		return NULL;
+	return g_ptr_array_ref (self->devices_cached);
+}
+
+/**
+ * fu_engine_get_profile:
+ * @self: A #FuEngine
+ *
+ * Gets the timing profile recorded while loading the engine and enumerating
+ * devices.
+ *
+ * Returns: (transfer none): a #FuProfile
+ **/
+FuProfile *
+fu_engine_get_profile (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	return self->profile;
 }
 
-static gint
-fu_engine_sort_devices_by_priority_name (gconstpointer a, gconstpointer b)
+/**
+ * fu_engine_get_config:
+ * @self: A #FuEngine
+ *
+ * Gets the daemon configuration.
+ *
+ * Returns: (transfer none): a #FuConfig
+ **/
+FuConfig *
+fu_engine_get_config (FuEngine *self)
 {
-	FuDevice *dev_a = *((FuDevice **) a);
-	FuDevice *dev_b = *((FuDevice **) b);
-	gint prio_a = fu_device_get_priority (dev_a);
-	gint prio_b = fu_device_get_priority (dev_b);
-	const gchar *name_a = fu_device_get_name (dev_a);
-	const gchar *name_b = fu_device_get_name (dev_b);
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	return self->config;
+}
 
-	if (prio_a > prio_b)
-		return -1;
-	if (prio_a < prio_b)
-		return 1;
-	if (g_strcmp0 (name_a, name_b) > 0)
-		return 1;
-	if (g_strcmp0 (name_a, name_b) < 0)
-		return -1;
-	return 0;
+/**
+ * fu_engine_get_metrics:
+ * @self: A #FuEngine
+ *
+ * Gets the counters and timings recorded since the engine was created.
+ *
+ * Returns: (transfer none): a #FuMetrics
+ **/
+FuMetrics *
+fu_engine_get_metrics (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	return self->metrics;
 }
 
 /**
- * fu_engine_get_devices:
+ * fu_engine_get_metrics_string:
  * @self: A #FuEngine
  * @error: A #GError, or %NULL
  *
- * Gets the list of devices.
+ * Exports the metrics in the OpenMetrics text format, including the values
+ * that are only sampled when read, such as the number of devices.
  *
- * Returns: (transfer container) (element-type FwupdDevice): results
+ * Returns: (transfer full): a string, or %NULL if `EnableMetrics` is not set
  **/
-GPtrArray *
-fu_engine_get_devices (FuEngine *self, GError **error)
+/* the second field of statm is the resident set size in pages */
+static guint64
+fu_engine_get_resident_memory (void)
+{
+	g_autofree gchar *statm = NULL;
+	g_auto(GStrv) split = NULL;
+
+	if (!g_file_get_contents ("/proc/self/statm", &statm, NULL, NULL))
+		return 0;
+	split = g_strsplit (statm, " ", -1);
+	if (g_strv_length (split) < 2)
+		return 0;
+	return g_ascii_strtoull (split[1], NULL, 10) * sysconf (_SC_PAGESIZE);
+}
+
+gchar *
+fu_engine_get_metrics_string (FuEngine *self, GError **error)
 {
+	guint hits = 0;
+	guint misses = 0;
+	guint64 rss;
+	GPtrArray *plugins;
 	g_autoptr(GPtrArray) devices = NULL;
 
 	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
-	devices = fu_device_list_get_active (self->device_list);
-	if (devices->len == 0) {
+	if (!fu_config_get_enable_metrics (self->config)) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
-				     FWUPD_ERROR_NOTHING_TO_DO,
-				     "No detected devices");
+				     FWUPD_ERROR_NOT_SUPPORTED,
+				     "metrics are not enabled in daemon.conf");
 		return NULL;
 	}
-	g_ptr_array_sort (devices, fu_engine_sort_devices_by_priority_name);
-	return g_steal_pointer (&devices);
+	devices = fu_device_list_get_all (self->device_list);
+	fu_metrics_set (self->metrics, "fwupd_devices", NULL, devices->len);
+	fu_quirks_get_lookup_stats (self->quirks, &hits, &misses);
+	fu_metrics_set (self->metrics, "fwupd_quirk_lookups", "hit", hits);
+	fu_metrics_set (self->metrics, "fwupd_quirk_lookups", "miss", misses);
+	plugins = fu_plugin_list_get_all (self->plugin_list);
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		guint64 calls = 0;
+		guint64 cputime = 0;
+		fu_plugin_get_runner_stats (plugin, &calls, &cputime);
+		if (calls == 0)
+			continue;
+		fu_metrics_set (self->metrics, "fwupd_plugin_runner_calls",
+				fu_plugin_get_name (plugin), (gdouble) calls);
+		fu_metrics_set (self->metrics, "fwupd_plugin_runner_cpu_seconds",
+				fu_plugin_get_name (plugin),
+				(gdouble) cputime / G_USEC_PER_SEC);
+	}
+
+	rss = fu_engine_get_resident_memory ();
+	if (rss > 0) {
+		fu_metrics_set (self->metrics, "process_resident_memory_bytes",
+				NULL, (gdouble) rss);
+	}
+	return fu_metrics_to_string (self->metrics);
 }
 
 /**
@@ -4351,23 +6660,48 @@ fu_engine_get_remote_by_id (FuEngine *self, const gchar *remote_id, GError **err
 }
 
 
+typedef struct {
+	FwupdRelease	*rel;
+	FuVersionKey	 key;
+} FuEngineSortReleaseItem;
+
 static gint
 fu_engine_sort_releases_cb (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-	FuDevice *device = FU_DEVICE (user_data);
-	FwupdRelease *rel_a = FWUPD_RELEASE (*((FwupdRelease **) a));
-	FwupdRelease *rel_b = FWUPD_RELEASE (*((FwupdRelease **) b));
+	const FuEngineSortReleaseItem *item_a = (const FuEngineSortReleaseItem *) a;
+	const FuEngineSortReleaseItem *item_b = (const FuEngineSortReleaseItem *) b;
 	gint rc;
 
 	/* first by branch */
-	rc = g_strcmp0 (fwupd_release_get_branch (rel_b), fwupd_release_get_branch (rel_a));
+	rc = g_strcmp0 (fwupd_release_get_branch (item_b->rel),
+			fwupd_release_get_branch (item_a->rel));
 	if (rc != 0)
 		return rc;
 
 	/* then by version */
-	return fu_common_vercmp_full (fwupd_release_get_version (rel_b),
-				      fwupd_release_get_version (rel_a),
-				      fu_device_get_version_format (device));
+	return fu_common_version_key_cmp (&item_b->key, &item_a->key);
+}
+
+/* parse each version once and then sort using the keys */
+static void
+fu_engine_sort_releases_by_version (FuDevice *device, GPtrArray *releases)
+{
+	FwupdVersionFormat fmt = fu_device_get_version_format (device);
+	g_autofree FuEngineSortReleaseItem *items = NULL;
+
+	if (releases->len < 2)
+		return;
+	items = g_new0 (FuEngineSortReleaseItem, releases->len);
+	for (guint i = 0; i < releases->len; i++) {
+		items[i].rel = g_ptr_array_index (releases, i);
+		fu_common_version_key_init (&items[i].key,
+					    fwupd_release_get_version (items[i].rel),
+					    fmt);
+	}
+	g_qsort_with_data (items, releases->len, sizeof(FuEngineSortReleaseItem),
+			   fu_engine_sort_releases_cb, NULL);
+	for (guint i = 0; i < releases->len; i++)
+		releases->pdata[i] = items[i].rel;
 }
 
 static gboolean
@@ -4399,45 +6733,83 @@ fu_engine_check_release_is_blocked (FuEngine *self, FwupdRelease *rel)
 	return FALSE;
 }
 
-static gboolean
-fu_engine_add_releases_for_device_component (FuEngine *self,
-					     FuEngineRequest *request,
-					     FuDevice *device,
-					     XbNode *component,
-					     GPtrArray *releases,
-					     GError **error)
+typedef struct {
+	gchar			*fingerprint;
+	GPtrArray		*releases;	/* (element-type FwupdRelease) */
+} FuEngineReleaseCacheItem;
+
+static void
+fu_engine_release_cache_item_free (FuEngineReleaseCacheItem *item)
+{
+	g_free (item->fingerprint);
+	g_ptr_array_unref (item->releases);
+	g_free (item);
+}
+
+/* everything about the device, request and engine that changes the releases
+ * built for a component */
+static gchar *
+fu_engine_release_cache_fingerprint (FuEngine *self,
+				     FuEngineRequest *request,
+				     FuDevice *device)
+{
+	FwupdFeatureFlags feature_flags = fu_engine_request_get_feature_flags (request);
+	const gchar *version_lowest = fu_device_get_version_lowest (device);
+	const gchar *branch = fu_device_get_branch (device);
+	return g_strdup_printf ("%u|%s|%s|%s|%u|%u|%u",
+				self->releases_generation,
+				fu_device_get_version (device),
+				version_lowest != NULL ? version_lowest : "",
+				branch != NULL ? branch : "",
+				fu_device_get_version_format (device),
+				fu_device_get_install_duration (device),
+				(feature_flags & FWUPD_FEATURE_FLAG_SWITCH_BRANCH) > 0);
+}
+
+/* builds the releases the device could use from one component, returning
+ * an empty array if there are none */
+static GPtrArray *
+fu_engine_build_releases_for_device_component (FuEngine *self,
+					       FuEngineRequest *request,
+					       FuDevice *device,
+					       XbNode *component,
+					       GError **error)
 {
 	FwupdFeatureFlags feature_flags;
 	FwupdVersionFormat fmt = fu_device_get_version_format (device);
+	gboolean is_alternate_branch = FALSE;
 	g_autoptr(GError) error_local = NULL;
-	g_autoptr(FuInstallTask) task = fu_install_task_new (device, component);
+	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_tmp = NULL;
 
-	if (!fu_engine_check_requirements (self, request, task,
-					   FWUPD_INSTALL_FLAG_OFFLINE |
-					   FWUPD_INSTALL_FLAG_IGNORE_VID_PID |
-					   FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH |
-					   FWUPD_INSTALL_FLAG_ALLOW_REINSTALL |
-					   FWUPD_INSTALL_FLAG_ALLOW_OLDER,
-					   error))
-		return FALSE;
+	releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+	/* the branch is set from the component, so avoid building releases
+	 * the client would not be able to show */
+	feature_flags = fu_engine_request_get_feature_flags (request);
+	if (g_strcmp0 (xb_node_query_text (component, "branch", NULL),
+		       fu_device_get_branch (device)) != 0) {
+		if ((feature_flags & FWUPD_FEATURE_FLAG_SWITCH_BRANCH) == 0) {
+			g_debug ("client does not understand branches, skipping %s",
+				 xb_node_query_text (component, "id", NULL));
+			return g_steal_pointer (&releases);
+		}
+		is_alternate_branch = TRUE;
+	}
 
 	/* get all releases */
 	releases_tmp = xb_node_query (component, "releases/release", 0, &error_local);
 	if (releases_tmp == NULL) {
 		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-			return TRUE;
+			return g_steal_pointer (&releases);
 		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT))
-			return TRUE;
+			return g_steal_pointer (&releases);
 		g_propagate_error (error, g_steal_pointer (&error_local));
-		return FALSE;
+		return NULL;
 	}
-	feature_flags = fu_engine_request_get_feature_flags (request);
 	for (guint i = 0; i < releases_tmp->len; i++) {
 		XbNode *release = g_ptr_array_index (releases_tmp, i);
 		const gchar *remote_id;
-		const gchar *update_message;
-		const gchar *update_image;
 		gint vercmp;
 		GPtrArray *checksums;
 		GPtrArray *locations;
@@ -4469,16 +6841,8 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 			continue;
 
 		/* different branch */
-		if (g_strcmp0 (fwupd_release_get_branch (rel),
-			       fu_device_get_branch (device)) != 0) {
-			if ((feature_flags & FWUPD_FEATURE_FLAG_SWITCH_BRANCH) == 0) {
-				g_debug ("client does not understand branches, skipping %s:%s",
-					 fwupd_release_get_branch (rel),
-					 fwupd_release_get_version (rel));
-				continue;
-			}
+		if (is_alternate_branch)
 			fwupd_release_add_flag (rel, FWUPD_RELEASE_FLAG_IS_ALTERNATE_BRANCH);
-		}
 
 		/* test for upgrade or downgrade */
 		vercmp = fu_common_vercmp_full (fwupd_release_get_version (rel),
@@ -4512,6 +6876,91 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 			}
 		}
 
+		/* success */
+		g_ptr_array_add (releases, g_steal_pointer (&rel));
+	}
+
+	/* success */
+	return g_steal_pointer (&releases);
+}
+
+/* the releases are cached on the component for each device, so they are
+ * only built again when the silo is replaced or the device changes; the
+ * returned releases are shared and must not be modified */
+static GPtrArray *
+fu_engine_get_releases_for_device_component (FuEngine *self,
+					     FuEngineRequest *request,
+					     FuDevice *device,
+					     XbNode *component,
+					     GError **error)
+{
+	FuEngineReleaseCacheItem *item;
+	GHashTable *cache;
+	g_autofree gchar *fingerprint = NULL;
+	g_autoptr(GPtrArray) releases = NULL;
+
+	/* refresh the device to the new version format first */
+	fu_engine_md_refresh_device_from_component (self, device, component);
+
+	cache = g_object_get_data (G_OBJECT (component), "FuEngine::releases");
+	if (cache == NULL) {
+		cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					       (GDestroyNotify) fu_engine_release_cache_item_free);
+		g_object_set_data_full (G_OBJECT (component), "FuEngine::releases", cache,
+					(GDestroyNotify) g_hash_table_unref);
+	}
+	fingerprint = fu_engine_release_cache_fingerprint (self, request, device);
+	item = g_hash_table_lookup (cache, fu_device_get_id (device));
+	if (item != NULL && g_strcmp0 (item->fingerprint, fingerprint) == 0)
+		return g_ptr_array_ref (item->releases);
+
+	releases = fu_engine_build_releases_for_device_component (self,
+								  request,
+								  device,
+								  component,
+								  error);
+	if (releases == NULL)
+		return NULL;
+	item = g_new0 (FuEngineReleaseCacheItem, 1);
+	item->fingerprint = g_steal_pointer (&fingerprint);
+	item->releases = g_ptr_array_ref (releases);
+	g_hash_table_insert (cache, g_strdup (fu_device_get_id (device)), item);
+	return g_steal_pointer (&releases);
+}
+
+static gboolean
+fu_engine_add_releases_for_device_component (FuEngine *self,
+					     FuEngineRequest *request,
+					     FuDevice *device,
+					     XbNode *component,
+					     GPtrArray *releases,
+					     GError **error)
+{
+	g_autoptr(FuInstallTask) task = fu_install_task_new (device, component);
+	g_autoptr(GPtrArray) releases_tmp = NULL;
+
+	if (!fu_engine_check_requirements (self, request, task,
+					   FWUPD_INSTALL_FLAG_OFFLINE |
+					   FWUPD_INSTALL_FLAG_IGNORE_VID_PID |
+					   FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH |
+					   FWUPD_INSTALL_FLAG_ALLOW_REINSTALL |
+					   FWUPD_INSTALL_FLAG_ALLOW_OLDER,
+					   error))
+		return FALSE;
+
+	/* only built for components that pass the requirements */
+	releases_tmp = fu_engine_get_releases_for_device_component (self,
+								    request,
+								    device,
+								    component,
+								    error);
+	if (releases_tmp == NULL)
+		return FALSE;
+	for (guint i = 0; i < releases_tmp->len; i++) {
+		FwupdRelease *rel = g_ptr_array_index (releases_tmp, i);
+		const gchar *update_message;
+		const gchar *update_image;
+
 		/* add update message if exists but device doesn't already have one */
 		update_message = fwupd_release_get_update_message (rel);
 		if (fwupd_device_get_update_message (FWUPD_DEVICE (device)) == NULL &&
@@ -4523,8 +6972,7 @@ fu_engine_add_releases_for_device_component (FuEngine *self,
 		    update_image != NULL) {
 			fwupd_device_set_update_image (FWUPD_DEVICE (device), update_image);
 		}
-		/* success */
-		g_ptr_array_add (releases, g_steal_pointer (&rel));
+		g_ptr_array_add (releases, g_object_ref (rel));
 	}
 
 	/* success */
@@ -4552,7 +7000,6 @@ fu_engine_get_releases_for_device (FuEngine *self,
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) branches = NULL;
 	g_autoptr(GPtrArray) components = NULL;
-	g_autoptr(GString) xpath = g_string_new (NULL);
 
 	/* get device version */
 	version = fu_device_get_version (device);
@@ -4575,17 +7022,9 @@ fu_engine_get_releases_for_device (FuEngine *self,
 
 	/* get all the components that provide any of these GUIDs */
 	device_guids = fu_device_get_guids (device);
-	for (guint i = 0; i < device_guids->len; i++) {
-		const gchar *guid = g_ptr_array_index (device_guids, i);
-		xb_string_append_union (xpath,
-					"components/component[@type='firmware']/"
-					"provides/firmware[@type=$'flashed'][text()=$'%s']/"
-					"../..", guid);
-	}
-	components = xb_silo_query (self->silo, xpath->str, 0, &error_local);
+	components = fu_engine_silos_query_guids (self, device_guids, 0, &error_local);
 	if (components == NULL) {
-		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND) ||
-		    g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+		if (g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
 			g_set_error_literal (error,
 					     FWUPD_ERROR,
 					     FWUPD_ERROR_NOTHING_TO_DO,
@@ -4690,7 +7129,7 @@ fu_engine_get_releases (FuEngine *self,
 				     "No releases for device");
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
@@ -4794,7 +7233,7 @@ fu_engine_get_downgrades (FuEngine *self,
 		}
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
@@ -4822,6 +7261,7 @@ fu_engine_add_approved_firmware (FuEngine *self, const gchar *checksum)
 								 NULL);
 	}
 	g_hash_table_add (self->approved_firmware, g_strdup (checksum));
+	self->releases_generation++;
 }
 
 GPtrArray *
@@ -4848,6 +7288,7 @@ fu_engine_add_blocked_firmware (FuEngine *self, const gchar *checksum)
 								NULL);
 	}
 	g_hash_table_add (self->blocked_firmware, g_strdup (checksum));
+	self->releases_generation++;
 }
 
 gboolean
@@ -4858,6 +7299,7 @@ fu_engine_set_blocked_firmware (FuEngine *self, GPtrArray *checksums, GError **e
 		g_hash_table_unref (self->blocked_firmware);
 		self->blocked_firmware = NULL;
 	}
+	self->releases_generation++;
 	for (guint i = 0; i < checksums->len; i++) {
 		const gchar *csum = g_ptr_array_index (checksums, i);
 		fu_engine_add_blocked_firmware (self, csum);
@@ -5012,7 +7454,7 @@ fu_engine_get_upgrades (FuEngine *self,
 		}
 		return NULL;
 	}
-	g_ptr_array_sort_with_data (releases, fu_engine_sort_releases_cb, device);
+	fu_engine_sort_releases_by_version (device, releases);
 	return g_steal_pointer (&releases);
 }
 
@@ -5088,37 +7530,254 @@ fu_engine_get_results (FuEngine *self, const gchar *device_id, GError **error)
 	if (device == NULL)
 		return NULL;
 
-	/* the notification has already been shown to the user */
-	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_NOTIFIED)) {
-		g_set_error (error,
-			     FWUPD_ERROR,
-			     FWUPD_ERROR_NOTHING_TO_DO,
-			     "User has already been notified about %s [%s]",
-			     fu_device_get_name (device),
-			     fu_device_get_id (device));
-		return NULL;
+	/* the notification has already been shown to the user */
+	if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_NOTIFIED)) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_NOTHING_TO_DO,
+			     "User has already been notified about %s [%s]",
+			     fu_device_get_name (device),
+			     fu_device_get_id (device));
+		return NULL;
+	}
+
+	/* success */
+	return g_object_ref (FWUPD_DEVICE (device));
+}
+
+static void
+fu_engine_plugins_setup (FuEngine *self)
+{
+	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	for (guint i = 0; i < plugins->len; i++) {
+		g_autoptr(GError) error = NULL;
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, "startup(%s)", fu_plugin_get_name (plugin));
+		if (!fu_plugin_runner_startup (plugin, &error)) {
+			fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
+			if (g_error_matches (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_NOT_SUPPORTED)) {
+				fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_NO_HARDWARE);
+			}
+			g_message ("disabling plugin because: %s", error->message);
+		}
+		fu_profile_pop (self->profile);
+	}
+}
+
+typedef enum {
+	FU_ENGINE_COLDPLUG_EVENT_DEVICE_ADDED,
+	FU_ENGINE_COLDPLUG_EVENT_DEVICE_REMOVED,
+	FU_ENGINE_COLDPLUG_EVENT_DEVICE_REGISTER,
+} FuEngineColdplugEventKind;
+
+typedef struct {
+	FuEngineColdplugEventKind	 kind;
+	FuPlugin			*plugin;
+	FuDevice			*device;
+} FuEngineColdplugEvent;
+
+typedef struct {
+	FuPlugin			*plugin;
+	GError				*error;
+	gdouble				 elapsed;	/* ms */
+} FuEngineColdplugHelper;
+
+static void fu_engine_plugin_device_added_cb	(FuPlugin	*plugin,
+						 FuDevice	*device,
+						 gpointer	 user_data);
+static void fu_engine_plugin_device_removed_cb	(FuPlugin	*plugin,
+						 FuDevice	*device,
+						 gpointer	 user_data);
+static void fu_engine_plugin_device_register_cb	(FuPlugin	*plugin,
+						 FuDevice	*device,
+						 gpointer	 user_data);
+
+static void
+fu_engine_coldplug_event_free (FuEngineColdplugEvent *event)
+{
+	g_object_unref (event->plugin);
+	g_object_unref (event->device);
+	g_free (event);
+}
+
+/* called from a plugin callback: if this is a coldplug worker thread then
+ * queue the event so it can be processed by the main thread later */
+static gboolean
+fu_engine_coldplug_event_defer (FuEngine *self,
+				FuEngineColdplugEventKind kind,
+				FuPlugin *plugin,
+				FuDevice *device)
+{
+	FuEngineColdplugEvent *event;
+	if (g_thread_self () == self->main_thread)
+		return FALSE;
+	event = g_new0 (FuEngineColdplugEvent, 1);
+	event->kind = kind;
+	event->plugin = g_object_ref (plugin);
+	event->device = g_object_ref (device);
+	g_async_queue_push (self->coldplug_events, event);
+	return TRUE;
+}
+
+static void
+fu_engine_coldplug_events_flush (FuEngine *self)
+{
+	FuEngineColdplugEvent *event;
+	while ((event = g_async_queue_try_pop (self->coldplug_events)) != NULL) {
+		switch (event->kind) {
+		case FU_ENGINE_COLDPLUG_EVENT_DEVICE_ADDED:
+			fu_engine_plugin_device_added_cb (event->plugin, event->device, self);
+			break;
+		case FU_ENGINE_COLDPLUG_EVENT_DEVICE_REMOVED:
+			fu_engine_plugin_device_removed_cb (event->plugin, event->device, self);
+			break;
+		case FU_ENGINE_COLDPLUG_EVENT_DEVICE_REGISTER:
+			fu_engine_plugin_device_register_cb (event->plugin, event->device, self);
+			break;
+		default:
+			break;
+		}
+		fu_engine_coldplug_event_free (event);
+	}
+}
+
+static void
+fu_engine_plugins_coldplug_thread_cb (gpointer data, gpointer user_data)
+{
+	FuEngineColdplugHelper *helper = (FuEngineColdplugHelper *) data;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	fu_plugin_runner_coldplug (helper->plugin, &helper->error);
+	helper->elapsed = g_timer_elapsed (timer, NULL) * 1000.f;
+}
+
+/* plugins with no ordering rules are run in worker threads, and then the
+ * remaining plugins are run in depsolved order in the main thread */
+static void
+fu_engine_plugins_coldplug_concurrent (FuEngine *self, GPtrArray *plugins)
+{
+	GThreadPool *pool;
+	g_autoptr(GError) error_pool = NULL;
+	g_autoptr(GArray) helpers = g_array_new (FALSE, TRUE, sizeof(FuEngineColdplugHelper));
+	g_autoptr(GPtrArray) plugins_ordered = g_ptr_array_new ();
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* split into the independent and ordered sets */
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		FuEngineColdplugHelper helper = { plugin, NULL, 0.f };
+		if (fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED))
+			continue;
+		if (fu_plugin_list_has_order_rules (self->plugin_list, plugin)) {
+			g_ptr_array_add (plugins_ordered, plugin);
+			continue;
+		}
+		g_array_append_val (helpers, helper);
+	}
+
+	/* run the independent plugins on a worker pool */
+	pool = g_thread_pool_new (fu_engine_plugins_coldplug_thread_cb, self,
+				  (gint) g_get_num_processors (), TRUE,
+				  &error_pool);
+	if (pool == NULL) {
+		g_warning ("failed to create coldplug pool, using main thread: %s",
+			   error_pool->message);
+		for (guint i = 0; i < helpers->len; i++) {
+			FuEngineColdplugHelper *helper = &g_array_index (helpers, FuEngineColdplugHelper, i);
+			fu_engine_plugins_coldplug_thread_cb (helper, self);
+		}
+	} else {
+		for (guint i = 0; i < helpers->len; i++) {
+			FuEngineColdplugHelper *helper = &g_array_index (helpers, FuEngineColdplugHelper, i);
+			g_autoptr(GError) error_local = NULL;
+			if (!g_thread_pool_push (pool, helper, &error_local)) {
+				g_warning ("failed to push %s to coldplug pool: %s",
+					   fu_plugin_get_name (helper->plugin),
+					   error_local->message);
+				fu_engine_plugins_coldplug_thread_cb (helper, self);
+			}
+		}
+
+		/* wait for all the workers to finish */
+		g_thread_pool_free (pool, FALSE, TRUE);
+	}
+
+	/* process everything the workers added or removed */
+	fu_engine_coldplug_events_flush (self);
+	for (guint i = 0; i < helpers->len; i++) {
+		FuEngineColdplugHelper *helper = &g_array_index (helpers, FuEngineColdplugHelper, i);
+		g_autofree gchar *id = g_strdup_printf ("coldplug(%s)",
+							fu_plugin_get_name (helper->plugin));
+		g_debug ("%s took %.1fms in worker", id, helper->elapsed);
+		fu_profile_add (self->profile, id, helper->elapsed);
+		fu_metrics_set (self->metrics, "fwupd_plugin_coldplug_duration_seconds",
+				fu_plugin_get_name (helper->plugin), helper->elapsed / 1000.f);
+		if (helper->error != NULL) {
+			fu_plugin_add_flag (helper->plugin, FWUPD_PLUGIN_FLAG_DISABLED);
+			g_message ("disabling plugin because: %s",
+				   helper->error->message);
+			g_clear_error (&helper->error);
+		}
 	}
 
-	/* success */
-	return g_object_ref (FWUPD_DEVICE (device));
+	/* now the plugins that care about the order */
+	for (guint i = 0; i < plugins_ordered->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins_ordered, i);
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GTimer) timer_plugin = g_timer_new ();
+		fu_profile_push (self->profile, "coldplug(%s)", fu_plugin_get_name (plugin));
+		if (!fu_plugin_runner_coldplug (plugin, &error)) {
+			fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
+			g_message ("disabling plugin because: %s",
+				   error->message);
+		}
+		fu_profile_pop (self->profile);
+		fu_metrics_set (self->metrics, "fwupd_plugin_coldplug_duration_seconds",
+				fu_plugin_get_name (plugin),
+				g_timer_elapsed (timer_plugin, NULL));
+		g_debug ("coldplug(%s) took %.1fms",
+			 fu_plugin_get_name (plugin),
+			 g_timer_elapsed (timer_plugin, NULL) * 1000.f);
+	}
+	g_debug ("concurrent coldplug of %u+%u plugins took %.1fms",
+		 helpers->len, plugins_ordered->len,
+		 g_timer_elapsed (timer, NULL) * 1000.f);
 }
 
+/* plugins that found no hardware at startup never get any devices */
 static void
-fu_engine_plugins_setup (FuEngine *self)
+fu_engine_release_memory (FuEngine *self)
 {
 	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
+	guint64 rss_before = fu_engine_get_resident_memory ();
+	guint64 rss_after;
+	g_autoptr(GPtrArray) plugins_unused = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
 	for (guint i = 0; i < plugins->len; i++) {
-		g_autoptr(GError) error = NULL;
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
-		if (!fu_plugin_runner_startup (plugin, &error)) {
-			fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
-			if (g_error_matches (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_NOT_SUPPORTED)) {
-				fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_NO_HARDWARE);
-			}
-			g_message ("disabling plugin because: %s", error->message);
-		}
+		if (fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_NO_HARDWARE))
+			g_ptr_array_add (plugins_unused, g_object_ref (plugin));
+	}
+	for (guint i = 0; i < plugins_unused->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins_unused, i);
+		g_debug ("unloading %s as no hardware was found",
+			 fu_plugin_get_name (plugin));
+		fu_plugin_list_remove (self->plugin_list, plugin);
+	}
+	g_ptr_array_set_size (plugins_unused, 0);
+
+#ifdef HAVE_MALLOC_TRIM
+	/* return the freed heap to the system */
+	malloc_trim (0);
+#endif
+
+	rss_after = fu_engine_get_resident_memory ();
+	if (rss_before > 0 && rss_after > 0) {
+		g_autofree gchar *str_before = g_format_size (rss_before);
+		g_autofree gchar *str_after = g_format_size (rss_after);
+		g_message ("resident memory was %s and is now %s",
+			   str_before, str_after);
 	}
 }
 
@@ -5147,17 +7806,29 @@ fu_engine_plugins_coldplug (FuEngine *self, gboolean is_recoldplug)
 	}
 
 	/* exec */
-	for (guint i = 0; i < plugins->len; i++) {
-		g_autoptr(GError) error = NULL;
-		FuPlugin *plugin = g_ptr_array_index (plugins, i);
-		if (is_recoldplug) {
-			if (!fu_plugin_runner_recoldplug (plugin, &error))
-				g_message ("failed recoldplug: %s", error->message);
-		} else {
-			if (!fu_plugin_runner_coldplug (plugin, &error)) {
-				fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
-				g_message ("disabling plugin because: %s",
-					   error->message);
+	if (!is_recoldplug && fu_config_get_concurrent_coldplug (self->config)) {
+		fu_engine_plugins_coldplug_concurrent (self, plugins);
+	} else {
+		for (guint i = 0; i < plugins->len; i++) {
+			g_autoptr(GError) error = NULL;
+			FuPlugin *plugin = g_ptr_array_index (plugins, i);
+			if (is_recoldplug) {
+				if (!fu_plugin_runner_recoldplug (plugin, &error))
+					g_message ("failed recoldplug: %s", error->message);
+			} else {
+				g_autoptr(GTimer) timer_plugin = g_timer_new ();
+				fu_profile_push (self->profile, "coldplug(%s)",
+						 fu_plugin_get_name (plugin));
+				if (!fu_plugin_runner_coldplug (plugin, &error)) {
+					fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
+					g_message ("disabling plugin because: %s",
+						   error->message);
+				}
+				fu_profile_pop (self->profile);
+				fu_metrics_set (self->metrics,
+						"fwupd_plugin_coldplug_duration_seconds",
+						fu_plugin_get_name (plugin),
+						g_timer_elapsed (timer_plugin, NULL));
 			}
 		}
 	}
@@ -5209,6 +7880,9 @@ fu_engine_plugin_device_register_cb (FuPlugin *plugin,
 				    gpointer user_data)
 {
 	FuEngine *self = FU_ENGINE (user_data);
+	if (fu_engine_coldplug_event_defer (self, FU_ENGINE_COLDPLUG_EVENT_DEVICE_REGISTER,
+					    plugin, device))
+		return;
 	fu_engine_plugin_device_register (self, device);
 }
 
@@ -5219,6 +7893,11 @@ fu_engine_plugin_device_added_cb (FuPlugin *plugin,
 {
 	FuEngine *self = FU_ENGINE (user_data);
 
+	/* called from a coldplug worker thread */
+	if (fu_engine_coldplug_event_defer (self, FU_ENGINE_COLDPLUG_EVENT_DEVICE_ADDED,
+					    plugin, device))
+		return;
+
 	/* plugin has prio and device not already set from quirk */
 	if (fu_plugin_get_priority (plugin) > 0 &&
 	    fu_device_get_priority (device) == 0) {
@@ -5235,46 +7914,68 @@ static void
 fu_engine_adopt_children (FuEngine *self, FuDevice *device)
 {
 	GPtrArray *guids;
+	FuDevice *parent = NULL;
+	guint parent_idx = G_MAXUINT;
+	g_autoptr(GHashTable) guids_new = g_hash_table_new (g_str_hash, g_str_equal);
+	g_autoptr(GHashTable) parent_guids_new = g_hash_table_new (g_str_hash, g_str_equal);
 	g_autoptr(GPtrArray) devices = fu_device_list_get_active (self->device_list);
 
-	/* find the parent GUID in any existing device */
+	/* index the new device so that each existing device is only visited once
+	 * rather than once for each GUID, and the earliest parent GUID wins */
+	guids = fu_device_get_guids (device);
+	for (guint j = 0; j < guids->len; j++)
+		g_hash_table_add (guids_new, g_ptr_array_index (guids, j));
 	guids = fu_device_get_parent_guids (device);
 	for (guint j = 0; j < guids->len; j++) {
 		const gchar *guid = g_ptr_array_index (guids, j);
-		for (guint i = 0; i < devices->len; i++) {
-			FuDevice *device_tmp = g_ptr_array_index (devices, i);
-			if (fu_device_get_parent (device) != NULL)
-				continue;
-			if (fu_device_has_guid (device_tmp, guid)) {
-				g_debug ("setting parent of %s [%s] to be %s [%s]",
-					 fu_device_get_name (device),
-					 fu_device_get_id (device),
-					 fu_device_get_name (device_tmp),
-					 fu_device_get_id (device_tmp));
-				fu_device_set_parent (device, device_tmp);
-				break;
+		if (!g_hash_table_contains (parent_guids_new, guid))
+			g_hash_table_insert (parent_guids_new, (gpointer) guid, GUINT_TO_POINTER (j));
+	}
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device_tmp = g_ptr_array_index (devices, i);
+
+		/* find the parent GUID in any existing device */
+		if (fu_device_get_parent (device) == NULL &&
+		    g_hash_table_size (parent_guids_new) > 0) {
+			guids = fu_device_get_guids (device_tmp);
+			for (guint j = 0; j < guids->len; j++) {
+				gpointer idx_tmp = NULL;
+				if (!g_hash_table_lookup_extended (parent_guids_new,
+								   g_ptr_array_index (guids, j),
+								   NULL, &idx_tmp))
+					continue;
+				if (GPOINTER_TO_UINT (idx_tmp) < parent_idx) {
+					parent_idx = GPOINTER_TO_UINT (idx_tmp);
+					parent = device_tmp;
+				}
 			}
 		}
-	}
 
-	/* the new device is the parent to an existing child */
-	guids = fu_device_get_guids (device);
-	for (guint j = 0; j < guids->len; j++) {
-		const gchar *guid = g_ptr_array_index (guids, j);
-		for (guint i = 0; i < devices->len; i++) {
-			FuDevice *device_tmp = g_ptr_array_index (devices, i);
-			if (fu_device_get_parent (device_tmp) != NULL)
-				continue;
-			if (fu_device_has_parent_guid (device_tmp, guid)) {
+		/* the new device is the parent to an existing child */
+		if (fu_device_get_parent (device_tmp) == NULL) {
+			guids = fu_device_get_parent_guids (device_tmp);
+			for (guint j = 0; j < guids->len; j++) {
+				if (!g_hash_table_contains (guids_new, g_ptr_array_index (guids, j)))
+					continue;
 				g_debug ("setting parent of %s [%s] to be %s [%s]",
 					 fu_device_get_name (device_tmp),
 					 fu_device_get_id (device_tmp),
 					 fu_device_get_name (device),
 					 fu_device_get_id (device));
 				fu_device_set_parent (device_tmp, device);
+				break;
 			}
 		}
 	}
+	if (parent != NULL) {
+		g_debug ("setting parent of %s [%s] to be %s [%s]",
+			 fu_device_get_name (device),
+			 fu_device_get_id (device),
+			 fu_device_get_name (parent),
+			 fu_device_get_id (parent));
+		fu_device_set_parent (device, parent);
+	}
 }
 
 static void
@@ -5354,6 +8055,52 @@ fu_engine_device_inherit_history (FuEngine *self, FuDevice *device)
 	}
 }
 
+/* the typical retry delay is device-model specific, so key it on the GUID */
+static void
+fu_engine_device_inherit_retry_delay (FuEngine *self, FuDevice *device)
+{
+	guint delay = 0;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_device_has_internal_flag (device, FU_DEVICE_INTERNAL_FLAG_RETRY_BACKOFF))
+		return;
+	if (fu_device_get_guid_default (device) == NULL)
+		return;
+	if (fu_device_get_retry_delay_learned (device) > 0)
+		return;
+	if (!fu_history_get_retry_delay (self->history,
+					 fu_device_get_guid_default (device),
+					 &delay, &error_local)) {
+		if (!g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND))
+			g_warning ("failed to get retry delay: %s", error_local->message);
+		return;
+	}
+	g_debug ("using learned retry delay of %ums for %s",
+		 delay, fu_device_get_id (device));
+	fu_device_set_retry_delay_learned (device, delay);
+}
+
+static void
+fu_engine_device_save_retry_delay (FuEngine *self, FuDevice *device)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	if (fu_device_get_retry_delay_learned (device) == 0)
+		return;
+	if (fu_device_get_guid_default (device) == NULL)
+		return;
+	if (fu_device_get_retry_count (device) > 0) {
+		g_debug ("%s needed %" G_GUINT64_FORMAT " retries",
+			 fu_device_get_id (device),
+			 fu_device_get_retry_count (device));
+	}
+	if (!fu_history_set_retry_delay (self->history,
+					 fu_device_get_guid_default (device),
+					 fu_device_get_retry_delay_learned (device),
+					 &error_local))
+		g_warning ("failed to save retry delay: %s", error_local->message);
+}
+
 void
 fu_engine_add_device (FuEngine *self, FuDevice *device)
 {
@@ -5477,6 +8224,7 @@ fu_engine_add_device (FuEngine *self, FuDevice *device)
 
 	/* sometimes inherit flags from recent history */
 	fu_engine_device_inherit_history (self, device);
+	fu_engine_device_inherit_retry_delay (self, device);
 
 	fu_engine_emit_changed (self);
 }
@@ -5510,7 +8258,7 @@ fu_engine_plugin_security_changed_cb (FuPlugin *plugin, gpointer user_data)
 	FuEngine *self = FU_ENGINE (user_data);
 
 	/* invalidate host security attributes */
-	g_clear_pointer (&self->host_security_id, g_free);
+	fu_engine_security_attrs_invalidate (self, fu_plugin_get_name (plugin));
 
 	/* make UI refresh */
 	fu_engine_emit_changed (self);
@@ -5526,6 +8274,11 @@ fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 	g_autoptr(FuDevice) device_tmp = NULL;
 	g_autoptr(GError) error = NULL;
 
+	/* called from a coldplug worker thread */
+	if (fu_engine_coldplug_event_defer (self, FU_ENGINE_COLDPLUG_EVENT_DEVICE_REMOVED,
+					    plugin, device))
+		return;
+
 	device_tmp = fu_device_list_get_by_id (self->device_list,
 					       fu_device_get_id (device),
 					       &error);
@@ -5555,6 +8308,9 @@ fu_engine_plugin_device_removed_cb (FuPlugin *plugin,
 		return;
 	}
 
+	/* remember how long the retries took for the next device of this model */
+	fu_engine_device_save_retry_delay (self, device_tmp);
+
 	/* make the UI update */
 	fu_device_list_remove (self->device_list, device);
 	fu_engine_emit_changed (self);
@@ -5607,26 +8363,30 @@ fu_engine_plugin_set_coldplug_delay_cb (FuPlugin *plugin, guint duration, FuEngi
 		 duration, self->coldplug_delay);
 }
 
+static void
+fu_engine_check_plugin_build_hash (FuEngine *self, FuPlugin *plugin)
+{
+	/* plugin does not match built version */
+	if (fu_plugin_get_build_hash (plugin) == NULL) {
+		const gchar *name = fu_plugin_get_name (plugin);
+		g_warning ("%s should call fu_plugin_set_build_hash()",
+			   name);
+		self->tainted = TRUE;
+	} else if (g_strcmp0 (fu_plugin_get_build_hash (plugin),
+			      FU_BUILD_HASH) != 0) {
+		const gchar *name = fu_plugin_get_name (plugin);
+		g_warning ("%s has incorrect built version %s",
+			   name, fu_plugin_get_build_hash (plugin));
+		self->tainted = TRUE;
+	}
+}
+
 /* this is called by the self tests as well */
 void
 fu_engine_add_plugin (FuEngine *self, FuPlugin *plugin)
 {
-	if (fu_plugin_is_open (plugin)) {
-		/* plugin does not match built version */
-		if (fu_plugin_get_build_hash (plugin) == NULL) {
-			const gchar *name = fu_plugin_get_name (plugin);
-			g_warning ("%s should call fu_plugin_set_build_hash()",
-				   name);
-			self->tainted = TRUE;
-		} else if (g_strcmp0 (fu_plugin_get_build_hash (plugin),
-				      FU_BUILD_HASH) != 0) {
-			const gchar *name = fu_plugin_get_name (plugin);
-			g_warning ("%s has incorrect built version %s",
-				   name, fu_plugin_get_build_hash (plugin));
-			self->tainted = TRUE;
-		}
-	}
-
+	if (fu_plugin_is_open (plugin))
+		fu_engine_check_plugin_build_hash (self, plugin);
 	fu_plugin_list_add (self->plugin_list, plugin);
 }
 
@@ -5669,17 +8429,14 @@ fu_engine_add_plugin_filter (FuEngine *self, const gchar *plugin_glob)
 static gboolean
 fu_engine_plugin_check_supported_cb (FuPlugin *plugin, const gchar *guid, FuEngine *self)
 {
-	g_autoptr(XbNode) n = NULL;
-	g_autofree gchar *xpath = NULL;
-
 	if (fu_config_get_enumerate_all_devices (self->config))
 		return TRUE;
-
-	xpath = g_strdup_printf ("components/component[@type='firmware']/"
-				 "provides/firmware[@type='flashed'][text()='%s']",
-				 guid);
-	n = xb_silo_query_first (self->silo, xpath, NULL);
-	return n != NULL;
+	for (guint i = 0; i < self->silos_guids->len; i++) {
+		GHashTable *silo_guids = g_ptr_array_index (self->silos_guids, i);
+		if (g_hash_table_contains (silo_guids, guid))
+			return TRUE;
+	}
+	return FALSE;
 }
 
 gboolean
@@ -5704,6 +8461,49 @@ fu_engine_get_host_machine_id (FuEngine *self)
 	return self->host_machine_id;
 }
 
+static void
+fu_engine_ensure_security_attrs_attestation (FuEngine *self)
+{
+	guint cnt = 0;
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* only when background verification is enabled */
+	if (fu_config_get_verify_interval (self->config) == 0)
+		return;
+
+	attr = fwupd_security_attr_new (FWUPD_SECURITY_ATTR_ID_FWUPD_ATTESTATION);
+	fwupd_security_attr_set_plugin (attr, "core");
+	fwupd_security_attr_add_flag (attr, FWUPD_SECURITY_ATTR_FLAG_RUNTIME_ATTESTATION);
+	fu_security_attrs_append (self->host_security_attrs, attr);
+
+	/* any device that no longer matches the metadata is drift */
+	devices = fu_device_list_get_active (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		gboolean success = FALSE;
+		if (!fu_history_get_verify_result (self->history,
+						   fu_device_get_id (device),
+						   NULL, &success, NULL))
+			continue;
+		if (!success) {
+			fwupd_security_attr_add_metadata (attr, "DeviceId",
+							  fu_device_get_id (device));
+			fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_NOT_VALID);
+			return;
+		}
+		cnt++;
+	}
+	if (cnt == 0) {
+		fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_NOT_FOUND);
+		return;
+	}
+
+	/* success */
+	fwupd_security_attr_add_flag (attr, FWUPD_SECURITY_ATTR_FLAG_SUCCESS);
+	fwupd_security_attr_set_result (attr, FWUPD_SECURITY_ATTR_RESULT_VALID);
+}
+
 static void
 fu_engine_ensure_security_attrs_tainted (FuEngine *self)
 {
@@ -5787,6 +8587,7 @@ fu_engine_ensure_security_attrs (FuEngine *self)
 {
 	GPtrArray *plugins = fu_plugin_list_get_all (self->plugin_list);
 	g_autoptr(GPtrArray) items = NULL;
+	g_autoptr(GVariant) variant = NULL;
 
 	/* already valid */
 	if (self->host_security_id != NULL)
@@ -5797,11 +8598,31 @@ fu_engine_ensure_security_attrs (FuEngine *self)
 
 	/* built in */
 	fu_engine_ensure_security_attrs_tainted (self);
+	fu_engine_ensure_security_attrs_attestation (self);
 
-	/* call into plugins */
+	/* call into plugins, reusing the results from plugins not invalidated */
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index (plugins, j);
-		fu_plugin_runner_add_security_attrs (plugin_tmp, self->host_security_attrs);
+		const gchar *name = fu_plugin_get_name (plugin_tmp);
+		FuSecurityAttrs *attrs_tmp;
+		g_autoptr(GPtrArray) items_tmp = NULL;
+
+		attrs_tmp = g_hash_table_lookup (self->security_attrs_cache, name);
+		if (attrs_tmp == NULL) {
+			attrs_tmp = fu_security_attrs_new ();
+			fu_plugin_runner_add_security_attrs (plugin_tmp, attrs_tmp);
+			g_hash_table_insert (self->security_attrs_cache,
+					     g_strdup (name), attrs_tmp);
+		}
+		items_tmp = fu_security_attrs_get_all (attrs_tmp);
+		for (guint i = 0; i < items_tmp->len; i++) {
+			FwupdSecurityAttr *attr = g_ptr_array_index (items_tmp, i);
+			FwupdSecurityAttrFlags flags = fwupd_security_attr_get_flags (attr);
+
+			/* set again by the depsolve below */
+			fwupd_security_attr_set_flags (attr, flags & ~FWUPD_SECURITY_ATTR_FLAG_OBSOLETED);
+			fu_security_attrs_append (self->host_security_attrs, attr);
+		}
 	}
 
 	/* set the fallback names for clients without native translations */
@@ -5825,6 +8646,19 @@ fu_engine_ensure_security_attrs (FuEngine *self)
 	/* distil into one simple string */
 	g_free (self->host_security_id);
 	self->host_security_id = fu_engine_attrs_calculate_hsi_for_chassis (self);
+
+	/* invalidating does not mean anything changed, so only tell clients
+	 * when the serialized attributes are actually different */
+	if (items->len > 0)
+		variant = g_variant_ref_sink (fu_security_attrs_to_variant (self->host_security_attrs));
+	if (variant != NULL && self->host_security_variant != NULL &&
+	    g_variant_equal (variant, self->host_security_variant))
+		return;
+	g_clear_pointer (&self->host_security_variant, g_variant_unref);
+	self->host_security_variant = g_steal_pointer (&variant);
+	self->host_security_generation++;
+	g_signal_emit (self, signals[SIGNAL_SECURITY_CHANGED], 0,
+		       self->host_security_generation);
 }
 
 const gchar *
@@ -5843,35 +8677,358 @@ fu_engine_get_host_security_attrs (FuEngine *self)
 	return g_object_ref (self->host_security_attrs);
 }
 
+/* the cached result of fu_security_attrs_to_variant(), or %NULL if empty */
+GVariant *
+fu_engine_get_host_security_variant (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+	fu_engine_ensure_security_attrs (self);
+	if (self->host_security_variant == NULL)
+		return NULL;
+	return g_variant_ref (self->host_security_variant);
+}
+
+/* incremented each time the host security attributes change */
+guint64
+fu_engine_get_host_security_generation (FuEngine *self)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), 0);
+	fu_engine_ensure_security_attrs (self);
+	return self->host_security_generation;
+}
+
+/* entry points that are called for every plugin rather than just for the
+ * devices the plugin created, so the module has to be loaded at startup */
+static const gchar *fu_engine_plugin_symbols_eager[] = {
+	"fu_plugin_startup",
+	"fu_plugin_coldplug",
+	"fu_plugin_coldplug_prepare",
+	"fu_plugin_coldplug_cleanup",
+	"fu_plugin_recoldplug",
+	"fu_plugin_add_security_attrs",
+	"fu_plugin_device_registered",
+	"fu_plugin_composite_prepare",
+	"fu_plugin_composite_cleanup",
+	"fu_plugin_update_prepare",
+	"fu_plugin_update_cleanup",
+	"fu_plugin_backend_device_changed",
+	"fu_plugin_backend_device_removed",
+	NULL };
+
+static const struct {
+	FuPluginRule	 rule;
+	const gchar	*key;
+} fu_engine_plugin_manifest_rules[] = {
+	{ FU_PLUGIN_RULE_CONFLICTS,		"Conflicts" },
+	{ FU_PLUGIN_RULE_RUN_AFTER,		"RunAfter" },
+	{ FU_PLUGIN_RULE_RUN_BEFORE,		"RunBefore" },
+	{ FU_PLUGIN_RULE_BETTER_THAN,		"BetterThan" },
+	{ FU_PLUGIN_RULE_INHIBITS_IDLE,		"InhibitsIdle" },
+	{ FU_PLUGIN_RULE_METADATA_SOURCE,	"MetadataSource" },
+	{ FU_PLUGIN_RULE_LAST,			NULL }
+};
+
+static gchar *
+fu_engine_get_plugin_manifest_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "plugins.manifest", NULL);
+}
+
+static gint
+fu_engine_plugin_manifest_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* any plugin being added, removed or rebuilt invalidates the manifest */
+static gchar *
+fu_engine_plugin_manifest_checksum (const gchar *plugin_path, GError **error)
+{
+	const gchar *fn;
+	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GPtrArray) fns = g_ptr_array_new_with_free_func (g_free);
+
+	dir = g_dir_open (plugin_path, 0, error);
+	if (dir == NULL)
+		return NULL;
+	while ((fn = g_dir_read_name (dir)) != NULL)
+		g_ptr_array_add (fns, g_strdup (fn));
+	g_ptr_array_sort (fns, fu_engine_plugin_manifest_sort_cb);
+	g_checksum_update (csum, (const guchar *) PACKAGE_VERSION, -1);
+	for (guint i = 0; i < fns->len; i++) {
+		const gchar *fn_tmp = g_ptr_array_index (fns, i);
+		GStatBuf st = { 0x0 };
+		g_autofree gchar *filename = g_build_filename (plugin_path, fn_tmp, NULL);
+		g_autofree gchar *str = NULL;
+		if (g_stat (filename, &st) != 0)
+			continue;
+		str = g_strdup_printf ("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ";",
+				       fn_tmp, (gint64) st.st_size, (gint64) st.st_mtime);
+		g_checksum_update (csum, (const guchar *) str, -1);
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+static GKeyFile *
+fu_engine_plugin_manifest_load (const gchar *checksum)
+{
+	g_autofree gchar *checksum_old = NULL;
+	g_autofree gchar *fn = fu_engine_get_plugin_manifest_filename ();
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new ();
+
+	if (!g_key_file_load_from_file (kf, fn, G_KEY_FILE_NONE, &error_local)) {
+		g_debug ("no plugin manifest: %s", error_local->message);
+		return NULL;
+	}
+	checksum_old = g_key_file_get_string (kf, "fwupd", "Checksum", NULL);
+	if (g_strcmp0 (checksum_old, checksum) != 0) {
+		g_debug ("plugin manifest is out of date");
+		return NULL;
+	}
+	return g_steal_pointer (&kf);
+}
+
+static gboolean
+fu_engine_plugin_is_deferrable (const gchar *filename)
+{
+	GModule *module = g_module_open (filename, 0);
+	gboolean deferrable = TRUE;
+
+	if (module == NULL)
+		return FALSE;
+	for (guint i = 0; fu_engine_plugin_symbols_eager[i] != NULL; i++) {
+		gpointer func = NULL;
+		if (g_module_symbol (module, fu_engine_plugin_symbols_eager[i], &func)) {
+			deferrable = FALSE;
+			break;
+		}
+	}
+	g_module_close (module);
+	return deferrable;
+}
+
+static void
+fu_engine_plugin_manifest_add (GKeyFile *kf,
+			       FuPlugin *plugin,
+			       const gchar *filename,
+			       GPtrArray *udev_subsystems)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	gboolean deferrable;
+
+	deferrable = !fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED) &&
+		     fu_engine_plugin_is_deferrable (filename);
+	g_key_file_set_boolean (kf, name, "Deferrable", deferrable);
+	if (!deferrable)
+		return;
+	if (udev_subsystems->len > 0) {
+		g_key_file_set_string_list (kf, name, "UdevSubsystems",
+					    (const gchar * const *) udev_subsystems->pdata,
+					    udev_subsystems->len);
+	}
+	for (guint i = 0; fu_engine_plugin_manifest_rules[i].key != NULL; i++) {
+		GPtrArray *rules = fu_plugin_get_rules (plugin, fu_engine_plugin_manifest_rules[i].rule);
+		if (rules == NULL || rules->len == 0)
+			continue;
+		g_key_file_set_string_list (kf, name, fu_engine_plugin_manifest_rules[i].key,
+					    (const gchar * const *) rules->pdata,
+					    rules->len);
+	}
+}
+
+/* set up everything the daemon needs before the module itself is loaded */
+static void
+fu_engine_plugin_manifest_apply (GKeyFile *kf, FuPlugin *plugin)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	g_auto(GStrv) subsystems = NULL;
+
+	subsystems = g_key_file_get_string_list (kf, name, "UdevSubsystems", NULL, NULL);
+	for (guint i = 0; subsystems != NULL && subsystems[i] != NULL; i++)
+		fu_plugin_add_udev_subsystem (plugin, subsystems[i]);
+	for (guint i = 0; fu_engine_plugin_manifest_rules[i].key != NULL; i++) {
+		g_auto(GStrv) rules = NULL;
+		rules = g_key_file_get_string_list (kf, name,
+						    fu_engine_plugin_manifest_rules[i].key,
+						    NULL, NULL);
+		for (guint j = 0; rules != NULL && rules[j] != NULL; j++)
+			fu_plugin_add_rule (plugin, fu_engine_plugin_manifest_rules[i].rule, rules[j]);
+	}
+}
+
+static void
+fu_engine_plugin_manifest_save (GKeyFile *kf, const gchar *checksum)
+{
+	g_autofree gchar *fn = fu_engine_get_plugin_manifest_filename ();
+	g_autoptr(GError) error_local = NULL;
+
+	g_key_file_set_string (kf, "fwupd", "Checksum", checksum);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !g_key_file_save_to_file (kf, fn, &error_local)) {
+		g_debug ("failed to save plugin manifest: %s", error_local->message);
+		return;
+	}
+}
+
+/* from the table if linked into the daemon, otherwise from the module */
+static gboolean
+fu_engine_plugin_open (FuEngine *self,
+		       FuPlugin *plugin,
+		       const gchar *filename,
+		       GError **error)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+
+	if (self->plugin_builtins == NULL)
+		return fu_plugin_open (plugin, filename, error);
+	for (guint i = 0; self->plugin_builtins[i].name != NULL; i++) {
+		if (g_strcmp0 (self->plugin_builtins[i].name, name) == 0) {
+			return fu_plugin_open_builtin (plugin,
+						       self->plugin_builtins[i].symbols,
+						       error);
+		}
+	}
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_NOT_FOUND,
+		     "plugin %s is not built in",
+		     name);
+	return FALSE;
+}
+
+/**
+ * fu_engine_set_plugin_builtins:
+ * @self: A #FuEngine
+ * @plugin_builtins: (array zero-terminated=1): plugins linked into the daemon
+ *
+ * Uses the plugins that were linked into the executable rather than loading
+ * the modules from the plugin directory.
+ **/
+void
+fu_engine_set_plugin_builtins (FuEngine *self, const FuPluginBuiltin *plugin_builtins)
+{
+	g_return_if_fail (FU_IS_ENGINE (self));
+	self->plugin_builtins = plugin_builtins;
+}
+
+/* loads a plugin that was deferred at startup using the manifest */
+static gboolean
+fu_engine_plugin_ensure_open (FuEngine *self, FuPlugin *plugin)
+{
+	const gchar *name = fu_plugin_get_name (plugin);
+	const gchar *filename;
+	g_autoptr(GError) error_local = NULL;
+
+	filename = g_hash_table_lookup (self->plugins_deferred, name);
+	if (filename == NULL)
+		return TRUE;
+	g_debug ("loading deferred plugin %s", name);
+	fu_profile_push (self->profile, "open(%s)", name);
+	if (!fu_engine_plugin_open (self, plugin, filename, &error_local)) {
+		g_warning ("cannot load: %s", error_local->message);
+		g_hash_table_remove (self->plugins_deferred, name);
+		fu_profile_pop (self->profile);
+		return FALSE;
+	}
+	g_hash_table_remove (self->plugins_deferred, name);
+	fu_engine_check_plugin_build_hash (self, plugin);
+	if (fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED)) {
+		fu_profile_pop (self->profile);
+		return FALSE;
+	}
+	if (!fu_plugin_runner_startup (plugin, &error_local)) {
+		fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED);
+		if (g_error_matches (error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED))
+			fu_plugin_add_flag (plugin, FWUPD_PLUGIN_FLAG_NO_HARDWARE);
+		g_message ("disabling plugin because: %s", error_local->message);
+		fu_profile_pop (self->profile);
+		return FALSE;
+	}
+	fu_profile_pop (self->profile);
+	return TRUE;
+}
+
+/* plugin-name : filename, or %NULL if linked into the daemon */
+static GHashTable *
+fu_engine_get_plugin_filenames (FuEngine *self, const gchar *plugin_path, GError **error)
+{
+	const gchar *fn;
+	g_autofree gchar *suffix = g_strdup_printf (".%s", G_MODULE_SUFFIX);
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GHashTable) filenames = NULL;
+
+	filenames = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	if (self->plugin_builtins != NULL) {
+		for (guint i = 0; self->plugin_builtins[i].name != NULL; i++) {
+			g_hash_table_insert (filenames,
+					     g_strdup (self->plugin_builtins[i].name),
+					     NULL);
+		}
+		return g_steal_pointer (&filenames);
+	}
+	dir = g_dir_open (plugin_path, 0, error);
+	if (dir == NULL)
+		return NULL;
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		gchar *name;
+
+		/* ignore non-plugins */
+		if (!g_str_has_suffix (fn, suffix))
+			continue;
+		name = fu_plugin_guess_name_from_fn (fn);
+		if (name == NULL)
+			continue;
+		g_hash_table_insert (filenames, name,
+				     g_build_filename (plugin_path, fn, NULL));
+	}
+	return g_steal_pointer (&filenames);
+}
+
 gboolean
 fu_engine_load_plugins (FuEngine *self, GError **error)
 {
-	const gchar *fn;
-	g_autoptr(GDir) dir = NULL;
+	g_autofree gchar *checksum = NULL;
 	g_autofree gchar *plugin_path = NULL;
-	g_autofree gchar *suffix = g_strdup_printf (".%s", G_MODULE_SUFFIX);
+	g_autoptr(GHashTable) filenames = NULL;
+	g_autoptr(GKeyFile) manifest = NULL;
+	g_autoptr(GKeyFile) manifest_new = NULL;
+	g_autoptr(GList) names = NULL;
+	g_autoptr(GPtrArray) plugins_deferred = g_ptr_array_new_with_free_func (g_free);
 	g_autoptr(GPtrArray) plugins_disabled = g_ptr_array_new_with_free_func (g_free);
 	g_autoptr(GPtrArray) plugins_disabled_rt = g_ptr_array_new_with_free_func (g_free);
 
 	/* search */
 	plugin_path = fu_common_get_path (FU_PATH_KIND_PLUGINDIR_PKG);
-	dir = g_dir_open (plugin_path, 0, error);
-	if (dir == NULL)
+	filenames = fu_engine_get_plugin_filenames (self, plugin_path, error);
+	if (filenames == NULL)
 		return FALSE;
-	while ((fn = g_dir_read_name (dir)) != NULL) {
-		g_autofree gchar *filename = NULL;
-		g_autofree gchar *name = NULL;
+
+	/* only load modules when matching hardware appears, using what we
+	 * learned about each plugin the last time they were all loaded;
+	 * there is nothing to defer when the plugins are built in */
+	if (self->load_flags & FU_ENGINE_LOAD_FLAG_LAZY_PLUGINS &&
+	    self->plugin_builtins == NULL) {
+		g_autoptr(GError) error_local = NULL;
+		checksum = fu_engine_plugin_manifest_checksum (plugin_path, &error_local);
+		if (checksum == NULL) {
+			g_debug ("cannot use plugin manifest: %s", error_local->message);
+		} else {
+			manifest = fu_engine_plugin_manifest_load (checksum);
+			if (manifest == NULL)
+				manifest_new = g_key_file_new ();
+		}
+	}
+	names = g_hash_table_get_keys (filenames);
+	for (GList *l = names; l != NULL; l = l->next) {
+		const gchar *filename = g_hash_table_lookup (filenames, l->data);
+		g_autofree gchar *name = g_strdup (l->data);
 		g_autoptr(FuPlugin) plugin = NULL;
 		g_autoptr(GError) error_local = NULL;
 
-		/* ignore non-plugins */
-		if (!g_str_has_suffix (fn, suffix))
-			continue;
-
 		/* is disabled */
-		name = fu_plugin_guess_name_from_fn (fn);
-		if (name == NULL)
-			continue;
 		if (fu_engine_is_plugin_name_disabled (self, name) ||
 		    !fu_engine_is_plugin_name_enabled (self, name)) {
 			g_ptr_array_add (plugins_disabled, g_steal_pointer (&name));
@@ -5879,7 +9036,6 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 		}
 
 		/* open module */
-		filename = g_build_filename (plugin_path, fn, NULL);
 		plugin = fu_plugin_new ();
 		fu_plugin_set_name (plugin, name);
 		fu_plugin_set_hwids (plugin, self->hwids);
@@ -5892,13 +9048,30 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 				  G_CALLBACK (fu_engine_plugin_add_firmware_gtype_cb),
 				  self);
 
+		/* only matching hardware will load the module */
+		if (manifest != NULL &&
+		    g_key_file_get_boolean (manifest, name, "Deferrable", NULL)) {
+			fu_engine_plugin_manifest_apply (manifest, plugin);
+			g_hash_table_insert (self->plugins_deferred,
+					     g_strdup (name),
+					     g_strdup (filename));
+			g_ptr_array_add (plugins_deferred, g_strdup (name));
+
 		/* if loaded from fu_engine_load() open the plugin */
-		if (g_hash_table_size (self->firmware_gtypes) > 0) {
-			if (!fu_plugin_open (plugin, filename, &error_local)) {
+		} else if (g_hash_table_size (self->firmware_gtypes) > 0) {
+			guint udev_subsystems_len = self->udev_subsystems->len;
+			if (!fu_engine_plugin_open (self, plugin, filename, &error_local)) {
 				g_warning ("cannot load: %s", error_local->message);
 				fu_engine_add_plugin (self, plugin);
 				continue;
 			}
+			if (manifest_new != NULL) {
+				g_autoptr(GPtrArray) udev_subsystems = g_ptr_array_new ();
+				for (guint i = udev_subsystems_len; i < self->udev_subsystems->len; i++)
+					g_ptr_array_add (udev_subsystems, g_ptr_array_index (self->udev_subsystems, i));
+				fu_engine_plugin_manifest_add (manifest_new, plugin,
+							       filename, udev_subsystems);
+			}
 		}
 
 		/* runtime disabled */
@@ -5950,6 +9123,17 @@ fu_engine_load_plugins (FuEngine *self, GError **error)
 		str = g_strjoinv (", ", (gchar **) plugins_disabled_rt->pdata);
 		g_debug ("plugins runtime-disabled: %s", str);
 	}
+	if (plugins_deferred->len > 0) {
+		g_autofree gchar *str = NULL;
+		g_ptr_array_add (plugins_deferred, NULL);
+		str = g_strjoinv (", ", (gchar **) plugins_deferred->pdata);
+		g_debug ("plugins deferred: %s", str);
+	}
+
+	/* save for the next time the daemon starts */
+	if (manifest_new != NULL &&
+	    (self->load_flags & FU_ENGINE_LOAD_FLAG_READONLY) == 0)
+		fu_engine_plugin_manifest_save (manifest_new, checksum);
 
 	/* depsolve into the correct order */
 	if (!fu_plugin_list_depsolve (self->plugin_list, error))
@@ -5979,14 +9163,569 @@ fu_engine_cleanup_state (GError **error)
 guint64
 fu_engine_get_archive_size_max (FuEngine *self)
 {
-	return fu_config_get_archive_size_max (self->config);
+	return fu_config_get_archive_size_max (self->config);
+}
+
+static void
+fu_engine_remove_devices_by_backend_id (FuEngine *self, const gchar *backend_id)
+{
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* go through each device and remove any that match */
+	devices = fu_device_list_get_all (self->device_list);
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device_tmp = g_ptr_array_index (devices, i);
+		if (g_strcmp0 (fu_device_get_backend_id (device_tmp), backend_id) == 0) {
+			g_debug ("auto-removing backend device");
+			fu_device_list_remove (self->device_list, device_tmp);
+		}
+	}
+}
+
+static const gchar *
+fu_engine_hotplug_stage_to_string (FuEngineHotplugStage stage)
+{
+	if (stage == FU_ENGINE_HOTPLUG_STAGE_QUEUE)
+		return "queue";
+	if (stage == FU_ENGINE_HOTPLUG_STAGE_SETUP)
+		return "setup";
+	if (stage == FU_ENGINE_HOTPLUG_STAGE_PUBLISH)
+		return "publish";
+	if (stage == FU_ENGINE_HOTPLUG_STAGE_TOTAL)
+		return "total";
+	return NULL;
+}
+
+static void
+fu_engine_hotplug_latency_add (FuEngine *self, FuEngineHotplugStage stage, gint64 usecs)
+{
+	guint64 ms = usecs > 0 ? (guint64) usecs / 1000 : 0;
+	guint bucket = 0;
+	while (bucket < FU_ENGINE_HOTPLUG_LATENCY_BUCKETS - 1 &&
+	       ms >= ((guint64) 1 << bucket))
+		bucket++;
+	self->hotplug_latency[stage][bucket]++;
+}
+
+/**
+ * fu_engine_get_hotplug_latency:
+ * @self: A #FuEngine
+ *
+ * Gets histograms of the time spent in each stage of adding hotplugged
+ * devices.
+ *
+ * Returns: a #GVariant of type `a(sau)`
+ **/
+GVariant *
+fu_engine_get_hotplug_latency (FuEngine *self)
+{
+	GVariantBuilder builder;
+
+	g_return_val_if_fail (FU_IS_ENGINE (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sau)"));
+	for (guint i = 0; i < FU_ENGINE_HOTPLUG_STAGE_LAST; i++) {
+		GVariantBuilder builder_buckets;
+		g_variant_builder_init (&builder_buckets, G_VARIANT_TYPE ("au"));
+		for (guint j = 0; j < FU_ENGINE_HOTPLUG_LATENCY_BUCKETS; j++)
+			g_variant_builder_add (&builder_buckets, "u", self->hotplug_latency[i][j]);
+		g_variant_builder_add (&builder, "(sau)",
+				       fu_engine_hotplug_stage_to_string (i),
+				       &builder_buckets);
+	}
+	return g_variant_builder_end (&builder);
+}
+
+static void
+fu_engine_backend_device_added_run_plugin (FuEngine *self, FuPlugin *plugin, FuDevice *device)
+{
+	g_autoptr(GError) error = NULL;
+	if (!fu_plugin_runner_backend_device_added (plugin, device, &error)) {
+		if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+				g_debug ("%s ignoring: %s",
+					 fu_plugin_get_name (plugin),
+					 error->message);
+			}
+			return;
+		}
+		g_warning ("failed to add device %s: %s",
+			   fu_device_get_backend_id (device),
+			   error->message);
+	}
+}
+
+static void
+fu_engine_hotplug_job_free (FuEngineHotplugJob *job)
+{
+	if (job->source != NULL) {
+		g_source_destroy (job->source);
+		g_source_unref (job->source);
+	}
+	g_object_unref (job->device);
+	g_ptr_array_unref (job->plugins);
+	g_free (job);
+}
+
+static gboolean
+fu_engine_hotplug_job_done_cb (gpointer user_data)
+{
+	FuEngineHotplugJob *job = (FuEngineHotplugJob *) user_data;
+	FuEngine *self = job->self;
+	gint64 now;
+
+	/* add anything the plugins created */
+	fu_engine_coldplug_events_flush (self);
+
+	/* removed while the plugin was busy */
+	if (job->cancelled) {
+		g_debug ("%s was removed during setup",
+			 fu_device_get_backend_id (job->device));
+		fu_engine_remove_devices_by_backend_id (self, fu_device_get_backend_id (job->device));
+	}
+
+	/* record how long each part took */
+	now = g_get_monotonic_time ();
+	fu_engine_hotplug_latency_add (self, FU_ENGINE_HOTPLUG_STAGE_QUEUE,
+				       job->started - job->queued);
+	fu_engine_hotplug_latency_add (self, FU_ENGINE_HOTPLUG_STAGE_SETUP,
+				       job->finished - job->started);
+	fu_engine_hotplug_latency_add (self, FU_ENGINE_HOTPLUG_STAGE_PUBLISH,
+				       now - job->finished);
+	fu_engine_hotplug_latency_add (self, FU_ENGINE_HOTPLUG_STAGE_TOTAL,
+				       now - job->queued);
+	g_debug ("hotplug of %s took %.1fms",
+		 fu_device_get_backend_id (job->device),
+		 (gdouble) (now - job->queued) / 1000.f);
+	g_ptr_array_remove (self->hotplug_jobs, job);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+fu_engine_hotplug_thread_cb (gpointer data, gpointer user_data)
+{
+	FuEngineHotplugJob *job = (FuEngineHotplugJob *) data;
+
+	job->started = g_get_monotonic_time ();
+	for (guint i = 0; i < job->plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (job->plugins, i);
+		fu_engine_backend_device_added_run_plugin (job->self, plugin, job->device);
+	}
+	job->finished = g_get_monotonic_time ();
+
+	/* process the plugin callbacks in the main thread */
+	job->source = g_idle_source_new ();
+	g_source_set_callback (job->source, fu_engine_hotplug_job_done_cb, job, NULL);
+	g_source_attach (job->source, NULL);
+}
+
+/* only use a worker when nothing else might be using the plugins */
+static gboolean
+fu_engine_hotplug_can_defer (FuEngine *self, GPtrArray *plugins)
+{
+	if (!self->loaded || self->coldplug_running)
+		return FALSE;
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return FALSE;
+	if (!fu_config_get_concurrent_hotplug (self->config))
+		return FALSE;
+	if (self->status != FWUPD_STATUS_IDLE)
+		return FALSE;
+	if (plugins->len == 0)
+		return FALSE;
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		if (fu_plugin_list_has_order_rules (self->plugin_list, plugin))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* each plugin gets one worker so it never sees two devices at once */
+static gboolean
+fu_engine_hotplug_defer (FuEngine *self, FuDevice *device, GPtrArray *plugins)
+{
+	FuPlugin *plugin = g_ptr_array_index (plugins, 0);
+	FuEngineHotplugJob *job;
+	GThreadPool *pool;
+	g_autoptr(GError) error_local = NULL;
+
+	pool = g_hash_table_lookup (self->hotplug_pools, fu_plugin_get_name (plugin));
+	if (pool == NULL) {
+		pool = g_thread_pool_new (fu_engine_hotplug_thread_cb, self,
+					  1, FALSE, &error_local);
+		if (pool == NULL) {
+			g_warning ("failed to create hotplug pool: %s",
+				   error_local->message);
+			return FALSE;
+		}
+		g_hash_table_insert (self->hotplug_pools,
+				     g_strdup (fu_plugin_get_name (plugin)),
+				     pool);
+	}
+	job = g_new0 (FuEngineHotplugJob, 1);
+	job->self = self;
+	job->device = g_object_ref (device);
+	job->plugins = g_ptr_array_ref (plugins);
+	job->queued = g_get_monotonic_time ();
+	g_ptr_array_add (self->hotplug_jobs, job);
+
+	/* the job is still queued if a new thread could not be started */
+	if (!g_thread_pool_push (pool, job, &error_local)) {
+		g_warning ("failed to start hotplug worker for %s: %s",
+			   fu_device_get_backend_id (device),
+			   error_local->message);
+	}
+	return TRUE;
+}
+
+static void
+fu_engine_job_lock_free (FuEngineJobLock *lock)
+{
+	g_mutex_clear (&lock->mutex);
+	g_free (lock);
+}
+
+static void
+fu_engine_job_free (FuEngineJob *job)
+{
+	g_free (job->device_id);
+	g_free (job->lock_id);
+	g_free (job);
+}
+
+/* plugins are not expected to be reentrant, so jobs for devices handled by
+ * the same plugin run one at a time, just like the hotplug workers */
+static const gchar *
+fu_engine_job_get_lock_id (FuDevice *device)
+{
+	if (fu_device_get_plugin (device) != NULL)
+		return fu_device_get_plugin (device);
+	return fu_device_get_id (device);
+}
+
+static FuEngineJobLock *
+fu_engine_job_lock_ref (FuEngine *self, const gchar *lock_id)
+{
+	FuEngineJobLock *lock;
+	g_mutex_lock (&self->job_mutex);
+	lock = g_hash_table_lookup (self->job_locks, lock_id);
+	if (lock == NULL) {
+		lock = g_new0 (FuEngineJobLock, 1);
+		g_mutex_init (&lock->mutex);
+		g_hash_table_insert (self->job_locks, g_strdup (lock_id), lock);
+	}
+	lock->pending++;
+	g_mutex_unlock (&self->job_mutex);
+	return lock;
+}
+
+static void
+fu_engine_job_lock_unref (FuEngine *self, const gchar *lock_id)
+{
+	FuEngineJobLock *lock;
+	g_mutex_lock (&self->job_mutex);
+	lock = g_hash_table_lookup (self->job_locks, lock_id);
+	if (lock != NULL && --lock->pending == 0)
+		g_hash_table_remove (self->job_locks, lock_id);
+	g_mutex_unlock (&self->job_mutex);
+}
+
+static gboolean
+fu_engine_job_is_pending (FuEngine *self, FuDevice *device)
+{
+	gboolean ret;
+	g_mutex_lock (&self->job_mutex);
+	ret = g_hash_table_contains (self->job_locks, fu_engine_job_get_lock_id (device));
+	g_mutex_unlock (&self->job_mutex);
+	return ret;
+}
+
+static gboolean
+fu_engine_job_can_thread (FuEngine *self)
+{
+	if (self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES)
+		return FALSE;
+	return fu_config_get_threaded_runners (self->config);
+}
+
+static void
+fu_engine_job_thread_cb (GTask *task,
+			 gpointer source_object,
+			 gpointer task_data,
+			 GCancellable *cancellable)
+{
+	FuEngine *self = FU_ENGINE (source_object);
+	FuEngineJob *job = (FuEngineJob *) task_data;
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+
+	g_mutex_lock (&job->lock->mutex);
+	ret = job->func (self, job->device_id, job->user_data, &error);
+	g_mutex_unlock (&job->lock->mutex);
+	fu_engine_job_lock_unref (self, job->lock_id);
+	job->lock = NULL;
+	if (!ret) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * fu_engine_run_job_async:
+ * @self: A #FuEngine
+ * @device_id: A device ID
+ * @func: (scope async): A #FuEngineJobFunc
+ * @user_data: (closure func): data for @func, which must stay valid until @callback
+ * @callback: A #GAsyncReadyCallback
+ * @callback_data: (closure callback): data for @callback
+ *
+ * Runs a device action such as unlocking or verifying. If `ThreadedRunners`
+ * is enabled then @func is called in a worker thread, and any signals it
+ * causes are emitted in the main context. Jobs for devices using the same
+ * plugin are run one at a time, and the device cannot be updated until all
+ * its jobs have completed.
+ *
+ * Call fu_engine_run_job_finish() from @callback to get the result.
+ **/
+void
+fu_engine_run_job_async (FuEngine *self,
+			 const gchar *device_id,
+			 FuEngineJobFunc func,
+			 gpointer user_data,
+			 GAsyncReadyCallback callback,
+			 gpointer callback_data)
+{
+	FuEngineJob *job;
+	g_autoptr(FuDevice) device = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FU_IS_ENGINE (self));
+	g_return_if_fail (device_id != NULL);
+	g_return_if_fail (func != NULL);
+
+	/* check the id exists */
+	task = g_task_new (self, NULL, callback, callback_data);
+	device = fu_device_list_get_by_id (self->device_list, device_id, &error_local);
+	if (device == NULL) {
+		g_task_return_error (task, g_steal_pointer (&error_local));
+		return;
+	}
+	job = g_new0 (FuEngineJob, 1);
+	job->func = func;
+	job->user_data = user_data;
+	job->device_id = g_strdup (device_id);
+	job->lock_id = g_strdup (fu_engine_job_get_lock_id (device));
+	job->lock = fu_engine_job_lock_ref (self, job->lock_id);
+	g_task_set_task_data (task, job, (GDestroyNotify) fu_engine_job_free);
+
+	/* the callback is still only called from the main context */
+	if (!fu_engine_job_can_thread (self)) {
+		fu_engine_job_thread_cb (task, self, job, NULL);
+		return;
+	}
+	g_task_run_in_thread (task, fu_engine_job_thread_cb);
+}
+
+/**
+ * fu_engine_run_job_finish:
+ * @self: A #FuEngine
+ * @res: A #GAsyncResult
+ * @error: A #GError, or %NULL
+ *
+ * Gets the result of fu_engine_run_job_async().
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_run_job_finish (FuEngine *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* add anything the plugin created while the job was running */
+	fu_engine_coldplug_events_flush (self);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+typedef struct {
+	FwupdInstallFlags	 flags;
+	FuEngineVerifyFunc	 func;
+	gpointer		 user_data;
+	guint			 pending;	/* groups still running */
+} FuEngineVerifyAllHelper;
+
+typedef struct {
+	GTask			*task;
+	GPtrArray		*devices;	/* (element-type FuDevice) */
+	guint			 idx;
+} FuEngineVerifyAllGroup;
+
+static void
+fu_engine_verify_all_group_free (FuEngineVerifyAllGroup *group)
+{
+	g_object_unref (group->task);
+	g_ptr_array_unref (group->devices);
+	g_free (group);
+}
+
+static FuDevice *
+fu_engine_verify_all_get_device (gpointer item)
+{
+	return FU_DEVICE (item);
+}
+
+static gboolean
+fu_engine_verify_all_job_cb (FuEngine *self,
+			     const gchar *device_id,
+			     gpointer user_data,
+			     GError **error)
+{
+	FuEngineVerifyAllGroup *group = (FuEngineVerifyAllGroup *) user_data;
+	FuEngineVerifyAllHelper *helper = g_task_get_task_data (group->task);
+	return fu_engine_verify (self, device_id, helper->flags, error);
+}
+
+static void fu_engine_verify_all_group_next (FuEngine *self, FuEngineVerifyAllGroup *group);
+
+static void
+fu_engine_verify_all_job_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (source);
+	FuEngineVerifyAllGroup *group = (FuEngineVerifyAllGroup *) user_data;
+	FuEngineVerifyAllHelper *helper = g_task_get_task_data (group->task);
+	FuDevice *device = g_ptr_array_index (group->devices, group->idx);
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_engine_run_job_finish (self, res, &error_local)) {
+		g_debug ("failed to verify %s: %s",
+			 fu_device_get_id (device),
+			 error_local->message);
+	}
+	helper->func (self, device, error_local, helper->user_data);
+	group->idx++;
+	fu_engine_verify_all_group_next (self, group);
+}
+
+/* devices in the same group are read back one at a time */
+static void
+fu_engine_verify_all_group_next (FuEngine *self, FuEngineVerifyAllGroup *group)
+{
+	FuEngineVerifyAllHelper *helper = g_task_get_task_data (group->task);
+	FuDevice *device;
+
+	if (group->idx >= group->devices->len) {
+		g_autoptr(GTask) task = g_object_ref (group->task);
+		fu_engine_verify_all_group_free (group);
+		if (--helper->pending == 0)
+			g_task_return_boolean (task, TRUE);
+		return;
+	}
+	device = g_ptr_array_index (group->devices, group->idx);
+	fu_engine_run_job_async (self, fu_device_get_id (device),
+				 fu_engine_verify_all_job_cb, group,
+				 fu_engine_verify_all_job_done_cb, group);
+}
+
+/**
+ * fu_engine_verify_all_async:
+ * @self: A #FuEngine
+ * @flags: #FwupdInstallFlags, e.g. %FWUPD_INSTALL_FLAG_FORCE to always read
+ *  back the device
+ * @func: (scope async): A #FuEngineVerifyFunc called as each device completes
+ * @user_data: (closure func): data for @func, which must stay valid until @callback
+ * @callback: A #GAsyncReadyCallback
+ * @callback_data: (closure callback): data for @callback
+ *
+ * Verifies all the devices that support it. Devices that share a parent, proxy
+ * or plugin are verified one after another, and each other group of devices
+ * is verified at the same time when `ThreadedRunners` is enabled.
+ *
+ * Call fu_engine_verify_all_finish() from @callback to get the result.
+ **/
+void
+fu_engine_verify_all_async (FuEngine *self,
+			    FwupdInstallFlags flags,
+			    FuEngineVerifyFunc func,
+			    gpointer user_data,
+			    GAsyncReadyCallback callback,
+			    gpointer callback_data)
+{
+	FuEngineVerifyAllHelper *helper;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) devices_active = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GTask) task = NULL;
+
+	g_return_if_fail (FU_IS_ENGINE (self));
+	g_return_if_fail (func != NULL);
+
+	task = g_task_new (self, NULL, callback, callback_data);
+	helper = g_new0 (FuEngineVerifyAllHelper, 1);
+	helper->flags = flags;
+	helper->func = func;
+	helper->user_data = user_data;
+	g_task_set_task_data (task, helper, g_free);
+
+	/* same as the background verification */
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	devices_active = fu_device_list_get_active (self->device_list);
+	for (guint i = 0; i < devices_active->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices_active, i);
+		if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY) &&
+		    !fu_device_has_flag (device, FWUPD_DEVICE_FLAG_CAN_VERIFY_IMAGE))
+			continue;
+		if (fu_device_has_flag (device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION) ||
+		    fu_device_has_flag (device, FWUPD_DEVICE_FLAG_IS_BOOTLOADER))
+			continue;
+		g_ptr_array_add (devices, g_object_ref (device));
+	}
+	if (devices->len == 0) {
+		g_task_return_new_error (task,
+					 FWUPD_ERROR,
+					 FWUPD_ERROR_NOTHING_TO_DO,
+					 "No devices can be verified");
+		return;
+	}
+
+	/* start each independent group */
+	groups = fu_engine_split_independent (devices, fu_engine_verify_all_get_device);
+	g_debug ("verifying %u devices in %u groups", devices->len, groups->len);
+	helper->pending = groups->len;
+	for (guint i = 0; i < groups->len; i++) {
+		FuEngineVerifyAllGroup *group = g_new0 (FuEngineVerifyAllGroup, 1);
+		group->task = g_object_ref (task);
+		group->devices = g_ptr_array_ref (g_ptr_array_index (groups, i));
+		fu_engine_verify_all_group_next (self, group);
+	}
+}
+
+/**
+ * fu_engine_verify_all_finish:
+ * @self: A #FuEngine
+ * @res: A #GAsyncResult
+ * @error: A #GError, or %NULL
+ *
+ * Gets the result of fu_engine_verify_all_async(). The result of each device
+ * is only reported using the #FuEngineVerifyFunc.
+ *
+ * Returns: %TRUE if all the devices were tried
+ **/
+gboolean
+fu_engine_verify_all_finish (FuEngine *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 static void
 fu_engine_backend_device_removed_cb (FuBackend *backend, FuDevice *device, FuEngine *self)
 {
-	g_autoptr(GPtrArray) devices = NULL;
-
 	/* debug */
 	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
 		g_debug ("%s removed %s",
@@ -5994,22 +9733,21 @@ fu_engine_backend_device_removed_cb (FuBackend *backend, FuDevice *device, FuEng
 			 fu_device_get_backend_id (device));
 	}
 
-	/* go through each device and remove any that match */
-	devices = fu_device_list_get_all (self->device_list);
-	for (guint i = 0; i < devices->len; i++) {
-		FuDevice *device_tmp = g_ptr_array_index (devices, i);
-		if (g_strcmp0 (fu_device_get_backend_id (device_tmp),
-			       fu_device_get_backend_id (device)) == 0) {
-			g_debug ("auto-removing backend device");
-			fu_device_list_remove (self->device_list, device_tmp);
-		}
+	/* a worker may still be setting this up */
+	for (guint i = 0; i < self->hotplug_jobs->len; i++) {
+		FuEngineHotplugJob *job = g_ptr_array_index (self->hotplug_jobs, i);
+		if (g_strcmp0 (fu_device_get_backend_id (job->device),
+			       fu_device_get_backend_id (device)) == 0)
+			job->cancelled = TRUE;
 	}
+	fu_engine_remove_devices_by_backend_id (self, fu_device_get_backend_id (device));
 }
 
 static void
 fu_engine_backend_device_added_cb (FuBackend *backend, FuDevice *device, FuEngine *self)
 {
 	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) plugins = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	g_autoptr(GPtrArray) possible_plugins = NULL;
 
 	/* super useful for plugin development */
@@ -6020,12 +9758,15 @@ fu_engine_backend_device_added_cb (FuBackend *backend, FuDevice *device, FuEngin
 
 	/* add any extra quirks */
 	fu_device_set_quirks (device, self->quirks);
+	fu_profile_push (self->profile, "probe(%s)", fu_device_get_backend_id (device));
 	if (!fu_device_probe (device, &error_local)) {
 		g_warning ("failed to probe device %s: %s",
 			   fu_device_get_backend_id (device),
 			   error_local->message);
+		fu_profile_pop (self->profile);
 		return;
 	}
+	fu_profile_pop (self->profile);
 
 	/* super useful for plugin development */
 	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
@@ -6038,25 +9779,25 @@ fu_engine_backend_device_added_cb (FuBackend *backend, FuDevice *device, FuEngin
 	for (guint i = 0; i < possible_plugins->len; i++) {
 		FuPlugin *plugin;
 		const gchar *plugin_name = g_ptr_array_index (possible_plugins, i);
-		g_autoptr(GError) error = NULL;
-
 		plugin = fu_plugin_list_find_by_name (self->plugin_list, plugin_name, NULL);
 		if (plugin == NULL)
 			continue;
-		if (!fu_plugin_runner_backend_device_added (plugin, device, &error)) {
-			if (g_error_matches (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-				if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
-					g_debug ("%s ignoring: %s",
-						 fu_plugin_get_name (plugin),
-						 error->message);
-				}
-				continue;
-			}
-			g_warning ("failed to add device %s: %s",
-				   fu_device_get_backend_id (device),
-				   error->message);
+		if (!fu_engine_plugin_ensure_open (self, plugin))
 			continue;
-		}
+		g_ptr_array_add (plugins, g_object_ref (plugin));
+	}
+
+	/* set up without blocking the main loop */
+	if (fu_engine_hotplug_can_defer (self, plugins) &&
+	    fu_engine_hotplug_defer (self, device, plugins))
+		return;
+	for (guint i = 0; i < plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (plugins, i);
+		fu_profile_push (self->profile, "%s(%s)",
+				 fu_plugin_get_name (plugin),
+				 fu_device_get_backend_id (device));
+		fu_engine_backend_device_added_run_plugin (self, plugin, device);
+		fu_profile_pop (self->profile);
 	}
 }
 
@@ -6081,6 +9822,7 @@ fu_engine_backend_device_changed_cb (FuBackend *backend, FuDevice *device, FuEng
 			continue;
 		if (g_strcmp0 (fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device_tmp)),
 			       fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (device))) == 0) {
+			fu_engine_security_attrs_invalidate (self, fu_device_get_plugin (device_tmp));
 			fu_udev_device_emit_changed (FU_UDEV_DEVICE (device));
 		}
 	}
@@ -6234,25 +9976,25 @@ fu_engine_update_history_device (FuEngine *self, FuDevice *dev_history, GError *
 static gboolean
 fu_engine_update_history_database (FuEngine *self, GError **error)
 {
-	g_autoptr(GPtrArray) devices = NULL;
-
-	/* get any devices */
-	devices = fu_history_get_devices (self->history, error);
-	if (devices == NULL)
-		return FALSE;
-	for (guint i = 0; i < devices->len; i++) {
-		FuDevice *dev = g_ptr_array_index (devices, i);
-		g_autoptr(GError) error_local = NULL;
+	FwupdUpdateState states[] = { FWUPD_UPDATE_STATE_NEEDS_REBOOT,
+				      FWUPD_UPDATE_STATE_PENDING };
 
-		/* not in the required state */
-		if (fu_device_get_update_state (dev) != FWUPD_UPDATE_STATE_NEEDS_REBOOT &&
-		    fu_device_get_update_state (dev) != FWUPD_UPDATE_STATE_PENDING)
-			continue;
+	/* get any devices in the required state */
+	for (guint j = 0; j < G_N_ELEMENTS (states); j++) {
+		g_autoptr(GPtrArray) devices = NULL;
+		devices = fu_history_get_devices_filtered (self->history, states[j],
+							   0, 0, error);
+		if (devices == NULL)
+			return FALSE;
+		for (guint i = 0; i < devices->len; i++) {
+			FuDevice *dev = g_ptr_array_index (devices, i);
+			g_autoptr(GError) error_local = NULL;
 
-		/* try to save the new update-state, but ignoring any error */
-		if (!fu_engine_update_history_device (self, dev, &error_local)) {
-			g_warning ("failed to update history database: %s",
-				   error_local->message);
+			/* try to save the new update-state, but ignoring any error */
+			if (!fu_engine_update_history_device (self, dev, &error_local)) {
+				g_warning ("failed to update history database: %s",
+					   error_local->message);
+			}
 		}
 	}
 	return TRUE;
@@ -6282,6 +10024,268 @@ fu_engine_ensure_client_certificate (FuEngine *self)
 	g_debug ("client certificate exists and working");
 }
 
+static gchar *
+fu_engine_get_devices_cache_filename (void)
+{
+	g_autofree gchar *cachedirpkg = fu_common_get_path (FU_PATH_KIND_CACHEDIR_PKG);
+	return g_build_filename (cachedirpkg, "devices.gvariant", NULL);
+}
+
+/* the physical ID is the sysfs path for most udev and USB devices, so we can
+ * cheaply tell if the backing device has gone away since we last ran */
+static gboolean
+fu_engine_devices_cache_physical_id_exists (const gchar *physical_id)
+{
+	g_autofree gchar *fn = NULL;
+	if (g_str_has_prefix (physical_id, "DEVPATH="))
+		fn = g_build_filename ("/sys", physical_id + 8, NULL);
+	else if (g_str_has_prefix (physical_id, "DEVNAME="))
+		fn = g_strdup (physical_id + 8);
+	else if (g_str_has_prefix (physical_id, "/sys/"))
+		fn = g_strdup (physical_id);
+	else
+		return TRUE;
+	return g_file_test (fn, G_FILE_TEST_EXISTS);
+}
+
+static void
+fu_engine_devices_cache_load (FuEngine *self)
+{
+	const gchar *boot_id_cached = NULL;
+	g_autofree gchar *boot_id = fu_engine_get_boot_id ();
+	g_autofree gchar *fn = fu_engine_get_devices_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) devices_val = NULL;
+	g_autoptr(GVariant) val = NULL;
+	g_autoptr(GVariantIter) iter = NULL;
+	const gchar *physical_id = NULL;
+	const gchar *serial = NULL;
+	GVariant *device_val = NULL;
+
+	/* the cache is only valid until the system is rebooted */
+	if (boot_id == NULL)
+		return;
+	if (!g_file_test (fn, G_FILE_TEST_EXISTS))
+		return;
+	blob = fu_common_get_contents_bytes (fn, NULL);
+	if (blob == NULL)
+		return;
+	val = g_variant_new_from_bytes (G_VARIANT_TYPE ("(sa(ssa{sv}))"), blob, FALSE);
+	if (!g_variant_is_normal_form (val)) {
+		g_debug ("ignoring corrupt device cache %s", fn);
+		return;
+	}
+	g_variant_get (val, "(&s@a(ssa{sv}))", &boot_id_cached, &devices_val);
+	if (g_strcmp0 (boot_id, boot_id_cached) != 0) {
+		g_debug ("ignoring device cache from boot %s", boot_id_cached);
+		return;
+	}
+
+	/* only include devices that are still present */
+	devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	iter = g_variant_iter_new (devices_val);
+	while (g_variant_iter_loop (iter, "(&s&s@a{sv})", &physical_id, &serial, &device_val)) {
+		g_autoptr(FwupdDevice) dev = NULL;
+		if (!fu_engine_devices_cache_physical_id_exists (physical_id)) {
+			g_debug ("ignoring cached device %s as removed", physical_id);
+			continue;
+		}
+		dev = fwupd_device_from_variant (device_val);
+		if (dev == NULL)
+			continue;
+		g_ptr_array_add (devices, g_steal_pointer (&dev));
+	}
+	if (devices->len == 0)
+		return;
+	g_debug ("using %u devices from the device cache", devices->len);
+	self->devices_cached = g_steal_pointer (&devices);
+}
+
+static void
+fu_engine_devices_cache_save (FuEngine *self)
+{
+	GVariantBuilder builder;
+	g_autofree gchar *boot_id = fu_engine_get_boot_id ();
+	g_autofree gchar *fn = fu_engine_get_devices_cache_filename ();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GVariant) val = NULL;
+
+	if (boot_id == NULL)
+		return;
+	devices = fu_device_list_get_active (self->device_list);
+	g_ptr_array_sort (devices, fu_engine_sort_devices_by_priority_name);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(ssa{sv})"));
+	for (guint i = 0; i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		const gchar *physical_id = fu_device_get_physical_id (device);
+		const gchar *serial = fu_device_get_serial (device);
+
+		/* let the user know the cached state was out of date */
+		if (self->devices_cached != NULL) {
+			gboolean found = FALSE;
+			for (guint j = 0; j < self->devices_cached->len; j++) {
+				FwupdDevice *dev = g_ptr_array_index (self->devices_cached, j);
+				if (g_strcmp0 (fwupd_device_get_id (dev),
+					       fu_device_get_id (device)) != 0)
+					continue;
+				if (g_strcmp0 (fwupd_device_get_version (dev),
+					       fu_device_get_version (device)) != 0) {
+					g_debug ("cached device %s changed version from %s to %s",
+						 fu_device_get_id (device),
+						 fwupd_device_get_version (dev),
+						 fu_device_get_version (device));
+				}
+				found = TRUE;
+				break;
+			}
+			if (!found)
+				g_debug ("device %s was not cached", fu_device_get_id (device));
+		}
+		g_variant_builder_add (&builder, "(ss@a{sv})",
+				       physical_id != NULL ? physical_id : "",
+				       serial != NULL ? serial : "",
+				       fwupd_device_to_variant_full (FWUPD_DEVICE (device),
+								     FWUPD_DEVICE_FLAG_TRUSTED));
+	}
+	val = g_variant_ref_sink (g_variant_new ("(sa(ssa{sv}))", boot_id, &builder));
+	blob = g_variant_get_data_as_bytes (val);
+	if (!fu_common_mkdir_parent (fn, &error_local) ||
+	    !fu_common_set_contents_bytes (fn, blob, &error_local)) {
+		g_debug ("failed to save device cache: %s", error_local->message);
+		return;
+	}
+}
+
+/**
+ * fu_engine_coldplug:
+ * @self: A #FuEngine
+ * @error: A #GError, or %NULL
+ *
+ * Enumerates devices when the engine was loaded with
+ * %FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG, replacing the cached devices.
+ *
+ * This is called automatically by fu_engine_load() when the flag is not set.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_engine_coldplug (FuEngine *self, GError **error)
+{
+	g_return_val_if_fail (FU_IS_ENGINE (self), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* already done */
+	if (self->loaded)
+		return TRUE;
+
+	/* add devices */
+	fu_profile_push (self->profile, "coldplug");
+	if (self->load_flags & FU_ENGINE_LOAD_FLAG_COLDPLUG)
+		fu_engine_plugins_coldplug (self, FALSE);
+
+	/* coldplug backends */
+	if (self->load_flags & FU_ENGINE_LOAD_FLAG_COLDPLUG) {
+		for (guint i = 0; i < self->backends->len; i++) {
+			FuBackend *backend = g_ptr_array_index (self->backends, i);
+			g_autoptr(GError) error_backend = NULL;
+			if (!fu_backend_get_enabled (backend))
+				continue;
+			g_signal_connect (backend, "device-added",
+					  G_CALLBACK (fu_engine_backend_device_added_cb),
+					  self);
+			g_signal_connect (backend, "device-removed",
+					  G_CALLBACK (fu_engine_backend_device_removed_cb),
+					  self);
+			g_signal_connect (backend, "device-changed",
+					  G_CALLBACK (fu_engine_backend_device_changed_cb),
+					  self);
+			fu_profile_push (self->profile, "backend(%s)",
+					 fu_backend_get_name (backend));
+			if (!fu_backend_coldplug (backend, &error_backend)) {
+				g_warning ("failed to coldplug backend %s: %s",
+					   fu_backend_get_name (backend),
+					   error_backend->message);
+				fu_profile_pop (self->profile);
+				continue;
+			}
+			fu_profile_pop (self->profile);
+		}
+	}
+
+	/* set device properties from the metadata */
+	fu_engine_md_refresh_devices (self);
+
+	/* update the db for devices that were updated during the reboot */
+	if (!fu_engine_update_history_database (self, error))
+		return FALSE;
+
+	/* save for the next time the daemon starts */
+	if ((self->load_flags & FU_ENGINE_LOAD_FLAG_COLDPLUG) &&
+	    (self->load_flags & FU_ENGINE_LOAD_FLAG_READONLY) == 0 &&
+	    !self->offline_plan)
+		fu_engine_devices_cache_save (self);
+	g_clear_pointer (&self->devices_cached, g_ptr_array_unref);
+
+	/* what was only needed for startup */
+	if (fu_config_get_low_memory (self->config))
+		fu_engine_release_memory (self);
+
+	/* anything after this is not part of startup */
+	if (fu_efivar_get_read_count () > 0) {
+		g_autofree gchar *id = g_strdup_printf ("efivarfs(%u reads)",
+							fu_efivar_get_read_count ());
+		fu_profile_add (self->profile, id, 0.f);
+	}
+	if (fu_volume_get_mount_count () > 0) {
+		g_autofree gchar *id = g_strdup_printf ("volumes(%u mounts, %u unmounts)",
+							fu_volume_get_mount_count (),
+							fu_volume_get_unmount_count ());
+		fu_profile_add (self->profile, id, 0.f);
+	}
+	fu_profile_stop (self->profile);
+
+	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
+	self->loaded = TRUE;
+
+	/* let clients know engine finished starting up */
+	fu_engine_emit_changed (self);
+
+	/* success */
+	return TRUE;
+}
+
+static void
+fu_engine_add_firmware_gtypes_builtin (FuEngine *self)
+{
+	fu_engine_add_firmware_gtype (self, "raw", FU_TYPE_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "dfu", FU_TYPE_DFU_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "dfuse", FU_TYPE_DFUSE_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "fmap", FU_TYPE_FMAP_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "ihex", FU_TYPE_IHEX_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "srec", FU_TYPE_SREC_FIRMWARE);
+	fu_engine_add_firmware_gtype (self, "smbios", FU_TYPE_SMBIOS);
+}
+
+/* the plugins are opened so they can register the firmware types, but
+ * nothing is started and no hardware is enumerated */
+static gboolean
+fu_engine_load_firmware_gtypes (FuEngine *self, GError **error)
+{
+	fu_engine_add_firmware_gtypes_builtin (self);
+	fu_profile_push (self->profile, "plugins");
+	if (!fu_engine_load_plugins (self, error)) {
+		g_prefix_error (error, "Failed to load plugins: ");
+		return FALSE;
+	}
+	fu_profile_pop (self->profile);
+	fu_profile_pop (self->profile);
+	self->loaded = TRUE;
+	return TRUE;
+}
+
 /**
  * fu_engine_load:
  * @self: A #FuEngine
@@ -6309,6 +10313,8 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	/* avoid re-loading a second time if fu-tool or fu-util request to */
 	if (self->loaded)
 		return TRUE;
+	self->load_flags = flags;
+	fu_profile_push (self->profile, "load");
 
 /* TODO: Read registry key [HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Cryptography] "MachineGuid" */
 #ifndef _WIN32
@@ -6318,20 +10324,40 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		g_debug ("failed to build machine-id: %s", error_local->message);
 #endif
 	/* read config file */
+	fu_profile_push (self->profile, "config");
 	if (!fu_config_load (self->config, error)) {
 		g_prefix_error (error, "Failed to load config: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
+	fu_history_set_write_ahead_log (self->history,
+					fu_config_get_batch_history_writes (self->config));
+
+	/* only the parsers are required, e.g. for fwupdtool firmware-parse */
+	if (flags & FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES)
+		return fu_engine_load_firmware_gtypes (self, error);
+
+	/* started by fwupd-offline-update */
+	if (flags & FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG)
+		fu_engine_offline_plan_load (self);
+
+	/* publish the devices from the last run until the coldplug is done */
+	if ((flags & FU_ENGINE_LOAD_FLAG_COLDPLUG) &&
+	    (flags & FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG) &&
+	    !self->offline_plan)
+		fu_engine_devices_cache_load (self);
 
 	/* read remotes */
 	if (flags & FU_ENGINE_LOAD_FLAG_REMOTES) {
 		FuRemoteListLoadFlags remote_list_flags = FU_REMOTE_LIST_LOAD_FLAG_NONE;
 		if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
 			remote_list_flags |= FU_REMOTE_LIST_LOAD_FLAG_READONLY_FS;
+		fu_profile_push (self->profile, "remotes");
 		if (!fu_remote_list_load (self->remote_list, remote_list_flags, error)) {
 			g_prefix_error (error, "Failed to load remotes: ");
 			return FALSE;
 		}
+		fu_profile_pop (self->profile);
 	}
 
 	/* create client certificate */
@@ -6369,32 +10395,54 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	if ((self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0)
 		fu_idle_set_timeout (self->idle, fu_config_get_idle_timeout (self->config));
 
+	/* set up background verification */
+	if ((self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0 &&
+	    fu_config_get_verify_interval (self->config) > 0 &&
+	    self->verify_id == 0) {
+		self->verify_id = g_timeout_add_seconds (FU_ENGINE_VERIFY_PACE,
+							 fu_engine_verify_background_cb,
+							 self);
+	}
+
+	/* set up history maintenance */
+	if ((self->app_flags & FU_APP_FLAGS_NO_IDLE_SOURCES) == 0 &&
+	    (fu_config_get_history_max_entries (self->config) > 0 ||
+	     fu_config_get_history_max_age (self->config) > 0) &&
+	    self->history_prune_id == 0) {
+		self->history_prune_id = g_timeout_add_seconds (FU_ENGINE_HISTORY_PRUNE_PACE,
+								fu_engine_history_prune_cb,
+								self);
+	}
+
 	/* load quirks, SMBIOS and the hwids */
 	if (flags & FU_ENGINE_LOAD_FLAG_HWINFO) {
+		fu_profile_push (self->profile, "smbios");
 		fu_engine_load_smbios (self);
+		fu_profile_pop (self->profile);
+		fu_profile_push (self->profile, "hwids");
 		fu_engine_load_hwids (self);
+		fu_profile_pop (self->profile);
 	}
 	/* on a read-only filesystem don't care about the cache GUID */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
 		quirks_flags |= FU_QUIRKS_LOAD_FLAG_READONLY_FS;
+	fu_profile_push (self->profile, "quirks");
 	fu_engine_load_quirks (self, quirks_flags);
+	fu_profile_pop (self->profile);
 
 	/* load AppStream metadata */
+	fu_profile_push (self->profile, "metadata");
 	if (!fu_engine_load_metadata_store (self, flags, error)) {
 		g_prefix_error (error, "Failed to load AppStream data: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* add the "built-in" firmware types */
-	fu_engine_add_firmware_gtype (self, "raw", FU_TYPE_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "dfu", FU_TYPE_DFU_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "dfuse", FU_TYPE_DFUSE_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "fmap", FU_TYPE_FMAP_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "ihex", FU_TYPE_IHEX_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "srec", FU_TYPE_SREC_FIRMWARE);
-	fu_engine_add_firmware_gtype (self, "smbios", FU_TYPE_SMBIOS);
+	fu_engine_add_firmware_gtypes_builtin (self);
 
 	/* set up backends */
+	fu_profile_push (self->profile, "backends");
 	for (guint i = 0; i < self->backends->len; i++) {
 		FuBackend *backend = g_ptr_array_index (self->backends, i);
 		g_autoptr(GError) error_backend = NULL;
@@ -6406,6 +10454,7 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		}
 		backend_cnt++;
 	}
+	fu_profile_pop (self->profile);
 	if (backend_cnt == 0) {
 		g_set_error_literal (error,
 				     FWUPD_ERROR,
@@ -6420,11 +10469,20 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 		return FALSE;
 	}
 
+	/* plugins read many of the same UEFI variables during startup */
+	if (fu_efivar_supported (NULL)) {
+		g_autoptr(GError) error_local = NULL;
+		if (!fu_efivar_set_cache_enabled (TRUE, &error_local))
+			g_debug ("not caching efivars: %s", error_local->message);
+	}
+
 	/* load plugin */
+	fu_profile_push (self->profile, "plugins");
 	if (!fu_engine_load_plugins (self, error)) {
 		g_prefix_error (error, "Failed to load plugins: ");
 		return FALSE;
 	}
+	fu_profile_pop (self->profile);
 
 	/* watch the device list for updates and proxy */
 	g_signal_connect (self->device_list, "added",
@@ -6439,47 +10497,12 @@ fu_engine_load (FuEngine *self, FuEngineLoadFlags flags, GError **error)
 	fu_engine_set_status (self, FWUPD_STATUS_LOADING);
 
 	/* add devices */
+	fu_profile_push (self->profile, "startup");
 	fu_engine_plugins_setup (self);
-	if (flags & FU_ENGINE_LOAD_FLAG_COLDPLUG)
-		fu_engine_plugins_coldplug (self, FALSE);
-
-	/* coldplug backends */
-	if (flags & FU_ENGINE_LOAD_FLAG_COLDPLUG) {
-		for (guint i = 0; i < self->backends->len; i++) {
-			FuBackend *backend = g_ptr_array_index (self->backends, i);
-			g_autoptr(GError) error_backend = NULL;
-			if (!fu_backend_get_enabled (backend))
-				continue;
-			g_signal_connect (backend, "device-added",
-					  G_CALLBACK (fu_engine_backend_device_added_cb),
-					  self);
-			g_signal_connect (backend, "device-removed",
-					  G_CALLBACK (fu_engine_backend_device_removed_cb),
-					  self);
-			g_signal_connect (backend, "device-changed",
-					  G_CALLBACK (fu_engine_backend_device_changed_cb),
-					  self);
-			if (!fu_backend_coldplug (backend, &error_backend)) {
-				g_warning ("failed to coldplug backend %s: %s",
-					   fu_backend_get_name (backend),
-					   error_backend->message);
-				continue;
-			}
-		}
-	}
-
-	/* set device properties from the metadata */
-	fu_engine_md_refresh_devices (self);
-
-	/* update the db for devices that were updated during the reboot */
-	if (!fu_engine_update_history_database (self, error))
-		return FALSE;
-
-	fu_engine_set_status (self, FWUPD_STATUS_IDLE);
-	self->loaded = TRUE;
-
-	/* let clients know engine finished starting up */
-	fu_engine_emit_changed (self);
+	fu_profile_pop (self->profile);
+	fu_profile_pop (self->profile);
+	if ((flags & FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG) == 0)
+		return fu_engine_coldplug (self, error);
 
 	/* success */
 	return TRUE;
@@ -6521,6 +10544,11 @@ fu_engine_class_init (FuEngineClass *klass)
 			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
 			      0, NULL, NULL, g_cclosure_marshal_VOID__UINT,
 			      G_TYPE_NONE, 1, G_TYPE_UINT);
+	signals[SIGNAL_SECURITY_CHANGED] =
+		g_signal_new ("security-changed",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL, g_cclosure_marshal_generic,
+			      G_TYPE_NONE, 1, G_TYPE_UINT64);
 }
 
 void
@@ -6544,8 +10572,57 @@ static void
 fu_engine_idle_status_notify_cb (FuIdle *idle, GParamSpec *pspec, FuEngine *self)
 {
 	FwupdStatus status = fu_idle_get_status (idle);
-	if (status == FWUPD_STATUS_SHUTDOWN)
-		fu_engine_set_status (self, status);
+	if (status != FWUPD_STATUS_SHUTDOWN)
+		return;
+
+	/* devices may have been hotplugged or updated since coldplug, so
+	 * refresh the snapshot served when the daemon is next activated */
+	if (self->loaded &&
+	    (self->load_flags & FU_ENGINE_LOAD_FLAG_COLDPLUG) &&
+	    (self->load_flags & FU_ENGINE_LOAD_FLAG_READONLY) == 0 &&
+	    !self->offline_plan)
+		fu_engine_devices_cache_save (self);
+	fu_engine_set_status (self, status);
+}
+
+static void
+fu_engine_public_keys_changed_cb (GFileMonitor *monitor,
+				  GFile *file,
+				  GFile *other_file,
+				  GFileMonitorEvent event_type,
+				  gpointer user_data)
+{
+	FuEngine *self = FU_ENGINE (user_data);
+	const gchar *path = g_object_get_data (G_OBJECT (monitor), "fwupd::Path");
+
+	if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+	    event_type != G_FILE_MONITOR_EVENT_CREATED &&
+	    event_type != G_FILE_MONITOR_EVENT_DELETED)
+		return;
+
+	/* signatures that failed before may now be trusted, or the other way */
+	g_debug ("public keys in %s changed, forgetting verification results", path);
+	fu_common_jcat_invalidate_cache (self->jcat_context);
+	jcat_context_add_public_keys (self->jcat_context, path);
+}
+
+static void
+fu_engine_watch_public_keys (FuEngine *self, const gchar *path)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GFile) file = g_file_new_for_path (path);
+	g_autoptr(GFileMonitor) monitor = NULL;
+
+	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, &error_local);
+	if (monitor == NULL) {
+		g_debug ("failed to watch %s: %s", path, error_local->message);
+		return;
+	}
+	g_object_set_data_full (G_OBJECT (monitor), "fwupd::Path",
+				g_strdup (path), g_free);
+	g_signal_connect (monitor, "changed",
+			  G_CALLBACK (fu_engine_public_keys_changed_cb), self);
+	g_ptr_array_add (self->pki_monitors, g_steal_pointer (&monitor));
 }
 
 static void
@@ -6566,16 +10643,39 @@ fu_engine_init (FuEngine *self)
 	self->smbios = fu_smbios_new ();
 	self->hwids = fu_hwids_new ();
 	self->idle = fu_idle_new ();
+	self->profile = fu_profile_new ();
+	self->metrics = fu_metrics_new ();
 	self->quirks = fu_quirks_new ();
 	self->history = fu_history_new ();
 	self->plugin_list = fu_plugin_list_new ();
 	self->plugin_filter = g_ptr_array_new_with_free_func (g_free);
+	self->plugins_deferred = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->host_security_attrs = fu_security_attrs_new ();
+	self->host_security_generation = (guint64) g_get_real_time ();
+	self->security_attrs_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+							    g_free, (GDestroyNotify) g_object_unref);
+	self->install_phase = FU_ENGINE_INSTALL_PHASE_LAST;
+	self->device_changed_pending = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+							      NULL, (GDestroyNotify) g_object_unref);
+	self->verify_unsupported = g_hash_table_new_full (g_str_hash, g_str_equal,
+							  g_free, NULL);
+	g_mutex_init (&self->job_mutex);
+	self->job_locks = g_hash_table_new_full (g_str_hash, g_str_equal,
+						 g_free, (GDestroyNotify) fu_engine_job_lock_free);
 	self->udev_subsystems = g_ptr_array_new_with_free_func (g_free);
 	self->backends = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	self->silos = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	self->silos_guids = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+	self->cabinet_cache = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_cabinet_cache_item_free);
+	self->silos_remote = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free, (GDestroyNotify) g_object_unref);
 	self->runtime_versions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->compile_versions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	self->firmware_gtypes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	self->main_thread = g_thread_self ();
+	self->coldplug_events = g_async_queue_new_full ((GDestroyNotify) fu_engine_coldplug_event_free);
+	self->hotplug_pools = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	self->hotplug_jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_engine_hotplug_job_free);
 
 	g_signal_connect (self->config, "changed",
 			  G_CALLBACK (fu_engine_config_changed_cb),
@@ -6607,6 +10707,9 @@ fu_engine_init (FuEngine *self)
 	jcat_context_add_public_keys (self->jcat_context, pkidir_fw);
 	pkidir_md = g_build_filename (sysconfdir, "pki", "fwupd-metadata", NULL);
 	jcat_context_add_public_keys (self->jcat_context, pkidir_md);
+	self->pki_monitors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	fu_engine_watch_public_keys (self, pkidir_fw);
+	fu_engine_watch_public_keys (self, pkidir_md);
 
 	/* add some runtime versions of things the daemon depends on */
 	fu_engine_add_runtime_version (self, "org.freedesktop.fwupd", VERSION);
@@ -6643,19 +10746,47 @@ static void
 fu_engine_finalize (GObject *obj)
 {
 	FuEngine *self = FU_ENGINE (obj);
-
-	if (self->silo != NULL)
-		g_object_unref (self->silo);
+	GHashTableIter iter;
+	gpointer pool;
+
+	/* wait for any hotplug workers */
+	g_hash_table_iter_init (&iter, self->hotplug_pools);
+	while (g_hash_table_iter_next (&iter, NULL, &pool))
+		g_thread_pool_free (pool, FALSE, TRUE);
+	g_hash_table_unref (self->hotplug_pools);
+	g_ptr_array_unref (self->hotplug_jobs);
+
+	g_hash_table_unref (self->silos_remote);
+	g_ptr_array_unref (self->silos);
+	g_ptr_array_unref (self->silos_guids);
+	g_ptr_array_unref (self->cabinet_cache);
 	if (self->coldplug_id != 0)
 		g_source_remove (self->coldplug_id);
+	if (self->device_changed_id != 0)
+		g_source_remove (self->device_changed_id);
+	if (self->verify_id != 0)
+		g_source_remove (self->verify_id);
+	if (self->history_prune_id != 0)
+		g_source_remove (self->history_prune_id);
+	g_hash_table_unref (self->verify_unsupported);
+	g_hash_table_unref (self->job_locks);
+	g_mutex_clear (&self->job_mutex);
 	if (self->approved_firmware != NULL)
 		g_hash_table_unref (self->approved_firmware);
 	if (self->blocked_firmware != NULL)
 		g_hash_table_unref (self->blocked_firmware);
 
+	if (self->devices_cached != NULL)
+		g_ptr_array_unref (self->devices_cached);
+	g_object_unref (self->profile);
+	g_object_unref (self->metrics);
 	g_free (self->host_machine_id);
 	g_free (self->host_security_id);
 	g_object_unref (self->host_security_attrs);
+	if (self->host_security_variant != NULL)
+		g_variant_unref (self->host_security_variant);
+	g_hash_table_unref (self->security_attrs_cache);
+	g_hash_table_unref (self->device_changed_pending);
 	g_object_unref (self->idle);
 	g_object_unref (self->config);
 	g_object_unref (self->remote_list);
@@ -6664,13 +10795,21 @@ fu_engine_finalize (GObject *obj)
 	g_object_unref (self->hwids);
 	g_object_unref (self->history);
 	g_object_unref (self->device_list);
+	for (guint i = 0; i < self->pki_monitors->len; i++)
+		g_file_monitor_cancel (g_ptr_array_index (self->pki_monitors, i));
+	g_ptr_array_unref (self->pki_monitors);
 	g_object_unref (self->jcat_context);
 	g_ptr_array_unref (self->plugin_filter);
+	g_hash_table_unref (self->plugins_deferred);
+	fu_efivar_set_cache_enabled (FALSE, NULL);
 	g_ptr_array_unref (self->udev_subsystems);
+	if (self->os_release != NULL)
+		g_hash_table_unref (self->os_release);
 	g_ptr_array_unref (self->backends);
 	g_hash_table_unref (self->runtime_versions);
 	g_hash_table_unref (self->compile_versions);
 	g_hash_table_unref (self->firmware_gtypes);
+	g_async_queue_unref (self->coldplug_events);
 	g_object_unref (self->plugin_list);
 
 	G_OBJECT_CLASS (fu_engine_parent_class)->finalize (obj);
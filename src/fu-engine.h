@@ -14,9 +14,13 @@
 #include "fwupd-enums.h"
 
 #include "fu-common.h"
+#include "fu-config.h"
 #include "fu-engine-request.h"
 #include "fu-install-task.h"
 #include "fu-plugin.h"
+#include "fu-plugin-builtin.h"
+#include "fu-metrics.h"
+#include "fu-profile.h"
 #include "fu-security-attrs.h"
 
 #define FU_TYPE_ENGINE (fu_engine_get_type ())
@@ -29,6 +33,9 @@ G_DECLARE_FINAL_TYPE (FuEngine, fu_engine, FU, ENGINE, GObject)
  * @FU_ENGINE_LOAD_FLAG_COLDPLUG:	Enumerate devices
  * @FU_ENGINE_LOAD_FLAG_REMOTES:	Enumerate remotes
  * @FU_ENGINE_LOAD_FLAG_HWINFO:		Load details about the hardware
+ * @FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG:	Use the device cache until fu_engine_coldplug() is called
+ * @FU_ENGINE_LOAD_FLAG_LAZY_PLUGINS:	Only load plugins when matching hardware is found
+ * @FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES:	Only register the firmware types, without quirks, metadata or devices
  *
  * The flags to use when loading the engine.
  **/
@@ -38,21 +45,37 @@ typedef enum {
 	FU_ENGINE_LOAD_FLAG_COLDPLUG		= 1 << 1,
 	FU_ENGINE_LOAD_FLAG_REMOTES		= 1 << 2,
 	FU_ENGINE_LOAD_FLAG_HWINFO		= 1 << 3,
+	FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG	= 1 << 4,
+	FU_ENGINE_LOAD_FLAG_LAZY_PLUGINS	= 1 << 5,
+	FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES	= 1 << 6,
 	/*< private >*/
 	FU_ENGINE_LOAD_FLAG_LAST
 } FuEngineLoadFlags;
 
+typedef gboolean (*FuEngineJobFunc)			(FuEngine	*self,
+							 const gchar	*device_id,
+							 gpointer	 user_data,
+							 GError		**error);
+typedef void (*FuEngineVerifyFunc)			(FuEngine	*self,
+							 FuDevice	*device,
+							 const GError	*error,
+							 gpointer	 user_data);
+
 FuEngine	*fu_engine_new				(FuAppFlags	 app_flags);
 void		 fu_engine_add_app_flag			(FuEngine	*self,
 							 FuAppFlags	 app_flags);
 void		 fu_engine_add_plugin_filter		(FuEngine	*self,
 							 const gchar	*plugin_glob);
+void		 fu_engine_set_plugin_builtins		(FuEngine	*self,
+							 const FuPluginBuiltin *plugin_builtins);
 void		 fu_engine_idle_reset			(FuEngine	*self);
 gboolean	 fu_engine_load				(FuEngine	*self,
 							 FuEngineLoadFlags flags,
 							 GError		**error);
 gboolean	 fu_engine_load_plugins			(FuEngine	*self,
 							 GError		**error);
+gboolean	 fu_engine_coldplug			(FuEngine	*self,
+							 GError		**error);
 gboolean	 fu_engine_get_tainted			(FuEngine	*self);
 const gchar	*fu_engine_get_host_product		(FuEngine *self);
 const gchar	*fu_engine_get_host_machine_id		(FuEngine *self);
@@ -65,6 +88,13 @@ guint64		 fu_engine_get_archive_size_max		(FuEngine	*self);
 GPtrArray	*fu_engine_get_plugins			(FuEngine	*self);
 GPtrArray	*fu_engine_get_devices			(FuEngine	*self,
 							 GError		**error);
+GPtrArray	*fu_engine_get_devices_cached		(FuEngine	*self);
+FuProfile	*fu_engine_get_profile			(FuEngine	*self);
+FuConfig	*fu_engine_get_config			(FuEngine	*self);
+FuMetrics	*fu_engine_get_metrics			(FuEngine	*self);
+gchar		*fu_engine_get_metrics_string		(FuEngine	*self,
+							 GError		**error);
+GVariant	*fu_engine_get_hotplug_latency		(FuEngine	*self);
 FuDevice	*fu_engine_get_device			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
@@ -94,6 +124,8 @@ FwupdDevice	*fu_engine_get_results			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
 FuSecurityAttrs	*fu_engine_get_host_security_attrs	(FuEngine	*self);
+GVariant	*fu_engine_get_host_security_variant	(FuEngine	*self);
+guint64		 fu_engine_get_host_security_generation	(FuEngine	*self);
 GHashTable	*fu_engine_get_report_metadata		(FuEngine	*self,
 							 GError		**error);
 gboolean	 fu_engine_clear_results		(FuEngine	*self,
@@ -104,6 +136,26 @@ gboolean	 fu_engine_update_metadata		(FuEngine	*self,
 							 gint		 fd,
 							 gint		 fd_sig,
 							 GError		**error);
+void		 fu_engine_update_metadata_async	(FuEngine	*self,
+							 const gchar	*remote_id,
+							 gint		 fd,
+							 gint		 fd_sig,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fu_engine_update_metadata_finish	(FuEngine	*self,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fu_engine_update_metadata_batch_async	(FuEngine	*self,
+							 GPtrArray	*remote_ids,
+							 GArray		*fds,
+							 GCancellable	*cancellable,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fu_engine_update_metadata_batch_finish	(FuEngine	*self,
+							 GAsyncResult	*res,
+							 GError		**error);
+guint		 fu_engine_get_metadata_generation	(FuEngine	*self);
 gboolean	 fu_engine_update_metadata_bytes	(FuEngine	*self,
 							 const gchar	*remote_id,
 							 GBytes		*bytes_raw,
@@ -114,9 +166,11 @@ gboolean	 fu_engine_unlock			(FuEngine	*self,
 							 GError		**error);
 gboolean	 fu_engine_verify			(FuEngine	*self,
 							 const gchar	*device_id,
+							 FwupdInstallFlags flags,
 							 GError		**error);
 gboolean	 fu_engine_verify_update		(FuEngine	*self,
 							 const gchar	*device_id,
+							 FwupdInstallFlags flags,
 							 GError		**error);
 GBytes		*fu_engine_firmware_dump		(FuEngine	*self,
 							 FuDevice	*device,
@@ -161,6 +215,24 @@ GPtrArray	*fu_engine_get_details			(FuEngine	*self,
 gboolean	 fu_engine_activate			(FuEngine	*self,
 							 const gchar	*device_id,
 							 GError		**error);
+void		 fu_engine_run_job_async		(FuEngine	*self,
+							 const gchar	*device_id,
+							 FuEngineJobFunc func,
+							 gpointer	 user_data,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fu_engine_run_job_finish		(FuEngine	*self,
+							 GAsyncResult	*res,
+							 GError		**error);
+void		 fu_engine_verify_all_async		(FuEngine	*self,
+							 FwupdInstallFlags flags,
+							 FuEngineVerifyFunc func,
+							 gpointer	 user_data,
+							 GAsyncReadyCallback callback,
+							 gpointer	 callback_data);
+gboolean	 fu_engine_verify_all_finish		(FuEngine	*self,
+							 GAsyncResult	*res,
+							 GError		**error);
 GPtrArray	*fu_engine_get_approved_firmware	(FuEngine	*self);
 void		 fu_engine_add_approved_firmware	(FuEngine	*self,
 							 const gchar	*checksum);
@@ -12,10 +12,17 @@
 
 #include "fu-engine.h"
 
+typedef struct {
+	guint64		 cnt;
+	gdouble		 elapsed;	/* ms */
+} FuFirmwareDumpStats;
+
 typedef struct {
 	gboolean	 verbose;
 	gint		 timeout;	/* ms */
+	gint		 iterations;
 	GPtrArray	*array;		/* element-type FuFirmware */
+	GArray		*stats;		/* element-type FuFirmwareDumpStats, same order as array */
 	FuEngine	*engine;
 } FuUtil;
 
@@ -23,10 +30,12 @@ extern void HF_ITER(guint8 **buf, gsize *len);
 
 static gboolean
 fu_firmware_dump_parse (FuUtil *self,
-			FuFirmware *firmware,
+			guint idx,
 			GBytes *fw,
 			GError **error)
 {
+	FuFirmware *firmware = g_ptr_array_index (self->array, idx);
+	FuFirmwareDumpStats *stats = &g_array_index (self->stats, FuFirmwareDumpStats, idx);
 	gboolean ret;
 	gdouble elapsed_ms;
 	g_autoptr(GError) error_local = NULL;
@@ -41,6 +50,8 @@ fu_firmware_dump_parse (FuUtil *self,
 
 	/* a timeout is more important than the actual parse failure */
 	elapsed_ms = g_timer_elapsed (timer, NULL) * 1000;
+	stats->cnt++;
+	stats->elapsed += elapsed_ms;
 	if (self->timeout > 0 &&
 	    elapsed_ms > self->timeout) {
 		g_set_error (error,
@@ -65,6 +76,21 @@ fu_firmware_dump_parse (FuUtil *self,
 	return TRUE;
 }
 
+/* the throughput of each parser, to find the slow ones */
+static void
+fu_firmware_dump_report (FuUtil *self)
+{
+	for (guint i = 0; i < self->array->len; i++) {
+		FuFirmware *firmware = g_ptr_array_index (self->array, i);
+		FuFirmwareDumpStats *stats = &g_array_index (self->stats, FuFirmwareDumpStats, i);
+		if (stats->cnt == 0 || stats->elapsed <= 0.f)
+			continue;
+		g_printerr ("%s: %" G_GUINT64_FORMAT " execs, %.0f execs/s\n",
+			    G_OBJECT_TYPE_NAME (firmware), stats->cnt,
+			    (gdouble) stats->cnt * 1000.f / stats->elapsed);
+	}
+}
+
 static gboolean
 fu_firmware_dump_iter (FuUtil *self, GBytes *blob, GError **error)
 {
@@ -74,7 +100,7 @@ fu_firmware_dump_iter (FuUtil *self, GBytes *blob, GError **error)
 		g_autoptr(GError) error_local = NULL;
 		g_autofree gchar *str = NULL;
 
-		if (!fu_firmware_dump_parse (self, firmware, blob, &error_local)) {
+		if (!fu_firmware_dump_parse (self, i, blob, &error_local)) {
 			/* timeout so bail */
 			if (g_error_matches (error_local,
 					     G_IO_ERROR,
@@ -116,6 +142,8 @@ fu_util_private_free (FuUtil *self)
 {
 	if (self->array != NULL)
 		g_ptr_array_unref (self->array);
+	if (self->stats != NULL)
+		g_array_unref (self->stats);
 	if (self->engine != NULL)
 		g_object_unref (self->engine);
 	g_free (self);
@@ -140,6 +168,9 @@ main (int argc, char **argv)
 		{ "timeout", 't', 0, G_OPTION_ARG_INT, &self->timeout,
 			/* TRANSLATORS: command line option */
 			_("Timeout in milliseconds for each parse"), NULL },
+		{ "iterations", 'i', 0, G_OPTION_ARG_INT, &self->iterations,
+			/* TRANSLATORS: command line option */
+			_("Parse each file this many times and show the throughput"), NULL },
 		{ NULL}
 	};
 
@@ -169,6 +200,9 @@ main (int argc, char **argv)
 
 	/* load engine */
 	self->engine = fu_engine_new (FU_APP_FLAGS_NO_IDLE_SOURCES);
+#ifdef HAVE_PLUGIN_BUILTIN
+	fu_engine_set_plugin_builtins (self->engine, fu_plugin_builtins);
+#endif
 	if (!fu_engine_load (self->engine, FU_ENGINE_LOAD_FLAG_READONLY, &error)) {
 		g_printerr ("Failed to load engine: %s\n", error->message);
 		return 1;
@@ -182,6 +216,8 @@ main (int argc, char **argv)
 		GType gtype = fu_engine_get_firmware_gtype_by_id (self->engine, id);
 		g_ptr_array_add (self->array, g_object_new (gtype, NULL));
 	}
+	self->stats = g_array_new (FALSE, TRUE, sizeof(FuFirmwareDumpStats));
+	g_array_set_size (self->stats, self->array->len);
 
 	/* no args */
 	if (argc >= 2) {
@@ -196,18 +232,23 @@ main (int argc, char **argv)
 				rc = 2;
 				continue;
 			}
-			if (!fu_firmware_dump_iter (self, blob, &error_local)) {
-				g_printerr ("failed to parse file %s: %s\n",
-					    argv[i], error_local->message);
-				if (g_error_matches (error_local,
-						     G_IO_ERROR,
-						     G_IO_ERROR_TIMED_OUT)) {
-					return 4;
+			for (gint j = 0; j < MAX (self->iterations, 1); j++) {
+				g_autoptr(GError) error_iter = NULL;
+				if (!fu_firmware_dump_iter (self, blob, &error_iter)) {
+					g_printerr ("failed to parse file %s: %s\n",
+						    argv[i], error_iter->message);
+					if (g_error_matches (error_iter,
+							     G_IO_ERROR,
+							     G_IO_ERROR_TIMED_OUT)) {
+						return 4;
+					}
+					rc = 3;
+					break;
 				}
-				rc = 3;
-				continue;
 			}
 		}
+		if (self->iterations > 1)
+			fu_firmware_dump_report (self);
 		return rc;
 	}
 	for (;;) {
@@ -222,9 +263,8 @@ main (int argc, char **argv)
 #endif
 		blob = g_bytes_new_static (buf, len);
 		for (guint i = 0; i < self->array->len; i++) {
-			FuFirmware *firmware = g_ptr_array_index (self->array, i);
 			g_autoptr(GError) error_local = NULL;
-			if (!fu_firmware_dump_parse (self, firmware, blob, &error_local)) {
+			if (!fu_firmware_dump_parse (self, i, blob, &error_local)) {
 				if (g_error_matches (error_local,
 						     G_IO_ERROR,
 						     G_IO_ERROR_TIMED_OUT)) {
@@ -20,7 +20,7 @@
 #include "fu-history.h"
 #include "fu-mutex.h"
 
-#define FU_HISTORY_CURRENT_SCHEMA_VERSION	6
+#define FU_HISTORY_CURRENT_SCHEMA_VERSION	11
 
 static void fu_history_finalize			 (GObject *object);
 
@@ -29,6 +29,9 @@ struct _FuHistory
 	GObject			 parent_instance;
 	sqlite3			*db;
 	GRWLock			 db_mutex;
+	GHashTable		*stmts;		/* SQL : sqlite3_stmt */
+	gboolean		 write_ahead_log;
+	guint			 transaction_depth;
 };
 
 G_DEFINE_TYPE (FuHistory, fu_history, G_TYPE_OBJECT)
@@ -147,6 +150,47 @@ fu_history_stmt_exec (FuHistory *self, sqlite3_stmt *stmt,
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
 			     "failed to execute prepared statement: %s",
 			     sqlite3_errmsg (self->db));
+		sqlite3_reset (stmt);
+		return FALSE;
+	}
+	sqlite3_reset (stmt);
+	return TRUE;
+}
+
+/* returns a statement owned by @self, and must be called with db_mutex
+ * held for writing as the bindings are cleared */
+static gint
+fu_history_stmt_prepare_cached (FuHistory *self, const gchar *sql, sqlite3_stmt **stmt)
+{
+	sqlite3_stmt *stmt_tmp = g_hash_table_lookup (self->stmts, sql);
+	if (stmt_tmp == NULL) {
+		gint rc = sqlite3_prepare_v2 (self->db, sql, -1, &stmt_tmp, NULL);
+		if (rc != SQLITE_OK)
+			return rc;
+		g_hash_table_insert (self->stmts, (gpointer) sql, stmt_tmp);
+	} else {
+		sqlite3_reset (stmt_tmp);
+		sqlite3_clear_bindings (stmt_tmp);
+	}
+	*stmt = stmt_tmp;
+	return SQLITE_OK;
+}
+
+/* must be called with db_mutex held for writing */
+static gboolean
+fu_history_ensure_write_ahead_log (FuHistory *self, GError **error)
+{
+	gint rc;
+	if (!self->write_ahead_log)
+		return TRUE;
+	rc = sqlite3_exec (self->db,
+			   "PRAGMA journal_mode=WAL;"
+			   "PRAGMA synchronous=NORMAL;",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to enable write-ahead log: %s",
+			     sqlite3_errmsg (self->db));
 		return FALSE;
 	}
 	return TRUE;
@@ -157,6 +201,7 @@ fu_history_create_database (FuHistory *self, GError **error)
 {
 	gint rc;
 	rc = sqlite3_exec (self->db,
+			 "PRAGMA auto_vacuum=INCREMENTAL;"
 			 "BEGIN TRANSACTION;"
 			 "CREATE TABLE IF NOT EXISTS schema ("
 			 "created timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
@@ -179,10 +224,26 @@ fu_history_create_database (FuHistory *self, GError **error)
 			 "version_new TEXT,"
 			 "checksum_device TEXT DEFAULT NULL,"
 			 "protocol TEXT DEFAULT NULL);"
+			 "CREATE INDEX IF NOT EXISTS history_device_id ON history (device_id);"
+			 "CREATE INDEX IF NOT EXISTS history_checksum ON history (checksum);"
+			 "CREATE INDEX IF NOT EXISTS history_update_state ON history (update_state);"
+			 "CREATE INDEX IF NOT EXISTS history_device_modified ON history (device_modified);"
 			 "CREATE TABLE IF NOT EXISTS approved_firmware ("
 			 "checksum TEXT);"
 			 "CREATE TABLE IF NOT EXISTS blocked_firmware ("
 			 "checksum TEXT);"
+			 "CREATE TABLE IF NOT EXISTS verify ("
+			 "device_id TEXT PRIMARY KEY,"
+			 "checksum TEXT DEFAULT NULL,"
+			 "success INTEGER DEFAULT 0,"
+			 "timestamp INTEGER DEFAULT 0);"
+			 "CREATE TABLE IF NOT EXISTS verify_cache ("
+			 "device_id TEXT PRIMARY KEY,"
+			 "fingerprint TEXT,"
+			 "checksums TEXT);"
+			 "CREATE TABLE IF NOT EXISTS retry_delay ("
+			 "guid TEXT PRIMARY KEY,"
+			 "delay INTEGER DEFAULT 0);"
 			 "COMMIT;", NULL, NULL, NULL);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
@@ -288,6 +349,100 @@ fu_history_migrate_database_v5 (FuHistory *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_history_migrate_database_v6 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE TABLE IF NOT EXISTS verify ("
+			   "device_id TEXT PRIMARY KEY,"
+			   "checksum TEXT DEFAULT NULL,"
+			   "success INTEGER DEFAULT 0,"
+			   "timestamp INTEGER DEFAULT 0);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create table: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v7 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE TABLE IF NOT EXISTS verify_cache ("
+			   "device_id TEXT PRIMARY KEY,"
+			   "fingerprint TEXT,"
+			   "checksums TEXT);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create table: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v8 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE TABLE IF NOT EXISTS retry_delay ("
+			   "guid TEXT PRIMARY KEY,"
+			   "delay INTEGER DEFAULT 0);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create table: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v9 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "CREATE INDEX IF NOT EXISTS history_device_id ON history (device_id);"
+			   "CREATE INDEX IF NOT EXISTS history_checksum ON history (checksum);"
+			   "CREATE INDEX IF NOT EXISTS history_update_state ON history (update_state);"
+			   "CREATE INDEX IF NOT EXISTS history_device_modified ON history (device_modified);",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to create index: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* the auto-vacuum mode can only be changed by rebuilding the file */
+static gboolean
+fu_history_migrate_database_v10 (FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec (self->db,
+			   "PRAGMA auto_vacuum=INCREMENTAL;"
+			   "VACUUM;",
+			   NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to enable auto-vacuum: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /* returns 0 if database is not initialized */
 static guint
 fu_history_get_schema_version (FuHistory *self)
@@ -347,6 +502,26 @@ fu_history_create_or_migrate (FuHistory *self, guint schema_ver, GError **error)
 	case 5:
 		if (!fu_history_migrate_database_v5 (self, error))
 			return FALSE;
+	/* fall through */
+	case 6:
+		if (!fu_history_migrate_database_v6 (self, error))
+			return FALSE;
+	/* fall through */
+	case 7:
+		if (!fu_history_migrate_database_v7 (self, error))
+			return FALSE;
+	/* fall through */
+	case 8:
+		if (!fu_history_migrate_database_v8 (self, error))
+			return FALSE;
+	/* fall through */
+	case 9:
+		if (!fu_history_migrate_database_v9 (self, error))
+			return FALSE;
+	/* fall through */
+	case 10:
+		if (!fu_history_migrate_database_v10 (self, error))
+			return FALSE;
 		break;
 	default:
 		/* this is probably okay, but return an error if we ever delete
@@ -450,10 +625,15 @@ fu_history_load (FuHistory *self, GError **error)
 			}
 			if (!fu_history_open (self, filename, error))
 				return FALSE;
-			return fu_history_create_database (self, error);
+			if (!fu_history_create_database (self, error))
+				return FALSE;
 		}
 	}
 
+	/* optionally avoid an fsync for every write */
+	if (!fu_history_ensure_write_ahead_log (self, error))
+		return FALSE;
+
 	/* success */
 	return TRUE;
 }
@@ -499,7 +679,7 @@ gboolean
 fu_history_modify_device (FuHistory *self, FuDevice *device, GError **error)
 {
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt = NULL;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -515,15 +695,15 @@ fu_history_modify_device (FuHistory *self, FuDevice *device, GError **error)
 	g_debug ("modifying device %s [%s]",
 		 fu_device_get_name (device),
 		 fu_device_get_id (device));
-	rc = sqlite3_prepare_v2 (self->db,
-				 "UPDATE history SET "
-				 "update_state = ?1, "
-				 "update_error = ?2, "
-				 "checksum_device = ?6, "
-				 "device_modified = ?7, "
-				 "flags = ?3 "
-				 "WHERE device_id = ?4;",
-				 -1, &stmt, NULL);
+	rc = fu_history_stmt_prepare_cached (self,
+					     "UPDATE history SET "
+					     "update_state = ?1, "
+					     "update_error = ?2, "
+					     "checksum_device = ?6, "
+					     "device_modified = ?7, "
+					     "flags = ?3 "
+					     "WHERE device_id = ?4;",
+					     &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
 			     "Failed to prepare SQL to update history: %s",
@@ -565,7 +745,7 @@ fu_history_set_device_metadata (FuHistory *self,
 	gint rc;
 	g_autofree gchar *metadata_str = NULL;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
 	g_return_val_if_fail (device_id != NULL, FALSE);
@@ -578,11 +758,11 @@ fu_history_set_device_metadata (FuHistory *self,
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
 	g_debug ("modifying %s", device_id);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "UPDATE history SET "
-				 "metadata = ?1 "
-				 "WHERE device_id = ?2;",
-				 -1, &stmt, NULL);
+	rc = fu_history_stmt_prepare_cached (self,
+					     "UPDATE history SET "
+					     "metadata = ?1 "
+					     "WHERE device_id = ?2;",
+					     &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
 			     "failed to prepare SQL to update history: %s",
@@ -619,7 +799,7 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 	const gchar *checksum = NULL;
 	gint rc;
 	g_autofree gchar *metadata = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt = NULL;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -649,25 +829,26 @@ fu_history_add_device (FuHistory *self, FuDevice *device, FwupdRelease *release,
 	/* add */
 	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, FALSE);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "INSERT INTO history (device_id,"
-						      "update_state,"
-						      "update_error,"
-						      "flags,"
-						      "filename,"
-						      "checksum,"
-						      "display_name,"
-						      "plugin,"
-						      "guid_default,"
-						      "metadata,"
-						      "device_created,"
-						      "device_modified,"
-						      "version_old,"
-						      "version_new,"
-						      "checksum_device,"
-						      "protocol) "
-				 "VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,"
-					 "?11,?12,?13,?14,?15,?16)", -1, &stmt, NULL);
+	rc = fu_history_stmt_prepare_cached (self,
+					     "INSERT INTO history (device_id,"
+								  "update_state,"
+								  "update_error,"
+								  "flags,"
+								  "filename,"
+								  "checksum,"
+								  "display_name,"
+								  "plugin,"
+								  "guid_default,"
+								  "metadata,"
+								  "device_created,"
+								  "device_modified,"
+								  "version_old,"
+								  "version_new,"
+								  "checksum_device,"
+								  "protocol) "
+					     "VALUES (?1,?2,?3,?4,?5,?6,?7,?8,?9,?10,"
+						     "?11,?12,?13,?14,?15,?16)",
+					     &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
 			     "Failed to prepare SQL to insert history: %s",
@@ -777,6 +958,86 @@ fu_history_remove_all (FuHistory *self, GError **error)
 	return fu_history_stmt_exec (self, stmt, NULL, error);
 }
 
+/**
+ * fu_history_prune:
+ * @self: A #FuHistory
+ * @max_entries: the number of entries to keep, or 0 for no limit
+ * @max_age: the age in seconds of entries to keep, or 0 for no limit
+ * @keep_unreported: if entries not reported to the metadata server are kept
+ * @error: A #GError or NULL
+ *
+ * Removes old entries from the history database, and then returns the unused
+ * pages to the filesystem. Entries for pending updates are never removed.
+ *
+ * Returns: @TRUE if successful, @FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_prune (FuHistory *self,
+		  guint max_entries,
+		  guint64 max_age,
+		  gboolean keep_unreported,
+		  GError **error)
+{
+	gint rc;
+	gint changes;
+	gint64 modified_min = 0;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+
+	/* nothing to do */
+	if (max_entries == 0 && max_age == 0)
+		return TRUE;
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* remove entries */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	if (max_age > 0)
+		modified_min = (g_get_real_time () / G_USEC_PER_SEC) - MIN (max_age, G_MAXINT64 / 2);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "DELETE FROM history WHERE "
+				 "update_state NOT IN (?1, ?2) "
+				 "AND (?3 = 0 OR (flags & ?3) != 0) "
+				 "AND ((?4 > 0 AND device_modified < ?4) OR "
+				 "(?5 > 0 AND rowid NOT IN "
+				 "(SELECT rowid FROM history ORDER BY device_modified DESC LIMIT ?5)));",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to prune history: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_int (stmt, 1, FWUPD_UPDATE_STATE_PENDING);
+	sqlite3_bind_int (stmt, 2, FWUPD_UPDATE_STATE_NEEDS_REBOOT);
+	sqlite3_bind_int64 (stmt, 3, keep_unreported ? FWUPD_DEVICE_FLAG_REPORTED : 0);
+	sqlite3_bind_int64 (stmt, 4, modified_min);
+	sqlite3_bind_int (stmt, 5, MIN (max_entries, G_MAXINT));
+	if (!fu_history_stmt_exec (self, stmt, NULL, error))
+		return FALSE;
+	changes = sqlite3_changes (self->db);
+	if (changes == 0)
+		return TRUE;
+	g_debug ("pruned %i history entries", changes);
+
+	/* give back the free pages, which is cheap when there are few */
+	rc = sqlite3_exec (self->db, "PRAGMA incremental_vacuum;", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to vacuum: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * fu_history_remove_device:
  * @self: A #FuHistory
@@ -793,7 +1054,7 @@ gboolean
 fu_history_remove_device (FuHistory *self,  FuDevice *device, GError **error)
 {
 	gint rc;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
+	sqlite3_stmt *stmt = NULL;
 	g_autoptr(GRWLockWriterLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
@@ -808,9 +1069,9 @@ fu_history_remove_device (FuHistory *self,  FuDevice *device, GError **error)
 	g_debug ("remove device %s [%s]",
 		 fu_device_get_name (device),
 		 fu_device_get_id (device));
-	rc = sqlite3_prepare_v2 (self->db,
-				 "DELETE FROM history WHERE device_id = ?1;",
-				 -1, &stmt, NULL);
+	rc = fu_history_stmt_prepare_cached (self,
+					     "DELETE FROM history WHERE device_id = ?1;",
+					     &stmt);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
 			     "Failed to prepare SQL to delete history: %s",
@@ -891,23 +1152,32 @@ fu_history_get_device_by_id (FuHistory *self, const gchar *device_id, GError **e
 	return g_object_ref (g_ptr_array_index (array_tmp, 0));
 }
 /**
- * fu_history_get_devices:
+ * fu_history_get_devices_filtered:
  * @self: A #FuHistory
+ * @update_state: A #FwupdUpdateState, or %FWUPD_UPDATE_STATE_UNKNOWN for any
+ * @modified_since: only return devices modified after this UNIX time, or 0
+ * @limit: maximum number of devices to return, or 0 for no limit
  * @error: A #GError or NULL
  *
- * Gets the devices in the history database.
+ * Gets the devices in the history database, oldest first. Callers can page
+ * through the results by passing the modified time of the last device as
+ * @modified_since for the next call.
  *
  * Returns: (element-type #FuDevice) (transfer container): devices
  *
- * Since: 1.0.4
+ * Since: 1.5.8
  **/
 GPtrArray *
-fu_history_get_devices (FuHistory *self, GError **error)
+fu_history_get_devices_filtered (FuHistory *self,
+				 FwupdUpdateState update_state,
+				 guint64 modified_since,
+				 guint limit,
+				 GError **error)
 {
-	GPtrArray *array = NULL;
-	g_autoptr(sqlite3_stmt) stmt = NULL;
 	gint rc;
 	g_autoptr(GPtrArray) array_tmp = NULL;
+	g_autoptr(GString) sql = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
 	g_autoptr(GRWLockReaderLocker) locker = NULL;
 
 	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
@@ -918,39 +1188,66 @@ fu_history_get_devices (FuHistory *self, GError **error)
 			return NULL;
 	}
 
+	/* only the rows requested, using the indexes */
+	sql = g_string_new ("SELECT device_id, "
+				"checksum, "
+				"plugin, "
+				"device_created, "
+				"device_modified, "
+				"display_name, "
+				"filename, "
+				"flags, "
+				"metadata, "
+				"guid_default, "
+				"update_state, "
+				"update_error, "
+				"version_new, "
+				"version_old, "
+				"checksum_device, "
+				"protocol FROM history "
+				"WHERE (?1 = 0 OR update_state = ?1) "
+				"AND (?2 = 0 OR device_modified > ?2) "
+				"ORDER BY device_modified ASC");
+	if (limit > 0)
+		g_string_append (sql, " LIMIT ?3");
+	g_string_append (sql, ";");
+
 	/* get all the devices */
 	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
 	g_return_val_if_fail (locker != NULL, NULL);
-	rc = sqlite3_prepare_v2 (self->db,
-				 "SELECT device_id, "
-					"checksum, "
-					"plugin, "
-					"device_created, "
-					"device_modified, "
-					"display_name, "
-					"filename, "
-					"flags, "
-					"metadata, "
-					"guid_default, "
-					"update_state, "
-					"update_error, "
-					"version_new, "
-					"version_old, "
-					"checksum_device, "
-					"protocol FROM history "
-					"ORDER BY device_modified ASC;",
-					-1, &stmt, NULL);
+	rc = sqlite3_prepare_v2 (self->db, sql->str, -1, &stmt, NULL);
 	if (rc != SQLITE_OK) {
 		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
 			     "Failed to prepare SQL to get history: %s",
 			     sqlite3_errmsg (self->db));
 		return NULL;
 	}
+	sqlite3_bind_int (stmt, 1, update_state);
+	sqlite3_bind_int64 (stmt, 2, (sqlite3_int64) MIN (modified_since, G_MAXINT64));
+	if (limit > 0)
+		sqlite3_bind_int (stmt, 3, limit);
 	array_tmp = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	if (!fu_history_stmt_exec (self, stmt, array_tmp, error))
 		return NULL;
-	array = g_ptr_array_ref (array_tmp);
-	return array;
+	return g_steal_pointer (&array_tmp);
+}
+
+/**
+ * fu_history_get_devices:
+ * @self: A #FuHistory
+ * @error: A #GError or NULL
+ *
+ * Gets the devices in the history database.
+ *
+ * Returns: (element-type #FuDevice) (transfer container): devices
+ *
+ * Since: 1.0.4
+ **/
+GPtrArray *
+fu_history_get_devices (FuHistory *self, GError **error)
+{
+	return fu_history_get_devices_filtered (self, FWUPD_UPDATE_STATE_UNKNOWN,
+						0, 0, error);
 }
 
 /**
@@ -1222,6 +1519,527 @@ fu_history_add_blocked_firmware (FuHistory *self, const gchar *checksum, GError
 	return fu_history_stmt_exec (self, stmt, NULL, error);
 }
 
+/**
+ * fu_history_add_verify_result:
+ * @self: A #FuHistory
+ * @device_id: a device ID
+ * @checksum: (nullable): the device checksum that was tested
+ * @success: %TRUE if the checksum matched the metadata
+ * @error: A #GError or NULL
+ *
+ * Records the result of a background verification, replacing any previous
+ * result for the device.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_add_verify_result (FuHistory *self,
+			      const gchar *device_id,
+			      const gchar *checksum,
+			      gboolean success,
+			      GError **error)
+{
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* add or replace */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "INSERT OR REPLACE INTO verify (device_id,"
+				 "checksum,"
+				 "success,"
+				 "timestamp) "
+				 "VALUES (?1,?2,?3,?4)", -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to insert verify result: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 2, checksum, -1, SQLITE_STATIC);
+	sqlite3_bind_int (stmt, 3, success ? 1 : 0);
+	sqlite3_bind_int64 (stmt, 4, g_get_real_time () / G_USEC_PER_SEC);
+	return fu_history_stmt_exec (self, stmt, NULL, error);
+}
+
+/**
+ * fu_history_get_verify_result:
+ * @self: A #FuHistory
+ * @device_id: a device ID
+ * @timestamp: (out) (optional): UNIX time of the verification
+ * @success: (out) (optional): if the checksum matched the metadata
+ * @error: A #GError or NULL
+ *
+ * Gets the last background verification result for the device.
+ *
+ * Returns: #TRUE for success, #FALSE if not found or on failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_get_verify_result (FuHistory *self,
+			      const gchar *device_id,
+			      guint64 *timestamp,
+			      gboolean *success,
+			      GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+
+	/* lazy load */
+	if (self->db == NULL) {
+		if (!fu_history_load (self, error))
+			return FALSE;
+	}
+
+	/* get the result */
+	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "SELECT success, timestamp FROM verify "
+				 "WHERE device_id = ?1 LIMIT 1;",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to get verify result: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	rc = sqlite3_step (stmt);
+	if (rc == SQLITE_DONE) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND,
+			     "no verify result for %s", device_id);
+		return FALSE;
+	}
+	if (rc != SQLITE_ROW) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "failed to execute prepared statement: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	if (success != NULL)
+		*success = sqlite3_column_int (stmt, 0) != 0;
+	if (timestamp != NULL)
+		*timestamp = sqlite3_column_int64 (stmt, 1);
+	return TRUE;
+}
+
+/**
+ * fu_history_set_verify_cache:
+ * @self: A #FuHistory
+ * @device_id: a device ID
+ * @fingerprint: a string describing the device state
+ * @checksums: (element-type utf8): device checksums
+ * @error: A #GError or NULL
+ *
+ * Saves the checksums read back from the device so they can be reused while
+ * the device state is unchanged.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_set_verify_cache (FuHistory *self,
+			     const gchar *device_id,
+			     const gchar *fingerprint,
+			     GPtrArray *checksums,
+			     GError **error)
+{
+	gint rc;
+	g_autoptr(GString) str = g_string_new (NULL);
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+	g_return_val_if_fail (fingerprint != NULL, FALSE);
+	g_return_val_if_fail (checksums != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* add or replace */
+	for (guint i = 0; i < checksums->len; i++) {
+		const gchar *checksum = g_ptr_array_index (checksums, i);
+		if (str->len > 0)
+			g_string_append_c (str, ',');
+		g_string_append (str, checksum);
+	}
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "INSERT OR REPLACE INTO verify_cache (device_id,"
+				 "fingerprint,"
+				 "checksums) "
+				 "VALUES (?1,?2,?3)", -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to insert verify cache: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 2, fingerprint, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 3, str->str, -1, SQLITE_STATIC);
+	return fu_history_stmt_exec (self, stmt, NULL, error);
+}
+
+/**
+ * fu_history_get_verify_cache:
+ * @self: A #FuHistory
+ * @device_id: a device ID
+ * @fingerprint: a string describing the device state
+ * @error: A #GError or NULL
+ *
+ * Gets the checksums saved by fu_history_set_verify_cache(), if the device
+ * state is the same as when they were saved.
+ *
+ * Returns: (transfer container) (element-type utf8): checksums, or %NULL
+ *
+ * Since: 1.5.8
+ **/
+GPtrArray *
+fu_history_get_verify_cache (FuHistory *self,
+			     const gchar *device_id,
+			     const gchar *fingerprint,
+			     GError **error)
+{
+	gint rc;
+	const gchar *checksums_str;
+	g_autoptr(GPtrArray) checksums = NULL;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_auto(GStrv) split = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), NULL);
+	g_return_val_if_fail (device_id != NULL, NULL);
+	g_return_val_if_fail (fingerprint != NULL, NULL);
+
+	/* lazy load */
+	if (self->db == NULL) {
+		if (!fu_history_load (self, error))
+			return NULL;
+	}
+
+	/* get the checksums */
+	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, NULL);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "SELECT checksums FROM verify_cache "
+				 "WHERE device_id = ?1 AND fingerprint = ?2 LIMIT 1;",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to get verify cache: %s",
+			     sqlite3_errmsg (self->db));
+		return NULL;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text (stmt, 2, fingerprint, -1, SQLITE_STATIC);
+	rc = sqlite3_step (stmt);
+	if (rc == SQLITE_DONE) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND,
+			     "no cached checksums for %s", device_id);
+		return NULL;
+	}
+	if (rc != SQLITE_ROW) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "failed to execute prepared statement: %s",
+			     sqlite3_errmsg (self->db));
+		return NULL;
+	}
+	checksums_str = (const gchar *) sqlite3_column_text (stmt, 0);
+	if (checksums_str == NULL || checksums_str[0] == '\0') {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND,
+			     "no cached checksums for %s", device_id);
+		return NULL;
+	}
+	checksums = g_ptr_array_new_with_free_func (g_free);
+	split = g_strsplit (checksums_str, ",", -1);
+	for (guint i = 0; split[i] != NULL; i++)
+		g_ptr_array_add (checksums, g_strdup (split[i]));
+	return g_steal_pointer (&checksums);
+}
+
+/**
+ * fu_history_remove_verify_cache:
+ * @self: A #FuHistory
+ * @device_id: a device ID
+ * @error: A #GError or NULL
+ *
+ * Removes any checksums saved for the device, e.g. when it has been written.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_remove_verify_cache (FuHistory *self,
+				const gchar *device_id,
+				GError **error)
+{
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (device_id != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* remove entry */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "DELETE FROM verify_cache WHERE device_id = ?1;",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to delete verify cache: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, device_id, -1, SQLITE_STATIC);
+	return fu_history_stmt_exec (self, stmt, NULL, error);
+}
+
+/**
+ * fu_history_set_retry_delay:
+ * @self: A #FuHistory
+ * @guid: a device GUID, typically the default GUID for the model
+ * @delay: delay in ms
+ * @error: A #GError or NULL
+ *
+ * Saves the typical delay that allowed a device retry to succeed.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_set_retry_delay (FuHistory *self,
+			    const gchar *guid,
+			    guint delay,
+			    GError **error)
+{
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (guid != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	/* add or replace */
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "INSERT OR REPLACE INTO retry_delay (guid,"
+				 "delay) "
+				 "VALUES (?1,?2)", -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to insert retry delay: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, guid, -1, SQLITE_STATIC);
+	sqlite3_bind_int (stmt, 2, delay);
+	return fu_history_stmt_exec (self, stmt, NULL, error);
+}
+
+/**
+ * fu_history_get_retry_delay:
+ * @self: A #FuHistory
+ * @guid: a device GUID
+ * @delay: (out): delay in ms
+ * @error: A #GError or NULL
+ *
+ * Gets the delay saved by fu_history_set_retry_delay().
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_get_retry_delay (FuHistory *self,
+			    const gchar *guid,
+			    guint *delay,
+			    GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockReaderLocker) locker = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+	g_return_val_if_fail (guid != NULL, FALSE);
+
+	/* lazy load */
+	if (self->db == NULL) {
+		if (!fu_history_load (self, error))
+			return FALSE;
+	}
+
+	/* get the delay */
+	locker = g_rw_lock_reader_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	rc = sqlite3_prepare_v2 (self->db,
+				 "SELECT delay FROM retry_delay "
+				 "WHERE guid = ?1 LIMIT 1;",
+				 -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+			     "Failed to prepare SQL to get retry delay: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text (stmt, 1, guid, -1, SQLITE_STATIC);
+	rc = sqlite3_step (stmt);
+	if (rc == SQLITE_DONE) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND,
+			     "no retry delay for %s", guid);
+		return FALSE;
+	}
+	if (rc != SQLITE_ROW) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "failed to execute prepared statement: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	if (delay != NULL)
+		*delay = sqlite3_column_int (stmt, 0);
+	return TRUE;
+}
+
+/**
+ * fu_history_set_write_ahead_log:
+ * @self: A #FuHistory
+ * @write_ahead_log: %TRUE to use a write-ahead log
+ *
+ * Sets the database to use a write-ahead log, which means that writes do
+ * not have to wait for the database to be synced to disk each time.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_history_set_write_ahead_log (FuHistory *self, gboolean write_ahead_log)
+{
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_if_fail (FU_IS_HISTORY (self));
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_if_fail (locker != NULL);
+	self->write_ahead_log = write_ahead_log;
+
+	/* already loaded */
+	if (self->db != NULL && !fu_history_ensure_write_ahead_log (self, &error_local))
+		g_warning ("%s", error_local->message);
+}
+
+/**
+ * fu_history_transaction_begin:
+ * @self: A #FuHistory
+ * @error: A #GError or NULL
+ *
+ * Starts a transaction so that all the following writes are committed to
+ * the database at the same time. Transactions can be nested, and only the
+ * outermost fu_history_transaction_commit() writes to the database.
+ *
+ * Returns: @TRUE if successful, @FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_transaction_begin (FuHistory *self, GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+
+	/* lazy load */
+	if (!fu_history_load (self, error))
+		return FALSE;
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	if (self->transaction_depth++ > 0)
+		return TRUE;
+	rc = sqlite3_exec (self->db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		self->transaction_depth = 0;
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to begin transaction: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_history_transaction_commit:
+ * @self: A #FuHistory
+ * @error: A #GError or NULL
+ *
+ * Ends a transaction started with fu_history_transaction_begin().
+ *
+ * Returns: @TRUE if successful, @FALSE for failure
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_history_transaction_commit (FuHistory *self, GError **error)
+{
+	gint rc;
+	g_autoptr(GRWLockWriterLocker) locker = NULL;
+
+	g_return_val_if_fail (FU_IS_HISTORY (self), FALSE);
+
+	locker = g_rw_lock_writer_locker_new (&self->db_mutex);
+	g_return_val_if_fail (locker != NULL, FALSE);
+	if (self->transaction_depth == 0) {
+		g_set_error_literal (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL,
+				     "No transaction in progress");
+		return FALSE;
+	}
+	if (--self->transaction_depth > 0)
+		return TRUE;
+	rc = sqlite3_exec (self->db, "COMMIT TRANSACTION;", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error (error, FWUPD_ERROR, FWUPD_ERROR_WRITE,
+			     "Failed to commit transaction: %s",
+			     sqlite3_errmsg (self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 fu_history_class_init (FuHistoryClass *klass)
 {
@@ -1233,6 +2051,8 @@ static void
 fu_history_init (FuHistory *self)
 {
 	g_rw_lock_init (&self->db_mutex);
+	self->stmts = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     NULL, (GDestroyNotify) sqlite3_finalize);
 }
 
 static void
@@ -1242,6 +2062,8 @@ fu_history_finalize (GObject *object)
 
 	g_rw_lock_clear (&self->db_mutex);
 
+	/* statements have to be finalized before closing the database */
+	g_hash_table_unref (self->stmts);
 	if (self->db != NULL)
 		sqlite3_close (self->db);
 
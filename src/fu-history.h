@@ -34,11 +34,21 @@ gboolean	 fu_history_remove_all			(FuHistory	*self,
 gboolean	 fu_history_remove_all_with_state	(FuHistory	*self,
 							 FwupdUpdateState update_state,
 							 GError		**error);
+gboolean	 fu_history_prune			(FuHistory	*self,
+							 guint		 max_entries,
+							 guint64	 max_age,
+							 gboolean	 keep_unreported,
+							 GError		**error);
 FuDevice	*fu_history_get_device_by_id		(FuHistory	*self,
 							 const gchar	*device_id,
 							 GError		**error);
 GPtrArray	*fu_history_get_devices			(FuHistory	*self,
 							 GError		**error);
+GPtrArray	*fu_history_get_devices_filtered	(FuHistory	*self,
+							 FwupdUpdateState update_state,
+							 guint64	 modified_since,
+							 guint		 limit,
+							 GError		**error);
 
 gboolean	 fu_history_clear_approved_firmware	(FuHistory	*self,
 							 GError		**error);
@@ -54,3 +64,40 @@ gboolean	 fu_history_add_blocked_firmware	(FuHistory	*self,
 							 GError		**error);
 GPtrArray	*fu_history_get_blocked_firmware	(FuHistory	*self,
 							 GError		**error);
+gboolean	 fu_history_add_verify_result		(FuHistory	*self,
+							 const gchar	*device_id,
+							 const gchar	*checksum,
+							 gboolean	 success,
+							 GError		**error);
+gboolean	 fu_history_get_verify_result		(FuHistory	*self,
+							 const gchar	*device_id,
+							 guint64	*timestamp,
+							 gboolean	*success,
+							 GError		**error);
+gboolean	 fu_history_set_verify_cache		(FuHistory	*self,
+							 const gchar	*device_id,
+							 const gchar	*fingerprint,
+							 GPtrArray	*checksums,
+							 GError		**error);
+GPtrArray	*fu_history_get_verify_cache		(FuHistory	*self,
+							 const gchar	*device_id,
+							 const gchar	*fingerprint,
+							 GError		**error);
+gboolean	 fu_history_remove_verify_cache		(FuHistory	*self,
+							 const gchar	*device_id,
+							 GError		**error);
+gboolean	 fu_history_set_retry_delay		(FuHistory	*self,
+							 const gchar	*guid,
+							 guint		 delay,
+							 GError		**error);
+gboolean	 fu_history_get_retry_delay		(FuHistory	*self,
+							 const gchar	*guid,
+							 guint		*delay,
+							 GError		**error);
+
+void		 fu_history_set_write_ahead_log		(FuHistory	*self,
+							 gboolean	 write_ahead_log);
+gboolean	 fu_history_transaction_begin		(FuHistory	*self,
+							 GError		**error);
+gboolean	 fu_history_transaction_commit		(FuHistory	*self,
+							 GError		**error);
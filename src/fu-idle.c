@@ -22,6 +22,7 @@ struct _FuIdle
 	GRWLock			 items_mutex;
 	guint			 idle_id;
 	guint			 timeout;
+	gint64			 activity;	/* monotonic, us */
 	FwupdStatus		 status;
 };
 
@@ -110,6 +111,7 @@ void
 fu_idle_reset (FuIdle *self)
 {
 	g_return_if_fail (FU_IS_IDLE (self));
+	self->activity = g_get_monotonic_time ();
 	fu_idle_stop (self);
 	if (self->items->len == 0)
 		fu_idle_start (self);
@@ -154,6 +156,14 @@ fu_idle_inhibit (FuIdle *self, const gchar *reason)
 	return item->token;
 }
 
+/* seconds since the daemon was last used */
+guint
+fu_idle_get_idle_time (FuIdle *self)
+{
+	g_return_val_if_fail (FU_IS_IDLE (self), 0);
+	return (g_get_monotonic_time () - self->activity) / G_USEC_PER_SEC;
+}
+
 void
 fu_idle_set_timeout (FuIdle *self, guint timeout)
 {
@@ -212,6 +222,7 @@ static void
 fu_idle_init (FuIdle *self)
 {
 	self->status = FWUPD_STATUS_IDLE;
+	self->activity = g_get_monotonic_time ();
 	self->items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_idle_item_free);
 	g_rw_lock_init (&self->items_mutex);
 }
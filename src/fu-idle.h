@@ -23,6 +23,7 @@ void		 fu_idle_set_timeout		(FuIdle		*self,
 						 guint		 timeout);
 void		 fu_idle_reset			(FuIdle		*self);
 FwupdStatus	 fu_idle_get_status		(FuIdle		*self);
+guint		 fu_idle_get_idle_time		(FuIdle		*self);
 
 /**
  * FuIdleLocker:
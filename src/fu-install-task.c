@@ -21,6 +21,7 @@ struct _FuInstallTask
 	GObject			 parent_instance;
 	FuDevice		*device;
 	XbNode			*component;
+	GBytes			*blob_cab;	/* (nullable) */
 	FwupdReleaseFlags		 trust_flags;
 	gboolean		 is_downgrade;
 };
@@ -57,6 +58,38 @@ fu_install_task_get_component (FuInstallTask *self)
 	return self->component;
 }
 
+/**
+ * fu_install_task_get_blob_cab:
+ * @self: A #FuInstallTask
+ *
+ * Gets the cabinet archive the component was loaded from.
+ *
+ * Returns: (transfer none) (nullable): the archive, or %NULL if unset
+ **/
+GBytes *
+fu_install_task_get_blob_cab (FuInstallTask *self)
+{
+	g_return_val_if_fail (FU_IS_INSTALL_TASK (self), NULL);
+	return self->blob_cab;
+}
+
+/**
+ * fu_install_task_set_blob_cab:
+ * @self: A #FuInstallTask
+ * @blob_cab: (nullable): the cabinet archive
+ *
+ * Sets the cabinet archive the component was loaded from, which is required
+ * when tasks from different archives are installed at the same time.
+ **/
+void
+fu_install_task_set_blob_cab (FuInstallTask *self, GBytes *blob_cab)
+{
+	g_return_if_fail (FU_IS_INSTALL_TASK (self));
+	if (self->blob_cab != NULL)
+		g_bytes_unref (self->blob_cab);
+	self->blob_cab = blob_cab != NULL ? g_bytes_ref (blob_cab) : NULL;
+}
+
 /**
  * fu_install_task_get_trust_flags:
  * @self: A #FuInstallTask
@@ -467,6 +500,8 @@ fu_install_task_finalize (GObject *object)
 		g_object_unref (self->component);
 	if (self->device != NULL)
 		g_object_unref (self->device);
+	if (self->blob_cab != NULL)
+		g_bytes_unref (self->blob_cab);
 
 	G_OBJECT_CLASS (fu_install_task_parent_class)->finalize (object);
 }
@@ -23,6 +23,7 @@
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <glib/gstdio.h>
 #include <jcat.h>
 
 #include "fwupd-device-private.h"
@@ -57,24 +58,98 @@ typedef enum {
 
 typedef struct {
 	GDBusConnection		*connection;
+	GDBusServer		*peer_server;
+	gchar			*peer_socket_fn;
+	GPtrArray		*peer_connections;	/* of GDBusConnection */
+	guint			 peer_generation;
 	GDBusNodeInfo		*introspection_daemon;
 	GDBusProxy		*proxy_uid;
 	GMainLoop		*loop;
 	GFileMonitor		*argv0_monitor;
 	GHashTable		*sender_features;	/* sender:FwupdFeatureFlags */
+	GHashTable		*sender_request_ids;	/* sender:request-id */
 #if GLIB_CHECK_VERSION(2,63,3)
 	GMemoryMonitor		*memory_monitor;
 #endif
 #ifdef HAVE_POLKIT
 	PolkitAuthority		*authority;
+	GHashTable		*sender_auths;	/* sender:(action-id:expiry) */
 #endif
 	guint			 owner_id;
+	guint			 name_owner_changed_id;
+	guint			 coldplug_id;
 	FuEngine		*engine;
 	gboolean		 update_in_progress;
 	gboolean		 pending_sigterm;
 	FuMainMachineKind	 machine_kind;
+	guint64			 devices_generation;
+	guint64			 devices_generation_all;	/* all devices changed */
+	GHashTable		*devices_changed;	/* device-id:guint64 */
+	GHashTable		*devices_removed;	/* device-id:guint64 */
+	GHashTable		*devices_variant;	/* device-id:FuMainDeviceVariant */
+	guint			 percentage_id;
+	guint			 percentage_pending;
+	guint			 percentage_emitted;
+	gint64			 percentage_emitted_time;
+	guint			 metadata_generation;
 } FuMainPrivate;
 
+typedef struct {
+	guint64			 generation;
+	FwupdDeviceFlags	 flags;
+	GVariant		*value;
+} FuMainDeviceVariant;
+
+static void
+fu_main_device_variant_free (FuMainDeviceVariant *item)
+{
+	g_variant_unref (item->value);
+	g_free (item);
+}
+
+/* connections from the private socket have no bus name */
+static gboolean
+fu_main_connection_is_peer (GDBusConnection *connection)
+{
+	return g_object_get_data (G_OBJECT (connection), "fwupd-peer-name") != NULL;
+}
+
+static gboolean
+fu_main_has_listeners (FuMainPrivate *priv)
+{
+	return priv->connection != NULL || priv->peer_connections->len > 0;
+}
+
+/* send to the system bus and directly to each peer */
+static void
+fu_main_emit_signal (FuMainPrivate *priv,
+		     const gchar *interface_name,
+		     const gchar *signal_name,
+		     GVariant *parameters)
+{
+	g_autoptr(GVariant) params = NULL;
+
+	if (parameters != NULL)
+		params = g_variant_ref_sink (parameters);
+	if (priv->connection != NULL) {
+		g_dbus_connection_emit_signal (priv->connection,
+					       NULL,
+					       FWUPD_DBUS_PATH,
+					       interface_name,
+					       signal_name,
+					       params, NULL);
+	}
+	for (guint i = 0; i < priv->peer_connections->len; i++) {
+		GDBusConnection *connection = g_ptr_array_index (priv->peer_connections, i);
+		g_dbus_connection_emit_signal (connection,
+					       NULL,
+					       FWUPD_DBUS_PATH,
+					       interface_name,
+					       signal_name,
+					       params, NULL);
+	}
+}
+
 static gboolean
 fu_main_sigterm_cb (gpointer user_data)
 {
@@ -88,18 +163,92 @@ fu_main_sigterm_cb (gpointer user_data)
 	return G_SOURCE_CONTINUE;
 }
 
+/* record when the device was last added, changed or removed */
+static void
+fu_main_devices_generation_bump (FuMainPrivate *priv, FuDevice *device, gboolean removed)
+{
+	const gchar *device_id = fu_device_get_id (device);
+	guint64 *generation = g_new0 (guint64, 1);
+
+	*generation = ++priv->devices_generation;
+	g_hash_table_remove (priv->devices_variant, device_id);
+	if (removed) {
+		g_hash_table_remove (priv->devices_changed, device_id);
+		g_hash_table_insert (priv->devices_removed, g_strdup (device_id), generation);
+	} else {
+		g_hash_table_remove (priv->devices_removed, device_id);
+		g_hash_table_insert (priv->devices_changed, g_strdup (device_id), generation);
+	}
+}
+
+/* reuse the serialized device until it is next changed */
+static GVariant *
+fu_main_device_to_variant (FuMainPrivate *priv, FuDevice *device, FwupdDeviceFlags flags)
+{
+	const gchar *device_id = fu_device_get_id (device);
+	guint64 *generation = NULL;
+	FuMainDeviceVariant *item;
+
+	/* not tracked, e.g. from the previous daemon instance */
+	if (device_id != NULL)
+		generation = g_hash_table_lookup (priv->devices_changed, device_id);
+	if (generation == NULL)
+		return g_variant_ref_sink (fwupd_device_to_variant_full (FWUPD_DEVICE (device), flags));
+
+	/* not changed since it was last serialized */
+	item = g_hash_table_lookup (priv->devices_variant, device_id);
+	if (item != NULL &&
+	    item->flags == flags &&
+	    item->generation >= *generation &&
+	    item->generation >= priv->devices_generation_all)
+		return g_variant_ref (item->value);
+
+	item = g_new0 (FuMainDeviceVariant, 1);
+	item->generation = priv->devices_generation;
+	item->flags = flags;
+	item->value = g_variant_ref_sink (fwupd_device_to_variant_full (FWUPD_DEVICE (device), flags));
+	g_hash_table_insert (priv->devices_variant, g_strdup (device_id), item);
+	return g_variant_ref (item->value);
+}
+
+static void fu_main_emit_property_changed (FuMainPrivate *priv,
+					   const gchar *property_name,
+					   GVariant *property_value);
+
 static void
 fu_main_engine_changed_cb (FuEngine *engine, FuMainPrivate *priv)
 {
+	/* the metadata may have changed any of the devices */
+	priv->devices_generation_all = ++priv->devices_generation;
+
+	/* a new catalog is now being used */
+	if (priv->metadata_generation != fu_engine_get_metadata_generation (engine)) {
+		priv->metadata_generation = fu_engine_get_metadata_generation (engine);
+		fu_main_emit_property_changed (priv, "MetadataGeneration",
+					       g_variant_new_uint32 (priv->metadata_generation));
+	}
+
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "Changed",
-				       NULL, NULL);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "Changed", NULL);
+}
+
+static void
+fu_main_engine_security_changed_cb (FuEngine *engine,
+				    guint64 generation,
+				    FuMainPrivate *priv)
+{
+	fu_main_emit_property_changed (priv, "HostSecurityGeneration",
+				       g_variant_new_uint64 (generation));
+	fu_main_emit_property_changed (priv, "HostSecurityId",
+				       g_variant_new_string (fu_engine_get_host_security_id (engine)));
+
+	/* not yet connected */
+	if (!fu_main_has_listeners (priv))
+		return;
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "SecurityChanged",
+			     g_variant_new ("(t)", generation));
 }
 
 static void
@@ -107,18 +256,17 @@ fu_main_engine_device_added_cb (FuEngine *engine,
 				FuDevice *device,
 				FuMainPrivate *priv)
 {
-	GVariant *val;
+	g_autoptr(GVariant) val = NULL;
+
+	/* for GetDevicesSince */
+	fu_main_devices_generation_bump (priv, device, FALSE);
 
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceAdded",
-				       g_variant_new_tuple (&val, 1), NULL);
+	val = fu_main_device_to_variant (priv, device, FWUPD_DEVICE_FLAG_NONE);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceAdded",
+			     g_variant_new_tuple (&val, 1));
 }
 
 static void
@@ -128,16 +276,15 @@ fu_main_engine_device_removed_cb (FuEngine *engine,
 {
 	GVariant *val;
 
+	/* for GetDevicesSince */
+	fu_main_devices_generation_bump (priv, device, TRUE);
+
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
 	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceRemoved",
-				       g_variant_new_tuple (&val, 1), NULL);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceRemoved",
+			     g_variant_new_tuple (&val, 1));
 }
 
 static void
@@ -145,18 +292,17 @@ fu_main_engine_device_changed_cb (FuEngine *engine,
 				  FuDevice *device,
 				  FuMainPrivate *priv)
 {
-	GVariant *val;
+	g_autoptr(GVariant) val = NULL;
+
+	/* for GetDevicesSince */
+	fu_main_devices_generation_bump (priv, device, FALSE);
 
 	/* not yet connected */
-	if (priv->connection == NULL)
+	if (!fu_main_has_listeners (priv))
 		return;
-	val = fwupd_device_to_variant (FWUPD_DEVICE (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       FWUPD_DBUS_INTERFACE,
-				       "DeviceChanged",
-				       g_variant_new_tuple (&val, 1), NULL);
+	val = fu_main_device_to_variant (priv, device, FWUPD_DEVICE_FLAG_NONE);
+	fu_main_emit_signal (priv, FWUPD_DBUS_INTERFACE, "DeviceChanged",
+			     g_variant_new_tuple (&val, 1));
 }
 
 static void
@@ -168,7 +314,7 @@ fu_main_emit_property_changed (FuMainPrivate *priv,
 	GVariantBuilder invalidated_builder;
 
 	/* not yet connected */
-	if (priv->connection == NULL) {
+	if (!fu_main_has_listeners (priv)) {
 		g_variant_unref (g_variant_ref_sink (property_value));
 		return;
 	}
@@ -180,23 +326,57 @@ fu_main_emit_property_changed (FuMainPrivate *priv,
 			       "{sv}",
 			       property_name,
 			       property_value);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       FWUPD_DBUS_PATH,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       FWUPD_DBUS_INTERFACE,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
+	fu_main_emit_signal (priv,
+			     "org.freedesktop.DBus.Properties",
+			     "PropertiesChanged",
+			     g_variant_new ("(sa{sv}as)",
+					    FWUPD_DBUS_INTERFACE,
+					    &builder,
+					    &invalidated_builder));
 	g_variant_builder_clear (&builder);
 	g_variant_builder_clear (&invalidated_builder);
 }
 
+/* percentage changes arrive at the rate the device reports progress, and
+ * PropertiesChanged wakes every client on the bus */
+#define FU_MAIN_PERCENTAGE_INTERVAL	100	/* ms */
+
+static void
+fu_main_emit_percentage (FuMainPrivate *priv, guint percentage)
+{
+	if (priv->percentage_emitted == percentage)
+		return;
+	priv->percentage_emitted = percentage;
+	priv->percentage_emitted_time = g_get_monotonic_time ();
+	g_debug ("Emitting PropertyChanged('Percentage'='%u%%')", percentage);
+	fu_main_emit_property_changed (priv, "Percentage",
+				       g_variant_new_uint32 (percentage));
+}
+
+static void
+fu_main_flush_percentage (FuMainPrivate *priv)
+{
+	if (priv->percentage_id == 0)
+		return;
+	g_source_remove (priv->percentage_id);
+	priv->percentage_id = 0;
+	fu_main_emit_percentage (priv, priv->percentage_pending);
+}
+
+static gboolean
+fu_main_percentage_timeout_cb (gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	priv->percentage_id = 0;
+	fu_main_emit_percentage (priv, priv->percentage_pending);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_main_set_status (FuMainPrivate *priv, FwupdStatus status)
 {
+	/* clients should see the final percentage of the old status */
+	fu_main_flush_percentage (priv);
 	g_debug ("Emitting PropertyChanged('Status'='%s')",
 		 fwupd_status_to_string (status));
 	fu_main_emit_property_changed (priv, "Status",
@@ -220,16 +400,35 @@ fu_main_engine_percentage_changed_cb (FuEngine *engine,
 				      guint percentage,
 				      FuMainPrivate *priv)
 {
-	g_debug ("Emitting PropertyChanged('Percentage'='%u%%')", percentage);
-	fu_main_emit_property_changed (priv, "Percentage",
-				       g_variant_new_uint32 (percentage));
+	gint64 elapsed;
+
+	/* the start and the end are always sent straight away */
+	priv->percentage_pending = percentage;
+	elapsed = (g_get_monotonic_time () - priv->percentage_emitted_time) / 1000;
+	if (percentage == 0 || percentage == 100 ||
+	    elapsed >= FU_MAIN_PERCENTAGE_INTERVAL) {
+		fu_main_flush_percentage (priv);
+		fu_main_emit_percentage (priv, percentage);
+		return;
+	}
+
+	/* coalesce the rest, sending the latest value when the interval ends */
+	if (priv->percentage_id == 0) {
+		priv->percentage_id = g_timeout_add (FU_MAIN_PERCENTAGE_INTERVAL - elapsed,
+						     fu_main_percentage_timeout_cb,
+						     priv);
+	}
 }
 
 static FuEngineRequest *
-fu_main_create_request (FuMainPrivate *priv, const gchar *sender, GError **error)
+fu_main_create_request (FuMainPrivate *priv,
+			GDBusConnection *connection,
+			const gchar *sender,
+			GError **error)
 {
 	FwupdFeatureFlags *feature_flags;
 	FwupdDeviceFlags device_flags = FWUPD_DEVICE_FLAG_NONE;
+	const gchar *request_id;
 	uid_t calling_uid = 0;
 	g_autoptr(FuEngineRequest) request = fu_engine_request_new ();
 	g_autoptr(GVariant) value = NULL;
@@ -241,19 +440,33 @@ fu_main_create_request (FuMainPrivate *priv, const gchar *sender, GError **error
 	if (feature_flags != NULL)
 		fu_engine_request_set_feature_flags (request, *feature_flags);
 
+	/* did the client want to trace this request */
+	request_id = g_hash_table_lookup (priv->sender_request_ids, sender);
+	if (request_id != NULL)
+		fu_engine_request_set_id (request, request_id);
+
 	/* are we root and therefore trusted? */
-	value = g_dbus_proxy_call_sync (priv->proxy_uid,
-					"GetConnectionUnixUser",
-					g_variant_new ("(s)", sender),
-					G_DBUS_CALL_FLAGS_NONE,
-					2000,
-					NULL,
-					error);
-	if (value == NULL) {
-		g_prefix_error (error, "failed to read user id of caller: ");
-		return NULL;
+	if (fu_main_connection_is_peer (connection)) {
+		GCredentials *credentials = g_dbus_connection_get_peer_credentials (connection);
+		calling_uid = g_credentials_get_unix_user (credentials, error);
+		if (calling_uid == (uid_t) -1) {
+			g_prefix_error (error, "failed to read user id of caller: ");
+			return NULL;
+		}
+	} else {
+		value = g_dbus_proxy_call_sync (priv->proxy_uid,
+						"GetConnectionUnixUser",
+						g_variant_new ("(s)", sender),
+						G_DBUS_CALL_FLAGS_NONE,
+						2000,
+						NULL,
+						error);
+		if (value == NULL) {
+			g_prefix_error (error, "failed to read user id of caller: ");
+			return NULL;
+		}
+		g_variant_get (value, "(u)", &calling_uid);
 	}
-	g_variant_get (value, "(u)", &calling_uid);
 	if (calling_uid == 0)
 		device_flags |= FWUPD_DEVICE_FLAG_TRUSTED;
 	fu_engine_request_set_device_flags (request, device_flags);
@@ -273,13 +486,64 @@ fu_main_device_array_to_variant (FuMainPrivate *priv, FuEngineRequest *request,
 
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index (devices, i);
-		GVariant *tmp = fwupd_device_to_variant_full (FWUPD_DEVICE (device),
-							      fu_engine_request_get_device_flags (request));
+		g_autoptr(GVariant) tmp = NULL;
+		tmp = fu_main_device_to_variant (priv, device,
+						 fu_engine_request_get_device_flags (request));
 		g_variant_builder_add_value (&builder, tmp);
 	}
 	return g_variant_new ("(aa{sv})", &builder);
 }
 
+static GVariant *
+fu_main_device_array_to_variant_since (FuMainPrivate *priv,
+				       FuEngineRequest *request,
+				       guint64 generation)
+{
+	GHashTableIter iter;
+	GVariantBuilder builder_devices;
+	GVariantBuilder builder_removed;
+	gboolean complete;
+	gpointer key, value;
+	g_autoptr(GPtrArray) devices = NULL;
+
+	/* a client that has never synced, or is from a previous daemon
+	 * instance, or has missed a metadata change needs everything */
+	complete = generation == 0 ||
+		   generation > priv->devices_generation ||
+		   generation < priv->devices_generation_all;
+
+	/* devices added or changed since the generation */
+	g_variant_builder_init (&builder_devices, G_VARIANT_TYPE ("aa{sv}"));
+	devices = fu_engine_get_devices (priv->engine, NULL);
+	for (guint i = 0; devices != NULL && i < devices->len; i++) {
+		FuDevice *device = g_ptr_array_index (devices, i);
+		guint64 *generation_tmp = g_hash_table_lookup (priv->devices_changed,
+							       fu_device_get_id (device));
+		g_autoptr(GVariant) tmp = NULL;
+		if (!complete && generation_tmp != NULL && *generation_tmp <= generation)
+			continue;
+		tmp = fu_main_device_to_variant (priv, device,
+						 fu_engine_request_get_device_flags (request));
+		g_variant_builder_add_value (&builder_devices, tmp);
+	}
+
+	/* devices removed since the generation */
+	g_variant_builder_init (&builder_removed, G_VARIANT_TYPE ("as"));
+	if (!complete) {
+		g_hash_table_iter_init (&iter, priv->devices_removed);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			guint64 *generation_tmp = (guint64 *) value;
+			if (*generation_tmp > generation)
+				g_variant_builder_add (&builder_removed, "s", (const gchar *) key);
+		}
+	}
+	return g_variant_new ("(tbaa{sv}as)",
+			      priv->devices_generation,
+			      complete,
+			      &builder_devices,
+			      &builder_removed);
+}
+
 static GVariant *
 fu_main_plugin_array_to_variant (GPtrArray *plugins)
 {
@@ -348,26 +612,32 @@ typedef struct {
 	GPtrArray		*action_ids;
 	GPtrArray		*checksums;
 	guint64			 flags;
-	GBytes			*blob_cab;
+	GPtrArray		*blob_cabs;	/* (element-type GBytes) */
+	GPtrArray		*device_ids;	/* (element-type utf8), one for each blob */
 	FuMainPrivate		*priv;
 	gchar			*device_id;
 	gchar			*remote_id;
 	gchar			*key;
 	gchar			*value;
-	XbSilo			*silo;
+	GPtrArray		*silos;		/* (element-type XbSilo) */
+	GPtrArray		*results;	/* (element-type FwupdDevice) */
 } FuMainAuthHelper;
 
 static void
 fu_main_auth_helper_free (FuMainAuthHelper *helper)
 {
-	if (helper->blob_cab != NULL)
-		g_bytes_unref (helper->blob_cab);
+	if (helper->blob_cabs != NULL)
+		g_ptr_array_unref (helper->blob_cabs);
+	if (helper->device_ids != NULL)
+		g_ptr_array_unref (helper->device_ids);
 #ifdef HAVE_POLKIT
 	if (helper->subject != NULL)
 		g_object_unref (helper->subject);
 #endif
-	if (helper->silo != NULL)
-		g_object_unref (helper->silo);
+	if (helper->silos != NULL)
+		g_ptr_array_unref (helper->silos);
+	if (helper->results != NULL)
+		g_ptr_array_unref (helper->results);
 	if (helper->request != NULL)
 		g_object_unref (helper->request);
 	if (helper->install_tasks != NULL)
@@ -417,6 +687,161 @@ fu_main_authorization_is_valid (PolkitAuthorizationResult *auth, GError **error)
 	/* success */
 	return TRUE;
 }
+
+/* how long polkit results are reused for the same client */
+#define FU_MAIN_AUTH_CACHE_TIMEOUT	30	/* s */
+
+static PolkitSubject *
+fu_main_authorization_subject_new (GDBusConnection *connection, const gchar *sender)
+{
+	PolkitSubject *subject;
+
+	/* the kernel told us who is on the other end of the socket */
+	if (fu_main_connection_is_peer (connection)) {
+		GCredentials *credentials = g_dbus_connection_get_peer_credentials (connection);
+		subject = polkit_unix_process_new_for_owner (g_credentials_get_unix_pid (credentials, NULL),
+							     0,
+							     g_credentials_get_unix_user (credentials, NULL));
+	} else {
+		subject = polkit_system_bus_name_new (sender);
+	}
+	g_object_set_data_full (G_OBJECT (subject), "fwupd-sender",
+				g_strdup (sender), g_free);
+	return subject;
+}
+
+static const gchar *
+fu_main_authorization_get_sender (PolkitSubject *subject)
+{
+	return g_object_get_data (G_OBJECT (subject), "fwupd-sender");
+}
+
+static gboolean
+fu_main_authorization_cache_lookup (FuMainPrivate *priv,
+				    const gchar *sender,
+				    const gchar *action_id)
+{
+	GHashTable *auths = g_hash_table_lookup (priv->sender_auths, sender);
+	gint64 *expiry;
+
+	if (auths == NULL)
+		return FALSE;
+	expiry = g_hash_table_lookup (auths, action_id);
+	if (expiry == NULL)
+		return FALSE;
+	if (*expiry < g_get_monotonic_time ()) {
+		g_hash_table_remove (auths, action_id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+fu_main_authorization_cache_add (FuMainPrivate *priv,
+				 const gchar *sender,
+				 const gchar *action_id)
+{
+	GHashTable *auths = g_hash_table_lookup (priv->sender_auths, sender);
+	gint64 *expiry = g_new0 (gint64, 1);
+
+	if (auths == NULL) {
+		auths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		g_hash_table_insert (priv->sender_auths, g_strdup (sender), auths);
+	}
+	*expiry = g_get_monotonic_time () + FU_MAIN_AUTH_CACHE_TIMEOUT * G_USEC_PER_SEC;
+	g_hash_table_insert (auths, g_strdup (action_id), expiry);
+}
+
+typedef struct {
+	FuMainPrivate		*priv;
+	PolkitSubject		*subject;
+	gchar			*action_id;
+	gboolean		 interactive;
+} FuMainAuthCheckHelper;
+
+static void
+fu_main_auth_check_helper_free (FuMainAuthCheckHelper *helper)
+{
+	g_object_unref (helper->subject);
+	g_free (helper->action_id);
+	g_free (helper);
+}
+
+static void
+fu_main_authorization_check_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	FuMainAuthCheckHelper *helper = g_task_get_task_data (task);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(PolkitAuthorizationResult) auth = NULL;
+
+	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
+							    res, &error);
+
+	/* ask again, this time allowing the user to authenticate */
+	if (auth != NULL && !helper->interactive &&
+	    polkit_authorization_result_get_is_challenge (auth)) {
+		helper->interactive = TRUE;
+		polkit_authority_check_authorization (helper->priv->authority,
+						      helper->subject,
+						      helper->action_id, NULL,
+						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
+						      NULL,
+						      fu_main_authorization_check_cb,
+						      g_steal_pointer (&task));
+		return;
+	}
+	if (!fu_main_authorization_is_valid (auth, &error)) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return;
+	}
+
+	/* only remember what polkit would grant again without asking */
+	if (!helper->interactive ||
+	    polkit_authorization_result_get_retains_authorization (auth)) {
+		fu_main_authorization_cache_add (helper->priv,
+						 fu_main_authorization_get_sender (helper->subject),
+						 helper->action_id);
+	}
+	g_task_return_boolean (task, TRUE);
+}
+
+/* checks without user interaction first, so that only the results the user
+ * did not have to authenticate for are cached */
+static void
+fu_main_authorization_check_async (FuMainPrivate *priv,
+				   PolkitSubject *subject,
+				   const gchar *action_id,
+				   GAsyncReadyCallback callback,
+				   gpointer user_data)
+{
+	FuMainAuthCheckHelper *helper;
+	const gchar *sender = fu_main_authorization_get_sender (subject);
+	g_autoptr(GTask) task = g_task_new (NULL, NULL, callback, user_data);
+
+	if (fu_main_authorization_cache_lookup (priv, sender, action_id)) {
+		g_debug ("using cached authorization of %s for %s", action_id, sender);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+	helper = g_new0 (FuMainAuthCheckHelper, 1);
+	helper->priv = priv;
+	helper->subject = g_object_ref (subject);
+	helper->action_id = g_strdup (action_id);
+	g_task_set_task_data (task, helper, (GDestroyNotify) fu_main_auth_check_helper_free);
+	polkit_authority_check_authorization (priv->authority, subject,
+					      action_id, NULL,
+					      POLKIT_CHECK_AUTHORIZATION_FLAGS_NONE,
+					      NULL,
+					      fu_main_authorization_check_cb,
+					      g_steal_pointer (&task));
+}
+
+static gboolean
+fu_main_authorization_check_finish (GAsyncResult *res, GError **error)
+{
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
 #else
 static gboolean
 fu_main_authorization_is_trusted (FuEngineRequest *request, GError **error)
@@ -433,19 +858,131 @@ fu_main_authorization_is_trusted (FuEngineRequest *request, GError **error)
 }
 #endif /* HAVE_POLKIT */
 
+static void
+fu_main_engine_job_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!fu_engine_run_job_finish (FU_ENGINE (source), res, &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	/* success */
+	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+}
+
+static void
+fu_main_update_metadata_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!fu_engine_update_metadata_finish (FU_ENGINE (source), res, &error)) {
+		g_prefix_error (&error, "Failed to update metadata for %s: ", helper->remote_id);
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	/* success */
+	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+}
+
+static void
+fu_main_update_metadata_batch_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!fu_engine_update_metadata_batch_finish (FU_ENGINE (source), res, &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	/* success */
+	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+}
+
+static gboolean
+fu_main_unlock_job_cb (FuEngine *engine, const gchar *device_id,
+		       gpointer user_data, GError **error)
+{
+	return fu_engine_unlock (engine, device_id, error);
+}
+
+static gboolean
+fu_main_activate_job_cb (FuEngine *engine, const gchar *device_id,
+			 gpointer user_data, GError **error)
+{
+	return fu_engine_activate (engine, device_id, error);
+}
+
+static gboolean
+fu_main_verify_job_cb (FuEngine *engine, const gchar *device_id,
+		       gpointer user_data, GError **error)
+{
+	return fu_engine_verify (engine, device_id, FWUPD_INSTALL_FLAG_NONE, error);
+}
+
+/* stream each result to clients as soon as it is known */
+static void
+fu_main_verify_all_device_cb (FuEngine *engine,
+			      FuDevice *device,
+			      const GError *error,
+			      gpointer user_data)
+{
+	FuMainAuthHelper *helper = (FuMainAuthHelper *) user_data;
+	GVariant *val;
+	g_autoptr(FwupdDevice) result = fwupd_device_new ();
+
+	fwupd_device_set_id (result, fu_device_get_id (device));
+	fwupd_device_set_name (result, fu_device_get_name (device));
+	fwupd_device_set_version (result, fu_device_get_version (device));
+	if (error != NULL) {
+		fwupd_device_set_update_state (result, FWUPD_UPDATE_STATE_FAILED);
+		fwupd_device_set_update_error (result, error->message);
+	} else {
+		fwupd_device_set_update_state (result, FWUPD_UPDATE_STATE_SUCCESS);
+	}
+	val = fwupd_device_to_variant (result);
+	fu_main_emit_signal (helper->priv, FWUPD_DBUS_INTERFACE, "DeviceVerified",
+			     g_variant_new_tuple (&val, 1));
+	g_ptr_array_add (helper->results, g_steal_pointer (&result));
+}
+
+static void
+fu_main_verify_all_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!fu_engine_verify_all_finish (FU_ENGINE (source), res, &error)) {
+		g_dbus_method_invocation_return_gerror (helper->invocation, error);
+		return;
+	}
+
+	/* success */
+	g_dbus_method_invocation_return_value (helper->invocation,
+					       fu_main_result_array_to_variant (helper->results));
+}
+
+static gboolean
+fu_main_verify_update_job_cb (FuEngine *engine, const gchar *device_id,
+			      gpointer user_data, GError **error)
+{
+	return fu_engine_verify_update (engine, device_id, FWUPD_INSTALL_FLAG_NONE, error);
+}
+
 static void
 fu_main_authorize_unlock_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -457,13 +994,10 @@ fu_main_authorize_unlock_cb (GObject *source, GAsyncResult *res, gpointer user_d
 #endif /* HAVE_POLKIT */
 
 	/* authenticated */
-	if (!fu_engine_unlock (helper->priv->engine, helper->device_id, &error)) {
-		g_dbus_method_invocation_return_gerror (helper->invocation, error);
-		return;
-	}
-
-	/* success */
-	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+	fu_engine_run_job_async (helper->priv->engine, helper->device_id,
+				 fu_main_unlock_job_cb, NULL,
+				 fu_main_engine_job_cb, helper);
+	helper = NULL;	/* owned by fu_main_engine_job_cb() */
 }
 
 static void
@@ -472,13 +1006,9 @@ fu_main_authorize_set_approved_firmware_cb (GObject *source, GAsyncResult *res,
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -503,13 +1033,9 @@ fu_main_authorize_set_blocked_firmware_cb (GObject *source, GAsyncResult *res, g
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -535,13 +1061,9 @@ fu_main_authorize_self_sign_cb (GObject *source, GAsyncResult *res, gpointer use
 	g_autofree gchar *sig = NULL;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -569,12 +1091,8 @@ fu_main_modify_config_cb (GObject *source, GAsyncResult *res, gpointer user_data
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -598,28 +1116,22 @@ static void
 fu_main_authorize_activate_cb (GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
-	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
+	g_autoptr(GError) error = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
 #endif /* HAVE_POLKIT */
 
 	/* authenticated */
-	if (!fu_engine_activate (helper->priv->engine, helper->device_id, &error)) {
-		g_dbus_method_invocation_return_gerror (helper->invocation, error);
-		return;
-	}
-
-	/* success */
-	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+	fu_engine_run_job_async (helper->priv->engine, helper->device_id,
+				 fu_main_activate_job_cb, NULL,
+				 fu_main_engine_job_cb, helper);
+	helper = NULL;	/* owned by fu_main_engine_job_cb() */
 }
 
 static void
@@ -628,13 +1140,9 @@ fu_main_authorize_verify_update_cb (GObject *source, GAsyncResult *res, gpointer
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -646,13 +1154,10 @@ fu_main_authorize_verify_update_cb (GObject *source, GAsyncResult *res, gpointer
 #endif /* HAVE_POLKIT */
 
 	/* authenticated */
-	if (!fu_engine_verify_update (helper->priv->engine, helper->device_id, &error)) {
-		g_dbus_method_invocation_return_gerror (helper->invocation, error);
-		return;
-	}
-
-	/* success */
-	g_dbus_method_invocation_return_value (helper->invocation, NULL);
+	fu_engine_run_job_async (helper->priv->engine, helper->device_id,
+				 fu_main_verify_update_job_cb, NULL,
+				 fu_main_engine_job_cb, helper);
+	helper = NULL;	/* owned by fu_main_engine_job_cb() */
 }
 
 static void
@@ -661,13 +1166,9 @@ fu_main_authorize_modify_remote_cb (GObject *source, GAsyncResult *res, gpointer
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
 #ifdef HAVE_POLKIT
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
-
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -700,13 +1201,10 @@ fu_main_authorize_install_cb (GObject *source, GAsyncResult *res, gpointer user_
 {
 	g_autoptr(FuMainAuthHelper) helper = (FuMainAuthHelper *) user_data;
 	g_autoptr(GError) error = NULL;
-	g_autoptr(PolkitAuthorizationResult) auth = NULL;
 
 	/* get result */
 	fu_main_set_status (helper->priv, FWUPD_STATUS_IDLE);
-	auth = polkit_authority_check_authorization_finish (POLKIT_AUTHORITY (source),
-							    res, &error);
-	if (!fu_main_authorization_is_valid (auth, &error)) {
+	if (!fu_main_authorization_check_finish (res, &error)) {
 		g_dbus_method_invocation_return_gerror (helper->invocation, error);
 		return;
 	}
@@ -725,17 +1223,24 @@ fu_main_authorize_install_queue (FuMainAuthHelper *helper_ref)
 	gboolean ret;
 
 #ifdef HAVE_POLKIT
+	/* skip the action IDs that have recently been authorized */
+	for (guint i = helper->action_ids->len; i > 0; i--) {
+		const gchar *action_id = g_ptr_array_index (helper->action_ids, i - 1);
+		if (fu_main_authorization_cache_lookup (priv,
+							fu_main_authorization_get_sender (helper->subject),
+							action_id))
+			g_ptr_array_remove_index (helper->action_ids, i - 1);
+	}
+
 	/* still more things to to authenticate */
 	if (helper->action_ids->len > 0) {
 		g_autofree gchar *action_id = g_strdup (g_ptr_array_index (helper->action_ids, 0));
 		g_autoptr(PolkitSubject) subject = g_object_ref (helper->subject);
 		g_ptr_array_remove_index (helper->action_ids, 0);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      action_id, NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_install_cb,
-						      g_steal_pointer (&helper));
+		fu_main_authorization_check_async (priv, subject,
+						   action_id,
+						   fu_main_authorize_install_cb,
+						   g_steal_pointer (&helper));
 		return;
 	}
 #endif /* HAVE_POLKIT */
@@ -745,7 +1250,7 @@ fu_main_authorize_install_queue (FuMainAuthHelper *helper_ref)
 	ret = fu_engine_install_tasks (helper->priv->engine,
 				       helper->request,
 				       helper->install_tasks,
-				       helper->blob_cab,
+				       NULL,
 				       helper->flags,
 				       &error);
 	priv->update_in_progress = FALSE;
@@ -786,7 +1291,7 @@ fu_main_install_task_sort_cb (gconstpointer a, gconstpointer b)
 }
 
 static GPtrArray *
-fu_main_get_device_family (FuMainAuthHelper *helper, GError **error)
+fu_main_get_device_family (FuMainAuthHelper *helper, const gchar *device_id, GError **error)
 {
 	FuDevice *parent;
 	GPtrArray *children;
@@ -794,7 +1299,7 @@ fu_main_get_device_family (FuMainAuthHelper *helper, GError **error)
 	g_autoptr(GPtrArray) devices_possible = NULL;
 
 	/* get the device */
-	device = fu_engine_get_device (helper->priv->engine, helper->device_id, error);
+	device = fu_engine_get_device (helper->priv->engine, device_id, error);
 	if (device == NULL)
 		return NULL;
 
@@ -826,42 +1331,43 @@ fu_main_get_device_family (FuMainAuthHelper *helper, GError **error)
 	return g_steal_pointer (&devices_possible);
 }
 
+/* adds the install tasks for the components in one archive */
 static gboolean
-fu_main_install_with_helper (FuMainAuthHelper *helper_ref, GError **error)
+fu_main_install_add_tasks (FuMainAuthHelper *helper,
+			   const gchar *device_id,
+			   GBytes *blob_cab,
+			   GPtrArray *errors,
+			   GError **error)
 {
-	FuMainPrivate *priv = helper_ref->priv;
-	g_autoptr(FuMainAuthHelper) helper = helper_ref;
+	FuMainPrivate *priv = helper->priv;
+	guint tasks_other = helper->install_tasks->len;
 	g_autoptr(GPtrArray) components = NULL;
 	g_autoptr(GPtrArray) devices_possible = NULL;
-	g_autoptr(GPtrArray) errors = NULL;
+	g_autoptr(XbSilo) silo = NULL;
 
 	/* get a list of devices that in some way match the device_id */
-	if (g_strcmp0 (helper->device_id, FWUPD_DEVICE_ID_ANY) == 0) {
+	if (g_strcmp0 (device_id, FWUPD_DEVICE_ID_ANY) == 0) {
 		devices_possible = fu_engine_get_devices (priv->engine, error);
 		if (devices_possible == NULL)
 			return FALSE;
 	} else {
-		devices_possible = fu_main_get_device_family (helper, error);
+		devices_possible = fu_main_get_device_family (helper, device_id, error);
 		if (devices_possible == NULL)
 			return FALSE;
 	}
 
 	/* parse silo */
-	helper->silo = fu_engine_get_silo_from_blob (priv->engine,
-						     helper->blob_cab,
-						     error);
-	if (helper->silo == NULL)
+	silo = fu_engine_get_silo_from_blob (priv->engine, blob_cab, error);
+	if (silo == NULL)
 		return FALSE;
+	g_ptr_array_add (helper->silos, g_object_ref (silo));
 
 	/* for each component in the silo */
-	components = xb_silo_query (helper->silo,
+	components = xb_silo_query (silo,
 				    "components/component[@type='firmware']",
 				    0, error);
 	if (components == NULL)
 		return FALSE;
-	helper->action_ids = g_ptr_array_new_with_free_func (g_free);
-	helper->install_tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	errors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_error_free);
 	for (guint i = 0; i < components->len; i++) {
 		XbNode *component = g_ptr_array_index (components, i);
 
@@ -910,6 +1416,19 @@ fu_main_install_with_helper (FuMainAuthHelper *helper_ref, GError **error)
 				continue;
 			}
 
+			/* the same device cannot be updated by two archives */
+			for (guint k = 0; k < tasks_other; k++) {
+				FuInstallTask *task_tmp = g_ptr_array_index (helper->install_tasks, k);
+				if (fu_install_task_get_device (task_tmp) == device) {
+					g_set_error (error,
+						     FWUPD_ERROR,
+						     FWUPD_ERROR_INVALID_FILE,
+						     "%s is updated by more than one archive",
+						     fu_device_get_id (device));
+					return FALSE;
+				}
+			}
+
 			/* if component should have an update message from CAB */
 			fu_device_incorporate_from_component (device, component);
 
@@ -917,10 +1436,36 @@ fu_main_install_with_helper (FuMainAuthHelper *helper_ref, GError **error)
 			action_id = fu_install_task_get_action_id (task);
 			if (!g_ptr_array_find (helper->action_ids, action_id, NULL))
 				g_ptr_array_add (helper->action_ids, g_strdup (action_id));
+			fu_install_task_set_blob_cab (task, blob_cab);
 			g_ptr_array_add (helper->install_tasks, g_steal_pointer (&task));
 		}
 	}
 
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_main_install_with_helper (FuMainAuthHelper *helper_ref, GError **error)
+{
+	FuMainPrivate *priv = helper_ref->priv;
+	g_autoptr(FuMainAuthHelper) helper = helper_ref;
+	g_autoptr(GPtrArray) errors = NULL;
+
+	/* the action IDs are shared by all the archives so that each is only
+	 * authorized once */
+	helper->silos = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	helper->action_ids = g_ptr_array_new_with_free_func (g_free);
+	helper->install_tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	errors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_error_free);
+	for (guint i = 0; i < helper->blob_cabs->len; i++) {
+		if (!fu_main_install_add_tasks (helper,
+						g_ptr_array_index (helper->device_ids, i),
+						g_ptr_array_index (helper->blob_cabs, i),
+						errors, error))
+			return FALSE;
+	}
+
 	/* order the install tasks by the device priority */
 	g_ptr_array_sort (helper->install_tasks, fu_main_install_task_sort_cb);
 
@@ -937,6 +1482,44 @@ fu_main_install_with_helper (FuMainAuthHelper *helper_ref, GError **error)
 	return TRUE;
 }
 
+/* the options are shared by Install and InstallBatch */
+static guint64
+fu_main_get_install_flags (GVariantIter *iter)
+{
+	GVariant *prop_value;
+	gchar *prop_key;
+	guint64 flags = FWUPD_INSTALL_FLAG_NONE;
+
+	while (g_variant_iter_next (iter, "{&sv}", &prop_key, &prop_value)) {
+		g_debug ("got option %s", prop_key);
+		if (g_strcmp0 (prop_key, "offline") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_OFFLINE;
+		if (g_strcmp0 (prop_key, "allow-older") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_ALLOW_OLDER;
+		if (g_strcmp0 (prop_key, "allow-reinstall") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_ALLOW_REINSTALL;
+		if (g_strcmp0 (prop_key, "allow-branch-switch") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH;
+		if (g_strcmp0 (prop_key, "force") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE) {
+			flags |= FWUPD_INSTALL_FLAG_FORCE;
+			flags |= FWUPD_INSTALL_FLAG_IGNORE_POWER;
+		}
+		if (g_strcmp0 (prop_key, "ignore-power") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_IGNORE_POWER;
+		if (g_strcmp0 (prop_key, "no-history") == 0 &&
+		    g_variant_get_boolean (prop_value) == TRUE)
+			flags |= FWUPD_INSTALL_FLAG_NO_HISTORY;
+		g_variant_unref (prop_value);
+	}
+	return flags;
+}
+
 static gboolean
 fu_main_device_id_valid (const gchar *device_id, GError **error)
 {
@@ -952,6 +1535,30 @@ fu_main_device_id_valid (const gchar *device_id, GError **error)
 	return FALSE;
 }
 
+typedef struct {
+	FuMetrics		*metrics;
+	gchar			*method_name;
+	gchar			*request_id;
+	gint64			 start;		/* monotonic */
+} FuMainMethodHelper;
+
+/* the invocation is finalized once the reply has been sent */
+static void
+fu_main_method_finalized_cb (gpointer user_data, GObject *where_the_object_was)
+{
+	FuMainMethodHelper *helper = (FuMainMethodHelper *) user_data;
+	gint64 elapsed = g_get_monotonic_time () - helper->start;
+	g_debug ("request %s: %s replied after %.1fms",
+		 helper->request_id, helper->method_name, (gdouble) elapsed / 1000.f);
+	fu_metrics_observe (helper->metrics, "fwupd_dbus_method_duration_seconds",
+			    helper->method_name, (gdouble) elapsed / G_USEC_PER_SEC,
+			    helper->request_id);
+	g_object_unref (helper->metrics);
+	g_free (helper->method_name);
+	g_free (helper->request_id);
+	g_free (helper);
+}
+
 static void
 fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			    const gchar *object_path, const gchar *interface_name,
@@ -960,15 +1567,30 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 {
 	FuMainPrivate *priv = (FuMainPrivate *) user_data;
 	GVariant *val = NULL;
+	FuMainMethodHelper *helper;
 	g_autoptr(FuEngineRequest) request = NULL;
 	g_autoptr(GError) error = NULL;
 
+	/* a private connection has no bus name */
+	if (sender == NULL)
+		sender = g_object_get_data (G_OBJECT (connection), "fwupd-peer-name");
+
 	/* build request */
-	request = fu_main_create_request (priv, sender, &error);
+	request = fu_main_create_request (priv, connection, sender, &error);
 	if (request == NULL) {
 		g_dbus_method_invocation_return_gerror (invocation, error);
 		return;
 	}
+	g_debug ("request %s: %s from %s",
+		 fu_engine_request_get_id (request), method_name, sender);
+
+	/* time until the reply, even when finished asynchronously */
+	helper = g_new0 (FuMainMethodHelper, 1);
+	helper->metrics = g_object_ref (fu_engine_get_metrics (priv->engine));
+	helper->method_name = g_strdup (method_name);
+	helper->request_id = g_strdup (fu_engine_request_get_id (request));
+	helper->start = g_get_monotonic_time ();
+	g_object_weak_ref (G_OBJECT (invocation), fu_main_method_finalized_cb, helper);
 
 	/* activity */
 	fu_engine_idle_reset (priv->engine);
@@ -976,17 +1598,38 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 	if (g_strcmp0 (method_name, "GetDevices") == 0) {
 		g_autoptr(GPtrArray) devices = NULL;
 		g_debug ("Called %s()", method_name);
-		devices = fu_engine_get_devices (priv->engine, &error);
-		if (devices == NULL) {
-			g_dbus_method_invocation_return_gerror (invocation, error);
-			return;
-		}
-		val = fu_main_device_array_to_variant (priv, request, devices, &error);
-		if (val == NULL) {
+		devices = fu_engine_get_devices_cached (priv->engine);
+		if (devices == NULL)
+			devices = fu_engine_get_devices (priv->engine, &error);
+		if (devices == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		val = fu_main_device_array_to_variant (priv, request, devices, &error);
+		if (val == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetDevicesSince") == 0) {
+		guint64 generation = 0;
+		g_variant_get (parameters, "(t)", &generation);
+		g_debug ("Called %s(%" G_GUINT64_FORMAT ")", method_name, generation);
+		val = fu_main_device_array_to_variant_since (priv, request, generation);
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
+	if (g_strcmp0 (method_name, "GetMetrics") == 0) {
+		g_autofree gchar *str = NULL;
+		g_debug ("Called %s()", method_name);
+		str = fu_engine_get_metrics_string (priv->engine, &error);
+		if (str == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
-		g_dbus_method_invocation_return_value (invocation, val);
+		g_dbus_method_invocation_return_value (invocation, g_variant_new ("(s)", str));
 		return;
 	}
 	if (g_strcmp0 (method_name, "GetPlugins") == 0) {
@@ -1086,14 +1729,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		for (guint i = 0; checksums[i] != NULL; i++)
 			g_ptr_array_add (helper->checksums, g_strdup (checksums[i]));
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.set-approved-firmware",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_set_approved_firmware_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.set-approved-firmware",
+						   fu_main_authorize_set_approved_firmware_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_set_approved_firmware_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1120,14 +1760,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		for (guint i = 0; checksums[i] != NULL; i++)
 			g_ptr_array_add (helper->checksums, g_strdup (checksums[i]));
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.set-approved-firmware",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_set_blocked_firmware_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.set-approved-firmware",
+						   fu_main_authorize_set_blocked_firmware_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_set_blocked_firmware_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1166,14 +1803,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->request = g_steal_pointer (&request);
 		helper->invocation = g_object_ref (invocation);
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.self-sign",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_self_sign_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.self-sign",
+						   fu_main_authorize_self_sign_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_self_sign_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1215,6 +1849,57 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		g_dbus_method_invocation_return_value (invocation, val);
 		return;
 	}
+	if (g_strcmp0 (method_name, "GetUpgradesAll") == 0) {
+		g_autoptr(GPtrArray) devices = NULL;
+		g_autoptr(GPtrArray) results = NULL;
+		g_debug ("Called %s()", method_name);
+		devices = fu_engine_get_devices (priv->engine, &error);
+		if (devices == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		for (guint i = 0; i < devices->len; i++) {
+			FuDevice *device = g_ptr_array_index (devices, i);
+			g_autoptr(FwupdDevice) result = NULL;
+			g_autoptr(GError) error_local = NULL;
+			g_autoptr(GPtrArray) releases = NULL;
+			if (!fu_device_has_flag (device, FWUPD_DEVICE_FLAG_UPDATABLE))
+				continue;
+			releases = fu_engine_get_upgrades (priv->engine, request,
+							   fu_device_get_id (device),
+							   &error_local);
+			if (releases == NULL) {
+				g_debug ("no upgrades for %s: %s",
+					 fu_device_get_id (device),
+					 error_local->message);
+				continue;
+			}
+
+			/* do not modify the device owned by the engine */
+			result = fwupd_device_new ();
+			fwupd_device_incorporate (result, FWUPD_DEVICE (device));
+			for (guint j = 0; j < releases->len; j++) {
+				FwupdRelease *rel = g_ptr_array_index (releases, j);
+				fwupd_device_add_release (result, rel);
+			}
+			g_ptr_array_add (results, g_steal_pointer (&result));
+		}
+		if (results->len == 0) {
+			g_dbus_method_invocation_return_error_literal (invocation,
+								       FWUPD_ERROR,
+								       FWUPD_ERROR_NOTHING_TO_DO,
+								       "No upgrades for any device");
+			return;
+		}
+		val = fu_main_device_array_to_variant (priv, request, results, &error);
+		if (val == NULL) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, val);
+		return;
+	}
 	if (g_strcmp0 (method_name, "GetRemotes") == 0) {
 		g_autoptr(GPtrArray) remotes = NULL;
 		g_debug ("Called %s()", method_name);
@@ -1244,7 +1929,7 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		return;
 	}
 	if (g_strcmp0 (method_name, "GetHostSecurityAttrs") == 0) {
-		g_autoptr(FuSecurityAttrs) attrs = NULL;
+		g_autoptr(GVariant) attrs = NULL;
 		g_debug ("Called %s()", method_name);
 		if (priv->machine_kind != FU_MAIN_MACHINE_KIND_PHYSICAL) {
 			g_dbus_method_invocation_return_error_literal (invocation,
@@ -1253,9 +1938,15 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 								       "HSI unavailable for hypervisor");
 			return;
 		}
-		attrs = fu_engine_get_host_security_attrs (priv->engine);
-		val = fu_security_attrs_to_variant (attrs);
-		g_dbus_method_invocation_return_value (invocation, val);
+		attrs = fu_engine_get_host_security_variant (priv->engine);
+		if (attrs == NULL) {
+			g_dbus_method_invocation_return_error_literal (invocation,
+								       FWUPD_ERROR,
+								       FWUPD_ERROR_NOTHING_TO_DO,
+								       "no security attributes");
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, attrs);
 		return;
 	}
 	if (g_strcmp0 (method_name, "ClearResults") == 0) {
@@ -1309,6 +2000,7 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		const gchar *remote_id = NULL;
 		gint fd_data;
 		gint fd_sig;
+		FuMainAuthHelper *helper;
 
 		g_variant_get (parameters, "(&shh)", &remote_id, &fd_data, &fd_sig);
 		g_debug ("Called %s(%s,%i,%i)", method_name, remote_id, fd_data, fd_sig);
@@ -1335,14 +2027,72 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			return;
 		}
 
-		/* store new metadata (will close the fds when done) */
-		if (!fu_engine_update_metadata (priv->engine, remote_id,
-						fd_data, fd_sig, &error)) {
-			g_prefix_error (&error, "Failed to update metadata for %s: ", remote_id);
+		/* store new metadata (will close the fds when done), returning
+		 * once the new silo is being used */
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->priv = priv;
+		helper->invocation = g_object_ref (invocation);
+		helper->remote_id = g_strdup (remote_id);
+		fu_engine_update_metadata_async (priv->engine, remote_id,
+						 fd_data, fd_sig, NULL,
+						 fu_main_update_metadata_cb, helper);
+		return;
+	}
+	if (g_strcmp0 (method_name, "UpdateMetadataBatch") == 0) {
+		GDBusMessage *message;
+		GUnixFDList *fd_list;
+		const gchar *remote_id = NULL;
+		gint32 fd_data_idx;
+		gint32 fd_sig_idx;
+		FuMainAuthHelper *helper;
+		g_autoptr(GArray) fds = g_array_new (FALSE, FALSE, sizeof(gint));
+		g_autoptr(GPtrArray) remote_ids = g_ptr_array_new_with_free_func (g_free);
+		g_autoptr(GVariantIter) iter = NULL;
+
+		g_variant_get (parameters, "(a(shh))", &iter);
+		g_debug ("Called %s(%" G_GSIZE_FORMAT ")", method_name,
+			 g_variant_iter_n_children (iter));
+		message = g_dbus_method_invocation_get_message (invocation);
+		fd_list = g_dbus_message_get_unix_fd_list (message);
+		if (fd_list == NULL) {
+			g_set_error (&error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "invalid handle");
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+
+		/* the engine closes the fds when done, so close them here on error */
+		while (g_variant_iter_next (iter, "(&shh)", &remote_id, &fd_data_idx, &fd_sig_idx)) {
+			gint fd_data = g_unix_fd_list_get (fd_list, fd_data_idx, &error);
+			gint fd_sig;
+			if (fd_data < 0)
+				break;
+			fd_sig = g_unix_fd_list_get (fd_list, fd_sig_idx, &error);
+			if (fd_sig < 0) {
+				g_close (fd_data, NULL);
+				break;
+			}
+			g_array_append_val (fds, fd_data);
+			g_array_append_val (fds, fd_sig);
+			g_ptr_array_add (remote_ids, g_strdup (remote_id));
+		}
+		if (error != NULL) {
+			for (guint i = 0; i < fds->len; i++)
+				g_close (g_array_index (fds, gint, i), NULL);
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
-		g_dbus_method_invocation_return_value (invocation, NULL);
+
+		/* store all the new metadata, returning once the new silos are
+		 * being used */
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->priv = priv;
+		helper->invocation = g_object_ref (invocation);
+		fu_engine_update_metadata_batch_async (priv->engine, remote_ids, fds, NULL,
+						       fu_main_update_metadata_batch_cb,
+						       helper);
 		return;
 	}
 	if (g_strcmp0 (method_name, "Unlock") == 0) {
@@ -1366,14 +2116,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->invocation = g_object_ref (invocation);
 		helper->device_id = g_strdup (device_id);
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.device-unlock",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_unlock_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.device-unlock",
+						   fu_main_authorize_unlock_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_unlock_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1400,14 +2147,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->invocation = g_object_ref (invocation);
 		helper->device_id = g_strdup (device_id);
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.device-activate",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_activate_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.device-activate",
+						   fu_main_authorize_activate_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_activate_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1431,14 +2175,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper->request = g_steal_pointer (&request);
 		helper->invocation = g_object_ref (invocation);
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.modify-config",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_modify_config_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.modify-config",
+						   fu_main_modify_config_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_modify_config_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1468,14 +2209,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		/* authenticate */
 		fu_main_set_status (priv, FWUPD_STATUS_WAITING_FOR_AUTH);
 #ifdef HAVE_POLKIT
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.modify-remote",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_modify_remote_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.modify-remote",
+						   fu_main_authorize_modify_remote_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_modify_remote_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1506,14 +2244,11 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		/* authenticate */
 #ifdef HAVE_POLKIT
 		fu_main_set_status (priv, FWUPD_STATUS_WAITING_FOR_AUTH);
-		subject = polkit_system_bus_name_new (sender);
-		polkit_authority_check_authorization (priv->authority, subject,
-						      "org.freedesktop.fwupd.verify-update",
-						      NULL,
-						      POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
-						      NULL,
-						      fu_main_authorize_verify_update_cb,
-						      g_steal_pointer (&helper));
+		subject = fu_main_authorization_subject_new (connection, sender);
+		fu_main_authorization_check_async (priv, subject,
+						   "org.freedesktop.fwupd.verify-update",
+						   fu_main_authorize_verify_update_cb,
+						   g_steal_pointer (&helper));
 #else
 		fu_main_authorize_verify_update_cb (NULL, NULL, g_steal_pointer (&helper));
 #endif /* HAVE_POLKIT */
@@ -1521,17 +2256,31 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 	}
 	if (g_strcmp0 (method_name, "Verify") == 0) {
 		const gchar *device_id = NULL;
+		FuMainAuthHelper *helper;
 		g_variant_get (parameters, "(&s)", &device_id);
 		g_debug ("Called %s(%s)", method_name, device_id);
 		if (!fu_main_device_id_valid (device_id, &error)) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
-		if (!fu_engine_verify (priv->engine, device_id, &error)) {
-			g_dbus_method_invocation_return_gerror (invocation, error);
-			return;
-		}
-		g_dbus_method_invocation_return_value (invocation, NULL);
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->priv = priv;
+		helper->invocation = g_object_ref (invocation);
+		fu_engine_run_job_async (priv->engine, device_id,
+					 fu_main_verify_job_cb, NULL,
+					 fu_main_engine_job_cb, helper);
+		return;
+	}
+	if (g_strcmp0 (method_name, "VerifyAll") == 0) {
+		FuMainAuthHelper *helper;
+		g_debug ("Called %s()", method_name);
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->priv = priv;
+		helper->invocation = g_object_ref (invocation);
+		helper->results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		fu_engine_verify_all_async (priv->engine, FWUPD_INSTALL_FLAG_NONE,
+					    fu_main_verify_all_device_cb, helper,
+					    fu_main_verify_all_cb, helper);
 		return;
 	}
 	if (g_strcmp0 (method_name, "SetFeatureFlags") == 0) {
@@ -1548,13 +2297,28 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		g_dbus_method_invocation_return_value (invocation, NULL);
 		return;
 	}
+	if (g_strcmp0 (method_name, "SetRequestId") == 0) {
+		const gchar *request_id = NULL;
+		g_variant_get (parameters, "(&s)", &request_id);
+		g_debug ("Called %s(%s)", method_name, request_id);
+
+		/* an empty string goes back to the daemon-assigned IDs */
+		if (request_id[0] == '\0') {
+			g_hash_table_remove (priv->sender_request_ids, sender);
+		} else {
+			g_hash_table_insert (priv->sender_request_ids,
+					     g_strdup (sender),
+					     g_strdup (request_id));
+		}
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
 	if (g_strcmp0 (method_name, "Install") == 0) {
-		GVariant *prop_value;
 		const gchar *device_id = NULL;
-		gchar *prop_key;
 		gint32 fd_handle = 0;
 		gint fd;
 		guint64 archive_size_max;
+		GBytes *blob_cab;
 		GDBusMessage *message;
 		GUnixFDList *fd_list;
 		g_autoptr(FuMainAuthHelper) helper = NULL;
@@ -1572,38 +2336,12 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		helper = g_new0 (FuMainAuthHelper, 1);
 		helper->request = g_steal_pointer (&request);
 		helper->invocation = g_object_ref (invocation);
-		helper->device_id = g_strdup (device_id);
 		helper->priv = priv;
+		helper->blob_cabs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+		helper->device_ids = g_ptr_array_new_with_free_func (g_free);
 
 		/* get flags */
-		while (g_variant_iter_next (iter, "{&sv}", &prop_key, &prop_value)) {
-			g_debug ("got option %s", prop_key);
-			if (g_strcmp0 (prop_key, "offline") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_OFFLINE;
-			if (g_strcmp0 (prop_key, "allow-older") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_ALLOW_OLDER;
-			if (g_strcmp0 (prop_key, "allow-reinstall") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_ALLOW_REINSTALL;
-			if (g_strcmp0 (prop_key, "allow-branch-switch") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH;
-			if (g_strcmp0 (prop_key, "force") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE) {
-				helper->flags |= FWUPD_INSTALL_FLAG_FORCE;
-				helper->flags |= FWUPD_INSTALL_FLAG_IGNORE_POWER;
-			}
-			if (g_strcmp0 (prop_key, "ignore-power") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_IGNORE_POWER;
-			if (g_strcmp0 (prop_key, "no-history") == 0 &&
-			    g_variant_get_boolean (prop_value) == TRUE)
-				helper->flags |= FWUPD_INSTALL_FLAG_NO_HISTORY;
-			g_variant_unref (prop_value);
-		}
-
+		helper->flags = fu_main_get_install_flags (iter);
 
 		/* get the fd */
 		message = g_dbus_method_invocation_get_message (invocation);
@@ -1626,15 +2364,96 @@ fu_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		 * what action ID to use, for instance, if this is trusted --
 		 * this will also close the fd when done */
 		archive_size_max = fu_engine_get_archive_size_max (priv->engine);
-		helper->blob_cab = fu_common_get_contents_fd (fd, archive_size_max, &error);
-		if (helper->blob_cab == NULL) {
+		blob_cab = fu_common_get_contents_fd (fd, archive_size_max, &error);
+		if (blob_cab == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
+		g_ptr_array_add (helper->blob_cabs, blob_cab);
+		g_ptr_array_add (helper->device_ids, g_strdup (device_id));
 
 		/* install all the things in the store */
 #ifdef HAVE_POLKIT
-		helper->subject = polkit_system_bus_name_new (sender);
+		helper->subject = fu_main_authorization_subject_new (connection, sender);
+#endif /* HAVE_POLKIT */
+		if (!fu_main_install_with_helper (g_steal_pointer (&helper), &error)) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+
+		/* async return */
+		return;
+	}
+	if (g_strcmp0 (method_name, "InstallBatch") == 0) {
+		const gchar *device_id = NULL;
+		gint32 fd_handle = 0;
+		guint64 archive_size_max;
+		GDBusMessage *message;
+		GUnixFDList *fd_list;
+		g_autoptr(FuMainAuthHelper) helper = NULL;
+		g_autoptr(GVariantIter) iter = NULL;
+		g_autoptr(GVariantIter) iter_items = NULL;
+
+		/* create helper object */
+		g_variant_get (parameters, "(a(sh)a{sv})", &iter_items, &iter);
+		g_debug ("Called %s(%" G_GSIZE_FORMAT ")",
+			 method_name, g_variant_iter_n_children (iter_items));
+		helper = g_new0 (FuMainAuthHelper, 1);
+		helper->request = g_steal_pointer (&request);
+		helper->invocation = g_object_ref (invocation);
+		helper->priv = priv;
+		helper->blob_cabs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+		helper->device_ids = g_ptr_array_new_with_free_func (g_free);
+		helper->flags = fu_main_get_install_flags (iter);
+
+		/* read all the archives before authenticating once for all of them;
+		 * each fd is closed when done */
+		message = g_dbus_method_invocation_get_message (invocation);
+		fd_list = g_dbus_message_get_unix_fd_list (message);
+		archive_size_max = fu_engine_get_archive_size_max (priv->engine);
+		while (g_variant_iter_next (iter_items, "(&sh)", &device_id, &fd_handle)) {
+			GBytes *blob_cab;
+			gint fd;
+			if (!fu_main_device_id_valid (device_id, &error)) {
+				g_dbus_method_invocation_return_gerror (invocation, error);
+				return;
+			}
+			if (fd_list == NULL ||
+			    fd_handle < 0 ||
+			    fd_handle >= g_unix_fd_list_get_length (fd_list)) {
+				g_set_error (&error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INTERNAL,
+					     "invalid handle %i",
+					     fd_handle);
+				g_dbus_method_invocation_return_gerror (invocation, error);
+				return;
+			}
+			fd = g_unix_fd_list_get (fd_list, fd_handle, &error);
+			if (fd < 0) {
+				g_dbus_method_invocation_return_gerror (invocation, error);
+				return;
+			}
+			blob_cab = fu_common_get_contents_fd (fd, archive_size_max, &error);
+			if (blob_cab == NULL) {
+				g_dbus_method_invocation_return_gerror (invocation, error);
+				return;
+			}
+			g_ptr_array_add (helper->blob_cabs, blob_cab);
+			g_ptr_array_add (helper->device_ids, g_strdup (device_id));
+		}
+		if (helper->blob_cabs->len == 0) {
+			g_set_error_literal (&error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "no archives");
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+
+		/* install all the things in all the stores */
+#ifdef HAVE_POLKIT
+		helper->subject = fu_main_authorization_subject_new (connection, sender);
 #endif /* HAVE_POLKIT */
 		if (!fu_main_install_with_helper (g_steal_pointer (&helper), &error)) {
 			g_dbus_method_invocation_return_gerror (invocation, error);
@@ -1706,6 +2525,9 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	if (g_strcmp0 (property_name, "Tainted") == 0)
 		return g_variant_new_boolean (fu_engine_get_tainted (priv->engine));
 
+	if (g_strcmp0 (property_name, "MetadataGeneration") == 0)
+		return g_variant_new_uint32 (fu_engine_get_metadata_generation (priv->engine));
+
 	if (g_strcmp0 (property_name, "Status") == 0)
 		return g_variant_new_uint32 (fu_engine_get_status (priv->engine));
 
@@ -1718,9 +2540,18 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	if (g_strcmp0 (property_name, "HostSecurityId") == 0)
 		return g_variant_new_string (fu_engine_get_host_security_id (priv->engine));
 
+	if (g_strcmp0 (property_name, "HostSecurityGeneration") == 0)
+		return g_variant_new_uint64 (fu_engine_get_host_security_generation (priv->engine));
+
 	if (g_strcmp0 (property_name, "Interactive") == 0)
 		return g_variant_new_boolean (isatty (fileno (stdout)) != 0);
 
+	if (g_strcmp0 (property_name, "StartupProfile") == 0)
+		return fu_profile_to_variant (fu_engine_get_profile (priv->engine));
+
+	if (g_strcmp0 (property_name, "HotplugLatency") == 0)
+		return fu_engine_get_hotplug_latency (priv->engine);
+
 	/* return an error */
 	g_set_error (error,
 		     G_DBUS_ERROR,
@@ -1730,6 +2561,52 @@ fu_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 	return NULL;
 }
 
+/* forget everything about clients that have gone away */
+static void
+fu_main_sender_forget (FuMainPrivate *priv, const gchar *sender)
+{
+	g_hash_table_remove (priv->sender_features, sender);
+	g_hash_table_remove (priv->sender_request_ids, sender);
+#ifdef HAVE_POLKIT
+	g_hash_table_remove (priv->sender_auths, sender);
+#endif
+}
+
+static void
+fu_main_name_owner_changed_cb (GDBusConnection *connection,
+			       const gchar *sender_name,
+			       const gchar *object_path,
+			       const gchar *interface_name,
+			       const gchar *signal_name,
+			       GVariant *parameters,
+			       gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	const gchar *name = NULL;
+	const gchar *old_owner = NULL;
+	const gchar *new_owner = NULL;
+
+	g_variant_get (parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+	if (new_owner[0] != '\0')
+		return;
+	fu_main_sender_forget (priv, name);
+}
+
+#ifdef HAVE_POLKIT
+static void
+fu_main_authority_changed_cb (PolkitAuthority *authority, FuMainPrivate *priv)
+{
+	g_debug ("polkit authority changed, dropping cached authorizations");
+	g_hash_table_remove_all (priv->sender_auths);
+}
+#endif
+
+static const GDBusInterfaceVTable fu_main_interface_vtable = {
+	fu_main_daemon_method_call,
+	fu_main_daemon_get_property,
+	NULL
+};
+
 static void
 fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 			    const gchar *name,
@@ -1738,17 +2615,22 @@ fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 	FuMainPrivate *priv = (FuMainPrivate *) user_data;
 	guint registration_id;
 	g_autoptr(GError) error = NULL;
-	static const GDBusInterfaceVTable interface_vtable = {
-		fu_main_daemon_method_call,
-		fu_main_daemon_get_property,
-		NULL
-	};
 
 	priv->connection = g_object_ref (connection);
+	priv->name_owner_changed_id =
+		g_dbus_connection_signal_subscribe (connection,
+						    "org.freedesktop.DBus",
+						    "org.freedesktop.DBus",
+						    "NameOwnerChanged",
+						    "/org/freedesktop/DBus",
+						    NULL,
+						    G_DBUS_SIGNAL_FLAGS_NONE,
+						    fu_main_name_owner_changed_cb,
+						    priv, NULL);
 	registration_id = g_dbus_connection_register_object (connection,
 							     FWUPD_DBUS_PATH,
 							     priv->introspection_daemon->interfaces[0],
-							     &interface_vtable,
+							     &fu_main_interface_vtable,
 							     priv,  /* user_data */
 							     NULL,  /* user_data_free_func */
 							     NULL); /* GError** */
@@ -1771,12 +2653,35 @@ fu_main_on_bus_acquired_cb (GDBusConnection *connection,
 	}
 }
 
+static gboolean
+fu_main_coldplug_cb (gpointer user_data)
+{
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	priv->coldplug_id = 0;
+	if (!fu_engine_coldplug (priv->engine, &error)) {
+		g_printerr ("Failed to coldplug engine: %s\n", error->message);
+		g_main_loop_quit (priv->loop);
+	}
+	return G_SOURCE_REMOVE;
+}
+
 static void
 fu_main_on_name_acquired_cb (GDBusConnection *connection,
 			     const gchar *name,
 			     gpointer user_data)
 {
+	FuMainPrivate *priv = (FuMainPrivate *) user_data;
 	g_debug ("acquired name: %s", name);
+
+	/* enumerate devices once any requests queued by the bus activation
+	 * have been answered using the device cache */
+	if (priv->coldplug_id == 0) {
+		priv->coldplug_id = g_idle_add_full (G_PRIORITY_LOW,
+						     fu_main_coldplug_cb,
+						     priv, NULL);
+	}
 }
 
 static void
@@ -1789,6 +2694,117 @@ fu_main_on_name_lost_cb (GDBusConnection *connection,
 	g_main_loop_quit (priv->loop);
 }
 
+/* only SO_PEERCRED, so that polkit knows the process for each request */
+static gboolean
+fu_main_peer_allow_mechanism_cb (GDBusAuthObserver *observer,
+				 const gchar *mechanism,
+				 gpointer user_data)
+{
+	return g_strcmp0 (mechanism, "EXTERNAL") == 0;
+}
+
+static gboolean
+fu_main_peer_authorize_cb (GDBusAuthObserver *observer,
+			   GIOStream *stream,
+			   GCredentials *credentials,
+			   gpointer user_data)
+{
+	if (credentials == NULL ||
+	    g_credentials_get_unix_pid (credentials, NULL) <= 0 ||
+	    g_credentials_get_unix_user (credentials, NULL) == (uid_t) -1) {
+		g_debug ("refusing peer without credentials");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+fu_main_peer_closed_cb (GDBusConnection *connection,
+			gboolean remote_peer_vanished,
+			GError *error,
+			FuMainPrivate *priv)
+{
+	const gchar *sender = g_object_get_data (G_OBJECT (connection), "fwupd-peer-name");
+	g_debug ("peer %s disconnected", sender);
+	fu_main_sender_forget (priv, sender);
+	g_ptr_array_remove (priv->peer_connections, connection);
+}
+
+static gboolean
+fu_main_peer_new_connection_cb (GDBusServer *server,
+				GDBusConnection *connection,
+				FuMainPrivate *priv)
+{
+	GCredentials *credentials = g_dbus_connection_get_peer_credentials (connection);
+	guint registration_id;
+	g_autofree gchar *sender = g_strdup_printf ("peer-%u", ++priv->peer_generation);
+	g_autoptr(GError) error = NULL;
+
+	registration_id = g_dbus_connection_register_object (connection,
+							     FWUPD_DBUS_PATH,
+							     priv->introspection_daemon->interfaces[0],
+							     &fu_main_interface_vtable,
+							     priv,  /* user_data */
+							     NULL,  /* user_data_free_func */
+							     &error);
+	if (registration_id == 0) {
+		g_warning ("failed to register peer object: %s", error->message);
+		return FALSE;
+	}
+	g_debug ("peer %s connected from pid %i",
+		 sender, (gint) g_credentials_get_unix_pid (credentials, NULL));
+	g_object_set_data_full (G_OBJECT (connection), "fwupd-peer-name",
+				g_steal_pointer (&sender), g_free);
+	g_signal_connect (connection, "closed",
+			  G_CALLBACK (fu_main_peer_closed_cb), priv);
+	g_ptr_array_add (priv->peer_connections, g_object_ref (connection));
+	return TRUE;
+}
+
+static gboolean
+fu_main_peer_server_start (FuMainPrivate *priv, GError **error)
+{
+	const gchar *socket_fn = g_getenv ("FWUPD_DBUS_SOCKET");
+	g_autofree gchar *address = NULL;
+	g_autofree gchar *guid = g_dbus_generate_guid ();
+	g_autoptr(GDBusAuthObserver) observer = g_dbus_auth_observer_new ();
+
+	/* left behind by a previous instance */
+	if (socket_fn == NULL)
+		socket_fn = FWUPD_DBUS_P2P_SOCKET_PATH;
+	g_unlink (socket_fn);
+
+	address = g_strdup_printf ("unix:path=%s", socket_fn);
+	g_signal_connect (observer, "allow-mechanism",
+			  G_CALLBACK (fu_main_peer_allow_mechanism_cb), priv);
+	g_signal_connect (observer, "authorize-authenticated-peer",
+			  G_CALLBACK (fu_main_peer_authorize_cb), priv);
+	priv->peer_server = g_dbus_server_new_sync (address,
+						    G_DBUS_SERVER_FLAGS_NONE,
+						    guid,
+						    observer,
+						    NULL,
+						    error);
+	if (priv->peer_server == NULL)
+		return FALSE;
+	priv->peer_socket_fn = g_strdup (socket_fn);
+	g_signal_connect (priv->peer_server, "new-connection",
+			  G_CALLBACK (fu_main_peer_new_connection_cb), priv);
+	g_dbus_server_start (priv->peer_server);
+
+	/* anyone can connect to the system bus too, and polkit decides the rest */
+	if (g_chmod (socket_fn, 0666) != 0) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_FAILED,
+			     "failed to set permissions on %s",
+			     socket_fn);
+		return FALSE;
+	}
+	g_debug ("listening for peers on %s", address);
+	return TRUE;
+}
+
 static gboolean
 fu_main_timed_exit_cb (gpointer user_data)
 {
@@ -1876,19 +2892,42 @@ static void
 fu_main_private_free (FuMainPrivate *priv)
 {
 	g_hash_table_unref (priv->sender_features);
+	g_hash_table_unref (priv->sender_request_ids);
+	g_hash_table_unref (priv->devices_changed);
+	g_hash_table_unref (priv->devices_removed);
+	g_hash_table_unref (priv->devices_variant);
 	if (priv->loop != NULL)
 		g_main_loop_unref (priv->loop);
 	if (priv->owner_id > 0)
 		g_bus_unown_name (priv->owner_id);
+	if (priv->coldplug_id != 0)
+		g_source_remove (priv->coldplug_id);
+	if (priv->percentage_id != 0)
+		g_source_remove (priv->percentage_id);
 	if (priv->proxy_uid != NULL)
 		g_object_unref (priv->proxy_uid);
 	if (priv->engine != NULL)
 		g_object_unref (priv->engine);
+	if (priv->name_owner_changed_id != 0)
+		g_dbus_connection_signal_unsubscribe (priv->connection, priv->name_owner_changed_id);
 	if (priv->connection != NULL)
 		g_object_unref (priv->connection);
+	for (guint i = 0; i < priv->peer_connections->len; i++) {
+		GDBusConnection *connection = g_ptr_array_index (priv->peer_connections, i);
+		g_signal_handlers_disconnect_by_data (connection, priv);
+	}
+	g_ptr_array_unref (priv->peer_connections);
+	if (priv->peer_server != NULL) {
+		g_dbus_server_stop (priv->peer_server);
+		g_object_unref (priv->peer_server);
+		g_unlink (priv->peer_socket_fn);
+	}
+	g_free (priv->peer_socket_fn);
 #ifdef HAVE_POLKIT
 	if (priv->authority != NULL)
 		g_object_unref (priv->authority);
+	if (priv->sender_auths != NULL)
+		g_hash_table_unref (priv->sender_auths);
 #endif
 	if (priv->argv0_monitor != NULL) {
 		g_file_monitor_cancel (priv->argv0_monitor);
@@ -1948,10 +2987,25 @@ main (int argc, char *argv[])
 	/* create new objects */
 	priv = g_new0 (FuMainPrivate, 1);
 	priv->sender_features = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->sender_request_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->devices_changed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->devices_removed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	priv->devices_variant = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						       (GDestroyNotify) fu_main_device_variant_free);
+	priv->peer_connections = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->loop = g_main_loop_new (NULL, FALSE);
+	priv->percentage_emitted = G_MAXUINT;
+
+	/* start the generation from the time so that clients can tell when
+	 * the daemon has been restarted */
+	priv->devices_generation = (guint64) g_get_real_time ();
+	priv->devices_generation_all = priv->devices_generation;
 
 	/* load engine */
 	priv->engine = fu_engine_new (FU_APP_FLAGS_NONE);
+#ifdef HAVE_PLUGIN_BUILTIN
+	fu_engine_set_plugin_builtins (priv->engine, fu_plugin_builtins);
+#endif
 	g_signal_connect (priv->engine, "changed",
 			  G_CALLBACK (fu_main_engine_changed_cb),
 			  priv);
@@ -1970,9 +3024,14 @@ main (int argc, char *argv[])
 	g_signal_connect (priv->engine, "percentage-changed",
 			  G_CALLBACK (fu_main_engine_percentage_changed_cb),
 			  priv);
+	g_signal_connect (priv->engine, "security-changed",
+			  G_CALLBACK (fu_main_engine_security_changed_cb),
+			  priv);
 	if (!fu_engine_load (priv->engine,
 			     FU_ENGINE_LOAD_FLAG_COLDPLUG |
+			     FU_ENGINE_LOAD_FLAG_DEFER_COLDPLUG |
 			     FU_ENGINE_LOAD_FLAG_HWINFO |
+			     FU_ENGINE_LOAD_FLAG_LAZY_PLUGINS |
 			     FU_ENGINE_LOAD_FLAG_REMOTES,
 			     &error)) {
 		g_printerr ("Failed to load engine: %s\n", error->message);
@@ -2011,6 +3070,10 @@ main (int argc, char *argv[])
 		g_printerr ("Failed to load authority: %s\n", error->message);
 		return EXIT_FAILURE;
 	}
+	priv->sender_auths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						    (GDestroyNotify) g_hash_table_unref);
+	g_signal_connect (priv->authority, "changed",
+			  G_CALLBACK (fu_main_authority_changed_cb), priv);
 #endif
 
 	/* are we a VM? */
@@ -2020,6 +3083,14 @@ main (int argc, char *argv[])
 		priv->machine_kind = FU_MAIN_MACHINE_KIND_CONTAINER;
 	}
 
+	/* local clients can avoid the system bus */
+	if (fu_config_get_enable_peer_socket (fu_engine_get_config (priv->engine))) {
+		if (!fu_main_peer_server_start (priv, &error)) {
+			g_printerr ("Failed to listen for peers: %s\n", error->message);
+			return EXIT_FAILURE;
+		}
+	}
+
 	/* own the object */
 	priv->owner_id = g_bus_own_name (G_BUS_TYPE_SYSTEM,
 					 FWUPD_DBUS_SERVICE,
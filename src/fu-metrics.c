@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuMetrics"
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "fu-metrics.h"
+
+/* 1ms to 131s, each bucket doubling the limit */
+#define FU_METRICS_HISTOGRAM_BUCKETS		18
+
+typedef enum {
+	FU_METRICS_TYPE_COUNTER,
+	FU_METRICS_TYPE_GAUGE,
+	FU_METRICS_TYPE_HISTOGRAM,
+} FuMetricsType;
+
+typedef struct {
+	const gchar		*name;
+	FuMetricsType		 type;
+	const gchar		*label_key;	/* nullable */
+	const gchar		*help;
+} FuMetricsFamily;
+
+/* everything the daemon exports, in the order rendered */
+static const FuMetricsFamily families[] = {
+	{ "fwupd_dbus_method_duration_seconds", FU_METRICS_TYPE_HISTOGRAM,
+	  "method", "Time taken to reply to each D-Bus method" },
+	{ "fwupd_plugin_coldplug_duration_seconds", FU_METRICS_TYPE_GAUGE,
+	  "plugin", "Time taken for the last coldplug of each plugin" },
+	{ "fwupd_plugin_runner_calls", FU_METRICS_TYPE_COUNTER,
+	  "plugin", "Number of plugin vfuncs called" },
+	{ "fwupd_plugin_runner_cpu_seconds", FU_METRICS_TYPE_COUNTER,
+	  "plugin", "CPU time used by plugin vfuncs" },
+	{ "fwupd_plugin_updates", FU_METRICS_TYPE_COUNTER,
+	  "plugin", "Number of successful device updates" },
+	{ "fwupd_plugin_update_failures", FU_METRICS_TYPE_COUNTER,
+	  "plugin", "Number of failed device updates" },
+	{ "fwupd_plugin_update_written_bytes", FU_METRICS_TYPE_COUNTER,
+	  "plugin", "Bytes written to devices during updates" },
+	{ "fwupd_plugin_update_duration_seconds", FU_METRICS_TYPE_HISTOGRAM,
+	  "plugin", "Time taken to write each update" },
+	{ "fwupd_silo_rebuild_duration_seconds", FU_METRICS_TYPE_HISTOGRAM,
+	  "remote", "Time taken to load the metadata of each remote" },
+	{ "fwupd_quirk_lookups", FU_METRICS_TYPE_COUNTER,
+	  "result", "Number of quirk lookups" },
+	{ "fwupd_devices", FU_METRICS_TYPE_GAUGE,
+	  NULL, "Number of devices" },
+	{ "process_resident_memory_bytes", FU_METRICS_TYPE_GAUGE,
+	  NULL, "Resident memory size" },
+	{ NULL }
+};
+
+typedef struct {
+	gchar			*request_id;
+	gdouble			 value;
+} FuMetricsExemplar;
+
+typedef struct {
+	const FuMetricsFamily	*family;
+	gchar			*label;		/* nullable */
+	gdouble			 value;		/* or sum */
+	guint64			 count;
+	guint64			 buckets[FU_METRICS_HISTOGRAM_BUCKETS + 1];
+	FuMetricsExemplar	 exemplars[FU_METRICS_HISTOGRAM_BUCKETS + 1];
+} FuMetricsSample;
+
+struct _FuMetrics
+{
+	GObject			 parent_instance;
+	GHashTable		*samples;	/* family\tlabel : FuMetricsSample */
+	GMutex			 mutex;
+};
+
+static void fu_metrics_finalize	 (GObject *obj);
+
+G_DEFINE_TYPE (FuMetrics, fu_metrics, G_TYPE_OBJECT)
+
+static void
+fu_metrics_sample_free (FuMetricsSample *sample)
+{
+	for (guint i = 0; i < FU_METRICS_HISTOGRAM_BUCKETS + 1; i++)
+		g_free (sample->exemplars[i].request_id);
+	g_free (sample->label);
+	g_free (sample);
+}
+
+static const FuMetricsFamily *
+fu_metrics_find_family (const gchar *name)
+{
+	for (guint i = 0; families[i].name != NULL; i++) {
+		if (g_strcmp0 (families[i].name, name) == 0)
+			return &families[i];
+	}
+	return NULL;
+}
+
+static FuMetricsSample *
+fu_metrics_ensure_sample (FuMetrics *self,
+			  const gchar *name,
+			  const gchar *label,
+			  FuMetricsType type)
+{
+	FuMetricsSample *sample;
+	const FuMetricsFamily *family = fu_metrics_find_family (name);
+	g_autofree gchar *key = NULL;
+
+	if (family == NULL || family->type != type) {
+		g_critical ("metric %s unknown or wrong type", name);
+		return NULL;
+	}
+	key = g_strdup_printf ("%s\t%s", name, label != NULL ? label : "");
+	sample = g_hash_table_lookup (self->samples, key);
+	if (sample != NULL)
+		return sample;
+	sample = g_new0 (FuMetricsSample, 1);
+	sample->family = family;
+	sample->label = g_strdup (label);
+	g_hash_table_insert (self->samples, g_steal_pointer (&key), sample);
+	return sample;
+}
+
+/* add a duration in seconds to a histogram, keeping the last request ID
+ * for each bucket so that a slow sample can be found in the log */
+void
+fu_metrics_observe (FuMetrics *self,
+		    const gchar *name,
+		    const gchar *label,
+		    gdouble value,
+		    const gchar *request_id)
+{
+	FuMetricsSample *sample;
+	guint idx = FU_METRICS_HISTOGRAM_BUCKETS;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_METRICS (self));
+	g_return_if_fail (name != NULL);
+
+	sample = fu_metrics_ensure_sample (self, name, label, FU_METRICS_TYPE_HISTOGRAM);
+	if (sample == NULL)
+		return;
+	sample->count++;
+	sample->value += value;
+	for (guint i = 0; i < FU_METRICS_HISTOGRAM_BUCKETS; i++) {
+		if (value * 1000.f <= (gdouble) (1u << i)) {
+			idx = i;
+			break;
+		}
+	}
+	sample->buckets[idx]++;
+	if (request_id != NULL) {
+		g_free (sample->exemplars[idx].request_id);
+		sample->exemplars[idx].request_id = g_strdup (request_id);
+		sample->exemplars[idx].value = value;
+	}
+}
+
+/* add to a counter */
+void
+fu_metrics_inc (FuMetrics *self,
+		const gchar *name,
+		const gchar *label,
+		gdouble value)
+{
+	FuMetricsSample *sample;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_METRICS (self));
+	g_return_if_fail (name != NULL);
+
+	sample = fu_metrics_ensure_sample (self, name, label, FU_METRICS_TYPE_COUNTER);
+	if (sample == NULL)
+		return;
+	sample->value += value;
+}
+
+/* set a gauge, or a counter that is maintained elsewhere */
+void
+fu_metrics_set (FuMetrics *self,
+		const gchar *name,
+		const gchar *label,
+		gdouble value)
+{
+	FuMetricsSample *sample;
+	const FuMetricsFamily *family = fu_metrics_find_family (name);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_METRICS (self));
+	g_return_if_fail (name != NULL);
+
+	sample = fu_metrics_ensure_sample (self, name, label,
+					   family != NULL && family->type == FU_METRICS_TYPE_COUNTER ?
+					   FU_METRICS_TYPE_COUNTER : FU_METRICS_TYPE_GAUGE);
+	if (sample == NULL)
+		return;
+	sample->value = value;
+}
+
+static void
+fu_metrics_append_value (GString *str, gdouble value)
+{
+	gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+	g_string_append (str, g_ascii_formatd (buf, sizeof(buf), "%.9g", value));
+}
+
+/* label values are quoted */
+static void
+fu_metrics_append_escaped (GString *str, const gchar *value)
+{
+	for (const gchar *tmp = value; *tmp != '\0'; tmp++) {
+		if (*tmp == '\\' || *tmp == '"')
+			g_string_append_c (str, '\\');
+		if (*tmp == '\n') {
+			g_string_append (str, "\\n");
+			continue;
+		}
+		g_string_append_c (str, *tmp);
+	}
+}
+
+static void
+fu_metrics_append_labels (GString *str,
+			  const FuMetricsFamily *family,
+			  const gchar *label,
+			  const gchar *le)
+{
+	if (family->label_key == NULL && le == NULL)
+		return;
+	g_string_append (str, "{");
+	if (family->label_key != NULL) {
+		g_string_append_printf (str, "%s=\"", family->label_key);
+		fu_metrics_append_escaped (str, label != NULL ? label : "");
+		g_string_append (str, "\"");
+		if (le != NULL)
+			g_string_append (str, ",");
+	}
+	if (le != NULL)
+		g_string_append_printf (str, "le=\"%s\"", le);
+	g_string_append (str, "}");
+}
+
+static void
+fu_metrics_append_exemplar (GString *str, FuMetricsExemplar *exemplar)
+{
+	if (exemplar->request_id == NULL) {
+		g_string_append (str, "\n");
+		return;
+	}
+	g_string_append (str, " # {request_id=\"");
+	fu_metrics_append_escaped (str, exemplar->request_id);
+	g_string_append (str, "\"} ");
+	fu_metrics_append_value (str, exemplar->value);
+	g_string_append (str, "\n");
+}
+
+static void
+fu_metrics_append_sample (GString *str, FuMetricsSample *sample)
+{
+	const FuMetricsFamily *family = sample->family;
+	guint64 cumulative = 0;
+
+	if (family->type == FU_METRICS_TYPE_COUNTER) {
+		g_string_append_printf (str, "%s_total", family->name);
+		fu_metrics_append_labels (str, family, sample->label, NULL);
+		g_string_append (str, " ");
+		fu_metrics_append_value (str, sample->value);
+		g_string_append (str, "\n");
+		return;
+	}
+	if (family->type == FU_METRICS_TYPE_GAUGE) {
+		g_string_append (str, family->name);
+		fu_metrics_append_labels (str, family, sample->label, NULL);
+		g_string_append (str, " ");
+		fu_metrics_append_value (str, sample->value);
+		g_string_append (str, "\n");
+		return;
+	}
+
+	/* histogram buckets are cumulative */
+	for (guint i = 0; i < FU_METRICS_HISTOGRAM_BUCKETS; i++) {
+		gchar le[G_ASCII_DTOSTR_BUF_SIZE];
+		cumulative += sample->buckets[i];
+		g_ascii_formatd (le, sizeof(le), "%.3f", (gdouble) (1u << i) / 1000.f);
+		g_string_append_printf (str, "%s_bucket", family->name);
+		fu_metrics_append_labels (str, family, sample->label, le);
+		g_string_append_printf (str, " %" G_GUINT64_FORMAT, cumulative);
+		fu_metrics_append_exemplar (str, &sample->exemplars[i]);
+	}
+	g_string_append_printf (str, "%s_bucket", family->name);
+	fu_metrics_append_labels (str, family, sample->label, "+Inf");
+	g_string_append_printf (str, " %" G_GUINT64_FORMAT, sample->count);
+	fu_metrics_append_exemplar (str, &sample->exemplars[FU_METRICS_HISTOGRAM_BUCKETS]);
+	g_string_append_printf (str, "%s_count", family->name);
+	fu_metrics_append_labels (str, family, sample->label, NULL);
+	g_string_append_printf (str, " %" G_GUINT64_FORMAT "\n", sample->count);
+	g_string_append_printf (str, "%s_sum", family->name);
+	fu_metrics_append_labels (str, family, sample->label, NULL);
+	g_string_append (str, " ");
+	fu_metrics_append_value (str, sample->value);
+	g_string_append (str, "\n");
+}
+
+static gint
+fu_metrics_sample_sort_cb (gconstpointer a, gconstpointer b)
+{
+	FuMetricsSample *sample1 = *((FuMetricsSample **) a);
+	FuMetricsSample *sample2 = *((FuMetricsSample **) b);
+	return g_strcmp0 (sample1->label, sample2->label);
+}
+
+/* in the OpenMetrics text exposition format */
+gchar *
+fu_metrics_to_string (FuMetrics *self)
+{
+	GString *str = g_string_new (NULL);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_val_if_fail (FU_IS_METRICS (self), NULL);
+
+	for (guint i = 0; families[i].name != NULL; i++) {
+		const gchar *types[] = { "counter", "gauge", "histogram" };
+		GHashTableIter iter;
+		FuMetricsSample *sample;
+		g_autoptr(GPtrArray) samples = g_ptr_array_new ();
+
+		g_hash_table_iter_init (&iter, self->samples);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &sample)) {
+			if (sample->family == &families[i])
+				g_ptr_array_add (samples, sample);
+		}
+		if (samples->len == 0)
+			continue;
+		g_ptr_array_sort (samples, fu_metrics_sample_sort_cb);
+		g_string_append_printf (str, "# TYPE %s %s\n",
+					families[i].name, types[families[i].type]);
+		g_string_append_printf (str, "# HELP %s %s\n",
+					families[i].name, families[i].help);
+		for (guint j = 0; j < samples->len; j++)
+			fu_metrics_append_sample (str, g_ptr_array_index (samples, j));
+	}
+	g_string_append (str, "# EOF\n");
+	return g_string_free (str, FALSE);
+}
+
+static void
+fu_metrics_class_init (FuMetricsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_metrics_finalize;
+}
+
+static void
+fu_metrics_init (FuMetrics *self)
+{
+	self->samples = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					       (GDestroyNotify) fu_metrics_sample_free);
+	g_mutex_init (&self->mutex);
+}
+
+static void
+fu_metrics_finalize (GObject *obj)
+{
+	FuMetrics *self = FU_METRICS (obj);
+
+	g_hash_table_unref (self->samples);
+	g_mutex_clear (&self->mutex);
+
+	G_OBJECT_CLASS (fu_metrics_parent_class)->finalize (obj);
+}
+
+FuMetrics *
+fu_metrics_new (void)
+{
+	FuMetrics *self;
+	self = g_object_new (FU_TYPE_METRICS, NULL);
+	return FU_METRICS (self);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#define FU_TYPE_METRICS (fu_metrics_get_type ())
+G_DECLARE_FINAL_TYPE (FuMetrics, fu_metrics, FU, METRICS, GObject)
+
+FuMetrics	*fu_metrics_new			(void);
+void		 fu_metrics_observe		(FuMetrics	*self,
+						 const gchar	*name,
+						 const gchar	*label,
+						 gdouble	 value,
+						 const gchar	*request_id);
+void		 fu_metrics_inc			(FuMetrics	*self,
+						 const gchar	*name,
+						 const gchar	*label,
+						 gdouble	 value);
+void		 fu_metrics_set			(FuMetrics	*self,
+						 const gchar	*name,
+						 const gchar	*label,
+						 gdouble	 value);
+gchar		*fu_metrics_to_string		(FuMetrics	*self);
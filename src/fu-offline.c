@@ -28,8 +28,17 @@ struct FuUtilPrivate {
 	FuOfflineFlag	 splash_flags;
 };
 
-static gboolean
-fu_offline_set_splash_progress (FuUtilPrivate *priv, guint percentage, GError **error)
+static void
+fu_offline_set_splash_progress_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	if (!fu_common_spawn_finish (res, &error))
+		g_debug ("failed to set splash progress: %s", error->message);
+}
+
+/* this does not wait for plymouth, so the install progress is not delayed */
+static void
+fu_offline_set_splash_progress (FuUtilPrivate *priv, guint percentage)
 {
 	g_autofree gchar *str = g_strdup_printf ("%u", percentage);
 	const gchar *argv[] = { priv->splash_cmd, "system-update", "--progress", str, NULL };
@@ -38,7 +47,7 @@ fu_offline_set_splash_progress (FuUtilPrivate *priv, guint percentage, GError **
 	if (priv->splash_flags == FU_OFFLINE_FLAG_NONE) {
 		/* TRANSLATORS: console message when not using plymouth */
 		g_printerr ("%s: %u%%\n", _("Percentage complete"), percentage);
-		return TRUE;
+		return;
 	}
 
 	/* fall back to really old mode that should be supported by anything */
@@ -46,7 +55,8 @@ fu_offline_set_splash_progress (FuUtilPrivate *priv, guint percentage, GError **
 		argv[1] = "display-message";
 		argv[2] = "--text";
 	}
-	return fu_common_spawn_sync (argv, NULL, NULL, 200, NULL, error);
+	fu_common_spawn_async (argv, NULL, NULL, 200, NULL,
+			       fu_offline_set_splash_progress_cb, NULL);
 }
 
 static gboolean
@@ -116,7 +126,7 @@ fu_offline_client_notify_cb (GObject *object, GParamSpec *pspec, gpointer user_d
 	if (g_timer_elapsed (priv->splash_timer, NULL) < 1.f ||
 	    fwupd_client_get_percentage (client) < 5)
 		return;
-	fu_offline_set_splash_progress (priv, fwupd_client_get_percentage (client), NULL);
+	fu_offline_set_splash_progress (priv, fwupd_client_get_percentage (client));
 	g_timer_reset (priv->splash_timer);
 }
 
@@ -140,6 +150,8 @@ main (int argc, char *argv[])
 	gint vercmp;
 	guint cnt = 0;
 	g_autofree gchar *link = NULL;
+	g_autofree gchar *plan = NULL;
+	g_autofree gchar *plan_active = NULL;
 	g_autofree gchar *target = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
 	g_autofree gchar *trigger = fu_common_get_path (FU_PATH_KIND_OFFLINE_TRIGGER);
 	g_autoptr(FuHistory) history = NULL;
@@ -164,6 +176,12 @@ main (int argc, char *argv[])
 	/* do this first to avoid a loop if this tool segfaults */
 	g_unlink (trigger);
 
+	/* the daemon only loads the plugins in the plan written at schedule time */
+	plan = g_build_filename (target, "offline.plan", NULL);
+	plan_active = g_build_filename (target, "offline.plan.active", NULL);
+	if (g_file_test (plan, G_FILE_TEST_EXISTS) && g_rename (plan, plan_active) != 0)
+		g_debug ("failed to activate %s", plan);
+
 	/* ensure root user */
 #ifdef HAVE_GETUID
 	if (getuid () != 0 || geteuid () != 0) {
@@ -182,7 +200,9 @@ main (int argc, char *argv[])
 
 	/* get prepared updates */
 	history = fu_history_new ();
-	results = fu_history_get_devices (history, &error);
+	results = fu_history_get_devices_filtered (history,
+						   FWUPD_UPDATE_STATE_PENDING,
+						   0, 0, &error);
 	if (results == NULL) {
 		/* TRANSLATORS: we could not get the devices to update offline */
 		g_printerr ("%s: %s\n", _("Failed to get pending devices"),
@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "fu-plugin-private.h"
+#include "fu-security-attrs.h"
+
+typedef struct {
+	const gchar		*name;
+	const FuPluginSymbol	*symbols;
+} FuPluginBuiltin;
+
+/* generated by fu-plugin-builtin-gen.py when built with -Dplugin_builtin=true */
+extern const FuPluginBuiltin fu_plugin_builtins[];
@@ -76,6 +76,25 @@ fu_plugin_list_add (FuPluginList *self, FuPlugin *plugin)
 			     g_object_ref (plugin));
 }
 
+/**
+ * fu_plugin_list_remove:
+ * @self: A #FuPluginList
+ * @plugin: A #FuPlugin
+ *
+ * Removes a plugin from the list, which unloads the module if nothing else
+ * holds a reference to the plugin.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_plugin_list_remove (FuPluginList *self, FuPlugin *plugin)
+{
+	g_return_if_fail (FU_IS_PLUGIN_LIST (self));
+	g_return_if_fail (FU_IS_PLUGIN (plugin));
+	g_hash_table_remove (self->plugins_hash, fu_plugin_get_name (plugin));
+	g_ptr_array_remove (self->plugins, plugin);
+}
+
 /**
  * fu_plugin_list_find_by_name:
  * @self: A #FuPluginList
@@ -106,6 +125,54 @@ fu_plugin_list_find_by_name (FuPluginList *self, const gchar *name, GError **err
 	return NULL;
 }
 
+/**
+ * fu_plugin_list_has_order_rules:
+ * @self: A #FuPluginList
+ * @plugin: A #FuPlugin
+ *
+ * Finds out if the plugin has to be run in a specific order relative to other
+ * plugins, either because it has %FU_PLUGIN_RULE_RUN_AFTER or
+ * %FU_PLUGIN_RULE_RUN_BEFORE rules itself, or because another enabled plugin
+ * has a rule that references it.
+ *
+ * Returns: %TRUE if the plugin is part of the ordering graph
+ *
+ * Since: 1.5.8
+ **/
+gboolean
+fu_plugin_list_has_order_rules (FuPluginList *self, FuPlugin *plugin)
+{
+	FuPluginRule rules[] = { FU_PLUGIN_RULE_RUN_AFTER,
+				 FU_PLUGIN_RULE_RUN_BEFORE };
+
+	g_return_val_if_fail (FU_IS_PLUGIN_LIST (self), FALSE);
+	g_return_val_if_fail (FU_IS_PLUGIN (plugin), FALSE);
+
+	for (guint r = 0; r < G_N_ELEMENTS (rules); r++) {
+		GPtrArray *deps = fu_plugin_get_rules (plugin, rules[r]);
+		if (deps != NULL && deps->len > 0)
+			return TRUE;
+	}
+	for (guint i = 0; i < self->plugins->len; i++) {
+		FuPlugin *plugin_tmp = g_ptr_array_index (self->plugins, i);
+		if (plugin_tmp == plugin)
+			continue;
+		if (fu_plugin_has_flag (plugin_tmp, FWUPD_PLUGIN_FLAG_DISABLED))
+			continue;
+		for (guint r = 0; r < G_N_ELEMENTS (rules); r++) {
+			GPtrArray *deps = fu_plugin_get_rules (plugin_tmp, rules[r]);
+			if (deps == NULL)
+				continue;
+			for (guint j = 0; j < deps->len; j++) {
+				const gchar *name = g_ptr_array_index (deps, j);
+				if (g_strcmp0 (name, fu_plugin_get_name (plugin)) == 0)
+					return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
 static gint
 fu_plugin_list_sort_cb (gconstpointer a, gconstpointer b)
 {
@@ -114,6 +181,128 @@ fu_plugin_list_sort_cb (gconstpointer a, gconstpointer b)
 	return fu_plugin_order_compare (*pa, *pb);
 }
 
+typedef struct {
+	guint		 from;
+	guint		 to;
+} FuPluginListEdge;
+
+typedef guint	(*FuPluginListGetFunc)	(FuPlugin	*self);
+typedef void	(*FuPluginListSetFunc)	(FuPlugin	*self,
+					 guint		 value);
+
+/* adds edges so that plugins that are named in @rule come before the plugin
+ * with the rule, or after it if @reverse is set */
+static void
+fu_plugin_list_depsolve_add_edges (FuPluginList *self,
+				   GHashTable *indexes,
+				   FuPluginRule rule,
+				   gboolean reverse,
+				   GArray *edges)
+{
+	for (guint i = 0; i < self->plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
+		GPtrArray *deps = fu_plugin_get_rules (plugin, rule);
+		if (deps == NULL)
+			continue;
+		for (guint j = 0; j < deps->len; j++) {
+			const gchar *plugin_name = g_ptr_array_index (deps, j);
+			FuPlugin *dep = g_hash_table_lookup (self->plugins_hash, plugin_name);
+			FuPluginListEdge edge;
+			guint idx;
+			if (dep == NULL) {
+				g_debug ("cannot find plugin '%s' "
+					 "referenced by '%s'",
+					 plugin_name,
+					 fu_plugin_get_name (plugin));
+				continue;
+			}
+			if (fu_plugin_has_flag (dep, FWUPD_PLUGIN_FLAG_DISABLED))
+				continue;
+			idx = GPOINTER_TO_UINT (g_hash_table_lookup (indexes, dep)) - 1;
+			edge.from = reverse ? i : idx;
+			edge.to = reverse ? idx : i;
+			g_array_append_val (edges, edge);
+		}
+	}
+}
+
+/* sets each value to be larger than the values of all its predecessors using
+ * a topological sort, which is linear in the number of plugins and edges */
+static gboolean
+fu_plugin_list_depsolve_edges (FuPluginList *self,
+			       GArray *edges,
+			       FuPluginListGetFunc get_func,
+			       FuPluginListSetFunc set_func,
+			       GError **error)
+{
+	guint n = self->plugins->len;
+	guint done = 0;
+	g_autofree guint *in_degree = g_new0 (guint, n);
+	g_autofree guint *offsets = g_new0 (guint, n + 1);
+	g_autofree guint *targets = g_new0 (guint, edges->len + 1);
+	g_autofree guint *values = g_new0 (guint, n);
+	g_autofree guint *queue = g_new0 (guint, n);
+	guint queue_len = 0;
+
+	/* adjacency list, grouped by the source plugin */
+	for (guint i = 0; i < edges->len; i++) {
+		FuPluginListEdge *edge = &g_array_index (edges, FuPluginListEdge, i);
+		offsets[edge->from + 1]++;
+		in_degree[edge->to]++;
+	}
+	for (guint i = 0; i < n; i++)
+		offsets[i + 1] += offsets[i];
+	for (guint i = 0; i < edges->len; i++) {
+		FuPluginListEdge *edge = &g_array_index (edges, FuPluginListEdge, i);
+		targets[offsets[edge->from]++] = edge->to;
+	}
+	for (guint i = n; i > 0; i--)
+		offsets[i] = offsets[i - 1];
+	offsets[0] = 0;
+
+	/* the queue is seeded in list order so the result is stable */
+	for (guint i = 0; i < n; i++) {
+		values[i] = get_func (g_ptr_array_index (self->plugins, i));
+		if (in_degree[i] == 0)
+			queue[queue_len++] = i;
+	}
+	for (guint q = 0; q < queue_len; q++) {
+		guint from = queue[q];
+		for (guint j = offsets[from]; j < offsets[from + 1]; j++) {
+			guint to = targets[j];
+			values[to] = MAX (values[to], values[from] + 1);
+			if (--in_degree[to] == 0)
+				queue[queue_len++] = to;
+		}
+		done++;
+	}
+
+	/* anything not visited is part of a loop */
+	if (done < n) {
+		for (guint i = 0; i < n; i++) {
+			if (in_degree[i] == 0)
+				continue;
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INTERNAL,
+				     "got stuck in dep loop with %s",
+				     fu_plugin_get_name (g_ptr_array_index (self->plugins, i)));
+			return FALSE;
+		}
+	}
+
+	/* apply */
+	for (guint i = 0; i < n; i++) {
+		FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
+		if (get_func (plugin) == values[i])
+			continue;
+		g_debug ("%s [%u] has dependencies so promoting to [%u]",
+			 fu_plugin_get_name (plugin), get_func (plugin), values[i]);
+		set_func (plugin, values[i]);
+	}
+	return TRUE;
+}
+
 /**
  * fu_plugin_list_depsolve:
  * @self: A #FuPluginList
@@ -133,117 +322,38 @@ fu_plugin_list_depsolve (FuPluginList *self, GError **error)
 {
 	FuPlugin *dep;
 	GPtrArray *deps;
-	gboolean changes;
-	guint dep_loop_check = 0;
+	g_autoptr(GArray) edges_order = g_array_new (FALSE, FALSE, sizeof(FuPluginListEdge));
+	g_autoptr(GArray) edges_priority = g_array_new (FALSE, FALSE, sizeof(FuPluginListEdge));
+	g_autoptr(GHashTable) indexes = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	g_return_val_if_fail (FU_IS_PLUGIN_LIST (self), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	/* order by deps */
-	do {
-		changes = FALSE;
-		for (guint i = 0; i < self->plugins->len; i++) {
-			FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
-			deps = fu_plugin_get_rules (plugin, FU_PLUGIN_RULE_RUN_AFTER);
-			if (deps == NULL)
-				continue;
-			for (guint j = 0; j < deps->len && !changes; j++) {
-				const gchar *plugin_name = g_ptr_array_index (deps, j);
-				dep = fu_plugin_list_find_by_name (self, plugin_name, NULL);
-				if (dep == NULL) {
-					g_debug ("cannot find plugin '%s' "
-						 "requested by '%s'",
-						 plugin_name,
-						 fu_plugin_get_name (plugin));
-					continue;
-				}
-				if (fu_plugin_has_flag (dep, FWUPD_PLUGIN_FLAG_DISABLED))
-					continue;
-				if (fu_plugin_get_order (plugin) <= fu_plugin_get_order (dep)) {
-					g_debug ("%s [%u] to be ordered after %s [%u] "
-						 "so promoting to [%u]",
-						 fu_plugin_get_name (plugin),
-						 fu_plugin_get_order (plugin),
-						 fu_plugin_get_name (dep),
-						 fu_plugin_get_order (dep),
-						 fu_plugin_get_order (dep) + 1);
-					fu_plugin_set_order (plugin, fu_plugin_get_order (dep) + 1);
-					changes = TRUE;
-				}
-			}
-		}
-		for (guint i = 0; i < self->plugins->len; i++) {
-			FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
-			deps = fu_plugin_get_rules (plugin, FU_PLUGIN_RULE_RUN_BEFORE);
-			if (deps == NULL)
-				continue;
-			for (guint j = 0; j < deps->len && !changes; j++) {
-				const gchar *plugin_name = g_ptr_array_index (deps, j);
-				dep = fu_plugin_list_find_by_name (self, plugin_name, NULL);
-				if (dep == NULL) {
-					g_debug ("cannot find plugin '%s' "
-						 "requested by '%s'",
-						 plugin_name,
-						 fu_plugin_get_name (plugin));
-					continue;
-				}
-				if (fu_plugin_has_flag (dep, FWUPD_PLUGIN_FLAG_DISABLED))
-					continue;
-				if (fu_plugin_get_order (plugin) >= fu_plugin_get_order (dep)) {
-					g_debug ("%s [%u] to be ordered before %s [%u] "
-						 "so promoting to [%u]",
-						 fu_plugin_get_name (plugin),
-						 fu_plugin_get_order (plugin),
-						 fu_plugin_get_name (dep),
-						 fu_plugin_get_order (dep),
-						 fu_plugin_get_order (dep) + 1);
-					fu_plugin_set_order (dep, fu_plugin_get_order (plugin) + 1);
-					changes = TRUE;
-				}
-			}
-		}
+	/* offset by one so that the first plugin is not NULL */
+	for (guint i = 0; i < self->plugins->len; i++) {
+		FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
+		g_hash_table_insert (indexes, plugin, GUINT_TO_POINTER (i + 1));
+	}
 
-		/* set priority as well */
-		for (guint i = 0; i < self->plugins->len; i++) {
-			FuPlugin *plugin = g_ptr_array_index (self->plugins, i);
-			deps = fu_plugin_get_rules (plugin, FU_PLUGIN_RULE_BETTER_THAN);
-			if (deps == NULL)
-				continue;
-			for (guint j = 0; j < deps->len && !changes; j++) {
-				const gchar *plugin_name = g_ptr_array_index (deps, j);
-				dep = fu_plugin_list_find_by_name (self, plugin_name, NULL);
-				if (dep == NULL) {
-					g_debug ("cannot find plugin '%s' "
-						 "referenced by '%s'",
-						 plugin_name,
-						 fu_plugin_get_name (plugin));
-					continue;
-				}
-				if (fu_plugin_has_flag (dep, FWUPD_PLUGIN_FLAG_DISABLED))
-					continue;
-				if (fu_plugin_get_priority (plugin) <= fu_plugin_get_priority (dep)) {
-					g_debug ("%s [%u] better than %s [%u] "
-						 "so bumping to [%u]",
-						 fu_plugin_get_name (plugin),
-						 fu_plugin_get_priority (plugin),
-						 fu_plugin_get_name (dep),
-						 fu_plugin_get_priority (dep),
-						 fu_plugin_get_priority (dep) + 1);
-					fu_plugin_set_priority (plugin, fu_plugin_get_priority (dep) + 1);
-					changes = TRUE;
-				}
-			}
-		}
+	/* order by deps */
+	fu_plugin_list_depsolve_add_edges (self, indexes, FU_PLUGIN_RULE_RUN_AFTER,
+					   FALSE, edges_order);
+	fu_plugin_list_depsolve_add_edges (self, indexes, FU_PLUGIN_RULE_RUN_BEFORE,
+					   TRUE, edges_order);
+	if (!fu_plugin_list_depsolve_edges (self, edges_order,
+					    fu_plugin_get_order,
+					    fu_plugin_set_order,
+					    error))
+		return FALSE;
 
-		/* check we're not stuck */
-		if (dep_loop_check++ > 100) {
-			g_set_error_literal (error,
-					     FWUPD_ERROR,
-					     FWUPD_ERROR_INTERNAL,
-					     "got stuck in dep loop");
-			return FALSE;
-		}
-	} while (changes);
+	/* set priority as well */
+	fu_plugin_list_depsolve_add_edges (self, indexes, FU_PLUGIN_RULE_BETTER_THAN,
+					   FALSE, edges_priority);
+	if (!fu_plugin_list_depsolve_edges (self, edges_priority,
+					    fu_plugin_get_priority,
+					    fu_plugin_set_priority,
+					    error))
+		return FALSE;
 
 	/* check for conflicts */
 	for (guint i = 0; i < self->plugins->len; i++) {
@@ -253,7 +363,7 @@ fu_plugin_list_depsolve (FuPluginList *self, GError **error)
 		deps = fu_plugin_get_rules (plugin, FU_PLUGIN_RULE_CONFLICTS);
 		if (deps == NULL)
 			continue;
-		for (guint j = 0; j < deps->len && !changes; j++) {
+		for (guint j = 0; j < deps->len; j++) {
 			const gchar *plugin_name = g_ptr_array_index (deps, j);
 			dep = fu_plugin_list_find_by_name (self, plugin_name, NULL);
 			if (dep == NULL)
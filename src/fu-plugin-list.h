@@ -16,9 +16,13 @@ G_DECLARE_FINAL_TYPE (FuPluginList, fu_plugin_list, FU, PLUGIN_LIST, GObject)
 FuPluginList	*fu_plugin_list_new			(void);
 void		 fu_plugin_list_add			(FuPluginList	*self,
 							 FuPlugin	*plugin);
+void		 fu_plugin_list_remove			(FuPluginList	*self,
+							 FuPlugin	*plugin);
 GPtrArray	*fu_plugin_list_get_all			(FuPluginList	*self);
 FuPlugin	*fu_plugin_list_find_by_name		(FuPluginList	*self,
 							 const gchar	*name,
 							 GError		**error);
 gboolean	 fu_plugin_list_depsolve		(FuPluginList	*self,
 							 GError		**error);
+gboolean	 fu_plugin_list_has_order_rules		(FuPluginList	*self,
+							 FuPlugin	*plugin);
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuProfile"
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "fu-profile.h"
+
+static void fu_profile_finalize	 (GObject *obj);
+
+/* a tree of timed sections, stored flat in the order they were started */
+struct _FuProfile
+{
+	GObject			 parent_instance;
+	GPtrArray		*items;		/* of FuProfileItem */
+	GPtrArray		*stack;		/* of FuProfileItem, not owned */
+	GMutex			 mutex;
+	GTimer			*timer;
+	gboolean		 stopped;
+};
+
+typedef struct {
+	gchar			*id;
+	guint			 depth;
+	gdouble			 start;		/* ms */
+	gdouble			 elapsed;	/* ms */
+} FuProfileItem;
+
+G_DEFINE_TYPE (FuProfile, fu_profile, G_TYPE_OBJECT)
+
+static FuProfileItem *
+fu_profile_item_new (FuProfile *self, const gchar *id)
+{
+	FuProfileItem *item = g_new0 (FuProfileItem, 1);
+	item->id = g_strdup (id);
+	item->depth = self->stack->len;
+	item->start = g_timer_elapsed (self->timer, NULL) * 1000.f;
+	g_ptr_array_add (self->items, item);
+	return item;
+}
+
+static void
+fu_profile_item_free (FuProfileItem *item)
+{
+	g_free (item->id);
+	g_free (item);
+}
+
+/* start a section nested inside the current one */
+void
+fu_profile_push (FuProfile *self, const gchar *fmt, ...)
+{
+	va_list args;
+	g_autofree gchar *id = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_PROFILE (self));
+	g_return_if_fail (fmt != NULL);
+
+	if (self->stopped)
+		return;
+	va_start (args, fmt);
+	id = g_strdup_vprintf (fmt, args);
+	va_end (args);
+	g_ptr_array_add (self->stack, fu_profile_item_new (self, id));
+}
+
+/* finish the current section */
+void
+fu_profile_pop (FuProfile *self)
+{
+	FuProfileItem *item;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_PROFILE (self));
+
+	if (self->stopped || self->stack->len == 0)
+		return;
+	item = g_ptr_array_index (self->stack, self->stack->len - 1);
+	item->elapsed = (g_timer_elapsed (self->timer, NULL) * 1000.f) - item->start;
+	g_ptr_array_remove_index (self->stack, self->stack->len - 1);
+}
+
+/* add a section that was timed elsewhere, e.g. in a worker thread */
+void
+fu_profile_add (FuProfile *self, const gchar *id, gdouble elapsed)
+{
+	FuProfileItem *item;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_if_fail (FU_IS_PROFILE (self));
+	g_return_if_fail (id != NULL);
+
+	if (self->stopped)
+		return;
+	item = fu_profile_item_new (self, id);
+	item->elapsed = elapsed;
+}
+
+/* ignore anything recorded after startup has completed */
+void
+fu_profile_stop (FuProfile *self)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+	g_return_if_fail (FU_IS_PROFILE (self));
+	while (self->stack->len > 0) {
+		FuProfileItem *item = g_ptr_array_index (self->stack, self->stack->len - 1);
+		item->elapsed = (g_timer_elapsed (self->timer, NULL) * 1000.f) - item->start;
+		g_ptr_array_remove_index (self->stack, self->stack->len - 1);
+	}
+	self->stopped = TRUE;
+}
+
+gchar *
+fu_profile_to_string (FuProfile *self)
+{
+	GString *str = g_string_new (NULL);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_val_if_fail (FU_IS_PROFILE (self), NULL);
+
+	for (guint i = 0; i < self->items->len; i++) {
+		FuProfileItem *item = g_ptr_array_index (self->items, i);
+		for (guint j = 0; j < item->depth; j++)
+			g_string_append (str, "  ");
+		g_string_append_printf (str, "%s: %.1fms\n", item->id, item->elapsed);
+	}
+	return g_string_free (str, FALSE);
+}
+
+/* a(usd) of depth, ID and elapsed time in ms */
+GVariant *
+fu_profile_to_variant (FuProfile *self)
+{
+	GVariantBuilder builder;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+	g_return_val_if_fail (FU_IS_PROFILE (self), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(usd)"));
+	for (guint i = 0; i < self->items->len; i++) {
+		FuProfileItem *item = g_ptr_array_index (self->items, i);
+		g_variant_builder_add (&builder, "(usd)",
+				       item->depth, item->id, item->elapsed);
+	}
+	return g_variant_builder_end (&builder);
+}
+
+static void
+fu_profile_class_init (FuProfileClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = fu_profile_finalize;
+}
+
+static void
+fu_profile_init (FuProfile *self)
+{
+	self->items = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_profile_item_free);
+	self->stack = g_ptr_array_new ();
+	self->timer = g_timer_new ();
+	g_mutex_init (&self->mutex);
+}
+
+static void
+fu_profile_finalize (GObject *obj)
+{
+	FuProfile *self = FU_PROFILE (obj);
+
+	g_ptr_array_unref (self->items);
+	g_ptr_array_unref (self->stack);
+	g_timer_destroy (self->timer);
+	g_mutex_clear (&self->mutex);
+
+	G_OBJECT_CLASS (fu_profile_parent_class)->finalize (obj);
+}
+
+FuProfile *
+fu_profile_new (void)
+{
+	FuProfile *self;
+	self = g_object_new (FU_TYPE_PROFILE, NULL);
+	return FU_PROFILE (self);
+}
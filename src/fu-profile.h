@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#define FU_TYPE_PROFILE (fu_profile_get_type ())
+G_DECLARE_FINAL_TYPE (FuProfile, fu_profile, FU, PROFILE, GObject)
+
+FuProfile	*fu_profile_new			(void);
+void		 fu_profile_push		(FuProfile	*self,
+						 const gchar	*fmt,
+						 ...)
+						 G_GNUC_PRINTF (2, 3);
+void		 fu_profile_pop			(FuProfile	*self);
+void		 fu_profile_add			(FuProfile	*self,
+						 const gchar	*id,
+						 gdouble	 elapsed);
+void		 fu_profile_stop		(FuProfile	*self);
+gchar		*fu_profile_to_string		(FuProfile	*self);
+GVariant	*fu_profile_to_variant		(FuProfile	*self);
@@ -30,6 +30,8 @@ struct _FuProgressbar
 	gint64			 last_animated;		/* monotonic */
 	GTimer			*time_elapsed;
 	gdouble			 last_estimate;
+	guint64			 speed;			/* bytes per second */
+	guint			 remaining;		/* seconds */
 	gboolean		 interactive;
 };
 
@@ -187,8 +189,21 @@ fu_progressbar_refresh (FuProgressbar *self, FwupdStatus status, guint percentag
 	}
 	g_string_append_c (str, ']');
 
-	/* once we have good data show an estimate of time remaining */
-	if (fu_progressbar_estimate_ready (self, percentage)) {
+	/* show the actual transfer speed if known */
+	if (self->speed > 0 && percentage > 0 && percentage < 100) {
+		g_autofree gchar *speed = g_format_size (self->speed);
+		g_string_append_printf (str, " %s/s", speed);
+	}
+
+	/* once we have good data show an estimate of time remaining, preferring
+	 * the prediction made from the transfer speed */
+	if (self->remaining > 0 && percentage > 0 && percentage < 100) {
+		g_autofree gchar *remaining = NULL;
+		self->last_estimate = self->remaining;
+		remaining = fu_progressbar_time_remaining_str (self);
+		if (remaining != NULL)
+			g_string_append_printf (str, " %s…", remaining);
+	} else if (fu_progressbar_estimate_ready (self, percentage)) {
 		g_autofree gchar *remaining = fu_progressbar_time_remaining_str (self);
 		if (remaining != NULL)
 			g_string_append_printf (str, " %s…", remaining);
@@ -343,10 +358,33 @@ fu_progressbar_update (FuProgressbar *self, FwupdStatus status, guint percentage
 	fu_progressbar_refresh (self, status, percentage);
 
 	/* cache */
+	if (self->status != status || percentage == 0 || percentage == 100) {
+		self->speed = 0;
+		self->remaining = 0;
+	}
 	self->status = status;
 	self->percentage = percentage;
 }
 
+/**
+ * fu_progressbar_set_transfer:
+ * @self: A #FuProgressbar
+ * @speed: bytes per second, or 0 for unknown
+ * @remaining: predicted seconds to completion, or 0 for unknown
+ *
+ * Sets the measured transfer speed of the current operation, which is shown
+ * after the progressbar until the status changes or the operation completes.
+ *
+ * Since: 1.5.8
+ **/
+void
+fu_progressbar_set_transfer (FuProgressbar *self, guint64 speed, guint remaining)
+{
+	g_return_if_fail (FU_IS_PROGRESSBAR (self));
+	self->speed = speed;
+	self->remaining = remaining;
+}
+
 /**
  * fu_progressbar_set_interactive:
  * @self: A #FuProgressbar
@@ -25,3 +25,6 @@ void		 fu_progressbar_set_title		(FuProgressbar	*self,
 							 const gchar	*title);
 void		 fu_progressbar_set_interactive		(FuProgressbar *self,
 							 gboolean interactive);
+void		 fu_progressbar_set_transfer		(FuProgressbar	*self,
+							 guint64	 speed,
+							 guint		 remaining);
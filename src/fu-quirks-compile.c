@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2021 Richard Hughes <richard@hughsie.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN				"FuQuirksCompile"
+
+#include "config.h"
+
+#include <fwupd.h>
+#include <stdlib.h>
+
+#include "fu-quirks.h"
+
+/* run at install time to compile PATH/quirks.d into PATH/quirks.xmlb, where
+ * PATH is prefixed with $DESTDIR when set */
+int
+main (int argc, char **argv)
+{
+	const gchar *destdir = g_getenv ("DESTDIR");
+	g_autofree gchar *path = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(FuQuirks) quirks = fu_quirks_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	if (argc != 2) {
+		g_printerr ("Usage: %s PATH\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (destdir != NULL && destdir[0] != '\0')
+		path = g_build_filename (destdir, argv[1], NULL);
+	else
+		path = g_strdup (argv[1]);
+	fn = g_build_filename (path, "quirks.xmlb", NULL);
+	file = g_file_new_for_path (fn);
+	if (!fu_quirks_compile_to_file (quirks, path, file, &error)) {
+		g_printerr ("Failed to compile %s: %s\n", fn, error->message);
+		return EXIT_FAILURE;
+	}
+	g_print ("Compiled %s\n", fn);
+	return EXIT_SUCCESS;
+}
@@ -29,6 +29,8 @@ static guint signals[SIGNAL_LAST] = { 0 };
 
 static void fu_remote_list_finalize	 (GObject *obj);
 
+#define FU_REMOTE_LIST_RELOAD_DELAY		500 /* ms */
+
 struct _FuRemoteList
 {
 	GObject			 parent_instance;
@@ -36,6 +38,7 @@ struct _FuRemoteList
 	GPtrArray		*monitors;		/* (element-type GFileMonitor) */
 	GHashTable		*hash_unfound;		/* utf8 : NULL */
 	XbSilo			*silo;
+	guint			 reload_id;
 };
 
 G_DEFINE_TYPE (FuRemoteList, fu_remote_list, G_TYPE_OBJECT)
@@ -47,6 +50,48 @@ fu_remote_list_emit_changed (FuRemoteList *self)
 	g_signal_emit (self, signals[SIGNAL_CHANGED], 0);
 }
 
+/* everything about the enabled remotes that ends up in the metadata silo,
+ * including the mtime of the cache file */
+static gchar *
+fu_remote_list_get_enabled_checksum (FuRemoteList *self)
+{
+	g_autoptr(GChecksum) csum = g_checksum_new (G_CHECKSUM_SHA1);
+	for (guint i = 0; i < self->array->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (self->array, i);
+		g_autofree gchar *str = NULL;
+		g_autoptr(GVariant) value = NULL;
+		if (!fwupd_remote_get_enabled (remote))
+			continue;
+		value = g_variant_ref_sink (fwupd_remote_to_variant (remote));
+		str = g_variant_print (value, FALSE);
+		g_checksum_update (csum, (const guchar *) str, -1);
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+static gboolean
+fu_remote_list_reload_cb (gpointer user_data)
+{
+	FuRemoteList *self = FU_REMOTE_LIST (user_data);
+	g_autofree gchar *checksum_old = fu_remote_list_get_enabled_checksum (self);
+	g_autofree gchar *checksum_new = NULL;
+	g_autoptr(GError) error = NULL;
+
+	self->reload_id = 0;
+	if (!fu_remote_list_reload (self, &error))
+		g_warning ("failed to rescan remotes: %s", error->message);
+
+	/* disabled remotes are not in the silo */
+	checksum_new = fu_remote_list_get_enabled_checksum (self);
+	if (g_strcmp0 (checksum_old, checksum_new) == 0) {
+		g_debug ("enabled remotes are unchanged");
+		return G_SOURCE_REMOVE;
+	}
+	fu_remote_list_emit_changed (self);
+	return G_SOURCE_REMOVE;
+}
+
+/* package upgrades touch several files in a row, so only reload once */
 static void
 fu_remote_list_monitor_changed_cb (GFileMonitor *monitor,
 				   GFile *file,
@@ -55,21 +100,22 @@ fu_remote_list_monitor_changed_cb (GFileMonitor *monitor,
 				   gpointer user_data)
 {
 	FuRemoteList *self = FU_REMOTE_LIST (user_data);
-	g_autoptr(GError) error = NULL;
 	g_autofree gchar *filename = g_file_get_path (file);
 	g_debug ("%s changed, reloading all remotes", filename);
-	if (!fu_remote_list_reload (self, &error))
-		g_warning ("failed to rescan remotes: %s", error->message);
-	fu_remote_list_emit_changed (self);
+	if (self->reload_id != 0)
+		g_source_remove (self->reload_id);
+	self->reload_id = g_timeout_add (FU_REMOTE_LIST_RELOAD_DELAY,
+					 fu_remote_list_reload_cb,
+					 self);
 }
 
 static guint64
-_fwupd_remote_get_mtime (FwupdRemote *remote)
+_fwupd_remote_get_mtime_for_filename (const gchar *filename)
 {
 	g_autoptr(GFile) file = NULL;
 	g_autoptr(GFileInfo) info = NULL;
 
-	file = g_file_new_for_path (fwupd_remote_get_filename_cache (remote));
+	file = g_file_new_for_path (filename);
 	if (!g_file_query_exists (file, NULL))
 		return G_MAXUINT64;
 	info = g_file_query_info (file,
@@ -81,6 +127,23 @@ _fwupd_remote_get_mtime (FwupdRemote *remote)
 	return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
 }
 
+static guint64
+_fwupd_remote_get_mtime (FwupdRemote *remote)
+{
+	guint64 mtime;
+	guint64 mtime_sig;
+
+	/* the metadata is not rewritten if only the signature changed */
+	mtime = _fwupd_remote_get_mtime_for_filename (fwupd_remote_get_filename_cache (remote));
+	if (mtime == G_MAXUINT64 ||
+	    fwupd_remote_get_keyring_kind (remote) == FWUPD_KEYRING_KIND_NONE)
+		return mtime;
+	mtime_sig = _fwupd_remote_get_mtime_for_filename (fwupd_remote_get_filename_cache_sig (remote));
+	if (mtime_sig != G_MAXUINT64 && mtime_sig > mtime)
+		return mtime_sig;
+	return mtime;
+}
+
 static gboolean
 fu_remote_list_add_inotify (FuRemoteList *self, const gchar *filename, GError **error)
 {
@@ -500,6 +563,8 @@ static void
 fu_remote_list_finalize (GObject *obj)
 {
 	FuRemoteList *self = FU_REMOTE_LIST (obj);
+	if (self->reload_id != 0)
+		g_source_remove (self->reload_id);
 	if (self->silo != NULL)
 		g_object_unref (self->silo);
 	g_ptr_array_unref (self->array);
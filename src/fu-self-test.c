@@ -10,12 +10,14 @@
 #include <fwupd.h>
 #include <fwupdplugin.h>
 #include <glib-object.h>
+#include <fcntl.h>
 #include <glib/gstdio.h>
 #include <libgcab.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "fu-config.h"
+#include "fu-decompressor.h"
 #include "fu-device-list.h"
 #include "fu-device-private.h"
 #include "fu-engine.h"
@@ -23,6 +25,8 @@
 #include "fu-install-task.h"
 #include "fu-plugin-private.h"
 #include "fu-plugin-list.h"
+#include "fu-metrics.h"
+#include "fu-profile.h"
 #include "fu-progressbar.h"
 #include "fu-hash.h"
 #include "fu-security-attr.h"
@@ -328,6 +332,49 @@ fu_engine_requirements_client_pass_func (gconstpointer user_data)
 	g_assert (ret);
 }
 
+static void
+fu_engine_requirements_client_reuse_func (gconstpointer user_data)
+{
+	gboolean ret;
+	g_autoptr(XbNode) component = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(FuEngineRequest) request = fu_engine_request_new ();
+	g_autoptr(FuInstallTask) task = NULL;
+	g_autoptr(GError) error = NULL;
+	const gchar *xml =
+		"<component>"
+		"  <requires>"
+		"    <client>detach-action</client>"
+		"  </requires>"
+		"</component>";
+
+	silo = xb_silo_new_from_xml (xml, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (silo);
+	component = xb_silo_query_first (silo, "component", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (component);
+
+	/* check this fails */
+	task = fu_install_task_new (NULL, component);
+	ret = fu_engine_check_requirements (engine, request, task,
+					    FWUPD_INSTALL_FLAG_NONE,
+					    &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* the prepared requirements are reused, but not the result */
+	fu_engine_request_set_feature_flags (request,
+					     FWUPD_FEATURE_FLAG_DETACH_ACTION);
+	ret = fu_engine_check_requirements (engine, request, task,
+					    FWUPD_INSTALL_FLAG_NONE,
+					    &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+}
+
 static void
 fu_engine_requirements_version_require_func (gconstpointer user_data)
 {
@@ -996,6 +1043,40 @@ fu_engine_device_parent_func (gconstpointer user_data)
 	g_assert_cmpint (fu_device_get_order (device3), ==, -1);
 }
 
+static void
+fu_engine_device_parent_guid_func (gconstpointer user_data)
+{
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(FuDevice) device3 = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo (engine, silo_empty);
+
+	/* two possible parents */
+	fu_device_set_id (device1, "parent1");
+	fu_device_add_instance_id (device1, "parent-GUID-1");
+	fu_device_convert_instance_ids (device1);
+	fu_engine_add_device (engine, device1);
+	fu_device_set_id (device2, "parent2");
+	fu_device_add_instance_id (device2, "parent-GUID-2");
+	fu_device_convert_instance_ids (device2);
+	fu_engine_add_device (engine, device2);
+
+	/* the first parent GUID wins, not the first device */
+	fu_device_set_id (device3, "child");
+	fu_device_add_instance_id (device3, "child-GUID");
+	fu_device_add_parent_guid (device3, "parent-GUID-2");
+	fu_device_add_parent_guid (device3, "parent-GUID-1");
+	fu_device_convert_instance_ids (device3);
+	fu_engine_add_device (engine, device3);
+	g_assert (fu_device_get_parent (device3) == device2);
+	g_assert_null (fu_device_get_parent (device1));
+	g_assert_null (fu_device_get_parent (device2));
+}
+
 static void
 fu_engine_partial_hash_func (gconstpointer user_data)
 {
@@ -1109,20 +1190,138 @@ fu_engine_device_unlock_func (gconstpointer user_data)
 	g_assert_nonnull (fwupd_device_get_release_default (FWUPD_DEVICE (device)));
 }
 
+static gboolean
+fu_engine_run_job_func_cb (FuEngine *engine, const gchar *device_id,
+			   gpointer user_data, GError **error)
+{
+	guint *cnt = (guint *) user_data;
+	g_assert_cmpstr (device_id, ==, "job_device");
+	(*cnt)++;
+	return TRUE;
+}
+
+static void
+fu_engine_run_job_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GError **error = (GError **) user_data;
+	g_assert_true (fu_engine_run_job_finish (FU_ENGINE (source), res, error));
+	fu_test_loop_quit ();
+}
+
+static void
+fu_engine_run_job_func (gconstpointer user_data)
+{
+	gboolean ret;
+	guint cnt = 0;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* load engine to get FuConfig set up */
+	fu_engine_set_silo (engine, silo_empty);
+	ret = fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* add a dummy device */
+	fu_device_set_id (device, "job_device");
+	fu_device_set_plugin (device, "test");
+	fu_device_add_guid (device, "12345678-1234-1234-1234-123456789012");
+	fu_engine_add_device (engine, device);
+
+	/* the result is always delivered in the main context */
+	fu_engine_run_job_async (engine, fu_device_get_id (device),
+				 fu_engine_run_job_func_cb, &cnt,
+				 fu_engine_run_job_done_cb, &error);
+	fu_test_loop_run_with_timeout (5000);
+	fu_test_loop_quit ();
+	g_assert_no_error (error);
+	g_assert_cmpint (cnt, ==, 1);
+}
+
+static void
+fu_engine_verify_all_device_cb (FuEngine *engine, FuDevice *device,
+				const GError *error, gpointer user_data)
+{
+	guint *cnt = (guint *) user_data;
+
+	/* no plugins are loaded */
+	g_assert_nonnull (error);
+	(*cnt)++;
+}
+
+static void
+fu_engine_verify_all_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GError **error = (GError **) user_data;
+	g_assert_true (fu_engine_verify_all_finish (FU_ENGINE (source), res, error));
+	fu_test_loop_quit ();
+}
+
+static void
+fu_engine_verify_all_func (gconstpointer user_data)
+{
+	gboolean ret;
+	guint cnt = 0;
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(FuDevice) device3 = fu_device_new ();
+	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
+
+	/* load engine to get FuConfig set up */
+	fu_engine_set_silo (engine, silo_empty);
+	ret = fu_engine_load (engine, FU_ENGINE_LOAD_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert_true (ret);
+
+	/* two independent devices, and one that cannot be verified */
+	fu_device_set_id (device1, "verify_device1");
+	fu_device_set_plugin (device1, "test");
+	fu_device_add_guid (device1, "12345678-1234-1234-1234-123456789012");
+	fu_device_add_flag (device1, FWUPD_DEVICE_FLAG_CAN_VERIFY);
+	fu_engine_add_device (engine, device1);
+	fu_device_set_id (device2, "verify_device2");
+	fu_device_set_plugin (device2, "test2");
+	fu_device_add_guid (device2, "12345678-1234-1234-1234-123456789013");
+	fu_device_add_flag (device2, FWUPD_DEVICE_FLAG_CAN_VERIFY);
+	fu_engine_add_device (engine, device2);
+	fu_device_set_id (device3, "verify_device3");
+	fu_device_set_plugin (device3, "test");
+	fu_device_add_guid (device3, "12345678-1234-1234-1234-123456789014");
+	fu_engine_add_device (engine, device3);
+
+	/* each result is reported before the operation completes */
+	fu_engine_verify_all_async (engine, FWUPD_INSTALL_FLAG_NONE,
+				    fu_engine_verify_all_device_cb, &cnt,
+				    fu_engine_verify_all_done_cb, &error);
+	fu_test_loop_run_with_timeout (5000);
+	fu_test_loop_quit ();
+	g_assert_no_error (error);
+	g_assert_cmpint (cnt, ==, 2);
+}
+
 static void
 fu_engine_require_hwid_func (gconstpointer user_data)
 {
 	gboolean ret;
 	g_autofree gchar *filename = NULL;
 	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
 	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
 	g_autoptr(FuEngineRequest) request = fu_engine_request_new ();
 	g_autoptr(FuInstallTask) task = NULL;
 	g_autoptr(GBytes) blob_cab = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) details1 = NULL;
+	g_autoptr(GPtrArray) details2 = NULL;
+	g_autoptr(GPtrArray) details3 = NULL;
 	g_autoptr(XbNode) component = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
 	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_cached = NULL;
 
 #if defined(__s390x__)
 	/* See https://github.com/fwupd/fwupd/issues/318 for more information */
@@ -1147,6 +1346,11 @@ fu_engine_require_hwid_func (gconstpointer user_data)
 	g_assert_no_error (error);
 	g_assert_nonnull (silo);
 
+	/* the same archive is not parsed again */
+	silo_cached = fu_engine_get_silo_from_blob (engine, blob_cab, &error);
+	g_assert_no_error (error);
+	g_assert (silo_cached == silo);
+
 	/* add a dummy device */
 	fu_device_set_id (device, "test_device");
 	fu_device_add_vendor_id (device, "USB:FFFF");
@@ -1172,6 +1376,24 @@ fu_engine_require_hwid_func (gconstpointer user_data)
 	g_assert_cmpstr (error->message, ==,
 			 "no HWIDs matched 9342d47a-1bab-5709-9869-c840b2eac501");
 	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* the details are reused until the devices change */
+	details1 = fu_engine_get_details (engine, request, g_open (filename, O_RDONLY, 0), &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (details1);
+	g_assert_cmpint (details1->len, ==, 1);
+	details2 = fu_engine_get_details (engine, request, g_open (filename, O_RDONLY, 0), &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (details2);
+	g_assert (g_ptr_array_index (details2, 0) == g_ptr_array_index (details1, 0));
+	fu_device_set_id (device2, "test_device2");
+	fu_device_add_guid (device2, "87654321-1234-1234-1234-123456789012");
+	fu_engine_add_device (engine, device2);
+	details3 = fu_engine_get_details (engine, request, g_open (filename, O_RDONLY, 0), &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (details3);
+	g_assert (g_ptr_array_index (details3, 0) != g_ptr_array_index (details1, 0));
 }
 
 static void
@@ -1188,6 +1410,7 @@ fu_engine_downgrade_func (gconstpointer user_data)
 	g_autoptr(GPtrArray) releases_dg = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_up = NULL;
+	g_autoptr(GPtrArray) releases_up2 = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
 
@@ -1341,6 +1564,16 @@ fu_engine_downgrade_func (gconstpointer user_data)
 	rel = FWUPD_RELEASE (g_ptr_array_index (releases_up, 1));
 	g_assert_cmpstr (fwupd_release_get_version (rel), ==, "1.2.4");
 
+	/* the releases are not built again for the same device */
+	releases_up2 = fu_engine_get_upgrades (engine,
+					       request,
+					       fu_device_get_id (device),
+					       &error);
+	g_assert_no_error (error);
+	g_assert (releases_up2 != NULL);
+	g_assert_cmpint (releases_up2->len, ==, 2);
+	g_assert_true (g_ptr_array_index (releases_up2, 1) == (gpointer) rel);
+
 	/* downgrades */
 	releases_dg = fu_engine_get_downgrades (engine,
 						request,
@@ -1987,6 +2220,9 @@ fu_device_list_replug_auto_func (gconstpointer user_data)
 	g_assert (ret);
 	g_assert_false (fu_device_has_flag (device1, FWUPD_DEVICE_FLAG_WAIT_FOR_REPLUG));
 
+	/* returned as soon as the device came back */
+	g_assert_cmpint (fu_device_get_metadata_integer (device2, "ReplugDuration"), <, 1000);
+
 	/* check device2 now has parent too */
 	g_assert (fu_device_get_parent (device2) == parent);
 
@@ -2131,6 +2367,84 @@ fu_device_list_compatible_func (gconstpointer user_data)
 	g_assert (device_old == device1);
 }
 
+static void
+fu_device_list_index_func (gconstpointer user_data)
+{
+	g_autoptr(FuDevice) device1 = fu_device_new ();
+	g_autoptr(FuDevice) device2 = fu_device_new ();
+	g_autoptr(FuDevice) device3 = fu_device_new ();
+	g_autoptr(FuDeviceList) device_list = fu_device_list_new ();
+	FuDevice *device;
+	g_autofree gchar *guid1 = fwupd_guid_hash_string ("baz");
+	g_autofree gchar *guid2 = fwupd_guid_hash_string ("baz-late");
+	g_autoptr(GError) error = NULL;
+
+	/* add two devices */
+	fu_device_set_id (device1, "device1");
+	fu_device_add_instance_id (device1, "foobar");
+	fu_device_convert_instance_ids (device1);
+	fu_device_list_add (device_list, device1);
+	fu_device_set_id (device2, "device2");
+	fu_device_add_instance_id (device2, "baz");
+	fu_device_convert_instance_ids (device2);
+	fu_device_list_add (device_list, device2);
+
+	/* exact and abbreviated ID */
+	device = fu_device_list_get_by_id (device_list,
+					   "99249eb1bd9ef0b6e192b271a8cb6a3090cfec7a",
+					   &error);
+	g_assert_no_error (error);
+	g_assert (device == device1);
+	g_clear_object (&device);
+	device = fu_device_list_get_by_id (device_list, "99249", &error);
+	g_assert_no_error (error);
+	g_assert (device == device1);
+	g_clear_object (&device);
+	device = fu_device_list_get_by_id (device_list, "1a8d", &error);
+	g_assert_no_error (error);
+	g_assert (device == device2);
+	g_clear_object (&device);
+	device = fu_device_list_get_by_id (device_list, "", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert (device == NULL);
+	g_clear_error (&error);
+
+	/* GUID, including one added after the device was added to the list */
+	device = fu_device_list_get_by_guid (device_list, guid1, &error);
+	g_assert_no_error (error);
+	g_assert (device == device2);
+	g_clear_object (&device);
+	fu_device_add_guid (device2, guid2);
+	device = fu_device_list_get_by_guid (device_list, guid2, &error);
+	g_assert_no_error (error);
+	g_assert (device == device2);
+	g_clear_object (&device);
+
+	/* ID changed after the device was added to the list */
+	fu_device_set_id (device2, "device3");
+	device = fu_device_list_get_by_id (device_list, "1a8d", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert (device == NULL);
+	g_clear_error (&error);
+
+	/* replace the device, which matches both the new and the old device */
+	fu_device_set_id (device3, "device1");
+	fu_device_add_instance_id (device3, "foobar");
+	fu_device_convert_instance_ids (device3);
+	fu_device_list_add (device_list, device3);
+	device = fu_device_list_get_by_id (device_list, "99249", &error);
+	g_assert_no_error (error);
+	g_assert (device == device3);
+	g_clear_object (&device);
+
+	/* removed devices are no longer found */
+	fu_device_list_remove (device_list, device3);
+	device = fu_device_list_get_by_id (device_list, "99249", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert (device == NULL);
+	g_clear_error (&error);
+}
+
 static void
 fu_device_list_remove_chain_func (gconstpointer user_data)
 {
@@ -2289,6 +2603,14 @@ fu_plugin_list_func (gconstpointer user_data)
 	plugin = fu_plugin_list_find_by_name (plugin_list, "nope", &error);
 	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
 	g_assert (plugin == NULL);
+	g_clear_error (&error);
+
+	/* remove */
+	fu_plugin_list_remove (plugin_list, plugin1);
+	g_assert_cmpint (plugins->len, ==, 1);
+	plugin = fu_plugin_list_find_by_name (plugin_list, "plugin1", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert (plugin == NULL);
 }
 
 static void
@@ -2300,7 +2622,11 @@ fu_plugin_list_depsolve_func (gconstpointer user_data)
 	g_autoptr(FuPluginList) plugin_list = fu_plugin_list_new ();
 	g_autoptr(FuPlugin) plugin1 = fu_plugin_new ();
 	g_autoptr(FuPlugin) plugin2 = fu_plugin_new ();
+	g_autoptr(FuPluginList) plugin_list2 = fu_plugin_list_new ();
+	g_autoptr(FuPlugin) plugin3 = fu_plugin_new ();
+	g_autoptr(FuPlugin) plugin4 = fu_plugin_new ();
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GError) error_loop = NULL;
 
 	fu_plugin_set_name (plugin1, "plugin1");
 	fu_plugin_set_name (plugin2, "plugin2");
@@ -2319,6 +2645,10 @@ fu_plugin_list_depsolve_func (gconstpointer user_data)
 	g_assert_cmpint (fu_plugin_get_order (plugin), ==, 0);
 	g_assert_false (fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED));
 
+	/* both plugins are now part of the ordering graph */
+	g_assert_true (fu_plugin_list_has_order_rules (plugin_list, plugin1));
+	g_assert_true (fu_plugin_list_has_order_rules (plugin_list, plugin2));
+
 	/* add another rule, then re-depsolve */
 	fu_plugin_add_rule (plugin1, FU_PLUGIN_RULE_CONFLICTS, "plugin2");
 	ret = fu_plugin_list_depsolve (plugin_list, &error);
@@ -2332,6 +2662,151 @@ fu_plugin_list_depsolve_func (gconstpointer user_data)
 	g_assert_no_error (error);
 	g_assert (plugin != NULL);
 	g_assert_true (fu_plugin_has_flag (plugin, FWUPD_PLUGIN_FLAG_DISABLED));
+
+	/* a loop cannot be ordered */
+	fu_plugin_set_name (plugin3, "plugin3");
+	fu_plugin_set_name (plugin4, "plugin4");
+	fu_plugin_list_add (plugin_list2, plugin3);
+	fu_plugin_list_add (plugin_list2, plugin4);
+	fu_plugin_add_rule (plugin3, FU_PLUGIN_RULE_RUN_AFTER, "plugin4");
+	fu_plugin_add_rule (plugin3, FU_PLUGIN_RULE_RUN_BEFORE, "plugin4");
+	ret = fu_plugin_list_depsolve (plugin_list2, &error_loop);
+	g_assert_error (error_loop, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false (ret);
+}
+
+static void
+fu_profile_func (gconstpointer user_data)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuProfile) profile = fu_profile_new ();
+	g_autoptr(GVariant) val = NULL;
+
+	fu_profile_push (profile, "load");
+	fu_profile_push (profile, "startup(%s)", "test");
+	fu_profile_pop (profile);
+	fu_profile_add (profile, "coldplug(test)", 1.5f);
+	fu_profile_pop (profile);
+	fu_profile_push (profile, "coldplug");
+	fu_profile_stop (profile);
+
+	/* ignored after startup */
+	fu_profile_push (profile, "recoldplug");
+	fu_profile_pop (profile);
+
+	str = fu_profile_to_string (profile);
+	g_print ("%s", str);
+	g_assert_nonnull (g_strstr_len (str, -1, "  startup(test): "));
+	g_assert_nonnull (g_strstr_len (str, -1, "  coldplug(test): 1.5ms\n"));
+	g_assert_null (g_strstr_len (str, -1, "recoldplug"));
+	val = fu_profile_to_variant (profile);
+	g_assert_cmpint (g_variant_n_children (val), ==, 4);
+}
+
+static void
+fu_metrics_func (gconstpointer user_data)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuMetrics) metrics = fu_metrics_new ();
+
+	fu_metrics_observe (metrics, "fwupd_dbus_method_duration_seconds", "GetDevices", 0.0005, NULL);
+	fu_metrics_observe (metrics, "fwupd_dbus_method_duration_seconds", "GetDevices", 0.003, "abc");
+	fu_metrics_inc (metrics, "fwupd_plugin_updates", "test", 1);
+	fu_metrics_inc (metrics, "fwupd_plugin_updates", "test", 1);
+	fu_metrics_set (metrics, "fwupd_devices", NULL, 5);
+	fu_metrics_set (metrics, "fwupd_plugin_coldplug_duration_seconds", "a\"b", 1);
+
+	str = fu_metrics_to_string (metrics);
+	g_print ("%s", str);
+	g_assert_nonnull (g_strstr_len (str, -1, "# TYPE fwupd_dbus_method_duration_seconds histogram\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_dbus_method_duration_seconds_bucket{method=\"GetDevices\",le=\"0.001\"} 1\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_dbus_method_duration_seconds_bucket{method=\"GetDevices\",le=\"0.004\"} 2 # {request_id=\"abc\"} 0.003\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_dbus_method_duration_seconds_count{method=\"GetDevices\"} 2\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_plugin_updates_total{plugin=\"test\"} 2\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_plugin_coldplug_duration_seconds{plugin=\"a\\\"b\"} 1\n"));
+	g_assert_nonnull (g_strstr_len (str, -1, "fwupd_devices 5\n"));
+	g_assert_null (g_strstr_len (str, -1, "fwupd_silo_rebuild_duration_seconds"));
+	g_assert_true (g_str_has_suffix (str, "# EOF\n"));
+}
+
+static void
+fu_decompressor_func (gconstpointer user_data)
+{
+	struct {
+		FuDecompressorFormat format;
+		const gchar *data;
+		gsize datasz;
+	} items[] = {
+		{ FU_DECOMPRESSOR_FORMAT_XZ,
+		  "\xfd\x37\x7a\x58\x5a\x00\x00\x04\xe6\xd6\xb4\x46\x04\xc0\x12\x0e"
+		  "\x21\x01\x16\x00\x00\x00\x00\x00\x00\x00\x00\x00\x9d\xc1\x66\xa9"
+		  "\x01\x00\x0d\x3c\x63\x6f\x6d\x70\x6f\x6e\x65\x6e\x74\x73\x2f\x3e"
+		  "\x0a\x00\x00\x00\x94\x70\xa5\x9e\xa9\x45\x3d\xf9\x00\x01\x2e\x0e"
+		  "\x00\x91\x39\xcc\x1f\xb6\xf3\x7d\x01\x00\x00\x00\x00\x04\x59\x5a",
+		  80 },
+		{ FU_DECOMPRESSOR_FORMAT_ZSTD,
+		  "\x28\xb5\x2f\xfd\x24\x0e\x71\x00\x00\x3c\x63\x6f\x6d\x70\x6f\x6e"
+		  "\x65\x6e\x74\x73\x2f\x3e\x0a\xc4\x43\x7b\x33",
+		  27 },
+		{ FU_DECOMPRESSOR_FORMAT_UNKNOWN, NULL, 0 }
+	};
+
+	for (guint i = 0; items[i].data != NULL; i++) {
+		gsize bufsz = 0;
+		gchar buf[64] = { '\0' };
+		gboolean ret;
+		g_autoptr(FuDecompressor) decompressor = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GInputStream) istream = NULL;
+		g_autoptr(GInputStream) stream = NULL;
+
+		if (!fu_decompressor_format_supported (items[i].format)) {
+			decompressor = fu_decompressor_new (items[i].format, &error);
+			g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+			g_assert_null (decompressor);
+			continue;
+		}
+		decompressor = fu_decompressor_new (items[i].format, &error);
+		g_assert_no_error (error);
+		g_assert_nonnull (decompressor);
+		istream = g_memory_input_stream_new_from_data (items[i].data,
+							       items[i].datasz,
+							       NULL);
+		stream = g_converter_input_stream_new (istream, G_CONVERTER (decompressor));
+		ret = g_input_stream_read_all (stream, buf, sizeof(buf) - 1,
+					       &bufsz, NULL, &error);
+		g_assert_no_error (error);
+		g_assert_true (ret);
+		g_assert_cmpstr (buf, ==, "<components/>\n");
+
+		/* truncated */
+		g_clear_object (&stream);
+		g_clear_object (&istream);
+		g_converter_reset (G_CONVERTER (decompressor));
+		istream = g_memory_input_stream_new_from_data (items[i].data,
+							       items[i].datasz - 4,
+							       NULL);
+		stream = g_converter_input_stream_new (istream, G_CONVERTER (decompressor));
+		ret = g_input_stream_read_all (stream, buf, sizeof(buf) - 1,
+					       &bufsz, NULL, &error);
+		g_assert_nonnull (error);
+		g_assert_false (ret);
+	}
+}
+
+static void
+fu_engine_request_id_func (gconstpointer user_data)
+{
+	g_autoptr(FuEngineRequest) request1 = fu_engine_request_new ();
+	g_autoptr(FuEngineRequest) request2 = fu_engine_request_new ();
+
+	/* assigned by the daemon by default */
+	g_assert_nonnull (fu_engine_request_get_id (request1));
+	g_assert_cmpstr (fu_engine_request_get_id (request1), !=,
+			 fu_engine_request_get_id (request2));
+	fu_engine_request_set_id (request2, "abc");
+	g_assert_cmpstr (fu_engine_request_get_id (request2), ==, "abc");
+	g_assert_cmpfloat (fu_engine_request_get_elapsed (request2), >=, 0.f);
 }
 
 static void
@@ -2404,12 +2879,16 @@ fu_plugin_module_func (gconstpointer user_data)
 	g_autofree gchar *mapped_file_fn = NULL;
 	g_autofree gchar *pending_cap = NULL;
 	g_autofree gchar *history_db = NULL;
+	g_autofree gchar *plan_dir = NULL;
+	g_autofree gchar *plan_fn = NULL;
+	g_autofree gchar *plan_plugin = NULL;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuDevice) device2 = NULL;
 	g_autoptr(FuDevice) device3 = NULL;
 	g_autoptr(FuEngine) engine = fu_engine_new (FU_APP_FLAGS_NONE);
 	g_autoptr(FuHistory) history = NULL;
 	g_autoptr(GBytes) blob_cab = NULL;
+	g_autoptr(GKeyFile) plan_kf = g_key_file_new ();
 	g_autoptr(GMappedFile) mapped_file = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new ();
 
@@ -2483,6 +2962,16 @@ fu_plugin_module_func (gconstpointer user_data)
 	/* save this; we'll need to delete it later */
 	pending_cap = g_strdup (fwupd_release_get_filename (release));
 
+	/* the offline plan only needs the one plugin */
+	plan_dir = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	plan_fn = g_build_filename (plan_dir, "offline.plan", NULL);
+	ret = g_key_file_load_from_file (plan_kf, plan_fn, G_KEY_FILE_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	plan_plugin = g_key_file_get_string (plan_kf, fu_device_get_id (device), "Plugin", &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (plan_plugin, ==, "test");
+
 	/* lets do this online */
 	fu_engine_add_device (engine, device);
 	fu_engine_add_plugin (engine, self->plugin);
@@ -2491,6 +2980,7 @@ fu_plugin_module_func (gconstpointer user_data)
 	g_assert_no_error (error);
 	g_assert (ret);
 	g_assert_cmpint (cnt, ==, 4);
+	g_assert_false (g_file_test (plan_fn, G_FILE_TEST_EXISTS));
 
 	/* check the new version */
 	g_assert_cmpstr (fu_device_get_version (device), ==, "1.2.3");
@@ -2533,11 +3023,17 @@ fu_history_func (gconstpointer user_data)
 	GError *error = NULL;
 	GPtrArray *checksums;
 	gboolean ret;
+	gboolean success = FALSE;
+	guint64 timestamp = 0;
+	guint retry_delay = 0;
 	FuDevice *device;
 	FwupdRelease *release;
+	GPtrArray *devices_filtered;
 	g_autoptr(FuDevice) device_found = NULL;
 	g_autoptr(FuHistory) history = NULL;
 	g_autoptr(GPtrArray) approved_firmware = NULL;
+	g_autoptr(GPtrArray) checksums_cache = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) checksums_found = NULL;
 	g_autofree gchar *dirname = NULL;
 	g_autofree gchar *filename = NULL;
 
@@ -2617,6 +3113,26 @@ fu_history_func (gconstpointer user_data)
 	g_assert (device_found != NULL);
 	g_object_unref (device_found);
 
+	/* filter by state, modified time and limit */
+	devices_filtered = fu_history_get_devices_filtered (history, FWUPD_UPDATE_STATE_FAILED,
+							    0, 1, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices_filtered);
+	g_assert_cmpint (devices_filtered->len, ==, 1);
+	g_ptr_array_unref (devices_filtered);
+	devices_filtered = fu_history_get_devices_filtered (history, FWUPD_UPDATE_STATE_PENDING,
+							    0, 0, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices_filtered);
+	g_assert_cmpint (devices_filtered->len, ==, 0);
+	g_ptr_array_unref (devices_filtered);
+	devices_filtered = fu_history_get_devices_filtered (history, FWUPD_UPDATE_STATE_UNKNOWN,
+							    456, 0, &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (devices_filtered);
+	g_assert_cmpint (devices_filtered->len, ==, 0);
+	g_ptr_array_unref (devices_filtered);
+
 	/* remove device */
 	ret = fu_history_remove_device (history, device, &error);
 	g_assert_no_error (error);
@@ -2645,6 +3161,182 @@ fu_history_func (gconstpointer user_data)
 	g_assert_cmpint (approved_firmware->len, ==, 2);
 	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 0), ==, "foo");
 	g_assert_cmpstr (g_ptr_array_index (approved_firmware, 1), ==, "bar");
+
+	/* background verification result, replacing the old one */
+	ret = fu_history_get_verify_result (history, "foo", NULL, NULL, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert (!ret);
+	g_clear_error (&error);
+	ret = fu_history_add_verify_result (history, "foo", "abc", FALSE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_add_verify_result (history, "foo", "def", TRUE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_get_verify_result (history, "foo", &timestamp, &success, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (success);
+	g_assert_cmpint (timestamp, >, 0);
+
+	/* cached checksums are only returned for the same device state */
+	g_ptr_array_add (checksums_cache, g_strdup ("abc"));
+	g_ptr_array_add (checksums_cache, g_strdup ("def"));
+	ret = fu_history_set_verify_cache (history, "foo", "1.2.3|0", checksums_cache, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	checksums_found = fu_history_get_verify_cache (history, "foo", "1.2.4|0", &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null (checksums_found);
+	g_clear_error (&error);
+	checksums_found = fu_history_get_verify_cache (history, "foo", "1.2.3|0", &error);
+	g_assert_no_error (error);
+	g_assert_nonnull (checksums_found);
+	g_assert_cmpint (checksums_found->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (checksums_found, 1), ==, "def");
+	ret = fu_history_remove_verify_cache (history, "foo", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* learned retry delay, replacing the old one */
+	ret = fu_history_set_retry_delay (history, "guid", 100, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_set_retry_delay (history, "guid", 50, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_get_retry_delay (history, "guid", &retry_delay, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (retry_delay, ==, 50);
+}
+
+static void
+fu_history_transaction_func (gconstpointer user_data)
+{
+	gboolean ret;
+	g_autofree gchar *dirname = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuDevice) device = fu_device_new ();
+	g_autoptr(FuDevice) device_found = NULL;
+	g_autoptr(FuHistory) history = fu_history_new ();
+	g_autoptr(FwupdRelease) release = fwupd_release_new ();
+	g_autoptr(GError) error = NULL;
+
+	/* delete the database */
+	dirname = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	if (!g_file_test (dirname, G_FILE_TEST_IS_DIR))
+		return;
+	filename = g_build_filename (dirname, "pending.db", NULL);
+	g_unlink (filename);
+	fu_history_set_write_ahead_log (history, TRUE);
+
+	/* nested transactions are only committed at the end */
+	ret = fu_history_transaction_begin (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_transaction_begin (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fu_device_set_id (device, "self-test");
+	fu_device_set_update_state (device, FWUPD_UPDATE_STATE_PENDING);
+	fwupd_release_set_version (release, "3.0.2");
+	ret = fu_history_add_device (history, device, release, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fu_device_set_update_state (device, FWUPD_UPDATE_STATE_SUCCESS);
+	ret = fu_history_modify_device (history, device, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_transaction_commit (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = fu_history_transaction_commit (history, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* not in a transaction */
+	ret = fu_history_transaction_commit (history, &error);
+	g_assert_error (error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* the cached statements were used with the latest data */
+	device_found = fu_history_get_device_by_id (history, fu_device_get_id (device), &error);
+	g_assert_no_error (error);
+	g_assert (device_found != NULL);
+	g_assert_cmpint (fu_device_get_update_state (device_found), ==, FWUPD_UPDATE_STATE_SUCCESS);
+}
+
+static void
+fu_history_prune_func (gconstpointer user_data)
+{
+	gboolean ret;
+	g_autofree gchar *dirname = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuHistory) history = fu_history_new ();
+	g_autoptr(FwupdRelease) release = fwupd_release_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	struct {
+		const gchar *id;
+		guint64 modified;
+		FwupdUpdateState state;
+		gboolean reported;
+	} entries[] = {
+		{ "prune-1", 1000, FWUPD_UPDATE_STATE_SUCCESS, TRUE },
+		{ "prune-2", 2000, FWUPD_UPDATE_STATE_FAILED, FALSE },
+		{ "prune-3", 3000, FWUPD_UPDATE_STATE_SUCCESS, TRUE },
+		{ "prune-4", 500, FWUPD_UPDATE_STATE_PENDING, FALSE },
+	};
+
+	/* delete the database */
+	dirname = fu_common_get_path (FU_PATH_KIND_LOCALSTATEDIR_PKG);
+	if (!g_file_test (dirname, G_FILE_TEST_IS_DIR))
+		return;
+	filename = g_build_filename (dirname, "pending.db", NULL);
+	g_unlink (filename);
+
+	fwupd_release_set_version (release, "3.0.2");
+	for (guint i = 0; i < G_N_ELEMENTS (entries); i++) {
+		g_autoptr(FuDevice) device = fu_device_new ();
+		fu_device_set_id (device, entries[i].id);
+		fu_device_set_modified (device, entries[i].modified);
+		fu_device_set_update_state (device, entries[i].state);
+		if (entries[i].reported)
+			fu_device_add_flag (device, FWUPD_DEVICE_FLAG_REPORTED);
+		ret = fu_history_add_device (history, device, release, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+
+	/* only the newest reported entry is kept */
+	ret = fu_history_prune (history, 1, 0, TRUE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_history_get_devices (history, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (devices->len, ==, 3);
+	g_ptr_array_unref (devices);
+
+	/* unreported too */
+	ret = fu_history_prune (history, 1, 0, FALSE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_history_get_devices (history, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (devices->len, ==, 2);
+	g_ptr_array_unref (devices);
+
+	/* everything is old, but the pending update is still required */
+	ret = fu_history_prune (history, 0, 1, FALSE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	devices = fu_history_get_devices (history, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (devices->len, ==, 1);
+	g_assert_cmpint (fu_device_get_update_state (g_ptr_array_index (devices, 0)), ==,
+			 FWUPD_UPDATE_STATE_PENDING);
 }
 
 static GBytes *
@@ -3039,6 +3731,7 @@ main (int argc, char **argv)
 	g_setenv ("FWUPD_SYSFSFWDIR", TESTDATADIR_SRC, TRUE);
 	g_setenv ("FWUPD_OFFLINE_TRIGGER", "/tmp/fwupd-self-test/system-update", TRUE);
 	g_setenv ("FWUPD_LOCALSTATEDIR", "/tmp/fwupd-self-test/var", TRUE);
+	g_setenv ("FWUPD_VIRTUAL_CLOCK", "1", TRUE);
 
 	/* ensure empty tree */
 	fu_self_test_mkroot ();
@@ -3073,10 +3766,16 @@ main (int argc, char **argv)
 			      fu_device_list_compatible_func);
 	g_test_add_data_func ("/fwupd/device-list{remove-chain}", self,
 			      fu_device_list_remove_chain_func);
+	g_test_add_data_func ("/fwupd/device-list{index}", self,
+			      fu_device_list_index_func);
 	g_test_add_data_func ("/fwupd/install-task{compare}", self,
 			      fu_install_task_compare_func);
 	g_test_add_data_func ("/fwupd/engine{device-unlock}", self,
 			      fu_engine_device_unlock_func);
+	g_test_add_data_func ("/fwupd/engine{run-job}", self,
+			      fu_engine_run_job_func);
+	g_test_add_data_func ("/fwupd/engine{verify-all}", self,
+			      fu_engine_verify_all_func);
 	g_test_add_data_func ("/fwupd/engine{multiple-releases}", self,
 			      fu_engine_multiple_rels_func);
 	g_test_add_data_func ("/fwupd/engine{history-success}", self,
@@ -3107,6 +3806,8 @@ main (int argc, char **argv)
 			      fu_engine_requirements_client_invalid_func);
 	g_test_add_data_func ("/fwupd/engine{requirements-client-pass}", self,
 			      fu_engine_requirements_client_pass_func);
+	g_test_add_data_func ("/fwupd/engine{requirements-client-reuse}", self,
+			      fu_engine_requirements_client_reuse_func);
 	g_test_add_data_func ("/fwupd/engine{requirements-version-require}", self,
 			      fu_engine_requirements_version_require_func);
 	g_test_add_data_func ("/fwupd/engine{requirements-parent-device}", self,
@@ -3127,6 +3828,8 @@ main (int argc, char **argv)
 			      fu_engine_requirements_version_format_func);
 	g_test_add_data_func ("/fwupd/engine{device-auto-parent}", self,
 			      fu_engine_device_parent_func);
+	g_test_add_data_func ("/fwupd/engine{device-parent-guid}", self,
+			      fu_engine_device_parent_guid_func);
 	g_test_add_data_func ("/fwupd/engine{install-duration}", self,
 			      fu_engine_install_duration_func);
 	g_test_add_data_func ("/fwupd/engine{generate-md}", self,
@@ -3137,8 +3840,20 @@ main (int argc, char **argv)
 			      fu_plugin_composite_func);
 	g_test_add_data_func ("/fwupd/history", self,
 			      fu_history_func);
+	g_test_add_data_func ("/fwupd/history{transaction}", self,
+			      fu_history_transaction_func);
+	g_test_add_data_func ("/fwupd/history{prune}", self,
+			      fu_history_prune_func);
 	g_test_add_data_func ("/fwupd/history{migrate}", self,
 			      fu_history_migrate_func);
+	g_test_add_data_func ("/fwupd/profile", self,
+			      fu_profile_func);
+	g_test_add_data_func ("/fwupd/metrics", self,
+			      fu_metrics_func);
+	g_test_add_data_func ("/fwupd/decompressor", self,
+			      fu_decompressor_func);
+	g_test_add_data_func ("/fwupd/engine{request-id}", self,
+			      fu_engine_request_id_func);
 	g_test_add_data_func ("/fwupd/plugin-list", self,
 			      fu_plugin_list_func);
 	g_test_add_data_func ("/fwupd/plugin-list{depsolve}", self,
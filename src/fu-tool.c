@@ -62,6 +62,7 @@ struct FuUtilPrivate {
 	gboolean		 enable_json_state;
 	FwupdInstallFlags	 flags;
 	gboolean		 show_all;
+	gboolean		 show_stats;
 	gboolean		 disable_ssl_strict;
 	/* only valid in update and downgrade */
 	FuUtilOperation		 current_operation;
@@ -322,9 +323,14 @@ static gboolean
 fu_util_get_plugins (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	GPtrArray *plugins;
+	FuEngineLoadFlags flags = FU_ENGINE_LOAD_FLAG_NONE;
+
+	/* the runner statistics are only useful after the devices are added */
+	if (priv->show_stats)
+		flags |= FU_ENGINE_LOAD_FLAG_COLDPLUG | FU_ENGINE_LOAD_FLAG_HWINFO;
 
 	/* load engine */
-	if (!fu_util_start_engine (priv, FU_ENGINE_LOAD_FLAG_NONE, error))
+	if (!fu_util_start_engine (priv, flags, error))
 		return FALSE;
 
 	/* print */
@@ -333,7 +339,27 @@ fu_util_get_plugins (FuUtilPrivate *priv, gchar **values, GError **error)
 	for (guint i = 0; i < plugins->len; i++) {
 		FuPlugin *plugin = g_ptr_array_index (plugins, i);
 		g_autofree gchar *str = fu_util_plugin_to_string (FWUPD_PLUGIN (plugin), 0);
-		g_print ("%s\n", str);
+		g_print ("%s", str);
+		if (priv->show_stats) {
+			GType gtype = fu_plugin_get_device_gtype (plugin);
+			guint64 calls = 0;
+			guint64 cputime = 0;
+			g_autoptr(GString) stats = g_string_new (NULL);
+			g_autofree gchar *cputime_str = NULL;
+
+			fu_plugin_get_runner_stats (plugin, &calls, &cputime);
+			fu_common_string_append_ku (stats, 1, "RunnerCalls", calls);
+			cputime_str = g_strdup_printf ("%.3fms", (gdouble) cputime / 1000.0);
+			fu_common_string_append_kv (stats, 1, "RunnerCpuTime", cputime_str);
+
+			/* only counted when run with GOBJECT_DEBUG=instance-count */
+			if (gtype != G_TYPE_INVALID && g_type_get_instance_count (gtype) > 0) {
+				fu_common_string_append_ku (stats, 1, "DeviceInstances",
+							    (guint64) g_type_get_instance_count (gtype));
+			}
+			g_print ("%s", stats->str);
+		}
+		g_print ("\n");
 	}
 	if (plugins->len == 0) {
 		/* TRANSLATORS: nothing found */
@@ -343,6 +369,25 @@ fu_util_get_plugins (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_util_get_profile (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	g_autofree gchar *str = NULL;
+
+	/* load engine, doing everything the daemon would do */
+	if (!fu_util_start_engine (priv,
+				   FU_ENGINE_LOAD_FLAG_COLDPLUG |
+				   FU_ENGINE_LOAD_FLAG_HWINFO |
+				   FU_ENGINE_LOAD_FLAG_REMOTES,
+				   error))
+		return FALSE;
+
+	/* print */
+	str = fu_profile_to_string (fu_engine_get_profile (priv->engine));
+	g_print ("%s", str);
+	return TRUE;
+}
+
 static gboolean
 fu_util_filter_device (FuUtilPrivate *priv, FwupdDevice *dev)
 {
@@ -698,6 +743,13 @@ fu_util_update_device_changed_cb (FwupdClient *client,
 {
 	g_autofree gchar *str = NULL;
 
+	/* the engine emits real devices, so the transfer speed is available */
+	if (FU_IS_DEVICE (device)) {
+		fu_progressbar_set_transfer (priv->progressbar,
+					     fu_device_get_progress_speed (FU_DEVICE (device)),
+					     fu_device_get_progress_remaining (FU_DEVICE (device)));
+	}
+
 	/* allowed to set whenever the device has changed */
 	if (fwupd_device_has_flag (device, FWUPD_DEVICE_FLAG_NEEDS_SHUTDOWN))
 		priv->completion_flags |= FWUPD_DEVICE_FLAG_NEEDS_SHUTDOWN;
@@ -1838,7 +1890,10 @@ fu_util_get_firmware_types (FuUtilPrivate *priv, gchar **values, GError **error)
 	g_autoptr(GPtrArray) firmware_types = NULL;
 
 	/* load engine */
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY, error))
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
 		return FALSE;
 
 	firmware_types = fu_engine_get_firmware_gtype_ids (priv->engine);
@@ -1882,10 +1937,113 @@ fu_util_prompt_for_firmware_type (FuUtilPrivate *priv, GError **error)
 	return g_strdup (g_ptr_array_index (firmware_types, idx - 1));
 }
 
+static FuFirmware *
+fu_util_firmware_parse_blob (FuUtilPrivate *priv,
+			     GBytes *blob,
+			     const gchar *firmware_type,
+			     GError **error)
+{
+	GType gtype;
+	g_autoptr(FuFirmware) firmware = NULL;
+
+	gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type);
+	if (gtype == G_TYPE_INVALID) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_FOUND,
+			     "GType %s not supported", firmware_type);
+		return NULL;
+	}
+	firmware = g_object_new (gtype, NULL);
+	if (!fu_firmware_parse (firmware, blob, priv->flags, error))
+		return NULL;
+	return g_steal_pointer (&firmware);
+}
+
+static gchar *
+fu_util_firmware_image_get_filename (FuFirmwareImage *img, guint idx)
+{
+	if (fu_firmware_image_get_filename (img) != NULL)
+		return g_strdup (fu_firmware_image_get_filename (img));
+	if (fu_firmware_image_get_id (img) != NULL)
+		return g_strdup_printf ("id-%s.fw", fu_firmware_image_get_id (img));
+	if (fu_firmware_image_get_idx (img) != 0x0)
+		return g_strdup_printf ("idx-0x%x.fw", (guint) fu_firmware_image_get_idx (img));
+	return g_strdup_printf ("img-0x%x.fw", idx);
+}
+
+/* streamed rather than building the whole image in memory */
+static gboolean
+fu_util_firmware_write_filename (FuFirmware *firmware, const gchar *filename, GError **error)
+{
+	g_autoptr(GFile) file = g_file_new_for_path (filename);
+	g_autoptr(GFile) file_parent = g_file_get_parent (file);
+
+	if (!g_file_query_exists (file_parent, NULL)) {
+		if (!g_file_make_directory_with_parents (file_parent, NULL, error))
+			return FALSE;
+	}
+	return fu_firmware_write_file (firmware, file, error);
+}
+
+static FuFirmware *
+fu_util_firmware_build_xml (FuUtilPrivate *priv, GBytes *blob_src, GError **error)
+{
+	GType gtype = FU_TYPE_FIRMWARE;
+	const gchar *tmp;
+	g_autoptr(FuFirmware) firmware = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new ();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* parse XML */
+	if (!xb_builder_source_load_bytes (source, blob_src,
+					   XB_BUILDER_SOURCE_FLAG_NONE,
+					   error)) {
+		g_prefix_error (error, "could not parse XML: ");
+		return NULL;
+	}
+	xb_builder_import_source (builder, source);
+	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (silo == NULL)
+		return NULL;
+
+	/* create FuFirmware of specific GType */
+	n = xb_silo_query_first (silo, "firmware", error);
+	if (n == NULL)
+		return NULL;
+	tmp = xb_node_get_attr (n, "gtype");
+	if (tmp != NULL) {
+		gtype = g_type_from_name (tmp);
+		if (gtype == G_TYPE_INVALID) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "GType %s not registered", tmp);
+			return NULL;
+		}
+	}
+	tmp = xb_node_get_attr (n, "id");
+	if (tmp != NULL) {
+		gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, tmp);
+		if (gtype == G_TYPE_INVALID) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "GType %s not supported", tmp);
+			return NULL;
+		}
+	}
+	firmware = g_object_new (gtype, NULL);
+	if (!fu_firmware_build (firmware, n, error))
+		return NULL;
+	return g_steal_pointer (&firmware);
+}
+
 static gboolean
 fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	GType gtype;
 	g_autoptr(GBytes) blob = NULL;
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autofree gchar *firmware_type = NULL;
@@ -1904,12 +2062,15 @@ fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type = g_strdup (values[1]);
 
 	/* load file */
-	blob = fu_common_get_contents_bytes (values[0], error);
+	blob = fu_common_get_contents_mapped (values[0], error);
 	if (blob == NULL)
 		return FALSE;
 
 	/* load engine */
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY, error))
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
 		return FALSE;
 
 	/* find the GType to use */
@@ -1917,16 +2078,8 @@ fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type = fu_util_prompt_for_firmware_type (priv, error);
 	if (firmware_type == NULL)
 		return FALSE;
-	gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type);
-	if (gtype == G_TYPE_INVALID) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_NOT_FOUND,
-			     "GType %s not supported", firmware_type);
-		return FALSE;
-	}
-	firmware = g_object_new (gtype, NULL);
-	if (!fu_firmware_parse (firmware, blob, priv->flags, error))
+	firmware = fu_util_firmware_parse_blob (priv, blob, firmware_type, error);
+	if (firmware == NULL)
 		return FALSE;
 	str = fu_firmware_to_string (firmware);
 	g_print ("%s", str);
@@ -1936,7 +2089,6 @@ fu_util_firmware_parse (FuUtilPrivate *priv, gchar **values, GError **error)
 static gboolean
 fu_util_firmware_extract (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	GType gtype;
 	g_autofree gchar *firmware_type = NULL;
 	g_autofree gchar *str = NULL;
 	g_autoptr(FuFirmware) firmware = NULL;
@@ -1955,12 +2107,15 @@ fu_util_firmware_extract (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type = g_strdup (values[1]);
 
 	/* load file */
-	blob = fu_common_get_contents_bytes (values[0], error);
+	blob = fu_common_get_contents_mapped (values[0], error);
 	if (blob == NULL)
 		return FALSE;
 
 	/* load engine */
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY, error))
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
 		return FALSE;
 
 	/* find the GType to use */
@@ -1968,16 +2123,8 @@ fu_util_firmware_extract (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type = fu_util_prompt_for_firmware_type (priv, error);
 	if (firmware_type == NULL)
 		return FALSE;
-	gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type);
-	if (gtype == G_TYPE_INVALID) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_NOT_FOUND,
-			     "GType %s not supported", firmware_type);
-		return FALSE;
-	}
-	firmware = g_object_new (gtype, NULL);
-	if (!fu_firmware_parse (firmware, blob, priv->flags, error))
+	firmware = fu_util_firmware_parse_blob (priv, blob, firmware_type, error);
+	if (firmware == NULL)
 		return FALSE;
 	str = fu_firmware_to_string (firmware);
 	g_print ("%s", str);
@@ -1993,15 +2140,7 @@ fu_util_firmware_extract (FuUtilPrivate *priv, gchar **values, GError **error)
 			continue;
 
 		/* use suitable filename */
-		if (fu_firmware_image_get_filename (img) != NULL) {
-			fn = g_strdup (fu_firmware_image_get_filename (img));
-		} else if (fu_firmware_image_get_id (img) != NULL) {
-			fn = g_strdup_printf ("id-%s.fw", fu_firmware_image_get_id (img));
-		} else if (fu_firmware_image_get_idx (img) != 0x0) {
-			fn = g_strdup_printf ("idx-0x%x.fw", (guint) fu_firmware_image_get_idx (img));
-		} else {
-			fn = g_strdup_printf ("img-0x%x.fw", i);
-		}
+		fn = fu_util_firmware_image_get_filename (img, i);
 		/* TRANSLATORS: decompressing images from a container firmware */
 		g_print ("%s : %s\n", _("Writing file:"), fn);
 		if (!fu_common_set_contents_bytes (fn, blob_img, error))
@@ -2015,17 +2154,11 @@ fu_util_firmware_extract (FuUtilPrivate *priv, gchar **values, GError **error)
 static gboolean
 fu_util_firmware_build (FuUtilPrivate *priv, gchar **values, GError **error)
 {
-	GType gtype = FU_TYPE_FIRMWARE;
-	const gchar *tmp;
 	g_autofree gchar *str = NULL;
 	g_autoptr(FuFirmware) firmware = NULL;
 	g_autoptr(FuFirmware) firmware_dst = NULL;
 	g_autoptr(GBytes) blob_dst = NULL;
 	g_autoptr(GBytes) blob_src = NULL;
-	g_autoptr(XbBuilder) builder = xb_builder_new ();
-	g_autoptr(XbBuilderSource) source = xb_builder_source_new ();
-	g_autoptr(XbNode) n = NULL;
-	g_autoptr(XbSilo) silo = NULL;
 
 	/* check args */
 	if (g_strv_length (values) != 2) {
@@ -2042,49 +2175,15 @@ fu_util_firmware_build (FuUtilPrivate *priv, gchar **values, GError **error)
 		return FALSE;
 
 	/* load engine */
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY, error))
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
 		return FALSE;
 
 	/* parse XML */
-	if (!xb_builder_source_load_bytes (source, blob_src,
-					   XB_BUILDER_SOURCE_FLAG_NONE,
-					   error)) {
-		g_prefix_error (error, "could not parse XML: ");
-		return FALSE;
-	}
-	xb_builder_import_source (builder, source);
-	silo = xb_builder_compile (builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
-	if (silo == NULL)
-		return FALSE;
-
-	/* create FuFirmware of specific GType */
-	n = xb_silo_query_first (silo, "firmware", error);
-	if (n == NULL)
-		return FALSE;
-	tmp = xb_node_get_attr (n, "gtype");
-	if (tmp != NULL) {
-		gtype = g_type_from_name (tmp);
-		if (gtype == G_TYPE_INVALID) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_NOT_FOUND,
-				     "GType %s not registered", tmp);
-			return FALSE;
-		}
-	}
-	tmp = xb_node_get_attr (n, "id");
-	if (tmp != NULL) {
-		gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, tmp);
-		if (gtype == G_TYPE_INVALID) {
-			g_set_error (error,
-				     G_IO_ERROR,
-				     G_IO_ERROR_NOT_FOUND,
-				     "GType %s not supported", tmp);
-			return FALSE;
-		}
-	}
-	firmware = g_object_new (gtype, NULL);
-	if (!fu_firmware_build (firmware, n, error))
+	firmware = fu_util_firmware_build_xml (priv, blob_src, error);
+	if (firmware == NULL)
 		return FALSE;
 
 	/* write new file */
@@ -2095,7 +2194,7 @@ fu_util_firmware_build (FuUtilPrivate *priv, gchar **values, GError **error)
 		return FALSE;
 
 	/* show what we wrote */
-	firmware_dst = g_object_new (gtype, NULL);
+	firmware_dst = g_object_new (G_OBJECT_TYPE (firmware), NULL);
 	if (!fu_firmware_parse (firmware_dst, blob_dst, priv->flags, error))
 		return FALSE;
 	str = fu_firmware_to_string (firmware_dst);
@@ -2109,14 +2208,12 @@ static gboolean
 fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	GType gtype_dst;
-	GType gtype_src;
 	g_autofree gchar *firmware_type_dst = NULL;
 	g_autofree gchar *firmware_type_src = NULL;
 	g_autofree gchar *str_dst = NULL;
 	g_autofree gchar *str_src = NULL;
 	g_autoptr(FuFirmware) firmware_dst = NULL;
 	g_autoptr(FuFirmware) firmware_src = NULL;
-	g_autoptr(GBytes) blob_dst = NULL;
 	g_autoptr(GBytes) blob_src = NULL;
 	g_autoptr(GPtrArray) images = NULL;
 
@@ -2135,12 +2232,15 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type_dst = g_strdup (values[3]);
 
 	/* load file */
-	blob_src = fu_common_get_contents_bytes (values[0], error);
+	blob_src = fu_common_get_contents_mapped (values[0], error);
 	if (blob_src == NULL)
 		return FALSE;
 
 	/* load engine */
-	if (!fu_engine_load (priv->engine, FU_ENGINE_LOAD_FLAG_READONLY, error))
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
 		return FALSE;
 
 	/* find the GType to use */
@@ -2152,16 +2252,8 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 		firmware_type_dst = fu_util_prompt_for_firmware_type (priv, error);
 	if (firmware_type_dst == NULL)
 		return FALSE;
-	gtype_src = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type_src);
-	if (gtype_src == G_TYPE_INVALID) {
-		g_set_error (error,
-			     G_IO_ERROR,
-			     G_IO_ERROR_NOT_FOUND,
-			     "GType %s not supported", firmware_type_src);
-		return FALSE;
-	}
-	firmware_src = g_object_new (gtype_src, NULL);
-	if (!fu_firmware_parse (firmware_src, blob_src, priv->flags, error))
+	firmware_src = fu_util_firmware_parse_blob (priv, blob_src, firmware_type_src, error);
+	if (firmware_src == NULL)
 		return FALSE;
 	gtype_dst = fu_engine_get_firmware_gtype_by_id (priv->engine, firmware_type_dst);
 	if (gtype_dst == G_TYPE_INVALID) {
@@ -2183,10 +2275,7 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* write new file */
-	blob_dst = fu_firmware_write (firmware_dst, error);
-	if (blob_dst == NULL)
-		return FALSE;
-	if (!fu_common_set_contents_bytes (values[1], blob_dst, error))
+	if (!fu_util_firmware_write_filename (firmware_dst, values[1], error))
 		return FALSE;
 	str_dst = fu_firmware_to_string (firmware_dst);
 	g_print ("%s", str_dst);
@@ -2195,6 +2284,364 @@ fu_util_firmware_convert (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+typedef struct {
+	gchar		**values;	/* command, then arguments */
+	GPtrArray	*filenames;	/* files written */
+	GError		*error;
+	gdouble		 elapsed;
+} FuUtilBatchJob;
+
+static void
+fu_util_batch_job_free (FuUtilBatchJob *job)
+{
+	g_strfreev (job->values);
+	g_ptr_array_unref (job->filenames);
+	if (job->error != NULL)
+		g_error_free (job->error);
+	g_free (job);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuUtilBatchJob, fu_util_batch_job_free)
+
+static gboolean
+fu_util_batch_job_check_args (FuUtilBatchJob *job, guint min, guint max, GError **error)
+{
+	guint len = g_strv_length (job->values) - 1;
+	if (len < min || len > max) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INVALID_ARGS,
+			     "Invalid arguments: %s requires %u-%u arguments, got %u",
+			     job->values[0], min, max, len);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* runs in a worker thread, so must never prompt or print */
+static gboolean
+fu_util_batch_job_run (FuUtilPrivate *priv, FuUtilBatchJob *job, GError **error)
+{
+	const gchar *cmd = job->values[0];
+	g_autoptr(FuFirmware) firmware = NULL;
+	g_autoptr(GBytes) blob = NULL;
+
+	if (g_strcmp0 (cmd, "firmware-parse") == 0) {
+		if (!fu_util_batch_job_check_args (job, 2, 2, error))
+			return FALSE;
+		blob = fu_common_get_contents_mapped (job->values[1], error);
+		if (blob == NULL)
+			return FALSE;
+		firmware = fu_util_firmware_parse_blob (priv, blob, job->values[2], error);
+		return firmware != NULL;
+	}
+	if (g_strcmp0 (cmd, "firmware-extract") == 0) {
+		const gchar *dirname = ".";
+		g_autoptr(GPtrArray) images = NULL;
+		if (!fu_util_batch_job_check_args (job, 2, 3, error))
+			return FALSE;
+		if (job->values[3] != NULL)
+			dirname = job->values[3];
+		blob = fu_common_get_contents_mapped (job->values[1], error);
+		if (blob == NULL)
+			return FALSE;
+		firmware = fu_util_firmware_parse_blob (priv, blob, job->values[2], error);
+		if (firmware == NULL)
+			return FALSE;
+		images = fu_firmware_get_images (firmware);
+		for (guint i = 0; i < images->len; i++) {
+			FuFirmwareImage *img = g_ptr_array_index (images, i);
+			g_autofree gchar *basename = NULL;
+			g_autofree gchar *fn = NULL;
+			g_autoptr(GBytes) blob_img = fu_firmware_image_get_bytes (img);
+			if (blob_img == NULL || g_bytes_get_size (blob_img) == 0)
+				continue;
+			basename = fu_util_firmware_image_get_filename (img, i);
+			fn = g_build_filename (dirname, basename, NULL);
+			if (!fu_common_set_contents_bytes (fn, blob_img, error))
+				return FALSE;
+			g_ptr_array_add (job->filenames, g_steal_pointer (&fn));
+		}
+		return TRUE;
+	}
+	if (g_strcmp0 (cmd, "firmware-convert") == 0) {
+		GType gtype_dst;
+		g_autoptr(FuFirmware) firmware_dst = NULL;
+		g_autoptr(GPtrArray) images = NULL;
+		if (!fu_util_batch_job_check_args (job, 4, 4, error))
+			return FALSE;
+		blob = fu_common_get_contents_mapped (job->values[1], error);
+		if (blob == NULL)
+			return FALSE;
+		firmware = fu_util_firmware_parse_blob (priv, blob, job->values[3], error);
+		if (firmware == NULL)
+			return FALSE;
+		gtype_dst = fu_engine_get_firmware_gtype_by_id (priv->engine, job->values[4]);
+		if (gtype_dst == G_TYPE_INVALID) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_FOUND,
+				     "GType %s not supported", job->values[4]);
+			return FALSE;
+		}
+		firmware_dst = g_object_new (gtype_dst, NULL);
+		images = fu_firmware_get_images (firmware);
+		for (guint i = 0; i < images->len; i++) {
+			FuFirmwareImage *img = g_ptr_array_index (images, i);
+			fu_firmware_add_image (firmware_dst, img);
+		}
+		if (!fu_util_firmware_write_filename (firmware_dst, job->values[2], error))
+			return FALSE;
+		g_ptr_array_add (job->filenames, g_strdup (job->values[2]));
+		return TRUE;
+	}
+	if (g_strcmp0 (cmd, "firmware-build") == 0) {
+		if (!fu_util_batch_job_check_args (job, 2, 2, error))
+			return FALSE;
+		blob = fu_common_get_contents_bytes (job->values[1], error);
+		if (blob == NULL)
+			return FALSE;
+		firmware = fu_util_firmware_build_xml (priv, blob, error);
+		if (firmware == NULL)
+			return FALSE;
+		if (!fu_util_firmware_write_filename (firmware, job->values[2], error))
+			return FALSE;
+		g_ptr_array_add (job->filenames, g_strdup (job->values[2]));
+		return TRUE;
+	}
+	g_set_error (error,
+		     FWUPD_ERROR,
+		     FWUPD_ERROR_NOT_SUPPORTED,
+		     "command %s not supported in batch mode", cmd);
+	return FALSE;
+}
+
+static void
+fu_util_batch_job_cb (gpointer data, gpointer user_data)
+{
+	FuUtilBatchJob *job = (FuUtilBatchJob *) data;
+	FuUtilPrivate *priv = (FuUtilPrivate *) user_data;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	if (!fu_util_batch_job_run (priv, job, &job->error))
+		g_debug ("%s failed: %s", job->values[1], job->error->message);
+	job->elapsed = g_timer_elapsed (timer, NULL);
+}
+
+static FuUtilBatchJob *
+fu_util_batch_job_new (gchar **values, GError **error)
+{
+	FuUtilBatchJob *job;
+	if (values == NULL || g_strv_length (values) < 2) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_FILE,
+				     "each job requires a command and a filename");
+		return NULL;
+	}
+	job = g_new0 (FuUtilBatchJob, 1);
+	job->values = g_strdupv (values);
+	job->filenames = g_ptr_array_new_with_free_func (g_free);
+	return job;
+}
+
+/* either a JSON array of string arrays, or one command and arguments per line */
+static GPtrArray *
+fu_util_batch_load_manifest (const gchar *filename, GError **error)
+{
+	g_autoptr(GPtrArray) jobs = NULL;
+
+	jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_util_batch_job_free);
+	if (g_str_has_suffix (filename, ".json")) {
+		JsonArray *json_jobs;
+		JsonNode *json_root;
+		g_autoptr(JsonParser) parser = json_parser_new ();
+
+		if (!json_parser_load_from_file (parser, filename, error))
+			return NULL;
+		json_root = json_parser_get_root (parser);
+		if (json_root == NULL || !JSON_NODE_HOLDS_ARRAY (json_root)) {
+			g_set_error_literal (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "manifest is not a JSON array");
+			return NULL;
+		}
+		json_jobs = json_node_get_array (json_root);
+		for (guint i = 0; i < json_array_get_length (json_jobs); i++) {
+			JsonNode *json_job = json_array_get_element (json_jobs, i);
+			JsonArray *json_values;
+			FuUtilBatchJob *job;
+			g_autoptr(GPtrArray) values = g_ptr_array_new ();
+
+			if (!JSON_NODE_HOLDS_ARRAY (json_job)) {
+				g_set_error (error,
+					     FWUPD_ERROR,
+					     FWUPD_ERROR_INVALID_FILE,
+					     "job %u is not a JSON array", i);
+				return NULL;
+			}
+			json_values = json_node_get_array (json_job);
+			for (guint j = 0; j < json_array_get_length (json_values); j++) {
+				JsonNode *json_value = json_array_get_element (json_values, j);
+				if (!JSON_NODE_HOLDS_VALUE (json_value) ||
+				    json_node_get_value_type (json_value) != G_TYPE_STRING) {
+					g_set_error (error,
+						     FWUPD_ERROR,
+						     FWUPD_ERROR_INVALID_FILE,
+						     "job %u argument %u is not a string", i, j);
+					return NULL;
+				}
+				g_ptr_array_add (values, (gpointer) json_node_get_string (json_value));
+			}
+			g_ptr_array_add (values, NULL);
+			job = fu_util_batch_job_new ((gchar **) values->pdata, error);
+			if (job == NULL) {
+				g_prefix_error (error, "job %u: ", i);
+				return NULL;
+			}
+			g_ptr_array_add (jobs, job);
+		}
+	} else {
+		g_autofree gchar *data = NULL;
+		g_auto(GStrv) lines = NULL;
+
+		if (!g_file_get_contents (filename, &data, NULL, error))
+			return NULL;
+		lines = g_strsplit (data, "\n", -1);
+		for (guint i = 0; lines[i] != NULL; i++) {
+			FuUtilBatchJob *job;
+			g_auto(GStrv) values = NULL;
+
+			g_strstrip (lines[i]);
+			if (lines[i][0] == '\0' || lines[i][0] == '#')
+				continue;
+			if (!g_shell_parse_argv (lines[i], NULL, &values, error)) {
+				g_prefix_error (error, "line %u: ", i + 1);
+				return NULL;
+			}
+			job = fu_util_batch_job_new (values, error);
+			if (job == NULL) {
+				g_prefix_error (error, "line %u: ", i + 1);
+				return NULL;
+			}
+			g_ptr_array_add (jobs, job);
+		}
+	}
+	if (jobs->len == 0) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOTHING_TO_DO,
+				     "no jobs in manifest");
+		return NULL;
+	}
+	return g_steal_pointer (&jobs);
+}
+
+static gboolean
+fu_util_firmware_batch (FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	guint failed = 0;
+	g_autofree gchar *str = NULL;
+	g_autoptr(GPtrArray) jobs = NULL;
+	g_autoptr(GPtrArray) firmware_types = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new ();
+	g_autoptr(JsonGenerator) json_generator = NULL;
+	g_autoptr(JsonNode) json_root = NULL;
+	GThreadPool *pool;
+
+	/* check args */
+	if (g_strv_length (values) != 1) {
+		g_set_error_literal (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_INVALID_ARGS,
+				     "Invalid arguments: manifest required");
+		return FALSE;
+	}
+	jobs = fu_util_batch_load_manifest (values[0], error);
+	if (jobs == NULL)
+		return FALSE;
+
+	/* load engine once for every job */
+	if (!fu_engine_load (priv->engine,
+			     FU_ENGINE_LOAD_FLAG_READONLY |
+			     FU_ENGINE_LOAD_FLAG_FIRMWARE_GTYPES,
+			     error))
+		return FALSE;
+
+	/* initialize each class up front rather than contending in the workers */
+	firmware_types = fu_engine_get_firmware_gtype_ids (priv->engine);
+	for (guint i = 0; i < firmware_types->len; i++) {
+		const gchar *id = g_ptr_array_index (firmware_types, i);
+		GType gtype = fu_engine_get_firmware_gtype_by_id (priv->engine, id);
+		g_type_class_unref (g_type_class_ref (gtype));
+	}
+
+	/* each job only writes to its own struct, so no locking is required */
+	pool = g_thread_pool_new (fu_util_batch_job_cb, priv,
+				  (gint) g_get_num_processors (), TRUE, error);
+	if (pool == NULL)
+		return FALSE;
+	for (guint i = 0; i < jobs->len; i++) {
+		if (!g_thread_pool_push (pool, g_ptr_array_index (jobs, i), error)) {
+			g_thread_pool_free (pool, TRUE, TRUE);
+			return FALSE;
+		}
+	}
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	/* results are in manifest order */
+	json_builder_begin_object (builder);
+	json_builder_set_member_name (builder, "Results");
+	json_builder_begin_array (builder);
+	for (guint i = 0; i < jobs->len; i++) {
+		FuUtilBatchJob *job = g_ptr_array_index (jobs, i);
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "Command");
+		json_builder_add_string_value (builder, job->values[0]);
+		json_builder_set_member_name (builder, "Filename");
+		json_builder_add_string_value (builder, job->values[1]);
+		json_builder_set_member_name (builder, "Success");
+		json_builder_add_boolean_value (builder, job->error == NULL);
+		if (job->error != NULL) {
+			json_builder_set_member_name (builder, "Error");
+			json_builder_add_string_value (builder, job->error->message);
+			failed++;
+		}
+		if (job->filenames->len > 0) {
+			json_builder_set_member_name (builder, "Written");
+			json_builder_begin_array (builder);
+			for (guint j = 0; j < job->filenames->len; j++) {
+				const gchar *fn = g_ptr_array_index (job->filenames, j);
+				json_builder_add_string_value (builder, fn);
+			}
+			json_builder_end_array (builder);
+		}
+		json_builder_set_member_name (builder, "Elapsed");
+		json_builder_add_double_value (builder, job->elapsed);
+		json_builder_end_object (builder);
+	}
+	json_builder_end_array (builder);
+	json_builder_end_object (builder);
+
+	/* export as a string */
+	json_root = json_builder_get_root (builder);
+	json_generator = json_generator_new ();
+	json_generator_set_pretty (json_generator, TRUE);
+	json_generator_set_root (json_generator, json_root);
+	str = json_generator_to_data (json_generator, NULL);
+	g_print ("%s\n", str);
+
+	/* the per-job results are already shown */
+	if (failed > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "%u of %u jobs failed", failed, jobs->len);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_verify_update (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -2221,7 +2668,8 @@ fu_util_verify_update (FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* add checksums */
-	if (!fu_engine_verify_update (priv->engine, fu_device_get_id (dev), error))
+	if (!fu_engine_verify_update (priv->engine, fu_device_get_id (dev),
+				      priv->flags, error))
 		return FALSE;
 
 	/* show checksums */
@@ -2725,6 +3173,8 @@ main (int argc, char *argv[])
 	gboolean ignore_checksum = FALSE;
 	gboolean ignore_power = FALSE;
 	gboolean ignore_vid_pid = FALSE;
+	gboolean trace = FALSE;
+	g_autofree gchar *record = NULL;
 	gboolean interactive = isatty (fileno (stdout)) != 0;
 	g_auto(GStrv) plugin_glob = NULL;
 	g_autoptr(FuUtilPrivate) priv = g_new0 (FuUtilPrivate, 1);
@@ -2769,6 +3219,9 @@ main (int argc, char *argv[])
 		{ "show-all-devices", '\0', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &priv->show_all,
 			/* TRANSLATORS: command line option */
 			_("Show devices that are not updatable"), NULL },
+		{ "stats", '\0', 0, G_OPTION_ARG_NONE, &priv->show_stats,
+			/* TRANSLATORS: command line option */
+			_("Show plugin statistics"), NULL },
 		{ "plugins", '\0', 0, G_OPTION_ARG_STRING_ARRAY, &plugin_glob,
 			/* TRANSLATORS: command line option */
 			_("Manually enable specific plugins"), NULL },
@@ -2787,6 +3240,12 @@ main (int argc, char *argv[])
 		{ "disable-ssl-strict", '\0', 0, G_OPTION_ARG_NONE, &priv->disable_ssl_strict,
 			/* TRANSLATORS: command line option */
 			_("Ignore SSL strict checks when downloading files"), NULL },
+		{ "trace", '\0', 0, G_OPTION_ARG_NONE, &trace,
+			/* TRANSLATORS: command line option */
+			_("Show the raw packets sent to and received from devices"), NULL },
+		{ "record", '\0', 0, G_OPTION_ARG_FILENAME, &record,
+			/* TRANSLATORS: command line option */
+			_("Save a transcript of each device into a directory for replaying later"), NULL },
 		{ "filter", '\0', 0, G_OPTION_ARG_STRING, &filter,
 			/* TRANSLATORS: command line option */
 			_("Filter with a set of device flags using a ~ prefix to "
@@ -2839,6 +3298,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Get all enabled plugins registered with the system"),
 		     fu_util_get_plugins);
+	fu_util_cmd_array_add (cmd_array,
+		     "get-profile",
+		     NULL,
+		     /* TRANSLATORS: command description */
+		     _("Show the time taken to load the engine and enumerate devices"),
+		     fu_util_get_profile);
 	fu_util_cmd_array_add (cmd_array,
 		     "get-details",
 		     NULL,
@@ -3009,6 +3474,13 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Extract a firmware blob to images"),
 		     fu_util_firmware_extract);
+	fu_util_cmd_array_add (cmd_array,
+		     "firmware-batch",
+		     /* TRANSLATORS: command argument: uppercase, spaces->dashes */
+		     _("MANIFEST"),
+		     /* TRANSLATORS: command description */
+		     _("Parse, convert, build or extract many firmware files"),
+		     fu_util_firmware_batch);
 	fu_util_cmd_array_add (cmd_array,
 		     "get-firmware-types",
 		     NULL,
@@ -3106,6 +3578,19 @@ main (int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	/* print each packet as it is recorded */
+	if (trace)
+		g_setenv ("FWUPD_TRACE", "1", TRUE);
+
+	/* save every transfer, each time a device is closed */
+	if (record != NULL) {
+		if (g_mkdir_with_parents (record, 0700) == -1) {
+			g_printerr ("Failed to create %s\n", record);
+			return EXIT_FAILURE;
+		}
+		g_setenv ("FWUPD_TRANSCRIPT_DIR", record, TRUE);
+	}
+
 	/* allow disabling SSL strict mode for broken corporate proxies */
 	if (priv->disable_ssl_strict) {
 		g_autofree gchar *fmt = NULL;
@@ -3152,6 +3637,9 @@ main (int argc, char *argv[])
 
 	/* load engine */
 	priv->engine = fu_engine_new (FU_APP_FLAGS_NO_IDLE_SOURCES);
+#ifdef HAVE_PLUGIN_BUILTIN
+	fu_engine_set_plugin_builtins (priv->engine, fu_plugin_builtins);
+#endif
 	g_signal_connect (priv->engine, "device-added",
 			  G_CALLBACK (fu_main_engine_device_added_cb),
 			  priv);
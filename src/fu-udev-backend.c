@@ -9,19 +9,48 @@
 #include "config.h"
 
 #include <gudev/gudev.h>
+#include <string.h>
 
 #include "fu-udev-device.h"
 #include "fu-udev-backend.h"
 
+/* uevents for the same sysfs path within this window are merged */
+#define FU_UDEV_BACKEND_COALESCE_TIMEOUT	500	/* ms */
+
 struct _FuUdevBackend {
 	FuBackend		 parent_instance;
 	GUdevClient		*gudev_client;
-	GHashTable		*changed_idle_ids;	/* sysfs:FuUdevBackendHelper */
+	GHashTable		*pending_events;	/* sysfs:FuUdevBackendEvent */
+	GPtrArray		*pending_queue;		/* of FuUdevBackendEvent, in order */
+	guint			 pending_id;
+	guint			 events_suppressed;
 	GPtrArray		*subsystems;
 };
 
+typedef enum {
+	FU_UDEV_BACKEND_ACTION_ADD,
+	FU_UDEV_BACKEND_ACTION_REMOVE,
+	FU_UDEV_BACKEND_ACTION_CHANGE,
+	FU_UDEV_BACKEND_ACTION_REPLUG,		/* remove, then add */
+	FU_UDEV_BACKEND_ACTION_NONE,		/* added then removed */
+} FuUdevBackendAction;
+
+typedef struct {
+	gchar			*sysfs_path;
+	GUdevDevice		*udev_device;
+	FuUdevBackendAction	 action;
+} FuUdevBackendEvent;
+
 G_DEFINE_TYPE (FuUdevBackend, fu_udev_backend, FU_TYPE_BACKEND)
 
+static void
+fu_udev_backend_event_free (FuUdevBackendEvent *event)
+{
+	g_free (event->sysfs_path);
+	g_object_unref (event->udev_device);
+	g_free (event);
+}
+
 static void
 fu_udev_backend_device_add (FuUdevBackend *self, GUdevDevice *udev_device)
 {
@@ -48,63 +77,105 @@ fu_udev_backend_device_remove (FuUdevBackend *self, GUdevDevice *udev_device)
 	}
 }
 
-typedef struct {
-	FuUdevBackend	*self;
-	FuDevice	*device;
-	guint		 idle_id;
-} FuUdevBackendHelper;
-
 static void
-fu_udev_backend_changed_helper_free (FuUdevBackendHelper *helper)
+fu_udev_backend_device_changed (FuUdevBackend *self, GUdevDevice *udev_device)
 {
-	if (helper->idle_id != 0)
-		g_source_remove (helper->idle_id);
-	g_object_unref (helper->self);
-	g_object_unref (helper->device);
-	g_free (helper);
+	FuDevice *device_tmp;
+
+	/* not a device we enumerated */
+	device_tmp = fu_backend_lookup_by_id (FU_BACKEND (self),
+					      g_udev_device_get_sysfs_path (udev_device));
+	if (device_tmp == NULL)
+		return;
+	fu_backend_device_changed (FU_BACKEND (self), device_tmp);
 }
 
-static FuUdevBackendHelper *
-fu_udev_backend_changed_helper_new (FuUdevBackend *self, FuDevice *device)
+static gboolean
+fu_udev_backend_pending_cb (gpointer user_data)
 {
-	FuUdevBackendHelper *helper = g_new0 (FuUdevBackendHelper, 1);
-	helper->self = g_object_ref (self);
-	helper->device = g_object_ref (device);
-	return helper;
+	FuUdevBackend *self = FU_UDEV_BACKEND (user_data);
+	g_autoptr(GPtrArray) queue = NULL;
+
+	/* steal the batch, as plugins may cause more uevents */
+	queue = g_steal_pointer (&self->pending_queue);
+	self->pending_queue = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_udev_backend_event_free);
+	g_hash_table_remove_all (self->pending_events);
+	self->pending_id = 0;
+
+	g_debug ("dispatching %u coalesced uevents, %u suppressed so far",
+		 queue->len, self->events_suppressed);
+	for (guint i = 0; i < queue->len; i++) {
+		FuUdevBackendEvent *event = g_ptr_array_index (queue, i);
+		switch (event->action) {
+		case FU_UDEV_BACKEND_ACTION_ADD:
+			fu_udev_backend_device_add (self, event->udev_device);
+			break;
+		case FU_UDEV_BACKEND_ACTION_REMOVE:
+			fu_udev_backend_device_remove (self, event->udev_device);
+			break;
+		case FU_UDEV_BACKEND_ACTION_CHANGE:
+			fu_udev_backend_device_changed (self, event->udev_device);
+			break;
+		case FU_UDEV_BACKEND_ACTION_REPLUG:
+			fu_udev_backend_device_remove (self, event->udev_device);
+			fu_udev_backend_device_add (self, event->udev_device);
+			break;
+		default:
+			break;
+		}
+	}
+	return G_SOURCE_REMOVE;
 }
 
-static gboolean
-fu_udev_backend_device_changed_cb (gpointer user_data)
+/* merge the new action into the one already pending for this sysfs path */
+static FuUdevBackendAction
+fu_udev_backend_action_merge (FuUdevBackend *self,
+			      FuUdevBackendEvent *event,
+			      FuUdevBackendAction action)
 {
-	FuUdevBackendHelper *helper = (FuUdevBackendHelper *) user_data;
-	fu_backend_device_changed (FU_BACKEND (helper->self), helper->device);
-	helper->idle_id = 0;
-	g_hash_table_remove (helper->self->changed_idle_ids,
-			     fu_udev_device_get_sysfs_path (FU_UDEV_DEVICE (helper->device)));
-	return FALSE;
+	gboolean known = fu_backend_lookup_by_id (FU_BACKEND (self), event->sysfs_path) != NULL;
+
+	if (action == FU_UDEV_BACKEND_ACTION_REMOVE)
+		return known ? FU_UDEV_BACKEND_ACTION_REMOVE : FU_UDEV_BACKEND_ACTION_NONE;
+	if (action == FU_UDEV_BACKEND_ACTION_ADD)
+		return known ? FU_UDEV_BACKEND_ACTION_REPLUG : FU_UDEV_BACKEND_ACTION_ADD;
+
+	/* a change does not matter if the device is being added or removed */
+	if (event->action == FU_UDEV_BACKEND_ACTION_NONE)
+		return FU_UDEV_BACKEND_ACTION_NONE;
+	return event->action;
 }
 
 static void
-fu_udev_backend_device_changed (FuUdevBackend *self, GUdevDevice *udev_device)
+fu_udev_backend_event_queue (FuUdevBackend *self,
+			     GUdevDevice *udev_device,
+			     FuUdevBackendAction action)
 {
 	const gchar *sysfs_path = g_udev_device_get_sysfs_path (udev_device);
-	FuUdevBackendHelper *helper;
-	FuDevice *device_tmp;
-
-	/* not a device we enumerated */
-	device_tmp = fu_backend_lookup_by_id (FU_BACKEND (self), sysfs_path);
-	if (device_tmp == NULL)
-		return;
+	FuUdevBackendEvent *event;
 
-	/* run all plugins, with per-device rate limiting */
-	if (g_hash_table_remove (self->changed_idle_ids, sysfs_path)) {
-		g_debug ("re-adding rate-limited timeout for %s", sysfs_path);
+	event = g_hash_table_lookup (self->pending_events, sysfs_path);
+	if (event != NULL) {
+		event->action = fu_udev_backend_action_merge (self, event, action);
+		g_set_object (&event->udev_device, udev_device);
+		self->events_suppressed++;
+		if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL)
+			g_debug ("coalesced uevent for %s", sysfs_path);
 	} else {
-		g_debug ("adding rate-limited timeout for %s", sysfs_path);
+		event = g_new0 (FuUdevBackendEvent, 1);
+		event->sysfs_path = g_strdup (sysfs_path);
+		event->udev_device = g_object_ref (udev_device);
+		event->action = action;
+		g_hash_table_insert (self->pending_events, event->sysfs_path, event);
+		g_ptr_array_add (self->pending_queue, event);
+	}
+
+	/* dispatch the whole batch at the end of the window */
+	if (self->pending_id == 0) {
+		self->pending_id = g_timeout_add (FU_UDEV_BACKEND_COALESCE_TIMEOUT,
+						  fu_udev_backend_pending_cb,
+						  self);
 	}
-	helper = fu_udev_backend_changed_helper_new (self, device_tmp);
-	helper->idle_id = g_timeout_add (500, fu_udev_backend_device_changed_cb, helper);
-	g_hash_table_insert (self->changed_idle_ids, g_strdup (sysfs_path), helper);
 }
 
 static void
@@ -114,26 +185,57 @@ fu_udev_backend_uevent_cb (GUdevClient *gudev_client,
 			   FuUdevBackend *self)
 {
 	if (g_strcmp0 (action, "add") == 0) {
-		fu_udev_backend_device_add (self, udev_device);
+		fu_udev_backend_event_queue (self, udev_device, FU_UDEV_BACKEND_ACTION_ADD);
 		return;
 	}
 	if (g_strcmp0 (action, "remove") == 0) {
-		fu_udev_backend_device_remove (self, udev_device);
+		fu_udev_backend_event_queue (self, udev_device, FU_UDEV_BACKEND_ACTION_REMOVE);
 		return;
 	}
 	if (g_strcmp0 (action, "change") == 0) {
-		fu_udev_backend_device_changed (self, udev_device);
+		fu_udev_backend_event_queue (self, udev_device, FU_UDEV_BACKEND_ACTION_CHANGE);
 		return;
 	}
 }
 
+/* subsystems are either `subsystem` or `subsystem/devtype` */
+static gboolean
+fu_udev_backend_device_matches (FuUdevBackend *self, GUdevDevice *udev_device)
+{
+	const gchar *subsystem = g_udev_device_get_subsystem (udev_device);
+	const gchar *devtype = g_udev_device_get_devtype (udev_device);
+	gsize subsystemsz;
+
+	if (subsystem == NULL)
+		return FALSE;
+	subsystemsz = strlen (subsystem);
+	for (guint i = 0; i < self->subsystems->len; i++) {
+		const gchar *tmp = g_ptr_array_index (self->subsystems, i);
+		if (strncmp (tmp, subsystem, subsystemsz) != 0)
+			continue;
+		if (tmp[subsystemsz] == '\0')
+			return TRUE;
+		if (tmp[subsystemsz] == '/' &&
+		    g_strcmp0 (tmp + subsystemsz + 1, devtype) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static gboolean
 fu_udev_backend_coldplug (FuBackend *backend, GError **error)
 {
 	FuUdevBackend *self = FU_UDEV_BACKEND (backend);
+	GList *devices;
+	guint cnt = 0;
+	g_autoptr(GHashTable) subsystems_matched = NULL;
+	g_autoptr(GUdevEnumerator) enumerator = NULL;
+
+	if (self->subsystems == NULL || self->subsystems->len == 0)
+		return TRUE;
 
 	/* udev watches can only be set up in _init() so set up client now */
-	if (self->subsystems->len > 0) {
+	if (self->gudev_client == NULL) {
 		g_auto(GStrv) subsystems = g_new0 (gchar *, self->subsystems->len + 1);
 		for (guint i = 0; i < self->subsystems->len; i++) {
 			const gchar *subsystem = g_ptr_array_index (self->subsystems, i);
@@ -144,22 +246,33 @@ fu_udev_backend_coldplug (FuBackend *backend, GError **error)
 				  G_CALLBACK (fu_udev_backend_uevent_cb), self);
 	}
 
-	/* get all devices of class */
+	/* get all devices of all subsystems in one pass */
+	enumerator = g_udev_enumerator_new (self->gudev_client);
+	subsystems_matched = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	for (guint i = 0; i < self->subsystems->len; i++) {
-		const gchar *subsystem = g_ptr_array_index (self->subsystems, i);
-		GList *devices = g_udev_client_query_by_subsystem (self->gudev_client,
-								   subsystem);
-		if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
-			g_debug ("%u devices with subsystem %s",
-				 g_list_length (devices), subsystem);
-		}
-		for (GList *l = devices; l != NULL; l = l->next) {
-			GUdevDevice *udev_device = l->data;
-			fu_udev_backend_device_add (self, udev_device);
-		}
-		g_list_foreach (devices, (GFunc) g_object_unref, NULL);
-		g_list_free (devices);
+		const gchar *tmp = g_ptr_array_index (self->subsystems, i);
+		g_autofree gchar *subsystem = g_strdup (tmp);
+		gchar *devtype = g_strstr_len (subsystem, -1, "/");
+		if (devtype != NULL)
+			*devtype = '\0';
+		if (g_hash_table_contains (subsystems_matched, subsystem))
+			continue;
+		g_udev_enumerator_add_match_subsystem (enumerator, subsystem);
+		g_hash_table_add (subsystems_matched, g_steal_pointer (&subsystem));
+	}
+	devices = g_udev_enumerator_execute (enumerator);
+	for (GList *l = devices; l != NULL; l = l->next) {
+		GUdevDevice *udev_device = l->data;
+		if (!fu_udev_backend_device_matches (self, udev_device))
+			continue;
+		fu_udev_backend_device_add (self, udev_device);
+		cnt++;
+	}
+	if (g_getenv ("FWUPD_PROBE_VERBOSE") != NULL) {
+		g_debug ("%u of %u devices matched %u subsystems",
+			 cnt, g_list_length (devices), self->subsystems->len);
 	}
+	g_list_free_full (devices, (GDestroyNotify) g_object_unref);
 
 	return TRUE;
 }
@@ -172,15 +285,18 @@ fu_udev_backend_finalize (GObject *object)
 		g_object_unref (self->gudev_client);
 	if (self->subsystems != NULL)
 		g_ptr_array_unref (self->subsystems);
-	g_hash_table_unref (self->changed_idle_ids);
+	if (self->pending_id != 0)
+		g_source_remove (self->pending_id);
+	g_hash_table_unref (self->pending_events);
+	g_ptr_array_unref (self->pending_queue);
 	G_OBJECT_CLASS (fu_udev_backend_parent_class)->finalize (object);
 }
 
 static void
 fu_udev_backend_init (FuUdevBackend *self)
 {
-	self->changed_idle_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
-							g_free, (GDestroyNotify) fu_udev_backend_changed_helper_free);
+	self->pending_events = g_hash_table_new (g_str_hash, g_str_equal);
+	self->pending_queue = g_ptr_array_new_with_free_func ((GDestroyNotify) fu_udev_backend_event_free);
 }
 
 static void
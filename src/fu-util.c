@@ -21,6 +21,7 @@
 #include <json-glib/json-glib.h>
 #include <locale.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "fu-history.h"
@@ -70,6 +71,7 @@ struct FuUtilPrivate {
 	gboolean		 assume_yes;
 	gboolean		 sign;
 	gboolean		 show_all;
+	gboolean		 show_timings;
 	gboolean		 disable_ssl_strict;
 	/* only valid in update and downgrade */
 	FuUtilOperation		 current_operation;
@@ -701,16 +703,17 @@ fu_util_clear_history (FuUtilPrivate *priv, gchar **values, GError **error)
 	return fu_history_remove_all (history, error);
 }
 
+/* remotes that share a report URI get one upload for all of their devices */
 static gboolean
-fu_util_report_history_for_remote (FuUtilPrivate *priv,
-				const gchar *remote_id,
+fu_util_report_history_for_uri (FuUtilPrivate *priv,
+				const gchar *report_uri,
 				GPtrArray *devices,
+				gboolean automatic_reports,
 				GError **error)
 {
 	g_autofree gchar *data = NULL;
 	g_autofree gchar *sig = NULL;
 	g_autofree gchar *uri = NULL;
-	g_autoptr(FwupdRemote) remote = NULL;
 
 	/* convert to JSON */
 	data = fwupd_build_history_report_json (devices, error);
@@ -726,14 +729,9 @@ fu_util_report_history_for_remote (FuUtilPrivate *priv,
 			return FALSE;
 	}
 
-	remote = fwupd_client_get_remote_by_id (priv->client, remote_id,
-						NULL, error);
-	if (remote == NULL)
-		return FALSE;
-
 	/* ask for permission */
-	if (!priv->assume_yes && !fwupd_remote_get_automatic_reports (remote)) {
-		fu_util_print_data (_("Target"), fwupd_remote_get_report_uri (remote));
+	if (!priv->assume_yes && !automatic_reports) {
+		fu_util_print_data (_("Target"), report_uri);
 		fu_util_print_data (_("Payload"), data);
 		if (sig != NULL)
 			fu_util_print_data (_("Signature"), sig);
@@ -748,9 +746,7 @@ fu_util_report_history_for_remote (FuUtilPrivate *priv,
 	}
 
 	/* POST request and parse reply */
-	if (!fu_util_send_report (priv->client,
-				  fwupd_remote_get_report_uri (remote),
-				  data, sig, &uri, error))
+	if (!fu_util_send_report (priv->client, report_uri, data, sig, &uri, error))
 		return FALSE;
 
 	/* server wanted us to see a message */
@@ -768,24 +764,41 @@ fu_util_report_history_for_remote (FuUtilPrivate *priv,
 static gboolean
 fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 {
+	g_autoptr(GHashTable) remotes_by_id = NULL;
 	g_autoptr(GHashTable) report_map = NULL;
-	g_autoptr(GList) ids = NULL;
+	g_autoptr(GHashTable) report_ask = NULL;
+	g_autoptr(GList) uris = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) remotes = NULL;
 	g_autoptr(GString) str = g_string_new (NULL);
 
+	/* get the remotes once rather than for each device */
+	remotes = fwupd_client_get_remotes (priv->client, priv->cancellable, error);
+	if (remotes == NULL)
+		return FALSE;
+	remotes_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+	for (guint i = 0; i < remotes->len; i++) {
+		FwupdRemote *remote = g_ptr_array_index (remotes, i);
+		g_hash_table_insert (remotes_by_id,
+				     (gpointer) fwupd_remote_get_id (remote),
+				     remote);
+	}
+
 	/* get all devices from the history database, then filter them,
-	 * adding to a hash map of report-ids */
+	 * adding to a hash map of report-uris */
 	devices = fwupd_client_get_history (priv->client, NULL, error);
 	if (devices == NULL)
 		return FALSE;
 	report_map = g_hash_table_new_full (g_str_hash, g_str_equal,
 					    g_free, (GDestroyNotify) g_ptr_array_unref);
+	report_ask = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	for (guint i = 0; i < devices->len; i++) {
 		FwupdDevice *dev = g_ptr_array_index (devices, i);
 		FwupdRelease *rel = fwupd_device_get_release_default (dev);
+		FwupdRemote *remote;
 		const gchar *remote_id;
+		const gchar *report_uri;
 		GPtrArray *devices_tmp;
-		g_autoptr(FwupdRemote) remote = NULL;
 
 		/* filter, if not forcing */
 		if (!fu_util_filter_device (priv, dev))
@@ -811,21 +824,29 @@ fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 			g_debug ("%s has no RemoteID", fwupd_device_get_id (dev));
 			continue;
 		}
-		remote = fwupd_client_get_remote_by_id (priv->client, remote_id,
-							NULL, error);
-		if (remote == NULL)
+		remote = g_hash_table_lookup (remotes_by_id, remote_id);
+		if (remote == NULL) {
+			g_set_error (error,
+				     FWUPD_ERROR,
+				     FWUPD_ERROR_NOT_FOUND,
+				     "No remote found with ID '%s'",
+				     remote_id);
 			return FALSE;
-		if (fwupd_remote_get_report_uri (remote) == NULL) {
-			g_debug ("%s has no RemoteURI", fwupd_remote_get_report_uri (remote));
+		}
+		report_uri = fwupd_remote_get_report_uri (remote);
+		if (report_uri == NULL) {
+			g_debug ("%s has no RemoteURI", remote_id);
 			continue;
 		}
 
 		/* add this to the hash map */
-		devices_tmp = g_hash_table_lookup (report_map, remote_id);
+		devices_tmp = g_hash_table_lookup (report_map, report_uri);
 		if (devices_tmp == NULL) {
 			devices_tmp = g_ptr_array_new ();
-			g_hash_table_insert (report_map, g_strdup (remote_id), devices_tmp);
+			g_hash_table_insert (report_map, g_strdup (report_uri), devices_tmp);
 		}
+		if (!fwupd_remote_get_automatic_reports (remote))
+			g_hash_table_add (report_ask, g_strdup (report_uri));
 		g_debug ("using %s for %s", remote_id, fwupd_device_get_id (dev));
 		g_ptr_array_add (devices_tmp, dev);
 	}
@@ -840,11 +861,13 @@ fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 	}
 
 	/* process each uri */
-	ids = g_hash_table_get_keys (report_map);
-	for (GList *l = ids; l != NULL; l = l->next) {
-		const gchar *id = l->data;
-		GPtrArray *devices_tmp = g_hash_table_lookup (report_map, id);
-		if (!fu_util_report_history_for_remote (priv, id, devices_tmp, error))
+	uris = g_hash_table_get_keys (report_map);
+	for (GList *l = uris; l != NULL; l = l->next) {
+		const gchar *report_uri = l->data;
+		GPtrArray *devices_tmp = g_hash_table_lookup (report_map, report_uri);
+		if (!fu_util_report_history_for_uri (priv, report_uri, devices_tmp,
+						     !g_hash_table_contains (report_ask, report_uri),
+						     error))
 			return FALSE;
 
 		/* mark each device as reported */
@@ -869,6 +892,39 @@ fu_util_report_history (FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_util_get_history_timings (FuUtilPrivate *priv, GPtrArray *devices)
+{
+	const gchar *keys[] = { "TimingPrepare", "TimingDetach", "TimingWrite",
+				"TimingAttach", "TimingReload", "TimingCleanup",
+				"TimingReplug", NULL };
+
+	for (guint i = 0; i < devices->len; i++) {
+		FwupdDevice *dev = g_ptr_array_index (devices, i);
+		FwupdRelease *rel = fwupd_device_get_release_default (dev);
+		g_autoptr(GString) str = g_string_new (NULL);
+
+		if (!fu_util_filter_device (priv, dev))
+			continue;
+		if (rel == NULL ||
+		    fwupd_release_get_metadata_item (rel, "TimingWrite") == NULL)
+			continue;
+		fu_common_string_append_kv (str, 0, fwupd_device_get_name (dev), NULL);
+		fu_common_string_append_kv (str, 1, "DeviceId", fwupd_device_get_id (dev));
+		fu_common_string_append_kv (str, 1, "Version", fwupd_release_get_version (rel));
+		for (guint j = 0; keys[j] != NULL; j++) {
+			const gchar *tmp = fwupd_release_get_metadata_item (rel, keys[j]);
+			g_autofree gchar *val = NULL;
+			if (tmp == NULL)
+				continue;
+			val = g_strdup_printf ("%sms", tmp);
+			fu_common_string_append_kv (str, 1, keys[j] + strlen ("Timing"), val);
+		}
+		g_print ("%s\n", str->str);
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_get_history (FuUtilPrivate *priv, gchar **values, GError **error)
 {
@@ -881,6 +937,10 @@ fu_util_get_history (FuUtilPrivate *priv, gchar **values, GError **error)
 	if (devices == NULL)
 		return FALSE;
 
+	/* just how long each update took */
+	if (priv->show_timings)
+		return fu_util_get_history_timings (priv, devices);
+
 	/* show each device */
 	for (guint i = 0; i < devices->len; i++) {
 		g_autoptr(GPtrArray) rels = NULL;
@@ -1092,10 +1152,10 @@ fu_util_check_oldest_remote (FuUtilPrivate *priv, guint64 *age_oldest, GError **
 static gboolean
 fu_util_download_metadata (FuUtilPrivate *priv, GError **error)
 {
-	gboolean download_remote_enabled = FALSE;
 	guint devices_supported_cnt = 0;
 	g_autoptr(GPtrArray) devs = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
+	g_autoptr(GPtrArray) remotes_download = g_ptr_array_new ();
 	g_autoptr(GString) str = g_string_new (NULL);
 
 	/* metadata refreshed recently */
@@ -1127,15 +1187,17 @@ fu_util_download_metadata (FuUtilPrivate *priv, GError **error)
 			continue;
 		if (fwupd_remote_get_kind (remote) != FWUPD_REMOTE_KIND_DOWNLOAD)
 			continue;
-		download_remote_enabled = TRUE;
 		g_print ("%s %s\n", _("Updating"), fwupd_remote_get_id (remote));
-		if (!fwupd_client_refresh_remote (priv->client, remote,
-						  priv->cancellable, error))
-			return FALSE;
+		g_ptr_array_add (remotes_download, remote);
 	}
 
+	/* download all the remotes at the same time */
+	if (!fwupd_client_refresh_remotes (priv->client, remotes_download,
+					   priv->cancellable, error))
+		return FALSE;
+
 	/* no web remote is declared; try to enable LVFS */
-	if (!download_remote_enabled) {
+	if (remotes_download->len == 0) {
 		/* we don't want to ask anything */
 		if (priv->no_remote_check) {
 			g_debug ("skipping remote check");
@@ -1313,11 +1375,58 @@ fu_util_prompt_for_release (FuUtilPrivate *priv, GPtrArray *rels, GError **error
 	return g_object_ref (rel);
 }
 
+static void
+fu_util_device_verified_cb (FwupdClient *client, FwupdDevice *device, gpointer user_data)
+{
+	if (fwupd_device_get_update_state (device) == FWUPD_UPDATE_STATE_SUCCESS) {
+		/* TRANSLATORS: success message when user verified device checksums */
+		g_print ("%s: %s\n", fwupd_device_get_name (device),
+			 _("Successfully verified device checksums"));
+		return;
+	}
+	g_print ("%s: %s\n", fwupd_device_get_name (device),
+		 fwupd_device_get_update_error (device));
+}
+
+/* the daemon reads back independent devices at the same time */
+static gboolean
+fu_util_verify_all (FuUtilPrivate *priv, GError **error)
+{
+	gulong handler_id;
+	guint failures = 0;
+	g_autoptr(GPtrArray) results = NULL;
+
+	handler_id = g_signal_connect (priv->client, "device-verified",
+				       G_CALLBACK (fu_util_device_verified_cb), priv);
+	results = fwupd_client_verify_all (priv->client, priv->cancellable, error);
+	g_signal_handler_disconnect (priv->client, handler_id);
+	if (results == NULL)
+		return FALSE;
+	for (guint i = 0; i < results->len; i++) {
+		FwupdDevice *result = g_ptr_array_index (results, i);
+		if (fwupd_device_get_update_state (result) != FWUPD_UPDATE_STATE_SUCCESS)
+			failures++;
+	}
+	if (failures > 0) {
+		g_set_error (error,
+			     FWUPD_ERROR,
+			     FWUPD_ERROR_INTERNAL,
+			     "failed to verify %u of %u devices",
+			     failures, results->len);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static gboolean
 fu_util_verify (FuUtilPrivate *priv, gchar **values, GError **error)
 {
 	g_autoptr(FwupdDevice) dev = NULL;
 
+	/* no device specified */
+	if (g_strv_length (values) == 0)
+		return fu_util_verify_all (priv, error);
+
 	priv->filter_include |= FWUPD_DEVICE_FLAG_CAN_VERIFY;
 	dev = fu_util_get_device_or_prompt (priv, values, error);
 	if (dev == NULL)
@@ -1533,7 +1642,9 @@ fu_util_update_device_with_release (FuUtilPrivate *priv,
 				    FwupdRelease *rel,
 				    GError **error)
 {
-	if (!priv->no_safety_check && !priv->assume_yes) {
+	/* nothing is flashed when only filling the firmware cache */
+	if (!priv->no_safety_check && !priv->assume_yes &&
+	    (priv->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD) == 0) {
 		if (!fu_util_prompt_warning (dev,
 					     fu_util_get_tree_title (priv),
 					     error))
@@ -1636,6 +1747,8 @@ fu_util_update_all (FuUtilPrivate *priv, GError **error)
 		g_print ("%s\n", upgrade_str);
 		if (!fu_util_update_device_with_release (priv, dev, rel, error))
 			return FALSE;
+		if (priv->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD)
+			continue;
 
 		fu_util_display_current_message (priv);
 
@@ -1655,7 +1768,8 @@ fu_util_update_all (FuUtilPrivate *priv, GError **error)
 	}
 
 	/* we don't want to ask anything */
-	if (priv->no_reboot_check) {
+	if (priv->no_reboot_check ||
+	    priv->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD) {
 		g_debug ("skipping reboot check");
 		return TRUE;
 	}
@@ -1690,6 +1804,8 @@ fu_util_update_by_id (FuUtilPrivate *priv, const gchar *device_id, GError **erro
 	rel = g_ptr_array_index (rels, 0);
 	if (!fu_util_update_device_with_release (priv, dev, rel, error))
 		return FALSE;
+	if (priv->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD)
+		return TRUE;
 	fu_util_display_current_message (priv);
 
 	/* send report if we're supposed to */
@@ -2717,6 +2833,7 @@ main (int argc, char *argv[])
 	gboolean allow_branch_switch = FALSE;
 	gboolean allow_older = FALSE;
 	gboolean allow_reinstall = FALSE;
+	gboolean download_only = FALSE;
 	gboolean enable_ipfs = FALSE;
 	gboolean ignore_power = FALSE;
 	gboolean is_interactive = TRUE;
@@ -2731,6 +2848,7 @@ main (int argc, char *argv[])
 	g_autoptr(GError) error_polkit = NULL;
 	g_autoptr(GPtrArray) cmd_array = fu_util_cmd_array_new ();
 	g_autofree gchar *cmd_descriptions = NULL;
+	g_autofree gchar *daemon_address = NULL;
 	g_autofree gchar *filter = NULL;
 	const GOptionEntry options[] = {
 		{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
@@ -2781,6 +2899,9 @@ main (int argc, char *argv[])
 		{ "show-all", '\0', 0, G_OPTION_ARG_NONE, &priv->show_all,
 			/* TRANSLATORS: command line option */
 			_("Show all results"), NULL },
+		{ "timings", '\0', 0, G_OPTION_ARG_NONE, &priv->show_timings,
+			/* TRANSLATORS: command line option */
+			_("Show how long each part of the update took"), NULL },
 		{ "show-all-devices", '\0', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &priv->show_all,
 			/* TRANSLATORS: command line option */
 			_("Show devices that are not updatable"), NULL },
@@ -2790,6 +2911,9 @@ main (int argc, char *argv[])
 		{ "ipfs", '\0', 0, G_OPTION_ARG_NONE, &enable_ipfs,
 			/* TRANSLATORS: command line option */
 			_("Only use IPFS when downloading files"), NULL },
+		{ "download-only", '\0', 0, G_OPTION_ARG_NONE, &download_only,
+			/* TRANSLATORS: command line option */
+			_("Only download and verify the firmware ready for a later update"), NULL },
 		{ "filter", '\0', 0, G_OPTION_ARG_STRING, &filter,
 			/* TRANSLATORS: command line option */
 			_("Filter with a set of device flags using a ~ prefix to "
@@ -2797,6 +2921,10 @@ main (int argc, char *argv[])
 		{ "ignore-power", '\0', 0, G_OPTION_ARG_NONE, &ignore_power,
 			/* TRANSLATORS: command line option */
 			_("Ignore requirement of external power source"), NULL },
+		{ "daemon-address", '\0', 0, G_OPTION_ARG_STRING, &daemon_address,
+			/* TRANSLATORS: command line option */
+			_("Connect to the daemon using a D-Bus address, "
+			  "e.g. 'unix:path=/tmp/fwupd.sock'"), NULL },
 		{ NULL}
 	};
 
@@ -3138,6 +3266,8 @@ main (int argc, char *argv[])
 	/* use IPFS for metadata and firmware *only* if specified */
 	if (enable_ipfs)
 		priv->download_flags |= FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_IPFS;
+	if (download_only)
+		priv->download_flags |= FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_DOWNLOAD;
 
 #ifdef HAVE_POLKIT
 	/* start polkit tty agent to listen for password requests */
@@ -3152,6 +3282,8 @@ main (int argc, char *argv[])
 	/* connect to the daemon */
 	priv->client = fwupd_client_new ();
 	fwupd_client_set_main_context (priv->client, priv->main_ctx);
+	if (daemon_address != NULL)
+		fwupd_client_set_daemon_address (priv->client, daemon_address);
 	g_signal_connect (priv->client, "notify::percentage",
 			  G_CALLBACK (fu_util_client_notify_cb), priv);
 	g_signal_connect (priv->client, "notify::status",